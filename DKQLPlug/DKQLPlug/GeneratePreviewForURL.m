@@ -21,10 +21,32 @@ OSStatus GeneratePreviewForURL(void* thisInterface, QLPreviewRequestRef preview,
 
 		DKDrawing* drawDat;
 		if ([nsUTI isEqualToString:kDKDrawingDocumentUTI] || [nsUTI isEqualToString:kDKDrawingDocumentXMLUTI]) {
-			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL];
+			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL options:NSDataReadingMappedIfSafe error:NULL];
 			if (dat == nil || QLPreviewRequestIsCancelled(preview)) {
 				return noErr;
 			}
+
+			// a drawing saved with a preview needn't be decoded at all; show the largest image it has
+
+			DKDrawingPreview* drawPreview = [DKDrawingPreview previewWithData:dat];
+			if (drawPreview) {
+				CGImageRef previewImage = [drawPreview newImageAtLevel:0];
+				if (previewImage) {
+					if (!QLPreviewRequestIsCancelled(preview)) {
+						CGSize previewSize = CGSizeMake(CGImageGetWidth(previewImage), CGImageGetHeight(previewImage));
+						CGContextRef ctx = QLPreviewRequestCreateContext(preview, previewSize, true, NULL);
+
+						CGContextDrawImage(ctx, CGRectMake(0, 0, previewSize.width, previewSize.height), previewImage);
+						QLPreviewRequestFlushContext(preview, ctx);
+						CGContextRelease(ctx);
+					}
+					CGImageRelease(previewImage);
+					return noErr;
+				}
+			}
+			if (QLPreviewRequestIsCancelled(preview)) {
+				return noErr;
+			}
 			drawDat = [DKDrawing drawingWithData:dat];
 		}
 		if (drawDat == nil || QLPreviewRequestIsCancelled(preview)) {
@@ -77,10 +77,27 @@ OSStatus GenerateThumbnailForURL(void* thisInterface, QLThumbnailRequestRef thum
 
 		DKDrawing* drawDat;
 		if ([nsUTI isEqualToString:kDKDrawingDocumentUTI] || [nsUTI isEqualToString:kDKDrawingDocumentXMLUTI]) {
-			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL];
+			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL options:NSDataReadingMappedIfSafe error:NULL];
 			if (dat == nil || QLThumbnailRequestIsCancelled(thumbnail)) {
 				return noErr;
 			}
+
+			// a drawing saved with a preview needn't be decoded at all
+
+			DKDrawingPreview* drawPreview = [DKDrawingPreview previewWithData:dat];
+			if (drawPreview) {
+				CGImageRef previewImage = [drawPreview newImageFittingSize:maxSize];
+				if (previewImage) {
+					if (!QLThumbnailRequestIsCancelled(thumbnail)) {
+						QLThumbnailRequestSetImage(thumbnail, previewImage, NULL);
+					}
+					CGImageRelease(previewImage);
+					return noErr;
+				}
+			}
+			if (QLThumbnailRequestIsCancelled(thumbnail)) {
+				return noErr;
+			}
 			drawDat = [DKDrawing drawingWithData:dat];
 		}
 		if (drawDat == nil || QLThumbnailRequestIsCancelled(thumbnail)) {
@@ -0,0 +1,105 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+// dkpreview - print the preview saved in DrawKit drawings, and how long it takes to read compared with loading the drawing.
+//
+//	usage: dkpreview [-o output.png] [-s size] [-full] file...
+//
+// -o writes the preview image that best fits -s (default 512) to a PNG file; -full also loads each drawing in full and reports the
+// time taken, for comparison. Build with:
+//
+//	clang -fobjc-arc -F<DrawKit build dir> -framework DKDrawKit -framework Cocoa main.m -o dkpreview
+
+#import <Cocoa/Cocoa.h>
+#import <DKDrawKit/DKDrawKit.h>
+#import <ImageIO/ImageIO.h>
+
+static BOOL writeImage(CGImageRef image, NSString* path)
+{
+	CGImageDestinationRef destRef = CGImageDestinationCreateWithURL((__bridge CFURLRef)[NSURL fileURLWithPath:path], kUTTypePNG, 1, NULL);
+
+	if (destRef == NULL)
+		return NO;
+
+	CGImageDestinationAddImage(destRef, image, NULL);
+	BOOL result = CGImageDestinationFinalize(destRef);
+	CFRelease(destRef);
+
+	return result;
+}
+
+int main(int argc, const char* argv[])
+{
+	@autoreleasepool {
+		NSString* outputPath = nil;
+		CGFloat size = 512;
+		BOOL full = NO;
+		NSMutableArray<NSString*>* files = [NSMutableArray array];
+
+		for (int i = 1; i < argc; ++i) {
+			NSString* arg = @(argv[i]);
+
+			if ([arg isEqualToString:@"-o"] && i + 1 < argc)
+				outputPath = @(argv[++i]);
+			else if ([arg isEqualToString:@"-s"] && i + 1 < argc)
+				size = MAX(1, atof(argv[++i]));
+			else if ([arg isEqualToString:@"-full"])
+				full = YES;
+			else
+				[files addObject:arg];
+		}
+
+		if ([files count] == 0) {
+			fprintf(stderr, "usage: dkpreview [-o output.png] [-s size] [-full] file...\n");
+			return 1;
+		}
+
+		int status = 0;
+
+		for (NSString* path in files) {
+			NSURL* url = [NSURL fileURLWithPath:path];
+			CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+			DKDrawingPreview* preview = [DKDrawingPreview previewWithContentsOfURL:url];
+			CFAbsoluteTime previewTime = CFAbsoluteTimeGetCurrent() - start;
+
+			if (preview == nil) {
+				printf("%s: no preview\n", [path fileSystemRepresentation]);
+				status = 1;
+			} else {
+				NSSize drawingSize = [preview drawingSize];
+
+				printf("%s: %g x %g points, %lu layers, %lu objects, read in %.2f ms\n", [path fileSystemRepresentation],
+					drawingSize.width, drawingSize.height, (unsigned long)[preview layerCount], (unsigned long)[preview objectCount], previewTime * 1000.0);
+
+				for (NSUInteger level = 0; level < [preview levelCount]; ++level) {
+					NSSize pixels = [preview pixelSizeOfLevel:level];
+					printf("\tlevel %lu: %g x %g\n", (unsigned long)level, pixels.width, pixels.height);
+				}
+
+				if (outputPath) {
+					CGImageRef image = [preview newImageFittingSize:NSMakeSize(size, size)];
+
+					if (image == NULL || !writeImage(image, outputPath)) {
+						fprintf(stderr, "couldn't write %s\n", [outputPath fileSystemRepresentation]);
+						status = 1;
+					}
+					CGImageRelease(image);
+				}
+			}
+
+			if (full) {
+				start = CFAbsoluteTimeGetCurrent();
+				NSData* data = [NSData dataWithContentsOfURL:url];
+				DKDrawing* drawing = data ? [DKDrawing drawingWithData:data] : nil;
+				CFAbsoluteTime fullTime = CFAbsoluteTimeGetCurrent() - start;
+
+				printf("\tfull load %s in %.2f ms\n", drawing ? "succeeded" : "failed", fullTime * 1000.0);
+			}
+		}
+
+		return status;
+	}
+}
@@ -102,6 +102,13 @@ typedef NS_ENUM(NSInteger, DKDimensionToleranceOption) {
 - (NSImage*)standardArrowSwatchImage;
 
 - (nullable NSBezierPath*)arrowPathFromOriginalPath:(NSBezierPath*)inPath fromObject:(id)obj;
+/** @brief The complete arrow for \c obj - its shaft outline, heads and any dimension text - as a path to be filled.
+
+ The arrow is kept in the object's rendering cache and rebuilt only when the object's path, the settings of this stroke that affect
+ its shape, or the formatted dimension text change, so this is much cheaper than <code>-arrowPathFromOriginalPath:fromObject:</code>
+ when an unchanged object is drawn again. The result is shared with the cache and must not be modified.
+ */
+- (nullable NSBezierPath*)arrowPathForObject:(id<DKRenderable>)obj;
 
 // dimensioning lines:
 
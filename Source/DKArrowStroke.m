@@ -22,6 +22,50 @@ NSString* const kDKNegativeToleranceKey = @"DKNegativeTolerance";
 NSString* const kDKDimensionValueKey = @"DKDimensionValue";
 NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 
+/** @brief The parameters of an arrow stroke that affect the shape of the arrow it builds. Zeroed before filling, so that equal
+ parameters are equal bytes.
+ */
+typedef struct {
+	CGFloat width;
+	NSLineCapStyle cap;
+	NSLineJoinStyle join;
+	DKArrowHeadKind headAtStart;
+	DKArrowHeadKind headAtEnd;
+	CGFloat headLength;
+	CGFloat headWidth;
+	DKDimensioningLineOptions dimensionOptions;
+	CGFloat dash[8];
+	NSInteger dashCount;
+	CGFloat dashPhase;
+	BOOL dashScales;
+} DKArrowShapeParameters;
+
+/** @brief An arrow built for one object, with what it was built from. Kept in the object's rendering cache.
+ */
+@interface DKArrowPathCacheEntry : NSObject {
+@public
+	NSUInteger mPathChecksum;
+	NSInteger mPathElementCount;
+	CGFloat mPathLength;
+	DKArrowShapeParameters mParameters;
+	NSAttributedString* mDimensionText;
+	NSBezierPath* mArrowPath;
+}
+@end
+
+@implementation DKArrowPathCacheEntry
+@end
+
+#pragma mark -
+
+@interface DKArrowStroke ()
+
+- (void)getShapeParameters:(DKArrowShapeParameters*)params;
+- (nullable NSAttributedString*)dimensionTextForObject:(nullable id)obj pathLength:(CGFloat)lengthOfPath;
+- (nullable NSBezierPath*)arrowPathFromOriginalPath:(NSBezierPath*)inPath dimensionText:(nullable NSAttributedString*)dim;
+
+@end
+
 #pragma mark -
 @implementation DKArrowStroke
 #pragma mark As a DKArrowStroke
@@ -431,6 +475,12 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 	NSAssert(inPath != nil, @"nil path for creating arrow stroke path");
 	NSAssert(obj != nil, @"nil object for creating arrow stroke path");
 
+	return [self arrowPathFromOriginalPath:inPath
+							 dimensionText:[self dimensionTextForObject:obj]];
+}
+
+- (NSBezierPath*)arrowPathFromOriginalPath:(NSBezierPath*)inPath dimensionText:(NSAttributedString*)dim
+{
 	if ([inPath elementCount] < 2)
 		return nil;
 
@@ -460,7 +510,7 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 	// length needs to be knocked out of the middle of the path
 
 	if ([self dimensioningLineOptions] == kDKDimensionPlaceInLine) {
-		CGFloat dimWidth = [self widthOfDimensionTextForObject:obj]; // add some padding at each end
+		CGFloat dimWidth = [dim size].width; // add some padding at each end
 		CGFloat padding = MAX(dimWidth / 5.0, 8.0);
 
 		shaft = [shaft bezierPathByTrimmingFromCentre:dimWidth + padding];
@@ -491,8 +541,6 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 	// if it's a dimensioning line, append the dimension text
 
 	if ([self dimensioningLineOptions] != kDKDimensionNone) {
-		NSAttributedString* dim = [self dimensionTextForObject:obj];
-
 		if (dim != nil) {
 			CGFloat lineHeight = [[self font] xHeight];
 			CGFloat dy;
@@ -523,6 +571,81 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 	return shaft;
 }
 
+- (void)getShapeParameters:(DKArrowShapeParameters*)params
+{
+	memset(params, 0, sizeof(DKArrowShapeParameters));
+
+	params->width = [self width];
+	params->cap = [self lineCapStyle];
+	params->join = [self lineJoinStyle];
+	params->headAtStart = [self arrowHeadAtStart];
+	params->headAtEnd = [self arrowHeadAtEnd];
+	params->headLength = [self arrowHeadLength];
+	params->headWidth = [self arrowHeadWidth];
+	params->dimensionOptions = [self dimensioningLineOptions];
+
+	DKStrokeDash* dash = [self dash];
+
+	if (dash) {
+		[dash getDashPattern:params->dash
+					   count:&params->dashCount];
+		params->dashPhase = [dash phase];
+		params->dashScales = [dash scalesToLineWidth];
+	}
+}
+
+- (NSBezierPath*)arrowPathForObject:(id<DKRenderable>)obj
+{
+	// building an arrow - trimming and outlining the shaft, making the heads and laying out any dimension text - is far more work than
+	// drawing it, and the result only changes when the object's path, the stroke's settings or the dimension text do. So the finished
+	// arrow is kept in the object's rendering cache along with what it was built from, and rebuilt only when one of those differs.
+
+	NSBezierPath* inPath = [obj renderingPath];
+
+	if (![obj respondsToSelector:@selector(renderingCache)] || [obj renderingCache] == nil)
+		return [self arrowPathFromOriginalPath:inPath
+									fromObject:obj];
+
+	// one object can be drawn by several arrow strokes, so each has its own entry
+
+	DKArrowPathCacheEntry* entry = [self renderingCacheEntryForObject:obj];
+	NSUInteger checksum = [inPath checksum];
+	NSInteger elementCount = [inPath elementCount];
+	BOOL samePath = entry != nil && entry->mPathChecksum == checksum && entry->mPathElementCount == elementCount;
+	DKArrowShapeParameters params;
+
+	[self getShapeParameters:&params];
+
+	// the dimension is the length of the path being drawn, which can be reused while the path is unchanged. It is formatted afresh each
+	// time because the object may supply its own units and tolerances.
+
+	CGFloat pathLength = samePath ? entry->mPathLength : [inPath length];
+	NSAttributedString* dim = nil;
+
+	if ([self dimensioningLineOptions] != kDKDimensionNone)
+		dim = [self dimensionTextForObject:obj
+								pathLength:pathLength];
+
+	if (samePath && memcmp(&params, &entry->mParameters, sizeof(params)) == 0 && (dim == entry->mDimensionText || [dim isEqualToAttributedString:entry->mDimensionText]))
+		return entry->mArrowPath;
+
+	if (entry == nil) {
+		entry = [[DKArrowPathCacheEntry alloc] init];
+		[self setRenderingCacheEntry:entry
+						   forObject:obj];
+	}
+
+	entry->mPathChecksum = checksum;
+	entry->mPathElementCount = elementCount;
+	entry->mPathLength = pathLength;
+	entry->mParameters = params;
+	entry->mDimensionText = [dim copy];
+	entry->mArrowPath = [self arrowPathFromOriginalPath:inPath
+										  dimensionText:dim];
+
+	return entry->mArrowPath;
+}
+
 #pragma mark -
 #pragma mark - dimensioning lines
 
@@ -546,12 +669,20 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 @synthesize dimensioningLineOptions = mDimensionOptions;
 
 - (NSAttributedString*)dimensionTextForObject:(id)obj
+{
+	if ([self dimensioningLineOptions] == kDKDimensionNone)
+		return nil;
+
+	return [self dimensionTextForObject:obj
+							 pathLength:[[obj renderingPath] length]];
+}
+
+- (NSAttributedString*)dimensionTextForObject:(id)obj pathLength:(CGFloat)lengthOfPath
 {
 	NSAttributedString* dimText = nil;
 
 	if ([self dimensioningLineOptions] != kDKDimensionNone) {
 		NSString* dimstr;
-		CGFloat lengthOfPath = [[obj renderingPath] length];
 
 		if ([obj respondsToSelector:@selector(convertLength:)])
 			lengthOfPath = [obj convertLength:lengthOfPath];
@@ -784,13 +915,14 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 	if ([self shadow] != nil && [DKStyle willDrawShadows])
 		[[self shadow] setAbsolute];
 
-	NSBezierPath* ap = [self arrowPathFromOriginalPath:[obj renderingPath]
-											fromObject:obj];
+	NSBezierPath* ap = [self arrowPathForObject:obj];
 
 	if (ap != nil) {
 		[ap fill];
 
 		if ([self outlineColour] != nil) {
+			// the cached path is shared, so it keeps the width it was given here last time; set it each time rather than restore it
+
 			[ap setLineWidth:[self outlineWidth]];
 			[[self outlineColour] setStroke];
 			[ap stroke];
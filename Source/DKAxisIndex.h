@@ -0,0 +1,82 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief One position in an axis index, and the object it belongs to.
+ */
+typedef struct {
+	CGFloat position;
+	__unsafe_unretained id owner;
+} DKAxisIndexEntry;
+
+/** @brief A sorted list of positions along one axis, used to find the nearest guide or object edge to a point in logarithmic time.
+
+ Each position belongs to an owner, such as a guide or a drawable, and an owner may have several positions (an object contributes
+ its two edges and its centre). Owners are not retained - whoever fills the index must keep them alive and remove their positions
+ before releasing them.
+
+ Single positions can be added and removed in place. When many owners change at once it is cheaper to remove them all with
+ -removeEntriesWithOwners: and add their new positions with <code>-addEntries:count:</code>, each of which is a single pass over the
+ index.
+ */
+@interface DKAxisIndex : NSObject {
+@private
+	DKAxisIndexEntry* mEntries;
+	NSUInteger mCount;
+	NSUInteger mCapacity;
+}
+
+- (void)addPosition:(CGFloat)pos owner:(id)owner;
+/** @brief Remove one position belonging to <code>owner</code>. Does nothing if there is no such entry.
+ */
+- (void)removePosition:(CGFloat)pos owner:(id)owner;
+/** @brief Add any number of entries, which needn't be sorted.
+ */
+- (void)addEntries:(const DKAxisIndexEntry*)entries count:(NSUInteger)count;
+/** @brief Remove every entry belonging to any object in <code>owners</code>, which should use pointer personality.
+ */
+- (void)removeEntriesWithOwners:(NSHashTable*)owners;
+- (void)removeAllEntries;
+
+@property (readonly) NSUInteger count;
+/** @brief The entries, in ascending order of position.
+ */
+@property (readonly) const DKAxisIndexEntry* entries NS_RETURNS_INNER_POINTER;
+
+/** @brief Return the index of the first entry whose position is not less than <code>pos</code>, or \c count if there is none.
+ */
+- (NSUInteger)indexOfFirstEntryNotBelow:(CGFloat)pos;
+
+/** @brief Return the owner of the entry nearest to <code>pos</code>, if it is closer than <code>tol</code>.
+
+ Entries whose owners are in \c exclude are skipped over.
+ @param pos the position to search from
+ @param tol entries must be strictly closer than this
+ @param exclude owners to ignore, or nil
+ @param found if not NULL, receives the position of the entry found
+ @return the owner of the nearest entry, or nil if there is none within the tolerance
+ */
+- (nullable id)nearestOwnerToPosition:(CGFloat)pos tolerance:(CGFloat)tol excluding:(nullable NSHashTable*)exclude position:(nullable CGFloat*)found;
+
+/** @brief Find the smallest move that brings any of several reference positions onto an entry.
+
+ This is how a dragged rect is snapped: its two edges and centre are offered together, and whichever lies closest to something
+ in the index wins.
+ @param positions the reference positions
+ @param count the number of reference positions
+ @param tol entries must be strictly closer than this
+ @param exclude owners to ignore, or nil
+ @param offset receives the distance to move, if an entry was found
+ @return YES if any reference position was within tolerance of an entry
+ */
+- (BOOL)snapOffsetForPositions:(const CGFloat*)positions count:(NSUInteger)count tolerance:(CGFloat)tol excluding:(nullable NSHashTable*)exclude offset:(CGFloat*)offset;
+
+@end
+
+NS_ASSUME_NONNULL_END
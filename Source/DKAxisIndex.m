@@ -0,0 +1,187 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKAxisIndex.h"
+
+static int compareEntries(const void* a, const void* b)
+{
+	CGFloat pa = ((const DKAxisIndexEntry*)a)->position;
+	CGFloat pb = ((const DKAxisIndexEntry*)b)->position;
+
+	return (pa < pb) ? -1 : (pa > pb) ? 1 : 0;
+}
+
+@interface DKAxisIndex ()
+
+- (void)ensureCapacity:(NSUInteger)capacity;
+
+@end
+
+#pragma mark -
+
+@implementation DKAxisIndex
+
+- (void)dealloc
+{
+	free(mEntries);
+}
+
+- (void)ensureCapacity:(NSUInteger)capacity
+{
+	if (capacity > mCapacity) {
+		mCapacity = MAX(capacity, MAX(32, mCapacity * 2));
+		mEntries = realloc(mEntries, mCapacity * sizeof(DKAxisIndexEntry));
+	}
+}
+
+- (void)addPosition:(CGFloat)pos owner:(id)owner
+{
+	NSAssert(owner != nil, @"an axis index entry must have an owner");
+
+	[self ensureCapacity:mCount + 1];
+
+	NSUInteger i = [self indexOfFirstEntryNotBelow:pos];
+
+	memmove(&mEntries[i + 1], &mEntries[i], (mCount - i) * sizeof(DKAxisIndexEntry));
+	mEntries[i].position = pos;
+	mEntries[i].owner = owner;
+	++mCount;
+}
+
+- (void)removePosition:(CGFloat)pos owner:(id)owner
+{
+	// several owners can share a position, so look through the run of equal positions for this one
+
+	for (NSUInteger i = [self indexOfFirstEntryNotBelow:pos]; i < mCount && mEntries[i].position == pos; ++i) {
+		if (mEntries[i].owner == owner) {
+			--mCount;
+			memmove(&mEntries[i], &mEntries[i + 1], (mCount - i) * sizeof(DKAxisIndexEntry));
+			return;
+		}
+	}
+}
+
+- (void)addEntries:(const DKAxisIndexEntry*)entries count:(NSUInteger)count
+{
+	if (count == 0)
+		return;
+
+	DKAxisIndexEntry* sorted = malloc(count * sizeof(DKAxisIndexEntry));
+
+	memcpy(sorted, entries, count * sizeof(DKAxisIndexEntry));
+	qsort(sorted, count, sizeof(DKAxisIndexEntry), compareEntries);
+
+	[self ensureCapacity:mCount + count];
+
+	// merge from the top down, so the existing entries can be moved up in place
+
+	NSInteger i = (NSInteger)mCount - 1;
+	NSInteger j = (NSInteger)count - 1;
+	NSInteger k = (NSInteger)(mCount + count) - 1;
+
+	while (j >= 0) {
+		if (i >= 0 && mEntries[i].position > sorted[j].position)
+			mEntries[k--] = mEntries[i--];
+		else
+			mEntries[k--] = sorted[j--];
+	}
+
+	mCount += count;
+	free(sorted);
+}
+
+- (void)removeEntriesWithOwners:(NSHashTable*)owners
+{
+	NSUInteger k = 0;
+
+	for (NSUInteger i = 0; i < mCount; ++i) {
+		if (![owners containsObject:mEntries[i].owner])
+			mEntries[k++] = mEntries[i];
+	}
+
+	mCount = k;
+}
+
+- (void)removeAllEntries
+{
+	mCount = 0;
+}
+
+@synthesize count = mCount;
+@synthesize entries = mEntries;
+
+- (NSUInteger)indexOfFirstEntryNotBelow:(CGFloat)pos
+{
+	NSUInteger lo = 0, hi = mCount;
+
+	while (lo < hi) {
+		NSUInteger mid = (lo + hi) / 2;
+
+		if (mEntries[mid].position < pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+- (id)nearestOwnerToPosition:(CGFloat)pos tolerance:(CGFloat)tol excluding:(NSHashTable*)exclude position:(CGFloat*)found
+{
+	NSUInteger i = [self indexOfFirstEntryNotBelow:pos];
+	NSUInteger best = NSNotFound;
+	CGFloat bestDistance = tol;
+	NSUInteger j;
+
+	// the nearest entry is the first acceptable one on either side of the insertion point
+
+	for (j = i; j < mCount && (mEntries[j].position - pos) < bestDistance; ++j) {
+		if (exclude == nil || ![exclude containsObject:mEntries[j].owner]) {
+			best = j;
+			bestDistance = mEntries[j].position - pos;
+			break;
+		}
+	}
+
+	for (j = i; j > 0 && (pos - mEntries[j - 1].position) < bestDistance; --j) {
+		if (exclude == nil || ![exclude containsObject:mEntries[j - 1].owner]) {
+			best = j - 1;
+			break;
+		}
+	}
+
+	if (best == NSNotFound)
+		return nil;
+
+	if (found)
+		*found = mEntries[best].position;
+
+	return mEntries[best].owner;
+}
+
+- (BOOL)snapOffsetForPositions:(const CGFloat*)positions count:(NSUInteger)count tolerance:(CGFloat)tol excluding:(NSHashTable*)exclude offset:(CGFloat*)offset
+{
+	BOOL snapped = NO;
+	CGFloat bestTolerance = tol;
+	CGFloat found;
+
+	// each search is bounded by the best distance so far, so later reference positions can only win by being closer
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		if ([self nearestOwnerToPosition:positions[i]
+								tolerance:bestTolerance
+								excluding:exclude
+								 position:&found]) {
+			*offset = found - positions[i];
+			bestTolerance = fabs(*offset);
+			snapped = YES;
+		}
+	}
+
+	return snapped;
+}
+
+@end
@@ -5,6 +5,7 @@
 */
 
 #import "DKBSPDirectObjectStorage.h"
+#import "DKTrace.h"
 
 // if this is set to 1, various iterations are done using the much faster CFArrayApplyFunction and CFArraySortValues methods
 
@@ -62,6 +63,7 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 {
 #pragma unused(options)
 
+	DKTraceScope(span, kDKTraceStorage, "BSP direct storage objects in rect");
 	NSMutableArray* results;
 
 	if (aView) {
@@ -83,7 +85,7 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 
 	[self unmarkAll:results];
 
-	//NSLog(@"returning %d object(s)", [results count]);
+	span.argument = [results count];
 
 	// warning, the results returned is the actual mutable array owned by the tree. This is for performance reasons. The client should not
 	// expect the array content to remain stable across each event loop. The client must make a copy if they wish to keep this list (in practice unlikely).
@@ -93,10 +95,13 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 
 - (NSArray*)objectsContainingPoint:(NSPoint)aPoint
 {
+	DKTraceScope(span, kDKTraceStorage, "BSP direct storage objects at point");
 	NSMutableArray* objects = [mTree objectsIntersectingPoint:aPoint];
 
 	[self sortObjectsByZ:objects];
 	[self unmarkAll:objects];
+
+	span.argument = [objects count];
 	return objects;
 }
 
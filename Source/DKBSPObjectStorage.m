@@ -6,6 +6,7 @@
 
 #import "DKBSPObjectStorage.h"
 #import "LogEvent.h"
+#import "DKTrace.h"
 
 // utility functions:
 
@@ -54,6 +55,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 {
 #pragma unused(options)
 
+	DKTraceScope(span, kDKTraceStorage, "BSP storage objects in rect");
 	NSIndexSet* indexes;
 
 	if (aView) {
@@ -83,13 +85,13 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 		}
 	}
 
-	//NSLog(@"returning %d object(s)", [array count]);
-
+	span.argument = [array count];
 	return array;
 }
 
 - (NSArray*)objectsContainingPoint:(NSPoint)aPoint
 {
+	DKTraceScope(span, kDKTraceStorage, "BSP storage objects at point");
 	NSIndexSet* indexes = [mTree itemsIntersectingPoint:aPoint];
 
 	//NSLog(@"indexes returned for hit: %@", indexes );
@@ -101,6 +103,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 			[array addObject:obj];
 	}
 
+	span.argument = [array count];
 	return array;
 }
 
@@ -19,6 +19,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (readonly, strong) NSBezierPath* textPath;
 - (NSArray*)glyphPathsForContainer:(NSTextContainer*)container usedSize:(NSSize*)aSize;
+/** @brief Return the outlines of the laid out glyphs in \c glyphRange as a single path, placed as they would be drawn at \c origin in a flipped
+ view.
+
+ This gives the same path as drawing the glyphs into a flipped context and capturing them in <code>-textPath</code>, but needs no graphics
+ context, so it can be used on any thread.
+ */
+- (NSBezierPath*)textPathForGlyphRange:(NSRange)glyphRange atPoint:(NSPoint)origin;
 
 @end
 
@@ -81,6 +81,56 @@
 	return array;
 }
 
+- (NSBezierPath*)textPathForGlyphRange:(NSRange)glyphRange atPoint:(NSPoint)origin
+{
+	// each glyph is appended at its laid out position and then flipped about its own baseline point, as -glyphPathsForContainer:usedSize:
+	// does, so that it reads the right way up in flipped drawing coordinates.
+
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	NSUInteger g;
+
+	for (g = glyphRange.location; g < NSMaxRange(glyphRange); ++g) {
+		NSGlyph glyph = [self glyphAtIndex:g];
+
+		if (glyph == NSNullGlyph || [self notShownAttributeForGlyphAtIndex:g])
+			continue;
+
+		NSRect fragRect = [self lineFragmentRectForGlyphAtIndex:g
+												 effectiveRange:NULL];
+		NSPoint loc = [self locationForGlyphAtIndex:g];
+		NSFont* font = [[self textStorage] attribute:NSFontAttributeName
+											 atIndex:[self characterIndexForGlyphAtIndex:g]
+									  effectiveRange:NULL];
+		NSBezierPath* temp = [NSBezierPath bezierPath];
+
+		// text without a font is laid out in 12 point Helvetica
+
+		if (font == nil)
+			font = [NSFont fontWithName:@"Helvetica"
+								   size:12];
+
+		loc.x += fragRect.origin.x + origin.x;
+		loc.y += fragRect.origin.y + origin.y;
+
+		[temp moveToPoint:loc];
+		[temp appendBezierPathWithGlyph:glyph
+								 inFont:font];
+
+		NSAffineTransform* xform = [NSAffineTransform transform];
+		[xform translateXBy:loc.x
+						yBy:loc.y];
+		[xform scaleXBy:1.0
+					yBy:-1.0];
+		[xform translateXBy:-loc.x
+						yBy:-loc.y];
+		[temp transformUsingAffineTransform:xform];
+
+		[path appendBezierPath:temp];
+	}
+
+	return path;
+}
+
 #pragma mark -
 #pragma mark - as a NSLayoutManager
 
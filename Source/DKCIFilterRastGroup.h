@@ -9,16 +9,23 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class DKRasterEffectPipeline;
+
 /** @brief Captures the output of its contained renderers in an image
 
  This class implements a special rendergroup that captures the output of its contained renderers in an image, then
  allows that image to be manipulated or processed (e.g. by core image) before rendering it back to the drawing. This
  allows us to leverage all sorts of imaging code to extend the range of available styles and effects.
+
+ Filters that DKRasterEffectPipeline can reproduce - blurs, colour matrices and drop shadows - are done on the CPU without Core Image;
+ any other is done by Core Image. Either way the filtered image is kept in each object's rendering cache, at the scale it was drawn
+ at, and made again only when the object changes, this group's filter or arguments change, or the object is drawn at another scale.
 */
 @interface DKCIFilterRastGroup : DKRastGroup <NSCoding, NSCopying> {
 	NSString* m_filter;
 	NSDictionary<NSString*, id>* m_arguments;
-	NSImage* m_cache;
+	DKRasterEffectPipeline* m_pipeline; // the filter done on the CPU, or nil if Core Image must do it
+	NSUInteger m_generation; // advanced when the filter changes, so that images cached by objects can tell they are stale
 }
 
 + (instancetype)effectGroupWithFilter:(NSString*)filter;
@@ -27,6 +34,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (copy, nullable) NSDictionary<NSString*, id>* arguments;
 
+/** @brief Mark every filtered image made so far as stale, so that each object's is made again the next time it is drawn.
+ */
 - (void)invalidateCache;
 
 @end
@@ -7,11 +7,67 @@
 #import "DKCIFilterRastGroup.h"
 
 #import "DKDrawableObject.h"
+#import "DKDrawKitMacros.h"
+#import "DKRasterEffectPipeline.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Geometry.h"
 #import "NSDictionary+DeepCopy.h"
 #import <QuartzCore/QuartzCore.h>
 
+// the largest filtered image made, in pixels on its longer side; objects zoomed in further than this are filtered at a lower resolution
+
+#define MAXIMUM_EFFECT_PIXELS 4096.0
+
+/** @brief A filtered image kept in an object's rendering cache, and what it was made for.
+ */
+@interface DKFilterEffectCacheEntry : NSObject {
+@public
+	NSRect mRect; // the area the image covers, in the object's coordinates
+	CGFloat mScale; // pixels per point in the image
+	NSUInteger mGeneration; // the group's generation when the image was made
+	CGImageRef mImage;
+}
+
+@end
+
+@implementation DKFilterEffectCacheEntry
+
+- (void)dealloc
+{
+	CGImageRelease(mImage);
+}
+
+@end
+
+static CGFloat effectScaleForContext(CGContextRef context, NSSize size)
+{
+	// the image is made at the device resolution, rounded so that tiny changes in the transform don't make it again
+
+	CGAffineTransform ctm = CGContextGetUserSpaceToDeviceSpaceTransform(context);
+	CGFloat scale = ceil(sqrt(fabs(ctm.a * ctm.d - ctm.b * ctm.c)) * 4.0) / 4.0;
+
+	scale = MIN(scale, MAXIMUM_EFFECT_PIXELS / MAX(size.width, size.height));
+
+	return MAX(scale, 0.25);
+}
+
+@interface DKCIFilterRastGroup ()
+
+/** @brief Return the filtered image of \c object covering <code>imgRect</code>, from the object's rendering cache if it is there.
+ The caller must release it.
+ */
+- (nullable CGImageRef)newEffectImageForObject:(DKDrawableObject*)object inRect:(NSRect)imgRect scale:(CGFloat)scale CF_RETURNS_RETAINED;
+/** @brief Capture the contained renderers' drawing of \c object and filter it. The caller must release the result.
+ */
+- (nullable CGImageRef)newFilteredImageOfObject:(DKDrawableObject*)object inRect:(NSRect)imgRect scale:(CGFloat)scale CF_RETURNS_RETAINED;
+/** @brief Filter a captured image with Core Image, for filters the raster effects can't do. The caller must release the result.
+ */
+- (nullable CGImageRef)newCoreImageFilteredImageFromBuffer:(DKRasterBuffer*)buffer forObject:(DKDrawableObject*)object scale:(CGFloat)scale CF_RETURNS_RETAINED;
+
+@end
+
+#pragma mark -
+
 @implementation DKCIFilterRastGroup
 #pragma mark As a DKCIFilterRastGroup
 
@@ -37,12 +93,169 @@
 }
 
 @synthesize filter = m_filter;
+
+- (void)setArguments:(NSDictionary<NSString*, id>*)arguments
+{
+	m_arguments = [arguments copy];
+
+	[self invalidateCache];
+}
+
 @synthesize arguments = m_arguments;
 
 #pragma mark -
 - (void)invalidateCache
 {
-	m_cache = nil;
+	// the images are kept by the objects, so can't be removed from here - instead they are ignored once the generation moves on
+
+	++m_generation;
+	m_pipeline = [DKRasterEffectPipeline pipelineWithFilter:m_filter
+												   arguments:m_arguments];
+}
+
+- (CGImageRef)newEffectImageForObject:(DKDrawableObject*)object inRect:(NSRect)imgRect scale:(CGFloat)scale
+{
+	// capturing and filtering the object is far more work than drawing the result, which only changes when the object does (which
+	// empties its rendering cache), when the filter does (which moves the generation on), or when it is drawn at another scale
+
+	DKFilterEffectCacheEntry* entry = [self renderingCacheEntryForObject:object];
+
+	if (entry != nil && entry->mGeneration == m_generation && entry->mScale == scale && NSEqualRects(entry->mRect, imgRect))
+		return CGImageRetain(entry->mImage);
+
+	CGImageRef image = [self newFilteredImageOfObject:object
+											   inRect:imgRect
+												scale:scale];
+
+	if (image != NULL) {
+		if (entry == nil) {
+			entry = [[DKFilterEffectCacheEntry alloc] init];
+			[self setRenderingCacheEntry:entry
+							   forObject:object];
+		}
+
+		CGImageRelease(entry->mImage);
+		entry->mImage = CGImageRetain(image);
+		entry->mRect = imgRect;
+		entry->mScale = scale;
+		entry->mGeneration = m_generation;
+	}
+
+	return image;
+}
+
+- (CGImageRef)newFilteredImageOfObject:(DKDrawableObject*)object inRect:(NSRect)imgRect scale:(CGFloat)scale
+{
+	DKRasterBufferPool* pool = [DKRasterBufferPool sharedPool];
+	DKRasterBuffer buffer;
+
+	if (![pool getBuffer:&buffer
+				   width:(size_t)ceil(NSWidth(imgRect) * scale)
+				  height:(size_t)ceil(NSHeight(imgRect) * scale)])
+		return NULL;
+
+	CGContextRef bm = DKRasterBufferCreateContext(&buffer);
+
+	if (bm == NULL) {
+		[pool recycleBuffer:&buffer];
+		return NULL;
+	}
+
+	// captured flipped, as the drawing is, so that the top row of the buffer is the top of imgRect
+
+	CGContextTranslateCTM(bm, 0, buffer.height);
+	CGContextScaleCTM(bm, scale, -scale);
+	CGContextTranslateCTM(bm, -NSMinX(imgRect), -NSMinY(imgRect));
+
+	SAVE_GRAPHICS_CONTEXT
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithGraphicsPort:bm
+																					 flipped:YES]];
+
+	DKClippingOption saveClipping = [self clipping];
+	[self setClippingWithoutNotifying:kDKClippingNone];
+
+	[super render:object];
+	[self setClippingWithoutNotifying:saveClipping];
+	RESTORE_GRAPHICS_CONTEXT
+
+	CGContextRelease(bm);
+
+	CGImageRef image = NULL;
+
+	if (m_pipeline == nil)
+		image = [self newCoreImageFilteredImageFromBuffer:&buffer
+												forObject:object
+													scale:scale];
+	else if ([m_pipeline applyToBuffer:&buffer
+								 scale:scale])
+		image = DKRasterBufferCreateImage(&buffer);
+
+	[pool recycleBuffer:&buffer];
+
+	return image;
+}
+
+- (CGImageRef)newCoreImageFilteredImageFromBuffer:(DKRasterBuffer*)buffer forObject:(DKDrawableObject*)object scale:(CGFloat)scale
+{
+	CGImageRef captured = DKRasterBufferCreateImage(buffer);
+	CGImageRef image = NULL;
+
+	if (captured == NULL)
+		return NULL;
+
+	@try {
+		CIFilter* filter = [CIFilter filterWithName:[self filter]];
+		NSMutableDictionary* args = [[self arguments] mutableCopy];
+
+		[filter setDefaults];
+
+		if ([[filter inputKeys] containsObject:@"inputCenter"]) {
+			// if the arguments don't contain a centre value, set it from the object's offset
+
+			if (args == nil)
+				args = [[NSMutableDictionary alloc] init];
+
+			NSPoint pp;
+
+			pp.x = buffer->width * 0.5 + ([object offset].width * [object size].width * scale);
+			pp.y = buffer->height * 0.5 + ([object offset].height * [object size].height * scale);
+
+			[args setObject:[CIVector vectorWithX:pp.x
+												Y:pp.y]
+					 forKey:@"inputCenter"];
+		}
+
+		if (args)
+			[filter setValuesForKeysWithDictionary:args];
+
+		[filter setValue:[CIImage imageWithCGImage:captured]
+				  forKey:kCIInputImageKey];
+
+		CIImage* output = [filter valueForKey:kCIOutputImageKey];
+
+		if (output) {
+			// the result goes back into the capture buffer, cropped to it
+
+			CGRect bounds = CGRectMake(0, 0, buffer->width, buffer->height);
+			CGContextRef bm = DKRasterBufferCreateContext(buffer);
+
+			CGContextClearRect(bm, bounds);
+			[[CIContext contextWithCGContext:bm
+									 options:nil] drawImage:output
+													 inRect:bounds
+												   fromRect:bounds];
+			CGContextRelease(bm);
+
+			image = DKRasterBufferCreateImage(buffer);
+		}
+	}
+	@catch (NSException* e) {
+		LogEvent_(kWheneverEvent, @"exception encountered during core image filtering: %@", e);
+	}
+
+	CGImageRelease(captured);
+
+	return image;
 }
 
 #pragma mark -
@@ -85,8 +298,12 @@
 	NSSize es = [super extraSpaceNeeded];
 
 	if ([self clipping] != kDKClippingInsidePath) {
-		es.width += (CIIMAGE_PADDING * 2);
-		es.height += (CIIMAGE_PADDING * 2);
+		// a filter done on the CPU knows how far it spreads; Core Image's might spread any distance
+
+		NSSize fx = m_pipeline ? [m_pipeline extraSpaceNeeded] : NSMakeSize(CIIMAGE_PADDING, CIIMAGE_PADDING);
+
+		es.width += (fx.width * 2);
+		es.height += (fx.height * 2);
 	}
 	return es;
 }
@@ -96,83 +313,58 @@
 	if (![self enabled])
 		return;
 
-	NSBezierPath* path = [self renderingPathForObject:object];
-	NSRect br = [path bounds];
-	NSSize extra = [self extraSpaceNeeded];
-
-	NSRect imgRect = NSInsetRect(br, -extra.width, -extra.height);
-
-	if (m_cache) {
-
-	} else {
-		NSImage* image = [[NSImage alloc] initWithSize:imgRect.size];
-
-		NSAffineTransform* tfm = [NSAffineTransform transform];
-		[tfm translateXBy:extra.width - br.origin.x
-					  yBy:extra.height - br.origin.y];
-		//[tfm scaleXBy:1.0 yBy:-1.0];
-
-		[image lockFocusFlipped:YES];
-		[tfm set];
-
-		DKClippingOption saveClipping = [self clipping];
-		[self setClippingWithoutNotifying:kDKClippingNone];
+	// hit-testing draws into a tiny context that would clamp the effect to its lowest scale and replace the image cached for the
+	// screen, and only cares which pixels are covered, so the unfiltered contents will do
 
+	if ([object isBeingHitTested]) {
 		[super render:object];
-		[self setClippingWithoutNotifying:saveClipping];
-
-		[image unlockFocus];
-
-		// captured, now render it back to the drawing, applying the filter
-
-		NSRect fr = NSZeroRect;
-		fr.size = imgRect.size;
-
-		SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
-			switch ([self clipping])
-		{
-		default:
-		case kDKClippingNone:
-			break;
+		return;
+	}
 
-		case kDKClippingInsidePath:
-			[path addClip];
-			break;
+	NSBezierPath* path = [self renderingPathForObject:object];
+	NSSize extra = [self extraSpaceNeeded];
+	NSRect imgRect = NSInsetRect([path bounds], -extra.width, -extra.height);
 
-		case kDKClippingOutsidePath:
-			[path addInverseClip];
-			break;
-		}
+	if (NSIsEmptyRect(imgRect))
+		return;
 
-		NSArray* inputKeys = [[CIFilter filterWithName:[self filter]] inputKeys];
+	NSGraphicsContext* gc = [NSGraphicsContext currentContext];
+	CGContextRef context = [gc graphicsPort];
+	CGImageRef image = [self newEffectImageForObject:object
+											  inRect:imgRect
+											   scale:effectScaleForContext(context, imgRect.size)];
 
-		//NSLog(@"input keys = %@", inputKeys);
+	if (image == NULL)
+		return;
 
-		NSMutableDictionary* args = [[self arguments] mutableCopy];
+	// render it back to the drawing, clipped as set
 
-		if ([inputKeys containsObject:@"inputCenter"]) {
-			// if the arguments don't contain a centre value, set it from the object's offset
+	SAVE_GRAPHICS_CONTEXT
+	switch ([self clipping]) {
+	default:
+	case kDKClippingNone:
+		break;
 
-			if (args == nil)
-				args = [[NSMutableDictionary alloc] init];
+	case kDKClippingInsidePath:
+		[path addClip];
+		break;
 
-			NSPoint pp;
+	case kDKClippingOutsidePath:
+		[path addInverseClip];
+		break;
+	}
 
-			pp.x = imgRect.size.width * 0.5 + ([object offset].width * [object size].width);
-			pp.y = imgRect.size.height * 0.5 + ([object offset].height * [object size].height);
+	// the image's top row is the top of imgRect, which in a flipped context means turning it over
 
-			[args setObject:[CIVector vectorWithX:pp.x
-												Y:pp.y]
-					 forKey:@"inputCenter"];
-		}
+	if ([gc isFlipped]) {
+		CGContextTranslateCTM(context, 0, NSMinY(imgRect) + NSMaxY(imgRect));
+		CGContextScaleCTM(context, 1, -1);
+	}
 
-		[image drawInRect:imgRect
-				   fromRect:fr
-			coreImageFilter:[self filter]
-				  arguments:args];
+	CGContextDrawImage(context, NSRectToCGRect(imgRect), image);
+	RESTORE_GRAPHICS_CONTEXT
 
-		RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
-	}
+	CGImageRelease(image);
 }
 
 #pragma mark -
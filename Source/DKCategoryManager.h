@@ -58,6 +58,10 @@ typedef NS_OPTIONS(NSUInteger, DKCatManagerMergeOptions) {
 	NSUInteger m_maxRecentlyUsedItems;
 	NSMutableArray<DKCategoryManagerMenuInfo*>* mMenusList;
 	BOOL mRecentlyAddedEnabled;
+	NSMutableDictionary<NSString*, ObjectType>* mObjectsByKey; // the master list keyed by the keys as given rather than lowercased
+	NSMapTable<ObjectType, NSMutableArray<NSString*>*>* mKeysByObject; // reverse of mObjectsByKey, keyed by object identity
+	NSMutableDictionary<DKCategoryName, NSMutableSet<NSString*>*>* mCategoryKeySets; // hashed copies of the category lists, built on demand
+	NSUInteger mChangeCount;
 }
 
 /** @brief Returns a new category manager object
@@ -164,6 +168,12 @@ typedef NS_OPTIONS(NSUInteger, DKCatManagerMergeOptions) {
  */
 @property (readonly) NSUInteger count;
 
+/** @brief A number that changes whenever an object is added to or removed from the container.
+
+ Do not rely on what the number is, only whether it has changed. Subclasses can use it to validate indexes of their own.
+ */
+@property (readonly) NSUInteger changeCount;
+
 /** @brief Return the object for the given key, but do not remember it in the "recently used" list.
  @param key The object's key.
  @return The object if available, else <code>nil</code>.
@@ -8,7 +8,6 @@
 #import "DKUnarchivingHelper.h"
 #import "LogEvent.h"
 #import "NSDictionary+DeepCopy.h"
-#import "NSMutableArray+DKAdditions.h"
 #import "NSString+DKAdditions.h"
 
 #pragma mark Contants(Non - localized)
@@ -79,6 +78,13 @@ enum {
 
 - (nullable DKCategoryManagerMenuInfo*)findInfoForMenu:(NSMenu*)aMenu;
 
+// the master list is only modified through these, which keep the lookup indexes in step with it
+
+- (void)setMasterObject:(id)obj forKey:(NSString*)key;
+- (void)removeMasterObjectForKey:(NSString*)key;
+- (void)rebuildIndexes;
+- (nullable NSMutableSet<NSString*>*)keySetForCategory:(NSString*)catName;
+
 @end
 
 #pragma mark -
@@ -157,6 +163,7 @@ static id sDearchivingHelper = nil;
 			[m_categories setDictionary:cm->m_categories];
 			[m_recentlyAdded setArray:cm->m_recentlyAdded];
 			[m_recentlyUsed setArray:cm->m_recentlyUsed];
+			[self rebuildIndexes];
 
 			m_maxRecentlyUsedItems = cm->m_maxRecentlyUsedItems;
 			m_maxRecentlyAddedItems = cm->m_maxRecentlyAddedItems;
@@ -179,8 +186,8 @@ static id sDearchivingHelper = nil;
 
 		for (NSString* s in dict) {
 			id obj = [dict objectForKey:s];
-			[m_masterList setObject:obj
-							 forKey:[s lowercaseString]];
+			[self setMasterObject:obj
+						   forKey:s];
 		}
 
 		// add to "All Items":
@@ -189,6 +196,7 @@ static id sDearchivingHelper = nil;
 
 		if (aicat) {
 			[aicat addObjectsFromArray:[dict allKeys]];
+			[mCategoryKeySets removeObjectForKey:kDKDefaultCategoryName];
 		}
 	}
 
@@ -211,8 +219,8 @@ static id sDearchivingHelper = nil;
 
 	// add the object to the master list
 
-	[m_masterList setObject:obj
-					 forKey:[name lowercaseString]];
+	[self setMasterObject:obj
+				   forKey:name];
 	[self addKey:name
 		toRecentList:kDKListRecentlyAdded];
 
@@ -244,8 +252,8 @@ static id sDearchivingHelper = nil;
 
 	// add the object to the master list
 
-	[m_masterList setObject:obj
-					 forKey:[name lowercaseString]];
+	[self setMasterObject:obj
+				   forKey:name];
 	[self addKey:name
 		toRecentList:kDKListRecentlyAdded];
 
@@ -281,7 +289,7 @@ static id sDearchivingHelper = nil;
 
 	// remove from master dictionary
 
-	[m_masterList removeObjectForKey:[key lowercaseString]];
+	[self removeMasterObjectForKey:key];
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerDidRemoveObject
 														object:self];
 }
@@ -302,7 +310,7 @@ static id sDearchivingHelper = nil;
 
 - (BOOL)containsKey:(NSString*)key
 {
-	return [[m_masterList allKeys] containsObject:[key lowercaseString]];
+	return [self objectForKey:key] != nil;
 }
 
 - (NSUInteger)count
@@ -310,11 +318,20 @@ static id sDearchivingHelper = nil;
 	return [m_masterList count];
 }
 
+@synthesize changeCount = mChangeCount;
+
 #pragma mark -
 
 - (id)objectForKey:(NSString*)key
 {
-	return [m_masterList objectForKey:[key lowercaseString]];
+	// nearly all lookups use the key exactly as it was given, which avoids making a lowercase copy of it
+
+	id obj = [mObjectsByKey objectForKey:key];
+
+	if (obj == nil && key != nil)
+		obj = [m_masterList objectForKey:[key lowercaseString]];
+
+	return obj;
 }
 
 - (id)objectForKey:(NSString*)key addToRecentlyUsedItems:(BOOL)add
@@ -334,16 +351,21 @@ static id sDearchivingHelper = nil;
 
 - (NSArray*)keysForObject:(id)obj
 {
-	//return [[self dictionary] allKeysForObject:obj];  // doesn't work because master dict uses lowercase keys
+	NSArray* keys = [mKeysByObject objectForKey:obj];
 
-	NSMutableArray* keys = [[NSMutableArray alloc] init];
+	if (keys)
+		return [keys copy];
+
+	// the index is by identity, so an object that is only equal to one stored here has to be found the slow way
+
+	NSMutableArray* equalKeys = [NSMutableArray array];
 
 	for (NSString* key in [self allKeys]) {
 		if ([[self objectForKey:key] isEqual:obj])
-			[keys addObject:key];
+			[equalKeys addObject:key];
 	}
 
-	return keys;
+	return equalKeys;
 }
 
 - (NSDictionary*)dictionary
@@ -446,24 +468,24 @@ static id sDearchivingHelper = nil;
 
 - (NSArray*)objectsInCategory:(NSString*)catName
 {
-	NSMutableArray* keys = [[NSMutableArray alloc] init];
+	NSArray* keys = [self allKeysInCategory:catName];
+	NSMutableArray* objects = [NSMutableArray arrayWithCapacity:[keys count]];
 
-	for (NSString* s in [self allKeysInCategory:catName])
-		[keys addObject:[s lowercaseString]];
+	for (NSString* key in keys)
+		[objects addObject:[self objectForKey:key] ?: [NSNull null]];
 
-	return [m_masterList objectsForKeys:keys
-						 notFoundMarker:[NSNull null]];
+	return objects;
 }
 
 - (NSArray*)objectsInCategories:(NSArray*)catNames
 {
-	NSMutableArray* keys = [[NSMutableArray alloc] init];
+	NSArray* keys = [self allKeysInCategories:catNames];
+	NSMutableArray* objects = [NSMutableArray arrayWithCapacity:[keys count]];
 
-	for (NSString* s in [self allKeysInCategories:catNames])
-		[keys addObject:[s lowercaseString]];
+	for (NSString* key in keys)
+		[objects addObject:[self objectForKey:key] ?: [NSNull null]];
 
-	return [m_masterList objectsForKeys:keys
-						 notFoundMarker:[NSNull null]];
+	return objects;
 }
 
 - (NSArray*)allKeysInCategory:(NSString*)catName
@@ -481,18 +503,14 @@ static id sDearchivingHelper = nil;
 	if ([catNames count] == 1)
 		return [self allKeysInCategory:[catNames lastObject]];
 	else {
-		NSMutableArray* temp = [[NSMutableArray alloc] init];
-		NSArray* keys;
+		NSMutableOrderedSet* temp = [[NSMutableOrderedSet alloc] init];
 
-		for (NSString* catname in catNames) {
-			keys = [self allKeysInCategory:catname];
+		// an ordered set keeps the first occurrence of each key, in category order
 
-			// add keys not already in <temp> to temp
+		for (NSString* catname in catNames)
+			[temp addObjectsFromArray:[self allKeysInCategory:catname]];
 
-			[temp addUniqueObjectsFromArray:keys];
-		}
-
-		return temp;
+		return [temp array];
 	}
 }
 
@@ -594,6 +612,7 @@ static id sDearchivingHelper = nil;
 															object:self
 														  userInfo:info];
 		[m_categories removeObjectForKey:catName];
+		[mCategoryKeySets removeObjectForKey:catName];
 
 		// inform menus that category has gone
 
@@ -613,6 +632,8 @@ static id sDearchivingHelper = nil;
 
 	if (gs) {
 		[m_categories removeObjectForKey:catName];
+		[mCategoryKeySets removeObjectForKey:catName];
+		[mCategoryKeySets removeObjectForKey:newname];
 
 		[m_categories setObject:gs
 						 forKey:newname];
@@ -635,6 +656,7 @@ static id sDearchivingHelper = nil;
 	[m_categories removeAllObjects];
 	[m_recentlyUsed removeAllObjects];
 	[m_recentlyAdded removeAllObjects];
+	[self rebuildIndexes];
 
 	[mMenusList makeObjectsPerformSelector:@selector(removeAll)];
 }
@@ -666,8 +688,11 @@ static id sDearchivingHelper = nil;
 
 	// add the key to this group's list if not already known
 
-	if (![ga containsObject:key]) {
+	NSMutableSet* keySet = [self keySetForCategory:catName];
+
+	if (![keySet containsObject:key]) {
 		[ga addObject:key];
+		[keySet addObject:key];
 
 		// update menus
 
@@ -705,7 +730,13 @@ static id sDearchivingHelper = nil;
 
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerWillRemoveKeyFromCategory
 															object:self];
-		[ga removeObject:key];
+
+		NSMutableSet* keySet = [self keySetForCategory:catName];
+
+		if ([keySet containsObject:key]) {
+			[ga removeObject:key];
+			[keySet removeObject:key];
+		}
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerDidRemoveKeyFromCategory
 															object:self];
 	}
@@ -798,10 +829,8 @@ static id sDearchivingHelper = nil;
 
 	catList = [[NSMutableArray alloc] init];
 
-	for (NSString* catName in [m_categories allKeys]) {
-		NSArray* cat = [self allKeysInCategory:catName];
-
-		if ([cat containsObject:key])
+	for (NSString* catName in m_categories) {
+		if ([[self keySetForCategory:catName] containsObject:key])
 			[catList addObject:catName];
 	}
 
@@ -837,7 +866,7 @@ static id sDearchivingHelper = nil;
 
 - (BOOL)key:(NSString*)key existsInCategory:(NSString*)catName
 {
-	return [[m_categories objectForKey:catName] containsObject:key];
+	return [[self keySetForCategory:catName] containsObject:key];
 }
 
 #pragma mark -
@@ -983,6 +1012,7 @@ static id sDearchivingHelper = nil;
 		[m_categories setDictionary:newCM->m_categories];
 		[m_recentlyUsed setArray:newCM->m_recentlyUsed];
 		[m_recentlyAdded setArray:newCM->m_recentlyAdded];
+		[self rebuildIndexes];
 
 		// TODO: deal with menus
 
@@ -1125,6 +1155,122 @@ static id sDearchivingHelper = nil;
 		[menuInfo checkItemsForKey:key];
 }
 
+#pragma mark -
+#pragma mark - indexes
+
+- (void)setMasterObject:(id)obj forKey:(NSString*)key
+{
+	// the master list is case insensitive, so this may replace an object added under a key differing only in case
+
+	if ([m_masterList objectForKey:[key lowercaseString]] != nil)
+		[self removeMasterObjectForKey:key];
+
+	[m_masterList setObject:obj
+					 forKey:[key lowercaseString]];
+	[mObjectsByKey setObject:obj
+					  forKey:key];
+
+	NSMutableArray* keys = [mKeysByObject objectForKey:obj];
+
+	if (keys == nil) {
+		keys = [NSMutableArray array];
+		[mKeysByObject setObject:keys
+						  forKey:obj];
+	}
+
+	[keys addObject:key];
+	++mChangeCount;
+}
+
+- (void)removeMasterObjectForKey:(NSString*)key
+{
+	NSString* lcKey = [key lowercaseString];
+	id obj = [m_masterList objectForKey:lcKey];
+
+	if (obj == nil)
+		return;
+
+	NSMutableArray* keys = [mKeysByObject objectForKey:obj];
+
+	for (NSString* k in [keys copy]) {
+		if ([[k lowercaseString] isEqualToString:lcKey]) {
+			[keys removeObject:k];
+			[mObjectsByKey removeObjectForKey:k];
+		}
+	}
+
+	if ([keys count] == 0)
+		[mKeysByObject removeObjectForKey:obj];
+
+	[m_masterList removeObjectForKey:lcKey];
+	++mChangeCount;
+}
+
+/** @brief Rebuilds the indexes from scratch after the master list and categories have been replaced wholesale
+
+ Every object in the master list is indexed, whether or not it is in any category. The master list only records lowercased keys, so
+ the keys as given are recovered from the categories where possible; an object in no category is indexed under its lowercased key.
+ */
+- (void)rebuildIndexes
+{
+	[mObjectsByKey removeAllObjects];
+	[mKeysByObject removeAllObjects];
+	[mCategoryKeySets removeAllObjects];
+
+	NSMutableDictionary<NSString*, NSString*>* givenKeys = [NSMutableDictionary dictionaryWithCapacity:[m_masterList count]];
+
+	for (NSArray* keys in [m_categories objectEnumerator]) {
+		for (NSString* key in keys) {
+			NSString* lcKey = [key lowercaseString];
+
+			if ([givenKeys objectForKey:lcKey] == nil)
+				[givenKeys setObject:key
+							  forKey:lcKey];
+		}
+	}
+
+	[m_masterList enumerateKeysAndObjectsUsingBlock:^(NSString* lcKey, id obj, BOOL* stop) {
+#pragma unused(stop)
+		NSString* key = [givenKeys objectForKey:lcKey];
+
+		if (key == nil)
+			key = lcKey;
+
+		[mObjectsByKey setObject:obj
+						  forKey:key];
+
+		NSMutableArray* objKeys = [mKeysByObject objectForKey:obj];
+
+		if (objKeys == nil) {
+			objKeys = [NSMutableArray array];
+			[mKeysByObject setObject:objKeys
+							  forKey:obj];
+		}
+
+		[objKeys addObject:key];
+	}];
+
+	++mChangeCount;
+}
+
+- (NSMutableSet*)keySetForCategory:(NSString*)catName
+{
+	NSMutableSet* keySet = [mCategoryKeySets objectForKey:catName];
+
+	if (keySet == nil) {
+		NSArray* keys = [m_categories objectForKey:catName];
+
+		if (keys == nil)
+			return nil;
+
+		keySet = [NSMutableSet setWithArray:keys];
+		[mCategoryKeySets setObject:keySet
+							 forKey:catName];
+	}
+
+	return keySet;
+}
+
 #pragma mark -
 #pragma mark As an NSObject
 - (instancetype)init
@@ -1136,6 +1282,9 @@ static id sDearchivingHelper = nil;
 		m_recentlyAdded = [[NSMutableArray alloc] init];
 		m_recentlyUsed = [[NSMutableArray alloc] init];
 		mMenusList = [[NSMutableArray alloc] init];
+		mObjectsByKey = [[NSMutableDictionary alloc] init];
+		mKeysByObject = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
+		mCategoryKeySets = [[NSMutableDictionary alloc] init];
 		mRecentlyAddedEnabled = YES;
 		m_maxRecentlyAddedItems = kDKDefaultMaxRecentArraySize;
 		m_maxRecentlyUsedItems = kDKDefaultMaxRecentArraySize;
@@ -1185,6 +1334,9 @@ static id sDearchivingHelper = nil;
 		mRecentlyAddedEnabled = YES;
 
 		mMenusList = [[NSMutableArray alloc] init];
+		mObjectsByKey = [[NSMutableDictionary alloc] init];
+		mKeysByObject = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
+		mCategoryKeySets = [[NSMutableDictionary alloc] init];
 
 		if (m_masterList == nil
 			|| m_categories == nil
@@ -1192,6 +1344,8 @@ static id sDearchivingHelper = nil;
 			|| m_recentlyUsed == nil) {
 			return nil;
 		}
+
+		[self rebuildIndexes];
 	}
 
 	return self;
@@ -1212,6 +1366,7 @@ static id sDearchivingHelper = nil;
 
 	NSDictionary* cats = [m_categories deepCopy];
 	[copy->m_categories setDictionary:cats];
+	[copy rebuildIndexes];
 
 	return copy;
 }
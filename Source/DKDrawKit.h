@@ -25,6 +25,7 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 #import "DKDrawing.h"
 #import "DKDrawing+Paper.h"
 #import "DKDrawing+Export.h"
+#import "DKDrawingPreview.h"
 
 #import "DKLayer.h"
 #import "DKLayer+Metadata.h"
@@ -36,12 +37,14 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 
 #import "DKGridLayer.h"
 #import "DKGuideLayer.h"
+#import "DKAxisIndex.h"
 #import "DKDrawingInfoLayer.h"
 #import "DKImageOverlayLayer.h"
 
 #import "DKDrawableObject.h"
 #import "DKDrawableObject+Metadata.h"
 #import "DKDrawableShape.h"
+#import "DKGeometryTable.h"
 #import "DKReshapableShape.h"
 #import "DKDrawableShape+Hotspots.h"
 #import "DKImageShape.h"
@@ -56,9 +59,12 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 #import "DKStyle.h"
 #import "DKStyle+Text.h"
 #import "DKStyle+SimpleAccess.h"
+#import "DKStyleReader.h"
+#import "DKExpression.h"
 #import "DKRasterizer.h"
 #import "DKRastGroup.h"
 #import "DKRasterizerProtocol.h"
+#import "DKRenderProgram.h"
 
 #import "NSColor+DKAdditions.h"
 #import "DKStrokeDash.h"
@@ -71,6 +77,8 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 #import "DKFill.h"
 #import "DKZigZagFill.h"
 #import "DKCIFilterRastGroup.h"
+#import "DKRasterEffects.h"
+#import "DKRasterEffectPipeline.h"
 #import "DKTextAdornment.h"
 #import "DKPathDecorator.h"
 #import "DKQuartzBlendRastGroup.h"
@@ -90,6 +98,7 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 
 #import "DKRandom.h"
 #import "DKUniqueID.h"
+#import "DKTrace.h"
 #import "DKGeometryUtilities.h"
 #import "DKDistortionTransform.h"
 #import "DKCategoryManager.h"
@@ -108,6 +117,8 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 #import "DKUndoManager.h"
 #import "NSBezierPath+Editing.h"
 #import "NSBezierPath+Geometry.h"
+#import "DKFlatPath.h"
+#import "DKFlatPath+Offset.h"
 #import "NSBezierPath+Text.h"
 #import "NSDictionary+DeepCopy.h"
 #import "NSShadow+Scaling.h"
@@ -116,6 +127,7 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 #import "NSMutableArray+DKAdditions.h"
 #import "NSImage+DKAdditions.h"
 #import "DKQuartzCache.h"
+#import "DKImageCache.h"
 
 #ifdef qUseLogEvent
 #import "LogEvent.h"
@@ -43,6 +43,13 @@ typedef NS_ENUM(NSInteger, DKMetadataSchema) {
 @property (readonly) DKMetadataSchema schema;
 
 - (void)setMetadataItem:(DKMetadataItem*)item forKey:(NSString*)key;
+/** @brief Return the metadata item for \c key, looking in the object's containers if the object has none of its own.
+
+ Items found in a container are remembered, so repeated lookups don't walk up through the groups and layers each time. The
+ remembered items are discarded when metadata is changed through the metadata methods of the object or one of its containers,
+ or when the object or a container moves to a new container. Code that changes the dictionary returned by -metadata directly
+ must call -metadataDidChangeKey: afterwards for inheriting objects to see the change.
+ */
 - (nullable DKMetadataItem*)metadataItemForKey:(NSString*)key;
 - (nullable DKMetadataItem*)metadataItemForKey:(NSString*)key limitToLocalSearch:(BOOL)local;
 
@@ -87,6 +94,12 @@ typedef NS_ENUM(NSInteger, DKMetadataSchema) {
 - (void)metadataWillChangeKey:(nullable NSString*)key;
 - (void)metadataDidChangeKey:(nullable NSString*)key;
 
+/** @brief Discard the metadata items the object, and any object it contains, has remembered from its containers.
+
+ Called when metadata changes or the object moves; there's rarely any need to call it directly.
+ */
+- (void)invalidateInheritedMetadata;
+
 @end
 
 /** deprecated methods - avoid using anonymous objects with metadata - wrap values in DKMetadataItem objects and use
@@ -15,6 +15,15 @@ NSString* const kDKMetadataDidChangeNotification = @"kDKMetadataDidChangeNotific
 NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUndoable";
 
 #define USE_107_OR_LATER_SCHEMA 1
+#define kDKInheritedMetadataCacheLimit 32
+
+@interface DKDrawableObject (MetadataPrivate)
+
+- (nullable DKMetadataItem*)inheritedMetadataItemForKey:(NSString*)key;
+
+@end
+
+#pragma mark -
 
 @implementation DKDrawableObject (Metadata)
 #pragma mark As a DKDrawableObject
@@ -97,7 +106,7 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 		item = [item copy];
 		[[self metadata] setObject:item
-							forKey:[key lowercaseString]];
+							forKey:DKMetadataKey(key)];
 
 		[self notifyVisualChange];
 		[self metadataDidChangeKey:key];
@@ -112,14 +121,45 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 - (DKMetadataItem*)metadataItemForKey:(NSString*)key limitToLocalSearch:(BOOL)local
 {
-	DKMetadataItem* item = [[self metadata] objectForKey:[key lowercaseString]];
+	key = DKMetadataKey(key);
+
+	DKMetadataItem* item = [[self metadata] objectForKey:key];
 
 	if (item == nil && !local && ([self container] != (id)self))
-		item = [[self container] metadataItemForKey:key];
+		item = [self inheritedMetadataItemForKey:key];
 
 	return item;
 }
 
+- (DKMetadataItem*)inheritedMetadataItemForKey:(NSString*)key
+{
+	// finding an inherited item means walking up through the groups and layers to the drawing, so the answer is remembered until
+	// the metadata of this object or one of its containers changes, or one of them moves. The cache is only used on the main
+	// thread, where all such changes are made; other threads always walk.
+
+	if (![NSThread isMainThread])
+		return [[self container] metadataItemForKey:key];
+
+	id item = [mInheritedMetadata objectForKey:key];
+
+	if (item == nil) {
+		item = [[self container] metadataItemForKey:key];
+
+		// most lookups are for a handful of keys. Looking up many different keys, most of which are absent, would otherwise fill
+		// the cache with NSNull, so it is started again once it holds more than a few.
+
+		if (mInheritedMetadata == nil)
+			mInheritedMetadata = [[NSMutableDictionary alloc] init];
+		else if ([mInheritedMetadata count] >= kDKInheritedMetadataCacheLimit)
+			[mInheritedMetadata removeAllObjects];
+
+		[mInheritedMetadata setObject:item ? item : [NSNull null]
+							   forKey:key];
+	}
+
+	return (item == [NSNull null]) ? nil : item;
+}
+
 - (NSArray*)metadataItemsForKeysInArray:(NSArray*)keyArray
 {
 	// returns an array of metadata items for the keys listed in <keyArray>. The returned order matches that of the keyArray, and is a local search only.
@@ -208,7 +248,7 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 		// if the key already exists, enforce the data type of the value. This allows this method to
 		// be connected to a table view for editing without changing any edited value into a string.
 
-		id oldValue = [[self metadata] objectForKey:[key lowercaseString]];
+		id oldValue = [[self metadata] objectForKey:DKMetadataKey(key)];
 
 		// optionally make the change undoable
 
@@ -268,7 +308,7 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 		[self metadataWillChangeKey:key];
 		[[self metadata] setObject:obj
-							forKey:[key lowercaseString]];
+							forKey:DKMetadataKey(key)];
 		[self notifyVisualChange];
 		[self metadataDidChangeKey:key];
 	}
@@ -286,7 +326,7 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 	// at which point the search gives up and returns nil.
 
 	@try {
-		if ([key length] > 1 && [[key substringWithRange:NSMakeRange(0, 1)] isEqualToString:@"$"]) {
+		if ([key length] > 1 && [key characterAtIndex:0] == '$') {
 			NSString* keyPath = [key substringFromIndex:1];
 			return [self valueForKeyPath:keyPath];
 		}
@@ -305,7 +345,7 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 #else
 
-	id object = [[self metadata] objectForKey:[key lowercaseString]];
+	id object = [[self metadata] objectForKey:DKMetadataKey(key)];
 
 	// search upwards through the containment hierarchy for the data. If it is anywhere between here and the root drawing, it will be found.
 	// normally the container can't legally be self, but this prevents a infinite recursion bug if it is wrongly set.
@@ -351,7 +391,7 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 #endif
 
 	[self metadataWillChangeKey:key];
-	[[self metadata] removeObjectForKey:[key lowercaseString]];
+	[[self metadata] removeObjectForKey:DKMetadataKey(key)];
 	[self metadataDidChangeKey:key];
 }
 
@@ -603,7 +643,7 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 {
 	NSDictionary* userInfo = nil;
 	if (key)
-		userInfo = @{ @"key": [key lowercaseString] };
+		userInfo = @{ @"key": DKMetadataKey(key) };
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKMetadataWillChangeNotification
 														object:self
 													  userInfo:userInfo];
@@ -611,14 +651,21 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 - (void)metadataDidChangeKey:(NSString*)key
 {
+	[self invalidateInheritedMetadata];
+
 	NSDictionary* userInfo = nil;
 	if (key)
-		userInfo = @{ @"key": [key lowercaseString] };
+		userInfo = @{ @"key": DKMetadataKey(key) };
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKMetadataDidChangeNotification
 														object:self
 													  userInfo:userInfo];
 }
 
+- (void)invalidateInheritedMetadata
+{
+	mInheritedMetadata = nil;
+}
+
 @end
 
 #pragma mark -
@@ -50,6 +50,7 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL mGhosted; // YES if object is drawn ghosted
 	BOOL mIsHitTesting; // YES when drawContent is called for the purposes of hit-testing
 	NSMutableDictionary* mRenderingCache; // a dictionary to support general caching by renderers
+	NSMutableDictionary* mInheritedMetadata; // metadata items found in containers, keyed by metadata key (NSNull if there is none)
 @protected
 	BOOL m_showBBox : 1; // debugging - display the object's bounding box
 	BOOL m_clipToBBox : 1; // debugging - force clip region to the bbox
@@ -397,6 +398,12 @@ NS_ASSUME_NONNULL_BEGIN
  there may be problems when layer contents are cached.
  */
 - (void)notifyVisualChange;
+/** @brief Request a redraw of this object's selection highlight
+
+ Marks the object's bounds as needing updating without discarding its rendering cache, as selecting or deselecting an object changes
+ only the highlight drawn over its content. The layer calls this when the object's selection state changes.
+ */
+- (void)notifySelectionChange;
 /** @brief Notify the drawing and its controllers that a non-visual status change occurred
 
  The drawing passes this back to any controllers it has
@@ -1042,7 +1049,8 @@ NS_ASSUME_NONNULL_BEGIN
 
  The rendering cache is simply emptied. The contents of the cache are generally set by individual
  renderers to speed up drawing, and are not known to this object. The cache is invalidated by any
- change that alters the object's appearance - size, position, angle, style, etc.
+ change that alters the object's appearance - size, position, angle, style, etc. - and so by
+ \c -notifyVisualChange. The caches of any groups containing the object are invalidated too.
  */
 - (void)invalidateRenderingCache;
 
@@ -1054,6 +1062,43 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly, strong) NSImage* cachedImage;
 
+/** @brief Record the object's unselected content into a new display list.
+
+ The display list is a single page PDF of the object's bounds at <code>scale</code>, holding the paths, paints and clips the object's
+ style produces, recorded as if drawing to the screen at that scale. No view is current while it is recorded, so renderers that cull to
+ the view being updated draw everything within the bounds. Recording draws through AppKit, so must be done on the thread that is
+ drawing. Returns nil if the object can't be recorded.
+ @param scale the number of device pixels in a unit of the drawing where the list will be replayed
+ @return the display list data
+ */
+- (nullable NSData*)recordDisplayListAtScale:(CGFloat)scale;
+
+/** @brief Whether the object's content may be recorded into a display list and replayed in place of normal drawing.
+
+ Default is YES. Objects whose appearance depends on the view they are drawn in, or which are expensive to hold as PDF, should
+ return NO and are drawn directly.
+ */
+@property (readonly) BOOL canRecordDisplayList;
+
+/** @brief Keep a recorded display list in the rendering cache, to be replayed by <code>-drawContentFromDisplayListAtScale:</code>.
+
+ The list is discarded along with the rest of the rendering cache when the object's appearance changes. The cache is made if the
+ object doesn't have one yet.
+ @param data data returned by \c -recordDisplayListAtScale:
+ @param scale the scale it was recorded at
+ */
+- (void)setDisplayList:(NSData*)data scale:(CGFloat)scale;
+
+/** @brief Whether a display list recorded at \c scale is cached for the object.
+ */
+- (BOOL)hasDisplayListAtScale:(CGFloat)scale;
+
+/** @brief Draw the object's unselected content by replaying its cached display list.
+ @param scale the number of device pixels in a unit of the drawing in the current context
+ @return YES if there was a display list recorded at that scale to draw, NO if the object must be drawn normally
+ */
+- (BOOL)drawContentFromDisplayListAtScale:(CGFloat)scale;
+
 /** @}
  @name Pasteboard
  @{ */
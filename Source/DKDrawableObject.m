@@ -10,11 +10,14 @@
 #import "DKDrawableContainerProtocol.h"
 #import "DKDrawableObject+Metadata.h"
 #import "DKDrawing.h"
+#import "DKDrawingView.h"
 #import "DKGeometryUtilities.h"
+#import "DKGuideLayer.h"
 #import "DKKnob.h"
 #import "DKObjectDrawingLayer+Alignment.h"
 #import "DKObjectDrawingLayer.h"
 #import "DKPasteboardInfo.h"
+#import "DKProxyGraphicsContext.h"
 #import "DKSelectionPDFView.h"
 #import "DKStyle.h"
 #import "LogEvent.h"
@@ -24,7 +27,6 @@
 #import "NSDictionary+DeepCopy.h"
 
 #ifdef qIncludeGraphicDebugging
-#import "DKDrawingView.h"
 #include <tgmath.h>
 #endif
 
@@ -43,12 +45,37 @@ NSString* const kDKGhostColourPreferencesKey = @"kDKGhostColourPreferencesKey";
 NSString* const kDKDragFeedbackEnabledPreferencesKey = @"kDKDragFeedbackEnabledPreferencesKey";
 
 NSString* const kDKDrawableCachedImageKey = @"DKD_Cached_Img";
+NSString* const kDKDrawableDisplayListKey = @"DKD_Display_List";
 
 #pragma mark Static vars
 
 static NSColor* s_ghostColour = nil;
 static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
+/** @brief A recorded display list, with the bounds and device scale it was recorded at.
+ */
+@interface DKDisplayList : NSObject {
+@public
+	CGPDFDocumentRef mDocument;
+	NSRect mBounds;
+	CGFloat mScale;
+}
+@end
+
+@implementation DKDisplayList
+
+- (void)dealloc
+{
+	CGPDFDocumentRelease(mDocument);
+}
+
+@end
+
+static BOOL displayListMatchesScale(DKDisplayList* list, CGFloat scale)
+{
+	return list != nil && fabs(list->mScale - scale) <= list->mScale * 0.001;
+}
+
 #pragma mark -
 @implementation DKDrawableObject
 #pragma mark As a DKDrawableObject
@@ -227,6 +254,10 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 		mContainerRef = aContainer;
 
+		// metadata this object inherits, and anything contained in it inherits, now comes from somewhere else
+
+		[self invalidateInheritedMetadata];
+
 		// make sure any attached style is aware of the undo manager used by the drawing/layers
 
 		if (aContainer)
@@ -493,6 +524,15 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 }
 
 - (void)notifyVisualChange
+{
+	[self invalidateRenderingCache];
+
+	if ([self layer])
+		[[self layer] drawable:self
+			needsDisplayInRect:[self bounds]];
+}
+
+- (void)notifySelectionChange
 {
 	if ([self layer])
 		[[self layer] drawable:self
@@ -510,6 +550,8 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 		[self invalidateRenderingCache];
 		[[self storage] object:self
 			didChangeBoundsFrom:oldBounds];
+		[[self layer] drawable:self
+			didChangeBoundsFrom:oldBounds];
 		[self updateRulerMarkers];
 	}
 }
@@ -834,6 +876,13 @@ static NSRect s_oldBounds;
 - (void)invalidateRenderingCache
 {
 	[mRenderingCache removeAllObjects];
+
+	// anything cached by a containing group includes this object's appearance, so is also stale
+
+	id container = [self container];
+
+	if ([container isKindOfClass:[DKDrawableObject class]])
+		[(DKDrawableObject*)container invalidateRenderingCache];
 }
 
 - (NSImage*)cachedImage
@@ -849,6 +898,106 @@ static NSRect s_oldBounds;
 	return img;
 }
 
+- (NSData*)recordDisplayListAtScale:(CGFloat)scale
+{
+	NSRect bounds = [self bounds];
+
+	if (NSIsEmptyRect(bounds) || scale <= 0 || ![self canRecordDisplayList])
+		return nil;
+
+	NSMutableData* data = [NSMutableData data];
+	CGDataConsumerRef consumer = CGDataConsumerCreateWithCFData((__bridge CFMutableDataRef)data);
+	CGRect mediaBox = CGRectMake(0, 0, NSWidth(bounds) * scale, NSHeight(bounds) * scale);
+	CGContextRef pdf = CGPDFContextCreate(consumer, &mediaBox, NULL);
+
+	CGDataConsumerRelease(consumer);
+
+	if (pdf == NULL)
+		return nil;
+
+	// the page holds the bounds at the device scale the list will be replayed at, flipped to match the view, so that anything
+	// depending on the scale comes out as it would on screen. No view is current, so nothing is culled to the view's update
+	// rects; the only clip is the page, which is the whole of the bounds.
+
+	CGPDFContextBeginPage(pdf, NULL);
+	CGContextTranslateCTM(pdf, 0, mediaBox.size.height);
+	CGContextScaleCTM(pdf, scale, -scale);
+	CGContextTranslateCTM(pdf, -NSMinX(bounds), -NSMinY(bounds));
+
+	NSGraphicsContext* context = [[DKProxyGraphicsContext alloc] initWithCGContext:pdf
+																 drawingToScreen:YES];
+
+	SAVE_GRAPHICS_CONTEXT
+		[NSGraphicsContext setCurrentContext:context];
+	[DKDrawingView pushNoView];
+
+	@try {
+		[self drawContentWithSelectedState:NO];
+	}
+	@finally {
+		[DKDrawingView pop];
+	}
+	RESTORE_GRAPHICS_CONTEXT
+
+	CGPDFContextEndPage(pdf);
+	CGPDFContextClose(pdf);
+	CGContextRelease(pdf);
+
+	return data;
+}
+
+- (BOOL)canRecordDisplayList
+{
+	return YES;
+}
+
+- (void)setDisplayList:(NSData*)data scale:(CGFloat)scale
+{
+	CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)data);
+	CGPDFDocumentRef doc = CGPDFDocumentCreateWithProvider(provider);
+
+	CGDataProviderRelease(provider);
+
+	if (doc) {
+		DKDisplayList* list = [[DKDisplayList alloc] init];
+
+		list->mDocument = doc;
+		list->mBounds = [self bounds];
+		list->mScale = scale;
+
+		// -renderingCache makes the cache if the object doesn't have one yet
+
+		[[self renderingCache] setObject:list
+								  forKey:kDKDrawableDisplayListKey];
+	}
+}
+
+- (BOOL)hasDisplayListAtScale:(CGFloat)scale
+{
+	return displayListMatchesScale([mRenderingCache objectForKey:kDKDrawableDisplayListKey], scale);
+}
+
+- (BOOL)drawContentFromDisplayListAtScale:(CGFloat)scale
+{
+	DKDisplayList* list = [mRenderingCache objectForKey:kDKDrawableDisplayListKey];
+
+	// a list recorded at another scale may have greeked text, culled motifs or hairlines that are wrong at this one
+
+	if (!displayListMatchesScale(list, scale))
+		return NO;
+
+	CGPDFPageRef page = CGPDFDocumentGetPage(list->mDocument, 1);
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+
+	CGContextSaveGState(context);
+	CGContextTranslateCTM(context, NSMinX(list->mBounds), NSMaxY(list->mBounds));
+	CGContextScaleCTM(context, 1.0 / list->mScale, -1.0 / list->mScale);
+	CGContextDrawPDFPage(context, page);
+	CGContextRestoreGState(context);
+
+	return YES;
+}
+
 #pragma mark -
 
 - (void)setOffset:(NSSize)offs
@@ -960,6 +1109,21 @@ static NSRect s_oldBounds;
 
 		NSSize snapOff = [[self drawing] snapPointsToGuide:[self snappingPointsWithOffset:offs]];
 
+		// where no guide was close enough, try aligning with the edges and centres of the other objects in the layer
+
+		if ((snapOff.width == 0 || snapOff.height == 0) && !snapControl && [[self layer] allowsSnapToObjects] && [[self layer] snapsToSmartGuides]) {
+			NSRect r = NSOffsetRect([self logicalBounds], offs.width + snapOff.width, offs.height + snapOff.height);
+			NSSize smartOff = [[self layer] smartGuideOffsetForRect:r
+												   excludingObjects:@[self]
+														  tolerance:[DKGuideLayer defaultSnapTolerance]];
+
+			if (snapOff.width == 0)
+				snapOff.width = smartOff.width;
+
+			if (snapOff.height == 0)
+				snapOff.height = smartOff.height;
+		}
+
 		mp.x += snapOff.width;
 		mp.y += snapOff.height;
 	}
@@ -1283,6 +1447,7 @@ static NSRect s_oldBounds;
 		mUserInfo = [[NSMutableDictionary alloc] init];
 
 	[mUserInfo setDictionary:info];
+	[self invalidateInheritedMetadata];
 	[self notifyStatusChange];
 }
 
@@ -1294,6 +1459,7 @@ static NSRect s_oldBounds;
 	NSDictionary* deepCopy = [info deepCopy];
 
 	[mUserInfo addEntriesFromDictionary:deepCopy];
+	[self invalidateInheritedMetadata];
 	[self notifyStatusChange];
 }
 
@@ -1317,6 +1483,7 @@ static NSRect s_oldBounds;
 
 	[mUserInfo setObject:obj
 				  forKey:key];
+	[self invalidateInheritedMetadata];
 	[self notifyStatusChange];
 }
 
@@ -1727,6 +1894,11 @@ static NSRect s_oldBounds;
 
 - (NSMutableDictionary*)renderingCache
 {
+	// made on first use, as most objects are never asked for it
+
+	if (mRenderingCache == nil)
+		mRenderingCache = [[NSMutableDictionary alloc] init];
+
 	return mRenderingCache;
 }
 
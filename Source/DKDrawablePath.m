@@ -217,103 +217,58 @@ static NSColor* sInfoWindowColour = nil;
  @param knobs the knobs object that draws the handles on the path */
 - (void)drawControlPointsOfPath:(NSBezierPath*)path usingKnobs:(DKKnob*)knobs
 {
-	// draws the control points of the entire path using the knobs supplied.
+	// draws the control points of the entire path using the knobs supplied. The control bars are drawn as the path is walked,
+	// but the knobs are collected and drawn afterwards as two batches, so that all of them are drawn over the bars. If the
+	// on-path point priority is set, on-path points are drawn on top, otherwise off-path points are drawn on top.
 
 	NSBezierPathElement et;
 	NSPoint ap[3];
 	NSPoint lp;
-	DKKnobType knobType;
+	DKKnobType onPathType = kDKOnPathKnobType;
+
+	if ([self locked])
+		onPathType |= kDKKnobIsDisabledFlag;
 
 	NSInteger i, ec = [path elementCount];
 	lp = NSMakePoint(-1, -1);
 
+	// each element contributes at most two on-path and two off-path points
+
+	NSPoint* onPathPoints = malloc(2 * MAX(ec, 1) * sizeof(NSPoint));
+	NSPoint* offPathPoints = malloc(2 * MAX(ec, 1) * sizeof(NSPoint));
+	NSUInteger onPathCount = 0, offPathCount = 0;
+	BOOL onPathInFront = [[self class] defaultOnPathHitDetectionPriority];
+
 	for (i = 0; i < ec; ++i) {
 		et = [path elementAtIndex:i
 				 associatedPoints:ap];
 
 		if (et == NSCurveToBezierPathElement) {
-			// three points to draw, plus some bars. If the on-path point priority is set, draw on-path points on top,
-			// otherwise draw off-path points on top.
-
-			// draw the bar - always behind the knobs whatever the priority
+			// three points to draw, plus some bars
 
 			if (![self locked])
 				[knobs drawControlBarFromPoint:ap[1]
 									   toPoint:ap[2]];
 
-			// draw on-path point behind
+			if (!NSEqualPoints(lp, NSMakePoint(-1, -1))) {
+				if (![self locked])
+					[knobs drawControlBarFromPoint:ap[0]
+										   toPoint:lp];
 
-			if (![[self class] defaultOnPathHitDetectionPriority]) {
-				knobType = kDKOnPathKnobType;
-
-				if (!NSEqualPoints(lp, NSMakePoint(-1, -1))) {
-					if ([self locked])
-						knobType |= kDKKnobIsDisabledFlag;
-					else
-						[knobs drawControlBarFromPoint:ap[0]
-											   toPoint:lp];
-
-					[knobs drawKnobAtPoint:lp
-									ofType:knobType
-								  userInfo:nil];
-
-					if (i == ec - 1)
-						[knobs drawKnobAtPoint:ap[2]
-										ofType:knobType
-									  userInfo:nil];
-				}
+				onPathPoints[onPathCount++] = lp;
 			}
 
-			// draw off-path points for unlocked paths
+			if (i == ec - 1 && (onPathInFront || !NSEqualPoints(lp, NSMakePoint(-1, -1))))
+				onPathPoints[onPathCount++] = ap[2];
 
-			knobType = kDKControlPointKnobType;
+			// off-path points are only drawn for unlocked paths
 
 			if (![self locked]) {
-				[knobs drawKnobAtPoint:ap[0]
-								ofType:knobType
-							  userInfo:nil];
-				[knobs drawKnobAtPoint:ap[1]
-								ofType:knobType
-							  userInfo:nil];
-			}
-
-			knobType = kDKOnPathKnobType;
-			if ([self locked])
-				knobType |= kDKKnobIsDisabledFlag;
-
-			// draw on-path point in front
-
-			if ([[self class] defaultOnPathHitDetectionPriority]) {
-				if (!NSEqualPoints(lp, NSMakePoint(-1, -1))) {
-					if (![self locked])
-						[knobs drawControlBarFromPoint:ap[0]
-											   toPoint:lp];
-
-					[knobs drawKnobAtPoint:lp
-									ofType:knobType
-								  userInfo:nil];
-				}
-
-				if (i == ec - 1)
-					[knobs drawKnobAtPoint:ap[2]
-									ofType:knobType
-								  userInfo:nil];
+				offPathPoints[offPathCount++] = ap[0];
+				offPathPoints[offPathCount++] = ap[1];
 			}
 
 			lp = ap[2];
-
-#ifdef qIncludeGraphicDebugging
-			if (m_showPartcodes) {
-				NSInteger j, pc;
-
-				for (j = 0; j < 3; ++j) {
-					pc = [self hitPart:ap[j]];
-					[knobs drawPartcode:pc
-								atPoint:ap[j]
-							   fontSize:10];
-				}
-			}
-#endif
 		} else {
 			// one point to draw. don't draw a moveto that is the last element
 
@@ -322,33 +277,55 @@ static NSColor* sInfoWindowColour = nil;
 			drawit = !((et == NSMoveToBezierPathElement) && (i == (ec - 1)));
 
 			if (drawit) {
-				knobType = kDKOnPathKnobType;
-				if ([self locked])
-					knobType |= kDKKnobIsDisabledFlag;
-
 				if (!NSEqualPoints(lp, NSMakePoint(-1, -1)))
-					[knobs drawKnobAtPoint:lp
-									ofType:knobType
-								  userInfo:nil];
+					onPathPoints[onPathCount++] = lp;
 
-				[knobs drawKnobAtPoint:ap[0]
-								ofType:knobType
-							  userInfo:nil];
+				onPathPoints[onPathCount++] = ap[0];
 			}
 			lp = ap[0];
+		}
+	}
+
+	if (onPathInFront) {
+		[knobs drawKnobsAtPoints:offPathPoints
+						   count:offPathCount
+						  ofType:kDKControlPointKnobType
+						   angle:0.0];
+		[knobs drawKnobsAtPoints:onPathPoints
+						   count:onPathCount
+						  ofType:onPathType
+						   angle:0.0];
+	} else {
+		[knobs drawKnobsAtPoints:onPathPoints
+						   count:onPathCount
+						  ofType:onPathType
+						   angle:0.0];
+		[knobs drawKnobsAtPoints:offPathPoints
+						   count:offPathCount
+						  ofType:kDKControlPointKnobType
+						   angle:0.0];
+	}
+
+	free(onPathPoints);
+	free(offPathPoints);
 
 #ifdef qIncludeGraphicDebugging
-			if (m_showPartcodes) {
-				NSInteger pc;
+	if (m_showPartcodes) {
+		for (i = 0; i < ec; ++i) {
+			et = [path elementAtIndex:i
+					 associatedPoints:ap];
 
-				pc = [self hitPart:ap[0]];
+			NSInteger j, pc, np = (et == NSCurveToBezierPathElement) ? 3 : 1;
+
+			for (j = 0; j < np; ++j) {
+				pc = [self hitPart:ap[j]];
 				[knobs drawPartcode:pc
-							atPoint:ap[0]
+							atPoint:ap[j]
 						   fontSize:10];
 			}
-#endif
 		}
 	}
+#endif
 }
 
 /** @brief Given a set of rects as NSValue objects, this invalidates them
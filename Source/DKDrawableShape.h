@@ -215,6 +215,9 @@ typedef NS_ENUM(NSInteger, DKShapeTransformOperation) {
 
  When getting, the path is transformed only by any active distortion transform, but not by the shape's
  overall scale, position or rotation.
+
+ The path set is interned in the shared DKGeometryTable, so every shape with the same geometry holds the same path. The path
+ returned may therefore be shared with other shapes and must not be changed - copy it, change the copy and set that instead.
  */
 @property (strong) NSBezierPath* path;
 
@@ -10,6 +10,7 @@
 #import "DKDrawablePath.h"
 #import "DKDrawableShape+Hotspots.h"
 #import "DKDrawing.h"
+#import "DKGeometryTable.h"
 #import "DKGeometryUtilities.h"
 #import "DKGridLayer.h"
 #import "DKKnob.h"
@@ -281,8 +282,7 @@ static NSSize sTempSavedOffset;
 {
 	self = [self initWithStyle:aStyle];
 	if (self != nil) {
-		[[self path] removeAllPoints];
-		[[self path] appendBezierPathWithOvalInRect:[[self class] unitRectAtOrigin]];
+		[self setPath:[NSBezierPath bezierPathWithOvalInRect:[[self class] unitRectAtOrigin]]];
 
 		NSPoint cp;
 		cp.x = NSMidX(aRect);
@@ -382,7 +382,10 @@ static NSSize sTempSavedOffset;
 									  selector:@selector(setPath:)
 										object:m_path];
 
-	m_path = path;
+	// shapes with the same geometry share one path. The shared path is never changed, so a later change to <path> by the caller
+	// doesn't affect this shape
+
+	m_path = [[DKGeometryTable sharedGeometryTable] internedPath:path];
 	[self notifyVisualChange];
 	[self notifyGeometryChange:oldBounds];
 }
@@ -1559,7 +1562,7 @@ static NSSize sTempSavedOffset;
 {
 	self = [super initWithStyle:aStyle];
 	if (self != nil) {
-		m_path = [NSBezierPath bezierPathWithRect:[[self class] unitRectAtOrigin]];
+		m_path = [[DKGeometryTable sharedGeometryTable] internedPath:[NSBezierPath bezierPathWithRect:[[self class] unitRectAtOrigin]]];
 
 		if (m_path == nil) {
 			return nil;
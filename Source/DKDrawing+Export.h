@@ -15,9 +15,9 @@ This category provides methods for exporting drawings in a variety of formats, s
 a way to specify the resolution of the exported image is also provided. All methods return NSData that is the formatted image data - this can be
 written directly as a file of the designated kind.
 
-All image export starts with the pdf representation of the drawing as exported directly by DKDrawing. This is then imaged into a new bitmap image
-rep before conversion to the final format. The use of the pdf data ensures that results are consistent and require no major knowledge of the
-drawing's internals.
+All image export draws the drawing through a private PDF view, exactly as it would be drawn for printing. The format-specific methods render the
+image in horizontal bands as the encoder consumes it, so that large, high resolution exports do not need a bitmap of the whole image in memory.
+This ensures that results are consistent and require no major knowledge of the drawing's internals.
 
 All images are exported in 24/32 bit full colour.
 
@@ -51,6 +51,41 @@ This uses Image I/O to perform the data encoding.
  */
 - (nullable CGImageRef)CGImageWithResolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale CF_RETURNS_NOT_RETAINED;
 
+// banded export:
+
+/** @brief Returns image data of the given type for the drawing, rendering and encoding it in horizontal bands.
+
+ The bitmap for the whole image is never created - each band is rendered into a reused band-sized bitmap as Image I/O asks for
+ its rows, and only the objects intersecting that band are drawn. Peak memory is therefore governed by the band size rather than
+ the output size. The format-specific methods below all use this.
+ @param type the uniform type identifier of the image format, e.g. \c kUTTypePNG
+ @param dpi the resolution of the image in dots per inch.
+ @param hasAlpha specifies whether the image is painted in the background paper colour or not.
+ @param relScale scaling factor, 1.0 = actual size, 0.5 = half size, etc.
+ @param options Image I/O properties for the image
+ @return the image data, or nil if there was a problem
+ */
+- (nullable NSData*)imageDataOfType:(NSString*)type resolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale properties:(nullable NSDictionary<NSString*, id>*)options;
+
+/** @brief Whether rendered export bands are kept between exports.
+
+ If YES, the pixels of every band are kept after an export, and the next export at the same resolution, scale and alpha setting renders
+ again only the bands touched by changes to the drawing since. This is useful when the same drawing is exported repeatedly, but holds the
+ whole image in memory between exports. Default is NO.
+ */
+@property BOOL retainsExportBands;
+
+/** @brief Mark the retained export bands covering \c rect as needing to be rendered again.
+
+ The drawing calls this whenever part of it needs redrawing, so it isn't normally called directly. Does nothing unless
+ \c retainsExportBands is YES.
+ */
+- (void)invalidateExportBandsInRect:(NSRect)rect;
+
+/** @brief Mark every retained export band as needing to be rendered again.
+ */
+- (void)invalidateAllExportBands;
+
 // convert to various formats:
 
 /** @brief Returns JPEG data for the drawing.
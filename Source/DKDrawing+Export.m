@@ -6,113 +6,341 @@
 
 #import "DKDrawing+Export.h"
 #import "DKLayer+Metadata.h"
+#import "DKProxyGraphicsContext.h"
 #import "DKSelectionPDFView.h"
+#import "DKViewController.h"
 #import "LogEvent.h"
 
 NSString* const kDKExportPropertiesResolution = @"kDKExportPropertiesResolution";
 NSString* const kDKExportedImageHasAlpha = @"kDKExportedImageHasAlpha";
 NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale";
 
-@interface DKGraphicsContextNoPrint : NSGraphicsContext
+// approximate size of the bitmap each band is rendered into. Peak memory use of a banded export is governed by this, not the image size.
+
+#define DK_EXPORT_BAND_BYTES (4 * 1024 * 1024)
+
+#pragma mark -
+
+/** @brief Renders a layer (usually the whole drawing) in horizontal bands on demand.
+
+ The renderer supplies a CGImage whose pixel data comes from a sequential data provider. Image I/O pulls rows from it as it encodes, and
+ each band is rendered only when its first row is requested, into a band-sized bitmap that is reused for every band. Only the parts of the
+ layer that intersect a band are drawn for that band.
+
+ If \c retainsBands is YES, the rendered pixels of each band are kept after the export, and a later export renders again only those bands
+ that the drawing has invalidated in the meantime. This trades memory (the full image) for speed when the same drawing is exported repeatedly.
+ */
+@interface DKExportBandRenderer : NSObject {
+	DKLayer* __weak mLayerRef;
+	DKLayerPDFView* mPDFView;
+	DKViewController* mViewController; // attaches the view to the drawing while an export is encoded
+	NSInteger mDPI;
+	CGFloat mScale;
+	BOOL mHasAlpha;
+	BOOL mRetainsBands;
+	size_t mWidth;
+	size_t mHeight;
+	size_t mBandHeight;
+	size_t mBytesPerRow;
+	CGContextRef mBandContext;
+	NSInteger mRenderedBand; // the band currently in mBandContext, or -1
+	size_t mPosition; // read position of the data provider
+	NSMutableDictionary<NSNumber*, NSData*>* mBands;
+	NSMutableIndexSet* mDirtyBands;
+}
+
+- (instancetype)initWithLayer:(DKLayer*)aLayer;
+
+/** @brief Set the output parameters. If they differ from the last export, any retained bands are discarded.
+ */
+- (void)setResolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale;
+
+/** @brief Return a new image whose pixels are rendered on demand by the receiver.
+ */
+- (CGImageRef)newBandedImage CF_RETURNS_RETAINED;
+
+- (void)invalidateRect:(NSRect)rect;
+- (void)invalidateAll;
+
+/** @brief Attach the renderer's view to the drawing for the duration of an export, as any view that draws it must be.
+ */
+- (void)beginExport;
+- (void)endExport;
+
+@property BOOL retainsBands;
+
+- (size_t)copyBytes:(void*)buffer count:(size_t)count;
+- (off_t)skipBytes:(off_t)count;
+- (void)rewind;
 
-- (instancetype)initWithCGContext:(CGContextRef)ctx;
 @end
 
-@implementation DKGraphicsContextNoPrint {
-	NSGraphicsContext* actualContext;
+static size_t bandProviderGetBytes(void* info, void* buffer, size_t count)
+{
+	return [(__bridge DKExportBandRenderer*)info copyBytes:buffer
+													 count:count];
 }
 
-//The whole point of this class...
-- (BOOL)isDrawingToScreen
+static off_t bandProviderSkipForward(void* info, off_t count)
 {
-	return NO;
+	return [(__bridge DKExportBandRenderer*)info skipBytes:count];
 }
 
-- (instancetype)initWithCGContext:(CGContextRef)ctx
+static void bandProviderRewind(void* info)
 {
-	if (self = [super init]) {
-		actualContext = [NSGraphicsContext graphicsContextWithGraphicsPort:ctx flipped:YES];
-		[actualContext setShouldAntialias:YES];
-		[actualContext setImageInterpolation:NSImageInterpolationHigh];
+	[(__bridge DKExportBandRenderer*)info rewind];
+}
+
+static void bandProviderRelease(void* info)
+{
+	CFBridgingRelease(info);
+}
+
+@implementation DKExportBandRenderer
+
+- (instancetype)initWithLayer:(DKLayer*)aLayer
+{
+	NSAssert(aLayer != nil, @"can't render a nil layer");
+
+	self = [super init];
+	if (self != nil) {
+		mLayerRef = aLayer;
+		mRenderedBand = -1;
+		mBands = [[NSMutableDictionary alloc] init];
+		mDirtyBands = [[NSMutableIndexSet alloc] init];
+
+		NSRect frame = NSZeroRect;
+		frame.size = [[aLayer drawing] drawingSize];
+
+		mPDFView = [[DKLayerPDFView alloc] initWithFrame:frame
+											   withLayer:aLayer];
 	}
+
 	return self;
 }
 
-- (void)forwardInvocation:(NSInvocation*)invocation
+- (void)dealloc
 {
-	SEL aSelector = [invocation selector];
+	[self endExport];
 
-	if ([actualContext respondsToSelector:aSelector]) {
-		[invocation invokeWithTarget:actualContext];
-	} else
-		[self doesNotRecognizeSelector:aSelector];
+	if (mBandContext)
+		CGContextRelease(mBandContext);
 }
 
-- (NSMethodSignature*)methodSignatureForSelector:(SEL)aSelector
+- (void)beginExport
 {
-	NSMethodSignature* sig = [super methodSignatureForSelector:aSelector];
+	// the renderer learns of changes to the drawing from the drawing itself, not through this controller, which is attached only
+	// while the encoder is pulling rows
+
+	if (mViewController == nil) {
+		NSRect frame = NSZeroRect;
+		frame.size = [[mLayerRef drawing] drawingSize];
 
-	if (sig == nil) {
-		sig = [actualContext methodSignatureForSelector:aSelector];
+		[mPDFView setFrame:frame];
+		mViewController = [mPDFView makeViewController];
+		[[mLayerRef drawing] addController:mViewController];
 	}
+}
 
-	return sig;
+- (void)endExport
+{
+	if (mViewController) {
+		[[mViewController drawing] removeController:mViewController];
+		mViewController = nil;
+	}
 }
 
-- (BOOL)respondsToSelector:(SEL)aSelector
+- (void)setResolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale
 {
-	BOOL responds = [super respondsToSelector:aSelector];
+	NSAssert(relScale > 0, @"scale factor must be greater than zero");
+
+	NSSize size = [[mLayerRef drawing] drawingSize];
+	size_t width = ceil((size.width * (CGFloat)dpi * relScale) / 72.0);
+	size_t height = ceil((size.height * (CGFloat)dpi * relScale) / 72.0);
+
+	if (dpi != mDPI || relScale != mScale || hasAlpha != mHasAlpha || width != mWidth || height != mHeight) {
+		mDPI = dpi;
+		mScale = relScale;
+		mHasAlpha = hasAlpha;
+		mWidth = MAX(width, 1);
+		mHeight = MAX(height, 1);
+		mBytesPerRow = mWidth * 4;
+		mBandHeight = LIMIT(DK_EXPORT_BAND_BYTES / mBytesPerRow, 1, mHeight);
+
+		if (mBandContext) {
+			CGContextRelease(mBandContext);
+			mBandContext = NULL;
+		}
 
-	if (!responds) {
-		responds = [actualContext respondsToSelector:aSelector];
+		[self invalidateAll];
 	}
+}
+
+- (CGImageRef)newBandedImage
+{
+	NSAssert(mWidth > 0, @"resolution must be set before creating an image");
 
-	return responds;
+	[self rewind];
+
+	CGDataProviderSequentialCallbacks callbacks = { 0, bandProviderGetBytes, bandProviderSkipForward, bandProviderRewind, bandProviderRelease };
+	CGDataProviderRef provider = CGDataProviderCreateSequential((__bridge_retained void*)self, &callbacks);
+	CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+
+	CGImageRef image = CGImageCreate(mWidth, mHeight, 8, 32, mBytesPerRow, clrSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast, provider, NULL, NO, kCGRenderingIntentDefault);
+
+	CGColorSpaceRelease(clrSpace);
+	CGDataProviderRelease(provider);
+
+	return image;
 }
 
-// Otherwise Cocoa complains
-- (void*)graphicsPort
+- (void)invalidateRect:(NSRect)rect
 {
-	return actualContext.graphicsPort;
+	if (mBandHeight == 0)
+		return;
+
+	CGFloat scale = ((CGFloat)mDPI * mScale) / 72.0;
+	NSInteger first = MAX(0, floor(NSMinY(rect) * scale / mBandHeight));
+	NSInteger last = floor(NSMaxY(rect) * scale / mBandHeight);
+
+	if (last >= first) {
+		NSRange range = NSMakeRange(first, last - first + 1);
+
+		[mDirtyBands addIndexesInRange:range];
+
+		if (NSLocationInRange(mRenderedBand, range))
+			mRenderedBand = -1;
+	}
 }
 
-- (void)saveGraphicsState
+- (void)invalidateAll
 {
-	[actualContext saveGraphicsState];
+	[mBands removeAllObjects];
+	[mDirtyBands removeAllIndexes];
+	mRenderedBand = -1;
 }
 
-- (void)restoreGraphicsState
+- (void)setRetainsBands:(BOOL)retain
 {
-	[actualContext restoreGraphicsState];
+	mRetainsBands = retain;
+
+	if (!retain)
+		[mBands removeAllObjects];
 }
 
-- (void)setImageInterpolation:(NSImageInterpolation)imageInterpolation
+@synthesize retainsBands = mRetainsBands;
+
+#pragma mark -
+
+- (void)renderBand:(NSInteger)band
 {
-	actualContext.imageInterpolation = imageInterpolation;
+	if (mBandContext == NULL) {
+		CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+		mBandContext = CGBitmapContextCreate(NULL, mWidth, mBandHeight, 8, mBytesPerRow, clrSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+		CGColorSpaceRelease(clrSpace);
+	}
+
+	CGContextClearRect(mBandContext, CGRectMake(0, 0, mWidth, mBandHeight));
+
+	CGFloat scale = ((CGFloat)mDPI * mScale) / 72.0;
+	NSGraphicsContext* context = [[DKProxyGraphicsContext alloc] initWithCGContext:mBandContext
+													 drawingToScreen:NO];
+
+	SAVE_GRAPHICS_CONTEXT
+		[NSGraphicsContext setCurrentContext:context];
+
+	[context setShouldAntialias:YES];
+	[context setImageInterpolation:NSImageInterpolationHigh];
+
+	if (!mHasAlpha) {
+		[[[mLayerRef drawing] paperColour] set];
+		NSRectFill(NSMakeRect(0, 0, mWidth, mBandHeight));
+	}
+
+	// same as a full image, but shifted up so that this band's rows land in the band bitmap
+
+	NSAffineTransform* flipTrans = [[NSAffineTransform alloc] init];
+	[flipTrans scaleXBy:1
+					yBy:-1];
+	[flipTrans translateXBy:0
+						yBy:-(CGFloat)mBandHeight];
+	[flipTrans translateXBy:0
+						yBy:-(CGFloat)(band * mBandHeight)];
+	[flipTrans scaleXBy:scale
+					yBy:scale];
+	[flipTrans concat];
+
+	NSRect bandRect = NSMakeRect(0, (band * mBandHeight) / scale, mWidth / scale, mBandHeight / scale);
+
+	[mPDFView drawRect:bandRect];
+
+	RESTORE_GRAPHICS_CONTEXT
+
+	mRenderedBand = band;
+	[mDirtyBands removeIndex:band];
+
+	if (mRetainsBands) {
+		[mBands setObject:[NSData dataWithBytes:CGBitmapContextGetData(mBandContext)
+										 length:mBytesPerRow * mBandHeight]
+				   forKey:@(band)];
+	}
 }
 
-- (NSImageInterpolation)imageInterpolation
+- (const UInt8*)bytesForBand:(NSInteger)band
 {
-	return actualContext.imageInterpolation;
+	if (![mDirtyBands containsIndex:band]) {
+		NSData* retained = [mBands objectForKey:@(band)];
+
+		if (retained)
+			return [retained bytes];
+
+		if (band == mRenderedBand)
+			return CGBitmapContextGetData(mBandContext);
+	}
+
+	[self renderBand:band];
+	return CGBitmapContextGetData(mBandContext);
 }
 
-- (void)setShouldAntialias:(BOOL)shouldAntialias
+- (size_t)copyBytes:(void*)buffer count:(size_t)count
 {
-	actualContext.shouldAntialias = shouldAntialias;
+	size_t total = mBytesPerRow * mHeight;
+	size_t bandBytes = mBytesPerRow * mBandHeight;
+	size_t copied = 0;
+
+	while (copied < count && mPosition < total) {
+		NSInteger band = mPosition / bandBytes;
+		size_t offset = mPosition - band * bandBytes;
+		size_t available = MIN(bandBytes, total - band * bandBytes) - offset;
+		size_t n = MIN(count - copied, available);
+
+		memcpy((UInt8*)buffer + copied, [self bytesForBand:band] + offset, n);
+
+		copied += n;
+		mPosition += n;
+	}
+
+	return copied;
 }
 
-- (BOOL)shouldAntialias
+- (off_t)skipBytes:(off_t)count
 {
-	return actualContext.shouldAntialias;
+	size_t total = mBytesPerRow * mHeight;
+	size_t skip = MIN((size_t)count, total - mPosition);
+
+	mPosition += skip;
+	return skip;
 }
 
-- (BOOL)isFlipped
+- (void)rewind
 {
-	return actualContext.flipped;
+	mPosition = 0;
 }
 
 @end
 
+#pragma mark -
+
 @implementation DKDrawing (Export)
 
 /** @brief Creates the initial bitmap image that the various bitmap formats are created from.
@@ -163,7 +391,8 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 
 	LogEvent_(kInfoEvent, @"size = %@, dpi = %ld, ctx = %@", NSStringFromSize(bmSize), (long)dpi, bmCtx);
 
-	NSGraphicsContext* context = [[DKGraphicsContextNoPrint alloc] initWithCGContext:bmCtx];
+	NSGraphicsContext* context = [[DKProxyGraphicsContext alloc] initWithCGContext:bmCtx
+												 drawingToScreen:NO];
 
 	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
 		[NSGraphicsContext setCurrentContext:context];
@@ -198,6 +427,86 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 	return (CGImageRef)CFAutorelease(image);
 }
 
+/** @brief Returns image data of the given type for the drawing, rendering and encoding it in horizontal bands.
+
+ The bitmap for the whole image is never created; peak memory is governed by the band size. If \c retainsExportBands is YES, bands
+ unaffected by changes to the drawing since the last export are not rendered again.
+ @param type the uniform type identifier of the image format, e.g. \c kUTTypePNG
+ @param dpi the resolution of the image in dots per inch.
+ @param hasAlpha specifies whether the image is painted in the background paper colour or not.
+ @param relScale scaling factor, 1.0 = actual size, 0.5 = half size, etc.
+ @param options Image I/O properties for the image
+ @return the image data, or nil if there was a problem
+ */
+- (NSData*)imageDataOfType:(NSString*)type resolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale properties:(NSDictionary*)options
+{
+	[self finalizePriorToSaving];
+
+	DKExportBandRenderer* renderer = mExportBandRenderer;
+
+	if (renderer == nil)
+		renderer = [[DKExportBandRenderer alloc] initWithLayer:self];
+
+	[renderer setResolution:dpi
+				   hasAlpha:hasAlpha
+			  relativeScale:relScale];
+
+	[renderer beginExport];
+
+	CGImageRef image = [renderer newBandedImage];
+
+	NSAssert(image != nil, @"could not create image for export");
+
+	if (image == nil) {
+		[renderer endExport];
+		return nil;
+	}
+
+	LogEvent_(kInfoEvent, @"banded export, type = %@, size = %lu x %lu, dpi = %ld", type, (unsigned long)CGImageGetWidth(image), (unsigned long)CGImageGetHeight(image), (long)dpi);
+
+	NSMutableData* data = [[NSMutableData alloc] init];
+	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((CFMutableDataRef)data, (CFStringRef)type, 1, NULL);
+
+	CGImageDestinationAddImage(destRef, image, (CFDictionaryRef)options);
+
+	BOOL result = CGImageDestinationFinalize(destRef);
+
+	CFRelease(destRef);
+	CGImageRelease(image);
+
+	[renderer endExport];
+
+	if (result) {
+		return [data copy];
+	} else {
+		return nil;
+	}
+}
+
+- (BOOL)retainsExportBands
+{
+	return mExportBandRenderer != nil;
+}
+
+- (void)setRetainsExportBands:(BOOL)retain
+{
+	if (retain && mExportBandRenderer == nil) {
+		mExportBandRenderer = [[DKExportBandRenderer alloc] initWithLayer:self];
+		[mExportBandRenderer setRetainsBands:YES];
+	} else if (!retain && mExportBandRenderer != nil)
+		mExportBandRenderer = nil;
+}
+
+- (void)invalidateExportBandsInRect:(NSRect)rect
+{
+	[(DKExportBandRenderer*)mExportBandRenderer invalidateRect:rect];
+}
+
+- (void)invalidateAllExportBands
+{
+	[(DKExportBandRenderer*)mExportBandRenderer invalidateAll];
+}
+
 /** @brief Returns JPEG data for the drawing.
  @param props various parameters and properties
  @return JPEG data or nil if there was a problem
@@ -239,33 +548,13 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 		[options setObject:@{ (NSString*)kCGImagePropertyJFIFIsProgressive: value }
 					forKey:(NSString*)kCGImagePropertyJFIFDictionary];
 
-	// generate the bitmap image at the required size
-
-	CGImageRef image = [self CGImageWithResolution:dpi
-										  hasAlpha:NO
-									 relativeScale:scale];
-
-	NSAssert(image != nil, @"could not create image for JPEG export");
-
-	if (image == nil)
-		return nil;
-
-	// encode it to data using Image I/O
-
-	NSMutableData* data = [[NSMutableData alloc] init];
-	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((CFMutableDataRef)data, kUTTypeJPEG, 1, NULL);
-
-	CGImageDestinationAddImage(destRef, image, (CFDictionaryRef)options);
-
-	BOOL result = CGImageDestinationFinalize(destRef);
-
-	CFRelease(destRef);
+	// render the image in bands at the required size and encode it to data using Image I/O
 
-	if (result) {
-		return [data copy];
-	} else {
-		return nil;
-	}
+	return [self imageDataOfType:(NSString*)kUTTypeJPEG
+					  resolution:dpi
+						hasAlpha:NO
+				   relativeScale:scale
+					  properties:options];
 }
 
 /** @brief Returns TIFF data for the drawing.
@@ -336,33 +625,13 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 	if (value != nil)
 		hasAlpha = [value boolValue];
 
-	// generate the bitmap image at the required size
-
-	CGImageRef image = [self CGImageWithResolution:dpi
-										  hasAlpha:hasAlpha
-									 relativeScale:scale];
-
-	NSAssert(image != nil, @"could not create image for TIFF export");
-
-	if (image == nil)
-		return nil;
-
-	// encode it to data using Image I/O
-
-	NSMutableData* data = [[NSMutableData alloc] init];
-	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((CFMutableDataRef)data, kUTTypeTIFF, 1, NULL);
-
-	CGImageDestinationAddImage(destRef, image, (CFDictionaryRef)options);
-
-	BOOL result = CGImageDestinationFinalize(destRef);
-
-	CFRelease(destRef);
+	// render the image in bands at the required size and encode it to data using Image I/O
 
-	if (result) {
-		return [data copy];
-	} else {
-		return nil;
-	}
+	return [self imageDataOfType:(NSString*)kUTTypeTIFF
+					  resolution:dpi
+						hasAlpha:hasAlpha
+				   relativeScale:scale
+					  properties:options];
 }
 
 /** @brief Returns PNG data for the drawing.
@@ -405,33 +674,13 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 	if (value != nil)
 		hasAlpha = [value boolValue];
 
-	// generate the bitmap image at the required size
-
-	CGImageRef image = [self CGImageWithResolution:dpi
-										  hasAlpha:hasAlpha
-									 relativeScale:scale];
+	// render the image in bands at the required size and encode it to data using Image I/O
 
-	NSAssert(image != nil, @"could not create image for PNG export");
-
-	if (image == nil)
-		return nil;
-
-	// encode it to data using Image I/O
-
-	NSMutableData* data = [[NSMutableData alloc] init];
-	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((CFMutableDataRef)data, kUTTypePNG, 1, NULL);
-
-	CGImageDestinationAddImage(destRef, image, (CFDictionaryRef)options);
-
-	BOOL result = CGImageDestinationFinalize(destRef);
-
-	CFRelease(destRef);
-
-	if (result) {
-		return [data copy];
-	} else {
-		return nil;
-	}
+	return [self imageDataOfType:(NSString*)kUTTypePNG
+					  resolution:dpi
+						hasAlpha:hasAlpha
+				   relativeScale:scale
+					  properties:options];
 }
 
 #pragma mark -
@@ -531,7 +780,50 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
  */
 - (NSData*)multipartTIFFDataWithResolution:(NSUInteger)dpi
 {
-	return [NSBitmapImageRep TIFFRepresentationOfImageRepsInArray:[self layerBitmapsWithDPI:dpi]];
+	// each layer is rendered in bands as it is encoded, so at most one band per layer is held in memory rather than a bitmap per layer
+
+	NSMutableArray<DKLayer*>* layers = [NSMutableArray array];
+
+	for (DKLayer* layer in [[self flattenedLayers] reverseObjectEnumerator]) {
+		if ([layer visible] && [layer shouldDrawToPrinter])
+			[layers addObject:layer];
+	}
+
+	if ([layers count] == 0)
+		return nil;
+
+	if (dpi == 0)
+		dpi = 72;
+
+	[self finalizePriorToSaving];
+
+	NSDictionary* options = @{ (NSString*)kCGImagePropertyDPIWidth: @(dpi),
+		(NSString*)kCGImagePropertyDPIHeight: @(dpi) };
+	NSMutableData* data = [[NSMutableData alloc] init];
+	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((CFMutableDataRef)data, kUTTypeTIFF, [layers count], NULL);
+	NSMutableArray<DKExportBandRenderer*>* renderers = [NSMutableArray array];
+
+	for (DKLayer* layer in layers) {
+		DKExportBandRenderer* renderer = [[DKExportBandRenderer alloc] initWithLayer:layer];
+
+		[renderer setResolution:dpi
+					   hasAlpha:YES
+				  relativeScale:1.0];
+		[renderer beginExport];
+
+		CGImageRef image = [renderer newBandedImage];
+
+		CGImageDestinationAddImage(destRef, image, (CFDictionaryRef)options);
+		CGImageRelease(image);
+		[renderers addObject:renderer];
+	}
+
+	BOOL result = CGImageDestinationFinalize(destRef);
+
+	CFRelease(destRef);
+	[renderers makeObjectsPerformSelector:@selector(endExport)];
+
+	return result ? [data copy] : nil;
 }
 
 @end
@@ -60,6 +60,7 @@ NS_ASSUME_NONNULL_BEGIN
 	DKImageDataManager* mImageManager; /**< internal object used to substantially improve efficiency of image archiving */
 	id<DKDrawingDelegate> __weak mDelegateRef; /**< delegate, if any */
 	id __weak mOwnerRef; /**< back pointer to document or view that owns this */
+	id mExportBandRenderer; /**< renders bitmap exports in bands, kept between exports if \c retainsExportBands is YES */
 }
 
 /** @brief Return the current version number of the framework
@@ -608,6 +609,15 @@ NS_ASSUME_NONNULL_BEGIN
  Can be overridden or you can make use of the notification
  */
 - (void)finalizePriorToSaving;
+
+/** @brief Whether saved drawing data includes a preview.
+
+ When YES, the default, \c drawingData and \c drawingAsXMLDataForKey: render a DKDrawingPreview and save it in the archive
+ beside the drawing, so that thumbnails and Quick Look can show the drawing without decoding it. Saving a very large drawing takes a
+ little longer as a result. Older versions of DrawKit ignore the preview.
+ */
+@property (class) BOOL savesPreview;
+
 /** @brief Saves the entire drawing to a file
  
  Implies the binary format
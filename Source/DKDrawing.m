@@ -7,8 +7,10 @@
 #import "DKDrawing.h"
 #import "DKCategoryManager.h"
 #import "DKDrawKitMacros.h"
+#import "DKDrawing+Export.h"
 #import "DKDrawing+Paper.h"
 #import "DKDrawingTool.h"
+#import "DKDrawingPreview.h"
 #import "DKDrawingView.h"
 #import "DKGridLayer.h"
 #import "DKGuideLayer.h"
@@ -19,6 +21,7 @@
 #import "DKObjectDrawingLayer.h"
 #import "DKStyle.h"
 #import "DKStyleRegistry.h"
+#import "DKTrace.h"
 #import "DKUnarchivingHelper.h"
 #import "DKUndoManager.h"
 #import "DKUniqueID.h"
@@ -81,6 +84,7 @@ NSString* const DKDrawingUnitsMiles = @"miles";
 #pragma mark Static vars
 
 static id sDearchivingHelper = nil;
+static BOOL sSavesPreview = YES;
 
 #pragma mark -
 @implementation DKDrawing
@@ -209,6 +213,9 @@ static id sDearchivingHelper = nil;
 	NSAssert(drawingData != nil, @"drawing data was nil - unable to proceed");
 	NSAssert([drawingData length] > 0, @"drawing data was empty - unable to proceed");
 
+	DKTraceScope(span, kDKTraceArchiving, "decode drawing");
+	span.argument = [drawingData length];
+
 	// using DKKeyedUnarchiver allows passing of image data manager to dearchiving methods for certain objects
 
 	DKKeyedUnarchiver* unarch = [[DKKeyedUnarchiver alloc] initForReadingWithData:drawingData];
@@ -222,8 +229,6 @@ static id sDearchivingHelper = nil;
 
 	[unarch setDelegate:dearchivingHelper];
 
-	LogEvent_(kReactiveEvent, @"decoding drawing root object......");
-
 	DKDrawing* dwg = [unarch decodeObjectForKey:@"root"];
 
 	[unarch finishDecoding];
@@ -497,6 +502,7 @@ static id sDearchivingHelper = nil;
 		[self drawingDidChangeToSize:[NSValue valueWithSize:aSize]];
 		[[self controllers] makeObjectsPerformSelector:@selector(drawingDidChangeToSize:)
 											withObject:[NSValue valueWithSize:aSize]];
+		[self invalidateAllExportBands];
 
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingDidChangeSize
 															object:self];
@@ -1284,6 +1290,7 @@ static id sDearchivingHelper = nil;
 	NSAssert(key != nil, @"key cannot be nil");
 	NSAssert([key length] > 0, @"key cannot be empty");
 
+	DKTraceScope(span, kDKTraceArchiving, "encode drawing as XML");
 	NSMutableData* data = [[NSMutableData alloc] init];
 
 	NSAssert(data != nil, @"couldn't create data for archiving");
@@ -1296,8 +1303,10 @@ static id sDearchivingHelper = nil;
 	[self finalizePriorToSaving];
 	[karch encodeObject:self
 				 forKey:key];
+	[self encodePreviewWithArchiver:karch];
 	[karch finishEncoding];
 
+	span.argument = [data length];
 	return [data copy];
 }
 
@@ -1308,8 +1317,48 @@ static id sDearchivingHelper = nil;
  */
 - (NSData*)drawingData
 {
+	DKTraceScope(span, kDKTraceArchiving, "encode drawing");
+	NSMutableData* data = [[NSMutableData alloc] init];
+	NSKeyedArchiver* karch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+
+	// the same archive +archivedDataWithRootObject: makes, so existing readers are unaffected by the preview
+
+	[karch setOutputFormat:NSPropertyListBinaryFormat_v1_0];
 	[self finalizePriorToSaving];
-	return [NSKeyedArchiver archivedDataWithRootObject:self];
+	[karch encodeObject:self
+				 forKey:NSKeyedArchiveRootObjectKey];
+	[self encodePreviewWithArchiver:karch];
+	[karch finishEncoding];
+
+	span.argument = [data length];
+	return [data copy];
+}
+
++ (BOOL)savesPreview
+{
+	return sSavesPreview;
+}
+
++ (void)setSavesPreview:(BOOL)saves
+{
+	sSavesPreview = saves;
+}
+
+/** @brief Add the drawing's preview to an archive, if previews are being saved
+
+ The preview is only property list objects, so it can be read back without decoding the drawing.
+ @param karch the archiver the drawing is being saved with
+ */
+- (void)encodePreviewWithArchiver:(NSKeyedArchiver*)karch
+{
+	if (![[self class] savesPreview])
+		return;
+
+	NSDictionary* preview = [[DKDrawingPreview previewOfDrawing:self] propertyList];
+
+	if (preview)
+		[karch encodeObject:preview
+					 forKey:kDKDrawingPreviewArchiveKey];
 }
 
 /** @brief The entire drawing in PDF format
@@ -1475,6 +1524,9 @@ static id sDearchivingHelper = nil;
  */
 - (void)setNeedsDisplay:(BOOL)refresh
 {
+	if (refresh)
+		[self invalidateAllExportBands];
+
 	[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplay:)
 										withObject:@(refresh)];
 }
@@ -1487,6 +1539,7 @@ static id sDearchivingHelper = nil;
  */
 - (void)setNeedsDisplayInRect:(NSRect)rect
 {
+	[self invalidateExportBandsInRect:rect];
 	[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplayInRect:)
 										withObject:[NSValue valueWithRect:rect]];
 }
@@ -1501,6 +1554,7 @@ static id sDearchivingHelper = nil;
 	NSAssert(setOfRects != nil, @"update set was nil");
 
 	for (NSValue* val in setOfRects) {
+		[self invalidateExportBandsInRect:[val rectValue]];
 		[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplayInRect:)
 											withObject:val];
 	}
@@ -0,0 +1,90 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKDrawing;
+
+/** @brief The key under which a drawing's preview is saved alongside its root object in a drawing archive.
+ */
+extern NSString* const kDKDrawingPreviewArchiveKey;
+
+/** @brief A small pyramid of pre-rendered images of a drawing, and a summary of what it contains, saved with the drawing so that it
+ can be read back without loading the drawing.
+
+ When a drawing is saved, its preview is written into the same keyed archive as the drawing, under its own top-level key and made only
+ of property list objects. Reading a preview decodes that key alone - none of the drawing's objects are decoded - so thumbnails and
+ Quick Look previews of even very large drawings are quick to make. Files saved before previews were added have none, and
+ <code>+previewWithData:</code> returns nil for them; callers should then load the drawing in full.
+
+ The images are PNG data, the largest no more than \c largestPreviewSize pixels on its longer side, each of the others half the size of the
+ one before, down to about 64 pixels.
+ */
+@interface DKDrawingPreview : NSObject {
+@private
+	NSSize mDrawingSize;
+	NSUInteger mLayerCount;
+	NSUInteger mObjectCount;
+	NSArray<NSDictionary*>* mLevels; // image levels, largest first
+}
+
+/** @brief The size in pixels of the longer side of the largest image in a new preview. The default is 512.
+ */
+@property (class) NSUInteger largestPreviewSize;
+
+/** @brief Render a preview of <code>drawing</code>.
+ */
++ (nullable instancetype)previewOfDrawing:(DKDrawing*)drawing;
+
+/** @brief Read the preview saved in drawing data, without decoding the drawing.
+ @param data the data of a saved drawing, binary or XML
+ @return the preview, or nil if the data has none or isn't a drawing
+ */
++ (nullable instancetype)previewWithData:(NSData*)data;
+
+/** @brief Read the preview saved in a drawing file, without decoding the drawing.
+
+ The file is mapped rather than read, so that only the parts of it holding the preview need be loaded.
+ */
++ (nullable instancetype)previewWithContentsOfURL:(NSURL*)url;
+
+/** @brief Make a preview from the property list it is saved as.
+ */
+- (nullable instancetype)initWithPropertyList:(NSDictionary*)plist NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/** @brief The preview as it is saved - a dictionary of property list objects.
+ */
+@property (readonly, copy) NSDictionary* propertyList;
+
+@property (readonly) NSSize drawingSize;
+/** @brief The number of layers in the drawing, not counting layer groups.
+ */
+@property (readonly) NSUInteger layerCount;
+/** @brief The number of objects in all of the drawing's object layers.
+ */
+@property (readonly) NSUInteger objectCount;
+
+/** @brief The number of images in the pyramid.
+ */
+@property (readonly) NSUInteger levelCount;
+/** @brief The size in pixels of the image at <code>level</code>, where 0 is the largest.
+ */
+- (NSSize)pixelSizeOfLevel:(NSUInteger)level;
+
+/** @brief Return the image at <code>level</code>, where 0 is the largest. The caller must release it.
+ */
+- (nullable CGImageRef)newImageAtLevel:(NSUInteger)level CF_RETURNS_RETAINED;
+/** @brief Return the smallest image that is at least as large as \c maxSize in one dimension, or the largest if none is. The caller
+ must release it.
+ */
+- (nullable CGImageRef)newImageFittingSize:(NSSize)maxSize CF_RETURNS_RETAINED;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,255 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKDrawingPreview.h"
+#import <ImageIO/ImageIO.h>
+#import "DKDrawing+Export.h"
+#import "DKDrawing.h"
+#import "DKObjectOwnerLayer.h"
+#import "LogEvent.h"
+
+NSString* const kDKDrawingPreviewArchiveKey = @"DKDrawingPreview";
+
+// keys in the saved property list
+
+static NSString* const kDKPreviewVersionKey = @"version";
+static NSString* const kDKPreviewDrawingSizeKey = @"drawingSize";
+static NSString* const kDKPreviewLayerCountKey = @"layerCount";
+static NSString* const kDKPreviewObjectCountKey = @"objectCount";
+static NSString* const kDKPreviewLevelsKey = @"levels";
+static NSString* const kDKPreviewWidthKey = @"width";
+static NSString* const kDKPreviewHeightKey = @"height";
+static NSString* const kDKPreviewImageKey = @"png";
+
+#define DK_PREVIEW_VERSION 1
+#define DK_PREVIEW_SMALLEST_SIZE 64
+
+static NSUInteger sLargestPreviewSize = 512;
+
+static NSData* pngDataForImage(CGImageRef image)
+{
+	NSMutableData* data = [NSMutableData data];
+	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypePNG, 1, NULL);
+
+	if (destRef == NULL)
+		return nil;
+
+	CGImageDestinationAddImage(destRef, image, NULL);
+	BOOL result = CGImageDestinationFinalize(destRef);
+	CFRelease(destRef);
+
+	return result ? data : nil;
+}
+
+static CGImageRef newHalvedImage(CGImageRef image)
+{
+	// each level is made from the one above rather than the original, so that every pixel is a filtered average of four
+
+	size_t width = MAX((size_t)1, CGImageGetWidth(image) / 2);
+	size_t height = MAX((size_t)1, CGImageGetHeight(image) / 2);
+	CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	CGContextRef ctx = CGBitmapContextCreate(NULL, width, height, 8, 0, clrSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst);
+
+	CGColorSpaceRelease(clrSpace);
+
+	if (ctx == NULL)
+		return NULL;
+
+	CGContextSetInterpolationQuality(ctx, kCGInterpolationHigh);
+	CGContextDrawImage(ctx, CGRectMake(0, 0, width, height), image);
+
+	CGImageRef result = CGBitmapContextCreateImage(ctx);
+	CGContextRelease(ctx);
+
+	return result;
+}
+
+#pragma mark -
+
+@implementation DKDrawingPreview
+
++ (NSUInteger)largestPreviewSize
+{
+	return sLargestPreviewSize;
+}
+
++ (void)setLargestPreviewSize:(NSUInteger)size
+{
+	sLargestPreviewSize = MAX((NSUInteger)DK_PREVIEW_SMALLEST_SIZE, size);
+}
+
++ (instancetype)previewOfDrawing:(DKDrawing*)drawing
+{
+	NSSize drawingSize = [drawing drawingSize];
+
+	if (drawingSize.width <= 0.0 || drawingSize.height <= 0.0)
+		return nil;
+
+	// the largest level is rendered from the drawing; the rest are scaled down from it. The export rounds pixel sizes up, so the scale
+	// is kept a hair under the exact one to stop rounding error adding a pixel to the longer side.
+
+	CGFloat scale = MIN(1.0, ((CGFloat)sLargestPreviewSize - 0.001) / MAX(drawingSize.width, drawingSize.height));
+	CGImageRef image = CGImageRetain([drawing CGImageWithResolution:72
+														   hasAlpha:NO
+													  relativeScale:scale]);
+	NSMutableArray<NSDictionary*>* levels = [NSMutableArray array];
+
+	while (image != NULL) {
+		size_t width = CGImageGetWidth(image);
+		size_t height = CGImageGetHeight(image);
+		NSData* png = pngDataForImage(image);
+
+		if (png)
+			[levels addObject:@{ kDKPreviewWidthKey: @(width),
+				kDKPreviewHeightKey: @(height),
+				kDKPreviewImageKey: png }];
+
+		CGImageRef next = (MAX(width, height) / 2 >= DK_PREVIEW_SMALLEST_SIZE) ? newHalvedImage(image) : NULL;
+
+		CGImageRelease(image);
+		image = next;
+	}
+
+	if ([levels count] == 0)
+		return nil;
+
+	NSUInteger objectCount = 0;
+
+	for (DKObjectOwnerLayer* layer in [drawing flattenedLayersOfClass:[DKObjectOwnerLayer class]])
+		objectCount += [layer countOfObjects];
+
+	NSDictionary* plist = @{ kDKPreviewVersionKey: @DK_PREVIEW_VERSION,
+		kDKPreviewDrawingSizeKey: NSStringFromSize(drawingSize),
+		kDKPreviewLayerCountKey: @([[drawing flattenedLayers] count]),
+		kDKPreviewObjectCountKey: @(objectCount),
+		kDKPreviewLevelsKey: levels };
+
+	return [[self alloc] initWithPropertyList:plist];
+}
+
++ (instancetype)previewWithData:(NSData*)data
+{
+	// only the preview key is decoded, and only property list classes are allowed in it, so nothing belonging to the drawing is
+	// created. A binary archive is read lazily, so the rest of it isn't even parsed.
+
+	NSSet* classes = [NSSet setWithObjects:[NSDictionary class], [NSArray class], [NSData class], [NSNumber class], [NSString class], nil];
+	NSDictionary* plist = nil;
+
+	@try {
+		NSKeyedUnarchiver* unarch = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+
+		[unarch setRequiresSecureCoding:YES];
+		plist = [unarch decodeObjectOfClasses:classes
+									   forKey:kDKDrawingPreviewArchiveKey];
+		[unarch finishDecoding];
+	}
+	@catch (NSException* exception) {
+		LogEvent_(kFileEvent, @"couldn't read drawing preview: %@", exception);
+		return nil;
+	}
+
+	if (![plist isKindOfClass:[NSDictionary class]])
+		return nil;
+
+	return [[self alloc] initWithPropertyList:plist];
+}
+
++ (instancetype)previewWithContentsOfURL:(NSURL*)url
+{
+	NSData* data = [NSData dataWithContentsOfURL:url
+										 options:NSDataReadingMappedIfSafe
+										   error:NULL];
+
+	if ([data length] == 0)
+		return nil;
+
+	return [self previewWithData:data];
+}
+
+- (instancetype)initWithPropertyList:(NSDictionary*)plist
+{
+	self = [super init];
+	if (self) {
+		if ([[plist objectForKey:kDKPreviewVersionKey] integerValue] != DK_PREVIEW_VERSION)
+			return nil;
+
+		NSArray* levels = [plist objectForKey:kDKPreviewLevelsKey];
+
+		if (![levels isKindOfClass:[NSArray class]] || [levels count] == 0)
+			return nil;
+
+		for (NSDictionary* level in levels) {
+			if (![level isKindOfClass:[NSDictionary class]] || ![[level objectForKey:kDKPreviewImageKey] isKindOfClass:[NSData class]])
+				return nil;
+		}
+
+		mDrawingSize = NSSizeFromString([plist objectForKey:kDKPreviewDrawingSizeKey]);
+		mLayerCount = [[plist objectForKey:kDKPreviewLayerCountKey] unsignedIntegerValue];
+		mObjectCount = [[plist objectForKey:kDKPreviewObjectCountKey] unsignedIntegerValue];
+		mLevels = [levels copy];
+	}
+
+	return self;
+}
+
+- (NSDictionary*)propertyList
+{
+	return @{ kDKPreviewVersionKey: @DK_PREVIEW_VERSION,
+		kDKPreviewDrawingSizeKey: NSStringFromSize(mDrawingSize),
+		kDKPreviewLayerCountKey: @(mLayerCount),
+		kDKPreviewObjectCountKey: @(mObjectCount),
+		kDKPreviewLevelsKey: mLevels };
+}
+
+@synthesize drawingSize = mDrawingSize;
+@synthesize layerCount = mLayerCount;
+@synthesize objectCount = mObjectCount;
+
+- (NSUInteger)levelCount
+{
+	return [mLevels count];
+}
+
+- (NSSize)pixelSizeOfLevel:(NSUInteger)level
+{
+	NSDictionary* info = [mLevels objectAtIndex:level];
+
+	return NSMakeSize([[info objectForKey:kDKPreviewWidthKey] doubleValue], [[info objectForKey:kDKPreviewHeightKey] doubleValue]);
+}
+
+- (CGImageRef)newImageAtLevel:(NSUInteger)level
+{
+	NSData* png = [[mLevels objectAtIndex:level] objectForKey:kDKPreviewImageKey];
+	CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)png, NULL);
+
+	if (source == NULL)
+		return NULL;
+
+	CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, NULL);
+	CFRelease(source);
+
+	return image;
+}
+
+- (CGImageRef)newImageFittingSize:(NSSize)maxSize
+{
+	// levels get smaller, so the last one large enough is the one wanted
+
+	NSUInteger level = 0;
+
+	for (NSUInteger i = 1; i < [mLevels count]; ++i) {
+		NSSize size = [self pixelSizeOfLevel:i];
+
+		if (size.width < maxSize.width && size.height < maxSize.height)
+			break;
+
+		level = i;
+	}
+
+	return [self newImageAtLevel:level];
+}
+
+@end
@@ -58,6 +58,12 @@ typedef NS_ENUM(NSInteger, DKCropMarkKind) {
 + (nullable DKDrawingView*)currentlyDrawingView;
 + (void)pop;
 
+/** @brief Make \c +currentlyDrawingView return nil until the matching <code>+pop</code>.
+
+ For drawing that must not be culled or otherwise affected by the view being updated, such as recording an object's display list.
+ */
++ (void)pushNoView;
+
 /** @brief Set the colour used to draw the page breaks
  */
 @property (class, retain, null_resettable) NSColor* pageBreakColour;
@@ -94,7 +94,9 @@ NSString* const kDKTextEditorUndoesTypingPrefsKey = @"kDKTextEditorUndoesTyping"
  */
 + (DKDrawingView*)currentlyDrawingView
 {
-	return [sDrawingViewStack lastObject];
+	id view = [sDrawingViewStack lastObject];
+
+	return (view == [NSNull null]) ? nil : view;
 }
 
 + (void)pushCurrentViewAndSet:(DKDrawingView*)aView
@@ -107,6 +109,14 @@ NSString* const kDKTextEditorUndoesTypingPrefsKey = @"kDKTextEditorUndoesTyping"
 	[sDrawingViewStack addObject:aView];
 }
 
++ (void)pushNoView
+{
+	if (sDrawingViewStack == nil)
+		sDrawingViewStack = [[NSMutableArray alloc] init];
+
+	[sDrawingViewStack addObject:[NSNull null]];
+}
+
 + (void)pop
 {
 	NSUInteger stackSize = [sDrawingViewStack count];
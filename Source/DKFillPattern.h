@@ -27,7 +27,6 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL m_angleRelativeToObject;
 	BOOL m_motifAngleRelativeToPattern;
 	BOOL m_noClippedElements;
-	NSMutableArray* mMotifAngleRandCache;
 }
 
 /** return the default pattern, which is based on some image - unlikely to be really useful so might be
@@ -41,6 +40,11 @@ NS_ASSUME_NONNULL_BEGIN
 @property NSSize patternAlternateOffset;
 
 - (void)fillRect:(NSRect)rect;
+/** @brief Draw the motifs that fill <code>aPath</code>.
+
+ Only the rows and columns that fall within the current clip are visited, and each row is split into spans where it crosses the
+ path's edges, so motifs wholly outside the path are skipped without being tested and those wholly inside are drawn without testing.
+ */
 - (void)drawPatternInPath:(NSBezierPath*)aPath;
 
 @property CGFloat angle;
@@ -55,7 +59,8 @@ NS_ASSUME_NONNULL_BEGIN
 @property BOOL motifAngleIsRelativeToPattern;
 
 /** @brief setting this causes a test for intersection of the motif's bounds with the object's path. If there is an intersection, the motif is not drawn. This makes patterns
- appear tidier for certain applications (such as GIS/mapping) but adds a substantial performance overhead. \c NO by default.
+ appear tidier for certain applications (such as GIS/mapping). The test is only made for motifs close to the path's edges, but can still be costly for
+ intricate paths. \c NO by default.
  */
 @property BOOL drawingOfClippedElementsSupressed;
 
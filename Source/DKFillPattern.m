@@ -6,12 +6,199 @@
 
 #import "DKFillPattern.h"
 #import "DKDrawKitMacros.h"
+#import "DKFlatPath.h"
 #import "DKGeometryUtilities.h"
 #import "DKRandom.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Text.h"
 #import "NSBezierPath-OAExtensions.h"
 
+/** @brief One straight edge of a flattened path, with its vertical extent. */
+typedef struct {
+	NSPoint a;
+	NSPoint b;
+	CGFloat minY;
+	CGFloat maxY;
+} patternEdge;
+
+/** @brief A horizontal run, from \c left to \c right inclusive. */
+typedef struct {
+	CGFloat left;
+	CGFloat right;
+} patternSpan;
+
+typedef struct {
+	CGFloat x;
+	NSInteger winding;
+} patternCrossing;
+
+static int compareEdges(const void* a, const void* b)
+{
+	CGFloat ya = ((const patternEdge*)a)->minY;
+	CGFloat yb = ((const patternEdge*)b)->minY;
+
+	return (ya < yb) ? -1 : (ya > yb) ? 1 : 0;
+}
+
+static int compareSpans(const void* a, const void* b)
+{
+	CGFloat la = ((const patternSpan*)a)->left;
+	CGFloat lb = ((const patternSpan*)b)->left;
+
+	return (la < lb) ? -1 : (la > lb) ? 1 : 0;
+}
+
+static int compareCrossings(const void* a, const void* b)
+{
+	CGFloat xa = ((const patternCrossing*)a)->x;
+	CGFloat xb = ((const patternCrossing*)b)->x;
+
+	return (xa < xb) ? -1 : (xa > xb) ? 1 : 0;
+}
+
+static void addEdge(patternEdge* edges, NSUInteger* count, NSPoint a, NSPoint b)
+{
+	if (NSEqualPoints(a, b))
+		return;
+
+	patternEdge* e = &edges[(*count)++];
+
+	e->a = a;
+	e->b = b;
+	e->minY = MIN(a.y, b.y);
+	e->maxY = MAX(a.y, b.y);
+}
+
+static patternEdge* newEdgesOfPath(NSBezierPath* path, NSUInteger* edgeCount)
+{
+	// flatten the path and list its edges, sorted by their lowest point. Open subpaths are closed, as they are when filled.
+
+	NSBezierPath* flat = [path bezierPathByFlatteningPath];
+	NSInteger i, ec = [flat elementCount];
+	patternEdge* edges = malloc((ec + 1) * sizeof(patternEdge));
+	NSPoint p[3], start = NSZeroPoint, last = NSZeroPoint;
+	NSUInteger count = 0;
+
+	for (i = 0; i < ec; ++i) {
+		switch ([flat elementAtIndex:i
+					associatedPoints:p]) {
+		case NSMoveToBezierPathElement:
+			addEdge(edges, &count, last, start);
+			start = last = p[0];
+			break;
+
+		case NSLineToBezierPathElement:
+			addEdge(edges, &count, last, p[0]);
+			last = p[0];
+			break;
+
+		case NSClosePathBezierPathElement:
+			addEdge(edges, &count, last, start);
+			last = start;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	addEdge(edges, &count, last, start);
+	qsort(edges, count, sizeof(patternEdge), compareEdges);
+
+	*edgeCount = count;
+	return edges;
+}
+
+static NSUInteger boundarySpans(const patternEdge* edges, NSUInteger edgeCount, CGFloat top, CGFloat bottom, patternSpan* spans)
+{
+	// the horizontal extent of every part of an edge lying between <top> and <bottom>, merged into sorted, disjoint spans
+
+	NSUInteger i, count = 0;
+
+	for (i = 0; i < edgeCount && edges[i].minY <= bottom; ++i) {
+		const patternEdge* e = &edges[i];
+
+		if (e->maxY < top)
+			continue;
+
+		CGFloat xa = e->a.x, xb = e->b.x;
+
+		if (e->a.y != e->b.y) {
+			CGFloat ta = LIMIT((top - e->a.y) / (e->b.y - e->a.y), 0, 1);
+			CGFloat tb = LIMIT((bottom - e->a.y) / (e->b.y - e->a.y), 0, 1);
+
+			xa = e->a.x + ta * (e->b.x - e->a.x);
+			xb = e->a.x + tb * (e->b.x - e->a.x);
+		}
+
+		spans[count].left = MIN(xa, xb);
+		spans[count].right = MAX(xa, xb);
+		++count;
+	}
+
+	if (count < 2)
+		return count;
+
+	qsort(spans, count, sizeof(patternSpan), compareSpans);
+
+	NSUInteger merged = 0;
+
+	for (i = 1; i < count; ++i) {
+		if (spans[i].left <= spans[merged].right)
+			spans[merged].right = MAX(spans[merged].right, spans[i].right);
+		else
+			spans[++merged] = spans[i];
+	}
+
+	return merged + 1;
+}
+
+static NSUInteger insideSpans(const patternEdge* edges, NSUInteger edgeCount, CGFloat y, BOOL evenOdd, patternCrossing* crossings, patternSpan* spans)
+{
+	// the runs of the line at <y> that are inside the path, found from the edges crossing it and the winding rule
+
+	NSUInteger i, count = 0, spanCount = 0;
+
+	for (i = 0; i < edgeCount && edges[i].minY <= y; ++i) {
+		const patternEdge* e = &edges[i];
+
+		if (y >= e->maxY)
+			continue;
+
+		crossings[count].x = e->a.x + (y - e->a.y) * (e->b.x - e->a.x) / (e->b.y - e->a.y);
+		crossings[count].winding = (e->b.y > e->a.y) ? 1 : -1;
+		++count;
+	}
+
+	qsort(crossings, count, sizeof(patternCrossing), compareCrossings);
+
+	NSInteger winding = 0;
+
+	for (i = 0; i < count; ++i) {
+		BOOL wasInside = evenOdd ? (winding & 1) : (winding != 0);
+
+		winding += crossings[i].winding;
+
+		BOOL isInside = evenOdd ? (winding & 1) : (winding != 0);
+
+		if (isInside && !wasInside)
+			spans[spanCount].left = crossings[i].x;
+		else if (wasInside && !isInside)
+			spans[spanCount++].right = crossings[i].x;
+	}
+
+	return spanCount;
+}
+
+static NSUInteger cellKey(NSInteger x, NSInteger y)
+{
+	// the column is kept whole in the low bits, so alternation by key follows the columns
+
+	return ((NSUInteger)(uint32_t)y << 32) | (uint32_t)x;
+}
+
+#pragma mark -
+
 @implementation DKFillPattern
 #pragma mark As a DKFillPattern
 
@@ -63,7 +250,8 @@
 
 	// because the shape may have any rotation, we cannot rely on the passed rect being aligned to the shape. Thus to prevent the pattern
 	// shifting around and having missing elements at the edges, take the longest side of rect, make it square, then multiply by sqrt(2) to
-	// allow for the worst-case diagonal.
+	// allow for the worst-case diagonal. This sets the extent of the grid, and so which cell each motif belongs to, but only the cells
+	// that can be seen are visited.
 
 	NSPoint cp;
 
@@ -116,100 +304,191 @@
 	cols = ((rect.size.width / dx) / 2) + 1;
 	rows = ((rect.size.height / dy) / 2) + 1;
 
-	NSPoint mp, tp;
-
-	//	LogEvent_(kInfoEvent, @"drawing patterm, %d rows x %d cols: rect = %@", rows, cols, NSStringFromRect( rect ) );
+	// the furthest any part of a motif can reach from its grid point, allowing for rotation, wobble, scale randomness and the
+	// superclass's own offsets. A cell is only treated as wholly inside or outside the path if no edge comes this close to it.
 
 	NSRect motifBounds;
 
 	motifBounds.size.width = mb.width * [self scale];
 	motifBounds.size.height = mb.height * [self scale];
 
-	@autoreleasepool {
+	CGFloat reach = hypot(motifBounds.size.width, motifBounds.size.height) * 0.5 * (1.0 + [self scaleRandomness] * 0.5);
 
-		// set up a transform that will transform each motif point to allow for the object's
-		// origin and angle, so the pattern can be rotated as a pattern rather than as individual images
+	reach += (MAX(dx, dy) + ABS([self interval])) * 0.5 * [self wobblyness] + ABS([self lateralOffset]);
 
-		NSAffineTransform* tfm = RotationTransform(angle, cp);
-		NSPoint wobblePoint = NSZeroPoint;
-		CGFloat tempAngle = mangle;
+	// the grid is laid out in pattern space, which is rotated by <angle> about the centre. Work there: bring the path and the
+	// area being drawn into pattern space, find the rows that could be seen, and split each into spans using the path's edges.
 
-		// ok, draw 'em...
+	NSAffineTransform* tfm = RotationTransform(angle, cp);
+	NSAffineTransform* inverse = [[tfm copy] autorelease];
 
-		for (y = -rows; y < rows; ++y) {
-			for (x = -cols; x < cols; ++x) {
-				if (y & 1)
-					mp.x = dx * (x + m_altXOffset) + cp.x;
-				else
-					mp.x = (x * dx) + cp.x;
+	[inverse invert];
 
-				if (x & 1)
-					mp.y = dy * (y + m_altYOffset) + cp.y;
-				else
-					mp.y = (y * dy) + cp.y;
+	NSRect visible = NSIntersectionRect(NSRectFromCGRect(CGContextGetClipBoundingBox([[NSGraphicsContext currentContext] graphicsPort])), [aPath bounds]);
 
-				if ([self wobblyness] > 0.0) {
-					// wobblyness is a randomising positioning factor from 0..1. Cached to avoid recalculation on every redraw.
+	if (NSIsEmptyRect(visible))
+		return;
 
-					if (mPlacementCount < [mWobbleCache count])
-						wobblePoint = [[mWobbleCache objectAtIndex:mPlacementCount] pointValue];
-					else {
-						wobblePoint.x = [DKRandom randomPositiveOrNegativeNumber] * dx * [self wobblyness];
-						wobblePoint.y = [DKRandom randomPositiveOrNegativeNumber] * dy * [self wobblyness];
-						[mWobbleCache addObject:[NSValue valueWithPoint:wobblePoint]];
-					}
+	NSPoint corners[4] = { visible.origin, NSMakePoint(NSMaxX(visible), NSMinY(visible)), NSMakePoint(NSMaxX(visible), NSMaxY(visible)), NSMakePoint(NSMinX(visible), NSMaxY(visible)) };
+	CGFloat vMinX = CGFLOAT_MAX, vMinY = CGFLOAT_MAX, vMaxX = -CGFLOAT_MAX, vMaxY = -CGFLOAT_MAX;
+	NSInteger i;
 
-					mp.x += wobblePoint.x;
-					mp.y += wobblePoint.y;
-				}
+	for (i = 0; i < 4; ++i) {
+		NSPoint vp = [inverse transformPoint:corners[i]];
 
-				if ([self motifAngleRandomness] > 0.0) {
-					CGFloat ra = 0.0;
+		vMinX = MIN(vMinX, vp.x);
+		vMaxX = MAX(vMaxX, vp.x);
+		vMinY = MIN(vMinY, vp.y);
+		vMaxY = MAX(vMaxY, vp.y);
+	}
 
-					if (mPlacementCount < [mMotifAngleRandCache count])
-						ra = [[mMotifAngleRandCache objectAtIndex:mPlacementCount] doubleValue];
-					else {
-						ra = [DKRandom randomPositiveOrNegativeNumber] * 2.0 * M_PI * [self motifAngleRandomness];
-						[mMotifAngleRandCache addObject:@(ra)];
-					}
-					tempAngle = mangle;
-					tempAngle += ra;
-				}
+	NSInteger firstRow = MAX(-rows, (NSInteger)floor((vMinY - reach - cp.y) / dy) - 1);
+	NSInteger lastRow = MIN(rows - 1, (NSInteger)ceil((vMaxY + reach - cp.y) / dy));
+	NSInteger firstCol = MAX(-cols, (NSInteger)floor((vMinX - reach - cp.x) / dx) - 1);
+	NSInteger lastCol = MIN(cols - 1, (NSInteger)ceil((vMaxX + reach - cp.x) / dx));
 
-				tp = [tfm transformPoint:mp];
-				++mPlacementCount;
+	if (firstRow > lastRow || firstCol > lastCol)
+		return;
 
-				if (m_noClippedElements) {
-					// if this option is set, we don't draw pattern images that intersect the path. To detect whether that happens, the bounding rect
-					// of the element is calculated in position and intersected with the path. The text for intersection can be potentially intensive,
-					// so this option may incur a significant performance hit depending on pattern density, as every placed element needs to be checked.
+	NSBezierPath* patternPath = [[aPath copy] autorelease];
 
-					// first, if <tp> is outside the path, we already know it's clipped or intersecting, so we can trivially discard that case
+	[patternPath transformUsingAffineTransform:inverse];
 
-					if (![aPath containsPoint:tp])
-						continue;
+	NSUInteger edgeCount;
+	patternEdge* edges = newEdgesOfPath(patternPath, &edgeCount);
+	BOOL evenOdd = ([aPath windingRule] == NSEvenOddWindingRule);
+	patternSpan* boundary = malloc(MAX(edgeCount, 1) * sizeof(patternSpan));
+	patternSpan* inside = malloc(MAX(edgeCount, 1) * sizeof(patternSpan));
+	patternCrossing* crossings = malloc(MAX(edgeCount, 1) * sizeof(patternCrossing));
+
+	// motifs near an edge are tested against the path itself, which is flattened once for all of them
+
+	DKFlatPath* flatPath = m_noClippedElements ? [DKFlatPath flatPathWithBezierPath:aPath] : nil;
+
+	// the random factors are derived from each cell's row and column, so a motif keeps its wobble and angle however much of the
+	// pattern is being drawn. The superclass wobbles and scales each motif by the first three factors for its key, so the pattern's
+	// own wobble and angle use the next three.
+
+	BOOL wobble = ([self wobblyness] > 0.0);
+	BOOL randomAngle = ([self motifAngleRandomness] > 0.0);
+
+	NSUInteger capacity = (NSUInteger)((lastRow - firstRow + 1) * (lastCol - firstCol + 1));
+	NSPoint* points = malloc(capacity * sizeof(NSPoint));
+	CGFloat* slopes = malloc(capacity * sizeof(CGFloat));
+	NSUInteger* indexes = malloc(capacity * sizeof(NSUInteger));
+	NSUInteger placed = 0;
+
+	@autoreleasepool {
+		for (y = firstRow; y <= lastRow; ++y) {
+			// odd columns are offset vertically, so each row is two bands: the even columns, then the odd ones
+
+			NSInteger parity;
+
+			for (parity = 0; parity < 2; ++parity) {
+				CGFloat cy = (parity ? dy * (y + m_altYOffset) : (y * dy)) + cp.y;
+				NSUInteger boundaryCount = boundarySpans(edges, edgeCount, cy - reach, cy + reach, boundary);
+				NSUInteger insideCount = insideSpans(edges, edgeCount, cy, evenOdd, crossings, inside);
+				NSUInteger b = 0, s = 0;
+
+				if (insideCount == 0 && boundaryCount == 0)
+					continue;
+
+				for (x = firstCol + ((firstCol & 1) != parity); x <= lastCol; x += 2) {
+					NSPoint mp;
+
+					if (y & 1)
+						mp.x = dx * (x + m_altXOffset) + cp.x;
+					else
+						mp.x = (x * dx) + cp.x;
+
+					mp.y = cy;
 
-					// tp is inside the path but not all of the image's bounds may be, so need to do full intersection test
+					// classify the cell: near an edge, wholly inside, or wholly outside. Spans are sorted and columns run left to right,
+					// so each list is walked once per band.
 
-					motifBounds.origin.x = tp.x - motifBounds.size.width * 0.5;
-					motifBounds.origin.y = tp.y - motifBounds.size.height * 0.5;
+					while (b < boundaryCount && boundary[b].right < mp.x - reach)
+						++b;
 
-					// uses Omni's code to perform the detection - returns as soon as it has an answer
+					while (s < insideCount && inside[s].right < mp.x)
+						++s;
 
-					if ([aPath intersectsRect:motifBounds])
+					BOOL onBoundary = (b < boundaryCount && boundary[b].left <= mp.x + reach);
+
+					if (!onBoundary && !(s < insideCount && inside[s].left <= mp.x))
 						continue;
-				}
 
-				// defer to superclass's placement method to actually draw the elements which applies further transformations, etc.
+					NSUInteger cell = cellKey(x, y);
+					CGFloat tempAngle = mangle;
+
+					if (wobble || randomAngle) {
+						CGFloat factors[6];
+
+						[self getRandomFactors:factors
+										 count:6
+										forKey:cell];
+
+						// wobblyness is a randomising positioning factor from 0..1
+
+						if (wobble) {
+							mp.x += factors[3] * dx * [self wobblyness];
+							mp.y += factors[4] * dy * [self wobblyness];
+						}
+
+						if (randomAngle)
+							tempAngle += factors[5] * 2.0 * M_PI * [self motifAngleRandomness];
+					}
+
+					NSPoint tp = [tfm transformPoint:mp];
+
+					if (m_noClippedElements && onBoundary) {
+						// if this option is set, we don't draw pattern images that intersect the path. Only cells near an edge need the
+						// exact test, which can be expensive; cells classified as inside can't intersect it.
+
+						// first, if <tp> is outside the path, we already know it's clipped or intersecting, so we can trivially discard that case
+
+						if (![aPath containsPoint:tp])
+							continue;
+
+						// tp is inside the path but not all of the image's bounds may be, so need to do full intersection test
+
+						motifBounds.origin.x = tp.x - motifBounds.size.width * 0.5;
+						motifBounds.origin.y = tp.y - motifBounds.size.height * 0.5;
+
+						// uses Omni's code to perform the detection - returns as soon as it has an answer
 
-				[self placeObjectAtPoint:tp
-								  onPath:nil
-								position:0
-								   slope:tempAngle
-								userInfo:NULL];
+						if ([aPath intersectsRect:motifBounds
+										 flatPath:flatPath])
+							continue;
+					}
+
+					points[placed] = tp;
+					slopes[placed] = tempAngle;
+					indexes[placed] = cell;
+					++placed;
+				}
 			}
 		}
+
+		// defer to the superclass to turn the points into placements, which applies further transformations, etc., and draw them all at once
+
+		mPlacementCount = placed;
+
+		NSUInteger count = [self placeMotifsAtPoints:points
+											  slopes:slopes
+											 indexes:indexes
+											   count:placed];
+
+		[self drawMotifPlacements:[self motifPlacements]
+							count:count];
 	}
+
+	free(points);
+	free(slopes);
+	free(indexes);
+	free(boundary);
+	free(inside);
+	free(crossings);
+	free(edges);
 }
 
 #pragma mark -
@@ -252,16 +531,9 @@
 
 - (void)setMotifAngleRandomness:(CGFloat)maRand
 {
-	maRand = LIMIT(maRand, 0, 1);
-
-	if (maRand != mMotifAngleRandomness) {
-		mMotifAngleRandomness = maRand;
+	// the random factors don't change, so changing the randomness scales each motif's angle rather than reshuffling them
 
-		if (mMotifAngleRandCache == nil)
-			mMotifAngleRandCache = [[NSMutableArray alloc] init];
-
-		[mMotifAngleRandCache removeAllObjects];
-	}
+	mMotifAngleRandomness = LIMIT(maRand, 0, 1);
 }
 
 @synthesize motifAngleRandomness = mMotifAngleRandomness;
@@ -326,12 +598,6 @@
 	return self;
 }
 
-- (void)dealloc
-{
-	[mMotifAngleRandCache release];
-	[super dealloc];
-}
-
 #pragma mark -
 #pragma mark As part of DKRasterizerProtocol
 
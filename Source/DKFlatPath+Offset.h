@@ -0,0 +1,48 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKFlatPath.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Offsetting and stroke outlining of flat paths.
+
+ Curves are offset directly rather than being flattened first: each curve is approximated by an offset curve whose distance from the
+ true offset is checked at several points and the curve subdivided until it lies within \c tolerance. Where the offset of a curve
+ would turn back on itself (at a cusp, or on the inside of a bend tighter than the offset distance), it falls back to short line
+ segments.
+
+ Corners on the outside of a bend are joined according to the join style and miter limit, in the same way that Quartz strokes a
+ path. On the inside of a bend the two offset segments overlap, and the loop this creates is removed by finding where the
+ segments cross and trimming them there. The crossings are found over the whole of each subpath, so a loop is removed even where the
+ path folds back on itself and the crossing is many segments away from the bend.
+
+ The offset may vary linearly with distance along the path, from \c startOffset at the start of the first subpath to \c endOffset
+ at the end of the last, which allows tapered strokes. Positive offsets are to the left of the direction of the path in
+ unflipped coordinates (below or to the right in a flipped view), matching -[NSBezierPath paralleloidPathWithOffset:].
+ */
+@interface DKFlatPath (Offset)
+
+/** @brief Return a path parallel to the receiver.
+ @param startOffset the offset at the start of the path
+ @param endOffset the offset at the end of the path
+ @param join how corners on the outside of bends are joined
+ @param miterLimit the miter limit for mitered joins
+ @param tolerance the maximum distance of the result from the true offset
+ @return a new path
+ */
+- (DKFlatPath*)flatPathByOffsettingFrom:(CGFloat)startOffset to:(CGFloat)endOffset lineJoinStyle:(NSLineJoinStyle)join miterLimit:(CGFloat)miterLimit tolerance:(CGFloat)tolerance;
+
+/** @brief Return the outline of the receiver stroked with a width varying from \c startWidth to <code>endWidth</code>.
+
+ The result uses the non-zero winding rule. Each open subpath becomes a single closed contour with its caps; each closed subpath
+ becomes two closed contours of opposite direction.
+ */
+- (DKFlatPath*)strokeOutlineWithStartWidth:(CGFloat)startWidth endWidth:(CGFloat)endWidth lineJoinStyle:(NSLineJoinStyle)join lineCapStyle:(NSLineCapStyle)cap miterLimit:(CGFloat)miterLimit tolerance:(CGFloat)tolerance;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,833 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKFlatPath+Offset.h"
+#import "NSBezierPath+Geometry.h"
+
+#define DK_OFFSET_MAX_DEPTH 8 // maximum levels of subdivision of a curve before falling back to lines
+#define DK_OFFSET_FALLBACK_STEPS 4 // number of lines a curve is replaced by at the deepest level
+#define DK_INTERSECT_MAX_DEPTH 24
+#define DK_INTERSECT_BUDGET 4096 // bounds the work done looking for any one crossing, e.g. where segments overlap along their length
+#define DK_OFFSET_EPSILON 1e-9
+
+/** @brief A line or curve segment, used both for the source path and for the pieces of the offset.
+
+ Lines keep their control points at the thirds so that they can be treated as curves where convenient.
+ */
+typedef struct {
+	NSPoint p[4];
+	CGFloat d0, d1; // offset at the start and end (source segments only)
+	BOOL isLine;
+	BOOL isConnector; // an inner join, or a piece of offset running backwards: these are where loops occur
+	BOOL isDeleted; // removed by loop cleanup
+} DKOffsetSegment;
+
+typedef struct {
+	DKOffsetSegment* items;
+	NSUInteger count;
+	NSUInteger capacity;
+} DKOffsetSegmentList;
+
+#pragma mark Static Functions
+
+static DKOffsetSegment* addSegment(DKOffsetSegmentList* list)
+{
+	if (list->count == list->capacity) {
+		list->capacity = MAX(16, list->capacity * 2);
+		list->items = reallocf(list->items, list->capacity * sizeof(DKOffsetSegment));
+	}
+
+	DKOffsetSegment* seg = &list->items[list->count++];
+	memset(seg, 0, sizeof(DKOffsetSegment));
+
+	return seg;
+}
+
+static void addLine(DKOffsetSegmentList* list, NSPoint a, NSPoint b, BOOL isConnector)
+{
+	DKOffsetSegment* seg = addSegment(list);
+
+	seg->p[0] = a;
+	seg->p[1] = NSMakePoint(a.x + (b.x - a.x) / 3.0, a.y + (b.y - a.y) / 3.0);
+	seg->p[2] = NSMakePoint(a.x + 2.0 * (b.x - a.x) / 3.0, a.y + 2.0 * (b.y - a.y) / 3.0);
+	seg->p[3] = b;
+	seg->isLine = YES;
+	seg->isConnector = isConnector;
+}
+
+static void addCurve(DKOffsetSegmentList* list, const NSPoint q[4], BOOL isConnector)
+{
+	DKOffsetSegment* seg = addSegment(list);
+
+	memcpy(seg->p, q, sizeof(seg->p));
+	seg->isConnector = isConnector;
+}
+
+#pragma mark -
+
+static inline NSPoint sub(NSPoint a, NSPoint b)
+{
+	return NSMakePoint(a.x - b.x, a.y - b.y);
+}
+
+static inline NSPoint addScaled(NSPoint a, NSPoint v, CGFloat s)
+{
+	return NSMakePoint(a.x + v.x * s, a.y + v.y * s);
+}
+
+static inline CGFloat dot(NSPoint a, NSPoint b)
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+static inline CGFloat cross(NSPoint a, NSPoint b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+static inline CGFloat distance(NSPoint a, NSPoint b)
+{
+	return hypot(a.x - b.x, a.y - b.y);
+}
+
+static inline NSPoint unitVector(NSPoint v)
+{
+	CGFloat len = hypot(v.x, v.y);
+
+	return (len > DK_OFFSET_EPSILON) ? NSMakePoint(v.x / len, v.y / len) : NSZeroPoint;
+}
+
+// the left hand normal of a unit tangent
+
+static inline NSPoint normal(NSPoint t)
+{
+	return NSMakePoint(-t.y, t.x);
+}
+
+static NSPoint bezierPoint(const NSPoint b[4], CGFloat t)
+{
+	CGFloat mt = 1.0 - t;
+	CGFloat c0 = mt * mt * mt, c1 = 3.0 * mt * mt * t, c2 = 3.0 * mt * t * t, c3 = t * t * t;
+
+	return NSMakePoint(c0 * b[0].x + c1 * b[1].x + c2 * b[2].x + c3 * b[3].x, c0 * b[0].y + c1 * b[1].y + c2 * b[2].y + c3 * b[3].y);
+}
+
+static NSPoint bezierDerivative(const NSPoint b[4], CGFloat t)
+{
+	CGFloat mt = 1.0 - t;
+	CGFloat c0 = 3.0 * mt * mt, c1 = 6.0 * mt * t, c2 = 3.0 * t * t;
+
+	return NSMakePoint(c0 * (b[1].x - b[0].x) + c1 * (b[2].x - b[1].x) + c2 * (b[3].x - b[2].x),
+		c0 * (b[1].y - b[0].y) + c1 * (b[2].y - b[1].y) + c2 * (b[3].y - b[2].y));
+}
+
+// unit tangents at the ends of a curve, skipping control points that coincide with the end point
+
+static NSPoint startTangent(const NSPoint b[4])
+{
+	NSUInteger i;
+
+	for (i = 1; i < 4; ++i) {
+		if (distance(b[i], b[0]) > DK_OFFSET_EPSILON)
+			return unitVector(sub(b[i], b[0]));
+	}
+
+	return NSZeroPoint;
+}
+
+static NSPoint endTangent(const NSPoint b[4])
+{
+	NSInteger i;
+
+	for (i = 2; i >= 0; --i) {
+		if (distance(b[3], b[i]) > DK_OFFSET_EPSILON)
+			return unitVector(sub(b[3], b[i]));
+	}
+
+	return NSZeroPoint;
+}
+
+static BOOL lineIntersection(NSPoint p, NSPoint u, NSPoint q, NSPoint v, NSPoint* result)
+{
+	// intersection of the line through p in direction u with the line through q in direction v
+
+	CGFloat den = cross(u, v);
+
+	if (fabs(den) < 1e-6)
+		return NO;
+
+	*result = addScaled(p, u, cross(sub(q, p), v) / den);
+	return YES;
+}
+
+#pragma mark - offsetting single segments
+
+static void tillerHansonOffset(const NSPoint b[4], CGFloat d0, CGFloat d1, NSPoint q[4])
+{
+	// offset each leg of the control polygon along its own normal and take the intersections of adjacent legs as the new inner
+	// control points. Degenerate legs take the direction of the curve at that end.
+
+	NSPoint ta = startTangent(b);
+	NSPoint tc = endTangent(b);
+	NSPoint tb = unitVector(sub(b[2], b[1]));
+	CGFloat dm = 0.5 * (d0 + d1);
+
+	if (tb.x == 0 && tb.y == 0)
+		tb = unitVector(sub(b[3], b[0]));
+
+	q[0] = addScaled(b[0], normal(ta), d0);
+	q[3] = addScaled(b[3], normal(tc), d1);
+
+	NSPoint mid = addScaled(b[1], normal(tb), dm);
+
+	if (!lineIntersection(q[0], ta, mid, tb, &q[1]))
+		q[1] = addScaled(b[1], normal(ta), d0);
+
+	mid = addScaled(b[2], normal(tb), dm);
+
+	if (!lineIntersection(q[3], tc, mid, tb, &q[2]))
+		q[2] = addScaled(b[2], normal(tc), d1);
+}
+
+static NSPoint exactOffsetPoint(const NSPoint b[4], CGFloat d0, CGFloat d1, CGFloat t, BOOL* valid)
+{
+	NSPoint tangent = unitVector(bezierDerivative(b, t));
+
+	*valid = (tangent.x != 0 || tangent.y != 0);
+	return addScaled(bezierPoint(b, t), normal(tangent), d0 + (d1 - d0) * t);
+}
+
+static void offsetCurve(DKOffsetSegmentList* out, const NSPoint b[4], CGFloat d0, CGFloat d1, CGFloat tolerance, NSUInteger depth)
+{
+	static const CGFloat samples[] = { 0.25, 0.5, 0.75 };
+	NSPoint q[4], exact;
+	CGFloat err = 0.0;
+	BOOL valid, reversed = NO;
+	NSUInteger i;
+
+	tillerHansonOffset(b, d0, d1, q);
+
+	for (i = 0; i < 3; ++i) {
+		exact = exactOffsetPoint(b, d0, d1, samples[i], &valid);
+
+		if (valid)
+			err = MAX(err, distance(exact, bezierPoint(q, samples[i])));
+	}
+
+	// the offset runs backwards where the curve bends more tightly than the offset distance
+
+	if (dot(bezierDerivative(q, 0.5), bezierDerivative(b, 0.5)) < 0)
+		reversed = YES;
+
+	if (err <= tolerance) {
+		addCurve(out, q, reversed);
+	} else if (depth < DK_OFFSET_MAX_DEPTH) {
+		NSPoint left[4], right[4];
+		CGFloat dm = 0.5 * (d0 + d1);
+
+		subdivideBezierAtT(b, left, right, 0.5);
+		offsetCurve(out, left, d0, dm, tolerance, depth + 1);
+		offsetCurve(out, right, dm, d1, tolerance, depth + 1);
+	} else {
+		// still out of tolerance - usually a cusp. Use short lines through exact offset points instead.
+
+		NSPoint prev = q[0];
+
+		for (i = 1; i <= DK_OFFSET_FALLBACK_STEPS; ++i) {
+			CGFloat t = (CGFloat)i / DK_OFFSET_FALLBACK_STEPS;
+			NSPoint p = (i == DK_OFFSET_FALLBACK_STEPS) ? q[3] : exactOffsetPoint(b, d0, d1, t, &valid);
+			NSPoint chord = sub(bezierPoint(b, t), bezierPoint(b, t - 1.0 / DK_OFFSET_FALLBACK_STEPS));
+
+			addLine(out, prev, p, dot(sub(p, prev), chord) < 0);
+			prev = p;
+		}
+	}
+}
+
+static void offsetSegment(DKOffsetSegmentList* out, const DKOffsetSegment* src, CGFloat sign, CGFloat tolerance)
+{
+	CGFloat d0 = src->d0 * sign;
+	CGFloat d1 = src->d1 * sign;
+
+	if (src->isLine) {
+		NSPoint n = normal(unitVector(sub(src->p[3], src->p[0])));
+		NSPoint a = addScaled(src->p[0], n, d0);
+		NSPoint b = addScaled(src->p[3], n, d1);
+
+		addLine(out, a, b, dot(sub(b, a), sub(src->p[3], src->p[0])) < 0);
+	} else
+		offsetCurve(out, src->p, d0, d1, tolerance, 0);
+}
+
+#pragma mark - joins and caps
+
+static void addArc(DKOffsetSegmentList* out, NSPoint centre, CGFloat radius, CGFloat startAngle, CGFloat sweep)
+{
+	// approximates the arc with one curve per quarter turn or part thereof
+
+	NSUInteger i, n = MAX(1, (NSUInteger)ceil(fabs(sweep) / M_PI_2 - 1e-6));
+	CGFloat step = sweep / n;
+	CGFloat k = (4.0 / 3.0) * tan(step / 4.0) * radius;
+	CGFloat a = startAngle;
+
+	for (i = 0; i < n; ++i) {
+		CGFloat b = a + step;
+		NSPoint q[4];
+
+		q[0] = NSMakePoint(centre.x + radius * cos(a), centre.y + radius * sin(a));
+		q[3] = NSMakePoint(centre.x + radius * cos(b), centre.y + radius * sin(b));
+		q[1] = NSMakePoint(q[0].x - k * sin(a), q[0].y + k * cos(a));
+		q[2] = NSMakePoint(q[3].x + k * sin(b), q[3].y - k * cos(b));
+
+		addCurve(out, q, NO);
+		a = b;
+	}
+}
+
+static void addJoin(DKOffsetSegmentList* out, const DKOffsetSegment* prev, const DKOffsetSegment* next, CGFloat sign, NSLineJoinStyle join, CGFloat miterLimit)
+{
+	NSPoint v = next->p[0];
+	CGFloat d = next->d0 * sign;
+	NSPoint tin = endTangent(prev->p);
+	NSPoint tout = startTangent(next->p);
+	NSPoint a = addScaled(v, normal(tin), d);
+	NSPoint b = addScaled(v, normal(tout), d);
+	CGFloat turn = cross(tin, tout);
+	CGFloat cosTurn = dot(tin, tout);
+
+	if (distance(a, b) < DK_OFFSET_EPSILON)
+		return;
+
+	// on the inside of the bend the offsets overlap. Connect them directly; the loop this makes is removed later.
+
+	if (turn * d > 0) {
+		addLine(out, a, b, YES);
+		return;
+	}
+
+	switch (join) {
+	case NSRoundLineJoinStyle:
+		addArc(out, v, fabs(d), atan2(a.y - v.y, a.x - v.x), atan2(turn, cosTurn));
+		break;
+
+	case NSMiterLineJoinStyle:
+		// the miter length relative to the line width is 1 / cos(turn / 2)
+
+		if (sqrt(0.5 * (1.0 + cosTurn)) * miterLimit >= 1.0) {
+			NSPoint n = NSMakePoint(normal(tin).x + normal(tout).x, normal(tin).y + normal(tout).y);
+			NSPoint m = addScaled(v, n, d / (1.0 + cosTurn));
+
+			addLine(out, a, m, NO);
+			addLine(out, m, b, NO);
+			break;
+		}
+	// else fall through to bevel
+
+	default:
+		addLine(out, a, b, NO);
+		break;
+	}
+}
+
+static void addCap(DKOffsetSegmentList* out, NSPoint p, NSPoint t, CGFloat halfWidth, NSLineCapStyle cap)
+{
+	// goes around the end of the stroke at <p>, facing in direction <t>, from its left edge to its right edge
+
+	if (halfWidth <= DK_OFFSET_EPSILON)
+		return;
+
+	NSPoint n = normal(t);
+	NSPoint a = addScaled(p, n, halfWidth);
+	NSPoint b = addScaled(p, n, -halfWidth);
+
+	switch (cap) {
+	case NSRoundLineCapStyle:
+		addArc(out, p, halfWidth, atan2(n.y, n.x), -M_PI);
+		break;
+
+	case NSSquareLineCapStyle: {
+		NSPoint ae = addScaled(a, t, halfWidth);
+		NSPoint be = addScaled(b, t, halfWidth);
+
+		addLine(out, a, ae, NO);
+		addLine(out, ae, be, NO);
+		addLine(out, be, b, NO);
+	} break;
+
+	default:
+		addLine(out, a, b, NO);
+		break;
+	}
+}
+
+#pragma mark - loop removal
+
+static NSRect segmentBounds(const NSPoint b[4])
+{
+	CGFloat minx = MIN(MIN(b[0].x, b[1].x), MIN(b[2].x, b[3].x));
+	CGFloat maxx = MAX(MAX(b[0].x, b[1].x), MAX(b[2].x, b[3].x));
+	CGFloat miny = MIN(MIN(b[0].y, b[1].y), MIN(b[2].y, b[3].y));
+	CGFloat maxy = MAX(MAX(b[0].y, b[1].y), MAX(b[2].y, b[3].y));
+
+	return NSMakeRect(minx, miny, maxx - minx, maxy - miny);
+}
+
+static BOOL intersectCurves(const NSPoint a[4], CGFloat a0, CGFloat a1, const NSPoint b[4], CGFloat b0, CGFloat b1, CGFloat tolerance, NSUInteger depth, NSInteger* budget, CGFloat* ta, CGFloat* tb)
+{
+	// finds a crossing by subdividing both curves wherever their control hulls overlap. The halves are searched in the order that
+	// finds the crossing nearest the end of <a> and the start of <b> first, which is the one nearest the join between them.
+
+	if (--(*budget) < 0)
+		return NO;
+
+	NSRect ra = segmentBounds(a);
+	NSRect rb = segmentBounds(b);
+
+	if (NSMaxX(ra) < NSMinX(rb) || NSMaxX(rb) < NSMinX(ra) || NSMaxY(ra) < NSMinY(rb) || NSMaxY(rb) < NSMinY(ra))
+		return NO;
+
+	CGFloat size = MAX(MAX(NSWidth(ra), NSHeight(ra)), MAX(NSWidth(rb), NSHeight(rb)));
+
+	if (size < tolerance * 0.05 || depth >= DK_INTERSECT_MAX_DEPTH) {
+		*ta = 0.5 * (a0 + a1);
+		*tb = 0.5 * (b0 + b1);
+		return YES;
+	}
+
+	NSPoint al[4], ar[4], bl[4], br[4];
+	CGFloat am = 0.5 * (a0 + a1);
+	CGFloat bm = 0.5 * (b0 + b1);
+
+	subdivideBezierAtT(a, al, ar, 0.5);
+	subdivideBezierAtT(b, bl, br, 0.5);
+
+	return intersectCurves(ar, am, a1, bl, b0, bm, tolerance, depth + 1, budget, ta, tb)
+		|| intersectCurves(ar, am, a1, br, bm, b1, tolerance, depth + 1, budget, ta, tb)
+		|| intersectCurves(al, a0, am, bl, b0, bm, tolerance, depth + 1, budget, ta, tb)
+		|| intersectCurves(al, a0, am, br, bm, b1, tolerance, depth + 1, budget, ta, tb);
+}
+
+static BOOL intersectSegments(const DKOffsetSegment* a, const DKOffsetSegment* b, CGFloat tolerance, CGFloat* ta, CGFloat* tb)
+{
+	if (a->isLine && b->isLine) {
+		NSPoint u = sub(a->p[3], a->p[0]);
+		NSPoint v = sub(b->p[3], b->p[0]);
+		CGFloat den = cross(u, v);
+
+		if (fabs(den) < DK_OFFSET_EPSILON)
+			return NO;
+
+		NSPoint w = sub(b->p[0], a->p[0]);
+
+		*ta = cross(w, v) / den;
+		*tb = cross(w, u) / den;
+
+		return (*ta >= 0.0 && *ta <= 1.0 && *tb >= 0.0 && *tb <= 1.0);
+	}
+
+	NSInteger budget = DK_INTERSECT_BUDGET;
+
+	return intersectCurves(a->p, 0.0, 1.0, b->p, 0.0, 1.0, tolerance, 0, &budget, ta, tb);
+}
+
+static void trimSegment(DKOffsetSegment* seg, CGFloat t0, CGFloat t1)
+{
+	if (seg->isLine) {
+		NSPoint a = seg->p[0], b = seg->p[3];
+		NSPoint p0 = addScaled(a, sub(b, a), t0);
+		NSPoint p1 = addScaled(a, sub(b, a), t1);
+
+		seg->p[0] = p0;
+		seg->p[1] = addScaled(p0, sub(p1, p0), 1.0 / 3.0);
+		seg->p[2] = addScaled(p0, sub(p1, p0), 2.0 / 3.0);
+		seg->p[3] = p1;
+	} else {
+		NSPoint left[4], right[4];
+
+		if (t1 < 1.0 && t1 > 0.0) {
+			subdivideBezierAtT(seg->p, left, right, t1);
+			memcpy(seg->p, left, sizeof(left));
+			t0 /= t1;
+		}
+
+		if (t0 > 0.0) {
+			subdivideBezierAtT(seg->p, left, right, t0);
+			memcpy(seg->p, right, sizeof(right));
+		}
+	}
+}
+
+/** @brief A crossing between two segments of an offset, found by the sweep in <code>removeLoops()</code>.
+ */
+typedef struct {
+	NSInteger i, j; // the segments, i < j
+	BOOL isSpent; // used to close a loop, or no longer crossing once its segments were trimmed
+} DKOffsetCrossing;
+
+typedef struct {
+	CGFloat minX;
+	NSInteger index;
+} DKOffsetSweepEntry;
+
+static int compareSweepEntries(const void* a, const void* b)
+{
+	CGFloat ax = ((const DKOffsetSweepEntry*)a)->minX;
+	CGFloat bx = ((const DKOffsetSweepEntry*)b)->minX;
+
+	return (ax < bx) ? -1 : (ax > bx) ? 1 : 0;
+}
+
+static DKOffsetCrossing* findCrossings(const DKOffsetSegmentList* list, BOOL closed, CGFloat tolerance, NSUInteger* count)
+{
+	// sweeps the segments' bounds in order of their left edges, so only segments whose bounds overlap are tested against each other.
+	// Neighbouring segments share an end point and are not counted as crossing.
+
+	NSInteger n = list->count;
+	NSInteger k, m;
+	NSRect* bounds = malloc(MAX(n, 1) * sizeof(NSRect));
+	DKOffsetSweepEntry* order = malloc(MAX(n, 1) * sizeof(DKOffsetSweepEntry));
+	DKOffsetCrossing* crossings = NULL;
+	NSUInteger capacity = 0;
+
+	*count = 0;
+
+	for (k = 0; k < n; ++k) {
+		bounds[k] = segmentBounds(list->items[k].p);
+		order[k].minX = NSMinX(bounds[k]);
+		order[k].index = k;
+	}
+
+	qsort(order, n, sizeof(DKOffsetSweepEntry), compareSweepEntries);
+
+	for (k = 0; k < n; ++k) {
+		NSInteger a = order[k].index;
+		NSRect ra = bounds[a];
+
+		for (m = k + 1; m < n && order[m].minX <= NSMaxX(ra); ++m) {
+			NSInteger b = order[m].index;
+			NSInteger i = MIN(a, b), j = MAX(a, b);
+			NSRect rb = bounds[b];
+			CGFloat ta, tb;
+
+			if (NSMaxY(ra) < NSMinY(rb) || NSMaxY(rb) < NSMinY(ra))
+				continue;
+
+			if (j - i < 2 || (closed && i == 0 && j == n - 1))
+				continue;
+
+			if (!intersectSegments(&list->items[i], &list->items[j], tolerance, &ta, &tb))
+				continue;
+
+			if (*count == capacity) {
+				capacity = MAX(16, capacity * 2);
+				crossings = reallocf(crossings, capacity * sizeof(DKOffsetCrossing));
+			}
+
+			crossings[*count].i = i;
+			crossings[*count].j = j;
+			crossings[*count].isSpent = NO;
+			++(*count);
+		}
+	}
+
+	free(bounds);
+	free(order);
+
+	return crossings;
+}
+
+static void removeLoops(DKOffsetSegmentList* list, BOOL closed, CGFloat tolerance)
+{
+	// at each connector, find the nearest crossing between a segment before it and a segment after it. The crossing closes a loop,
+	// so both are trimmed to it and everything in between is deleted. The crossings are found for the whole offset at once, so a loop
+	// is removed however many segments it spans - where a path folds back on itself the crossing can be a long way from the join that
+	// made the loop. "Nearest" counts the segments in the loop; for a closed path a loop may run through the end back to the start.
+
+	NSInteger n = list->count;
+	NSInteger c, k;
+	NSUInteger q, crossingCount;
+	DKOffsetSegment* segs = list->items;
+	DKOffsetCrossing* crossings = findCrossings(list, closed, tolerance, &crossingCount);
+
+	for (c = 0; c < n && crossingCount > 0; ++c) {
+		if (!segs[c].isConnector || segs[c].isDeleted)
+			continue;
+
+		for (;;) {
+			DKOffsetCrossing* nearest = NULL;
+			NSInteger before = 0, after = 0, nearestSpan = n;
+			CGFloat ta, tb;
+
+			for (q = 0; q < crossingCount; ++q) {
+				DKOffsetCrossing* x = &crossings[q];
+				NSInteger span, first, second;
+
+				if (x->isSpent || segs[x->i].isDeleted || segs[x->j].isDeleted)
+					continue;
+
+				if (x->i < c && c < x->j) {
+					span = x->j - x->i;
+					first = x->i;
+					second = x->j;
+				} else if (closed && (c < x->i || c > x->j)) {
+					span = n - (x->j - x->i);
+					first = x->j;
+					second = x->i;
+				} else
+					continue;
+
+				if (span < nearestSpan) {
+					nearest = x;
+					nearestSpan = span;
+					before = first;
+					after = second;
+				}
+			}
+
+			if (nearest == NULL)
+				break;
+
+			// earlier trimming may have moved the segments apart, so the crossing is found again on them as they are now
+
+			nearest->isSpent = YES;
+
+			if (intersectSegments(&segs[before], &segs[after], tolerance, &ta, &tb)) {
+				trimSegment(&segs[before], 0.0, ta);
+				trimSegment(&segs[after], tb, 1.0);
+
+				for (k = (before + 1) % n; k != after; k = (k + 1) % n)
+					segs[k].isDeleted = YES;
+
+				break;
+			}
+		}
+	}
+
+	free(crossings);
+}
+
+#pragma mark - building the result
+
+static BOOL emitSegments(DKFlatPath* out, const DKOffsetSegmentList* list, BOOL reversed, BOOL startSubpath, NSPoint* currentPoint)
+{
+	// returns YES if anything was added
+
+	NSInteger k, n = list->count;
+	BOOL emitted = NO;
+
+	for (k = 0; k < n; ++k) {
+		const DKOffsetSegment* seg = &list->items[reversed ? n - 1 - k : k];
+
+		if (seg->isDeleted)
+			continue;
+
+		NSPoint p0 = reversed ? seg->p[3] : seg->p[0];
+		NSPoint p1 = reversed ? seg->p[2] : seg->p[1];
+		NSPoint p2 = reversed ? seg->p[1] : seg->p[2];
+		NSPoint p3 = reversed ? seg->p[0] : seg->p[3];
+
+		if (startSubpath) {
+			[out moveToPoint:p0];
+			startSubpath = NO;
+		} else if (distance(*currentPoint, p0) > DK_OFFSET_EPSILON)
+			[out lineToPoint:p0];
+
+		if (seg->isLine)
+			[out lineToPoint:p3];
+		else
+			[out curveToPoint:p3
+				controlPoint1:p1
+				controlPoint2:p2];
+
+		*currentPoint = p3;
+		emitted = YES;
+	}
+
+	return emitted;
+}
+
+static void offsetSubpath(DKOffsetSegmentList* out, const DKOffsetSegmentList* src, BOOL closed, CGFloat sign, NSLineJoinStyle join, CGFloat miterLimit, CGFloat tolerance)
+{
+	NSUInteger k;
+
+	out->count = 0;
+
+	for (k = 0; k < src->count; ++k) {
+		if (k > 0)
+			addJoin(out, &src->items[k - 1], &src->items[k], sign, join, miterLimit);
+
+		offsetSegment(out, &src->items[k], sign, tolerance);
+	}
+
+	if (closed && src->count > 1)
+		addJoin(out, &src->items[src->count - 1], &src->items[0], sign, join, miterLimit);
+
+	removeLoops(out, closed, tolerance);
+}
+
+#pragma mark -
+
+@implementation DKFlatPath (Offset)
+
+/** @brief Collect the segments of the subpath starting at element <start>, skipping any of zero length, along with the offset at each end.
+
+ Returns the index of the first element of the next subpath.
+ */
+- (NSUInteger)gatherSubpathFromElement:(NSUInteger)start into:(DKOffsetSegmentList*)list closed:(BOOL*)closed distance:(CGFloat*)s ofLength:(CGFloat)length startOffset:(CGFloat)startOffset endOffset:(CGFloat)endOffset tolerance:(CGFloat)tolerance
+{
+	const NSBezierPathElement* types = [self elementTypes];
+	const NSUInteger* pi = [self pointIndexes];
+	const NSPoint* pts = [self points];
+	NSUInteger i, ec = [self elementCount];
+	CGFloat ramp = (length > 0) ? (endOffset - startOffset) / length : 0;
+
+	list->count = 0;
+	*closed = NO;
+
+	i = (start == 0 || types[start] == NSMoveToBezierPathElement) ? start + 1 : start;
+
+	for (; i < ec; ++i) {
+		NSBezierPathElement type = types[i];
+
+		if (type == NSMoveToBezierPathElement)
+			return i;
+
+		CGFloat len = [self lengthOfElement:i
+							   maximumError:tolerance];
+
+		if (len > DK_OFFSET_EPSILON) {
+			DKOffsetSegment* seg;
+
+			if (type == NSCurveToBezierPathElement) {
+				seg = addSegment(list);
+				memcpy(seg->p, pts + pi[i] - 1, sizeof(seg->p));
+			} else {
+				addLine(list, pts[pi[i] - 1], pts[pi[i]], NO);
+				seg = &list->items[list->count - 1];
+			}
+
+			seg->d0 = startOffset + ramp * *s;
+			seg->d1 = startOffset + ramp * (*s + len);
+		}
+
+		*s += len;
+
+		if (type == NSClosePathBezierPathElement) {
+			*closed = YES;
+			return i + 1;
+		}
+	}
+
+	return i;
+}
+
+- (DKFlatPath*)flatPathByOffsettingFrom:(CGFloat)startOffset to:(CGFloat)endOffset lineJoinStyle:(NSLineJoinStyle)join miterLimit:(CGFloat)miterLimit tolerance:(CGFloat)tolerance
+{
+	DKFlatPath* result = [[DKFlatPath alloc] initWithElementCapacity:[self elementCount]];
+	DKOffsetSegmentList src = { 0 }, offset = { 0 };
+	CGFloat length = (startOffset != endOffset) ? [self lengthWithMaximumError:tolerance] : 0.0;
+	CGFloat s = 0.0;
+	NSUInteger i = 0, ec = [self elementCount];
+	BOOL closed;
+
+	[result setWindingRule:[self windingRule]];
+
+	while (i < ec) {
+		i = [self gatherSubpathFromElement:i
+									  into:&src
+									closed:&closed
+								  distance:&s
+								  ofLength:length
+							   startOffset:startOffset
+								 endOffset:endOffset
+								 tolerance:tolerance];
+
+		if (src.count > 0) {
+			NSPoint cp;
+
+			offsetSubpath(&offset, &src, closed, 1.0, join, miterLimit, tolerance);
+
+			if (emitSegments(result, &offset, NO, YES, &cp) && closed)
+				[result closePath];
+		}
+	}
+
+	free(src.items);
+	free(offset.items);
+
+	return result;
+}
+
+- (DKFlatPath*)strokeOutlineWithStartWidth:(CGFloat)startWidth endWidth:(CGFloat)endWidth lineJoinStyle:(NSLineJoinStyle)join lineCapStyle:(NSLineCapStyle)cap miterLimit:(CGFloat)miterLimit tolerance:(CGFloat)tolerance
+{
+	DKFlatPath* result = [[DKFlatPath alloc] initWithElementCapacity:[self elementCount] * 2];
+	DKOffsetSegmentList src = { 0 }, left = { 0 }, right = { 0 }, caps = { 0 };
+	CGFloat length = (startWidth != endWidth) ? [self lengthWithMaximumError:tolerance] : 0.0;
+	CGFloat s = 0.0;
+	NSUInteger i = 0, ec = [self elementCount];
+	BOOL closed;
+
+	[result setWindingRule:NSNonZeroWindingRule];
+
+	while (i < ec) {
+		i = [self gatherSubpathFromElement:i
+									  into:&src
+									closed:&closed
+								  distance:&s
+								  ofLength:length
+							   startOffset:startWidth * 0.5
+								 endOffset:endWidth * 0.5
+								 tolerance:tolerance];
+
+		if (src.count == 0)
+			continue;
+
+		NSPoint cp;
+
+		offsetSubpath(&left, &src, closed, 1.0, join, miterLimit, tolerance);
+		offsetSubpath(&right, &src, closed, -1.0, join, miterLimit, tolerance);
+
+		if (closed) {
+			// two contours in opposite directions, so the area between them is filled and the area inside the inner one is not
+
+			if (emitSegments(result, &left, NO, YES, &cp))
+				[result closePath];
+
+			if (emitSegments(result, &right, YES, YES, &cp))
+				[result closePath];
+		} else {
+			// one contour: along the left edge, around the end cap, back along the right edge and around the start cap
+
+			const DKOffsetSegment* first = &src.items[0];
+			const DKOffsetSegment* last = &src.items[src.count - 1];
+			NSPoint t0 = startTangent(first->p);
+
+			if (!emitSegments(result, &left, NO, YES, &cp))
+				continue;
+
+			caps.count = 0;
+			addCap(&caps, last->p[3], endTangent(last->p), last->d1, cap);
+			emitSegments(result, &caps, NO, NO, &cp);
+
+			emitSegments(result, &right, YES, NO, &cp);
+
+			caps.count = 0;
+			addCap(&caps, first->p[0], NSMakePoint(-t0.x, -t0.y), first->d0, cap);
+			emitSegments(result, &caps, NO, NO, &cp);
+
+			[result closePath];
+		}
+	}
+
+	free(src.items);
+	free(left.items);
+	free(right.items);
+	free(caps.items);
+
+	return result;
+}
+
+@end
@@ -0,0 +1,143 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief A compact, contiguous copy of a path's geometry that DrawKit's path algorithms can work on directly.
+
+ NSBezierPath only hands out its points one element at a time, and building a path costs a message send per element. DKFlatPath keeps
+ the element types in one array and all of the points in a single contiguous array of \c NSPoint (double precision on all supported
+ architectures), so loops over a path are plain C with no copying.
+
+ Every element stores its end point last, and a close path element stores the point it closes to (the start of its subpath). The point
+ preceding an element's first point is therefore always its start point, which means that the four control points of a curve element
+ are simply <code>points + pointIndexes[i] - 1</code>, and a line or close element runs from <code>points[pointIndexes[i] - 1]</code> to
+ <code>points[pointIndexes[i]]</code>. Algorithms can pass these pointers straight to bezier routines without assembling temporary arrays.
+
+ Conversion to and from NSBezierPath happens once, at the boundary. Pointers returned by the accessors belong to the receiver and are only
+ valid until it is next mutated.
+ */
+@interface DKFlatPath : NSObject <NSCopying> {
+@private
+	NSBezierPathElement* mTypes;
+	NSUInteger* mPointIndexes;
+	NSPoint* mPoints;
+	NSUInteger mElementCount;
+	NSUInteger mElementCapacity;
+	NSUInteger mPointCount;
+	NSUInteger mPointCapacity;
+	NSUInteger mSubpathStart;
+	NSWindingRule mWindingRule;
+}
+
++ (DKFlatPath*)flatPathWithBezierPath:(NSBezierPath*)path;
+
+- (instancetype)init;
+/** @brief Initialize an empty path with room for \c capacity elements without reallocating.
+ */
+- (instancetype)initWithElementCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+/** @brief Initialize with the elements of \c path, read in a single pass.
+ */
+- (instancetype)initWithBezierPath:(NSBezierPath*)path;
+
+/** @brief Return a new NSBezierPath with the same elements and winding rule as the receiver.
+ */
+- (NSBezierPath*)bezierPath;
+/** @brief Append the receiver's elements to an existing NSBezierPath.
+ */
+- (void)appendToBezierPath:(NSBezierPath*)path;
+
+@property (readonly) NSUInteger elementCount;
+@property (readonly) NSUInteger pointCount;
+@property (nonatomic) NSWindingRule windingRule;
+@property (readonly, getter=isEmpty) BOOL empty;
+
+/** @brief The element types, one per element.
+ */
+@property (readonly) const NSBezierPathElement* elementTypes NS_RETURNS_INNER_POINTER;
+/** @brief The index into \c points of each element's first point.
+ */
+@property (readonly) const NSUInteger* pointIndexes NS_RETURNS_INNER_POINTER;
+/** @brief All of the points in the path, in element order.
+ */
+@property (readonly) const NSPoint* points NS_RETURNS_INNER_POINTER;
+
+/** @brief Return the type of element \c i and a pointer to its points.
+
+ The pointer addresses one point for a move, line or close path element and three (cp1, cp2, end point) for a curve.
+ */
+- (NSBezierPathElement)elementAtIndex:(NSUInteger)i points:(const NSPoint* _Nullable* _Nullable)points;
+/** @brief Return the point element \c i starts from, i.e. the end point of the previous element.
+
+ For the first element this is its own first point.
+ */
+- (NSPoint)startPointOfElement:(NSUInteger)i;
+- (NSPoint)endPointOfElement:(NSUInteger)i;
+
+// building
+
+- (void)moveToPoint:(NSPoint)p;
+- (void)lineToPoint:(NSPoint)p;
+- (void)curveToPoint:(NSPoint)p controlPoint1:(NSPoint)cp1 controlPoint2:(NSPoint)cp2;
+- (void)closePath;
+- (void)removeAllPoints;
+
+// geometry
+
+/** @brief Return the length of element \c i, approximating curves to within \c maxError.
+
+ Move elements have zero length.
+ */
+- (CGFloat)lengthOfElement:(NSUInteger)i maximumError:(CGFloat)maxError;
+- (CGFloat)lengthWithMaximumError:(CGFloat)maxError;
+
+/** @brief Return a path that is the first \c trimLength units of the receiver.
+ */
+- (DKFlatPath*)flatPathByTrimmingToLength:(CGFloat)trimLength maximumError:(CGFloat)maxError;
+/** @brief Return a path that is the receiver with the first \c trimLength units removed.
+ */
+- (DKFlatPath*)flatPathByTrimmingFromLength:(CGFloat)trimLength maximumError:(CGFloat)maxError;
+
+/** @brief Find the point and slope at regular distances along the path, in a single pass.
+
+ Samples are taken at 0, \c interval, 2 * \c interval and so on for as long as they lie on the path, giving the same point and slope
+ that -[NSBezierPath pointOnPathAtLength:slope:] would for each distance, without trimming the path afresh for every one.
+ @param points receives the sampled points
+ @param slopes if not NULL, receives the slope of the path at each point, in radians
+ @param distances if not NULL, receives the distance of each point from the start of the path
+ @param interval the distance between samples, which must be positive
+ @param maxCount the capacity of the buffers
+ @param maxError the accuracy with which curves are measured
+ @return the number of samples written, never more than <code>maxCount</code>
+ */
+- (NSUInteger)getPoints:(NSPoint*)points slopes:(nullable CGFloat*)slopes distances:(nullable CGFloat*)distances atInterval:(CGFloat)interval maximumCount:(NSUInteger)maxCount maximumError:(CGFloat)maxError;
+/** @brief Find the point and slope at each of a list of distances along the path, in a single pass.
+
+ The distances should be in ascending order, except that any distance of 0 or less (the start of the path) may appear anywhere.
+ Distances beyond the end of the path give its end point, as -[NSBezierPath pointOnPathAtLength:slope:] does.
+ @param points receives one point for each distance
+ @param slopes if not NULL, receives the slope of the path at each point, in radians
+ @param distances the distances from the start of the path
+ @param count the number of distances
+ @param maxError the accuracy with which curves are measured
+ */
+- (void)getPoints:(NSPoint*)points slopes:(nullable CGFloat*)slopes atDistances:(const CGFloat*)distances count:(NSUInteger)count maximumError:(CGFloat)maxError;
+
+@end
+
+/** @brief Return the length of the cubic bezier <code>bez</code>, to within \c maxError.
+ */
+extern CGFloat DKLengthOfBezier(const NSPoint bez[_Nonnull 4], CGFloat maxError);
+
+/** @brief Split the cubic bezier \c bez into \c bez1 and \c bez2 such that \c bez1 is \c length units long, to within <code>maxError</code>.
+
+ Returns the actual length of <code>bez1</code>.
+ */
+extern CGFloat DKSubdivideBezierAtLength(const NSPoint bez[_Nonnull 4], NSPoint bez1[_Nonnull 4], NSPoint bez2[_Nonnull 4], CGFloat length, CGFloat maxError);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,611 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKFlatPath.h"
+#import "DKGeometryUtilities.h"
+#import "NSBezierPath+Geometry.h"
+
+#pragma mark Static Functions
+
+static inline CGFloat distanceBetween(NSPoint a, NSPoint b)
+{
+	return hypot(a.x - b.x, a.y - b.y);
+}
+
+static inline NSPoint interpolatedPoint(NSPoint a, NSPoint b, CGFloat f)
+{
+	return NSMakePoint(a.x + f * (b.x - a.x), a.y + f * (b.y - a.y));
+}
+
+inline static void subdivideBezier(const NSPoint bez[4], NSPoint bez1[4], NSPoint bez2[4])
+{
+	NSPoint q;
+
+	bez1[0].x = bez[0].x;
+	bez1[0].y = bez[0].y;
+	bez2[3].x = bez[3].x;
+	bez2[3].y = bez[3].y;
+
+	q.x = (bez[1].x + bez[2].x) / 2.0;
+	q.y = (bez[1].y + bez[2].y) / 2.0;
+	bez1[1].x = (bez[0].x + bez[1].x) / 2.0;
+	bez1[1].y = (bez[0].y + bez[1].y) / 2.0;
+	bez2[2].x = (bez[2].x + bez[3].x) / 2.0;
+	bez2[2].y = (bez[2].y + bez[3].y) / 2.0;
+
+	bez1[2].x = (bez1[1].x + q.x) / 2.0;
+	bez1[2].y = (bez1[1].y + q.y) / 2.0;
+	bez2[1].x = (q.x + bez2[2].x) / 2.0;
+	bez2[1].y = (q.y + bez2[2].y) / 2.0;
+
+	bez1[3].x = bez2[0].x = (bez1[2].x + bez2[1].x) / 2.0;
+	bez1[3].y = bez2[0].y = (bez1[2].y + bez2[1].y) / 2.0;
+}
+
+CGFloat DKLengthOfBezier(const NSPoint bez[4], CGFloat maxError)
+{
+	CGFloat polyLen = 0.0;
+	CGFloat chordLen = distanceBetween(bez[0], bez[3]);
+	CGFloat retLen, errLen;
+	NSUInteger n;
+
+	for (n = 0; n < 3; ++n)
+		polyLen += distanceBetween(bez[n], bez[n + 1]);
+
+	errLen = polyLen - chordLen;
+
+	if (errLen > maxError) {
+		NSPoint left[4], right[4];
+		subdivideBezier(bez, left, right);
+		retLen = (DKLengthOfBezier(left, maxError)
+			+ DKLengthOfBezier(right, maxError));
+	} else {
+		retLen = 0.5 * (polyLen + chordLen);
+	}
+
+	return retLen;
+}
+
+CGFloat DKSubdivideBezierAtLength(const NSPoint bez[4], NSPoint bez1[4], NSPoint bez2[4], CGFloat length, CGFloat maxError)
+{
+	CGFloat top = 1.0, bottom = 0.0;
+	CGFloat t, prevT;
+
+	prevT = t = 0.5;
+	for (;;) {
+		CGFloat len1;
+
+		subdivideBezierAtT(bez, bez1, bez2, t);
+
+		len1 = DKLengthOfBezier(bez1, 0.5 * maxError);
+
+		if (fabs(length - len1) < maxError)
+			return len1;
+
+		if (length > len1) {
+			bottom = t;
+			t = 0.5 * (t + top);
+		} else if (length < len1) {
+			top = t;
+			t = 0.5 * (bottom + t);
+		}
+
+		if (t == prevT)
+			return len1;
+
+		prevT = t;
+	}
+}
+
+#pragma mark -
+
+@implementation DKFlatPath
+
+// element building is done by these functions rather than the equivalent methods so that the loops that copy or generate whole paths
+// don't pay for a message send per element.
+
+static void reserve(DKFlatPath* fp, NSUInteger elements, NSUInteger points)
+{
+	if (fp->mElementCount + elements > fp->mElementCapacity) {
+		fp->mElementCapacity = MAX(fp->mElementCount + elements, fp->mElementCapacity * 2);
+		fp->mTypes = reallocf(fp->mTypes, fp->mElementCapacity * sizeof(NSBezierPathElement));
+		fp->mPointIndexes = reallocf(fp->mPointIndexes, fp->mElementCapacity * sizeof(NSUInteger));
+	}
+
+	if (fp->mPointCount + points > fp->mPointCapacity) {
+		fp->mPointCapacity = MAX(fp->mPointCount + points, fp->mPointCapacity * 2);
+		fp->mPoints = reallocf(fp->mPoints, fp->mPointCapacity * sizeof(NSPoint));
+	}
+}
+
+static void appendElement(DKFlatPath* fp, NSBezierPathElement type, const NSPoint* pts, NSUInteger count)
+{
+	reserve(fp, 1, count);
+
+	fp->mTypes[fp->mElementCount] = type;
+	fp->mPointIndexes[fp->mElementCount++] = fp->mPointCount;
+	memcpy(fp->mPoints + fp->mPointCount, pts, count * sizeof(NSPoint));
+	fp->mPointCount += count;
+}
+
+static inline void appendMoveTo(DKFlatPath* fp, NSPoint p)
+{
+	fp->mSubpathStart = fp->mPointCount;
+	appendElement(fp, NSMoveToBezierPathElement, &p, 1);
+}
+
+static inline void appendLineTo(DKFlatPath* fp, NSPoint p)
+{
+	NSCAssert(fp->mPointCount > 0, @"no current point for line");
+	appendElement(fp, NSLineToBezierPathElement, &p, 1);
+}
+
+static inline void appendCurveTo(DKFlatPath* fp, NSPoint cp1, NSPoint cp2, NSPoint p)
+{
+	NSCAssert(fp->mPointCount > 0, @"no current point for curve");
+
+	NSPoint pts[3] = { cp1, cp2, p };
+	appendElement(fp, NSCurveToBezierPathElement, pts, 3);
+}
+
+static inline void appendClosePath(DKFlatPath* fp)
+{
+	if (fp->mPointCount > 0) {
+		NSPoint p = fp->mPoints[fp->mSubpathStart];
+		appendElement(fp, NSClosePathBezierPathElement, &p, 1);
+	}
+}
+
++ (DKFlatPath*)flatPathWithBezierPath:(NSBezierPath*)path
+{
+	return [[self alloc] initWithBezierPath:path];
+}
+
+- (instancetype)init
+{
+	return [self initWithElementCapacity:0];
+}
+
+- (instancetype)initWithElementCapacity:(NSUInteger)capacity
+{
+	self = [super init];
+	if (self) {
+		mWindingRule = NSNonZeroWindingRule;
+		reserve(self, MAX(capacity, 4), MAX(capacity, 4) * 2);
+	}
+
+	return self;
+}
+
+- (instancetype)initWithBezierPath:(NSBezierPath*)path
+{
+	NSInteger i, ec = [path elementCount];
+
+	self = [self initWithElementCapacity:ec];
+	if (self) {
+		mWindingRule = [path windingRule];
+
+		// this is the only place the Cocoa path is read; caching the IMP keeps it to one function call per element
+
+		SEL sel = @selector(elementAtIndex:associatedPoints:);
+		NSBezierPathElement (*elementAtIndex)(id, SEL, NSInteger, NSPointArray) = (NSBezierPathElement(*)(id, SEL, NSInteger, NSPointArray))[path methodForSelector:sel];
+		NSPoint ap[3];
+
+		for (i = 0; i < ec; ++i) {
+			switch (elementAtIndex(path, sel, i, ap)) {
+			case NSMoveToBezierPathElement:
+				appendMoveTo(self, ap[0]);
+				break;
+
+			case NSLineToBezierPathElement:
+				appendLineTo(self, ap[0]);
+				break;
+
+			case NSCurveToBezierPathElement:
+				appendCurveTo(self, ap[0], ap[1], ap[2]);
+				break;
+
+			case NSClosePathBezierPathElement:
+				appendClosePath(self);
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	free(mTypes);
+	free(mPointIndexes);
+	free(mPoints);
+}
+
+- (NSBezierPath*)bezierPath
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	[path setWindingRule:[self windingRule]];
+	[self appendToBezierPath:path];
+
+	return path;
+}
+
+- (void)appendToBezierPath:(NSBezierPath*)path
+{
+	SEL moveSel = @selector(moveToPoint:);
+	SEL lineSel = @selector(lineToPoint:);
+	SEL curveSel = @selector(curveToPoint:controlPoint1:controlPoint2:);
+	void (*moveTo)(id, SEL, NSPoint) = (void (*)(id, SEL, NSPoint))[path methodForSelector:moveSel];
+	void (*lineTo)(id, SEL, NSPoint) = (void (*)(id, SEL, NSPoint))[path methodForSelector:lineSel];
+	void (*curveTo)(id, SEL, NSPoint, NSPoint, NSPoint) = (void (*)(id, SEL, NSPoint, NSPoint, NSPoint))[path methodForSelector:curveSel];
+	NSUInteger i;
+
+	for (i = 0; i < mElementCount; ++i) {
+		const NSPoint* p = mPoints + mPointIndexes[i];
+
+		switch (mTypes[i]) {
+		case NSMoveToBezierPathElement:
+			moveTo(path, moveSel, p[0]);
+			break;
+
+		case NSLineToBezierPathElement:
+			lineTo(path, lineSel, p[0]);
+			break;
+
+		case NSCurveToBezierPathElement:
+			curveTo(path, curveSel, p[2], p[0], p[1]);
+			break;
+
+		case NSClosePathBezierPathElement:
+			[path closePath];
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+- (id)copyWithZone:(NSZone*)zone
+{
+	DKFlatPath* copy = [[[self class] allocWithZone:zone] initWithElementCapacity:mElementCount];
+
+	reserve(copy, mElementCount, mPointCount);
+	memcpy(copy->mTypes, mTypes, mElementCount * sizeof(NSBezierPathElement));
+	memcpy(copy->mPointIndexes, mPointIndexes, mElementCount * sizeof(NSUInteger));
+	memcpy(copy->mPoints, mPoints, mPointCount * sizeof(NSPoint));
+	copy->mElementCount = mElementCount;
+	copy->mPointCount = mPointCount;
+	copy->mSubpathStart = mSubpathStart;
+	copy->mWindingRule = mWindingRule;
+
+	return copy;
+}
+
+#pragma mark -
+
+@synthesize elementCount = mElementCount;
+@synthesize pointCount = mPointCount;
+@synthesize windingRule = mWindingRule;
+
+- (BOOL)isEmpty
+{
+	return mElementCount == 0;
+}
+
+- (const NSBezierPathElement*)elementTypes
+{
+	return mTypes;
+}
+
+- (const NSUInteger*)pointIndexes
+{
+	return mPointIndexes;
+}
+
+- (const NSPoint*)points
+{
+	return mPoints;
+}
+
+- (NSBezierPathElement)elementAtIndex:(NSUInteger)i points:(const NSPoint**)points
+{
+	NSAssert(i < mElementCount, @"element index %lu out of range", (unsigned long)i);
+
+	if (points)
+		*points = mPoints + mPointIndexes[i];
+
+	return mTypes[i];
+}
+
+- (NSPoint)startPointOfElement:(NSUInteger)i
+{
+	NSAssert(i < mElementCount, @"element index %lu out of range", (unsigned long)i);
+
+	return mPoints[i == 0 ? 0 : mPointIndexes[i] - 1];
+}
+
+- (NSPoint)endPointOfElement:(NSUInteger)i
+{
+	NSAssert(i < mElementCount, @"element index %lu out of range", (unsigned long)i);
+
+	return mPoints[(i + 1 < mElementCount ? mPointIndexes[i + 1] : mPointCount) - 1];
+}
+
+#pragma mark -
+
+- (void)moveToPoint:(NSPoint)p
+{
+	appendMoveTo(self, p);
+}
+
+- (void)lineToPoint:(NSPoint)p
+{
+	appendLineTo(self, p);
+}
+
+- (void)curveToPoint:(NSPoint)p controlPoint1:(NSPoint)cp1 controlPoint2:(NSPoint)cp2
+{
+	appendCurveTo(self, cp1, cp2, p);
+}
+
+- (void)closePath
+{
+	appendClosePath(self);
+}
+
+- (void)removeAllPoints
+{
+	mElementCount = mPointCount = mSubpathStart = 0;
+}
+
+#pragma mark -
+
+static inline CGFloat lengthOfElementAtIndex(DKFlatPath* fp, NSUInteger i, CGFloat maxError)
+{
+	if (i == 0)
+		return 0.0;
+
+	const NSPoint* p = fp->mPoints + fp->mPointIndexes[i];
+
+	switch (fp->mTypes[i]) {
+	case NSLineToBezierPathElement:
+	case NSClosePathBezierPathElement:
+		return distanceBetween(p[-1], p[0]);
+
+	case NSCurveToBezierPathElement:
+		return DKLengthOfBezier(p - 1, maxError);
+
+	default:
+		return 0.0;
+	}
+}
+
+- (CGFloat)lengthOfElement:(NSUInteger)i maximumError:(CGFloat)maxError
+{
+	NSAssert(i < mElementCount, @"element index %lu out of range", (unsigned long)i);
+
+	return lengthOfElementAtIndex(self, i, maxError);
+}
+
+- (CGFloat)lengthWithMaximumError:(CGFloat)maxError
+{
+	CGFloat length = 0.0;
+	NSUInteger i;
+
+	for (i = 1; i < mElementCount; ++i)
+		length += lengthOfElementAtIndex(self, i, maxError);
+
+	return length;
+}
+
+- (DKFlatPath*)flatPathByTrimmingToLength:(CGFloat)trimLength maximumError:(CGFloat)maxError
+{
+	DKFlatPath* newPath = [[DKFlatPath alloc] initWithElementCapacity:mElementCount];
+	CGFloat length = 0.0;
+	NSUInteger i;
+
+	newPath->mWindingRule = mWindingRule;
+
+	for (i = 0; i < mElementCount; ++i) {
+		const NSPoint* p = mPoints + mPointIndexes[i];
+		NSBezierPathElement element = mTypes[i];
+		CGFloat remainingLength = trimLength - length;
+		CGFloat elementLength;
+
+		if (element == NSMoveToBezierPathElement) {
+			appendMoveTo(newPath, p[0]);
+			continue;
+		}
+
+		elementLength = lengthOfElementAtIndex(self, i, maxError);
+
+		if (length + elementLength <= trimLength) {
+			if (element == NSCurveToBezierPathElement)
+				appendCurveTo(newPath, p[0], p[1], p[2]);
+			else if (element == NSLineToBezierPathElement)
+				appendLineTo(newPath, p[0]);
+			else
+				appendClosePath(newPath);
+		} else {
+			if (element == NSCurveToBezierPathElement) {
+				NSPoint bez1[4], bez2[4];
+				DKSubdivideBezierAtLength(p - 1, bez1, bez2, remainingLength, maxError);
+				appendCurveTo(newPath, bez1[1], bez1[2], bez1[3]);
+			} else
+				appendLineTo(newPath, interpolatedPoint(p[-1], p[0], remainingLength / elementLength));
+
+			break;
+		}
+
+		length += elementLength;
+	}
+
+	return newPath;
+}
+
+- (DKFlatPath*)flatPathByTrimmingFromLength:(CGFloat)trimLength maximumError:(CGFloat)maxError
+{
+	DKFlatPath* newPath = [[DKFlatPath alloc] initWithElementCapacity:mElementCount];
+	CGFloat length = 0.0;
+	NSUInteger i;
+
+	newPath->mWindingRule = mWindingRule;
+
+	for (i = 0; i < mElementCount; ++i) {
+		const NSPoint* p = mPoints + mPointIndexes[i];
+		NSBezierPathElement element = mTypes[i];
+		CGFloat remainingLength = trimLength - length;
+		CGFloat elementLength;
+
+		if (element == NSMoveToBezierPathElement) {
+			if (length > trimLength)
+				appendMoveTo(newPath, p[0]);
+			continue;
+		}
+
+		elementLength = lengthOfElementAtIndex(self, i, maxError);
+
+		if (length > trimLength) {
+			if (element == NSCurveToBezierPathElement)
+				appendCurveTo(newPath, p[0], p[1], p[2]);
+			else if (element == NSLineToBezierPathElement)
+				appendLineTo(newPath, p[0]);
+			else {
+				// the subpath's start was trimmed away, so close it explicitly
+
+				appendLineTo(newPath, p[0]);
+				appendClosePath(newPath);
+			}
+		} else if (length + elementLength > trimLength) {
+			if (element == NSCurveToBezierPathElement) {
+				NSPoint bez1[4], bez2[4];
+				DKSubdivideBezierAtLength(p - 1, bez1, bez2, remainingLength, maxError);
+				appendMoveTo(newPath, bez2[0]);
+				appendCurveTo(newPath, bez2[1], bez2[2], bez2[3]);
+			} else {
+				appendMoveTo(newPath, interpolatedPoint(p[-1], p[0], remainingLength / elementLength));
+				appendLineTo(newPath, p[0]);
+			}
+		}
+
+		length += elementLength;
+	}
+
+	return newPath;
+}
+
+static NSUInteger samplePath(DKFlatPath* fp, const CGFloat* targets, CGFloat interval, NSUInteger count, BOOL clampToEnd, NSPoint* points, CGFloat* slopes, CGFloat* distances, CGFloat maxError)
+{
+	// samples are taken at each of <targets>, or at multiples of <interval> if there are none. Either way they are found by walking
+	// the elements once, taking every sample that falls within each one before moving on. A target of 0 or less is the start of the
+	// path, heading towards the first point of the next element, wherever it appears.
+
+	NSUInteger i = 1, n;
+	CGFloat length = 0.0;
+	CGFloat elementLength = lengthOfElementAtIndex(fp, 1, maxError);
+	CGFloat target = -interval;
+
+	for (n = 0; n < count; ++n) {
+		target = targets ? targets[n] : target + interval;
+
+		if (target <= 0.0) {
+			points[n] = fp->mPoints[0];
+
+			if (slopes)
+				slopes[n] = Slope(fp->mPoints[0], fp->mPoints[fp->mPointIndexes[1]]);
+			if (distances)
+				distances[n] = target;
+
+			continue;
+		}
+
+		while (i < fp->mElementCount && (fp->mTypes[i] == NSMoveToBezierPathElement || target > length + elementLength)) {
+			length += elementLength;
+
+			if (++i < fp->mElementCount)
+				elementLength = lengthOfElementAtIndex(fp, i, maxError);
+		}
+
+		if (i >= fp->mElementCount) {
+			// past the end: either stop, or give the end of the last element drawn, as trimming to a greater length would
+
+			if (!clampToEnd)
+				break;
+
+			NSUInteger k = fp->mElementCount - 1;
+
+			while (k > 1 && fp->mTypes[k] == NSMoveToBezierPathElement)
+				--k;
+
+			const NSPoint* p = fp->mPoints + fp->mPointIndexes[k];
+
+			if (fp->mTypes[k] == NSCurveToBezierPathElement) {
+				points[n] = p[2];
+
+				if (slopes)
+					slopes[n] = Slope(p[1], p[2]);
+			} else {
+				points[n] = p[0];
+
+				if (slopes)
+					slopes[n] = Slope(p[-1], p[0]);
+			}
+		} else {
+			const NSPoint* p = fp->mPoints + fp->mPointIndexes[i];
+			CGFloat remainingLength = target - length;
+
+			if (fp->mTypes[i] == NSCurveToBezierPathElement) {
+				NSPoint bez1[4], bez2[4];
+
+				DKSubdivideBezierAtLength(p - 1, bez1, bez2, remainingLength, maxError);
+				points[n] = bez1[3];
+
+				if (slopes)
+					slopes[n] = Slope(bez1[2], bez1[3]);
+			} else {
+				points[n] = (elementLength > 0.0) ? interpolatedPoint(p[-1], p[0], remainingLength / elementLength) : p[0];
+
+				if (slopes)
+					slopes[n] = Slope(p[-1], p[0]);
+			}
+		}
+
+		if (distances)
+			distances[n] = target;
+	}
+
+	return n;
+}
+
+- (NSUInteger)getPoints:(NSPoint*)points slopes:(CGFloat*)slopes distances:(CGFloat*)distances atInterval:(CGFloat)interval maximumCount:(NSUInteger)maxCount maximumError:(CGFloat)maxError
+{
+	NSAssert(interval > 0.0, @"sampling interval must be positive");
+
+	if (mElementCount < 2)
+		return 0;
+
+	return samplePath(self, NULL, interval, maxCount, NO, points, slopes, distances, maxError);
+}
+
+- (void)getPoints:(NSPoint*)points slopes:(CGFloat*)slopes atDistances:(const CGFloat*)distances count:(NSUInteger)count maximumError:(CGFloat)maxError
+{
+	if (mElementCount < 2) {
+		for (NSUInteger n = 0; n < count; ++n) {
+			points[n] = NSZeroPoint;
+
+			if (slopes)
+				slopes[n] = 0.0;
+		}
+	} else
+		samplePath(self, distances, 0.0, count, YES, points, slopes, NULL, maxError);
+}
+
+@end
@@ -0,0 +1,52 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief A table of shared, immutable paths, so that objects with the same geometry can share one path rather than each keeping a copy.
+
+ Most shapes in a drawing are one of a few unit rects, ovals and factory shapes. A shape's unit path is passed through
+ <code>-internedPath:</code> when it is set, which returns the table's path with the same elements and attributes, adding a private copy
+ if there is none yet. Shapes with the same geometry then hold the same path object, so memory grows with the number of distinct
+ geometries rather than the number of shapes, and NSKeyedArchiver, which writes each object once however many times it is referred to,
+ stores each geometry once in a saved drawing.
+
+ A path returned by the table is shared and must never be changed. To edit one, copy it, change the copy and set that - the copy is
+ interned in its turn. The table holds its paths weakly, so a geometry is dropped once nothing uses it. The table may be used from any
+ thread.
+ */
+@interface DKGeometryTable : NSObject {
+@private
+	NSMapTable* mPaths; // geometry key -> shared path, held weakly
+	NSHashTable* mShared; // the shared paths, held weakly, for telling quickly whether a path is already one of them
+	NSUInteger mPurgeThreshold; // size of mPaths at which keys of paths no longer used are removed
+	dispatch_queue_t mQueue; // serialises access to the tables
+}
+
+/** @brief Return the table shared by all shapes.
+ */
+@property (class, readonly, strong) DKGeometryTable* sharedGeometryTable;
+
+/** @brief Return the shared path with the same geometry as <code>path</code>.
+
+ If the table has no such path yet a copy of \c path is added and returned, so that the caller can go on changing its own path
+ without affecting anyone else. A path that is already the table's own is returned as it is.
+ */
+- (NSBezierPath*)internedPath:(NSBezierPath*)path;
+
+/** @brief Return the shared path with the same geometry as <code>path</code>, or nil if there is none. Doesn't add anything.
+ */
+- (nullable NSBezierPath*)existingPathForPath:(NSBezierPath*)path;
+
+/** @brief The number of distinct geometries in use.
+ */
+@property (readonly) NSUInteger count;
+
+@end
+
+NS_ASSUME_NONNULL_END
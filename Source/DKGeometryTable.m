@@ -0,0 +1,205 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKGeometryTable.h"
+#import "NSBezierPath+Editing.h"
+
+#define DK_GEOMETRY_TABLE_MIN_PURGE 64
+
+/** @brief The attributes of a path besides its elements, zeroed before filling so that equal attributes are equal bytes.
+ */
+typedef struct {
+	NSInteger windingRule;
+	NSInteger lineCapStyle;
+	NSInteger lineJoinStyle;
+	CGFloat lineWidth;
+	CGFloat miterLimit;
+	CGFloat flatness;
+} DKGeometryAttributes;
+
+/** @brief The key of a path in the table - its elements and attributes, laid out as bytes, and hashed with the path's checksum.
+ */
+@interface DKGeometryKey : NSObject {
+@public
+	NSData* mBytes;
+	NSUInteger mHash;
+}
+
+- (instancetype)initWithPath:(NSBezierPath*)path;
+
+@end
+
+@implementation DKGeometryKey
+
+- (instancetype)initWithPath:(NSBezierPath*)path
+{
+	self = [super init];
+	if (self) {
+		DKGeometryAttributes attrs;
+		NSInteger ec = [path elementCount];
+		NSMutableData* bytes = [NSMutableData dataWithCapacity:sizeof(attrs) + ec * (sizeof(NSInteger) + sizeof(NSPoint))];
+		NSPoint p[3];
+
+		memset(&attrs, 0, sizeof(attrs));
+		attrs.windingRule = [path windingRule];
+		attrs.lineCapStyle = [path lineCapStyle];
+		attrs.lineJoinStyle = [path lineJoinStyle];
+		attrs.lineWidth = [path lineWidth];
+		attrs.miterLimit = [path miterLimit];
+		attrs.flatness = [path flatness];
+		[bytes appendBytes:&attrs
+					length:sizeof(attrs)];
+
+		for (NSInteger i = 0; i < ec; ++i) {
+			NSInteger element = [path elementAtIndex:i
+									associatedPoints:p];
+			NSInteger n = (element == NSCurveToBezierPathElement) ? 3 : (element == NSClosePathBezierPathElement) ? 0 : 1;
+
+			[bytes appendBytes:&element
+						length:sizeof(element)];
+			[bytes appendBytes:p
+						length:n * sizeof(NSPoint)];
+		}
+
+		mBytes = bytes;
+		mHash = [path checksum];
+	}
+
+	return self;
+}
+
+- (NSUInteger)hash
+{
+	return mHash;
+}
+
+- (BOOL)isEqual:(id)object
+{
+	if (![object isKindOfClass:[DKGeometryKey class]])
+		return NO;
+
+	DKGeometryKey* other = object;
+	return other->mHash == mHash && [other->mBytes isEqualToData:mBytes];
+}
+
+@end
+
+#pragma mark -
+
+@interface DKGeometryTable ()
+
+- (void)purgeUnusedKeys;
+
+@end
+
+@implementation DKGeometryTable
+
++ (DKGeometryTable*)sharedGeometryTable
+{
+	static DKGeometryTable* sTable = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sTable = [[DKGeometryTable alloc] init];
+	});
+
+	return sTable;
+}
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self) {
+		mPaths = [NSMapTable strongToWeakObjectsMapTable];
+		mShared = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality];
+		mPurgeThreshold = DK_GEOMETRY_TABLE_MIN_PURGE;
+		mQueue = dispatch_queue_create("net.apptree.drawkit.geometrytable", DISPATCH_QUEUE_SERIAL);
+	}
+
+	return self;
+}
+
+- (NSBezierPath*)internedPath:(NSBezierPath*)path
+{
+	NSAssert(path != nil, @"can't intern a nil path");
+
+	__block NSBezierPath* shared = nil;
+
+	// a path that is already shared is returned straight away, without working out its key - this is the usual case when shapes
+	// are copied or an edit is undone
+
+	dispatch_sync(mQueue, ^{
+		if ([mShared containsObject:path])
+			shared = path;
+	});
+
+	if (shared)
+		return shared;
+
+	DKGeometryKey* key = [[DKGeometryKey alloc] initWithPath:path];
+
+	dispatch_sync(mQueue, ^{
+		shared = [mPaths objectForKey:key];
+
+		if (shared == nil) {
+			// the caller keeps its own path and may go on changing it, so the table's path is a copy
+
+			shared = [path copy];
+
+			if ([mPaths count] >= mPurgeThreshold)
+				[self purgeUnusedKeys];
+
+			[mPaths setObject:shared
+					   forKey:key];
+			[mShared addObject:shared];
+		}
+	});
+
+	return shared;
+}
+
+- (NSBezierPath*)existingPathForPath:(NSBezierPath*)path
+{
+	DKGeometryKey* key = [[DKGeometryKey alloc] initWithPath:path];
+	__block NSBezierPath* shared = nil;
+
+	dispatch_sync(mQueue, ^{
+		shared = [mPaths objectForKey:key];
+	});
+
+	return shared;
+}
+
+- (NSUInteger)count
+{
+	__block NSUInteger count = 0;
+
+	dispatch_sync(mQueue, ^{
+		count = [[[mPaths objectEnumerator] allObjects] count];
+	});
+
+	return count;
+}
+
+- (void)purgeUnusedKeys
+{
+	// the keys of paths that have gone are left in the map table, so remove them from time to time. The threshold grows with the
+	// number of paths in use, so this costs a constant amount per path added.
+
+	NSMutableArray* unused = [NSMutableArray array];
+
+	for (DKGeometryKey* key in mPaths) {
+		if ([mPaths objectForKey:key] == nil)
+			[unused addObject:key];
+	}
+
+	for (DKGeometryKey* key in unused)
+		[mPaths removeObjectForKey:key];
+
+	mPurgeThreshold = MAX((NSUInteger)DK_GEOMETRY_TABLE_MIN_PURGE, [mPaths count] * 2);
+}
+
+@end
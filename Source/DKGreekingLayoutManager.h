@@ -9,21 +9,51 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** @brief The greeking blocks of one line fragment.
+ */
+typedef struct {
+	NSRange glyphRange; // the glyphs in the line
+	NSRect usedRect; // the line's used rect, drawn when greeking by line
+	NSPoint origin; // the origin of the line fragment rect, which the glyph blocks are relative to
+} DKGreekingLine;
+
 /** @brief This layout manager subclass draws greeking rectangles instead of glyphs, either as entire line fragement rectangles or as glyph rectangles.
 
  This layout manager subclass draws greeking rectangles instead of glyphs, either as entire line fragement rectangles or as glyph rectangles.
  
  Greeking can be faster for certain operations such as hit-testing where exact glyph rendition is not needed.
+
+ The line and glyph rectangles are worked out the first time they are drawn and kept until the layout changes, so that drawing the
+ same text again, at any scale and with either kind of greeking, is a single fill of rectangles already known. Setting the greeking to
+ \c kDKGreekingNone draws the glyphs as normal, so one layout can be drawn with or without greeking as the scale requires.
 */
 @interface DKGreekingLayoutManager : NSLayoutManager {
 	DKGreeking mGreeking;
 	NSColor* mGreekingColour;
+	DKGreekingLine* mLines; // line fragments, in glyph order
+	NSUInteger mLineCount;
+	NSUInteger mLineCapacity;
+	NSRect* mGlyphBlocks; // one block for each glyph in mLines, relative to its line fragment
+	NSUInteger mGlyphBlockCapacity;
 }
 
 @property DKGreeking greeking;
 
 @property (strong) NSColor* greekingColour;
 
+/** @brief Discard the line and glyph rectangles, so that they are worked out again when next drawn.
+
+ This is done automatically whenever the layout is invalidated.
+ */
+- (void)invalidateGreekingBlocks;
+
+/** @brief Return the blocks that the current greeking draws for the lines holding <code>glyphRange</code>, placed as if drawn at <code>origin</code>.
+
+ This lets a client keep the greeked form of some text and draw it again without laying the text out again. Returns \c nil if the
+ greeking is <code>kDKGreekingNone</code>.
+ */
+- (nullable NSBezierPath*)greekingPathForGlyphRange:(NSRange)glyphRange atPoint:(NSPoint)origin;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -6,82 +6,201 @@
 
 #import "DKGreekingLayoutManager.h"
 
+@interface DKGreekingLayoutManager ()
+
+- (void)buildGreekingBlocksToGlyphIndex:(NSUInteger)limit;
+- (NSUInteger)indexOfGreekingLineForGlyphAtIndex:(NSUInteger)glyphIndex;
+
+@end
+
 @implementation DKGreekingLayoutManager
 @synthesize greeking = mGreeking;
 @synthesize greekingColour = mGreekingColour;
 
+- (void)invalidateGreekingBlocks
+{
+	mLineCount = 0;
+}
+
+- (void)buildGreekingBlocksToGlyphIndex:(NSUInteger)limit
+{
+	// works out the line and glyph blocks from the end of those already known up to the line containing <limit> - 1. Each glyph's
+	// block is its bounding box placed at its location, in container coordinates, so a run of lines can be filled in one go.
+
+	limit = MIN(limit, [self numberOfGlyphs]);
+
+	// finish any layout first, as it could invalidate what is already known
+
+	[self ensureLayoutForGlyphRange:NSMakeRange(0, limit)];
+
+	NSTextStorage* text = [self textStorage];
+	NSUInteger glyphIndex = (mLineCount > 0) ? NSMaxRange(mLines[mLineCount - 1].glyphRange) : 0;
+	NSRange fontRun = NSMakeRange(0, 0);
+	NSFont* font = nil;
+
+	while (glyphIndex < limit) {
+		NSRange lineRange;
+		NSRect usedRect = [self lineFragmentUsedRectForGlyphAtIndex:glyphIndex
+													 effectiveRange:&lineRange];
+		NSRect lineRect = [self lineFragmentRectForGlyphAtIndex:glyphIndex
+												 effectiveRange:NULL];
+
+		if (lineRange.length == 0)
+			break;
+
+		if (mLineCount == mLineCapacity) {
+			mLineCapacity = MAX(16, mLineCapacity * 2);
+			mLines = realloc(mLines, mLineCapacity * sizeof(DKGreekingLine));
+		}
+
+		if (NSMaxRange(lineRange) > mGlyphBlockCapacity) {
+			mGlyphBlockCapacity = MAX(NSMaxRange(lineRange), mGlyphBlockCapacity * 2);
+			mGlyphBlocks = realloc(mGlyphBlocks, mGlyphBlockCapacity * sizeof(NSRect));
+		}
+
+		DKGreekingLine* line = &mLines[mLineCount++];
+
+		line->glyphRange = lineRange;
+		line->usedRect = usedRect;
+		line->origin = lineRect.origin;
+
+		for (NSUInteger gli = lineRange.location; gli < NSMaxRange(lineRange); ++gli) {
+			NSUInteger characterIndex = [self characterIndexForGlyphAtIndex:gli];
+
+			// the font only needs looking up again when the glyph is past the end of the last run
+
+			if (font == nil || !NSLocationInRange(characterIndex, fontRun))
+				font = [text attribute:NSFontAttributeName
+							   atIndex:characterIndex
+						effectiveRange:&fontRun];
+
+			NSPoint glyphLoc = [self locationForGlyphAtIndex:gli];
+			NSRect glyphBounds = [font boundingRectForGlyph:[self glyphAtIndex:gli]];
+
+			glyphBounds.origin.x = lineRect.origin.x + glyphLoc.x;
+			glyphBounds.origin.y = (lineRect.origin.y + glyphLoc.y) - NSHeight(glyphBounds);
+
+			mGlyphBlocks[gli] = glyphBounds;
+		}
+
+		glyphIndex = NSMaxRange(lineRange);
+	}
+}
+
+- (NSUInteger)indexOfGreekingLineForGlyphAtIndex:(NSUInteger)glyphIndex
+{
+	// returns the index of the known line containing the glyph, or NSNotFound
+
+	NSUInteger lo = 0, hi = mLineCount;
+
+	while (lo < hi) {
+		NSUInteger mid = (lo + hi) / 2;
+
+		if (NSMaxRange(mLines[mid].glyphRange) <= glyphIndex)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < mLineCount && NSLocationInRange(glyphIndex, mLines[lo].glyphRange))
+		return lo;
+
+	return NSNotFound;
+}
+
+- (NSBezierPath*)greekingPathForGlyphRange:(NSRange)glyphRange atPoint:(NSPoint)origin
+{
+	if ([self greeking] == kDKGreekingNone)
+		return nil;
+
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	if (glyphRange.length == 0)
+		return path;
+
+	[self buildGreekingBlocksToGlyphIndex:NSMaxRange(glyphRange)];
+
+	NSUInteger first = [self indexOfGreekingLineForGlyphAtIndex:glyphRange.location];
+
+	if (first == NSNotFound)
+		return path;
+
+	NSUInteger li, last = first;
+
+	while (last + 1 < mLineCount && mLines[last + 1].glyphRange.location < NSMaxRange(glyphRange))
+		++last;
+
+	if ([self greeking] == kDKGreekingByLineRectangle) {
+		for (li = first; li <= last; ++li)
+			[path appendBezierPathWithRect:NSOffsetRect(mLines[li].usedRect, origin.x, origin.y)];
+	} else {
+		NSUInteger gli;
+
+		for (gli = mLines[first].glyphRange.location; gli < NSMaxRange(mLines[last].glyphRange); ++gli)
+			[path appendBezierPathWithRect:NSOffsetRect(mGlyphBlocks[gli], origin.x, origin.y)];
+	}
+
+	return path;
+}
+
 #pragma mark - as a NSLayoutManager
 
 - (void)drawGlyphsForGlyphRange:(NSRange)glyphsToShow atPoint:(NSPoint)origin
 {
-	if ([self greeking] == kDKGreekingNone)
+	if ([self greeking] == kDKGreekingNone) {
 		[super drawGlyphsForGlyphRange:glyphsToShow
 							   atPoint:origin];
-	else {
-		NSGlyph glyph;
-		NSFont* font;
-		NSRect glyphBounds, lineRect;
-		NSPoint glyphLoc;
-		NSUInteger gli, characterIndex;
-
-		[[self greekingColour] set];
-
-		// draw blocks instead of glyphs, either the entire line fragment used rect or each glyph.
-		// if the range to show is just a single glyph, handle it slightly differently so that the text on path
-		// layout works as expected. In this mode, either greeking setting produces glyph-based greeking as we are
-		// being called to lay out each glyph one by one.
-
-		if (glyphsToShow.length == 1) {
-			glyph = [self glyphAtIndex:glyphsToShow.location];
-			characterIndex = [self characterIndexForGlyphAtIndex:glyphsToShow.location];
-			font = [[self textStorage] attribute:NSFontAttributeName
-										 atIndex:characterIndex
-								  effectiveRange:NULL];
-			glyphLoc = [self locationForGlyphAtIndex:glyphsToShow.location];
-			glyphBounds = [font boundingRectForGlyph:glyph];
-
-			glyphBounds.origin.x = origin.x + glyphLoc.x;
-			glyphBounds.origin.y = origin.y + glyphLoc.y - NSHeight(glyphBounds);
-
-			NSRectFill(glyphBounds);
-		} else {
-			NSRange glyphRange;
-			NSRect fragRect;
-			NSUInteger glyphIndex = glyphsToShow.location;
+		return;
+	}
+
+	if (glyphsToShow.length == 0)
+		return;
+
+	[self buildGreekingBlocksToGlyphIndex:NSMaxRange(glyphsToShow)];
+
+	NSUInteger first = [self indexOfGreekingLineForGlyphAtIndex:glyphsToShow.location];
+
+	if (first == NSNotFound)
+		return;
+
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+
+	[[self greekingColour] set];
 
-			while (glyphIndex < NSMaxRange(glyphsToShow)) {
-				fragRect = [self lineFragmentUsedRectForGlyphAtIndex:glyphIndex
-													  effectiveRange:&glyphRange];
+	CGContextSaveGState(context);
+	CGContextTranslateCTM(context, origin.x, origin.y);
 
-				if ([self greeking] == kDKGreekingByLineRectangle)
-					NSRectFill(NSOffsetRect(fragRect, origin.x, origin.y));
-				else {
-					// greeking down to the glyph rects, so calculate them and draw them
+	// draw blocks instead of glyphs, either the entire line fragment used rect or each glyph.
+	// if the range to show is just a single glyph, handle it slightly differently so that the text on path
+	// layout works as expected. In this mode, either greeking setting produces glyph-based greeking as we are
+	// being called to lay out each glyph one by one, each placed relative to its own location.
 
-					lineRect = [self lineFragmentRectForGlyphAtIndex:glyphIndex
-													  effectiveRange:NULL];
+	if (glyphsToShow.length == 1) {
+		NSRect glyphBounds = mGlyphBlocks[glyphsToShow.location];
 
-					for (gli = glyphRange.location; gli < NSMaxRange(glyphRange); ++gli) {
-						glyph = [self glyphAtIndex:gli];
-						glyphLoc = [self locationForGlyphAtIndex:gli];
-						characterIndex = [self characterIndexForGlyphAtIndex:gli];
-						font = [[self textStorage] attribute:NSFontAttributeName
-													 atIndex:characterIndex
-											  effectiveRange:NULL];
+		glyphBounds.origin.x -= mLines[first].origin.x;
+		glyphBounds.origin.y -= mLines[first].origin.y;
 
-						glyphBounds = [font boundingRectForGlyph:glyph];
+		CGContextFillRect(context, glyphBounds);
+	} else {
+		// whole lines are drawn, so take every line that starts before the end of the range
 
-						glyphBounds.origin.x = origin.x + lineRect.origin.x + glyphLoc.x;
-						glyphBounds.origin.y = (origin.y + lineRect.origin.y + glyphLoc.y) - NSHeight(glyphBounds);
+		NSUInteger last = first;
 
-						NSRectFill(glyphBounds);
-					}
-				}
+		while (last + 1 < mLineCount && mLines[last + 1].glyphRange.location < NSMaxRange(glyphsToShow))
+			++last;
 
-				glyphIndex = NSMaxRange(glyphRange);
-			}
+		if ([self greeking] == kDKGreekingByLineRectangle) {
+			for (NSUInteger li = first; li <= last; ++li)
+				CGContextFillRect(context, mLines[li].usedRect);
+		} else {
+			NSUInteger start = mLines[first].glyphRange.location;
+
+			CGContextFillRects(context, (const CGRect*)&mGlyphBlocks[start], NSMaxRange(mLines[last].glyphRange) - start);
 		}
 	}
+
+	CGContextRestoreGState(context);
 }
 
 - (void)drawBackgroundForGlyphRange:(NSRange)glyphsToShow atPoint:(NSPoint)origin
@@ -91,6 +210,43 @@
 								   atPoint:origin];
 }
 
+- (void)setTextStorage:(NSTextStorage*)textStorage
+{
+	[super setTextStorage:textStorage];
+	[self invalidateGreekingBlocks];
+}
+
+- (void)processEditingForTextStorage:(NSTextStorage*)textStorage edited:(NSTextStorageEditActions)editMask range:(NSRange)newCharRange changeInLength:(NSInteger)delta invalidatedRange:(NSRange)invalidatedCharRange
+{
+	[super processEditingForTextStorage:textStorage
+								 edited:editMask
+								  range:newCharRange
+						 changeInLength:delta
+					   invalidatedRange:invalidatedCharRange];
+	[self invalidateGreekingBlocks];
+}
+
+- (void)invalidateGlyphsForCharacterRange:(NSRange)charRange changeInLength:(NSInteger)delta actualCharacterRange:(NSRangePointer)actualCharRange
+{
+	[super invalidateGlyphsForCharacterRange:charRange
+							  changeInLength:delta
+						actualCharacterRange:actualCharRange];
+	[self invalidateGreekingBlocks];
+}
+
+- (void)invalidateLayoutForCharacterRange:(NSRange)charRange actualCharacterRange:(NSRangePointer)actualCharRange
+{
+	[super invalidateLayoutForCharacterRange:charRange
+						actualCharacterRange:actualCharRange];
+	[self invalidateGreekingBlocks];
+}
+
+- (void)textContainerChangedGeometry:(NSTextContainer*)container
+{
+	[super textContainerChangedGeometry:container];
+	[self invalidateGreekingBlocks];
+}
+
 #pragma mark - as a NSObject
 
 - (id)init
@@ -102,4 +258,10 @@
 	return self;
 }
 
+- (void)dealloc
+{
+	free(mLines);
+	free(mGlyphBlocks);
+}
+
 @end
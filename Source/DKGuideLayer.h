@@ -9,7 +9,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKGuide;
+@class DKGuide, DKAxisIndex;
 
 /** @brief Implements horizontal and vertical guidelines.
  
@@ -35,6 +35,8 @@ NS_ASSUME_NONNULL_BEGIN
 	CGFloat m_snapTolerance; // the current snap tolerance value
 	NSRect mGuideDeletionZone; // guides dragged outside this rect are deleted
 	BOOL mDrawGuidesInClipView; // if YES, guides are extended to be drawn in the clip view of an enclosing scroller
+	DKAxisIndex* mVerticalGuideIndex; // vertical guides sorted by position, built on demand
+	DKAxisIndex* mHorizontalGuideIndex; // horizontal guides sorted by position, built on demand
 }
 
 // default snapping tolerance:
@@ -99,6 +101,10 @@ NS_ASSUME_NONNULL_BEGIN
 // finding guides close to a given position
 
 /** @brief Locates the nearest guide to the given position, if position is within the snap tolerance
+
+ Guides are kept sorted by position, so this takes logarithmic time however many guides there are. Guides should be moved
+ by dragging them or with the layer's own methods, which keep the order up to date; a guide repositioned directly with
+ -setGuidePosition: while in the layer may not be found until guides are next added or removed.
  @param pos a verical coordinate value, in points
  @return the nearest guide to the given point that lies within the snap tolerance, or nil
  */
@@ -5,6 +5,7 @@
 */
 
 #import "DKGuideLayer.h"
+#import "DKAxisIndex.h"
 #import "DKDrawing.h"
 #import "DKDrawingView.h"
 #import "DKGridLayer.h"
@@ -25,6 +26,8 @@
  */
 - (void)repositionGuide:(DKGuide*)guide atPoint:(NSPoint)p inView:(NSView*)aView;
 - (NSRect)guideRectOfGuide:(DKGuide*)guide forEnclosingClipViewOfView:(NSView*)aView;
+- (void)buildGuideIndexesIfNeeded;
+- (void)invalidateGuideIndexes;
 
 @end
 
@@ -74,6 +77,8 @@ static BOOL sWasInside = NO;
 	else
 		[m_hGuides addObject:guide];
 
+	[self invalidateGuideIndexes];
+
 	[guide setGuideColour:[self guideColour]];
 	[self refreshGuide:guide];
 
@@ -97,6 +102,8 @@ static BOOL sWasInside = NO;
 	else
 		[m_hGuides removeObject:guide];
 
+	[self invalidateGuideIndexes];
+
 	if (!([[self undoManager] isUndoing] || [[self undoManager] isRedoing]))
 		[[self undoManager] setActionName:NSLocalizedString(@"Delete Guide", @"undo action for Remove Guide")];
 }
@@ -110,6 +117,7 @@ static BOOL sWasInside = NO;
 
 		[m_vGuides removeAllObjects];
 		[m_hGuides removeAllObjects];
+		[self invalidateGuideIndexes];
 		[self setNeedsDisplay:YES];
 	}
 }
@@ -122,19 +130,12 @@ static BOOL sWasInside = NO;
  */
 - (DKGuide*)nearestVerticalGuideToPosition:(CGFloat)pos
 {
-	DKGuide* nearestGuide = nil;
-	CGFloat nearestDistance = 10000, distance;
-
-	for (DKGuide* guide in [self verticalGuides]) {
-		distance = fabs(pos - [guide guidePosition]);
-
-		if (distance < [self snapTolerance] && distance < nearestDistance) {
-			nearestDistance = distance;
-			nearestGuide = guide;
-		}
-	}
+	[self buildGuideIndexesIfNeeded];
 
-	return nearestGuide;
+	return [mVerticalGuideIndex nearestOwnerToPosition:pos
+											 tolerance:[self snapTolerance]
+											 excluding:nil
+											  position:NULL];
 }
 
 /** @brief Locates the nearest guide to the given position, if position is within the snap tolerance
@@ -143,19 +144,38 @@ static BOOL sWasInside = NO;
  */
 - (DKGuide*)nearestHorizontalGuideToPosition:(CGFloat)pos
 {
-	DKGuide* nearestGuide = nil;
-	CGFloat nearestDistance = 10000, distance;
+	[self buildGuideIndexesIfNeeded];
 
-	for (DKGuide* guide in [self horizontalGuides]) {
-		distance = fabs(pos - [guide guidePosition]);
+	return [mHorizontalGuideIndex nearestOwnerToPosition:pos
+											   tolerance:[self snapTolerance]
+											   excluding:nil
+												position:NULL];
+}
 
-		if (distance < [self snapTolerance] && distance < nearestDistance) {
-			nearestDistance = distance;
-			nearestGuide = guide;
-		}
+/** @brief Sorts the guides by position, if they have changed since they were last sorted
+
+ Guides change rarely compared with how often they're searched, so the indexes are simply rebuilt after any change.
+ */
+- (void)buildGuideIndexesIfNeeded
+{
+	if (mVerticalGuideIndex == nil) {
+		mVerticalGuideIndex = [[DKAxisIndex alloc] init];
+		mHorizontalGuideIndex = [[DKAxisIndex alloc] init];
+
+		for (DKGuide* guide in m_vGuides)
+			[mVerticalGuideIndex addPosition:[guide guidePosition]
+									   owner:guide];
+
+		for (DKGuide* guide in m_hGuides)
+			[mHorizontalGuideIndex addPosition:[guide guidePosition]
+										 owner:guide];
 	}
+}
 
-	return nearestGuide;
+- (void)invalidateGuideIndexes
+{
+	mVerticalGuideIndex = nil;
+	mHorizontalGuideIndex = nil;
 }
 
 /** @brief Returns the list of vertical guides
@@ -507,6 +527,7 @@ static BOOL sWasInside = NO;
 #endif
 			[self refreshGuide:guide];
 		[guide setGuidePosition:newPos];
+		[self invalidateGuideIndexes];
 #if DK_DRAW_GUIDES_IN_CLIP_VIEW
 		gr = [self guideRectOfGuide:guide
 			forEnclosingClipViewOfView:aView];
@@ -44,6 +44,12 @@ DKHandle is a base class for all handles, which are the knobs attached to shapes
 
 - (void)drawAtPoint:(NSPoint)point;
 - (void)drawAtPoint:(NSPoint)point angle:(CGFloat)radians;
+/** @brief Draw the handle at each of \c count points, all at the same angle.
+
+ The graphics state is saved and the view scale compensated for once for the whole batch, and the cached image is then stamped at
+ each point. This is much cheaper than calling -drawAtPoint:angle: for each point when there are many handles to draw.
+ */
+- (void)drawAtPoints:(const NSPoint*)points count:(NSUInteger)count angle:(CGFloat)radians;
 - (BOOL)hitTestPoint:(NSPoint)point inHandleAtPoint:(NSPoint)hp;
 
 @end
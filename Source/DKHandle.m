@@ -181,6 +181,30 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 
 - (void)drawAtPoint:(NSPoint)point angle:(CGFloat)radians
 {
+	[self drawAtPoints:&point
+				 count:1
+				 angle:radians];
+}
+
+- (void)drawAtPoints:(const NSPoint*)points count:(NSUInteger)count angle:(CGFloat)radians
+{
+	if (count == 0)
+		return;
+
+	// a subclass that draws single handles its own way must still get to do so
+
+	static IMP sBaseDrawIMP = NULL;
+
+	if (sBaseDrawIMP == NULL)
+		sBaseDrawIMP = [DKHandle instanceMethodForSelector:@selector(drawAtPoint:angle:)];
+
+	if (count > 1 && [self methodForSelector:@selector(drawAtPoint:angle:)] != sBaseDrawIMP) {
+		for (NSUInteger i = 0; i < count; ++i)
+			[self drawAtPoint:points[i]
+						angle:radians];
+		return;
+	}
+
 	if (mCache == nil) {
 		mCache = [DKQuartzCache cacheForCurrentContextWithSize:[self size]];
 
@@ -216,20 +240,37 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 
 	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
 	CGAffineTransform ctm = CGContextGetCTM(context);
-	CGAffineTransform newTfm = CGAffineTransformIdentity;
-
 	CGFloat compScale = 1.0 / ctm.a;
+	NSSize size = [self size];
 
-	newTfm = CGAffineTransformTranslate(newTfm, point.x, point.y);
+	if (radians == 0) {
+		// unrotated handles differ only by translation, so the scale is set once and each point is mapped into the scaled space
 
-	if (radians != 0)
-		newTfm = CGAffineTransformRotate(newTfm, radians);
+		NSPoint* origins = malloc(count * sizeof(NSPoint));
 
-	newTfm = CGAffineTransformScale(newTfm, compScale, compScale);
-	newTfm = CGAffineTransformTranslate(newTfm, -[self size].width * 0.5, -[self size].height * 0.5);
-	CGContextConcatCTM(context, newTfm);
+		for (NSUInteger i = 0; i < count; ++i) {
+			origins[i].x = points[i].x * ctm.a - size.width * 0.5;
+			origins[i].y = points[i].y * ctm.a - size.height * 0.5;
+		}
 
-	[mCache drawAtPoint:NSZeroPoint];
+		CGContextScaleCTM(context, compScale, compScale);
+		[mCache drawAtPoints:origins
+					   count:count];
+		free(origins);
+	} else {
+		for (NSUInteger i = 0; i < count; ++i) {
+			CGAffineTransform newTfm = CGAffineTransformMakeTranslation(points[i].x, points[i].y);
+
+			newTfm = CGAffineTransformRotate(newTfm, radians);
+			newTfm = CGAffineTransformScale(newTfm, compScale, compScale);
+			newTfm = CGAffineTransformTranslate(newTfm, -size.width * 0.5, -size.height * 0.5);
+
+			CGContextSaveGState(context);
+			CGContextConcatCTM(context, newTfm);
+			[mCache drawAtPoint:NSZeroPoint];
+			CGContextRestoreGState(context);
+		}
+	}
 
 	RESTORE_GRAPHICS_CONTEXT
 }
@@ -370,10 +370,11 @@
 		// relative to the spacing. It is used to give a more naturalistic type of hatch (esp. in conjunction with roughness).
 
 		CGFloat maxWobble = mWobblyness * [self spacing];
+		DKRandomState* rng = DKRandomThreadState();
 
 		for (i = 0; i < m; i++) {
-			a.x = cr.origin.x + m_leadIn + (i * [self spacing]) + ([DKRandom randomPositiveOrNegativeNumber] * maxWobble);
-			b.x = cr.origin.x + m_leadIn + (i * [self spacing]) + ([DKRandom randomPositiveOrNegativeNumber] * maxWobble);
+			a.x = cr.origin.x + m_leadIn + (i * [self spacing]) + (DKRandomSigned(rng) * maxWobble);
+			b.x = cr.origin.x + m_leadIn + (i * [self spacing]) + (DKRandomSigned(rng) * maxWobble);
 
 			[m_cache moveToPoint:a];
 			[m_cache lineToPoint:b];
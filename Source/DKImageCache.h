@@ -0,0 +1,100 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKImageCacheEntry, DKImageCacheFailure;
+
+/** @brief A shared, byte-bounded cache of decoded and downsampled images.
+
+ DKImageCache holds decoded bitmaps for images keyed by an image key (typically the key used by DKImageDataManager) and a mip level. Level
+ 0 is the image at its native size and is never cached here - callers draw their original image for it. Each level above 0 halves the
+ pixel dimensions of the one below, and is produced with a pre-filtered, high quality downsample so that zoomed-out images do not alias.
+
+ Levels are built on a background queue. While a level is being built, the cache returns the nearest coarser level it already has (if any)
+ so that the caller can draw something reasonable; if nothing is available the caller should draw a placeholder. When the level becomes
+ available the completion block passed with the request is called on the main thread, typically to trigger a redraw.
+
+ The total size of the cached bitmaps is bounded by \c byteLimit. When it is exceeded the least recently used levels are discarded first.
+*/
+@interface DKImageCache : NSObject {
+@private
+	NSMutableDictionary<NSString*, DKImageCacheEntry*>* mEntries; // level key -> entry
+	NSMutableDictionary<NSString*, NSMutableArray*>* mPending; // level key -> completion blocks awaiting that level
+	NSMutableDictionary<NSString*, DKImageCacheFailure*>* mFailures; // level key -> levels that couldn't be built, and when to try again
+	NSMutableDictionary<NSString*, NSNumber*>* mGenerations; // key -> the number of times its images have been removed
+	DKImageCacheEntry* mLRUHead; // most recently used
+	DKImageCacheEntry* __unsafe_unretained mLRUTail; // least recently used
+	NSUInteger mByteLimit;
+	NSUInteger mBytesUsed;
+	NSUInteger mHits;
+	NSUInteger mMisses;
+	dispatch_queue_t mWorkQueue;
+}
+
+/** @brief Return the cache shared by all image shapes.
+ */
+@property (class, readonly, retain) DKImageCache* sharedImageCache;
+
+/** @brief Return the size in pixels of the image's first bitmap representation, or its size in points if it has none.
+ */
++ (NSSize)pixelSizeOfImage:(NSImage*)image;
+
+/** @brief Return the mip level that should be drawn for an image of the given pixel size when it covers \c destSize device pixels.
+
+ Level 0 is returned when the destination is at least as large as the source (or larger than half of it).
+ */
++ (NSInteger)mipLevelForSourceSize:(NSSize)sourceSize destinationSize:(NSSize)destSize;
+
+/** @brief Return a decoded image for the key at the requested level, or the nearest coarser level available.
+
+ If the exact level is not cached, a background job is started to build it from \c imageData (preferred, decoded directly at the reduced
+ size) or \c image, and \c completion is called on the main thread once it is ready. Returns \c NULL if no level at or above the one
+ requested is cached yet, in which case the caller should draw a placeholder, or, if
+ <code>-failedToBuildImageForKey:level:</code> returns YES, the full size image. The returned image is owned by the cache - retain it
+ if it is needed beyond the current drawing pass.
+ @param key the image key
+ @param level the mip level required (must be > 0)
+ @param imageData the original compressed image data, if known
+ @param image the image to use if there is no data
+ @param completion called on the main thread when a newly built level has been added to the cache, or building it failed
+ */
+- (nullable CGImageRef)imageForKey:(NSString*)key level:(NSInteger)level imageData:(nullable NSData*)imageData image:(nullable NSImage*)image completion:(nullable void (^)(void))completion CF_RETURNS_NOT_RETAINED;
+
+/** @brief Return whether the last attempt to build the level failed, e.g. because the image data couldn't be decoded.
+
+ A level that failed isn't tried again on every request: the cache waits a second before the next attempt, and twice as long after
+ each further failure, up to a minute.
+ */
+- (BOOL)failedToBuildImageForKey:(NSString*)key level:(NSInteger)level;
+
+/** @brief Discard all cached levels for the key.
+
+ Call this when the image associated with the key changes.
+ */
+- (void)removeImagesForKey:(NSString*)key;
+- (void)removeAllImages;
+
+/** @brief The maximum number of bytes of decoded bitmap data the cache will hold.
+
+ The default is 128MB.
+ */
+@property (nonatomic) NSUInteger byteLimit;
+@property (readonly) NSUInteger bytesUsed;
+
+/** @brief Counts of requests satisfied exactly from the cache (hits) and those that were not (misses).
+
+ Useful for tuning \c byteLimit, e.g. while zooming through a large drawing.
+ */
+@property (readonly) NSUInteger hits;
+@property (readonly) NSUInteger misses;
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,385 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKImageCache.h"
+#import <ImageIO/ImageIO.h>
+
+#define DK_IMAGE_CACHE_DEFAULT_BYTE_LIMIT (128 * 1024 * 1024)
+#define DK_IMAGE_CACHE_MAX_LEVEL 16
+#define DK_IMAGE_CACHE_FIRST_RETRY_DELAY 1.0
+#define DK_IMAGE_CACHE_MAX_RETRY_DELAY 60.0
+
+/** @brief One cached mip level. Entries form a doubly linked list in order of use so that eviction is O(1).
+ */
+@interface DKImageCacheEntry : NSObject {
+@public
+	NSString* mKey;
+	CGImageRef mImage;
+	NSUInteger mCost;
+	DKImageCacheEntry* mNext;
+	DKImageCacheEntry* __unsafe_unretained mPrev;
+}
+@end
+
+@implementation DKImageCacheEntry
+
+- (void)dealloc
+{
+	CGImageRelease(mImage);
+}
+
+@end
+
+/** @brief A level that couldn't be built, and when it may be tried again.
+ */
+@interface DKImageCacheFailure : NSObject {
+@public
+	NSUInteger mCount;
+	NSTimeInterval mRetryTime;
+}
+@end
+
+@implementation DKImageCacheFailure
+@end
+
+#pragma mark -
+
+static NSString* levelKey(NSString* key, NSInteger level)
+{
+	return [NSString stringWithFormat:@"%@|%ld", key, (long)level];
+}
+
+/** @brief Build the image for a mip level.
+
+ When the original data is available ImageIO decodes it directly at the reduced size, which avoids ever holding the full size
+ bitmap. Otherwise the decoded source is drawn into a bitmap of the reduced size with high quality (pre-filtered) interpolation.
+ */
+static CGImageRef createImageForLevel(NSData* data, CGImageRef source, NSSize sourceSize, NSInteger level)
+{
+	size_t width = MAX(1, (size_t)sourceSize.width >> level);
+	size_t height = MAX(1, (size_t)sourceSize.height >> level);
+	CGImageRef result = NULL;
+
+	if (data) {
+		CGImageSourceRef src = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+
+		if (src) {
+			NSDictionary* options = @{ (id)kCGImageSourceCreateThumbnailFromImageAlways : @YES,
+				(id)kCGImageSourceCreateThumbnailWithTransform : @YES,
+				(id)kCGImageSourceShouldCacheImmediately : @YES,
+				(id)kCGImageSourceThumbnailMaxPixelSize : @(MAX(width, height)) };
+
+			result = CGImageSourceCreateThumbnailAtIndex(src, 0, (__bridge CFDictionaryRef)options);
+			CFRelease(src);
+		}
+	}
+
+	if (result == NULL && source) {
+		CGColorSpaceRef cs = CGColorSpaceCreateDeviceRGB();
+		CGContextRef bm = CGBitmapContextCreate(NULL, width, height, 8, 0, cs, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst);
+		CGColorSpaceRelease(cs);
+
+		if (bm) {
+			CGContextSetInterpolationQuality(bm, kCGInterpolationHigh);
+			CGContextDrawImage(bm, CGRectMake(0, 0, width, height), source);
+			result = CGBitmapContextCreateImage(bm);
+			CGContextRelease(bm);
+		}
+	}
+
+	return result;
+}
+
+@interface DKImageCache ()
+
+- (void)touchEntry:(DKImageCacheEntry*)entry;
+- (void)unlinkEntry:(DKImageCacheEntry*)entry;
+- (void)addImage:(CGImageRef)image forLevelKey:(NSString*)lk;
+- (void)trimToByteLimit:(NSUInteger)limit;
+
+@end
+
+#pragma mark -
+
+@implementation DKImageCache
+
++ (DKImageCache*)sharedImageCache
+{
+	static DKImageCache* sSharedImageCache = nil;
+
+	if (sSharedImageCache == nil)
+		sSharedImageCache = [[DKImageCache alloc] init];
+
+	return sSharedImageCache;
+}
+
++ (NSSize)pixelSizeOfImage:(NSImage*)image
+{
+	for (NSImageRep* rep in [image representations]) {
+		if ([rep pixelsWide] > 0 && [rep pixelsHigh] > 0)
+			return NSMakeSize([rep pixelsWide], [rep pixelsHigh]);
+	}
+
+	return [image size];
+}
+
++ (NSInteger)mipLevelForSourceSize:(NSSize)sourceSize destinationSize:(NSSize)destSize
+{
+	// choose the smallest level that is still at least as big as the destination, so we only ever scale down when drawing
+
+	CGFloat srcMax = MAX(sourceSize.width, sourceSize.height);
+	CGFloat dstMax = MAX(fabs(destSize.width), fabs(destSize.height));
+
+	if (dstMax <= 0 || srcMax <= dstMax * 2.0)
+		return 0;
+
+	NSInteger level = (NSInteger)floor(log2(srcMax / dstMax));
+
+	return MIN(level, DK_IMAGE_CACHE_MAX_LEVEL);
+}
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self) {
+		mEntries = [[NSMutableDictionary alloc] init];
+		mPending = [[NSMutableDictionary alloc] init];
+		mFailures = [[NSMutableDictionary alloc] init];
+		mGenerations = [[NSMutableDictionary alloc] init];
+		mByteLimit = DK_IMAGE_CACHE_DEFAULT_BYTE_LIMIT;
+		mWorkQueue = dispatch_queue_create("net.apptree.drawkit.imagecache", DISPATCH_QUEUE_SERIAL);
+	}
+
+	return self;
+}
+
+- (CGImageRef)imageForKey:(NSString*)key level:(NSInteger)level imageData:(NSData*)imageData image:(NSImage*)image completion:(void (^)(void))completion
+{
+	NSAssert([NSThread isMainThread], @"DKImageCache must be used from the main thread");
+	NSAssert(level > 0, @"level 0 images are not cached");
+
+	NSString* lk = levelKey(key, level);
+	DKImageCacheEntry* entry = [mEntries objectForKey:lk];
+
+	if (entry) {
+		++mHits;
+		[self touchEntry:entry];
+		return entry->mImage;
+	}
+
+	++mMisses;
+
+	// start building the level unless that is already under way, in which case just add to the list of parties to notify. A level that
+	// failed isn't tried again until its retry time has passed.
+
+	NSMutableArray* waiting = [mPending objectForKey:lk];
+	DKImageCacheFailure* failure = [mFailures objectForKey:lk];
+
+	if (waiting == nil && (imageData || image) && (failure == nil || [NSDate timeIntervalSinceReferenceDate] >= failure->mRetryTime)) {
+		waiting = [NSMutableArray array];
+		[mPending setObject:waiting
+					 forKey:lk];
+
+		// NSImage is not safe to use from another thread, so obtain the decoded source here if there's no data to work from
+
+		CGImageRef source = NULL;
+		NSSize sourceSize = [[self class] pixelSizeOfImage:image];
+
+		if (imageData == nil)
+			source = CGImageRetain([image CGImageForProposedRect:NULL
+														 context:nil
+														   hints:nil]);
+
+		// a build that finishes after the key's images were removed is for an image that has gone, and is thrown away
+
+		NSUInteger generation = [[mGenerations objectForKey:key] unsignedIntegerValue];
+
+		dispatch_async(mWorkQueue, ^{
+			CGImageRef mip = createImageForLevel(imageData, source, sourceSize, level);
+			CGImageRelease(source);
+
+			dispatch_async(dispatch_get_main_queue(), ^{
+				NSArray* blocks = [mPending objectForKey:lk];
+				[mPending removeObjectForKey:lk];
+
+				BOOL current = [[mGenerations objectForKey:key] unsignedIntegerValue] == generation;
+
+				if (mip) {
+					if (current) {
+						[mFailures removeObjectForKey:lk];
+						[self addImage:mip
+							forLevelKey:lk];
+					}
+
+					CGImageRelease(mip);
+				} else if (current) {
+					DKImageCacheFailure* fail = [mFailures objectForKey:lk];
+
+					if (fail == nil) {
+						fail = [[DKImageCacheFailure alloc] init];
+						[mFailures setObject:fail
+									  forKey:lk];
+					}
+
+					NSTimeInterval delay = MIN(DK_IMAGE_CACHE_FIRST_RETRY_DELAY * (1 << MIN(fail->mCount, (NSUInteger)16)), DK_IMAGE_CACHE_MAX_RETRY_DELAY);
+
+					++fail->mCount;
+					fail->mRetryTime = [NSDate timeIntervalSinceReferenceDate] + delay;
+				}
+
+				// callers are told either way, so that those waiting on a failed level can stop drawing a placeholder
+
+				for (void (^block)(void) in blocks)
+					block();
+			});
+		});
+	}
+
+	if (completion)
+		[waiting addObject:[completion copy]];
+
+	// meanwhile, return the nearest coarser level we have, if any
+
+	for (NSInteger coarser = level + 1; coarser <= DK_IMAGE_CACHE_MAX_LEVEL; ++coarser) {
+		entry = [mEntries objectForKey:levelKey(key, coarser)];
+
+		if (entry) {
+			[self touchEntry:entry];
+			return entry->mImage;
+		}
+	}
+
+	return NULL;
+}
+
+- (BOOL)failedToBuildImageForKey:(NSString*)key level:(NSInteger)level
+{
+	return [mFailures objectForKey:levelKey(key, level)] != nil;
+}
+
+- (void)removeImagesForKey:(NSString*)key
+{
+	[mGenerations setObject:@([[mGenerations objectForKey:key] unsignedIntegerValue] + 1)
+					 forKey:key];
+
+	for (NSInteger level = 1; level <= DK_IMAGE_CACHE_MAX_LEVEL; ++level) {
+		NSString* lk = levelKey(key, level);
+		DKImageCacheEntry* entry = [mEntries objectForKey:lk];
+
+		if (entry) {
+			[self unlinkEntry:entry];
+			[mEntries removeObjectForKey:lk];
+		}
+
+		[mFailures removeObjectForKey:lk];
+	}
+}
+
+- (void)removeAllImages
+{
+	// builds still under way are for images that have been removed too
+
+	for (NSString* lk in [mPending allKeys]) {
+		NSString* key = [lk substringToIndex:[lk rangeOfString:@"|"
+													  options:NSBackwardsSearch]
+												 .location];
+
+		[mGenerations setObject:@([[mGenerations objectForKey:key] unsignedIntegerValue] + 1)
+						 forKey:key];
+	}
+
+	[self trimToByteLimit:0];
+	[mFailures removeAllObjects];
+}
+
+- (void)setByteLimit:(NSUInteger)limit
+{
+	mByteLimit = limit;
+	[self trimToByteLimit:limit];
+}
+
+@synthesize byteLimit = mByteLimit;
+@synthesize bytesUsed = mBytesUsed;
+@synthesize hits = mHits;
+@synthesize misses = mMisses;
+
+- (void)resetStatistics
+{
+	mHits = mMisses = 0;
+}
+
+#pragma mark -
+
+- (void)touchEntry:(DKImageCacheEntry*)entry
+{
+	if (entry != mLRUHead) {
+		DKImageCacheEntry* keep = entry;
+
+		[self unlinkEntry:keep];
+
+		keep->mNext = mLRUHead;
+		if (mLRUHead)
+			mLRUHead->mPrev = keep;
+		mLRUHead = keep;
+
+		if (mLRUTail == nil)
+			mLRUTail = keep;
+
+		mBytesUsed += keep->mCost;
+	}
+}
+
+- (void)unlinkEntry:(DKImageCacheEntry*)entry
+{
+	// removes the entry from the use list (but not the dictionary) and deducts its cost
+
+	if (entry->mPrev)
+		entry->mPrev->mNext = entry->mNext;
+	else if (entry == mLRUHead)
+		mLRUHead = entry->mNext;
+	else
+		return; // not linked
+
+	if (entry->mNext)
+		entry->mNext->mPrev = entry->mPrev;
+	else
+		mLRUTail = entry->mPrev;
+
+	entry->mNext = nil;
+	entry->mPrev = nil;
+	mBytesUsed -= entry->mCost;
+}
+
+- (void)addImage:(CGImageRef)image forLevelKey:(NSString*)lk
+{
+	DKImageCacheEntry* entry = [[DKImageCacheEntry alloc] init];
+
+	entry->mKey = lk;
+	entry->mImage = CGImageRetain(image);
+	entry->mCost = CGImageGetBytesPerRow(image) * CGImageGetHeight(image);
+
+	DKImageCacheEntry* old = [mEntries objectForKey:lk];
+
+	if (old)
+		[self unlinkEntry:old];
+
+	[mEntries setObject:entry
+				 forKey:lk];
+	[self touchEntry:entry];
+	[self trimToByteLimit:mByteLimit];
+}
+
+- (void)trimToByteLimit:(NSUInteger)limit
+{
+	while (mBytesUsed > limit && mLRUTail) {
+		DKImageCacheEntry* victim = mLRUTail;
+
+		[self unlinkEntry:victim];
+		[mEntries removeObjectForKey:victim->mKey];
+	}
+}
+
+@end
@@ -48,6 +48,7 @@ typedef NS_OPTIONS(NSInteger, DKImageCroppingOptions) {
 	DKImageCroppingOptions mImageCropping; // whether the image is scaled or cropped to the bounds
 	NSInteger mImageOffsetPartcode; // the partcode of the image offset hotspot
 	NSData* mOriginalImageData; // original image data (shared with image manager)
+	NSString* mImageCacheKey; // key used with the shared image cache when the image has no image manager key
 }
 
 + (DKStyle*)imageShapeDefaultStyle;
@@ -9,10 +9,12 @@
 #import "DKDrawableObject+Metadata.h"
 #import "DKDrawableShape+Hotspots.h"
 #import "DKDrawing.h"
+#import "DKImageCache.h"
 #import "DKImageDataManager.h"
 #import "DKKeyedUnarchiver.h"
 #import "DKObjectOwnerLayer.h"
 #import "DKStyle.h"
+#import "DKUniqueID.h"
 #import "LogEvent.h"
 
 #pragma mark Constants
@@ -42,8 +44,41 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
  */
 - (void)drawImage;
 
+/** @brief Return the key under which downsampled versions of the image are held by the shared image cache
+
+ Images that came from the image manager share the manager's key, so shapes displaying the same image data share the cached
+ levels. Other images are given a key private to this shape.
+ @return the key
+ */
+- (NSString*)imageCacheKey;
+
+/** @brief Return a reduced size version of the image suitable for drawing into the destination rect in the current context
+
+ Returns nil if the image should be drawn at full size. If a suitable version is still being built, returns the nearest
+ coarser version available, or <code>pendingImagePlaceholder()</code> if there is none yet, in which case the caller should
+ draw a placeholder. Returns nil as well if the reduced version couldn't be made. The shape is redrawn when the version it wants
+ becomes available.
+ @param destRect the rect the image will be drawn into, in the current user space
+ @return an image, or nil
+ */
+- (NSImage*)cachedImageForDestinationRect:(NSRect)destRect;
+
 @end
 
+/** @brief The image returned by <code>-cachedImageForDestinationRect:</code> while nothing suitable is cached, told apart by identity.
+ */
+static NSImage* pendingImagePlaceholder(void)
+{
+	static NSImage* sPlaceholder = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sPlaceholder = [[NSImage alloc] initWithSize:NSZeroSize];
+	});
+
+	return sPlaceholder;
+}
+
 @implementation DKImageShape
 #pragma mark As a DKImageShape
 
@@ -217,6 +252,13 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 										  selector:@selector(setImage:)
 											object:[self image]];
 
+		// downsampled versions of a private image are no longer any use. Versions cached under a manager's key remain valid as that data is shared.
+
+		if (mImageCacheKey) {
+			[[DKImageCache sharedImageCache] removeImagesForKey:mImageCacheKey];
+			mImageCacheKey = nil;
+		}
+
 		m_image = anImage;
 
 		[m_image setCacheMode:NSImageCacheNever];
@@ -630,21 +672,88 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 		ir.origin.y = m_imageOffset.y;
 	}
 
+	// when zoomed out, draw a prefiltered reduced size version of the image rather than resampling the full size image every time
+
+	NSImage* image = [self cachedImageForDestinationRect:ir];
+
+	if (image == nil)
+		image = [self image];
+	else if (image == pendingImagePlaceholder()) {
+		// still being built - draw a placeholder
+
+		[[[NSColor lightGrayColor] colorWithAlphaComponent:[self imageOpacity]] set];
+		NSRectFillUsingOperation(ir, [self compositingOperation]);
+		image = nil;
+	}
+
 	// render at high quality
 
 	[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationHigh];
 	//[[self image] setFlipped:[[NSGraphicsContext currentContext] isFlipped]];
 
-	[[self image] drawInRect:ir
-					fromRect:NSZeroRect
-				   operation:[self compositingOperation]
-					fraction:[self imageOpacity]
-			  respectFlipped:YES
-					   hints:nil];
+	[image drawInRect:ir
+			 fromRect:NSZeroRect
+			operation:[self compositingOperation]
+			 fraction:[self imageOpacity]
+	   respectFlipped:YES
+				hints:nil];
 
 	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 }
 
+- (NSString*)imageCacheKey
+{
+	if ([self imageKey])
+		return [self imageKey];
+
+	if (mImageCacheKey == nil)
+		mImageCacheKey = [DKUniqueID uniqueKey];
+
+	return mImageCacheKey;
+}
+
+- (NSImage*)cachedImageForDestinationRect:(NSRect)destRect
+{
+	NSGraphicsContext* gc = [NSGraphicsContext currentContext];
+
+	// printing and exporting always use the full size image
+
+	if ([self image] == nil || ![gc isDrawingToScreen])
+		return nil;
+
+	CGAffineTransform ctm = CGContextGetUserSpaceToDeviceSpaceTransform([gc graphicsPort]);
+	NSSize destSize;
+
+	destSize.width = destRect.size.width * hypot(ctm.a, ctm.b);
+	destSize.height = destRect.size.height * hypot(ctm.c, ctm.d);
+
+	NSInteger level = [DKImageCache mipLevelForSourceSize:[DKImageCache pixelSizeOfImage:[self image]]
+										  destinationSize:destSize];
+	if (level == 0)
+		return nil;
+
+	__weak DKImageShape* weakSelf = self;
+	CGImageRef mip = [[DKImageCache sharedImageCache] imageForKey:[self imageCacheKey]
+															level:level
+														imageData:[self imageData]
+															image:[self image]
+													   completion:^{
+														   [weakSelf notifyVisualChange];
+													   }];
+	if (mip == NULL) {
+		// nothing yet, or the level couldn't be made, in which case the full size image will have to do until the cache tries again
+
+		if ([[DKImageCache sharedImageCache] failedToBuildImageForKey:[self imageCacheKey]
+																level:level])
+			return nil;
+
+		return pendingImagePlaceholder();
+	}
+
+	return [[NSImage alloc] initWithCGImage:mip
+									   size:destRect.size];
+}
+
 - (NSAffineTransform*)imageTransform
 {
 	NSAffineTransform* tfm = [NSAffineTransform transform];
@@ -808,6 +917,16 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 #pragma mark -
 #pragma mark As a DKDrawableObject
 
+/** @brief Image shapes are drawn directly rather than from a display list
+
+ A recording would embed the full size image, and drawing directly allows the shared image cache to supply a version
+ suited to the current scale.
+ */
+- (BOOL)canRecordDisplayList
+{
+	return NO;
+}
+
 /** @brief Draws the object
  */
 - (void)drawContent
@@ -872,6 +991,22 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 #pragma mark -
 #pragma mark As an NSObject
 
+- (void)dealloc
+{
+	// levels cached under a private key can't be used by anything else. The cache is only used on the main thread.
+
+	NSString* key = mImageCacheKey;
+
+	if (key) {
+		if ([NSThread isMainThread])
+			[[DKImageCache sharedImageCache] removeImagesForKey:key];
+		else
+			dispatch_async(dispatch_get_main_queue(), ^{
+				[[DKImageCache sharedImageCache] removeImagesForKey:key];
+			});
+	}
+}
+
 #pragma mark -
 #pragma mark As part of the DKHotspotDelegate protocol
 
@@ -58,6 +58,20 @@ might include the shape of a knob, its colours, whether stroked or filled or bot
 - (void)drawKnobAtPoint:(NSPoint)p ofType:(DKKnobType)knobType angle:(CGFloat)radians userInfo:(nullable id)userInfo;
 - (void)drawKnobAtPoint:(NSPoint)p ofType:(DKKnobType)knobType angle:(CGFloat)radians highlightColour:(nullable NSColor*)aColour;
 
+/** @brief Draw knobs of one type at many points.
+
+ Draws exactly what calling -drawKnobAtPoint:ofType:angle:userInfo: for each point would, but the owner's scale and active state and
+ the handle for the type are looked up once for the whole batch, and the handle is stamped at every point in a single pass. Clients
+ that draw many knobs, such as the control points of a long path, should collect them and draw them with this.
+ */
+- (void)drawKnobsAtPoints:(const NSPoint*)points count:(NSUInteger)count ofType:(DKKnobType)knobType angle:(CGFloat)radians;
+/** @brief Draw knobs of mixed types, each point having its own type.
+
+ The points are grouped by type and each group is drawn as one batch. Groups are drawn in the order in which their types first
+ appear, so knobs of a type listed earlier are drawn behind those listed later.
+ */
+- (void)drawKnobsAtPoints:(const NSPoint*)points ofTypes:(const DKKnobType*)types count:(NSUInteger)count;
+
 - (void)drawControlBarFromPoint:(NSPoint)a toPoint:(NSPoint)b;
 - (void)drawControlBarWithKnobsFromPoint:(NSPoint)a toPoint:(NSPoint)b;
 - (void)drawControlBarWithKnobsFromPoint:(NSPoint)a ofType:(DKKnobType)typeA toPoint:(NSPoint)b ofType:(DKKnobType)typeB;
@@ -250,6 +250,82 @@ static NSSize sKnobSize = { 6.0, 6.0 };
 #endif
 }
 
+- (void)drawKnobsAtPoints:(const NSPoint*)points count:(NSUInteger)count ofType:(DKKnobType)knobType angle:(CGFloat)radians
+{
+	NSAssert(knobType != 0, @"knob type can't be zero");
+
+	if (count == 0)
+		return;
+
+#if USE_DK_HANDLES
+	// a subclass that customises single knob drawing must still see every knob, so in that case fall back to drawing them one at a time
+
+	static IMP sBaseDrawIMP = NULL;
+
+	if (sBaseDrawIMP == NULL)
+		sBaseDrawIMP = [DKKnob instanceMethodForSelector:@selector(drawKnobAtPoint:ofType:angle:userInfo:)];
+
+	if ([self methodForSelector:@selector(drawKnobAtPoint:ofType:angle:userInfo:)] == sBaseDrawIMP) {
+		if ([[self owner] respondsToSelector:@selector(knobsWantDrawingActiveState)]) {
+			BOOL active = [[self owner] knobsWantDrawingActiveState];
+
+			if (!active)
+				knobType |= kDKKnobIsInactiveFlag;
+		}
+
+		NSSize ahs = [self actualHandleSize];
+
+		if (ahs.width >= 1.0 || ahs.height >= 1.0) {
+			DKHandle* handle = [self handleForType:knobType];
+			[handle drawAtPoints:points
+						   count:count
+						   angle:radians];
+		}
+		return;
+	}
+#endif
+
+	for (NSUInteger i = 0; i < count; ++i)
+		[self drawKnobAtPoint:points[i]
+					   ofType:knobType
+						angle:radians
+					 userInfo:nil];
+}
+
+- (void)drawKnobsAtPoints:(const NSPoint*)points ofTypes:(const DKKnobType*)types count:(NSUInteger)count
+{
+	if (count == 0)
+		return;
+
+	// a selection rarely uses more than a handful of knob types, so each distinct type is gathered with a pass over the list
+
+	NSPoint* group = malloc(count * sizeof(NSPoint));
+	BOOL* done = calloc(count, sizeof(BOOL));
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		if (done[i])
+			continue;
+
+		DKKnobType type = types[i];
+		NSUInteger n = 0;
+
+		for (NSUInteger j = i; j < count; ++j) {
+			if (!done[j] && types[j] == type) {
+				group[n++] = points[j];
+				done[j] = YES;
+			}
+		}
+
+		[self drawKnobsAtPoints:group
+						  count:n
+						 ofType:type
+						  angle:0.0];
+	}
+
+	free(done);
+	free(group);
+}
+
 - (void)drawControlBarFromPoint:(NSPoint)a toPoint:(NSPoint)b
 {
 	BOOL active = YES;
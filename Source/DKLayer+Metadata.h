@@ -69,6 +69,12 @@ typedef NS_ENUM(NSInteger, DKLayerMetadataSchema) {
 - (void)metadataWillChangeKey:(nullable NSString*)key;
 - (void)metadataDidChangeKey:(nullable NSString*)key;
 
+/** @brief Discard the metadata items that objects in the layer, or in any layer it contains, have remembered from their containers.
+
+ Called when the layer's metadata changes or the layer moves to a new group; there's rarely any need to call it directly.
+ */
+- (void)invalidateInheritedMetadata;
+
 @end
 
 extern NSString* const kDKLayerMetadataUserInfoKey;
@@ -80,7 +80,7 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 		[self metadataWillChangeKey:key];
 		item = [item copy];
 		[[self metadata] setObject:item
-							forKey:[key lowercaseString]];
+							forKey:DKMetadataKey(key)];
 
 		[self metadataDidChangeKey:key];
 	}
@@ -88,7 +88,7 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 
 - (DKMetadataItem*)metadataItemForKey:(NSString*)key
 {
-	DKMetadataItem* item = [[self metadata] objectForKey:[key lowercaseString]];
+	DKMetadataItem* item = [[self metadata] objectForKey:DKMetadataKey(key)];
 
 	if (item == nil)
 		item = [[self layerGroup] metadataItemForKey:key];
@@ -194,7 +194,7 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 		[self setupMetadata];
 		[self metadataWillChangeKey:key];
 		[[self metadata] setObject:obj
-							forKey:[key lowercaseString]];
+							forKey:DKMetadataKey(key)];
 		[self metadataDidChangeKey:key];
 	}
 }
@@ -206,7 +206,7 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 	// as a keypath, and will return the property at that keypath. This allows stuff that
 	// reads metadata to introspect objects in the framework - for example $style.name returns the style name, etc.
 
-	if ([key length] > 1 && [[key substringWithRange:NSMakeRange(0, 1)] isEqualToString:@"$"]) {
+	if ([key length] > 1 && [key characterAtIndex:0] == '$') {
 		NSString* keyPath = [key substringFromIndex:1];
 		return [self valueForKeyPath:keyPath];
 	}
@@ -217,7 +217,7 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 
 #else
 
-	id object = [[self metadata] objectForKey:[key lowercaseString]];
+	id object = [[self metadata] objectForKey:DKMetadataKey(key)];
 
 	// search upwards through the containment hierarchy for the data. If it is anywhere between here and the root drawing, it will be found.
 
@@ -260,7 +260,7 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 	}
 #endif
 	[self metadataWillChangeKey:key];
-	[[self metadata] removeObjectForKey:[key lowercaseString]];
+	[[self metadata] removeObjectForKey:DKMetadataKey(key)];
 	[self metadataDidChangeKey:key];
 }
 
@@ -378,7 +378,7 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 {
 	NSDictionary* userInfo = nil;
 	if (key)
-		userInfo = @{ @"key": [key lowercaseString] };
+		userInfo = @{ @"key": DKMetadataKey(key) };
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKMetadataWillChangeNotification
 														object:self
 													  userInfo:userInfo];
@@ -386,14 +386,21 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 
 - (void)metadataDidChangeKey:(NSString*)key
 {
+	[self invalidateInheritedMetadata];
+
 	NSDictionary* userInfo = nil;
 	if (key)
-		userInfo = @{ @"key": [key lowercaseString] };
+		userInfo = @{ @"key": DKMetadataKey(key) };
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKMetadataDidChangeNotification
 														object:self
 													  userInfo:userInfo];
 }
 
+- (void)invalidateInheritedMetadata
+{
+	// a plain layer has no objects of its own that inherit from it
+}
+
 #pragma mark -
 
 - (void)updateMetadataKeys
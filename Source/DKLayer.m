@@ -166,7 +166,21 @@ static NSArray* s_selectionColours = nil;
 #pragma mark -
 #pragma mark - layer group hierarchy
 
-@synthesize layerGroup = m_groupRef;
+- (DKLayerGroup*)layerGroup
+{
+	return m_groupRef;
+}
+
+- (void)setLayerGroup:(DKLayerGroup*)group
+{
+	if (group != m_groupRef) {
+		m_groupRef = group;
+
+		// the objects in this layer inherit metadata from a different group now
+
+		[self invalidateInheritedMetadata];
+	}
+}
 
 /** @brief Gets the layer's index within the group that the layer is contained in
 
@@ -679,6 +693,7 @@ static NSArray* s_selectionColours = nil;
 - (void)setUserInfo:(NSMutableDictionary*)info
 {
 	mUserInfo = [info mutableCopy];
+	[self invalidateInheritedMetadata];
 }
 
 /** @brief Add a dictionary of metadata to the object
@@ -694,6 +709,7 @@ static NSArray* s_selectionColours = nil;
 	NSDictionary* deepCopy = [info deepCopy];
 
 	[mUserInfo addEntriesFromDictionary:deepCopy];
+	[self invalidateInheritedMetadata];
 }
 
 /** @brief Return the attached user info
@@ -731,6 +747,7 @@ static NSArray* s_selectionColours = nil;
 
 	[[self userInfo] setObject:obj
 						forKey:key];
+	[self invalidateInheritedMetadata];
 }
 
 #pragma mark -
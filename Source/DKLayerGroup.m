@@ -7,6 +7,7 @@
 #import "DKLayerGroup.h"
 #import "DKDrawKitMacros.h"
 #import "DKDrawing.h"
+#import "DKLayer+Metadata.h"
 #import "LogEvent.h"
 
 #pragma mark Constants(Non - localized)
@@ -799,6 +800,11 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 								   withObject:um];
 }
 
+- (void)invalidateInheritedMetadata
+{
+	[[self layers] makeObjectsPerformSelector:@selector(invalidateInheritedMetadata)];
+}
+
 /** @brief Draws the layers it contains
 
  Layers are not drawn if they lie below the highest opaque layer, or if we are printing and the layer
@@ -6,6 +6,7 @@
 
 #import "DKLinearObjectStorage.h"
 #import "LogEvent.h"
+#import "DKTrace.h"
 
 @implementation DKLinearObjectStorage
 
@@ -13,6 +14,7 @@
 
 - (NSArray*)objectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options
 {
+	DKTraceScope(span, kDKTraceStorage, "linear storage objects in rect");
 	NSMutableArray* temp = [NSMutableArray array];
 	NSEnumerator* iter;
 
@@ -39,6 +41,7 @@
 		}
 	}
 
+	span.argument = [temp count];
 	return temp;
 }
 
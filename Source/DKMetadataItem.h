@@ -183,6 +183,13 @@ DKMetadataItems are used to store metadata (attribute) values in user info dicti
 extern NSPasteboardType DKSingleMetadataItemPBoardType NS_SWIFT_NAME(dkSingleMetadataItem);
 extern NSPasteboardType DKMultipleMetadataItemsPBoardType NS_SWIFT_NAME(dkMultipleMetadataItems);
 
+/** @brief Return the canonical form of a metadata key.
+
+ Metadata keys are case insensitive, and are stored lowercased. This returns the lowercased key, remembering it so that later
+ lookups with the same key don't have to lowercase it again. Safe to call from any thread.
+ */
+extern NSString* DKMetadataKey(NSString* key);
+
 //! objects can optionally implement any of the following to assist with additional conversions:
 @protocol DKMetadataItemConversions <NSObject>
 
@@ -9,6 +9,28 @@
 NSString* DKSingleMetadataItemPBoardType = @"com.apptree.dk.meta";
 NSString* DKMultipleMetadataItemsPBoardType = @"com.apptree.dk.multimeta";
 
+NSString* DKMetadataKey(NSString* key)
+{
+	// NSCache is thread safe, and a bound on it means that a stream of one-off keys can't grow it without limit
+
+	static NSCache* sKeys = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sKeys = [[NSCache alloc] init];
+		[sKeys setCountLimit:1024];
+	});
+
+	NSString* canonicalKey = [sKeys objectForKey:key];
+
+	if (canonicalKey == nil) {
+		canonicalKey = [key lowercaseString];
+		[sKeys setObject:canonicalKey
+				  forKey:[key copy]];
+	}
+
+	return canonicalKey;
+}
+
 @interface DKMetadataItem ()
 
 - (void)assignValue:(id)aValue;
@@ -44,6 +44,7 @@ NS_ASSUME_NONNULL_BEGIN
 	NSArray<DKDrawableObject*>* m_objectsPendingDrag; // temporary list of objects being dragged from the layer
 	__unsafe_unretained DKDrawableObject* mKeyAlignmentObject; // the master object to which others can be aligned
 	NSRect mSelBoundsCached; // cached value of the selection bounds
+	BOOL mMarqueeExtending; // the extend flag passed to the last -changeSelectionForMarqueeRect:fromRect:extending:
 }
 
 // default settings:
@@ -252,6 +253,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)exchangeSelectionWithObjectsFromArray:(NSArray<DKDrawableObject*>*)sel;
 
+/** @brief Update the selection to follow a marquee that has changed from \c oldRect to <code>rect</code>.
+
+ Only objects touching the area that differs between the two rects can change state, so only that area is queried, and
+ only the objects whose state actually changes are updated and redrawn. The selection must already be the one made by
+ <code>oldRect</code>; if \c oldRect is empty, or \c extend differs from the last call, the whole of \c rect is queried
+ instead, and if \c extend is \c NO everything outside \c rect is deselected.
+ @param rect the new marquee rect
+ @param oldRect the marquee rect the current selection was made with
+ @param extend YES to add to the selection only, as in a shift-drag
+ @return YES if the selection changed, NO if it did not
+ */
+- (BOOL)changeSelectionForMarqueeRect:(NSRect)rect fromRect:(NSRect)oldRect extending:(BOOL)extend;
+
 /** @brief Scrolls one or all views attached to the drawing so that the selection within this layer is visible
  @param aView if not nil, the view to scroll. If nil, scrolls all views
  */
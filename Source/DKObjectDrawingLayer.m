@@ -475,7 +475,7 @@ enum {
 - (void)deselectAll
 {
 	if ([self isSelectionNotEmpty]) {
-		[self refreshSelectedObjects];
+		[m_selection makeObjectsPerformSelector:@selector(notifySelectionChange)];
 		[m_selection makeObjectsPerformSelector:@selector(objectIsNoLongerSelected)];
 		[m_selection removeAllObjects];
 		[self hideRulerMarkers];
@@ -506,7 +506,7 @@ enum {
 	if (![m_selection containsObject:obj] && ![self lockedOrHidden] && [obj objectMayBecomeSelected]) {
 		[m_selection addObject:obj];
 		[obj objectDidBecomeSelected];
-		[obj notifyVisualChange];
+		[obj notifySelectionChange];
 		mSelBoundsCached = NSZeroRect;
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
 															object:self];
@@ -559,7 +559,7 @@ enum {
 			[self bufferObject:obj
 				forSelectionOp:kObjectRemove];
 		else {
-			[obj notifyVisualChange];
+			[obj notifySelectionChange];
 			[obj objectIsNoLongerSelected];
 			[m_selection removeObject:obj];
 
@@ -642,12 +642,12 @@ enum {
 					[newSel minusSet:m_selection]; // these are not present in the old selection, so will be selected
 
 					[oldSel makeObjectsPerformSelector:@selector(objectIsNoLongerSelected)];
-					[oldSel makeObjectsPerformSelector:@selector(notifyVisualChange)];
+					[oldSel makeObjectsPerformSelector:@selector(notifySelectionChange)];
 
 					[m_selection setSet:[NSSet setWithArray:sel]];
 
 					[newSel makeObjectsPerformSelector:@selector(objectDidBecomeSelected)];
-					[newSel makeObjectsPerformSelector:@selector(notifyVisualChange)];
+					[newSel makeObjectsPerformSelector:@selector(notifySelectionChange)];
 
 					mSelBoundsCached = NSZeroRect;
 					[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
@@ -663,6 +663,85 @@ enum {
 	return didChange;
 }
 
+/** @brief Update the selection to follow a marquee that has changed from \c oldRect to <code>rect</code>.
+
+ Only objects touching the area that differs between the two rects can change state, so only that area is queried, and
+ only the objects whose state actually changes are updated. The whole change is redrawn as one area. The selection must
+ already be the one made by <code>oldRect</code>; if \c oldRect is empty the whole of \c rect is queried instead, and if
+ \c extend is \c NO everything outside \c rect is deselected.
+ @param rect the new marquee rect
+ @param oldRect the marquee rect the current selection was made with
+ @param extend YES to add to the selection only, as in a shift-drag
+ @return YES if the selection changed, NO if it did not
+ */
+- (BOOL)changeSelectionForMarqueeRect:(NSRect)rect fromRect:(NSRect)oldRect extending:(BOOL)extend
+{
+	if ([self lockedOrHidden])
+		return NO;
+
+	// with no previous marquee, or while changes are being buffered, there's no delta to work from. Nor is there if the extend flag
+	// changed since the last call, since objects outside the area between the rects may now have to be deselected.
+
+	BOOL extendChanged = (extend != mMarqueeExtending);
+	mMarqueeExtending = extend;
+
+	if (NSIsEmptyRect(oldRect) || extendChanged || [self isBufferingSelectionChanges]) {
+		NSArray* sel = [self objectsInRect:rect];
+
+		if (extend) {
+			NSUInteger before = [m_selection count];
+			[self addObjectsToSelectionFromArray:sel];
+			return [m_selection count] != before;
+		} else
+			return [self exchangeSelectionWithObjectsFromArray:sel];
+	}
+
+	if (NSEqualRects(rect, oldRect))
+		return NO;
+
+	// an object can only have changed state if it touches the area between the two rects. Those that do are tested
+	// against the new rect to find their new state; the objects in the storage's query are visible by definition.
+
+	NSMutableSet* candidates = [NSMutableSet set];
+
+	for (NSValue* v in DifferenceOfTwoRects(oldRect, rect))
+		[candidates addObjectsFromArray:[self objectsInRect:[v rectValue]]];
+
+	NSMutableArray* selected = [NSMutableArray array];
+	NSMutableArray* deselected = [NSMutableArray array];
+
+	for (DKDrawableObject* od in candidates) {
+		BOOL wasSelected = [m_selection containsObject:od];
+		BOOL inRect = !NSIsEmptyRect(rect) && [od intersectsRect:rect];
+
+		if (inRect && !wasSelected && [od objectMayBecomeSelected])
+			[selected addObject:od];
+		else if (!inRect && wasSelected && !extend)
+			[deselected addObject:od];
+	}
+
+	if ([selected count] == 0 && [deselected count] == 0)
+		return NO;
+
+	for (DKDrawableObject* od in deselected) {
+		[od objectIsNoLongerSelected];
+		[m_selection removeObject:od];
+		[od notifySelectionChange];
+	}
+
+	for (DKDrawableObject* od in selected) {
+		[m_selection addObject:od];
+		[od objectDidBecomeSelected];
+		[od notifySelectionChange];
+	}
+
+	mSelBoundsCached = NSZeroRect;
+	[self updateRulerMarkersForRect:[self selectionLogicalBounds]];
+	[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
+														object:self];
+	return YES;
+}
+
 /** @brief Scrolls one or all views attached to the drawing so that the selection within this layer is visible
  @param aView if not nil, the view to scroll. If nil, scrolls all views
  */
@@ -2172,16 +2251,21 @@ enum {
 
 				// draw the objects
 
+				[self prepareDisplayListsForObjects:objectsToDraw];
+
 				if (!drawSelected || [self drawsSelectionHighlightsOnTop]) {
 
 					for (DKDrawableObject* obj in objectsToDraw) {
-						[obj drawContentWithSelectedState:NO];
+						[self drawObjectContent:obj];
 					}
 
 				} else {
 
 					for (DKDrawableObject* obj in objectsToDraw) {
-						[obj drawContentWithSelectedState:[self isSelectedObject:obj]];
+						if ([self isSelectedObject:obj])
+							[obj drawContentWithSelectedState:YES];
+						else
+							[self drawObjectContent:obj];
 					}
 				}
 
@@ -11,7 +11,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawableObject, DKStyle;
+@class DKDrawableObject, DKStyle, DKAxisIndex, DKMetadataItem;
 
 /** @brief caching options
  */
@@ -19,7 +19,8 @@ typedef NS_OPTIONS(NSUInteger, DKLayerCacheOption) {
 	kDKLayerCacheNone = 0, //!< no caching
 	kDKLayerCacheUsingPDF = (1 << 0), //!< layer is cached in a PDF Image Rep
 	kDKLayerCacheUsingCGLayer = (1 << 1), //!< layer is cached in a CGLayer bitmap
-	kDKLayerCacheObjectOutlines = (1 << 2) //!< objects are drawn using a simple outline stroke only
+	kDKLayerCacheObjectOutlines = (1 << 2), //!< objects are drawn using a simple outline stroke only
+	kDKLayerCacheObjectDisplayLists = (1 << 3) //!< each object's content is recorded once into a display list and replayed until it changes
 };
 
 // the class
@@ -48,6 +49,11 @@ application needs.
  
  NOTE: PDF caching has been shown to be actually slower when there are many objects, espcially with advanced storage in use. This is
  because it's an all-or-nothing rendering proposition which direct drawing of a layer's objects is not.
+
+ Display lists work per object instead, and apply whether the layer is active or not. Each object's unselected content is recorded once
+ into a display list (the paths, paints and clips its style produces) and replayed on later updates, so the style is only rendered again
+ after the object notifies a visual change, or the view is zoomed. Objects needing a new list are all recorded before any are drawn, and
+ drawing then proceeds strictly in Z-order.
 */
 @interface DKObjectOwnerLayer : DKLayer <NSCoding, NSDraggingDestination, DKDrawableContainer> {
 @private
@@ -55,6 +61,7 @@ application needs.
 	NSPoint m_pasteAnchor; // used when recording the paste/duplication offset
 	BOOL m_allowEditing; // YES to allow editing of objects, NO to prevent
 	BOOL m_allowSnapToObjects; // YES to let snapping look for other objects
+	BOOL m_snapToSmartGuides; // YES to let dragged objects align with the edges and centres of other objects
 	DKDrawableObject* mNewObjectPending; // temporary object being created - is drawn and handled as a normal object but can be deleted without undo
 	DKLayerCacheOption mLayerCachingOption; // see constants defined above
 	NSRect mCacheBounds; // the bounds rect of the cached layer or PDF rep - used to accurately position the cache when drawn
@@ -63,6 +70,12 @@ application needs.
 	BOOL m_recordPasteOffset; // set to YES following a paste, and NO following a drag. When YES, paste offset is recorded.
 	NSInteger mPasteboardLastChange; // last change count recorded during a paste
 	NSInteger mPasteCount; // number of repeated paste operations since last new paste
+	NSMutableDictionary<NSString*, NSMutableArray<DKDrawableObject*>*>* mObjectsByStyleKey; // objects keyed by their style's unique key, built on demand
+	NSMutableArray<DKDrawableObject*>* mObjectsWithoutStyle; // objects (typically groups) not in mObjectsByStyleKey
+	DKAxisIndex* mSmartGuidesX; // left edges, centres and right edges of objects, built on demand
+	DKAxisIndex* mSmartGuidesY; // bottom edges, centres and top edges of objects, built on demand
+	NSMapTable<DKDrawableObject*, NSValue*>* mSmartGuideRects; // the rect each object was last indexed with, weakly keyed
+	NSHashTable<DKDrawableObject*>* mSmartGuidesPending; // objects added or moved since the smart guides were updated, held weakly
 @protected
 	BOOL mShowStorageDebugging; // if YES, draws the debugging path for the storage on top (debugging feature only)
 }
@@ -149,12 +162,24 @@ application needs.
 /** @brief Returns objects that share the given style.
 
  The style is compared by unique key, so style clones are not considered a match. Unavailable objects are
- also included.
+ also included. The layer keeps an index of the objects using each style, so this takes time proportional to
+ the number of matches rather than the number of objects. The objects are returned in no particular order.
  @param style The style to compare.
  @return An array of those objects that have the style.
  */
 - (NSArray<DKDrawableObject*>*)objectsWithStyle:(DKStyle*)style NS_SWIFT_NAME(objectsWith(_:));
 
+/** @brief Returns objects whose metadata item for a key passes a test.
+
+ The item tested for each object is the one it would return from <code>-metadataItemForKey:</code>, so an object with no item
+ of its own is tested against the item it inherits from its group, this layer or the drawing. Objects that inherit the same
+ item share one evaluation of the test. Objects with no item for the key at all are not tested and are not returned.
+ @param key The metadata key.
+ @param predicate A block that returns YES for the items whose objects should be returned.
+ @return An array of the matching objects, in the order they are stacked in the layer.
+ */
+- (NSArray<DKDrawableObject*>*)objectsWithMetadataKey:(NSString*)key passingTest:(BOOL (^)(DKMetadataItem* item))predicate;
+
 /** @brief Returns objects that respond to the selector with the value <code>answer</code>.
 
  This is a very simple type of predicate test. Note - the method \c selector must not return
@@ -393,6 +418,14 @@ application needs.
  */
 - (void)drawable:(DKDrawableObject*)obj needsDisplayInRect:(NSRect)rect;
 
+/** @brief Called by an object in the layer when its bounds change.
+
+ The layer uses this to keep its smart guides up to date.
+ @param obj The object whose bounds changed.
+ @param oldBounds Its bounds before the change.
+ */
+- (void)drawable:(DKDrawableObject*)obj didChangeBoundsFrom:(NSRect)oldBounds;
+
 /** @brief Draws all of the visible objects.
  
  This is used when drawing the layer into special contexts, not for view rendering.
@@ -677,6 +710,18 @@ application needs.
  */
 - (NSPoint)snappedMousePoint:(NSPoint)mp forObject:(DKDrawableObject*)obj withControlFlag:(BOOL)snapControl;
 
+/** @brief Find the offset that aligns an edge or the centre of a rect with an edge or centre of another object.
+
+ These are "smart guides": every object in the layer acts as a guide along its left, right, top and bottom edges and through
+ its centre, in each direction. The positions are kept in sorted indexes, so the search takes logarithmic time however many
+ objects there are. The indexes are built the first time this is called and kept up to date after that.
+ @param rect The rect to snap, typically the logical bounds of an object being dragged.
+ @param objects Objects to ignore, typically those being dragged. May be <code>nil</code>.
+ @param tol An edge or centre must be closer than this to snap.
+ @return The distance to move the rect in each direction; a component is 0 if nothing was close enough in that direction.
+ */
+- (NSSize)smartGuideOffsetForRect:(NSRect)rect excludingObjects:(nullable NSArray<DKDrawableObject*>*)objects tolerance:(CGFloat)tol;
+
 /** @}
  @name Options
  @{ */
@@ -693,6 +738,13 @@ application needs.
  */
 @property BOOL allowsSnapToObjects;
 
+/** @brief Do objects dragged in the layer align with the edges and centres of its other objects?
+
+ Smart guide snapping is applied as objects are dragged, in addition to snapping to the grid and guides, when this and
+ \c allowsSnapToObjects are both set. Default is \c NO.
+ */
+@property BOOL snapsToSmartGuides;
+
 /** @brief Query whether the layer caches its content in an offscreen layer when not active.
 
  Layers can cache their entire contents offscreen when they are inactive. This can boost
@@ -701,6 +753,19 @@ application needs.
  */
 @property (nonatomic) DKLayerCacheOption layerCacheOption;
 
+/** @brief Record display lists for any of the objects that need one.
+
+ Does nothing unless the layer's cache option includes \c kDKLayerCacheObjectDisplayLists and drawing is to the screen at high quality.
+ Call before drawing the objects with \c -drawObjectContent: so that recording can be done in one batch.
+ @param objects the objects about to be drawn
+ */
+- (void)prepareDisplayListsForObjects:(NSArray<DKDrawableObject*>*)objects;
+
+/** @brief Draw the object's unselected content, from its display list if it has one.
+ @param obj the object to draw
+ */
+- (void)drawObjectContent:(DKDrawableObject*)obj;
+
 /** @brief Set whether the layer is currently highlighted for a drag (receive) operation.
  Is \c YES if highlighted, \c NO otherwise.
  */
@@ -5,8 +5,10 @@
 */
 
 #import "DKObjectOwnerLayer.h"
+#import "DKAxisIndex.h"
 #import "DKBSPObjectStorage.h"
 #import "DKDrawKitMacros.h"
+#import "DKDrawableObject+Metadata.h"
 #import "DKDrawing.h"
 #import "DKDrawingView.h"
 #import "DKGeometryUtilities.h"
@@ -18,9 +20,12 @@
 #import "DKSelectionPDFView.h"
 #import "DKStyle.h"
 #import "DKTextShape.h"
+#import "DKTrace.h"
 #import "DKUndoManager.h"
 #import "LogEvent.h"
 
+#define kDKSmartGuideIncrementalLimit 8
+
 // constants
 
 NSString* const kDKLayerWillAddObject = @"kDKLayerWillAddObject";
@@ -31,11 +36,37 @@ NSString* const kDKLayerDidRemoveObject = @"kDKLayerDidRemoveObject";
 @interface DKObjectOwnerLayer ()
 - (void)updateCache;
 - (void)invalidateCache;
+
+// style index
+
+- (void)buildStyleIndexIfNeeded;
+- (void)invalidateStyleIndex;
+- (void)indexObject:(DKDrawableObject*)obj withStyle:(nullable DKStyle*)style;
+- (void)unindexObject:(DKDrawableObject*)obj withStyle:(nullable DKStyle*)style;
+- (void)drawableStyleWasAttached:(NSNotification*)note;
+
+// smart guides
+
+- (void)buildSmartGuidesIfNeeded;
+- (void)invalidateSmartGuides;
+- (void)smartGuidesNeedUpdateForObject:(DKDrawableObject*)obj;
+- (void)removeSmartGuidesForObjects:(NSArray<DKDrawableObject*>*)objects;
+- (void)unindexSmartGuidesForObject:(DKDrawableObject*)obj;
+- (void)updateSmartGuides;
 @end
 
 static Class sStorageClass = nil;
 static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
+// the device scale of the current context, which display lists are recorded at and keyed by
+
+static CGFloat displayListScaleOfCurrentContext(void)
+{
+	CGAffineTransform ctm = CGContextGetUserSpaceToDeviceSpaceTransform([[NSGraphicsContext currentContext] graphicsPort]);
+
+	return hypot(ctm.a, ctm.b);
+}
+
 @implementation DKObjectOwnerLayer
 #pragma mark As a DKObjectOwnerLayer
 
@@ -69,6 +100,8 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 		LogEvent_(kReactiveEvent, @"owner layer (%@) setting storage = %@", self, storage);
 
 		mStorage = storage;
+		[self invalidateStyleIndex];
+		[self invalidateSmartGuides];
 	}
 }
 
@@ -93,6 +126,8 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 															object:self];
 
 		[[self storage] setObjects:objs];
+		[self invalidateStyleIndex];
+		[self invalidateSmartGuides];
 
 		[[self objects] makeObjectsPerformSelector:@selector(setContainer:)
 										withObject:self];
@@ -176,15 +211,56 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (NSArray*)objectsWithStyle:(DKStyle*)style
 {
-	NSMutableArray* ao = [[NSMutableArray alloc] init];
 	NSString* key = [style uniqueKey];
 
-	for (DKDrawableObject* od in self.objects) {
-		if ([[[od style] uniqueKey] isEqualToString:key])
-			[ao addObject:od];
+	if (key == nil)
+		return @[];
+
+	[self buildStyleIndexIfNeeded];
+
+	NSArray* matches = [mObjectsByStyleKey objectForKey:key];
+
+	return matches ? [matches copy] : @[];
+}
+
+- (NSArray*)objectsWithMetadataKey:(NSString*)key passingTest:(BOOL (^)(DKMetadataItem* item))predicate
+{
+	NSMutableArray* result = [NSMutableArray array];
+	NSMapTable* inheritedAnswers = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+														 valueOptions:NSPointerFunctionsStrongMemory];
+
+	key = DKMetadataKey(key);
+
+	for (DKDrawableObject* od in [self objects]) {
+		DKMetadataItem* item = [[od metadata] objectForKey:key];
+		BOOL passed;
+
+		if (item)
+			passed = predicate(item);
+		else {
+			// usually many objects inherit the same item, so each inherited item is only tested once
+
+			item = [od metadataItemForKey:key];
+
+			if (item == nil)
+				continue;
+
+			NSNumber* answer = [inheritedAnswers objectForKey:item];
+
+			if (answer == nil) {
+				answer = @(predicate(item));
+				[inheritedAnswers setObject:answer
+									 forKey:item];
+			}
+
+			passed = [answer boolValue];
+		}
+
+		if (passed)
+			[result addObject:od];
 	}
 
-	return ao;
+	return result;
 }
 
 - (NSArray*)objectsReturning:(NSInteger)answer toSelector:(SEL)selector
@@ -271,7 +347,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 {
 	NSAssert(obj != nil, @"attempt to add a nil object to the layer");
 
-	LogEvent_(kReactiveEvent, @"inserting %@ at: %lu, count = %lu", obj, (unsigned long)indx, (unsigned long)[self countOfObjects]);
+	DKTraceInstant(kDKTraceLayers, "insert object at index", indx);
 
 	if (![[self storage] containsObject:obj] && ![self lockedOrHidden]) {
 		[[[self undoManager] prepareWithInvocationTarget:self] removeObject:obj];
@@ -282,6 +358,9 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 		[obj setContainer:self];
 		[obj notifyVisualChange];
 		[obj objectWasAddedToLayer:self];
+		[self indexObject:obj
+				withStyle:[obj style]];
+		[self smartGuidesNeedUpdateForObject:obj];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerDidAddObject
 															object:self];
 	}
@@ -293,7 +372,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 	if (![self lockedOrHidden]) {
 		DKDrawableObject* obj = [self objectInObjectsAtIndex:indx];
-		LogEvent_(kReactiveEvent, @"removing object %@, index = %lu", obj, (unsigned long)indx);
+		DKTraceInstant(kDKTraceLayers, "remove object at index", indx);
 
 		[[[self undoManager] prepareWithInvocationTarget:self] insertObject:obj
 														   inObjectsAtIndex:indx];
@@ -303,6 +382,9 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 		[obj notifyVisualChange];
 		[[self storage] removeObjectFromObjectsAtIndex:indx];
 		[obj objectWasRemovedFromLayer:self];
+		[self unindexObject:obj
+				  withStyle:[obj style]];
+		[self removeSmartGuidesForObjects:@[obj]];
 		[obj setContainer:nil];
 
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerDidRemoveObject
@@ -327,12 +409,18 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 		[old notifyVisualChange];
 		[old objectWasRemovedFromLayer:self];
 		[old setContainer:nil];
+		[self unindexObject:old
+				  withStyle:[old style]];
+		[self removeSmartGuidesForObjects:@[old]];
 
 		[[self storage] replaceObjectInObjectsAtIndex:indx
 										   withObject:obj];
 		[obj setContainer:self];
 		[obj notifyVisualChange];
 		[obj objectWasAddedToLayer:self];
+		[self indexObject:obj
+				withStyle:[obj style]];
+		[self smartGuidesNeedUpdateForObject:obj];
 
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerDidRemoveObject
 															object:self];
@@ -361,6 +449,12 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 		[objs makeObjectsPerformSelector:@selector(objectWasAddedToLayer:)
 							  withObject:self];
 
+		for (DKDrawableObject* obj in objs) {
+			[self indexObject:obj
+					withStyle:[obj style]];
+			[self smartGuidesNeedUpdateForObject:obj];
+		}
+
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerDidAddObject
 															object:self];
 	}
@@ -384,6 +478,12 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 			[[self storage] removeObjectsAtIndexes:set];
 			[objs makeObjectsPerformSelector:@selector(objectWasRemovedFromLayer:)
 								  withObject:self];
+
+			for (DKDrawableObject* obj in objs)
+				[self unindexObject:obj
+						  withStyle:[obj style]];
+
+			[self removeSmartGuidesForObjects:objs];
 			[objs makeObjectsPerformSelector:@selector(setContainer:)
 								  withObject:nil];
 
@@ -934,12 +1034,14 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (DKDrawableObject*)hitTest:(NSPoint)point partCode:(NSInteger*)part
 {
+	DKTraceScope(span, kDKTraceHitTesting, "hit test layer");
 	NSInteger partcode;
 	NSArray* objects = [[self storage] objectsContainingPoint:point];
 
-	LogEvent_(kUserEvent, @"hit-testing %lu objects; layer = %@; objects = %@", (unsigned long)[objects count], self, objects);
+	// the argument is the number of objects tried, which is all of them if nothing was hit
 
 	for (DKDrawableObject* o in objects) {
+		++span.argument;
 		partcode = [o hitPart:point];
 
 		if (partcode != kDKDrawingNoPart) {
@@ -947,8 +1049,6 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 				*part = partcode;
 			}
 
-			LogEvent_(kUserEvent, @"found hit = %@", o);
-
 			return o;
 		}
 	}
@@ -956,8 +1056,6 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	if (part)
 		*part = kDKDrawingNoPart;
 
-	LogEvent_(kUserEvent, @"nothing hit");
-
 	return nil;
 }
 
@@ -1071,6 +1169,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 @synthesize allowsEditing = m_allowEditing;
 @synthesize allowsSnapToObjects = m_allowSnapToObjects;
+@synthesize snapsToSmartGuides = m_snapToSmartGuides;
 @synthesize layerCacheOption = mLayerCachingOption;
 
 - (void)setHighlightedForDrag:(BOOL)highlight
@@ -1129,6 +1228,309 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	// not implemented
 }
 
+#pragma mark -
+#pragma mark - style index
+
+/** @brief Builds the index of objects by style, if it doesn't exist already
+
+ Once built, the index is kept up to date as objects are added and removed and as their styles change. Until something asks for
+ it, there's no index and no cost.
+ */
+- (void)buildStyleIndexIfNeeded
+{
+	if (mObjectsByStyleKey == nil) {
+		if (mObjectsWithoutStyle == nil) {
+			// first time - start listening for objects changing style. The notification is only sent by objects in a layer.
+
+			[[NSNotificationCenter defaultCenter] addObserver:self
+													 selector:@selector(drawableStyleWasAttached:)
+														 name:kDKDrawableStyleWasAttachedNotification
+													   object:nil];
+		}
+
+		mObjectsByStyleKey = [[NSMutableDictionary alloc] init];
+		mObjectsWithoutStyle = [[NSMutableArray alloc] init];
+
+		for (DKDrawableObject* od in [[self storage] objects])
+			[self indexObject:od
+					withStyle:[od style]];
+	}
+}
+
+/** @brief Discards the index when the objects are replaced wholesale; it is rebuilt when next needed
+ */
+- (void)invalidateStyleIndex
+{
+	[mObjectsByStyleKey removeAllObjects];
+	mObjectsByStyleKey = nil;
+}
+
+- (void)indexObject:(DKDrawableObject*)obj withStyle:(DKStyle*)style
+{
+	if (mObjectsByStyleKey == nil)
+		return;
+
+	NSString* key = [style uniqueKey];
+
+	if (key == nil)
+		[mObjectsWithoutStyle addObject:obj];
+	else {
+		NSMutableArray* matches = [mObjectsByStyleKey objectForKey:key];
+
+		if (matches == nil) {
+			matches = [NSMutableArray array];
+			[mObjectsByStyleKey setObject:matches
+								   forKey:key];
+		}
+
+		[matches addObject:obj];
+	}
+}
+
+- (void)unindexObject:(DKDrawableObject*)obj withStyle:(DKStyle*)style
+{
+	if (mObjectsByStyleKey == nil)
+		return;
+
+	NSString* key = [style uniqueKey];
+
+	if (key == nil)
+		[mObjectsWithoutStyle removeObjectIdenticalTo:obj];
+	else {
+		NSMutableArray* matches = [mObjectsByStyleKey objectForKey:key];
+
+		[matches removeObjectIdenticalTo:obj];
+
+		if ([matches count] == 0)
+			[mObjectsByStyleKey removeObjectForKey:key];
+	}
+}
+
+- (void)drawableStyleWasAttached:(NSNotification*)note
+{
+	// only objects directly owned by this layer are indexed - objects inside groups have the group as their container
+
+	DKDrawableObject* obj = [note object];
+
+	if (mObjectsByStyleKey && [obj container] == self) {
+		// the userInfo omits the old style if there wasn't one. The new style is already set.
+
+		[self unindexObject:obj
+				  withStyle:[[note userInfo] objectForKey:kDKDrawableOldStyleKey]];
+		[self indexObject:obj
+				withStyle:[obj style]];
+	}
+}
+
+#pragma mark -
+#pragma mark - smart guides
+
+- (NSSize)smartGuideOffsetForRect:(NSRect)rect excludingObjects:(NSArray*)objects tolerance:(CGFloat)tol
+{
+	NSSize offset = NSZeroSize;
+
+	[self buildSmartGuidesIfNeeded];
+	[self updateSmartGuides];
+
+	NSHashTable* exclude = nil;
+
+	if ([objects count] > 0) {
+		exclude = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality];
+
+		for (DKDrawableObject* od in objects)
+			[exclude addObject:od];
+	}
+
+	CGFloat xs[3] = { NSMinX(rect), NSMidX(rect), NSMaxX(rect) };
+	CGFloat ys[3] = { NSMinY(rect), NSMidY(rect), NSMaxY(rect) };
+	CGFloat d;
+
+	if ([mSmartGuidesX snapOffsetForPositions:xs
+										count:3
+									tolerance:tol
+									excluding:exclude
+									   offset:&d])
+		offset.width = d;
+
+	if ([mSmartGuidesY snapOffsetForPositions:ys
+										count:3
+									tolerance:tol
+									excluding:exclude
+									   offset:&d])
+		offset.height = d;
+
+	return offset;
+}
+
+- (void)drawable:(DKDrawableObject*)obj didChangeBoundsFrom:(NSRect)oldBounds
+{
+#pragma unused(oldBounds)
+
+	// objects inside groups report this too, but only the group's own bounds are indexed
+
+	if ([obj container] == self)
+		[self smartGuidesNeedUpdateForObject:obj];
+}
+
+/** @brief Builds the smart guide indexes, if they don't exist already
+
+ Like the style index, these cost nothing until something snaps to them. After that they're kept up to date as objects are
+ added, removed and moved.
+ */
+- (void)buildSmartGuidesIfNeeded
+{
+	if (mSmartGuidesX == nil) {
+		mSmartGuidesX = [[DKAxisIndex alloc] init];
+		mSmartGuidesY = [[DKAxisIndex alloc] init];
+		mSmartGuideRects = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+												 valueOptions:NSPointerFunctionsStrongMemory];
+		mSmartGuidesPending = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality];
+
+		for (DKDrawableObject* od in [[self storage] objects])
+			[mSmartGuidesPending addObject:od];
+	}
+}
+
+- (void)invalidateSmartGuides
+{
+	mSmartGuidesX = nil;
+	mSmartGuidesY = nil;
+	mSmartGuideRects = nil;
+	mSmartGuidesPending = nil;
+}
+
+- (void)smartGuidesNeedUpdateForObject:(DKDrawableObject*)obj
+{
+	// changes are only noted here and applied in one go when the guides are next used, so an object moved many times between
+	// snaps, or many objects added at once, cost no more than a single update. The layer owns every pending object, so the
+	// weak reference here is only a safeguard.
+
+	[mSmartGuidesPending addObject:obj];
+}
+
+- (void)removeSmartGuidesForObjects:(NSArray<DKDrawableObject*>*)objects
+{
+	// unlike other changes, removals are applied at once: the index doesn't retain its owners, so it must not refer to an
+	// object after the layer lets go of it
+
+	if (mSmartGuidesX == nil)
+		return;
+
+	if ([objects count] <= kDKSmartGuideIncrementalLimit) {
+		for (DKDrawableObject* od in objects) {
+			[mSmartGuidesPending removeObject:od];
+			[self unindexSmartGuidesForObject:od];
+		}
+	} else {
+		NSHashTable* owners = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality];
+
+		for (DKDrawableObject* od in objects) {
+			[mSmartGuidesPending removeObject:od];
+			[mSmartGuideRects removeObjectForKey:od];
+			[owners addObject:od];
+		}
+
+		[mSmartGuidesX removeEntriesWithOwners:owners];
+		[mSmartGuidesY removeEntriesWithOwners:owners];
+	}
+}
+
+- (void)unindexSmartGuidesForObject:(DKDrawableObject*)obj
+{
+	NSValue* old = [mSmartGuideRects objectForKey:obj];
+
+	if (old) {
+		NSRect r = [old rectValue];
+
+		[mSmartGuidesX removePosition:NSMinX(r)
+								owner:obj];
+		[mSmartGuidesX removePosition:NSMidX(r)
+								owner:obj];
+		[mSmartGuidesX removePosition:NSMaxX(r)
+								owner:obj];
+		[mSmartGuidesY removePosition:NSMinY(r)
+								owner:obj];
+		[mSmartGuidesY removePosition:NSMidY(r)
+								owner:obj];
+		[mSmartGuidesY removePosition:NSMaxY(r)
+								owner:obj];
+		[mSmartGuideRects removeObjectForKey:obj];
+	}
+}
+
+- (void)updateSmartGuides
+{
+	NSUInteger count = [mSmartGuidesPending count];
+
+	if (count == 0)
+		return;
+
+	// a few changes are cheapest applied one at a time; beyond that, one pass to remove and one to merge is quicker
+
+	if (count <= kDKSmartGuideIncrementalLimit) {
+		for (DKDrawableObject* od in mSmartGuidesPending) {
+			[self unindexSmartGuidesForObject:od];
+
+			if ([od container] == self) {
+				NSRect r = [od logicalBounds];
+
+				[mSmartGuidesX addPosition:NSMinX(r)
+									 owner:od];
+				[mSmartGuidesX addPosition:NSMidX(r)
+									 owner:od];
+				[mSmartGuidesX addPosition:NSMaxX(r)
+									 owner:od];
+				[mSmartGuidesY addPosition:NSMinY(r)
+									 owner:od];
+				[mSmartGuidesY addPosition:NSMidY(r)
+									 owner:od];
+				[mSmartGuidesY addPosition:NSMaxY(r)
+									 owner:od];
+				[mSmartGuideRects setObject:[NSValue valueWithRect:r]
+									 forKey:od];
+			}
+		}
+	} else {
+		DKAxisIndexEntry* xe = malloc(count * 3 * sizeof(DKAxisIndexEntry));
+		DKAxisIndexEntry* ye = malloc(count * 3 * sizeof(DKAxisIndexEntry));
+		NSUInteger n = 0;
+
+		[mSmartGuidesX removeEntriesWithOwners:mSmartGuidesPending];
+		[mSmartGuidesY removeEntriesWithOwners:mSmartGuidesPending];
+
+		for (DKDrawableObject* od in mSmartGuidesPending) {
+			[mSmartGuideRects removeObjectForKey:od];
+
+			if ([od container] == self) {
+				NSRect r = [od logicalBounds];
+
+				xe[n].position = NSMinX(r);
+				xe[n + 1].position = NSMidX(r);
+				xe[n + 2].position = NSMaxX(r);
+				ye[n].position = NSMinY(r);
+				ye[n + 1].position = NSMidY(r);
+				ye[n + 2].position = NSMaxY(r);
+
+				for (NSUInteger i = n; i < n + 3; ++i)
+					xe[i].owner = ye[i].owner = od;
+
+				n += 3;
+				[mSmartGuideRects setObject:[NSValue valueWithRect:r]
+									 forKey:od];
+			}
+		}
+
+		[mSmartGuidesX addEntries:xe
+							count:n];
+		[mSmartGuidesY addEntries:ye
+							count:n];
+		free(xe);
+		free(ye);
+	}
+
+	[mSmartGuidesPending removeAllObjects];
+}
+
 #pragma mark -
 #pragma mark As a DKLayer
 
@@ -1144,6 +1546,11 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 									  withObject:um];
 }
 
+- (void)invalidateInheritedMetadata
+{
+	[[[self storage] objects] makeObjectsPerformSelector:@selector(invalidateInheritedMetadata)];
+}
+
 /** @brief Called when the drawing's size changed - this gives layers that need to know about this a
  direct notification
 
@@ -1163,8 +1570,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
  */
 - (void)drawingDidChangeMargins:(NSValue*)oldInterior
 {
-	LogEvent_(kReactiveEvent, @"changed margins, old = %@", NSStringFromRect([oldInterior rectValue]));
-
+	DKTraceScope(span, kDKTraceLayers, "layer moves objects for new margins");
 	NSRect old = [oldInterior rectValue];
 	NSRect new = [[self drawing] interior];
 
@@ -1173,6 +1579,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 				  yBy:new.origin.y - old.origin.y];
 
 	[self applyTransformToObjects:tfm];
+	span.argument = [self countOfObjects];
 }
 
 /** @brief Draws the layer and its contents on demand
@@ -1186,13 +1593,15 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 #pragma unused(rect)
 
 	if ([self countOfObjects] > 0) {
-		NSEnumerator* iter = [self objectEnumeratorForUpdateRect:rect
-														  inView:aView];
+		NSArray* objects = [self objectsForUpdateRect:rect
+											   inView:aView];
+
+		// draw the objects - this list has already excluded any not needing to be drawn
 
-		// draw the objects - this enumerator has already excluded any not needing to be drawn
+		[self prepareDisplayListsForObjects:objects];
 
-		for (DKDrawableObject* obj in iter)
-			[obj drawContentWithSelectedState:NO];
+		for (DKDrawableObject* obj in objects)
+			[self drawObjectContent:obj];
 	}
 
 	// draw any pending object on top of the others
@@ -1211,6 +1620,39 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	}
 }
 
+- (void)prepareDisplayListsForObjects:(NSArray*)objects
+{
+	if (([self layerCacheOption] & kDKLayerCacheObjectDisplayLists) == 0 || ![NSGraphicsContext currentContextDrawingToScreen] || [[self drawing] lowRenderingQuality])
+		return;
+
+	// lists are recorded one at a time on this thread - recording draws through AppKit and sets DrawKit's current view, neither of
+	// which can be shared between threads. Each is recorded at the scale it will be replayed at; zooming records them again.
+
+	CGFloat scale = displayListScaleOfCurrentContext();
+
+	for (DKDrawableObject* obj in objects) {
+		if ([obj canRecordDisplayList] && ![obj hasDisplayListAtScale:scale]) {
+			@autoreleasepool {
+				NSData* list = [obj recordDisplayListAtScale:scale];
+
+				if (list)
+					[obj setDisplayList:list
+								  scale:scale];
+			}
+		}
+	}
+}
+
+- (void)drawObjectContent:(DKDrawableObject*)obj
+{
+	// a display list is used only if the layer asks for them, but one made earlier remains valid in low quality mode
+
+	if (([self layerCacheOption] & kDKLayerCacheObjectDisplayLists) != 0 && [NSGraphicsContext currentContextDrawingToScreen] && [obj canRecordDisplayList] && [obj drawContentFromDisplayListAtScale:displayListScaleOfCurrentContext()])
+		return;
+
+	[obj drawContentWithSelectedState:NO];
+}
+
 /** @brief Does the point hit anything in the layer?
  @param p the point to test
  @return YES if any object is hit, NO otherwise
@@ -1227,10 +1669,21 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
  */
 - (NSSet*)allStyles
 {
-	NSEnumerator<DKDrawableObject*>* iter = [[self objects] reverseObjectEnumerator];
+	// each indexed object's style is the only one it contributes, and all of the objects sharing a key share the style, so
+	// only objects outside the index (i.e. groups) need asking
+
+	[self buildStyleIndexIfNeeded];
+
 	NSMutableSet<DKStyle*>* unionOfAllStyles = nil;
 
-	for (DKDrawableObject* dko in iter) {
+	if ([mObjectsByStyleKey count] > 0) {
+		unionOfAllStyles = [NSMutableSet setWithCapacity:[mObjectsByStyleKey count]];
+
+		for (NSArray<DKDrawableObject*>* matches in [mObjectsByStyleKey objectEnumerator])
+			[unionOfAllStyles addObject:[[matches firstObject] style]];
+	}
+
+	for (DKDrawableObject* dko in mObjectsWithoutStyle) {
 		NSSet<DKStyle*>* styles = [dko allStyles];
 
 		if (styles != nil) {
@@ -1340,6 +1793,10 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 #pragma mark As an NSObject
 - (void)dealloc
 {
+	[[NSNotificationCenter defaultCenter] removeObserver:self
+													name:kDKDrawableStyleWasAttachedNotification
+												  object:nil];
+
 	// though we are about to release all the objects, set their container to nil - this ensures that
 	// if anything else is retaining them, when they are later released they won't have stale refs to the drawing, owner, et. al.
 
@@ -1409,6 +1866,8 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 			   forKey:@"editable"];
 	[coder encodeBool:[self allowsSnapToObjects]
 			   forKey:@"snappable"];
+	[coder encodeBool:[self snapsToSmartGuides]
+			   forKey:@"DKObjectOwnerLayer_smartGuides"];
 	[coder encodeInteger:[self layerCacheOption]
 				  forKey:@"DKObjectOwnerLayer_cacheOption"];
 }
@@ -1448,6 +1907,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 							y:20];
 		[self setAllowsEditing:[coder decodeBoolForKey:@"editable"]];
 		[self setAllowsSnapToObjects:[coder decodeBoolForKey:@"snappable"]];
+		[self setSnapsToSmartGuides:[coder decodeBoolForKey:@"DKObjectOwnerLayer_smartGuides"]];
 		[self setLayerCacheOption:[[self class] defaultLayerCacheOption]];
 	}
 	return self;
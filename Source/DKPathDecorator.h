@@ -12,6 +12,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class DKQuartzCache;
 
+/** @brief Where one motif is drawn.
+
+ \c transform maps the motif's own coordinates (its image, with the origin at the bottom left) into those of the path, and \c bounds
+ is the area the placed motif covers in the path's coordinates.
+ */
+typedef struct {
+	CGAffineTransform transform;
+	NSRect bounds;
+} DKMotifPlacement;
+
 /** @brief This renderer draws the image along the path of another object spaced at \c interval distance.
 
  This renderer draws the image along the path of another object spaced at \c interval distance. Each image is scaled by \c scale and is
@@ -36,11 +46,14 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL m_normalToPath;
 	BOOL m_useChainMethod;
 	DKQuartzCache* mDKCache;
+	CGPDFDocumentRef mPDFDocument; // the PDF rep's data, opened once so that motifs can be drawn straight from its page
 	BOOL m_lowQuality;
+	DKMotifPlacement* mPlacements; // the placements found by the last -placeMotifsAlongPath:
+	NSUInteger mPlacementsFound;
+	NSUInteger mPlacementCapacity;
+	uint64_t mRandomSeed; // the random factors of each placement are derived from this and the placement's key
 @protected
 	NSUInteger mPlacementCount;
-	NSMutableArray* mWobbleCache;
-	NSMutableArray* mScaleRandCache;
 }
 
 + (DKPathDecorator*)pathDecoratorWithImage:(nullable NSImage*)image;
@@ -73,6 +86,42 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic) CGFloat leadInAndOutLengthProportion;
 - (CGFloat)rampFunction:(CGFloat)val;
 
+/** @brief Work out where every motif along \c path is drawn, in a single pass over the path.
+
+ This is what -renderPath: uses: the path is measured once, the random wobble and scale factors are read from plain buffers, and
+ the result is a flat array of placements that can be drawn with <code>-drawMotifPlacements:count:</code>. Placements are not culled
+ here, so the result doesn't depend on what is being drawn.
+ @return the number of placements, which are then available from \c motifPlacements
+ */
+- (NSUInteger)placeMotifsAlongPath:(NSBezierPath*)path;
+/** @brief Work out placements for motifs at arbitrary points, as if each were placed on a path at that point and slope.
+
+ This is for subclasses that lay motifs out themselves. \c indexes identify each motif for alternation and for its random factors,
+ so that a motif keeps the same wobble however many of its neighbours are left out; if NULL, the motifs are numbered in order. Any
+ values will do as indexes, since nothing is sized by them.
+ @return the number of placements, which are then available from \c motifPlacements
+ */
+- (NSUInteger)placeMotifsAtPoints:(const NSPoint*)points slopes:(const CGFloat*)slopes indexes:(nullable const NSUInteger*)indexes count:(NSUInteger)count;
+/** @brief The placements found by the last call to <code>-placeMotifsAlongPath:</code>, valid until the next.
+ */
+@property (readonly) const DKMotifPlacement* motifPlacements NS_RETURNS_INNER_POINTER;
+@property (readonly) NSUInteger motifPlacementCount;
+
+/** @brief Draw the motif at each of <code>placements</code>.
+
+ Placements whose bounds fall outside the area being drawn are dropped first, in one pass, and the rest are all drawn with the
+ graphics state set up once.
+ */
+- (void)drawMotifPlacements:(const DKMotifPlacement*)placements count:(NSUInteger)count;
+
+/** @brief Fill \c factors with \c count random factors belonging to <code>key</code>, for subclasses that place motifs themselves.
+
+ The factors are in [-0.5, 0.5) and are derived from the key each time rather than stored, so they stay the same from one rendering
+ to the next and a wobbly pattern doesn't jump about; changing the wobblyness only rescales them. The first three are the ones the
+ receiver uses itself for the motif with that key: its horizontal and vertical wobble and its scale.
+ */
+- (void)getRandomFactors:(CGFloat*)factors count:(NSUInteger)count forKey:(NSUInteger)key;
+
 /**
  experimental: allows use of "chain" callback which emulates links more accurately than image drawing - but really this ought to be
  pushed out into another more specialised class.
@@ -9,6 +9,7 @@
 #import "DKDrawKitMacros.h"
 #import "DKDrawing.h"
 #import "DKDrawingView.h"
+#import "DKFlatPath.h"
 #import "DKGeometryUtilities.h"
 #import "DKQuartzCache.h"
 #import "DKRandom.h"
@@ -18,6 +19,81 @@
 #import "NSBezierPath+Text.h"
 #include <tgmath.h>
 
+// the accuracy to which the path is measured when placing motifs along it
+
+#define kDKPlacementMaximumError 0.1
+
+/** @brief The settings that every placement depends on, read once before a run of placements is computed. */
+typedef struct {
+	NSSize motifSize;
+	CGFloat scale;
+	CGFloat interval;
+	CGFloat lateralOffset;
+	CGFloat wobblyness;
+	CGFloat scaleRandomness;
+	BOOL alternateOffsets;
+	BOOL normalToPath;
+	uint64_t randomSeed;
+} DKPlacementParameters;
+
+static void getRandomFactors(uint64_t seed, NSUInteger key, CGFloat* factors, NSUInteger count)
+{
+	// the factors depend only on the seed and the key, so nothing needs to be kept for them however many motifs there are
+
+	DKRandomState state;
+
+	DKRandomSeed(&state, DKRandomHashBytes(seed, &key, sizeof(key)));
+	DKRandomFillSigned(&state, factors, count, 1.0);
+}
+
+static void placeMotif(const DKPlacementParameters* params, DKMotifPlacement* placement, NSPoint p, CGFloat slope, CGFloat leadScale, NSUInteger index)
+{
+	// displace the image to the side of the path by the lateral offset in the direction normal to the slope. If the offset is 0,
+	// this has no effect except if the alternating flag is also set it flips every other image.
+
+	if ((index & 1) && params->alternateOffsets)
+		slope += M_PI;
+
+	CGFloat tx = p.x + params->lateralOffset * cos(slope + HALF_PI);
+	CGFloat ty = p.y + params->lateralOffset * sin(slope + HALF_PI);
+	CGFloat scale = params->scale * leadScale;
+
+	// wobblyness is a randomising positioning factor from 0..1 that is scaled by the spacing. Scale randomness makes motifs
+	// relatively smaller than the set scale.
+
+	if (params->wobblyness > 0.0 || params->scaleRandomness > 0.0) {
+		CGFloat factors[3];
+
+		getRandomFactors(params->randomSeed, index, factors, 3);
+
+		tx += factors[0] * params->interval * params->wobblyness;
+		ty += factors[1] * params->interval * params->wobblyness;
+		scale *= 1.0 + factors[2] * params->scaleRandomness;
+	}
+
+	CGAffineTransform tfm = CGAffineTransformMakeTranslation(tx, ty);
+
+	tfm = CGAffineTransformScale(tfm, scale, -scale);
+
+	if (params->normalToPath)
+		tfm = CGAffineTransformRotate(tfm, -slope);
+
+	tfm = CGAffineTransformTranslate(tfm, -(params->motifSize.width / 2), -(params->motifSize.height / 2));
+
+	placement->transform = tfm;
+	placement->bounds = NSRectFromCGRect(CGRectApplyAffineTransform(CGRectMake(0, 0, params->motifSize.width, params->motifSize.height), tfm));
+}
+
+@interface DKPathDecorator ()
+
+- (CGFloat)leadScaleAtPosition:(CGFloat)pos ofPathLength:(CGFloat)pathLength;
+- (void)getPlacementParameters:(DKPlacementParameters*)params;
+- (CGPDFPageRef)pdfPage CF_RETURNS_NOT_RETAINED;
+
+@end
+
+#pragma mark -
+
 @implementation DKPathDecorator
 #pragma mark As a DKPathDecorator
 
@@ -34,6 +110,7 @@
 		m_scale = 1.0;
 		m_interval = 50.0;
 		m_normalToPath = YES;
+		mRandomSeed = DKRandomNext(DKRandomThreadState());
 	}
 	return self;
 }
@@ -49,6 +126,8 @@
 	// whatever happens the pdf rep is also released
 
 	m_pdf = nil;
+	CGPDFDocumentRelease(mPDFDocument);
+	mPDFDocument = NULL;
 
 	// remove any CGLayer cache so that next time the rasterizer is used it
 	// will be recreated using the new image
@@ -157,14 +236,7 @@
 {
 	scRand = LIMIT(scRand, 0, 1.0);
 
-	if (scRand != mScaleRandomness) {
-		mScaleRandomness = scRand;
-
-		if (mScaleRandCache == nil)
-			mScaleRandCache = [[NSMutableArray alloc] init];
-
-		[mScaleRandCache removeAllObjects];
-	}
+	mScaleRandomness = scRand;
 }
 
 @synthesize scaleRandomness = mScaleRandomness;
@@ -181,14 +253,7 @@
 {
 	wobble = LIMIT(wobble, 0, 1);
 
-	if (wobble != mWobblyness) {
-		mWobblyness = wobble;
-
-		if (mWobbleCache == nil)
-			mWobbleCache = [[NSMutableArray alloc] init];
-
-		[mWobbleCache removeAllObjects];
-	}
+	mWobblyness = wobble;
 }
 
 @synthesize wobblyness = mWobblyness;
@@ -219,6 +284,226 @@
 	return 0.5 * (1 - cos(fmod(val, 1.0) * M_PI));
 }
 
+- (CGFloat)leadScaleAtPosition:(CGFloat)pos ofPathLength:(CGFloat)pathLength
+{
+	CGFloat loLen = pathLength - m_leadOutLength;
+
+	if (m_leadInLength != 0 && pos <= m_leadInLength)
+		return [self rampFunction:pos / m_leadInLength];
+	else if (m_leadOutLength != 0 && pos >= loLen)
+		return [self rampFunction:1.0 - ((pos - loLen) / m_leadOutLength)];
+
+	return 1.0;
+}
+
+#pragma mark -
+- (void)getPlacementParameters:(DKPlacementParameters*)params
+{
+	params->motifSize = [[self image] size];
+	params->scale = [self scale];
+	params->interval = [self interval];
+	params->lateralOffset = mLateralOffset;
+	params->wobblyness = [self wobblyness];
+	params->scaleRandomness = [self scaleRandomness];
+	params->alternateOffsets = mAlternateLateralOffsets;
+	params->normalToPath = [self normalToPath];
+	params->randomSeed = mRandomSeed;
+}
+
+- (void)getRandomFactors:(CGFloat*)factors count:(NSUInteger)count forKey:(NSUInteger)key
+{
+	getRandomFactors(mRandomSeed, key, factors, count);
+}
+
+- (NSUInteger)placeMotifsAlongPath:(NSBezierPath*)path
+{
+	mPlacementsFound = 0;
+
+	if ([self image] == nil || [self interval] <= 0.0 || [path elementCount] < 2)
+		return 0;
+
+	// measure the path once and sample it in a single pass, rather than finding each point by trimming the path again
+
+	DKFlatPath* flatPath = [DKFlatPath flatPathWithBezierPath:path];
+	CGFloat pathLength = [flatPath lengthWithMaximumError:kDKPlacementMaximumError];
+	NSUInteger maxCount = (NSUInteger)floor(pathLength / [self interval]) + 2;
+	NSPoint* points = malloc(maxCount * sizeof(NSPoint));
+	CGFloat* slopes = malloc(maxCount * sizeof(CGFloat));
+	CGFloat* distances = malloc(maxCount * sizeof(CGFloat));
+
+	NSUInteger count = [flatPath getPoints:points
+									slopes:slopes
+								 distances:distances
+								atInterval:[self interval]
+							  maximumCount:maxCount
+							  maximumError:kDKPlacementMaximumError];
+
+	if (count > mPlacementCapacity) {
+		mPlacementCapacity = count;
+		mPlacements = realloc(mPlacements, mPlacementCapacity * sizeof(DKMotifPlacement));
+	}
+
+	DKPlacementParameters params;
+	BOOL hasLeads = (m_leadInLength != 0 || m_leadOutLength != 0);
+	NSUInteger i, placed = 0;
+
+	[self getPlacementParameters:&params];
+
+	for (i = 0; i < count; ++i) {
+		CGFloat leadScale = hasLeads ? [self leadScaleAtPosition:distances[i]
+													ofPathLength:pathLength]
+									 : 1.0;
+
+		// motifs whose size has reduced to zero are left out, and don't count towards alternation
+
+		if (leadScale <= 0.0)
+			continue;
+
+		placeMotif(&params, &mPlacements[placed], points[i], slopes[i], leadScale, placed);
+		++placed;
+	}
+
+	free(points);
+	free(slopes);
+	free(distances);
+
+	mPlacementsFound = placed;
+	mPlacementCount = placed;
+
+	return placed;
+}
+
+- (NSUInteger)placeMotifsAtPoints:(const NSPoint*)points slopes:(const CGFloat*)slopes indexes:(const NSUInteger*)indexes count:(NSUInteger)count
+{
+	mPlacementsFound = 0;
+
+	if ([self image] == nil || count == 0)
+		return 0;
+
+	if (count > mPlacementCapacity) {
+		mPlacementCapacity = count;
+		mPlacements = realloc(mPlacements, mPlacementCapacity * sizeof(DKMotifPlacement));
+	}
+
+	DKPlacementParameters params;
+	NSUInteger i;
+
+	[self getPlacementParameters:&params];
+
+	for (i = 0; i < count; ++i)
+		placeMotif(&params, &mPlacements[i], points[i], slopes[i], 1.0, indexes ? indexes[i] : i);
+
+	mPlacementsFound = count;
+
+	return count;
+}
+
+@synthesize motifPlacements = mPlacements;
+@synthesize motifPlacementCount = mPlacementsFound;
+
+- (CGPDFPageRef)pdfPage
+{
+	if (m_pdf == nil)
+		return NULL;
+
+	if (mPDFDocument == NULL) {
+		CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)[m_pdf PDFRepresentation]);
+
+		mPDFDocument = CGPDFDocumentCreateWithProvider(provider);
+		CGDataProviderRelease(provider);
+	}
+
+	return CGPDFDocumentGetPage(mPDFDocument, [m_pdf currentPage] + 1);
+}
+
+- (void)drawMotifPlacements:(const DKMotifPlacement*)placements count:(NSUInteger)count
+{
+	NSImage* img = [self image];
+
+	if (img == nil || count == 0)
+		return;
+
+	// cull everything outside the area being drawn in one pass. The view's update rects are used where there is one; otherwise
+	// (drawing into an image, etc.) the bounds of the clip will do
+
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+	DKDrawingView* cv = [DKDrawingView currentlyDrawingView];
+	const NSRect* rects;
+	NSInteger rectCount;
+	NSRect clipRect;
+
+	if (cv != nil)
+		[cv getRectsBeingDrawn:&rects
+						 count:&rectCount];
+	else {
+		clipRect = NSRectFromCGRect(CGContextGetClipBoundingBox(context));
+		rects = &clipRect;
+		rectCount = 1;
+	}
+
+	CGAffineTransform* visible = malloc(count * sizeof(CGAffineTransform));
+	NSRect visibleBounds = NSZeroRect;
+	NSUInteger i, visibleCount = 0;
+	NSInteger r;
+
+	for (i = 0; i < count; ++i) {
+		for (r = 0; r < rectCount; ++r) {
+			if (NSIntersectsRect(placements[i].bounds, rects[r])) {
+				visible[visibleCount++] = placements[i].transform;
+				visibleBounds = placements[i].bounds;
+				break;
+			}
+		}
+	}
+
+	// then draw what's left with the state set up once
+
+	if (visibleCount > 0) {
+		CGContextSaveGState(context);
+
+		CGPDFPageRef page;
+
+		if (mDKCache && m_lowQuality)
+			[mDKCache drawWithTransforms:visible
+								   count:visibleCount];
+		else if ((page = [self pdfPage]) != NULL) {
+			CGRect box = CGPDFPageGetBoxRect(page, kCGPDFCropBox);
+
+			for (i = 0; i < visibleCount; ++i) {
+				CGContextSaveGState(context);
+				CGContextConcatCTM(context, visible[i]);
+				CGContextTranslateCTM(context, -box.origin.x, -box.origin.y);
+				CGContextClipToRect(context, box);
+				CGContextDrawPDFPage(context, page);
+				CGContextRestoreGState(context);
+			}
+		} else {
+			// the image is resolved once, choosing the representation that suits the size motifs are drawn at
+
+			NSSize iSize = [img size];
+			CGRect imageRect = CGRectMake(0, 0, iSize.width, iSize.height);
+			CGImageRef image = [img CGImageForProposedRect:&visibleBounds
+												   context:[NSGraphicsContext currentContext]
+													 hints:nil];
+
+			if (image != NULL) {
+				CGContextSetBlendMode(context, kCGBlendModeSourceAtop);
+
+				for (i = 0; i < visibleCount; ++i) {
+					CGContextSaveGState(context);
+					CGContextConcatCTM(context, visible[i]);
+					CGContextDrawImage(context, imageRect, image);
+					CGContextRestoreGState(context);
+				}
+			}
+		}
+
+		CGContextRestoreGState(context);
+	}
+
+	free(visible);
+}
+
 #pragma mark -
 @synthesize usesChainMethod = m_useChainMethod;
 
@@ -273,28 +558,26 @@
 	return [self initWithImage:nil];
 }
 
+- (void)dealloc
+{
+	CGPDFDocumentRelease(mPDFDocument);
+	free(mPlacements);
+}
+
 #pragma mark -
 #pragma mark As part of BezierPlacement Protocol
 - (id)placeObjectAtPoint:(NSPoint)p onPath:(NSBezierPath*)path position:(CGFloat)pos slope:(CGFloat)slope userInfo:(void*)userInfo
 {
 #pragma unused(userInfo)
 
-	NSImage* img = [self image];
-
-	if (img != nil) {
+	if ([self image] != nil) {
 		NSAssert([NSGraphicsContext currentContext] != nil, @"no context for drawing path decorator motif");
 
-		NSSize iSize = [img size];
-
 		CGFloat leadScale = 1.0;
 
 		if (path != nil) {
-			CGFloat loLen = [path length] - m_leadOutLength;
-
-			if (m_leadInLength != 0 && pos <= m_leadInLength)
-				leadScale = [self rampFunction:pos / m_leadInLength];
-			else if (m_leadOutLength != 0 && pos >= loLen)
-				leadScale = [self rampFunction:1.0 - ((pos - loLen) / m_leadOutLength)];
+			leadScale = [self leadScaleAtPosition:pos
+									 ofPathLength:[path length]];
 
 			// if size has reduced to zero, nothing to do
 
@@ -302,90 +585,14 @@
 				return nil;
 		}
 
-		NSAffineTransform* tfm = [NSAffineTransform transform];
-
-		// displace the image to the side of the path by mLateralOffset in the direction normal to the slope. If the offset is 0,
-		// this has no effect except if the alternating flag is also set it flips every other image.
-
-		if ((mPlacementCount & 1) && mAlternateLateralOffsets)
-			slope += M_PI;
-
-		CGFloat dx = mLateralOffset * cos(slope + HALF_PI);
-		CGFloat dy = mLateralOffset * sin(slope + HALF_PI);
-		NSPoint wobblePoint = NSZeroPoint;
-
-		if ([self wobblyness] > 0.0) {
-			// wobblyness is a randomising positioning factor from 0..1 that is scaled by the spacing and offset by half. This is
-			// cached so that the wobble positions are not recalculated unless the wobble factor itself changes.
-
-			if (mPlacementCount < [mWobbleCache count])
-				wobblePoint = [[mWobbleCache objectAtIndex:mPlacementCount] pointValue];
-			else {
-				wobblePoint.x = [DKRandom randomPositiveOrNegativeNumber] * [self interval] * [self wobblyness];
-				wobblePoint.y = [DKRandom randomPositiveOrNegativeNumber] * [self interval] * [self wobblyness];
-				[mWobbleCache addObject:[NSValue valueWithPoint:wobblePoint]];
-			}
-		}
-
-		CGFloat randScale = 1.0;
+		DKPlacementParameters params;
+		DKMotifPlacement placement;
 
-		if ([self scaleRandomness] > 0.0) {
-			// scale randomness is a randomising factor applied to the scale of the motif. Scale max is always
-			// set to the normal scale, the randomising factor makes the scale relatively smaller
+		[self getPlacementParameters:&params];
+		placeMotif(&params, &placement, p, slope, leadScale, mPlacementCount);
 
-			if (mPlacementCount < [mScaleRandCache count])
-				randScale = [[mScaleRandCache objectAtIndex:mPlacementCount] doubleValue];
-			else {
-				randScale = 1.0 + ([DKRandom randomPositiveOrNegativeNumber] * [self scaleRandomness]);
-				[mScaleRandCache addObject:@(randScale)];
-			}
-		}
-
-		[tfm translateXBy:p.x + dx + wobblePoint.x
-					  yBy:p.y + dy + wobblePoint.y];
-		[tfm scaleXBy:[self scale] * leadScale * randScale
-				  yBy:[self scale] * -1.0 * leadScale * randScale];
-
-		if ([self normalToPath])
-			[tfm rotateByRadians:-slope];
-
-		[tfm translateXBy:-(iSize.width / 2)
-					  yBy:-(iSize.height / 2)];
-
-		// does it really need to be drawn at all?
-
-		NSRect drawnRect;
-		DKDrawingView* cv = [DKDrawingView currentlyDrawingView]; // n.b. can be nil if drawing into image, etc
-
-		drawnRect.origin = [tfm transformPoint:NSZeroPoint];
-		NSPoint qp = [tfm transformPoint:NSMakePoint(iSize.width, iSize.height)];
-
-		drawnRect = NSRectFromTwoPoints(drawnRect.origin, qp);
-
-		CGFloat maxw = MAX(drawnRect.size.width, drawnRect.size.height);
-		drawnRect.size.width = drawnRect.size.height = maxw * 1.4;
-		drawnRect = CentreRectOnPoint(drawnRect, p);
-
-		// debugging - show the bbox
-		//[[NSColor blackColor] set];
-		//NSFrameRectWithWidth( drawnRect, 1.0 );
-
-		if (cv == nil || [cv needsToDrawRect:drawnRect]) {
-			SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
-				[tfm concat];
-
-			if (mDKCache && m_lowQuality) {
-				[mDKCache drawAtPoint:NSZeroPoint];
-			} else if (m_pdf != nil)
-				[m_pdf draw];
-			else
-				[img drawAtPoint:NSZeroPoint
-						fromRect:NSZeroRect
-					   operation:NSCompositeSourceAtop
-						fraction:1.0];
-
-			RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
-		}
+		[self drawMotifPlacements:&placement
+							count:1];
 	}
 
 	// increment the placement count - this is used to alternately offset items
@@ -496,10 +703,18 @@
 		[path placeLinksOnPathWithLinkLength:[self interval]
 							   factoryObject:self
 									userInfo:&pass];
-	} else
+	} else if ([self methodForSelector:@selector(placeObjectAtPoint:onPath:position:slope:userInfo:)] != [DKPathDecorator instanceMethodForSelector:@selector(placeObjectAtPoint:onPath:position:slope:userInfo:)]) {
+		// a subclass that places its own motifs is called for each one as before
+
 		[path placeObjectsOnPathAtInterval:[self interval]
 							 factoryObject:self
 								  userInfo:NULL];
+	} else {
+		NSUInteger count = [self placeMotifsAlongPath:path];
+
+		[self drawMotifPlacements:mPlacements
+							count:count];
+	}
 }
 
 #pragma mark -
@@ -582,6 +797,7 @@
 		mAlternateLateralOffsets = [coder decodeBoolForKey:@"DKPathDecorator_alternateLaterals"];
 		mWobblyness = [coder decodeDoubleForKey:@"DKPathDecorator_wobblyness"];
 		mScaleRandomness = [coder decodeDoubleForKey:@"DKPathDecorator_scaleRandomness"];
+		mRandomSeed = DKRandomNext(DKRandomThreadState());
 	}
 	return self;
 }
@@ -613,6 +829,7 @@
 
 	dc->mLateralOffset = mLateralOffset;
 	dc->mAlternateLateralOffsets = mAlternateLateralOffsets;
+	dc->mRandomSeed = mRandomSeed;
 
 	return dc;
 }
@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief A graphics context that draws into a given CGContext but reports a chosen value for \c isDrawingToScreen.
+
+ Used internally where DK renders into an offscreen CGContext but needs renderers to behave as they would for a particular
+ destination - as for printing when exporting bitmaps, or as for the screen when recording display lists. All other methods
+ are forwarded to an ordinary flipped graphics context for the CGContext.
+*/
+@interface DKProxyGraphicsContext : NSGraphicsContext
+
+- (instancetype)initWithCGContext:(CGContextRef)ctx drawingToScreen:(BOOL)toScreen;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,104 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKProxyGraphicsContext.h"
+
+@implementation DKProxyGraphicsContext {
+	NSGraphicsContext* actualContext;
+	BOOL drawingToScreen;
+}
+
+//The whole point of this class...
+- (BOOL)isDrawingToScreen
+{
+	return drawingToScreen;
+}
+
+- (instancetype)initWithCGContext:(CGContextRef)ctx drawingToScreen:(BOOL)toScreen
+{
+	if (self = [super init]) {
+		actualContext = [NSGraphicsContext graphicsContextWithGraphicsPort:ctx flipped:YES];
+		drawingToScreen = toScreen;
+		[actualContext setShouldAntialias:YES];
+		[actualContext setImageInterpolation:NSImageInterpolationHigh];
+	}
+	return self;
+}
+
+- (void)forwardInvocation:(NSInvocation*)invocation
+{
+	SEL aSelector = [invocation selector];
+
+	if ([actualContext respondsToSelector:aSelector]) {
+		[invocation invokeWithTarget:actualContext];
+	} else
+		[self doesNotRecognizeSelector:aSelector];
+}
+
+- (NSMethodSignature*)methodSignatureForSelector:(SEL)aSelector
+{
+	NSMethodSignature* sig = [super methodSignatureForSelector:aSelector];
+
+	if (sig == nil) {
+		sig = [actualContext methodSignatureForSelector:aSelector];
+	}
+
+	return sig;
+}
+
+- (BOOL)respondsToSelector:(SEL)aSelector
+{
+	BOOL responds = [super respondsToSelector:aSelector];
+
+	if (!responds) {
+		responds = [actualContext respondsToSelector:aSelector];
+	}
+
+	return responds;
+}
+
+// Otherwise Cocoa complains
+- (void*)graphicsPort
+{
+	return actualContext.graphicsPort;
+}
+
+- (void)saveGraphicsState
+{
+	[actualContext saveGraphicsState];
+}
+
+- (void)restoreGraphicsState
+{
+	[actualContext restoreGraphicsState];
+}
+
+- (void)setImageInterpolation:(NSImageInterpolation)imageInterpolation
+{
+	actualContext.imageInterpolation = imageInterpolation;
+}
+
+- (NSImageInterpolation)imageInterpolation
+{
+	return actualContext.imageInterpolation;
+}
+
+- (void)setShouldAntialias:(BOOL)shouldAntialias
+{
+	actualContext.shouldAntialias = shouldAntialias;
+}
+
+- (BOOL)shouldAntialias
+{
+	return actualContext.shouldAntialias;
+}
+
+- (BOOL)isFlipped
+{
+	return actualContext.flipped;
+}
+
+@end
@@ -36,6 +36,12 @@ Higher-level wrapper for CGLayer, used to cache graphics in numerous places in D
 - (void)drawAtPoint:(NSPoint)point;
 - (void)drawAtPoint:(NSPoint)point operation:(CGBlendMode)op fraction:(CGFloat)frac;
 - (void)drawInRect:(NSRect)rect;
+/** @brief Draw the cache once at each of \c count points, setting up the context only once.
+ */
+- (void)drawAtPoints:(const NSPoint*)points count:(NSUInteger)count;
+/** @brief Draw the cache once for each of \c count transforms, each applied on top of the current one.
+ */
+- (void)drawWithTransforms:(const CGAffineTransform*)transforms count:(NSUInteger)count;
 
 /** @brief bracket drawing calls to establish what is cached by -lockFocus and -unlockFocus.
  @discussion The drawing must be done at {0,0}
@@ -122,6 +122,30 @@
 	CGContextDrawLayerInRect(port, cg_rect, mCGLayer);
 }
 
+- (void)drawAtPoints:(const NSPoint*)points count:(NSUInteger)count
+{
+	CGContextRef port = [[NSGraphicsContext currentContext] graphicsPort];
+	CGContextSetAlpha(port, 1.0);
+	CGContextSetBlendMode(port, kCGBlendModeNormal);
+
+	for (NSUInteger i = 0; i < count; ++i)
+		CGContextDrawLayerAtPoint(port, CGPointMake(points[i].x, points[i].y), mCGLayer);
+}
+
+- (void)drawWithTransforms:(const CGAffineTransform*)transforms count:(NSUInteger)count
+{
+	CGContextRef port = [[NSGraphicsContext currentContext] graphicsPort];
+	CGContextSetAlpha(port, 1.0);
+	CGContextSetBlendMode(port, kCGBlendModeNormal);
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		CGContextSaveGState(port);
+		CGContextConcatCTM(port, transforms[i]);
+		CGContextDrawLayerAtPoint(port, CGPointZero, mCGLayer);
+		CGContextRestoreGState(port);
+	}
+}
+
 - (void)lockFocus
 {
 	[self lockFocusFlipped:self.isFlipped];
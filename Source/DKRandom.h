@@ -6,7 +6,103 @@
 
 #import <Foundation/Foundation.h>
 
-/** @brief Random number generation. */
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief The state of a DrawKit random number generator.
+
+ The generator is xoshiro256**, seeded through splitmix64. It is small enough to keep on the stack or in an object, and has no
+ hidden state, so two generators given the same seed produce the same sequence on every machine and every thread. Code that wants
+ reproducible output (the same dither or jitter every time an object is drawn) should seed its own generator; code that doesn't care
+ can use the calling thread's generator, returned by <code>DKRandomThreadState()</code>.
+
+ A state must not be used by more than one thread at a time.
+ */
+typedef struct {
+	uint64_t s[4];
+} DKRandomState;
+
+/** @brief Seed \c state so that it produces the sequence belonging to <code>seed</code>.
+
+ Every seed, including 0, gives a usable state.
+ */
+extern void DKRandomSeed(DKRandomState* state, uint64_t seed);
+
+/** @brief Return the generator belonging to the calling thread.
+
+ Each thread's generator is seeded from the system entropy source the first time it is used. The pointer is only valid on the thread
+ that asked for it.
+ */
+extern DKRandomState* DKRandomThreadState(void);
+
+/** @brief Return the next 64 random bits from <code>state</code>.
+ */
+NS_INLINE uint64_t DKRandomNext(DKRandomState* state)
+{
+#define DK_ROTL64(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+	uint64_t* s = state->s;
+	const uint64_t result = DK_ROTL64(s[1] * 5, 7) * 9;
+	const uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = DK_ROTL64(s[3], 45);
+
+	return result;
+#undef DK_ROTL64
+}
+
+/** @brief Return a random value in the range [0, 1), using the top 53 bits of the next output.
+ */
+NS_INLINE CGFloat DKRandomUnit(DKRandomState* state)
+{
+	return (CGFloat)(DKRandomNext(state) >> 11) * 0x1.0p-53;
+}
+
+/** @brief Return a random value in the range [-0.5, 0.5).
+ */
+NS_INLINE CGFloat DKRandomSigned(DKRandomState* state)
+{
+	return DKRandomUnit(state) - 0.5;
+}
+
+/** @brief Return a random integer in the range [0, <code>n</code>). \c n must not be 0.
+ */
+NS_INLINE NSUInteger DKRandomIndex(DKRandomState* state, NSUInteger n)
+{
+	return (NSUInteger)(DKRandomUnit(state) * n);
+}
+
+/** @brief Fill \c values with \c count random values in the range [0, 1).
+
+ The result is the same as calling DKRandomUnit() \c count times, but the state is kept in registers for the whole run and the
+ conversion loop is free of dependencies, so the compiler can vectorise it. Use this wherever a loop needs one value per pixel or
+ per segment.
+ */
+extern void DKRandomFillUnit(DKRandomState* state, CGFloat* values, NSUInteger count);
+
+/** @brief As <code>DKRandomFillUnit()</code>, but each value is scaled into the range [-<code>amount</code>/2, <code>amount</code>/2).
+ */
+extern void DKRandomFillSigned(DKRandomState* state, CGFloat* values, NSUInteger count, CGFloat amount);
+
+/** @brief The value to start a hash with before passing it to <code>DKRandomHashBytes()</code>.
+ */
+#define kDKRandomHashInitial 0xCBF29CE484222325ULL
+
+/** @brief Mix \c length bytes into <code>hash</code>, returning the new hash.
+
+ This is 64-bit FNV-1a. It is fast and spreads small differences well enough to derive a seed from a key, or to key a cache, but it is
+ not cryptographic. Start with <code>kDKRandomHashInitial</code>; hashing several values in turn is the same as hashing their bytes
+ end to end. Values hashed through their bytes hash differently on machines of different byte order, so hashes should not be archived.
+ */
+extern uint64_t DKRandomHashBytes(uint64_t hash, const void* bytes, NSUInteger length);
+
+/** @brief Random number generation.
+
+ These methods use the calling thread's generator and so are safe to call from any thread.
+ */
 @interface DKRandom : NSObject
 
 - (instancetype)init UNAVAILABLE_ATTRIBUTE;
@@ -17,5 +113,13 @@
 /** @brief Returns a random value between \c -0.5 and <code>0.5</code>.
  */
 + (CGFloat)randomPositiveOrNegativeNumber;
+/** @brief Reseed the calling thread's generator, so that what follows on this thread is reproducible.
+ */
++ (void)seedThreadGenerator:(uint64_t)seed;
+/** @brief Return a new seed drawn from the calling thread's generator, suitable for giving an object its own generator.
+ */
++ (uint64_t)randomSeed;
 
 @end
+
+NS_ASSUME_NONNULL_END
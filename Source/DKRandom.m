@@ -6,28 +6,124 @@
 
 #import "DKRandom.h"
 
-@implementation DKRandom
-#pragma mark As a DKRandom
+#define kDKRandomBatchSize 64
 
-+ (CGFloat)randomNumber
+static __thread DKRandomState sThreadState;
+static __thread BOOL sThreadStateSeeded = NO;
+
+void DKRandomSeed(DKRandomState* state, uint64_t seed)
 {
-	// returns a random value between 0 and 1.
+	// splitmix64 spreads the seed over the whole state, so similar seeds still give unrelated sequences and the state is never all zero
 
-	static unsigned long seed = 0;
+	for (NSUInteger i = 0; i < 4; ++i) {
+		uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
 
-	if (seed == 0) {
-		srandom([[NSDate date] timeIntervalSince1970]);
-		seed = 1;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		state->s[i] = z ^ (z >> 31);
 	}
-	CGFloat randomNum = (CGFloat)random();
-	randomNum /= (randomNum < 0) ? -2147483647.0 : 2147483647.0;
+}
+
+DKRandomState* DKRandomThreadState(void)
+{
+	if (!sThreadStateSeeded) {
+		uint64_t seed;
 
-	return randomNum;
+		arc4random_buf(&seed, sizeof(seed));
+		DKRandomSeed(&sThreadState, seed);
+		sThreadStateSeeded = YES;
+	}
+
+	return &sThreadState;
+}
+
+void DKRandomFillUnit(DKRandomState* state, CGFloat* values, NSUInteger count)
+{
+	// generate in chunks: the generator itself is serial, but once a chunk of raw bits exists the conversion to floating point
+	// is independent per value and vectorises
+
+	DKRandomState local = *state;
+	uint64_t bits[kDKRandomBatchSize];
+
+	while (count > 0) {
+		NSUInteger n = MIN(count, (NSUInteger)kDKRandomBatchSize);
+		NSUInteger i;
+
+		for (i = 0; i < n; ++i)
+			bits[i] = DKRandomNext(&local) >> 11;
+
+		for (i = 0; i < n; ++i)
+			values[i] = (CGFloat)bits[i] * 0x1.0p-53;
+
+		values += n;
+		count -= n;
+	}
+
+	*state = local;
+}
+
+void DKRandomFillSigned(DKRandomState* state, CGFloat* values, NSUInteger count, CGFloat amount)
+{
+	// as DKRandomFillUnit(), with the scale and offset folded into a single multiply-add per value
+
+	DKRandomState local = *state;
+	uint64_t bits[kDKRandomBatchSize];
+	const CGFloat scale = amount * 0x1.0p-53;
+	const CGFloat offset = amount * 0.5;
+
+	while (count > 0) {
+		NSUInteger n = MIN(count, (NSUInteger)kDKRandomBatchSize);
+		NSUInteger i;
+
+		for (i = 0; i < n; ++i)
+			bits[i] = DKRandomNext(&local) >> 11;
+
+		for (i = 0; i < n; ++i)
+			values[i] = (CGFloat)bits[i] * scale - offset;
+
+		values += n;
+		count -= n;
+	}
+
+	*state = local;
+}
+
+uint64_t DKRandomHashBytes(uint64_t hash, const void* bytes, NSUInteger length)
+{
+	// 64-bit FNV-1a
+
+	const unsigned char* b = bytes;
+
+	for (NSUInteger i = 0; i < length; ++i)
+		hash = (hash ^ b[i]) * 0x100000001B3ULL;
+
+	return hash;
+}
+
+#pragma mark -
+
+@implementation DKRandom
+#pragma mark As a DKRandom
+
++ (CGFloat)randomNumber
+{
+	return DKRandomUnit(DKRandomThreadState());
 }
 
 + (CGFloat)randomPositiveOrNegativeNumber
 {
-	return [self randomNumber] - 0.5;
+	return DKRandomSigned(DKRandomThreadState());
+}
+
++ (void)seedThreadGenerator:(uint64_t)seed
+{
+	DKRandomSeed(&sThreadState, seed);
+	sThreadStateSeeded = YES;
+}
+
++ (uint64_t)randomSeed
+{
+	return DKRandomNext(DKRandomThreadState());
 }
 
 @end
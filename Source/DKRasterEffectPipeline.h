@@ -0,0 +1,136 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+#import "DKRasterEffects.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Return a bitmap context that draws into <code>buffer</code>, in sRGB. The caller must release it.
+ */
+extern CGContextRef _Nullable DKRasterBufferCreateContext(DKRasterBuffer* buffer) CF_RETURNS_RETAINED;
+
+/** @brief Return an image of the current contents of <code>buffer</code>. The pixels are copied, so the buffer can be reused
+ afterwards. The caller must release it.
+ */
+extern CGImageRef _Nullable DKRasterBufferCreateImage(const DKRasterBuffer* buffer) CF_RETURNS_RETAINED;
+
+#pragma mark -
+
+/** @brief A pool of raster buffers, so that rendering an effect doesn't allocate a new bitmap for every intermediate image.
+
+ Buffers given back are kept until the total kept exceeds \c maximumRetainedBytes, and handed out again for any request that fits
+ in them without wasting too much. The shared pool can be used from any thread.
+ */
+@interface DKRasterBufferPool : NSObject {
+@private
+	dispatch_queue_t mQueue;
+	DKRasterBuffer* mFree; // buffers available for reuse
+	NSUInteger mFreeCount;
+	NSUInteger mFreeCapacity;
+	NSUInteger mRetainedBytes;
+	NSUInteger mMaximumRetainedBytes;
+	NSUInteger mAllocationCount;
+}
+
+@property (class, readonly, strong) DKRasterBufferPool* sharedPool;
+
+/** @brief The most memory the pool will keep for reuse. The default is 64MB.
+ */
+@property NSUInteger maximumRetainedBytes;
+/** @brief The number of buffers the pool has had to allocate rather than reuse.
+ */
+@property (readonly) NSUInteger allocationCount;
+
+/** @brief Fill in \c buffer with a cleared bitmap of the given size, reusing one if possible.
+ @return NO if the memory couldn't be had
+ */
+- (BOOL)getBuffer:(DKRasterBuffer*)buffer width:(size_t)width height:(size_t)height;
+/** @brief Give a buffer back to the pool. \c buffer is cleared, and must have come from <code>-getBuffer:width:height:</code>.
+ */
+- (void)recycleBuffer:(DKRasterBuffer*)buffer;
+/** @brief Free every buffer the pool is keeping.
+ */
+- (void)purge;
+
+@end
+
+#pragma mark -
+
+/** @brief One step in a DKRasterEffectPipeline.
+ */
+typedef NS_ENUM(NSInteger, DKRasterEffectKind) {
+	kDKRasterEffectGaussianBlur = 0,
+	kDKRasterEffectBoxBlur = 1,
+	kDKRasterEffectColourMatrix = 2,
+	kDKRasterEffectDropShadow = 3,
+	kDKRasterEffectBlendSource = 4
+};
+
+typedef struct {
+	DKRasterEffectKind kind;
+	CGFloat radius; // blurs and shadows, in points
+	NSSize offset; // shadows, in points, y downwards
+	CGFloat colour[4]; // shadows, premultiplied
+	CGFloat matrix[20]; // colour matrices
+	DKRasterBlendMode mode; // blends
+	CGFloat opacity; // blends
+} DKRasterEffectStep;
+
+/** @brief The name under which DKCIFilterRastGroup offers a drop shadow, which Core Image has no filter for.
+
+ Its arguments are \c inputRadius (an NSNumber, default 4), \c inputOffset (an NSValue holding an NSSize, y downwards, default 3, 3)
+ and \c inputColor (an NSColor, default 50% black).
+ */
+extern NSString* const kDKRasterDropShadowFilter;
+
+/** @brief A chain of raster effects applied one after another to an image in a DKRasterBuffer.
+
+ Sizes in a pipeline are in points, and scaled to pixels when it is applied, so the same pipeline gives the same look at any zoom.
+ Every intermediate image it needs comes from the shared DKRasterBufferPool.
+
+ A pipeline can be made from the name and arguments of those Core Image filters it can reproduce, so that DKCIFilterRastGroup can
+ render them without Core Image: \c CIGaussianBlur, \c CIBoxBlur, \c CIColorMatrix, \c CIColorInvert and <code>kDKRasterDropShadowFilter</code>.
+ */
+@interface DKRasterEffectPipeline : NSObject <NSCopying> {
+@private
+	DKRasterEffectStep* mSteps;
+	NSUInteger mCount;
+	NSUInteger mCapacity;
+}
+
+/** @brief Return a pipeline that does what the Core Image filter \c filterName would do with <code>arguments</code>, or nil if the
+ filter isn't one that can be done this way.
+ */
++ (nullable instancetype)pipelineWithFilter:(NSString*)filterName arguments:(nullable NSDictionary<NSString*, id>*)arguments;
+
+- (void)addStep:(const DKRasterEffectStep*)step;
+- (void)addGaussianBlurWithRadius:(CGFloat)radius;
+- (void)addColourMatrix:(const CGFloat[_Nonnull 20])matrix;
+/** @brief Add a drop shadow behind everything drawn so far.
+ */
+- (void)addDropShadowWithOffset:(NSSize)offset radius:(CGFloat)radius colour:(NSColor*)colour;
+/** @brief Composite the image the pipeline started with over the result so far, e.g. to put a sharp copy over a blurred glow.
+ */
+- (void)addBlendSourceWithMode:(DKRasterBlendMode)mode opacity:(CGFloat)opacity;
+
+@property (readonly) NSUInteger count;
+- (const DKRasterEffectStep*)stepAtIndex:(NSUInteger)indx NS_RETURNS_INNER_POINTER;
+
+/** @brief The room in points the effects need around what they are applied to, so that blurs and shadows aren't cut off.
+ */
+@property (readonly) NSSize extraSpaceNeeded;
+
+/** @brief Apply every step in turn to <code>buffer</code>.
+ @param buffer the image to apply the effects to, which is replaced by the result
+ @param scale the number of pixels in a point in <code>buffer</code>
+ @return NO if the intermediate buffers couldn't be had, in which case \c buffer is unchanged
+ */
+- (BOOL)applyToBuffer:(DKRasterBuffer*)buffer scale:(CGFloat)scale;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,480 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKRasterEffectPipeline.h"
+#import <QuartzCore/QuartzCore.h>
+
+NSString* const kDKRasterDropShadowFilter = @"DKDropShadow";
+
+#define DEFAULT_MAXIMUM_RETAINED_BYTES (64 * 1024 * 1024)
+
+#pragma mark Buffers
+
+CGContextRef DKRasterBufferCreateContext(DKRasterBuffer* buffer)
+{
+	CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	CGContextRef ctx = CGBitmapContextCreate(buffer->data, buffer->width, buffer->height, 8, buffer->rowBytes, clrSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+
+	CGColorSpaceRelease(clrSpace);
+
+	return ctx;
+}
+
+CGImageRef DKRasterBufferCreateImage(const DKRasterBuffer* buffer)
+{
+	CFDataRef data = CFDataCreate(kCFAllocatorDefault, buffer->data, buffer->rowBytes * buffer->height);
+
+	if (data == NULL)
+		return NULL;
+
+	CGDataProviderRef provider = CGDataProviderCreateWithCFData(data);
+	CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	CGImageRef image = CGImageCreate(buffer->width, buffer->height, 8, 32, buffer->rowBytes, clrSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big, provider, NULL, false, kCGRenderingIntentDefault);
+
+	CGColorSpaceRelease(clrSpace);
+	CGDataProviderRelease(provider);
+	CFRelease(data);
+
+	return image;
+}
+
+#pragma mark -
+
+@interface DKRasterBufferPool ()
+
+/** @brief Free the oldest buffers until no more than \c bytes are kept. Must be called on the pool's queue.
+ */
+- (void)trimToSize:(NSUInteger)bytes;
+
+@end
+
+@implementation DKRasterBufferPool
+
++ (DKRasterBufferPool*)sharedPool
+{
+	static DKRasterBufferPool* sPool = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sPool = [[self alloc] init];
+	});
+
+	return sPool;
+}
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self) {
+		mQueue = dispatch_queue_create("net.apptree.drawkit.rasterbufferpool", DISPATCH_QUEUE_SERIAL);
+		mMaximumRetainedBytes = DEFAULT_MAXIMUM_RETAINED_BYTES;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	for (NSUInteger i = 0; i < mFreeCount; ++i)
+		free(mFree[i].data);
+
+	free(mFree);
+}
+
+- (NSUInteger)maximumRetainedBytes
+{
+	__block NSUInteger result;
+
+	dispatch_sync(mQueue, ^{
+		result = self->mMaximumRetainedBytes;
+	});
+
+	return result;
+}
+
+- (void)setMaximumRetainedBytes:(NSUInteger)bytes
+{
+	dispatch_sync(mQueue, ^{
+		self->mMaximumRetainedBytes = bytes;
+		[self trimToSize:bytes];
+	});
+}
+
+- (NSUInteger)allocationCount
+{
+	__block NSUInteger result;
+
+	dispatch_sync(mQueue, ^{
+		result = self->mAllocationCount;
+	});
+
+	return result;
+}
+
+- (void)trimToSize:(NSUInteger)bytes
+{
+	// oldest first, as those are the least likely to be wanted again
+
+	while (mFreeCount > 0 && mRetainedBytes > bytes) {
+		mRetainedBytes -= mFree[0].capacity;
+		free(mFree[0].data);
+		--mFreeCount;
+		memmove(&mFree[0], &mFree[1], mFreeCount * sizeof(DKRasterBuffer));
+	}
+}
+
+- (BOOL)getBuffer:(DKRasterBuffer*)buffer width:(size_t)width height:(size_t)height
+{
+	memset(buffer, 0, sizeof(DKRasterBuffer));
+
+	if (width == 0 || height == 0 || width > SIZE_MAX / 4 / height)
+		return NO;
+
+	const size_t rowBytes = width * 4;
+	const size_t needed = rowBytes * height;
+	__block uint8_t* data = NULL;
+	__block size_t capacity = needed;
+
+	dispatch_sync(mQueue, ^{
+		// the smallest free buffer that is big enough, so long as it isn't so much bigger that it's wasted on this
+
+		NSUInteger best = NSNotFound;
+
+		for (NSUInteger i = 0; i < self->mFreeCount; ++i) {
+			size_t cap = self->mFree[i].capacity;
+
+			if (cap >= needed && cap <= needed * 2 && (best == NSNotFound || cap < self->mFree[best].capacity))
+				best = i;
+		}
+
+		if (best != NSNotFound) {
+			data = self->mFree[best].data;
+			capacity = self->mFree[best].capacity;
+			self->mRetainedBytes -= capacity;
+
+			// close the gap rather than move the last one into it, so the list stays oldest first for -trimToSize:
+
+			--self->mFreeCount;
+			memmove(&self->mFree[best], &self->mFree[best + 1], (self->mFreeCount - best) * sizeof(DKRasterBuffer));
+		} else
+			++self->mAllocationCount;
+	});
+
+	if (data == NULL) {
+		data = malloc(needed);
+
+		if (data == NULL)
+			return NO;
+	}
+
+	memset(data, 0, needed);
+
+	buffer->data = data;
+	buffer->width = width;
+	buffer->height = height;
+	buffer->rowBytes = rowBytes;
+	buffer->capacity = capacity;
+
+	return YES;
+}
+
+- (void)recycleBuffer:(DKRasterBuffer*)buffer
+{
+	if (buffer->data == NULL)
+		return;
+
+	DKRasterBuffer recycled = *buffer;
+
+	memset(buffer, 0, sizeof(DKRasterBuffer));
+
+	dispatch_sync(mQueue, ^{
+		if (recycled.capacity > self->mMaximumRetainedBytes) {
+			free(recycled.data);
+			return;
+		}
+
+		if (self->mFreeCount == self->mFreeCapacity) {
+			self->mFreeCapacity = MAX(8, self->mFreeCapacity * 2);
+			self->mFree = realloc(self->mFree, self->mFreeCapacity * sizeof(DKRasterBuffer));
+		}
+
+		self->mFree[self->mFreeCount++] = recycled;
+		self->mRetainedBytes += recycled.capacity;
+		[self trimToSize:self->mMaximumRetainedBytes];
+	});
+}
+
+- (void)purge
+{
+	dispatch_sync(mQueue, ^{
+		[self trimToSize:0];
+	});
+}
+
+@end
+
+#pragma mark -
+
+static CGFloat numberArgument(NSDictionary* arguments, NSString* key, CGFloat defaultValue)
+{
+	id value = [arguments objectForKey:key];
+
+	return [value respondsToSelector:@selector(doubleValue)] ? [value doubleValue] : defaultValue;
+}
+
+static void getVectorArgument(NSDictionary* arguments, NSString* key, CGFloat* row, NSUInteger count)
+{
+	CIVector* vector = [arguments objectForKey:key];
+
+	if ([vector isKindOfClass:[CIVector class]]) {
+		for (NSUInteger i = 0; i < count; ++i)
+			row[i] = (i < [vector count]) ? [vector valueAtIndex:i] : 0.0;
+	}
+}
+
+@implementation DKRasterEffectPipeline
+
++ (instancetype)pipelineWithFilter:(NSString*)filterName arguments:(NSDictionary<NSString*, id>*)arguments
+{
+	DKRasterEffectPipeline* pipeline = [[self alloc] init];
+
+	if ([filterName isEqualToString:@"CIGaussianBlur"])
+		[pipeline addGaussianBlurWithRadius:numberArgument(arguments, @"inputRadius", 10.0)];
+	else if ([filterName isEqualToString:@"CIBoxBlur"]) {
+		DKRasterEffectStep step;
+
+		memset(&step, 0, sizeof(step));
+		step.kind = kDKRasterEffectBoxBlur;
+		step.radius = numberArgument(arguments, @"inputRadius", 10.0);
+		[pipeline addStep:&step];
+	} else if ([filterName isEqualToString:@"CIColorMatrix"]) {
+		CGFloat matrix[20] = { 1, 0, 0, 0, 0,
+			0, 1, 0, 0, 0,
+			0, 0, 1, 0, 0,
+			0, 0, 0, 1, 0 };
+		CGFloat bias[4] = { 0, 0, 0, 0 };
+
+		getVectorArgument(arguments, @"inputRVector", &matrix[0], 4);
+		getVectorArgument(arguments, @"inputGVector", &matrix[5], 4);
+		getVectorArgument(arguments, @"inputBVector", &matrix[10], 4);
+		getVectorArgument(arguments, @"inputAVector", &matrix[15], 4);
+		getVectorArgument(arguments, @"inputBiasVector", bias, 4);
+
+		for (NSUInteger i = 0; i < 4; ++i)
+			matrix[i * 5 + 4] = bias[i];
+
+		[pipeline addColourMatrix:matrix];
+	} else if ([filterName isEqualToString:@"CIColorInvert"]) {
+		const CGFloat matrix[20] = { -1, 0, 0, 0, 1,
+			0, -1, 0, 0, 1,
+			0, 0, -1, 0, 1,
+			0, 0, 0, 1, 0 };
+
+		[pipeline addColourMatrix:matrix];
+	} else if ([filterName isEqualToString:kDKRasterDropShadowFilter]) {
+		NSValue* offset = [arguments objectForKey:@"inputOffset"];
+		NSColor* colour = [arguments objectForKey:@"inputColor"];
+
+		[pipeline addDropShadowWithOffset:[offset isKindOfClass:[NSValue class]] ? [offset sizeValue] : NSMakeSize(3, 3)
+								   radius:numberArgument(arguments, @"inputRadius", 4.0)
+								   colour:[colour isKindOfClass:[NSColor class]] ? colour : [NSColor colorWithCalibratedWhite:0.0 alpha:0.5]];
+	} else
+		return nil;
+
+	return pipeline;
+}
+
+- (void)dealloc
+{
+	free(mSteps);
+}
+
+- (void)addStep:(const DKRasterEffectStep*)step
+{
+	if (mCount == mCapacity) {
+		mCapacity = MAX(4, mCapacity * 2);
+		mSteps = realloc(mSteps, mCapacity * sizeof(DKRasterEffectStep));
+	}
+
+	mSteps[mCount++] = *step;
+}
+
+- (void)addGaussianBlurWithRadius:(CGFloat)radius
+{
+	DKRasterEffectStep step;
+
+	memset(&step, 0, sizeof(step));
+	step.kind = kDKRasterEffectGaussianBlur;
+	step.radius = radius;
+	[self addStep:&step];
+}
+
+- (void)addColourMatrix:(const CGFloat[20])matrix
+{
+	DKRasterEffectStep step;
+
+	memset(&step, 0, sizeof(step));
+	step.kind = kDKRasterEffectColourMatrix;
+	memcpy(step.matrix, matrix, sizeof(step.matrix));
+	[self addStep:&step];
+}
+
+- (void)addDropShadowWithOffset:(NSSize)offset radius:(CGFloat)radius colour:(NSColor*)colour
+{
+	DKRasterEffectStep step;
+	NSColor* rgb = [colour colorUsingColorSpace:[NSColorSpace sRGBColorSpace]];
+
+	memset(&step, 0, sizeof(step));
+	step.kind = kDKRasterEffectDropShadow;
+	step.offset = offset;
+	step.radius = radius;
+
+	if (rgb) {
+		step.colour[3] = [rgb alphaComponent];
+		step.colour[0] = [rgb redComponent] * step.colour[3];
+		step.colour[1] = [rgb greenComponent] * step.colour[3];
+		step.colour[2] = [rgb blueComponent] * step.colour[3];
+	}
+
+	[self addStep:&step];
+}
+
+- (void)addBlendSourceWithMode:(DKRasterBlendMode)mode opacity:(CGFloat)opacity
+{
+	DKRasterEffectStep step;
+
+	memset(&step, 0, sizeof(step));
+	step.kind = kDKRasterEffectBlendSource;
+	step.mode = mode;
+	step.opacity = opacity;
+	[self addStep:&step];
+}
+
+@synthesize count = mCount;
+
+- (const DKRasterEffectStep*)stepAtIndex:(NSUInteger)indx
+{
+	NSAssert(indx < mCount, @"step index out of range");
+
+	return &mSteps[indx];
+}
+
+- (NSSize)extraSpaceNeeded
+{
+	// a gaussian has next to nothing left three deviations out, and each blur spreads what the one before it spread
+
+	NSSize extra = NSZeroSize;
+
+	for (NSUInteger i = 0; i < mCount; ++i) {
+		const DKRasterEffectStep* step = &mSteps[i];
+
+		switch (step->kind) {
+		case kDKRasterEffectGaussianBlur:
+			extra.width += step->radius * 3.0;
+			extra.height += step->radius * 3.0;
+			break;
+
+		case kDKRasterEffectBoxBlur:
+			extra.width += step->radius;
+			extra.height += step->radius;
+			break;
+
+		case kDKRasterEffectDropShadow:
+			extra.width += fabs(step->offset.width) + step->radius * 3.0;
+			extra.height += fabs(step->offset.height) + step->radius * 3.0;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return NSMakeSize(ceil(extra.width), ceil(extra.height));
+}
+
+- (BOOL)applyToBuffer:(DKRasterBuffer*)buffer scale:(CGFloat)scale
+{
+	if (mCount == 0)
+		return YES;
+
+	DKRasterBufferPool* pool = [DKRasterBufferPool sharedPool];
+	DKRasterBuffer scratch, shadow, source;
+	BOOL needsShadow = NO, needsSource = NO;
+	NSUInteger i;
+
+	memset(&shadow, 0, sizeof(shadow));
+	memset(&source, 0, sizeof(source));
+
+	for (i = 0; i < mCount; ++i) {
+		needsShadow |= (mSteps[i].kind == kDKRasterEffectDropShadow);
+		needsSource |= (mSteps[i].kind == kDKRasterEffectBlendSource);
+	}
+
+	BOOL ok = [pool getBuffer:&scratch
+						width:buffer->width
+					   height:buffer->height];
+
+	if (ok && needsShadow)
+		ok = [pool getBuffer:&shadow
+					   width:buffer->width
+					  height:buffer->height];
+
+	if (ok && needsSource) {
+		ok = [pool getBuffer:&source
+					   width:buffer->width
+					  height:buffer->height];
+
+		if (ok)
+			DKRasterCopy(buffer, &source);
+	}
+
+	for (i = 0; ok && i < mCount; ++i) {
+		const DKRasterEffectStep* step = &mSteps[i];
+
+		switch (step->kind) {
+		case kDKRasterEffectGaussianBlur:
+			DKRasterGaussianBlur(buffer, &scratch, step->radius * scale);
+			break;
+
+		case kDKRasterEffectBoxBlur:
+			DKRasterBoxBlur(buffer, &scratch, (size_t)round(step->radius * scale));
+			break;
+
+		case kDKRasterEffectColourMatrix:
+			DKRasterColourMatrix(buffer, step->matrix);
+			break;
+
+		case kDKRasterEffectDropShadow:
+			DKRasterDropShadow(buffer, &shadow, &scratch, lround(step->offset.width * scale), lround(step->offset.height * scale), step->radius * scale, step->colour);
+			break;
+
+		case kDKRasterEffectBlendSource:
+			DKRasterBlend(&source, buffer, step->mode, step->opacity);
+			break;
+		}
+	}
+
+	[pool recycleBuffer:&scratch];
+	[pool recycleBuffer:&shadow];
+	[pool recycleBuffer:&source];
+
+	return ok;
+}
+
+#pragma mark -
+#pragma mark As part of NSCopying Protocol
+
+- (id)copyWithZone:(NSZone*)zone
+{
+	DKRasterEffectPipeline* copy = [[[self class] allocWithZone:zone] init];
+
+	for (NSUInteger i = 0; i < mCount; ++i)
+		[copy addStep:&mSteps[i]];
+
+	return copy;
+}
+
+@end
@@ -0,0 +1,268 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#include "DKRasterEffects.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static DKRasterBuffer viewOfBuffer(const DKRasterBuffer* buffer, size_t width, size_t height)
+{
+	// a scratch buffer may be larger than the image it is working with, so it is used as one the same size
+
+	DKRasterBuffer view = *buffer;
+
+	view.width = width;
+	view.height = height;
+	view.rowBytes = width * 4;
+
+	assert(view.rowBytes * height <= buffer->capacity && "scratch buffer is too small");
+
+	return view;
+}
+
+void DKRasterCopy(const DKRasterBuffer* src, DKRasterBuffer* dst)
+{
+	for (size_t y = 0; y < src->height; ++y)
+		memcpy(dst->data + y * dst->rowBytes, src->data + y * src->rowBytes, src->width * 4);
+}
+
+// dividing by the box width is done as a multiply and shift, rounded to nearest so that repeated passes don't lose intensity
+
+#define BOX_DIVIDE(sum, mul) ((uint8_t)(((sum) * (mul) + ((uint64_t)1 << 31)) >> 32))
+
+static inline uint64_t boxMultiplier(size_t r)
+{
+	return ((uint64_t)1 << 32) / (2 * r + 1);
+}
+
+static void boxBlurHorizontal(const DKRasterBuffer* src, DKRasterBuffer* dst, size_t r)
+{
+	const size_t width = src->width;
+	const uint64_t mul = boxMultiplier(r);
+
+	for (size_t y = 0; y < src->height; ++y) {
+		const uint8_t* in = src->data + y * src->rowBytes;
+		uint8_t* out = dst->data + y * dst->rowBytes;
+		uint32_t sum[4] = { 0, 0, 0, 0 };
+		size_t i, c;
+
+		for (i = 0; i <= r && i < width; ++i)
+			for (c = 0; c < 4; ++c)
+				sum[c] += in[i * 4 + c];
+
+		for (size_t x = 0; x < width; ++x) {
+			for (c = 0; c < 4; ++c)
+				out[x * 4 + c] = BOX_DIVIDE(sum[c], mul);
+
+			if (x + r + 1 < width)
+				for (c = 0; c < 4; ++c)
+					sum[c] += in[(x + r + 1) * 4 + c];
+
+			if (x >= r)
+				for (c = 0; c < 4; ++c)
+					sum[c] -= in[(x - r) * 4 + c];
+		}
+	}
+}
+
+static void boxBlurVertical(const DKRasterBuffer* src, DKRasterBuffer* dst, size_t r)
+{
+	// a running sum per column, moved down a row at a time, so that every pass reads and writes whole rows in order
+
+	const size_t height = src->height;
+	const size_t n = src->width * 4;
+	const uint64_t mul = boxMultiplier(r);
+	uint32_t* sum = calloc(n, sizeof(uint32_t));
+	size_t i;
+
+	// without room for the sums, pass the image through unblurred so that the passes either side still chain up
+
+	if (sum == NULL) {
+		DKRasterCopy(src, dst);
+		return;
+	}
+
+	for (size_t row = 0; row <= r && row < height; ++row) {
+		const uint8_t* in = src->data + row * src->rowBytes;
+
+		for (i = 0; i < n; ++i)
+			sum[i] += in[i];
+	}
+
+	for (size_t y = 0; y < height; ++y) {
+		uint8_t* out = dst->data + y * dst->rowBytes;
+
+		for (i = 0; i < n; ++i)
+			out[i] = BOX_DIVIDE(sum[i], mul);
+
+		if (y + r + 1 < height) {
+			const uint8_t* in = src->data + (y + r + 1) * src->rowBytes;
+
+			for (i = 0; i < n; ++i)
+				sum[i] += in[i];
+		}
+
+		if (y >= r) {
+			const uint8_t* in = src->data + (y - r) * src->rowBytes;
+
+			for (i = 0; i < n; ++i)
+				sum[i] -= in[i];
+		}
+	}
+
+	free(sum);
+}
+
+void DKRasterGaussianBlur(DKRasterBuffer* buffer, DKRasterBuffer* scratch, double radius)
+{
+	// three passes of a box of width w have the variance (w^2 - 1) / 4, so this is the box that matches the gaussian's
+
+	size_t r = (size_t)round((sqrt(4.0 * radius * radius + 1.0) - 1.0) * 0.5);
+
+	if (r == 0 || buffer->width == 0 || buffer->height == 0)
+		return;
+
+	DKRasterBuffer tmp = viewOfBuffer(scratch, buffer->width, buffer->height);
+
+	boxBlurHorizontal(buffer, &tmp, r);
+	boxBlurHorizontal(&tmp, buffer, r);
+	boxBlurHorizontal(buffer, &tmp, r);
+	boxBlurVertical(&tmp, buffer, r);
+	boxBlurVertical(buffer, &tmp, r);
+	boxBlurVertical(&tmp, buffer, r);
+}
+
+void DKRasterBoxBlur(DKRasterBuffer* buffer, DKRasterBuffer* scratch, size_t radius)
+{
+	if (radius == 0 || buffer->width == 0 || buffer->height == 0)
+		return;
+
+	DKRasterBuffer tmp = viewOfBuffer(scratch, buffer->width, buffer->height);
+
+	boxBlurHorizontal(buffer, &tmp, radius);
+	boxBlurVertical(&tmp, buffer, radius);
+}
+
+void DKRasterColourMatrix(DKRasterBuffer* buffer, const double matrix[20])
+{
+	float m[20];
+	size_t i;
+
+	for (i = 0; i < 20; ++i)
+		m[i] = (float)matrix[i];
+
+	for (size_t y = 0; y < buffer->height; ++y) {
+		uint8_t* p = buffer->data + y * buffer->rowBytes;
+
+		for (size_t x = 0; x < buffer->width; ++x, p += 4) {
+			float a = p[3] * (1.0f / 255.0f);
+			float inv = (a > 0.0f) ? 1.0f / (a * 255.0f) : 0.0f;
+			float c[4] = { p[0] * inv, p[1] * inv, p[2] * inv, a };
+			float out[4];
+
+			for (i = 0; i < 4; ++i) {
+				const float* row = &m[i * 5];
+				float v = row[0] * c[0] + row[1] * c[1] + row[2] * c[2] + row[3] * c[3] + row[4];
+
+				out[i] = (v < 0.0f) ? 0.0f : (v > 1.0f) ? 1.0f : v;
+			}
+
+			p[0] = (uint8_t)(out[0] * out[3] * 255.0f + 0.5f);
+			p[1] = (uint8_t)(out[1] * out[3] * 255.0f + 0.5f);
+			p[2] = (uint8_t)(out[2] * out[3] * 255.0f + 0.5f);
+			p[3] = (uint8_t)(out[3] * 255.0f + 0.5f);
+		}
+	}
+}
+
+static inline float blendComponent(DKRasterBlendMode mode, float s, float sa, float d, float da)
+{
+	switch (mode) {
+	default:
+	case kDKRasterBlendNormal:
+		return s + d * (1.0f - sa);
+
+	case kDKRasterBlendMultiply:
+		return s * d + s * (1.0f - da) + d * (1.0f - sa);
+
+	case kDKRasterBlendScreen:
+		return s + d - s * d;
+
+	case kDKRasterBlendDarken:
+		return fminf(s * da, d * sa) + s * (1.0f - da) + d * (1.0f - sa);
+
+	case kDKRasterBlendLighten:
+		return fmaxf(s * da, d * sa) + s * (1.0f - da) + d * (1.0f - sa);
+	}
+}
+
+void DKRasterBlend(const DKRasterBuffer* src, DKRasterBuffer* dst, DKRasterBlendMode mode, double opacity)
+{
+	assert(src->width == dst->width && src->height == dst->height && "blended buffers must be the same size");
+
+	const float scale = (float)opacity / 255.0f;
+
+	for (size_t y = 0; y < dst->height; ++y) {
+		const uint8_t* s = src->data + y * src->rowBytes;
+		uint8_t* d = dst->data + y * dst->rowBytes;
+
+		for (size_t x = 0; x < dst->width; ++x, s += 4, d += 4) {
+			if (s[3] == 0)
+				continue;
+
+			float sa = s[3] * scale;
+			float da = d[3] * (1.0f / 255.0f);
+
+			for (size_t c = 0; c < 3; ++c) {
+				float v = blendComponent(mode, s[c] * scale, sa, d[c] * (1.0f / 255.0f), da);
+
+				d[c] = (uint8_t)(fminf(v, 1.0f) * 255.0f + 0.5f);
+			}
+
+			d[3] = (uint8_t)(fminf(sa + da - sa * da, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+}
+
+void DKRasterDropShadow(DKRasterBuffer* buffer, DKRasterBuffer* shadow, DKRasterBuffer* scratch, ptrdiff_t dx, ptrdiff_t dy, double radius, const double colour[4])
+{
+	const size_t width = buffer->width;
+	const size_t height = buffer->height;
+	DKRasterBuffer sh = viewOfBuffer(shadow, width, height);
+	float tint[4];
+
+	for (size_t c = 0; c < 4; ++c)
+		tint[c] = (float)colour[c];
+
+	// the shadow is the offset alpha of the image in the shadow colour
+
+	for (size_t y = 0; y < height; ++y) {
+		uint8_t* out = sh.data + y * sh.rowBytes;
+		ptrdiff_t sy = (ptrdiff_t)y - dy;
+
+		memset(out, 0, width * 4);
+
+		if (sy < 0 || sy >= (ptrdiff_t)height)
+			continue;
+
+		const uint8_t* in = buffer->data + sy * buffer->rowBytes;
+		ptrdiff_t x0 = (dx > 0) ? dx : 0;
+		ptrdiff_t x1 = (dx < 0) ? (ptrdiff_t)width + dx : (ptrdiff_t)width;
+
+		for (ptrdiff_t x = x0; x < x1; ++x) {
+			uint8_t a = in[(x - dx) * 4 + 3];
+
+			for (size_t c = 0; c < 4; ++c)
+				out[x * 4 + c] = (uint8_t)(tint[c] * a + 0.5f);
+		}
+	}
+
+	DKRasterGaussianBlur(&sh, scratch, radius);
+	DKRasterBlend(buffer, &sh, kDKRasterBlendNormal, 1.0);
+	DKRasterCopy(&sh, buffer);
+}
@@ -0,0 +1,88 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#ifndef DKRasterEffects_h
+#define DKRasterEffects_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief A bitmap worked on by the raster effects: 8 bits per channel, premultiplied RGBA, in that byte order.
+
+ Row 0 is the top of the image. The effects are plain C over this memory, with no dependence on Quartz, Core Image or Foundation.
+ */
+typedef struct {
+	uint8_t* data;
+	size_t width;
+	size_t height;
+	size_t rowBytes;
+	size_t capacity; // bytes allocated at data, which may be more than rowBytes * height
+} DKRasterBuffer;
+
+/** @brief How one image is combined with another by <code>DKRasterBlend()</code>.
+ */
+typedef enum {
+	kDKRasterBlendNormal = 0,
+	kDKRasterBlendMultiply = 1,
+	kDKRasterBlendScreen = 2,
+	kDKRasterBlendDarken = 3,
+	kDKRasterBlendLighten = 4
+} DKRasterBlendMode;
+
+/** @brief Copy the image in \c src into <code>dst</code>, which must be at least as large.
+ */
+extern void DKRasterCopy(const DKRasterBuffer* src, DKRasterBuffer* dst);
+
+/** @brief Blur \c buffer in place, approximating a gaussian blur with standard deviation <code>radius</code> pixels by three box
+ blurs in each direction.
+
+ Each box blur is a running sum, so the cost doesn't depend on the radius. Pixels outside the buffer count as transparent.
+ @param buffer the image to blur
+ @param scratch a buffer at least as large as <code>buffer</code>, whose contents are overwritten
+ @param radius the standard deviation of the blur, in pixels
+ */
+extern void DKRasterGaussianBlur(DKRasterBuffer* buffer, DKRasterBuffer* scratch, double radius);
+
+/** @brief Blur \c buffer in place with a single box blur of <code>radius</code> pixels either side of each pixel.
+ */
+extern void DKRasterBoxBlur(DKRasterBuffer* buffer, DKRasterBuffer* scratch, size_t radius);
+
+/** @brief Transform the colour of every pixel in \c buffer by a 4 x 5 matrix.
+
+ The matrix is in rows for red, green, blue and alpha, each of which is the four weights for the unpremultiplied source components
+ followed by a bias, with components scaled to 0..1 - the same arrangement as Core Image's \c CIColorMatrix.
+ */
+extern void DKRasterColourMatrix(DKRasterBuffer* buffer, const double matrix[20]);
+
+/** @brief Composite \c src over \c dst in place using <code>mode</code>.
+
+ The two buffers must be the same size.
+ @param opacity the opacity \c src is drawn with, 0..1
+ */
+extern void DKRasterBlend(const DKRasterBuffer* src, DKRasterBuffer* dst, DKRasterBlendMode mode, double opacity);
+
+/** @brief Put a drop shadow behind the image in <code>buffer</code>.
+
+ The shadow is the image's alpha, offset, blurred and tinted with <code>colour</code>, and the image is composited over it.
+ @param buffer the image to add a shadow to
+ @param shadow a buffer at least as large as <code>buffer</code>, whose contents are overwritten
+ @param scratch another such buffer
+ @param dx the offset of the shadow to the right, in pixels
+ @param dy the offset of the shadow downwards, in pixels
+ @param radius the standard deviation of the shadow's blur, in pixels
+ @param colour the premultiplied red, green, blue and alpha of the shadow, 0..1
+ */
+extern void DKRasterDropShadow(DKRasterBuffer* buffer, DKRasterBuffer* shadow, DKRasterBuffer* scratch, ptrdiff_t dx, ptrdiff_t dy, double radius, const double colour[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DKRasterEffects_h */
@@ -38,6 +38,7 @@ typedef NS_ENUM(NSInteger, DKClippingOption) {
 	NSString* m_name; // optional name
 	BOOL m_enabled; // YES if actually drawn
 	DKClippingOption mClipping; // set path clipping to this
+	NSUUID* mRenderingCacheKey; // key for this renderer's entries in objects' rendering caches
 }
 
 /** @brief creates a renderer from the pasteboard if possible.
@@ -106,6 +107,17 @@ typedef NS_ENUM(NSInteger, DKClippingOption) {
  @return the rendering path */
 - (NSBezierPath*)renderingPathForObject:(id<DKRenderable>)object;
 
+/** @brief Return the receiver's entry in \c object 's rendering cache, or \c nil if it has none.
+
+ Renderers that keep work for an object from one rendering to the next store it in the object's rendering cache. Each renderer's
+ entry has a key that is unique to it and never reused, so several renderers can keep entries for one object, and an entry left by
+ a renderer that has gone away can't be mistaken for another's.
+ */
+- (nullable id)renderingCacheEntryForObject:(id<DKRenderable>)object;
+/** @brief Set the receiver's entry in \c object 's rendering cache. Does nothing if the object has no rendering cache.
+ */
+- (void)setRenderingCacheEntry:(nullable id)entry forObject:(id<DKRenderable>)object;
+
 - (BOOL)copyToPasteboard:(NSPasteboard*)pb;
 
 @end
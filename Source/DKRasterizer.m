@@ -117,6 +117,26 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	return [object renderingPath];
 }
 
+- (id)renderingCacheEntryForObject:(id<DKRenderable>)object
+{
+	if (![object respondsToSelector:@selector(renderingCache)])
+		return nil;
+
+	return [[object renderingCache] objectForKey:mRenderingCacheKey];
+}
+
+- (void)setRenderingCacheEntry:(id)entry forObject:(id<DKRenderable>)object
+{
+	if (![object respondsToSelector:@selector(renderingCache)])
+		return;
+
+	if (entry)
+		[[object renderingCache] setObject:entry
+									forKey:mRenderingCacheKey];
+	else
+		[[object renderingCache] removeObjectForKey:mRenderingCacheKey];
+}
+
 - (BOOL)copyToPasteboard:(NSPasteboard*)pb
 {
 	NSAssert(pb != nil, @"expected pasteboard to be non-nil");
@@ -160,6 +180,7 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	if (self != nil) {
 		m_enabled = YES;
 		mClipping = kDKClippingNone;
+		mRenderingCacheKey = [[NSUUID alloc] init];
 	}
 	return self;
 }
@@ -259,6 +280,7 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 		[self setName:[coder decodeObjectForKey:@"name"]];
 		[self setEnabled:[coder decodeBoolForKey:@"enabled"]];
 		[self setClipping:[coder decodeIntegerForKey:@"DKRasterizer_clipping"]];
+		mRenderingCacheKey = [[NSUUID alloc] init];
 	}
 	return self;
 }
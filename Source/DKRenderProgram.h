@@ -0,0 +1,67 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+#import "DKRasterizerProtocol.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKRasterizer;
+
+/** @brief Opcodes of a render program.
+ */
+typedef NS_ENUM(NSInteger, DKRenderOpcode) {
+	kDKRenderOpSaveGraphicsState = 0,
+	kDKRenderOpRestoreGraphicsState = 1,
+	kDKRenderOpRender = 2
+};
+
+/** @brief One step of a render program. \c rasterizer and \c render are only used by <code>kDKRenderOpRender</code>.
+ */
+typedef struct {
+	DKRenderOpcode opcode;
+	__unsafe_unretained DKRasterizer* _Nullable rasterizer;
+	IMP _Nullable render;
+} DKRenderOp;
+
+/** @brief A render tree flattened into a linear list of steps.
+
+ Rendering a style by walking its tree repeats the same decisions for every object drawn: whether each group is enabled, which
+ renderers it contains, and the dispatch of -render: to each one. A render program makes those decisions once. Plain groups are
+ replaced by a save/restore pair around their contents, disabled renderers and empty groups are left out, and each remaining
+ renderer is called through its cached -render: implementation.
+
+ Groups that override -render: to do something of their own (such as DKQuartzBlendRastGroup or DKCIFilterRastGroup) are kept
+ as a single step, so their subtrees render exactly as before.
+
+ A program is immutable once built and keeps its renderers alive, so it can be run on any number of threads at the same time, each
+ drawing into its own graphics context. It does not watch the tree it was built from; its owner must discard it when that changes.
+ */
+@interface DKRenderProgram : NSObject {
+@private
+	DKRenderOp* mOps;
+	NSUInteger mCount;
+	NSUInteger mCapacity;
+	NSArray<DKRasterizer*>* mRasterizers;
+}
+
+/** @brief Build the program for \c root and everything it contains.
+ */
+- (instancetype)initWithRasterizer:(DKRasterizer*)root NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/** @brief Render \c object into the current graphics context.
+ */
+- (void)renderObject:(id<DKRenderable>)object;
+
+/** @brief The number of steps in the program.
+ */
+@property (readonly) NSUInteger count;
+@property (readonly) const DKRenderOp* ops NS_RETURNS_INNER_POINTER;
+
+@end
+
+NS_ASSUME_NONNULL_END
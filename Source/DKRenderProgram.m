@@ -0,0 +1,139 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKRenderProgram.h"
+#import "DKRastGroup.h"
+
+typedef void (*DKRenderIMP)(id, SEL, id);
+
+@interface DKRenderProgram ()
+
+- (void)appendOpcode:(DKRenderOpcode)opcode rasterizer:(DKRasterizer*)rast;
+- (void)compileRasterizer:(DKRasterizer*)rast isRoot:(BOOL)root into:(NSMutableArray*)rasterizers;
+
+@end
+
+#pragma mark -
+
+@implementation DKRenderProgram
+
+- (instancetype)initWithRasterizer:(DKRasterizer*)root
+{
+	NSAssert(root != nil, @"can't build a render program without a root");
+
+	self = [super init];
+	if (self != nil) {
+		NSMutableArray* rasterizers = [NSMutableArray array];
+
+		[self compileRasterizer:root
+						 isRoot:YES
+						   into:rasterizers];
+
+		mRasterizers = [rasterizers copy];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	free(mOps);
+}
+
+- (void)renderObject:(id<DKRenderable>)object
+{
+	SEL renderSel = @selector(render:);
+	NSUInteger depth = 0;
+
+	// the graphics state must balance even if a renderer throws, as the group methods this replaces guaranteed
+
+	@try {
+		for (NSUInteger i = 0; i < mCount; ++i) {
+			const DKRenderOp* op = &mOps[i];
+
+			switch (op->opcode) {
+			case kDKRenderOpSaveGraphicsState:
+				[NSGraphicsContext saveGraphicsState];
+				++depth;
+				break;
+
+			case kDKRenderOpRestoreGraphicsState:
+				[NSGraphicsContext restoreGraphicsState];
+				--depth;
+				break;
+
+			case kDKRenderOpRender:
+				((DKRenderIMP)op->render)(op->rasterizer, renderSel, object);
+				break;
+			}
+		}
+	}
+	@finally {
+		while (depth > 0) {
+			[NSGraphicsContext restoreGraphicsState];
+			--depth;
+		}
+	}
+}
+
+@synthesize count = mCount;
+@synthesize ops = mOps;
+
+#pragma mark -
+
+- (void)appendOpcode:(DKRenderOpcode)opcode rasterizer:(DKRasterizer*)rast
+{
+	if (mCount == mCapacity) {
+		mCapacity = MAX(16, mCapacity * 2);
+		mOps = realloc(mOps, mCapacity * sizeof(DKRenderOp));
+	}
+
+	DKRenderOp* op = &mOps[mCount++];
+
+	op->opcode = opcode;
+	op->rasterizer = rast;
+	op->render = rast ? [rast methodForSelector:@selector(render:)] : NULL;
+}
+
+- (void)compileRasterizer:(DKRasterizer*)rast isRoot:(BOOL)root into:(NSMutableArray*)rasterizers
+{
+	static IMP sGroupRender = NULL;
+
+	if (sGroupRender == NULL)
+		sGroupRender = [DKRastGroup instanceMethodForSelector:@selector(render:)];
+
+	if (![rast enabled])
+		return;
+
+	// the root is always expanded - its own -render: is the one running the program. Other groups are only expanded if they
+	// render in the standard way, i.e. just bracket their contents with a save and restore.
+
+	if ([rast isKindOfClass:[DKRastGroup class]] && (root || [rast methodForSelector:@selector(render:)] == sGroupRender)) {
+		NSUInteger mark = mCount;
+
+		[self appendOpcode:kDKRenderOpSaveGraphicsState
+				rasterizer:nil];
+
+		for (DKRasterizer* child in [(DKRastGroup*)rast renderList])
+			[self compileRasterizer:child
+							 isRoot:NO
+							   into:rasterizers];
+
+		// a group that draws nothing needn't touch the graphics state either
+
+		if (mCount == mark + 1)
+			mCount = mark;
+		else
+			[self appendOpcode:kDKRenderOpRestoreGraphicsState
+					rasterizer:nil];
+	} else {
+		[rasterizers addObject:rast];
+		[self appendOpcode:kDKRenderOpRender
+				rasterizer:rast];
+	}
+}
+
+@end
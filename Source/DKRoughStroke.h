@@ -16,7 +16,7 @@ NS_ASSUME_NONNULL_BEGIN
 
  The nominal width, colour, etc are all inherited from <code>DKStroke</code>. \c roughness is the amount of randomness and is a fraction of the stroke width.
 
- Because a roughened path is both fairly complicated to compute and has a lot of randomness that is different every time, this object caches the roughened
+ Because a roughened path is fairly complicated to compute, this object caches the roughened
  paths it generates and re-uses them as much as it can. A path is cached based on its bounds, width and length, giving a key that is likely to be unique in practice.
  Paths are cached up to the maximum number set by the constant, after which least used cached paths are discarded.
 */
@@ -25,9 +25,15 @@ NS_ASSUME_NONNULL_BEGIN
 	CGFloat mRoughness;
 	NSMutableDictionary<NSString*, NSBezierPath*>* mPathCache;
 	NSMutableArray<NSBezierPath*>* mCacheList;
+	uint64_t mSeed;
 }
 
 @property (nonatomic) CGFloat roughness;
+/** @brief The seed for the roughening. A given path roughened with the same seed, roughness and width always comes out the same.
+
+ New strokes are given a random seed. The seed is archived and copied, so a document looks the same every time it is opened.
+ */
+@property (nonatomic) uint64_t seed;
 
 - (NSString*)pathKeyForPath:(NSBezierPath*)path;
 - (void)invalidateCache;
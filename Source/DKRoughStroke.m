@@ -5,6 +5,7 @@
 */
 
 #import "DKRoughStroke.h"
+#import "DKRandom.h"
 #import "NSBezierPath+Geometry.h"
 
 @implementation DKRoughStroke
@@ -21,6 +22,16 @@
 
 @synthesize roughness = mRoughness;
 
+- (void)setSeed:(uint64_t)seed
+{
+	if (seed != mSeed) {
+		mSeed = seed;
+		[self invalidateCache];
+	}
+}
+
+@synthesize seed = mSeed;
+
 - (NSString*)pathKeyForPath:(NSBezierPath*)path
 {
 	// form a simple hash from the path's size, length and current stroke width. Note that the precision is deliberately set to just 1 decimal
@@ -48,7 +59,15 @@
 	if (cp == nil) {
 		// not in the cache, so create it from scratch
 
-		cp = [path bezierPathWithRoughenedStrokeOutline:[self roughness] * [self width]];
+		// seed a generator from the stroke's seed and the key, so that the same path always roughens the same way
+
+		DKRandomState rng;
+		const char* keyBytes = [key UTF8String];
+
+		DKRandomSeed(&rng, mSeed ^ DKRandomHashBytes(kDKRandomHashInitial, keyBytes, strlen(keyBytes)));
+
+		cp = [path bezierPathWithRoughenedStrokeOutline:[self roughness] * [self width]
+											randomState:&rng];
 
 		if (cp != nil) {
 			// set its origin to 0,0 based on the original path
@@ -106,6 +125,7 @@
 		mPathCache = [[NSMutableDictionary alloc] init];
 		mCacheList = [[NSMutableArray alloc] init];
 		[self setRoughness:0.25];
+		mSeed = [DKRandom randomSeed];
 	}
 
 	return self;
@@ -147,7 +167,7 @@
 
 + (NSArray*)observableKeyPaths
 {
-	return [[super observableKeyPaths] arrayByAddingObjectsFromArray:@[@"roughness"]];
+	return [[super observableKeyPaths] arrayByAddingObjectsFromArray:@[@"roughness", @"seed"]];
 }
 
 - (void)registerActionNames
@@ -155,6 +175,8 @@
 	[super registerActionNames];
 	[self setActionName:@"#kind# Stroke Roughness"
 			 forKeyPath:@"roughness"];
+	[self setActionName:@"#kind# Stroke Roughness Pattern"
+			 forKeyPath:@"seed"];
 }
 
 #pragma mark -
@@ -166,6 +188,11 @@
 		mPathCache = [[NSMutableDictionary alloc] init];
 		mCacheList = [[NSMutableArray alloc] init];
 		[self setRoughness:[coder decodeDoubleForKey:@"DKRoughStroke_roughness"]];
+
+		if ([coder containsValueForKey:@"DKRoughStroke_seed"])
+			mSeed = (uint64_t)[coder decodeInt64ForKey:@"DKRoughStroke_seed"];
+		else
+			mSeed = [DKRandom randomSeed];
 	}
 
 	return self;
@@ -176,6 +203,8 @@
 	[super encodeWithCoder:coder];
 	[coder encodeDouble:[self roughness]
 				 forKey:@"DKRoughStroke_roughness"];
+	[coder encodeInt64:(int64_t)mSeed
+				forKey:@"DKRoughStroke_seed"];
 }
 
 #pragma mark -
@@ -185,6 +214,7 @@
 {
 	DKRoughStroke* rs = [super copyWithZone:zone];
 	[rs setRoughness:[self roughness]];
+	[rs setSeed:[self seed]];
 
 	return rs;
 }
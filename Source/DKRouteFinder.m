@@ -5,6 +5,7 @@
 */
 
 #import "DKRouteFinder.h"
+#import "DKRandom.h"
 
 static CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger annealingSteps, const void* context);
 static void progressCallback(CGFloat iteration, CGFloat maxIterations, const void* context);
@@ -445,10 +446,7 @@ static DKDirection directionOfAngle(const CGFloat angle)
 
 static NSInteger* ivector(long nl, long nh);
 static void free_ivector(NSInteger* v, long nl, long nh);
-static CGFloat ran3(long* idum);
-static NSInteger irbit1(unsigned long* iseed);
-static NSInteger metrop(CGFloat de, CGFloat t);
-static CGFloat ran3(long* idum);
+static NSInteger metrop(CGFloat de, CGFloat t, DKRandomState* rng);
 static CGFloat revcst(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger n[]);
 static void reverse(NSInteger iorder[], NSInteger ncity, NSInteger n[]);
 static CGFloat trncst(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger n[]);
@@ -482,81 +480,6 @@ void free_ivector(NSInteger* v, long nl, long nh)
 	free((FREE_ARG)(v + nl - NR_END));
 }
 
-#define MBIG 1000000000
-#define MSEED 161803398
-#define MZ 0
-#define FAC (1.0 / MBIG)
-
-CGFloat ran3(long* idum)
-{
-	static NSInteger inext, inextp;
-	static long ma[56];
-	static NSInteger iff = 0;
-	long mj, mk;
-	NSInteger i, ii, k;
-
-	if (*idum < 0 || iff == 0) {
-		iff = 1;
-		mj = MSEED - (*idum < 0 ? -*idum : *idum);
-		mj %= MBIG;
-		ma[55] = mj;
-		mk = 1;
-
-		for (i = 1; i <= 54; i++) {
-			ii = (21 * i) % 55;
-			ma[ii] = mk;
-			mk = mj - mk;
-			if (mk < MZ)
-				mk += MBIG;
-			mj = ma[ii];
-		}
-
-		for (k = 1; k <= 4; k++) {
-			for (i = 1; i <= 55; i++) {
-				ma[i] -= ma[1 + (i + 30) % 55];
-				if (ma[i] < MZ)
-					ma[i] += MBIG;
-			}
-		}
-		inext = 0;
-		inextp = 31;
-		*idum = 1;
-	}
-
-	if (++inext == 56)
-		inext = 1;
-
-	if (++inextp == 56)
-		inextp = 1;
-
-	mj = ma[inext] - ma[inextp];
-
-	if (mj < MZ)
-		mj += MBIG;
-
-	ma[inext] = mj;
-
-	return mj * FAC;
-}
-
-#define IB1 1
-#define IB2 2
-#define IB5 16
-#define IB18 131072
-#define MASK (IB1 + IB2 + IB5)
-
-NSInteger irbit1(unsigned long* iseed)
-{
-	unsigned long newbit;
-
-	newbit = (*iseed & IB18) >> 17
-		^ (*iseed & IB5) >> 4
-		^ (*iseed & IB2) >> 1
-		^ (*iseed & IB1);
-	*iseed = (*iseed << 1) | newbit;
-	return (NSInteger)newbit;
-}
-
 /*
 This algorithm ﬁnds the shortest round-trip path to ncity cities whose coordinates are in the
 arrays x[1..ncity], y[1..ncity]. The array iorder[1..ncity] speciﬁes the order in
@@ -568,6 +491,7 @@ function result is the final path length
 
 #pragma mark -
 #define TFACTR 0.9 // Annealing schedule: reduce t by this factor on each step.
+#define kDKAnnealingSeed 111
 #define ALEN(a, b, c, d) sqrt(((b) - (a)) * ((b) - (a)) + ((d) - (c)) * ((d) - (c)))
 
 CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger annealingSteps, const void* context)
@@ -575,11 +499,14 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 	NSInteger ans, nover, nlimit, i1, i2;
 	NSInteger i, j, k, nsucc, nn, idec;
 
-	static NSInteger n[7];
-	static long idum = -1;
-	static unsigned long iseed = 111;
+	NSInteger n[7];
+	DKRandomState rng;
 	CGFloat path, de, t, previousPath;
 
+	// the generator is local and always seeded the same way, so the same cities give the same route on any thread
+
+	DKRandomSeed(&rng, kDKAnnealingSeed);
+
 	nover = 100 * ncity; // Maximum number of paths tried at any temperature.
 	nlimit = 20 * ncity; // Maximum number of successful path changes before continuing.
 	path = 0.0;
@@ -597,8 +524,6 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 	i1 = iorder[ncity]; // Close the loop by tying path ends together.
 	i2 = iorder[1];
 	path += ALEN(x[i1], x[i2], y[i1], y[i2]);
-	//idum = -1;
-	//iseed = 111;
 
 	previousPath = path;
 
@@ -619,25 +544,25 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 			}
 
 			do {
-				n[1] = 1 + (NSInteger)(ncity * ran3(&idum)); // Choose beginning of segment..
-				n[2] = 1 + (NSInteger)((ncity - 1) * ran3(&idum)); // ..and end of segment.
+				n[1] = 1 + (NSInteger)(ncity * DKRandomUnit(&rng)); // Choose beginning of segment..
+				n[2] = 1 + (NSInteger)((ncity - 1) * DKRandomUnit(&rng)); // ..and end of segment.
 				if (n[2] >= n[1])
 					++n[2];
 
 				nn = 1 + ((n[1] - n[2] + ncity - 1) % ncity); // nn is the number of cities not on the segment.
 			} while (nn < 3);
 
-			idec = irbit1(&iseed);
+			idec = DKRandomNext(&rng) >> 63;
 
 			// Decide whether to do a segment reversal or transport.
 			if (idec == 0) {
 				// Do a transport.
-				n[3] = n[2] + (NSInteger)(labs(nn - 2) * ran3(&idum)) + 1;
+				n[3] = n[2] + (NSInteger)(labs(nn - 2) * DKRandomUnit(&rng)) + 1;
 				n[3] = 1 + ((n[3] - 1) % ncity);
 
 				// Transport to a location not on the path.
 				de = trncst(x, y, iorder, ncity, n); // Calculate cost.
-				ans = metrop(de, t); // Consult the oracle.
+				ans = metrop(de, t, &rng); // Consult the oracle.
 				if (ans) {
 					++nsucc;
 					path += de;
@@ -646,7 +571,7 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 			} else {
 				// Do a path reversal.
 				de = revcst(x, y, iorder, ncity, n); // Calculate cost.
-				ans = metrop(de, t); // Consult the oracle.
+				ans = metrop(de, t, &rng); // Consult the oracle.
 
 				if (ans) {
 					++nsucc;
@@ -811,9 +736,7 @@ metrop = 1(true), while if de > 0, metrop is only true with probability exp(-de/
 t is a temperature determined by the annealing schedule.
 */
 
-NSInteger metrop(CGFloat de, CGFloat t)
+NSInteger metrop(CGFloat de, CGFloat t, DKRandomState* rng)
 {
-	static long gljdum = 1;
-
-	return de < 0.0 || ran3(&gljdum) < exp(-de / t);
+	return de < 0.0 || DKRandomUnit(rng) < exp(-de / t);
 }
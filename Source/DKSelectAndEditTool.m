@@ -964,18 +964,18 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 			default:
 				break;
 
-			case kDKEditToolSelectionMode:
-				[self setMarqueeRect:NSRectFromTwoPoints(mAnchorPoint, p)
-							 inLayer:odl];
+			case kDKEditToolSelectionMode: {
+				// the layer only needs to look at the area the marquee has moved over since the last drag
 
-				sel = [odl objectsInRect:[self marqueeRect]];
+				NSRect oldMarquee = [self marqueeRect];
 
-				if (extended)
-					[odl addObjectsToSelectionFromArray:sel];
-				else
-					[odl exchangeSelectionWithObjectsFromArray:sel];
+				[self setMarqueeRect:NSRectFromTwoPoints(mAnchorPoint, p)
+							 inLayer:odl];
 
-				break;
+				[odl changeSelectionForMarqueeRect:[self marqueeRect]
+										  fromRect:oldMarquee
+										 extending:extended];
+			} break;
 
 			case kDKEditToolMoveObjectsMode:
 				sel = [self draggedObjects];
@@ -21,8 +21,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class DKObjectOwnerLayer, DKShapeGroup;
 
+/** @brief Draws a layer, or a whole drawing, into the current context, e.g. for export.
+
+ While it draws, the view reports the rect passed to \c -drawRect: as the only rect being drawn, so that layers cull their objects to it
+ even when \c -drawRect: is called directly rather than by AppKit, as it is for each band of a bitmap export.
+ */
 @interface DKLayerPDFView : DKDrawingView {
 	__weak DKLayer* mLayerRef;
+	NSRect mDrawingRect; // the rect being drawn, while mIsDrawing is YES
+	BOOL mIsDrawing;
 }
 
 - (instancetype)initWithFrame:(NSRect)frame withLayer:(nullable DKLayer*)aLayer NS_DESIGNATED_INITIALIZER;
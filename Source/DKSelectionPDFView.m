@@ -59,23 +59,49 @@
 
 - (void)drawRect:(NSRect)rect
 {
-#pragma unused(rect)
-
 	//[[NSColor clearColor] set];
 	//NSRectFill([self bounds]);
 
 	if (mLayerRef != nil) {
 		[self set];
 
+		// only draw what was asked for - banded export relies on this to avoid drawing the whole layer for every band. Object storage
+		// culls using the rects the view says are being drawn, so those are the rect too.
+
+		mDrawingRect = NSIntersectionRect(rect, [self bounds]);
+		mIsDrawing = YES;
+
 		[mLayerRef beginDrawing];
-		[mLayerRef drawRect:[self bounds]
+		[mLayerRef drawRect:mDrawingRect
 					 inView:self];
 		[mLayerRef endDrawing];
 
+		mIsDrawing = NO;
+
 		[[self class] pop];
 	}
 }
 
+- (void)getRectsBeingDrawn:(const NSRect**)rects count:(NSInteger*)count
+{
+	if (mIsDrawing) {
+		if (rects)
+			*rects = &mDrawingRect;
+		if (count)
+			*count = 1;
+	} else
+		[super getRectsBeingDrawn:rects
+							count:count];
+}
+
+- (BOOL)needsToDrawRect:(NSRect)aRect
+{
+	if (mIsDrawing)
+		return NSIntersectsRect(aRect, mDrawingRect);
+
+	return [super needsToDrawRect:aRect];
+}
+
 - (instancetype)initWithCoder:(NSCoder*)decoder
 {
 	return self = [super initWithCoder:decoder];
@@ -525,6 +525,12 @@
 	return [super bounds];
 }
 
+- (void)invalidateInheritedMetadata
+{
+	[super invalidateInheritedMetadata];
+	[[self groupObjects] makeObjectsPerformSelector:@selector(invalidateInheritedMetadata)];
+}
+
 - (NSSet*)allStyles
 {
 	// return the union of all the contained objects' styles
@@ -877,7 +883,7 @@
 			return nil;
 		}
 
-		[[self path] appendBezierPathWithRect:[[self class] unitRectAtOrigin]];
+		[self setPath:[NSBezierPath bezierPathWithRect:[[self class] unitRectAtOrigin]]];
 		mBounds = [coder decodeRectForKey:@"group_bounds"];
 
 		mClipContentToPath = [coder decodeBoolForKey:@"DKShapeGroup_clipContent"];
@@ -9,7 +9,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawableObject, DKUndoManager;
+@class DKDrawableObject, DKRenderProgram, DKUndoManager;
 
 //! swatch types that can be passed to \c -styleSwatchWithSize:type:
 typedef NS_ENUM(NSInteger, DKStyleSwatchType) {
@@ -34,12 +34,12 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
 	NSUndoManager* __weak m_undoManagerRef; // style's undo manager
 	BOOL m_shared; // YES if the style is shared
 	BOOL m_locked; // YES if style can't be edited
-	id m_renderClientRef; // valid only while actually drawing
 	NSString* m_uniqueKey; // unique key, set once for all time
 	BOOL m_mergeFlag; // set to YES when a style is read in from a file and was saved in a registered state.
 	NSTimeInterval m_lastModTime; // timestamp to determine when styles have been updated
 	NSUInteger m_clientCount; // keeps count of the clients using the style
 	NSMutableDictionary* mSwatchCache; // cache of swatches at various sizes previously requested
+	DKRenderProgram* mRenderProgram; // compiled form of the render tree, built on demand
 }
 
 // basic standard styles:
@@ -445,10 +445,20 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
 /** @brief Returns the current object being rendered by this style.
 
  This is only valid when called while rendering is in progress - mainly for the benefit of renderers
- that are part of this style.
+ that are part of this style. The client is tracked per thread, so a style rendering different objects
+ on several threads at once returns the right one to each.
  @return The current rendering object.
  */
-- (id)currentRenderClient;
+- (nullable id)currentRenderClient;
+
+// rendering
+
+/** @brief The compiled form of the style's render tree, which is what -render: actually runs.
+
+ Built the first time it is needed and discarded whenever the style or any of its components changes.
+ Safe to obtain and run from any thread.
+ */
+@property (readonly, strong) DKRenderProgram* renderProgram;
 
 // making derivative styles:
 
@@ -13,9 +13,11 @@
 #import "DKGradient.h"
 #import "DKHatching.h"
 #import "DKImageAdornment.h"
+#import "DKRenderProgram.h"
 #import "DKRoughStroke.h"
 #import "DKStyleRegistry.h"
 #import "DKTextAdornment.h"
+#import "DKTrace.h"
 #import "DKUndoManager.h"
 #import "DKUniqueID.h"
 #import "LogEvent.h"
@@ -55,9 +57,19 @@ static BOOL sShouldDrawShadows = YES;
 static BOOL sAntialias = YES;
 static BOOL sSubstitute = NO;
 
+// the style being rendered on this thread and the object it is rendering, for -currentRenderClient
+
+static __thread __unsafe_unretained DKStyle* sRenderingStyle = nil;
+static __thread __unsafe_unretained id sRenderClient = nil;
+
 @interface DKStyle ()
 
 - (NSSize)extraSpaceNeededIgnoringMitreLimit;
+- (void)invalidateRenderProgram;
+
+/** @brief The current render program, or nil if it needs building. Atomic, as it may be read while rendering on several threads.
+ */
+@property (strong, nullable) DKRenderProgram* cachedRenderProgram;
 
 @end
 
@@ -394,6 +406,7 @@ static BOOL sSubstitute = NO;
 	// invalidate any swatch cache to ensure cache is forced to be rebuilt after a change
 
 	[mSwatchCache removeAllObjects];
+	[self invalidateRenderProgram];
 
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleDidChangeNotification
 														object:self];
@@ -1196,7 +1209,33 @@ static BOOL sSubstitute = NO;
  */
 - (id)currentRenderClient
 {
-	return m_renderClientRef;
+	return (sRenderingStyle == self) ? sRenderClient : nil;
+}
+
+#pragma mark -
+#pragma mark - render program
+
+@synthesize cachedRenderProgram = mRenderProgram;
+
+- (DKRenderProgram*)renderProgram
+{
+	// if two threads get here at once both will build a program, which is harmless - the last one stored wins
+
+	DKRenderProgram* program = self.cachedRenderProgram;
+
+	if (program == nil) {
+		program = [[DKRenderProgram alloc] initWithRasterizer:self];
+		self.cachedRenderProgram = program;
+	}
+
+	return program;
+}
+
+/** @brief Discards the render program so that it is rebuilt from the current tree when next needed
+ */
+- (void)invalidateRenderProgram
+{
+	self.cachedRenderProgram = nil;
 }
 
 /** @brief Returns a new style formed by copying the rasterizers from the receiver and the other style into one
@@ -1249,6 +1288,25 @@ static BOOL sSubstitute = NO;
 #pragma mark -
 #pragma mark As a DKRastGroup
 
+- (void)setRenderList:(NSArray*)list
+{
+	[super setRenderList:list];
+	[self invalidateRenderProgram];
+}
+
+- (void)insertObject:(id)obj inRenderListAtIndex:(NSUInteger)indx
+{
+	[super insertObject:obj
+		inRenderListAtIndex:indx];
+	[self invalidateRenderProgram];
+}
+
+- (void)removeObjectFromRenderListAtIndex:(NSUInteger)indx
+{
+	[super removeObjectFromRenderListAtIndex:indx];
+	[self invalidateRenderProgram];
+}
+
 /** @brief Adds a renderer to the style, ensuring internal KVO linkage is established
  @param renderer the renderer to attach
  */
@@ -1348,35 +1406,44 @@ static BOOL sSubstitute = NO;
 
 /** @brief Renders the object using this style
 
- Sets the value of the client for the duration of rendering */
+ Runs the style's render program, which is reentrant, so the same style may render different objects on several
+ threads at once. The caller is responsible for an autorelease pool and for handling exceptions - DKDrawableObject
+ sets up both around each object it draws. */
 - (void)render:(id<DKRenderable>)object
 {
-	if (![object conformsToProtocol:@protocol(DKRenderable)])
+	if (![self enabled])
 		return;
 
-	if ([self enabled]) {
-		@autoreleasepool {
+	DKTraceScope(span, kDKTraceRendering, "style render");
 
-			if (![[self class] shouldAntialias] && [NSGraphicsContext currentContextDrawingToScreen]) {
-				[[NSGraphicsContext currentContext] setShouldAntialias:NO];
-				[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationNone];
-			}
+	if (![[self class] shouldAntialias] && [NSGraphicsContext currentContextDrawingToScreen]) {
+		[[NSGraphicsContext currentContext] setShouldAntialias:NO];
+		[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationNone];
+	}
 
-			m_renderClientRef = object;
+	DKRenderProgram* program = [self renderProgram];
+	__unsafe_unretained DKStyle* savedStyle = sRenderingStyle;
+	__unsafe_unretained id savedClient = sRenderClient;
 
-			@try {
-				[super render:object];
-			}
-			@catch (NSException* exception) {
-				// exceptions thrown during drawing can cause a lot of problems that multiply a minor bug into a major one.
-				// Each renderer should ideally take steps to catch an yexceptions and deal with them appropriately - if it does not
-				// this catch will log the problem, but NOT rethrown, so higher level drawing code doesn't see the exception. If you
-				// see this log, the problem should be investigated.
+	sRenderingStyle = self;
+	sRenderClient = object;
 
-				NSLog(@"An exception occurred while rendering the style - PLEASE FIX - %@. Exception = %@", self, exception);
-			}
-			m_renderClientRef = nil;
-		}
+	@try {
+		[program renderObject:object];
+	}
+	@catch (NSException* exception) {
+		// exceptions thrown during drawing can cause a lot of problems that multiply a minor bug into a major one.
+		// Each renderer should ideally take steps to catch any exceptions and deal with them appropriately - if it does not
+		// this catch will log the problem, but NOT rethrow it, so higher level drawing code doesn't see the exception. If you
+		// see this log, the problem should be investigated.
+
+		NSLog(@"An exception occurred while rendering the style - PLEASE FIX - %@. Exception = %@", self, exception);
+	}
+	@finally {
+		// the render client is per thread, and must not be left pointing at an object that may not outlive this call
+
+		sRenderingStyle = savedStyle;
+		sRenderClient = savedClient;
 	}
 }
 
@@ -1455,7 +1522,6 @@ static BOOL sSubstitute = NO;
 		NSAssert(m_undoManagerRef == nil, @"Expected init to zero");
 		[self setStyleSharable:[[self class] stylesAreSharableByDefault]];
 		NSAssert(!m_locked, @"Expected init to NO");
-		NSAssert(m_renderClientRef == nil, @"Expected init to zero");
 
 		m_mergeFlag = NO;
 		[self assignUniqueKey];
@@ -1545,7 +1611,6 @@ static BOOL sSubstitute = NO;
 		[self setStyleSharable:[coder decodeBoolForKey:@"shared"]];
 		[self setLocked:[coder decodeBoolForKey:@"locked"]];
 		mSwatchCache = [[NSMutableDictionary alloc] init];
-		NSAssert(m_renderClientRef == nil, @"Expected init to zero");
 		m_clientCount = 0;
 
 		// once the entire style and its rasterizer tree have been unarchived, start observing all of the individual
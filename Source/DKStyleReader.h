@@ -11,8 +11,14 @@
 
 @interface DKStyleReader : DKEvaluator {
 	DKParser* mParser;
+	NSCache* mCompiledScripts; // script text -> parsed tree
 }
 
+/** @brief Parse and evaluate \c script, returning the object it describes.
+
+ The parsed form of each script is kept, so evaluating the same script again only repeats the evaluation. Evaluation never
+ modifies a parsed tree, so each call still returns new objects.
+ */
 - (id)evaluateScript:(NSString*)script;
 - (id)readContentsOfFile:(NSString*)filenamet;
 - (void)loadBuiltinSymbols;
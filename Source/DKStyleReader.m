@@ -14,10 +14,21 @@
 @implementation DKStyleReader
 #pragma mark As a DKStyleReader
 
-/**  */
 - (id)evaluateScript:(NSString*)script
 {
-	return [self evaluateExpression:[mParser parseString:script]];
+	id tree = [mCompiledScripts objectForKey:script];
+
+	if (tree == nil) {
+		tree = [mParser parseString:script];
+
+		if (tree == nil)
+			return nil;
+
+		[mCompiledScripts setObject:tree
+							 forKey:[[script copy] autorelease]];
+	}
+
+	return [self evaluateExpression:tree];
 }
 
 - (id)readContentsOfFile:(NSString*)filename;
@@ -152,6 +163,7 @@
 #pragma mark As an NSObject
 - (void)dealloc
 {
+	[mCompiledScripts release];
 	[mParser release];
 
 	[super dealloc];
@@ -162,8 +174,10 @@
 	self = [super init];
 	if (self != nil) {
 		mParser = [[DKParser alloc] init];
+		mCompiledScripts = [[NSCache alloc] init];
+		[mCompiledScripts setCountLimit:64];
 
-		if (mParser == nil) {
+		if (mParser == nil || mCompiledScripts == nil) {
 			[self autorelease];
 			self = nil;
 		}
@@ -116,7 +116,12 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  Cut/Paste: cut and paste of styles works independently of the registry, including dealing with shared styles. See DKStyle for more info.
 */
 @interface DKStyleRegistry : DKCategoryManager <DKStyle*>
-<DKCategoryManagerMenuItemDelegate>
+<DKCategoryManagerMenuItemDelegate> {
+@private
+	NSCountedSet<NSString*>* mStyleNames; // names of all registered styles, used to resolve name collisions
+	NSUInteger mStyleNamesChangeCount; // the changeCount at which mStyleNames was last valid
+	id mStyleNameObserver; // notification observer that invalidates mStyleNames when a registered style is renamed
+}
 
 	// retrieving the registry and styles
 
@@ -48,6 +48,17 @@ NSString* const kDKStyleWasEditedWhileRegisteredNotification = @"kDKStyleWasEdit
 
 #pragma mark -
 
+@interface DKStyleRegistry ()
+
+/** @brief The names of the registered styles, rebuilt if the registry has changed since it was last used.
+ */
+- (NSCountedSet<NSString*>*)styleNameIndex;
+- (void)startObservingStyleNames;
+
+@end
+
+#pragma mark -
+
 @implementation DKStyleRegistry
 
 // warning: only access this using +sharedStyleRegistry
@@ -173,13 +184,21 @@ static BOOL s_NoDKDefaults = NO;
 	name = [reg uniqueNameForName:name];
 	[aStyle setName:name];
 
-	// add the style to the registry
+	// add the style to the registry. If nothing else changed the registry meanwhile, the name index can be brought up
+	// to date directly instead of being rebuilt next time.
+
+	NSUInteger changeCount = [reg changeCount];
 
 	[reg addObject:aStyle
 				  forKey:styleID
 			toCategories:styleCategories
 		createCategories:YES];
 
+	if (reg->mStyleNames && reg->mStyleNamesChangeCount == changeCount && [reg changeCount] == changeCount + 1) {
+		[reg->mStyleNames addObject:name];
+		reg->mStyleNamesChangeCount = [reg changeCount];
+	}
+
 	LogEvent_(kStateEvent, @"registered new style %@; key = %@ '%@'", aStyle, [aStyle uniqueKey], [aStyle name]);
 
 	// finally lock the style to prevent accidental edits to registered styles. (Edits are still possible if the style is unlocked first
@@ -220,17 +239,19 @@ static BOOL s_NoDKDefaults = NO;
 {
 	NSAssert(styles != nil, @"array of styles was nil - can't register");
 
-	NSArray* stNames = nil;
+	NSSet* stNames = nil;
 
 	[[self sharedStyleRegistry] setRecentlyAddedListEnabled:NO];
 
 	for (DKStyle* style in styles) {
 		if (ignoreDupes) {
+			// only names registered before this call count as duplicates, so take a copy
+
 			if (stNames == nil) {
-				stNames = [[self sharedStyleRegistry] styleNames];
+				stNames = [[[self sharedStyleRegistry] styleNameIndex] copy];
 			}
 
-			if ([stNames containsObject:[style name]]) {
+			if ([style name] && [stNames containsObject:[style name]]) {
 				continue;
 			}
 		}
@@ -629,20 +650,48 @@ static BOOL s_NoDKDefaults = NO;
 	// if <name> already exists among the registerd styles, append a number to it until it is not found.
 
 	NSInteger numeral = 0;
-	BOOL found = YES;
 	NSString* temp = name;
-	NSArray* keys = [self styleNames];
+	NSCountedSet* names = [self styleNameIndex];
+
+	while ([names containsObject:temp])
+		temp = [NSString stringWithFormat:@"%@ %ld", name, (long)++numeral];
+
+	return temp;
+}
+
+- (NSCountedSet*)styleNameIndex
+{
+	if (mStyleNames == nil || mStyleNamesChangeCount != [self changeCount]) {
+		mStyleNames = [[NSCountedSet alloc] init];
 
-	while (found) {
-		NSInteger k = [keys indexOfObject:temp];
+		for (DKStyle* style in [self allObjects]) {
+			if ([style name])
+				[mStyleNames addObject:[style name]];
+		}
 
-		if (k == NSNotFound)
-			found = NO;
-		else
-			temp = [NSString stringWithFormat:@"%@ %ld", name, (long)++numeral];
+		mStyleNamesChangeCount = [self changeCount];
 	}
 
-	return temp;
+	return mStyleNames;
+}
+
+- (void)startObservingStyleNames
+{
+	// a registered style that is renamed makes the name index out of date. Styles being registered are renamed before
+	// they are added, so don't affect it. This is independent of +setStyleNotificationsEnabled:, which only concerns menus.
+
+	__weak DKStyleRegistry* weakSelf = self;
+
+	mStyleNameObserver = [[NSNotificationCenter defaultCenter] addObserverForName:kDKStyleNameChangedNotification
+																		   object:nil
+																			queue:nil
+																	   usingBlock:^(NSNotification* note) {
+																		   DKStyleRegistry* reg = weakSelf;
+																		   DKStyle* style = [note object];
+
+																		   if (reg && [reg styleForKey:[style uniqueKey]] == style)
+																			   reg->mStyleNames = nil;
+																	   }];
 }
 
 /** @brief Return a list of all the registered styles' names, in alphabetical order
@@ -1030,8 +1079,29 @@ static BOOL s_NoDKDefaults = NO;
 #pragma mark -
 #pragma mark As a NSObject
 
+- (instancetype)init
+{
+	self = [super init];
+	if (self != nil)
+		[self startObservingStyleNames];
+
+	return self;
+}
+
+- (instancetype)initWithCoder:(NSCoder*)coder
+{
+	self = [super initWithCoder:coder];
+	if (self != nil)
+		[self startObservingStyleNames];
+
+	return self;
+}
+
 - (void)dealloc
 {
+	if (mStyleNameObserver)
+		[[NSNotificationCenter defaultCenter] removeObserver:mStyleNameObserver];
+
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 }
 
@@ -10,6 +10,8 @@
 #import "DKRandom.h"
 #import "LogEvent.h"
 
+#define kDKSweptAngleDitherSeed 0x5EED
+
 @interface DKGradient (Private)
 - (void)private_colorAtValue:(CGFloat)val components:(CGFloat*)components randomAccess:(BOOL)ra;
 @end
@@ -114,17 +116,33 @@
 
 		unsigned int* p = (unsigned int*)buffer;
 
+		// the dither is drawn from a generator with a fixed seed, so that rebuilding the cache reproduces the same image. Offsets
+		// are generated a row at a time.
+
+		DKRandomState rng;
+		CGFloat* dither = NULL;
+
+		if (m_ditherColours) {
+			DKRandomSeed(&rng, kDKSweptAngleDitherSeed);
+			dither = (CGFloat*)malloc(width * sizeof(CGFloat));
+		}
+
 		for (y = 0; y < height; ++y) {
+			if (dither)
+				DKRandomFillSigned(&rng, dither, width, 2.0);
+
 			for (x = 0; x < width; ++x) {
 				// need to know angle of x,y relative to centre point which gives us an index into the colour table
 
 				angle = atan2((CGFloat)y - cp.y, (CGFloat)x - cp.x) + M_PI;
 				colour = (NSUInteger)((angle * (CGFloat)nColours) / twopi);
 
-				// add a bit of random dither to the colour
+				// add a bit of random dither to the colour, wrapping in both directions
 
-				if (m_ditherColours)
-					colour = (NSInteger)(colour + [DKRandom randomPositiveOrNegativeNumber] * 2.0) % nColours;
+				if (dither)
+					colour = ((NSInteger)(colour + dither[x]) + nColours) % nColours;
+				else if (colour >= nColours)
+					colour = nColours - 1;
 
 				// write the colour to the image in one fell swoop
 
@@ -132,6 +150,8 @@
 			}
 		}
 
+		free(dither);
+
 		// convert to an image.
 
 		m_sa_image = CGBitmapContextCreateImage(m_sa_bitmap);
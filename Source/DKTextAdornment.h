@@ -48,7 +48,7 @@ NS_ASSUME_NONNULL_BEGIN
 	CGFloat mTextKnockoutStrokeWidth; // stroke width for text knockout, if any (0 = none)
 	NSColor* mTextKnockoutColour; // colour for text knockout, default = white
 	NSColor* mTextKnockoutStrokeColour; // colour for stroking the text knockout, default = black
-	NSMutableDictionary* mTACache; // private cache used for various text layout caching
+	NSUInteger mCacheGeneration; // advanced by -invalidateCache, so that layouts cached by objects from before are discarded
 	NSDictionary* mDefaultAttributes; // saves default attributes for when text is deleted altogether
 }
 
@@ -61,6 +61,14 @@ NS_ASSUME_NONNULL_BEGIN
 @property (class, readonly, strong) NSDictionary<NSAttributedStringKey, id>* defaultTextAttributes;
 @property (class, readonly, copy) NSString* defaultLabel;
 @property (class) CGFloat defaultMaximumVerticalOffset;
+/** @brief the size, in device pixels, below which text drawn to the screen is greeked automatically
+
+ When an adornment whose greeking is \c kDKGreekingNone draws to the screen, it works out how tall its text will be on screen from
+ the current transform. Text shorter than this is drawn as glyph rectangles, and text shorter than half of it as line rectangles, as
+ the glyphs could not be read anyway. The laid out text is the same whichever way it is drawn, so zooming in and out doesn't lay it out
+ again. Printing and exporting always draw the glyphs. Set to 0 to turn automatic greeking off.
+ */
+@property (class) CGFloat automaticGreekingTextSize;
 
 // the text:
 
@@ -161,7 +169,8 @@ NS_ASSUME_NONNULL_BEGIN
  more quickly, or to give an impression of text. It is rarely used, but can be handy for hit-testing where the exact glyphs are not required and don't work
  well when rendered using scaling to small bitmap contexts (as when hit-testing).
  
- currently the greeking setting is considered temporary so isn't archived or exported as an observable property
+ currently the greeking setting is considered temporary so isn't archived or exported as an observable property. When it is
+ \c kDKGreekingNone, text that is too small to read on screen is still greeked - see <code>+automaticGreekingTextSize</code>.
 */
 @property DKGreeking greeking;
 
@@ -218,8 +227,25 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, strong) DKTextSubstitutor* textSubstitutor;
 
+/** @brief Whether all the text fitted when the adornment last drew <code>object</code>, so that the object can show a "more text" marker.
+
+ This is kept with the object's laid out text, so it is right whichever thread the object was drawn on. Objects that haven't been
+ drawn report \c YES.
+ */
+- (BOOL)allTextWasFittedForObject:(id<DKRenderable>)object;
+
+/** @brief Whether all the text fitted when the adornment last drew any object.
+
+ When the adornment draws several objects this only describes the last of them; <code>-allTextWasFittedForObject:</code> gives the
+ answer for a particular object.
+ */
 @property (readonly) BOOL allTextWasFitted;
 
+/** @brief Discard any text layout cached for the objects this adornment draws.
+
+ Each object keeps its own laid out text, rebuilt when its text, metadata or size changes. This is called whenever a setting of the
+ adornment itself changes the layout, and is only needed by subclasses adding settings of their own.
+ */
 - (void)invalidateCache;
 
 - (void)drawInRect:(NSRect)aRect;
@@ -245,6 +271,7 @@ NS_ASSUME_NONNULL_BEGIN
 @end
 
 #define DEFAULT_BASELINE_OFFSET_MAX 16
+#define DEFAULT_AUTOMATIC_GREEKING_SIZE 4
 
 // these keys are used to access text adornment properties in the \c -textAttributes dictionary. Using this dictionary allows these settings to
 // be more portable especially when cutting and pasting styles between objects. These are placed alongside any Cocoa attributes defined in the
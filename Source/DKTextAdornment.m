@@ -24,18 +24,22 @@
 #import "NSBezierPath+Text.h"
 #import "NSObject+StringValue.h"
 
+@class DKTextLayoutCacheEntry;
+
 @interface DKTextAdornment ()
 
-- (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path;
-- (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path layoutManager:(NSLayoutManager*)lm;
+- (BOOL)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path cache:(DKTextLayoutCacheEntry*)entry greeking:(DKGreeking)greeking;
+- (NSBezierPath*)textLayoutPathForObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path size:(NSSize*)osize;
+- (BOOL)layOutText:(NSTextStorage*)contents inSize:(NSSize)osize layoutPath:(NSBezierPath*)layoutPath layoutManager:(NSLayoutManager*)lm glyphRange:(NSRange*)grange textOrigin:(NSPoint*)textOrigin fittedAllText:(BOOL*)fitted;
+- (DKTextLayoutCacheEntry*)layoutCacheForObject:(id<DKRenderable>)obj;
+- (DKGreeking)greekingForText:(NSAttributedString*)text transform:(NSAffineTransform*)tfm;
 - (void)drawText:(NSTextStorage*)contents centredAtPoint:(NSPoint)p;
 - (NSAffineTransform*)textTransformForObject:(id<DKRenderable>)obj;
-- (void)drawKnockoutWithObject:(id<DKRenderable>)obj;
+- (void)drawKnockoutWithObject:(id<DKRenderable>)obj cache:(DKTextLayoutCacheEntry*)entry;
 - (void)changeTextAttribute:(NSString*)attribute toValue:(id)val;
 - (NSPoint)textOriginForSize:(NSSize)textSize objectSize:(NSSize)osize;
 - (CGFloat)verticalTextOffsetForTextSize:(NSSize)textSize objectSize:(NSSize)osize;
 - (void)applyNonCocoaTextAttributes:(NSDictionary*)attrs;
-- (NSLayoutManager*)layoutManager;
 - (void)masterStringChanged:(NSNotification*)note;
 
 @end
@@ -50,16 +54,173 @@ NSString* const DKTextVerticalAlignmentAttributeName = @"DKTextVerticalAlignment
 NSString* const DKTextVerticalAlignmentProportionAttributeName = @"DKTextVerticalAlignmentProportionAttributeName";
 NSString* const DKTextCapitalizationAttributeName = @"DKTextCapitalizationAttributeName";
 
-// private keys in the text adornment cache
+/** @brief Everything besides the text itself that decides how text is laid out in a box or shape. Zeroed before filling, so that equal
+ parameters are equal bytes.
+ */
+typedef struct {
+	DKTextLayoutMode layoutMode;
+	DKVerticalTextAlignment verticalAlignment;
+	CGFloat verticalPosition;
+	NSRect textRect;
+	CGFloat flowedTextPathInset;
+	BOOL wrapsLines;
+	BOOL allowsIndefiniteWidth;
+	NSSize layoutSize;
+	NSUInteger layoutPathChecksum;
+} DKTextLayoutParameters;
+
+/** @brief A run of laid out glyphs in one font, placed for drawing in a flipped context.
+ */
+@interface DKTextGlyphRun : NSObject {
+@public
+	NSFont* mFont;
+	NSMutableData* mGlyphs; // CGGlyphs
+	NSMutableData* mPositions; // a CGPoint for each glyph, with y reversed to suit the flipped text matrix the run is drawn with
+}
+@end
+
+@implementation DKTextGlyphRun
+@end
+
+/** @brief What an adornment keeps from laying out text for one object, kept in the object's rendering cache so that the text can be
+ drawn again without laying it out again. The text system itself is shared by everything drawn on a thread, so an entry holds only
+ the results: the glyphs and their positions, or the greeking blocks as paths, and whether all the text fitted.
+ */
+@interface DKTextLayoutCacheEntry : NSObject {
+@public
+	NSUInteger mGeneration; // the adornment's cache generation when this was made
+	NSUInteger mMetadataChecksum; // the object's metadata checksum when this was made
+	NSAttributedString* mText; // the text laid out in a box or shape
+	DKTextLayoutParameters mParameters;
+	BOOL mFittedAllText; // whether all the text fitted when last laid out, in a box, a shape or along a path
+	NSColor* mTextColour; // the colour of mText if its glyphs can be drawn in one colour without the text system, otherwise nil
+	NSArray<DKTextGlyphRun*>* mGlyphRuns; // the glyphs of mText, placed for drawing
+	NSBezierPath* mLineGreekingPath; // the blocks drawn for mText when greeking by line
+	NSBezierPath* mGlyphGreekingPath; // the blocks drawn for mText when greeking by glyph
+	NSAttributedString* mPathText; // the text laid out along a path
+	NSMutableDictionary* mPathLayoutCache; // cache for laying out text along a path
+	NSBezierPath* mKnockoutPath;
+	NSUInteger mKnockoutChecksum;
+	CGFloat mKnockoutDistance;
+}
+@end
+
+@implementation DKTextLayoutCacheEntry
+@end
+
+static NSColor* colourOfPlainText(NSAttributedString* text)
+{
+	// returns the one colour <text> is drawn in if its glyphs can be drawn as a single filled path, or nil if drawing it needs the text
+	// system - for several colours, outlines, underlines, backgrounds, shadows and the like.
+
+	static NSSet* s_plainAttributes = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		s_plainAttributes = [NSSet setWithObjects:NSFontAttributeName, NSParagraphStyleAttributeName, NSForegroundColorAttributeName, NSKernAttributeName,
+								   NSLigatureAttributeName, NSBaselineOffsetAttributeName, NSSuperscriptAttributeName, DKTextKnockoutColourAttributeName,
+								   DKTextKnockoutDistanceAttributeName, DKTextKnockoutStrokeColourAttributeName, DKTextKnockoutStrokeWidthAttributeName,
+								   DKTextVerticalAlignmentAttributeName, DKTextVerticalAlignmentProportionAttributeName, DKTextCapitalizationAttributeName, nil];
+	});
+
+	__block NSColor* colour = nil;
+	__block BOOL plain = YES;
+
+	[text enumerateAttributesInRange:NSMakeRange(0, [text length])
+							 options:0
+						  usingBlock:^(NSDictionary<NSAttributedStringKey, id>* attrs, NSRange range, BOOL* stop) {
+#pragma unused(range)
+							  NSColor* runColour = [attrs objectForKey:NSForegroundColorAttributeName];
+
+							  if (runColour == nil)
+								  runColour = [NSColor blackColor];
+
+							  if (colour == nil)
+								  colour = runColour;
+
+							  if (![runColour isEqual:colour])
+								  plain = NO;
+
+							  for (NSString* key in attrs) {
+								  if (![s_plainAttributes containsObject:key])
+									  plain = NO;
+							  }
+
+							  *stop = !plain;
+						  }];
+
+	return plain ? colour : nil;
+}
+
+static NSArray<DKTextGlyphRun*>* glyphRunsForGlyphRange(NSLayoutManager* lm, NSRange glyphRange, NSPoint origin)
+{
+	// gathers the laid out glyphs of <glyphRange> into runs of one font, placed as they would be drawn at <origin> in a flipped view.
+	// Like the outlines made by DKBezierLayoutManager this needs no graphics context, but the glyphs are drawn as text, so they keep
+	// their hinting on screen and stay text when printed or saved as PDF.
+
+	NSMutableArray* runs = [NSMutableArray array];
+	DKTextGlyphRun* run = nil;
+	NSUInteger g;
+
+	for (g = glyphRange.location; g < NSMaxRange(glyphRange); ++g) {
+		NSGlyph glyph = [lm glyphAtIndex:g];
+
+		if (glyph == NSNullGlyph || glyph == NSControlGlyph || [lm notShownAttributeForGlyphAtIndex:g])
+			continue;
+
+		NSRect fragRect = [lm lineFragmentRectForGlyphAtIndex:g
+											   effectiveRange:NULL];
+		NSPoint loc = [lm locationForGlyphAtIndex:g];
+		NSFont* font = [[lm textStorage] attribute:NSFontAttributeName
+										   atIndex:[lm characterIndexForGlyphAtIndex:g]
+									effectiveRange:NULL];
+
+		// text without a font is laid out in 12 point Helvetica
+
+		if (font == nil)
+			font = [NSFont fontWithName:@"Helvetica"
+								   size:12];
+
+		if (run == nil || ![font isEqual:run->mFont]) {
+			run = [[DKTextGlyphRun alloc] init];
+			run->mFont = font;
+			run->mGlyphs = [NSMutableData data];
+			run->mPositions = [NSMutableData data];
+			[runs addObject:run];
+		}
+
+		CGGlyph cgGlyph = (CGGlyph)glyph;
+		CGPoint position = CGPointMake(loc.x + fragRect.origin.x + origin.x, -(loc.y + fragRect.origin.y + origin.y));
+
+		[run->mGlyphs appendBytes:&cgGlyph
+						   length:sizeof(CGGlyph)];
+		[run->mPositions appendBytes:&position
+							  length:sizeof(CGPoint)];
+	}
+
+	return runs;
+}
+
+static void drawGlyphRuns(NSArray<DKTextGlyphRun*>* runs)
+{
+	// the text matrix turns the glyphs the right way up in the flipped context, and the positions back to where they were laid out
+
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+
+	CGContextSaveGState(context);
+	CGContextSetTextMatrix(context, CGAffineTransformMakeScale(1.0, -1.0));
+	CGContextSetTextDrawingMode(context, kCGTextFill);
 
-//static NSString* kDKTextAdornmentLastClientSeenCacheKey		= @"DKTextAdornmentLastClientSeen";
-static NSString* const kDKTextAdornmentMaskPathCacheKey = @"DKTextAdornmentMaskPath";
-static NSString* const kDKTextAdornmentMaskObjectChecksumCacheKey = @"DKTextAdornmentMaskObjectChecksum";
-static NSString* const kDKTextAdornmentMetadataChecksumCacheKey = @"DKTextAdornmentMetadataChecksum";
+	for (DKTextGlyphRun* run in runs)
+		CTFontDrawGlyphs((__bridge CTFontRef)run->mFont, [run->mGlyphs bytes], [run->mPositions bytes], [run->mGlyphs length] / sizeof(CGGlyph), context);
+
+	CGContextRestoreGState(context);
+}
 
 @implementation DKTextAdornment
 
 static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
+static CGFloat s_automaticGreekingTextSize = DEFAULT_AUTOMATIC_GREEKING_SIZE;
 
 #pragma mark As a DKTextAdornment
 
@@ -113,6 +274,16 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	s_maximumVerticalOffset = mvo;
 }
 
++ (CGFloat)automaticGreekingTextSize
+{
+	return s_automaticGreekingTextSize;
+}
+
++ (void)setAutomaticGreekingTextSize:(CGFloat)size
+{
+	s_automaticGreekingTextSize = size;
+}
+
 - (NSString*)string
 {
 	return [[self textSubstitutor] string];
@@ -205,23 +376,32 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		return [path bezierPathWithTextOnPath:str
 									  yOffset:baseOffset];
 	} else {
-		DKBezierLayoutManager* captureLM = sharedCaptureLayoutManager();
-		[[captureLM textPath] removeAllPoints];
-
-		// by drawing into a temporary flipped image context, text will be right side up with its lines in the right order
+		// the glyph outlines are taken straight from the layout, the right way up for flipped drawing, so no graphics context is needed
 
-		NSImage* tempImage = [[NSImage alloc] initWithSize:NSMakeSize(1, 1)];
-		[tempImage lockFocusFlipped:YES];
-
-		[self drawText:str
-			   withObject:object
-				 withPath:path
-			layoutManager:captureLM];
-		[tempImage unlockFocus];
+		DKBezierLayoutManager* captureLM = sharedCaptureLayoutManager();
+		NSSize osize;
+		NSBezierPath* layoutPath = [self textLayoutPathForObject:object
+														withPath:path
+															size:&osize];
+		NSBezierPath* newPath = nil;
+		NSRange grange;
+		NSPoint textOrigin;
+
+		if ([self layOutText:str
+					   inSize:osize
+				   layoutPath:layoutPath
+				layoutManager:captureLM
+				   glyphRange:&grange
+				   textOrigin:&textOrigin
+				fittedAllText:NULL])
+			newPath = [captureLM textPathForGlyphRange:grange
+											   atPoint:textOrigin];
+		else
+			newPath = [NSBezierPath bezierPath];
 
-		// get the text path and position it aligned with the object
+		[str removeLayoutManager:captureLM];
 
-		NSBezierPath* newPath = [[captureLM textPath] copy];
+		// position it aligned with the object
 
 		NSAffineTransform* tfm = [self textTransformForObject:object];
 		[newPath transformUsingAffineTransform:tfm];
@@ -258,13 +438,21 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	} else {
 		DKBezierLayoutManager* captureLM = sharedCaptureLayoutManager();
 		NSTextContainer* container = [[captureLM textContainers] lastObject];
+		NSSize osize;
+		NSBezierPath* layoutPath = [self textLayoutPathForObject:object
+														withPath:path
+															size:&osize];
+		NSRange grange;
+		NSPoint textOrigin;
 
-		[self drawText:str
-			   withObject:object
-				 withPath:path
-			layoutManager:captureLM];
+		[self layOutText:str
+					inSize:osize
+				layoutPath:layoutPath
+			 layoutManager:captureLM
+				glyphRange:&grange
+				textOrigin:&textOrigin
+			 fittedAllText:NULL];
 
-		[str addLayoutManager:captureLM];
 		NSArray* glyphs = [captureLM glyphPathsForContainer:container
 												   usedSize:aSize];
 		[str removeLayoutManager:captureLM];
@@ -398,12 +586,6 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 @synthesize wrapsLines = m_wrapLines;
 @synthesize allowsTextToExtendHorizontally = mAllowIndefiniteWidth;
 
-- (void)setTextKnockoutDistance:(CGFloat)distance
-{
-	mTextKnockoutDistance = distance;
-	[mTACache removeObjectForKey:kDKTextAdornmentMaskPathCacheKey];
-}
-
 @synthesize textKnockoutDistance = mTextKnockoutDistance;
 @synthesize textKnockoutStrokeWidth = mTextKnockoutStrokeWidth;
 @synthesize textKnockoutColour = mTextKnockoutColour;
@@ -845,13 +1027,22 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 }
 
 @synthesize textSubstitutor = mSubstitutor;
+
 @synthesize allTextWasFitted = mLastLayoutFittedAllText;
 
+- (BOOL)allTextWasFittedForObject:(id<DKRenderable>)object
+{
+	DKTextLayoutCacheEntry* entry = [self renderingCacheEntryForObject:object];
+
+	return (entry == nil) || entry->mFittedAllText;
+}
+
 - (void)invalidateCache
 {
-	// empties the cache, causing all information it contains to be recalculated as needed
+	// the layouts are held by the objects, so rather than find them all, move on to a new generation; each object's layout is
+	// rebuilt the next time it is drawn
 
-	[mTACache removeAllObjects];
+	++mCacheGeneration;
 }
 
 - (void)masterStringChanged:(NSNotification*)note
@@ -985,94 +1176,264 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	return textOrigin;
 }
 
-- (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path
-{
-	[self drawText:contents
-		   withObject:obj
-			 withPath:path
-		layoutManager:[self layoutManager]];
+- (BOOL)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path cache:(DKTextLayoutCacheEntry*)entry greeking:(DKGreeking)greeking
+{
+	// laying out the text is most of the work of drawing it. The text system is shared by everything drawn on the thread, so what the
+	// object keeps is the result - its glyphs and their positions, or its greeking blocks as a path - which is drawn again until the text
+	// or anything that decides its layout changes. Text that a single fill can't reproduce is laid out again each time it is drawn ungreeked. Returns whether all
+	// the text fitted.
+
+	if ([contents length] == 0)
+		return YES;
+
+	DKTextLayoutParameters params;
+	NSSize osize;
+	NSBezierPath* layoutPath = [self textLayoutPathForObject:obj
+													withPath:path
+														size:&osize];
+
+	memset(&params, 0, sizeof(params));
+	params.layoutMode = [self layoutMode];
+	params.verticalAlignment = [self verticalAlignment];
+	params.verticalPosition = [self verticalAlignmentProportion];
+	params.textRect = [self textRect];
+	params.flowedTextPathInset = [self flowedTextPathInset];
+	params.wrapsLines = [self wrapsLines];
+	params.allowsIndefiniteWidth = [self allowsTextToExtendHorizontally];
+	params.layoutSize = osize;
+	params.layoutPathChecksum = layoutPath ? [layoutPath checksum] : 0;
+
+	if (entry->mText == nil || memcmp(&params, &entry->mParameters, sizeof(params)) != 0 || ![contents isEqualToAttributedString:entry->mText]) {
+		entry->mText = [[NSAttributedString alloc] initWithAttributedString:contents];
+		entry->mParameters = params;
+		entry->mTextColour = colourOfPlainText(contents);
+		entry->mGlyphRuns = nil;
+		entry->mLineGreekingPath = nil;
+		entry->mGlyphGreekingPath = nil;
+	}
+
+	NSBezierPath* greekingPath = nil;
+
+	if (greeking == kDKGreekingByLineRectangle)
+		greekingPath = entry->mLineGreekingPath;
+	else if (greeking == kDKGreekingByGlyphRectangle)
+		greekingPath = entry->mGlyphGreekingPath;
+
+	if (greeking != kDKGreekingNone ? greekingPath == nil : entry->mGlyphRuns == nil) {
+		NSLayoutManager* lm;
+
+		if (greeking != kDKGreekingNone) {
+			lm = sharedGreekingLayoutManager();
+			[(DKGreekingLayoutManager*)lm setGreeking:greeking];
+		} else if (entry->mTextColour)
+			lm = sharedCaptureLayoutManager();
+		else
+			lm = sharedDrawingLayoutManager();
+
+		NSRange grange;
+		NSPoint textOrigin;
+		BOOL hasGlyphs = [self layOutText:contents
+								   inSize:osize
+							   layoutPath:layoutPath
+							layoutManager:lm
+							   glyphRange:&grange
+							   textOrigin:&textOrigin
+							fittedAllText:&entry->mFittedAllText];
+
+		if (greeking != kDKGreekingNone) {
+			greekingPath = hasGlyphs ? [(DKGreekingLayoutManager*)lm greekingPathForGlyphRange:grange
+																					   atPoint:textOrigin]
+									 : [NSBezierPath bezierPath];
+
+			if (greeking == kDKGreekingByLineRectangle)
+				entry->mLineGreekingPath = greekingPath;
+			else
+				entry->mGlyphGreekingPath = greekingPath;
+		} else if (entry->mTextColour)
+			entry->mGlyphRuns = hasGlyphs ? glyphRunsForGlyphRange(lm, grange, textOrigin) : @[];
+		else if (hasGlyphs) {
+			[lm drawBackgroundForGlyphRange:grange
+									atPoint:textOrigin];
+			[lm drawGlyphsForGlyphRange:grange
+								atPoint:textOrigin];
+		}
+
+		[contents removeLayoutManager:lm];
+	}
+
+	if (greekingPath) {
+		[[sharedGreekingLayoutManager() greekingColour] set];
+		[greekingPath fill];
+	} else if (greeking == kDKGreekingNone && [entry->mGlyphRuns count] > 0) {
+		[entry->mTextColour set];
+		drawGlyphRuns(entry->mGlyphRuns);
+	}
+
+	return entry->mFittedAllText;
 }
 
-- (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path layoutManager:(NSLayoutManager*)lm
+- (NSBezierPath*)textLayoutPathForObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path size:(NSSize*)osize
 {
-	NSAssert(lm != nil, @"there must be a valid layout manager when calling -drawText:withObject:withPath:layoutManager:");
+	// returns the path that text flowed into a shape is laid out in, or nil when it's laid out in a box, and sets <osize> to the size
+	// of the space it is laid out in.
 
-	if ([contents length] > 0) {
-		NSSize osize = obj ? [obj size] : [path bounds].size;
+	*osize = obj ? [obj size] : [path bounds].size;
 
-		DKBezierTextContainer* bc = (id)[[lm textContainers] lastObject];
+	if ([self layoutMode] == kDKTextLayoutFlowedInPath) {
+		// if the text angle is rel to the object, the layout path should be the unrotated path
+		// so the the text is laid out unrotated, then transformed into place. So detect that case here
+		// and compensate the path for the angle.
 
-		if ([self layoutMode] == kDKTextLayoutFlowedInPath) {
-			// if the text angle is rel to the object, the layout path should be the unrotated path
-			// so the the text is laid out unrotated, then transformed into place. So detect that case here
-			// and compensate the path for the angle.
+		NSAffineTransform* tfm = [self textTransformForObject:obj];
+		[tfm invert];
 
-			NSBezierPath* textLayoutPath = path;
+		NSBezierPath* textLayoutPath = [tfm transformBezierPath:path];
 
-			if ([self flowedTextPathInset] != 0.0) {
-				[bc setLineFragmentPadding:[self flowedTextPathInset]];
-			}
+		*osize = [textLayoutPath bounds].size;
+		return textLayoutPath;
+	}
 
-			NSAffineTransform* tfm = [self textTransformForObject:obj];
-			[tfm invert];
+	if ([self allowsTextToExtendHorizontally])
+		osize->width = 50000;
 
-			textLayoutPath = [tfm transformBezierPath:textLayoutPath];
+	return nil;
+}
 
-			osize = [textLayoutPath bounds].size;
-			[bc setContainerSize:osize];
-			[bc setBezierPath:textLayoutPath];
-		} else {
-			if ([self allowsTextToExtendHorizontally])
-				osize.width = 50000;
+- (BOOL)layOutText:(NSTextStorage*)contents inSize:(NSSize)osize layoutPath:(NSBezierPath*)layoutPath layoutManager:(NSLayoutManager*)lm glyphRange:(NSRange*)grange textOrigin:(NSPoint*)textOrigin fittedAllText:(BOOL*)fitted
+{
+	// lays out <contents> in <lm>'s container and works out which glyphs to draw, and where. <contents> is left attached to <lm>, so
+	// that the glyphs can be drawn; the caller must remove it when done. Returns NO if there is nothing to draw.
 
-			[bc setBezierPath:nil];
-			[bc setContainerSize:osize];
-		}
+	DKBezierTextContainer* bc = (id)[[lm textContainers] lastObject];
 
-		NSRange glyphRange;
-		NSRange grange;
-		NSRect frag;
+	if (layoutPath) {
+		if ([self flowedTextPathInset] != 0.0)
+			[bc setLineFragmentPadding:[self flowedTextPathInset]];
 
-		[contents addLayoutManager:lm];
+		[bc setContainerSize:osize];
+		[bc setBezierPath:layoutPath];
+	} else {
+		[bc setBezierPath:nil];
+		[bc setContainerSize:osize];
+	}
 
-		// Force layout of the text and find out how much of it fits in the container.
+	NSRange glyphRange;
+	NSRect frag;
 
-		glyphRange = [lm glyphRangeForTextContainer:bc];
+	[contents addLayoutManager:lm];
+
+	// Force layout of the text and find out how much of it fits in the container.
+
+	glyphRange = [lm glyphRangeForTextContainer:bc];
 
-		// flag whether all the text was laid out. This can be queried to see if a "more text" marker should be shown
-		// by the bject that is using this service.
+	// flag whether all the text was laid out. This can be queried to see if a "more text" marker should be shown
+	// by the bject that is using this service.
 
+	if (fitted) {
 		NSRange fullRange = [lm glyphRangeForCharacterRange:NSMakeRange(0, [contents length])
 									   actualCharacterRange:NULL];
-		mLastLayoutFittedAllText = NSEqualRanges(fullRange, glyphRange);
+		*fitted = NSEqualRanges(fullRange, glyphRange);
+	}
 
-		// because of the object transform applied, draw the text at the origin
+	if (glyphRange.length == 0)
+		return NO;
 
-		if (glyphRange.length > 0) {
-			NSSize textSize = [lm usedRectForTextContainer:bc].size;
+	NSSize textSize = [lm usedRectForTextContainer:bc].size;
 
-			// if not wrapping lines, draw only the first line
+	// if not wrapping lines, draw only the first line
 
-			if (![self wrapsLines]) {
-				frag = [lm lineFragmentUsedRectForGlyphAtIndex:0
-												effectiveRange:&grange];
-				textSize.height = frag.size.height;
-			} else
-				grange = glyphRange;
+	if (![self wrapsLines]) {
+		frag = [lm lineFragmentUsedRectForGlyphAtIndex:0
+										effectiveRange:grange];
+		textSize.height = frag.size.height;
+	} else
+		*grange = glyphRange;
 
-			NSPoint textOrigin = [self textOriginForSize:textSize
-											  objectSize:osize];
+	*textOrigin = [self textOriginForSize:textSize
+							   objectSize:osize];
 
-			if ([self layoutMode] == kDKTextLayoutFlowedInPath && [self flowedTextPathInset] != 0.0)
-				textOrigin.y += [self flowedTextPathInset] * 0.5;
+	if ([self layoutMode] == kDKTextLayoutFlowedInPath && [self flowedTextPathInset] != 0.0)
+		textOrigin->y += [self flowedTextPathInset] * 0.5;
 
-			[lm drawBackgroundForGlyphRange:grange
-									atPoint:textOrigin];
-			[lm drawGlyphsForGlyphRange:grange
-								atPoint:textOrigin];
-		}
-		[contents removeLayoutManager:lm];
+	return YES;
+}
+
+- (DKTextLayoutCacheEntry*)layoutCacheForObject:(id<DKRenderable>)obj
+{
+	// each object keeps its own entry, keyed by the adornment, so objects sharing a style don't keep replacing one another's layout,
+	// and several objects can be drawn on different threads at once. An object without a rendering cache gets a new entry each time.
+
+	DKTextLayoutCacheEntry* entry = [self renderingCacheEntryForObject:obj];
+	NSUInteger metadataChecksum = [obj respondsToSelector:@selector(metadataChecksum)] ? [(id)obj metadataChecksum] : 0;
+
+	// anything cached before the adornment changed, or before the object's metadata changed, may be for different text
+
+	if (entry == nil || entry->mGeneration != mCacheGeneration || entry->mMetadataChecksum != metadataChecksum) {
+		entry = [[DKTextLayoutCacheEntry alloc] init];
+		entry->mGeneration = mCacheGeneration;
+		entry->mMetadataChecksum = metadataChecksum;
+		entry->mPathLayoutCache = [[NSMutableDictionary alloc] init];
+
+		[self setRenderingCacheEntry:entry
+						   forObject:obj];
 	}
+
+	return entry;
+}
+
+- (DKGreeking)greekingForText:(NSAttributedString*)text transform:(NSAffineTransform*)tfm
+{
+	// returns the greeking to draw <text> with, once <tfm> is applied to the current context. Text is greeked automatically when drawing
+	// to the screen if it would be too small to read there. A display list is recorded as drawing to the screen at the device scale it
+	// will be replayed at, and is only replayed at that scale, so greeking recorded into it is what drawing directly would have done.
+
+	if ([self greeking] != kDKGreekingNone)
+		return [self greeking];
+
+	NSGraphicsContext* gc = [NSGraphicsContext currentContext];
+	CGFloat threshold = [[self class] automaticGreekingTextSize];
+
+	if (threshold <= 0.0 || [text length] == 0 || ![gc isDrawingToScreen])
+		return kDKGreekingNone;
+
+	CGAffineTransform ctm = CGContextGetUserSpaceToDeviceSpaceTransform([gc graphicsPort]);
+
+	if (tfm) {
+		NSAffineTransformStruct ts = [tfm transformStruct];
+		ctm = CGAffineTransformConcat(CGAffineTransformMake(ts.m11, ts.m12, ts.m21, ts.m22, ts.tX, ts.tY), ctm);
+	}
+
+	// the size that decides is the one most of the text is set in, so a run of small print doesn't greek a whole paragraph, nor a large
+	// initial keep a paragraph of small print readable
+
+	NSMutableDictionary<NSNumber*, NSNumber*>* lengthsBySize = [NSMutableDictionary dictionary];
+	__block CGFloat pointSize = 0;
+	__block NSUInteger longest = 0;
+
+	[text enumerateAttribute:NSFontAttributeName
+					 inRange:NSMakeRange(0, [text length])
+					 options:0
+				  usingBlock:^(id font, NSRange range, BOOL* stop) {
+#pragma unused(stop)
+					  CGFloat size = font ? [font pointSize] : 12.0;
+					  NSUInteger length = [lengthsBySize[@(size)] unsignedIntegerValue] + range.length;
+
+					  lengthsBySize[@(size)] = @(length);
+
+					  if (length > longest) {
+						  longest = length;
+						  pointSize = size;
+					  }
+				  }];
+
+	CGFloat deviceSize = pointSize * hypot(ctm.c, ctm.d);
+
+	if (deviceSize < threshold * 0.5)
+		return kDKGreekingByLineRectangle;
+	else if (deviceSize < threshold)
+		return kDKGreekingByGlyphRectangle;
+	else
+		return kDKGreekingNone;
 }
 
 - (CGFloat)baselineOffset
@@ -1230,7 +1591,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 #endif
 }
 
-- (void)drawKnockoutWithObject:(id<DKRenderable>)obj
+- (void)drawKnockoutWithObject:(id<DKRenderable>)obj cache:(DKTextLayoutCacheEntry*)entry
 {
 	BOOL ghost = NO;
 
@@ -1238,24 +1599,18 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		ghost = [(id)obj isGhosted];
 
 	if ([self textKnockoutDistance] > 0.0 && !ghost) {
-		// see if the object size has changed since last time - if so, the cached info can't be reliable. Note that
-		// the general case of a text change will have invalidated the entire cache. This checks for a layout change
-		// that is only in consideration of the text mask effect.
+		// see if the object size or knockout distance has changed since last time - if so, the cached mask can't be reliable. Note
+		// that a change of text will have replaced the entry altogether. This checks for a layout change that is only in consideration
+		// of the text mask effect.
 
-		NSUInteger cs = [[mTACache objectForKey:kDKTextAdornmentMaskObjectChecksumCacheKey] integerValue];
-		NSUInteger geoCheck = [(id)obj geometryChecksum] ^ [(id)obj metadataChecksum];
-
-		if (geoCheck != cs) {
-			[mTACache removeObjectForKey:kDKTextAdornmentMaskPathCacheKey];
-			[mTACache setObject:@(geoCheck)
-						 forKey:kDKTextAdornmentMaskObjectChecksumCacheKey];
-		}
+		NSUInteger geoCheck = [(id)obj geometryChecksum] ^ entry->mMetadataChecksum;
 
-		NSBezierPath* textPath;
+		if (geoCheck != entry->mKnockoutChecksum || [self textKnockoutDistance] != entry->mKnockoutDistance)
+			entry->mKnockoutPath = nil;
 
 		// see if an earlier path was cached:
 
-		textPath = [mTACache objectForKey:kDKTextAdornmentMaskPathCacheKey];
+		NSBezierPath* textPath = entry->mKnockoutPath;
 
 		if (textPath == nil) {
 			// not in cache, so calculate it
@@ -1273,8 +1628,9 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 			textPath = [textPath strokedPathWithStrokeWidth:dist];
 			[textPath setWindingRule:NSNonZeroWindingRule];
 
-			[mTACache setObject:textPath
-						 forKey:kDKTextAdornmentMaskPathCacheKey];
+			entry->mKnockoutPath = textPath;
+			entry->mKnockoutChecksum = geoCheck;
+			entry->mKnockoutDistance = [self textKnockoutDistance];
 		}
 
 		if ([self textKnockoutColour]) {
@@ -1298,27 +1654,6 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	[self render:shape];
 }
 
-- (NSLayoutManager*)layoutManager
-{
-	if ([self greeking] == kDKGreekingNone)
-		return sharedDrawingLayoutManager();
-	else {
-		// greeking is implemented using a greeking layout manager
-
-		DKGreekingLayoutManager* glm = [[DKGreekingLayoutManager alloc] init];
-		[glm setGreeking:[self greeking]];
-
-		DKBezierTextContainer* tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
-		[tc setWidthTracksTextView:NO];
-		[tc setHeightTracksTextView:NO];
-		[glm addTextContainer:tc];
-
-		[glm setUsesScreenFonts:NO];
-
-		return glm;
-	}
-}
-
 #pragma mark -
 #pragma mark As a DKRasterizer
 
@@ -1373,17 +1708,11 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	if (![object conformsToProtocol:@protocol(DKRenderable)])
 		return;
 
-	// check the cache for the last client of this renderer. If it's not the same one, any cached information can't be reliable
-	// so the cache must be invalidated. For TAs associated with text objects, the client object will invariably be the same one.
+	// the object's own cache entry holds its laid out text. It is replaced if the object's metadata has changed since it was made,
+	// as the text may then be different.
 
 	@try {
-		NSUInteger cs, ccs = [[mTACache objectForKey:kDKTextAdornmentMetadataChecksumCacheKey] integerValue];
-		cs = [(id)object metadataChecksum];
-		if (cs != ccs) {
-			[self invalidateCache];
-			[mTACache setObject:@(ccs)
-						 forKey:kDKTextAdornmentMetadataChecksumCacheKey];
-		}
+		DKTextLayoutCacheEntry* entry = [self layoutCacheForObject:object];
 
 		NSTextStorage* str = [self textToDraw:object];
 
@@ -1413,10 +1742,14 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 
 			if ([self layoutMode] == kDKTextLayoutAlongReversedPath ||
 				[self layoutMode] == kDKTextLayoutAlongPath) {
+				DKGreeking greeking = [self greekingForText:str
+												  transform:nil];
+
 				// draw any knockout behind the text - warning: potentially expensive.
 
-				if ([self greeking] == kDKGreekingNone)
-					[self drawKnockoutWithObject:object];
+				if (greeking == kDKGreekingNone)
+					[self drawKnockoutWithObject:object
+										   cache:entry];
 
 				// measure the text height for the centring option based on the font of the first character
 
@@ -1430,34 +1763,51 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 				} else
 					baseOffset = [self baselineOffset];
 
-				NSLayoutManager* lm = nil;
+				DKGreekingLayoutManager* lm = nil;
+
+				if (greeking != kDKGreekingNone) {
+					lm = sharedGreekingLayoutManager();
+					[lm setGreeking:greeking];
+				}
+
+				// the path layout cache notices path changes by itself, but must be emptied when the text changes
 
-				if ([self greeking] != kDKGreekingNone)
-					lm = [self layoutManager];
+				if (![str isEqualToAttributedString:entry->mPathText]) {
+					[entry->mPathLayoutCache removeAllObjects];
+					entry->mPathText = [[NSAttributedString alloc] initWithAttributedString:str];
+				}
 
 				// passing nil as lm causes text on path to be laid out using its own shared lm for the purpose
 
-				mLastLayoutFittedAllText = [path drawTextOnPath:str
-														yOffset:baseOffset
-												  layoutManager:lm
-														  cache:mTACache];
+				entry->mFittedAllText = [path drawTextOnPath:str
+													 yOffset:baseOffset
+											   layoutManager:lm
+													   cache:entry->mPathLayoutCache];
+				mLastLayoutFittedAllText = entry->mFittedAllText;
 			} else {
 				if ([self clipping] != kDKClippingNone)
 					[path addClip];
 
+				NSAffineTransform* tfm = [self textTransformForObject:object];
+				DKGreeking greeking = [self greekingForText:str
+												  transform:tfm];
+
 				// draw any knockout behind the text - warning: potentially expensive.
 
-				if ([self greeking] == kDKGreekingNone)
-					[self drawKnockoutWithObject:object];
+				if (greeking == kDKGreekingNone)
+					[self drawKnockoutWithObject:object
+										   cache:entry];
 
-				NSAffineTransform* tfm = [self textTransformForObject:object];
 				[tfm concat];
 
-				// draw the text
+				// draw the text. Whether it all fitted is kept in the object's entry, not the adornment, as several objects may be
+				// drawn at once
 
-				[self drawText:str
-					withObject:object
-					  withPath:path];
+				mLastLayoutFittedAllText = [self drawText:str
+											   withObject:object
+												 withPath:path
+													cache:entry
+												 greeking:greeking];
 			}
 			RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 		}
@@ -1540,8 +1890,6 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		m_applyObjectAngle = YES;
 		[self setFlowedTextPathInset:3];
 
-		mTACache = [[NSMutableDictionary alloc] init];
-
 		mSubstitutor = [[DKTextSubstitutor alloc] init];
 
 		[self setLabel:[[self class] defaultLabel]];
@@ -1605,8 +1953,6 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	NSAssert(coder != nil, @"Expected valid coder");
 	self = [super initWithCoder:coder];
 	if (self != nil) {
-		mTACache = [[NSMutableDictionary alloc] init];
-
 		// identifiers are deprecated in favour of substitution - to migrate older objects, we append the identifier
 		// to the end of the master string using appropriate delimiters. This gives identical results to the earlier
 		// approach which simply appended the identifier to the label.
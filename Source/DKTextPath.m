@@ -791,7 +791,7 @@ static NSString* sDefault_string = @"Double-click to edit this text";
 
 - (void)drawSelectedState
 {
-	if (![[self textAdornment] allTextWasFitted] && [DKTextShape showsTextOverflowIndicator]) {
+	if (![[self textAdornment] allTextWasFittedForObject:self] && [DKTextShape showsTextOverflowIndicator]) {
 		// if text is overflowing, show the "more text" symbol. This is placed just above the path's right-hand end
 
 		DKKnob* knob = [[self layer] knobs];
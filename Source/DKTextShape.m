@@ -1195,6 +1195,13 @@ static NSString* sDefault_string = @"Double-click to edit this text";
 	return br;
 }
 
+/** @brief Text being edited is drawn by the editor, so the shape isn't recorded while editing is in progress
+ */
+- (BOOL)canRecordDisplayList
+{
+	return m_editorRef == nil && [super canRecordDisplayList];
+}
+
 - (NSSize)extraSpaceNeeded
 {
 	NSSize extra = [super extraSpaceNeeded];
@@ -1245,7 +1252,7 @@ static NSString* sDefault_string = @"Double-click to edit this text";
 {
 	// draw a "more text" indicator if the current text can't be fully laid out in the box
 
-	if (![[self textAdornment] allTextWasFitted] && [[self class] showsTextOverflowIndicator]) {
+	if (![[self textAdornment] allTextWasFittedForObject:self] && [[self class] showsTextOverflowIndicator]) {
 		DKKnob* knob = [[self layer] knobs];
 		NSSize knobSize = [knob controlKnobSize];
 
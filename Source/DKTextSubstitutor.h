@@ -23,6 +23,10 @@ NS_ASSUME_NONNULL_BEGIN
 	NSAttributedString* mMasterString;
 	NSMutableArray* mKeys;
 	BOOL mNeedsToEvaluate;
+	NSArray<NSAttributedString*>* mLiterals; // the text before, between and after the keys, compiled from the master string
+	NSArray<NSDictionary*>* mSlotAttributes; // the attributes taken on by the value substituted for each key
+	NSUInteger mCompiledGeneration; // the substitution settings the template was compiled with
+	NSCache* mResults; // substituted strings, keyed by the metadata values they were made from
 }
 
 @property (class, copy, nullable) NSString* delimiterString;
@@ -49,7 +53,19 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)processMasterString;
 - (NSArray<NSString*>*)allKeys;
 
+/** @brief Return the master string with the values of \c anObject's metadata in place of the keys.
+
+ The master string is compiled once into the literal text between the keys and a slot for each key, so each result is assembled in
+ a single pass. Results are cached against the metadata values they were made from, so an object whose metadata hasn't changed
+ since it was last substituted, or that has the same values as another object, gets the earlier result back without any work.
+ */
 - (nullable NSAttributedString*)substitutedStringWithObject:(id)anObject;
+/** @brief Substitute the master string for each of <code>objects</code>.
+
+ Equivalent to calling -substitutedStringWithObject: for each object, but the template is checked once for the whole batch.
+ @return an array of substituted strings, in the same order as <code>objects</code>
+ */
+- (NSArray<NSAttributedString*>*)substitutedStringsWithObjects:(NSArray*)objects;
 - (nullable NSString*)metadataStringFromObject:(id)object;
 
 @end
@@ -12,6 +12,37 @@
 NSString* const kDKTextSubstitutorNewStringNotification = @"kDKTextSubstitutorNewStringNotification";
 
 #define TS_LAZY_EVALUATION 1
+#define kDKTextSubstitutorResultCacheLimit 4096
+
+// bumped whenever a class-wide setting that affects substitution changes, so that every substitutor knows to recompile
+
+static NSUInteger sSubstitutionGeneration = 1;
+
+static NSString* resultCacheKey(NSArray<NSString*>* values)
+{
+	// each value is prefixed with its length, so no two different lists of values can give the same key
+
+	NSMutableString* key = [NSMutableString string];
+
+	for (NSString* value in values) {
+		[key appendFormat:@"%lu:", (unsigned long)[value length]];
+		[key appendString:value];
+	}
+
+	return key;
+}
+
+@interface DKTextSubstitutor ()
+
+- (void)compileTemplateIfNeeded;
+- (void)invalidateTemplate;
+- (NSArray<NSString*>*)metadataStringsFromObject:(id)anObject;
+- (NSAttributedString*)substitutedStringWithValues:(NSArray<NSString*>*)values;
+- (NSAttributedString*)substitutedStringWithCompiledTemplateForObject:(id)anObject;
+
+@end
+
+#pragma mark -
 
 @implementation DKTextSubstitutor
 
@@ -25,6 +56,7 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 + (void)setDelimiterString:(NSString*)delim
 {
 	sDelimiter = [delim copy];
+	++sSubstitutionGeneration;
 }
 
 + (NSCharacterSet*)keyBreakingCharacterSet
@@ -56,6 +88,9 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 
 	if (self = [super init]) {
 		mKeys = [[NSMutableArray alloc] init];
+		mResults = [[NSCache alloc] init];
+		[mResults setCountLimit:kDKTextSubstitutorResultCacheLimit];
+		mCompiledGeneration = sSubstitutionGeneration;
 		[self setMasterString:aString];
 	}
 
@@ -68,6 +103,7 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 		NSString* oldString = [self string];
 
 		mMasterString = master;
+		[self invalidateTemplate];
 
 		// for lazy evaluation, do not process the string immediately. Instead this will be done when the substitutor is asked to
 		// perform its first substitution. This is only flagged if the actual string content has changed.
@@ -217,6 +253,7 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 	}
 
 	mNeedsToEvaluate = NO;
+	[self invalidateTemplate];
 
 	LogEvent_(kReactiveEvent, @"completed processing of string '%@', result = %@", mMasterString, mKeys);
 }
@@ -228,8 +265,53 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 
 - (NSAttributedString*)substitutedStringWithObject:(id)anObject
 {
-// given an object that implements -metadataObjectForKey, this returns a string which is formed by substituting the metadata values in place of
-// the embedded keys in the master string.
+	// given an object that implements -metadataObjectForKey, this returns a string which is formed by substituting the metadata values in place of
+	// the embedded keys in the master string.
+
+	[self compileTemplateIfNeeded];
+
+	// even after lazy evaluation there may be no substitutions to do - in which case just return the original string
+
+	if ([mKeys count] == 0)
+		return [self masterString];
+
+	return [self substitutedStringWithCompiledTemplateForObject:anObject];
+}
+
+- (NSArray<NSAttributedString*>*)substitutedStringsWithObjects:(NSArray*)objects
+{
+	[self compileTemplateIfNeeded];
+
+	NSMutableArray* results = [NSMutableArray arrayWithCapacity:[objects count]];
+
+	if ([mKeys count] == 0) {
+		NSAttributedString* master = [self masterString];
+
+		if (master == nil)
+			master = [[NSAttributedString alloc] init];
+
+		for (NSUInteger i = 0; i < [objects count]; ++i)
+			[results addObject:master];
+	} else {
+		for (id object in objects)
+			[results addObject:[self substitutedStringWithCompiledTemplateForObject:object]];
+	}
+
+	return results;
+}
+
+- (void)compileTemplateIfNeeded
+{
+	// the delimiter or the abbreviations may have changed since the keys were found, in which case start again
+
+	if (mCompiledGeneration != sSubstitutionGeneration) {
+		mCompiledGeneration = sSubstitutionGeneration;
+		[mKeys removeAllObjects];
+		[self invalidateTemplate];
+
+		if ([self masterString] != nil)
+			[self processMasterString];
+	}
 
 // For lazy evaluation, perform the evaluation now if no keys are currently stored.
 
@@ -238,41 +320,104 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 		[self processMasterString];
 #endif
 
-	// even after lazy evaluation there may be no substitutions to do - in which case just return the original string
+	if (mLiterals != nil || [mKeys count] == 0)
+		return;
 
-	if ([mKeys count] == 0)
-		return [self masterString];
+	// split the master string into the literal text around each key, and note the attributes that a key's value will take on, which
+	// are those of the key's first character, as they would be if the key were replaced in place
+
+	NSAttributedString* master = [self masterString];
+	NSUInteger length = [master length];
+	NSUInteger location = 0;
+	NSMutableArray* literals = [NSMutableArray arrayWithCapacity:[mKeys count] + 1];
+	NSMutableArray* slotAttributes = [NSMutableArray arrayWithCapacity:[mKeys count]];
 
-	// apply keys:
+	for (DKTextSubstitutionKey* key in mKeys) {
+		NSRange range = [key range];
 
-	NSMutableAttributedString* newString = [[self masterString] mutableCopy];
+		[literals addObject:[master attributedSubstringFromRange:NSMakeRange(location, range.location - location)]];
+		[slotAttributes addObject:[master attributesAtIndex:range.location
+											 effectiveRange:NULL]];
+
+		location = MIN(NSMaxRange(range), length);
+	}
+
+	[literals addObject:[master attributedSubstringFromRange:NSMakeRange(location, length - location)]];
+
+	mLiterals = [literals copy];
+	mSlotAttributes = [slotAttributes copy];
+}
+
+- (void)invalidateTemplate
+{
+	mLiterals = nil;
+	mSlotAttributes = nil;
+	[mResults removeAllObjects];
+}
 
-	NSInteger rangeAdjustment = 0;
+- (NSArray<NSString*>*)metadataStringsFromObject:(id)anObject
+{
+	NSMutableArray* values = [NSMutableArray arrayWithCapacity:[mKeys count]];
+	BOOL hasMetadata = [anObject respondsToSelector:@selector(metadataObjectForKey:)];
 
 	for (DKTextSubstitutionKey* key in mKeys) {
-		NSString* subString = @"";
+		NSString* value = nil;
 
-		if ([anObject respondsToSelector:@selector(metadataObjectForKey:)]) {
+		if (hasMetadata) {
 			id metaObject = [anObject metadataObjectForKey:[key key]];
 
 			if (metaObject)
-				subString = [key stringByApplyingSubkeysToString:[self metadataStringFromObject:metaObject]];
+				value = [self metadataStringFromObject:metaObject];
 		}
 
-		NSRange range = [key range];
+		[values addObject:value ? value : @""];
+	}
+
+	return values;
+}
+
+- (NSAttributedString*)substitutedStringWithValues:(NSArray<NSString*>*)values
+{
+	// assemble the result in one pass, alternating the literal text with each key's value
+
+	NSMutableAttributedString* newString = [[NSMutableAttributedString alloc] init];
+	NSUInteger i, count = [mKeys count];
+
+	[newString beginEditing];
 
-		// compensate for string length changes:
+	for (i = 0; i < count; ++i) {
+		[newString appendAttributedString:[mLiterals objectAtIndex:i]];
 
-		range.location += rangeAdjustment;
-		[newString replaceCharactersInRange:range
-								 withString:subString];
+		NSString* subString = [[mKeys objectAtIndex:i] stringByApplyingSubkeysToString:[values objectAtIndex:i]];
+
+		if ([subString length] > 0) {
+			NSAttributedString* value = [[NSAttributedString alloc] initWithString:subString
+																		attributes:[mSlotAttributes objectAtIndex:i]];
+			[newString appendAttributedString:value];
+		}
+	}
+
+	[newString appendAttributedString:[mLiterals lastObject]];
+	[newString endEditing];
+
+	return [newString copy];
+}
+
+- (NSAttributedString*)substitutedStringWithCompiledTemplateForObject:(id)anObject
+{
+	// the result depends only on the metadata values, so if these have been seen before, so has the result
 
-		// work out the range adjustment needed for the next one
+	NSArray* values = [self metadataStringsFromObject:anObject];
+	NSString* cacheKey = resultCacheKey(values);
+	NSAttributedString* result = [mResults objectForKey:cacheKey];
 
-		rangeAdjustment += [subString length] - range.length;
+	if (result == nil) {
+		result = [self substitutedStringWithValues:values];
+		[mResults setObject:result
+					 forKey:cacheKey];
 	}
 
-	return newString;
+	return result;
 }
 
 - (NSString*)metadataStringFromObject:(id)object
@@ -302,6 +447,9 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 	self = [super init];
 	if (self) {
 		mKeys = [[NSMutableArray alloc] init];
+		mResults = [[NSCache alloc] init];
+		[mResults setCountLimit:kDKTextSubstitutorResultCacheLimit];
+		mCompiledGeneration = sSubstitutionGeneration;
 	}
 
 	return self;
@@ -311,6 +459,9 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 {
 	if (self = [super init]) {
 		mKeys = [[NSMutableArray alloc] init];
+		mResults = [[NSCache alloc] init];
+		[mResults setCountLimit:kDKTextSubstitutorResultCacheLimit];
+		mCompiledGeneration = sSubstitutionGeneration;
 
 		// deal with earlier format
 
@@ -364,6 +515,7 @@ static NSDictionary* s_abbreviationDict = nil;
 + (void)setAbbreviationDictionary:(NSDictionary*)abbreviations
 {
 	s_abbreviationDict = [abbreviations copy];
+	++sSubstitutionGeneration;
 }
 
 - (instancetype)initWithKey:(NSString*)key range:(NSRange)aRange
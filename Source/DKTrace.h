@@ -0,0 +1,135 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Set \c DK_TRACING to 0 to compile tracing out altogether. When it is 1, the default, a trace point that is turned off costs
+ one load and one test.
+ */
+#ifndef DK_TRACING
+#define DK_TRACING 1
+#endif
+
+/** @brief The kinds of work that can be traced, each of which is turned on and off separately.
+ */
+typedef NS_OPTIONS(uint32_t, DKTraceCategory) {
+	kDKTraceStorage = 1 << 0, //!< object storage queries
+	kDKTraceRendering = 1 << 1, //!< styles rendering objects
+	kDKTraceHitTesting = 1 << 2, //!< finding the object under a point
+	kDKTraceArchiving = 1 << 3, //!< saving and loading drawings
+	kDKTraceUndo = 1 << 4, //!< undo grouping, registration, undo and redo
+	kDKTraceLayers = 1 << 5, //!< objects added to and removed from layers, and drawing changes layers respond to
+	kDKTraceAllCategories = 0xFFFFFFFF
+};
+
+/** @brief The categories being traced. Read it through <code>DKTraceIsEnabled()</code>, and change it with
+ <code>DKTraceSetEnabledCategories()</code>.
+ */
+extern uint32_t DKTraceEnabledMask;
+
+/** @brief Return whether any of \c category is being traced.
+ */
+NS_INLINE BOOL DKTraceIsEnabled(DKTraceCategory category)
+{
+#if DK_TRACING
+	return (DKTraceEnabledMask & category) != 0;
+#else
+	return NO;
+#endif
+}
+
+/** @brief Turn tracing on for <code>categories</code>, and off for all others.
+
+ Tracing is off unless the environment variable \c DK_TRACE is set when the framework loads, to a category mask (e.g. 0x3) or "all".
+ */
+extern void DKTraceSetEnabledCategories(DKTraceCategory categories);
+
+/** @brief Return the current time in the units the trace records, which are converted to nanoseconds when it is written.
+ */
+extern uint64_t DKTraceTimestamp(void);
+
+/** @brief Add an event to the calling thread's trace buffer.
+
+ Events are fixed size records written to a ring buffer belonging to the thread, so recording one takes no lock and allocates nothing;
+ once a thread's buffer is full its oldest events are overwritten. Use the macros below rather than calling this directly.
+ @param category the category of the event, which should be a single bit
+ @param name a description of the event, which must be a string constant, as only the pointer is kept
+ @param start when the event happened, or began, from <code>DKTraceTimestamp()</code>
+ @param duration how long it lasted, in the same units, or 0
+ @param argument a number recorded with the event, such as a count of objects
+ @param phase 'X' for a span that lasted \c duration, 'i' for an instant
+ */
+extern void DKTraceRecord(DKTraceCategory category, const char* name, uint64_t start, uint64_t duration, uint64_t argument, char phase);
+
+/** @brief A span of time being traced, made by <code>DKTraceScope()</code>.
+ */
+typedef struct {
+	const char* name;
+	uint64_t start; // 0 if the span isn't being traced
+	uint64_t argument; // may be set while the span is open
+	DKTraceCategory category;
+} DKTraceSpan;
+
+NS_INLINE DKTraceSpan DKTraceSpanBegin(DKTraceCategory category, const char* name)
+{
+	DKTraceSpan span = { name, DKTraceIsEnabled(category) ? DKTraceTimestamp() : 0, 0, category };
+
+	return span;
+}
+
+NS_INLINE void DKTraceSpanEnd(DKTraceSpan* span)
+{
+	if (span->start != 0)
+		DKTraceRecord(span->category, span->name, span->start, DKTraceTimestamp() - span->start, span->argument, 'X');
+}
+
+/** @brief Trace the time from here to the end of the enclosing block as one event.
+
+ Declares a DKTraceSpan called <code>var</code>, whose \c argument can be set before the block ends. For example:
+
+ <code>DKTraceScope(span, kDKTraceStorage, "objects in rect");</code>
+ ...
+ <code>span.argument = [result count];</code>
+ */
+#define DKTraceScope(var, category, name) \
+	__attribute__((cleanup(DKTraceSpanEnd), unused)) DKTraceSpan var = DKTraceSpanBegin((category), (name))
+
+/** @brief Trace a single moment, with a number to go with it.
+ */
+#define DKTraceInstant(category, name, arg)                                                       \
+	do {                                                                                           \
+		if (DKTraceIsEnabled(category))                                                            \
+			DKTraceRecord((category), (name), DKTraceTimestamp(), 0, (uint64_t)(arg), 'i');       \
+	} while (0)
+
+/** @brief The number of events each thread's buffer holds, for buffers made from now on. The default is 16384.
+ */
+extern void DKTraceSetBufferCapacity(NSUInteger eventsPerThread);
+
+/** @brief Discard every event recorded so far.
+ */
+extern void DKTraceReset(void);
+
+/** @brief Return everything in the trace buffers, in the binary format below.
+
+ Events being recorded while this runs may be missed or, in a buffer that has filled, partly overwritten; turn tracing off first for
+ an exact capture.
+
+ The format is little-endian. A 16 byte header - the characters "DKTR", then the format version (1), the number of names and the
+ number of threads as 32-bit integers - is followed by the names, each a 32-bit length and that many bytes of UTF-8. Then comes each
+ thread: its 64-bit id, a 32-bit event count, 64 bytes of NUL-padded name, and the events. Each event is 32 bytes: start and duration
+ in nanoseconds and the argument, all 64-bit, the 32-bit index of its name, the phase character, the index of its category's bit, and
+ two bytes of padding. \c Tools/dktrace2json converts this to the Trace Event JSON read by Perfetto and chrome://tracing.
+ */
+extern NSData* DKTraceData(void);
+
+/** @brief Write <code>DKTraceData()</code> to a file.
+ */
+extern BOOL DKTraceWriteToURL(NSURL* url, NSError* _Nullable __autoreleasing* _Nullable error);
+
+NS_ASSUME_NONNULL_END
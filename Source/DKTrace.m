@@ -0,0 +1,346 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKTrace.h"
+#include <pthread.h>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#define DK_TRACE_FORMAT_VERSION 1
+#define DK_TRACE_THREAD_NAME_LENGTH 64
+#define DEFAULT_BUFFER_CAPACITY 16384
+
+typedef struct {
+	uint64_t start;
+	uint64_t duration;
+	uint64_t argument;
+	const char* name;
+	uint32_t category;
+	char phase;
+} DKTraceEvent;
+
+typedef struct DKTraceRing {
+	struct DKTraceRing* next;
+	uint64_t threadID;
+	char threadName[DK_TRACE_THREAD_NAME_LENGTH];
+	uint64_t head; // the number of events written since the ring's epoch began, so the next goes at head % capacity
+	uint64_t epoch; // the reset the events follow; a ring from an earlier one is emptied by its thread before it next records
+	NSUInteger capacity;
+	BOOL exited; // the thread has finished, and this holds only the events it left, until the next reset
+	DKTraceEvent events[];
+} DKTraceRing;
+
+uint32_t DKTraceEnabledMask = 0;
+
+static NSUInteger sBufferCapacity = DEFAULT_BUFFER_CAPACITY;
+static uint64_t sResetEpoch = 0; // the number of resets, changed only on the queue
+static __thread DKTraceRing* sThreadRing = NULL;
+static DKTraceRing* sRings = NULL; // every ring, guarded by the queue
+static dispatch_queue_t sRingQueue;
+static pthread_key_t sRingKey;
+
+static void threadDidExit(void* value);
+
+static dispatch_queue_t ringQueue(void)
+{
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sRingQueue = dispatch_queue_create("net.apptree.drawkit.trace", DISPATCH_QUEUE_SERIAL);
+		pthread_key_create(&sRingKey, threadDidExit);
+	});
+
+	return sRingQueue;
+}
+
+static void threadDidExit(void* value)
+{
+	// the thread's ring is freed as it exits. Whatever it recorded since the last reset is kept in a block just big enough for it,
+	// so that the events of a thread that has finished can still be read.
+
+	DKTraceRing* ring = value;
+
+	sThreadRing = NULL;
+
+	dispatch_sync(ringQueue(), ^{
+		uint64_t head = (ring->epoch == sResetEpoch) ? ring->head : 0;
+		NSUInteger count = (NSUInteger)MIN(head, (uint64_t)ring->capacity);
+		DKTraceRing* remains = (count > 0) ? malloc(sizeof(DKTraceRing) + count * sizeof(DKTraceEvent)) : NULL;
+
+		if (remains) {
+			memcpy(remains, ring, sizeof(DKTraceRing));
+			remains->head = count;
+			remains->capacity = count;
+			remains->exited = YES;
+
+			for (NSUInteger i = 0; i < count; ++i)
+				remains->events[i] = ring->events[(head - count + i) % ring->capacity];
+		}
+
+		DKTraceRing** link = &sRings;
+
+		while (*link != ring)
+			link = &(*link)->next;
+
+		if (remains) {
+			remains->next = ring->next;
+			*link = remains;
+		} else
+			*link = ring->next;
+
+		free(ring);
+	});
+}
+
+__attribute__((constructor)) static void enableTracingFromEnvironment(void)
+{
+	// read once at load rather than on every trace point
+
+	const char* value = getenv("DK_TRACE");
+
+	if (value == NULL)
+		return;
+
+	if (strcmp(value, "all") == 0)
+		DKTraceEnabledMask = kDKTraceAllCategories;
+	else
+		DKTraceEnabledMask = (uint32_t)strtoul(value, NULL, 0);
+}
+
+void DKTraceSetEnabledCategories(DKTraceCategory categories)
+{
+	__atomic_store_n(&DKTraceEnabledMask, categories, __ATOMIC_RELAXED);
+}
+
+uint64_t DKTraceTimestamp(void)
+{
+#ifdef __APPLE__
+	return mach_absolute_time();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint64_t nanosecondsFromTimestamp(uint64_t t)
+{
+#ifdef __APPLE__
+	static mach_timebase_info_data_t sTimebase;
+
+	if (sTimebase.denom == 0)
+		mach_timebase_info(&sTimebase);
+
+	return (uint64_t)((__uint128_t)t * sTimebase.numer / sTimebase.denom);
+#else
+	return t;
+#endif
+}
+
+static DKTraceRing* newRingForThisThread(void)
+{
+	NSUInteger capacity = MAX((NSUInteger)1, __atomic_load_n(&sBufferCapacity, __ATOMIC_RELAXED));
+	DKTraceRing* ring = calloc(1, sizeof(DKTraceRing) + capacity * sizeof(DKTraceEvent));
+
+	if (ring == NULL)
+		return NULL;
+
+	ring->capacity = capacity;
+	ring->epoch = __atomic_load_n(&sResetEpoch, __ATOMIC_ACQUIRE);
+
+#ifdef __APPLE__
+	pthread_threadid_np(NULL, &ring->threadID);
+
+	if (pthread_main_np())
+		strlcpy(ring->threadName, "main", sizeof(ring->threadName));
+	else
+#else
+	ring->threadID = (uint64_t)pthread_self();
+#endif
+		pthread_getname_np(pthread_self(), ring->threadName, sizeof(ring->threadName));
+
+	dispatch_sync(ringQueue(), ^{
+		ring->next = sRings;
+		sRings = ring;
+	});
+
+	pthread_setspecific(sRingKey, ring);
+	sThreadRing = ring;
+
+	return ring;
+}
+
+void DKTraceRecord(DKTraceCategory category, const char* name, uint64_t start, uint64_t duration, uint64_t argument, char phase)
+{
+	DKTraceRing* ring = sThreadRing;
+
+	if (ring == NULL && (ring = newRingForThisThread()) == NULL)
+		return;
+
+	// only this thread writes to its ring; the head is published after the event so that a reader never sees an unwritten one. A
+	// reset since the last event is noticed here, and the ring emptied before its new epoch is published.
+
+	uint64_t epoch = __atomic_load_n(&sResetEpoch, __ATOMIC_ACQUIRE);
+
+	if (ring->epoch != epoch) {
+		__atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&ring->epoch, epoch, __ATOMIC_RELEASE);
+	}
+
+	uint64_t head = ring->head;
+	DKTraceEvent* event = &ring->events[head % ring->capacity];
+
+	event->start = start;
+	event->duration = duration;
+	event->argument = argument;
+	event->name = name;
+	event->category = category;
+	event->phase = phase;
+
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void DKTraceSetBufferCapacity(NSUInteger eventsPerThread)
+{
+	__atomic_store_n(&sBufferCapacity, eventsPerThread, __ATOMIC_RELAXED);
+}
+
+void DKTraceReset(void)
+{
+	// other threads may be writing to their rings, so rather than being emptied here they are left to empty themselves when they
+	// see the new epoch, and are ignored until then. The calling thread's is replaced if the capacity has changed since it was made,
+	// and what remains of threads that have finished is freed.
+
+	DKTraceRing* mine = sThreadRing;
+	BOOL replaceMine = mine != NULL && mine->capacity != __atomic_load_n(&sBufferCapacity, __ATOMIC_RELAXED);
+
+	dispatch_sync(ringQueue(), ^{
+		DKTraceRing** link = &sRings;
+
+		__atomic_store_n(&sResetEpoch, sResetEpoch + 1, __ATOMIC_RELEASE);
+
+		while (*link) {
+			DKTraceRing* ring = *link;
+
+			if ((replaceMine && ring == mine) || ring->exited) {
+				*link = ring->next;
+				free(ring);
+			} else
+				link = &ring->next;
+		}
+	});
+
+	if (replaceMine) {
+		sThreadRing = NULL;
+		pthread_setspecific(sRingKey, NULL);
+	}
+}
+
+static uint8_t categoryIndex(uint32_t category)
+{
+	return (category == 0) ? 0 : (uint8_t)__builtin_ctz(category);
+}
+
+NSData* DKTraceData(void)
+{
+	NSMutableData* threads = [NSMutableData data];
+	NSMutableData* names = [NSMutableData data];
+	__block uint32_t threadCount = 0;
+	__block uint32_t nameCount = 0;
+	__block const char** nameTable = NULL;
+
+	dispatch_sync(ringQueue(), ^{
+		for (DKTraceRing* ring = sRings; ring; ring = ring->next) {
+			// a ring whose thread hasn't yet seen the last reset holds only events that were discarded
+
+			if (__atomic_load_n(&ring->epoch, __ATOMIC_ACQUIRE) != sResetEpoch)
+				continue;
+
+			uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+			uint32_t count = (uint32_t)MIN(head, (uint64_t)ring->capacity);
+
+			if (count == 0)
+				continue;
+
+			char threadName[DK_TRACE_THREAD_NAME_LENGTH];
+
+			memset(threadName, 0, sizeof(threadName));
+			strlcpy(threadName, ring->threadName, sizeof(threadName));
+
+			[threads appendBytes:&ring->threadID
+						  length:sizeof(uint64_t)];
+			[threads appendBytes:&count
+						  length:sizeof(uint32_t)];
+			[threads appendBytes:threadName
+						  length:sizeof(threadName)];
+
+			// oldest first
+
+			for (uint64_t i = head - count; i < head; ++i) {
+				const DKTraceEvent* event = &ring->events[i % ring->capacity];
+				uint32_t nameIndex;
+
+				// names are few, and the same constant is almost always the same pointer, so a linear search is fine
+
+				for (nameIndex = 0; nameIndex < nameCount; ++nameIndex)
+					if (nameTable[nameIndex] == event->name)
+						break;
+
+				if (nameIndex == nameCount) {
+					nameTable = realloc(nameTable, (nameCount + 1) * sizeof(const char*));
+					nameTable[nameCount++] = event->name;
+				}
+
+				uint64_t times[3] = { nanosecondsFromTimestamp(event->start), nanosecondsFromTimestamp(event->duration), event->argument };
+				uint8_t tail[4] = { (uint8_t)event->phase, categoryIndex(event->category), 0, 0 };
+
+				[threads appendBytes:times
+							  length:sizeof(times)];
+				[threads appendBytes:&nameIndex
+							  length:sizeof(uint32_t)];
+				[threads appendBytes:tail
+							  length:sizeof(tail)];
+			}
+
+			++threadCount;
+		}
+	});
+
+	for (uint32_t i = 0; i < nameCount; ++i) {
+		const char* name = nameTable[i] ? nameTable[i] : "";
+		uint32_t length = (uint32_t)strlen(name);
+
+		[names appendBytes:&length
+					length:sizeof(uint32_t)];
+		[names appendBytes:name
+					length:length];
+	}
+
+	free(nameTable);
+
+	NSMutableData* data = [NSMutableData dataWithBytes:"DKTR"
+												length:4];
+	uint32_t header[3] = { DK_TRACE_FORMAT_VERSION, nameCount, threadCount };
+
+	[data appendBytes:header
+			   length:sizeof(header)];
+	[data appendData:names];
+	[data appendData:threads];
+
+	return data;
+}
+
+BOOL DKTraceWriteToURL(NSURL* url, NSError* __autoreleasing* error)
+{
+	return [DKTraceData() writeToURL:url
+							 options:NSDataWritingAtomic
+							   error:error];
+}
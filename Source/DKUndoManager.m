@@ -5,6 +5,7 @@
 */
 
 #import "DKUndoManager.h"
+#import "DKTrace.h"
 #import "LogEvent.h"
 
 #if USE_GC_UNDO_MANAGER
@@ -66,8 +67,7 @@
 - (void)invokeEmbeddedInvocation:(NSInvocation*)invocation
 {
 	@try {
-		LogEvent_(kInfoEvent, @"%@ %@ '%@' target = <%@ %p>", [self isUndoing] ? @"undoing" : @"redoing", [self undoActionName], NSStringFromSelector([invocation selector]), NSStringFromClass([[invocation target] class]), [invocation target]);
-
+		DKTraceScope(span, kDKTraceUndo, [self isUndoing] ? "invoke undo task" : "invoke redo task");
 		[invocation invoke];
 	}
 	@catch (NSException* excp) {
@@ -115,11 +115,9 @@
 	mLastSelector = NULL;
 	mChangePerGroupCount = 0;
 
-	NSLog(@"grouping level = %ld", (long)[self groupingLevel]);
-
 	[super beginUndoGrouping];
 
-	LogEvent_(kInfoEvent, @"%@ opened undo group, level = %ld", self, (long)[self groupingLevel]);
+	DKTraceInstant(kDKTraceUndo, "open undo group", [self groupingLevel]);
 }
 
 - (void)endUndoGrouping
@@ -127,11 +125,9 @@
 	mSkipTask = NO;
 	mLastSelector = NULL;
 
-	NSLog(@"grouping level = %ld", (long)[self groupingLevel]);
-
 	[super endUndoGrouping];
 
-	LogEvent_(kInfoEvent, @"%@ closed undo group, level = %ld, tasks submitted = %lu", self, (long)[self groupingLevel], (unsigned long)[self numberOfTasksInLastGroup]);
+	DKTraceInstant(kDKTraceUndo, "close undo group", [self groupingLevel]);
 }
 
 - (id)prepareWithInvocationTarget:(id)target
@@ -168,14 +164,12 @@
 				//if the target and selector are the same return
 
 				if (target == mSkipTargetRef && mLastSelector == sel) {
-					LogEvent_(kInfoEvent, @"undo '%@' (discarded) group %ld", NSStringFromSelector(sel), (long)[self groupingLevel]);
+					DKTraceInstant(kDKTraceUndo, "coalesce undo task", [self groupingLevel]);
 
 					return;
 				}
 			}
 
-			LogEvent_(kInfoEvent, @"undo '%@' (accepted) group %ld", NSStringFromSelector(sel), (long)[self groupingLevel]);
-
 			mSkipTargetRef = target;
 			mSkipTask = YES;
 			mLastSelector = sel;
@@ -232,13 +226,12 @@
 			//if the target and selector are the same discard the invocation and return
 
 			if ((mLastTargetRef == mSkipTargetRef) && (mLastSelector == [invocation selector])) {
-				LogEvent_(kInfoEvent, @"undo invocation: [%@ %@] (discarded) group %ld", NSStringFromClass([mSkipTargetRef class]), NSStringFromSelector([invocation selector]), (long)[self groupingLevel]);
+				DKTraceInstant(kDKTraceUndo, "coalesce undo invocation", [self groupingLevel]);
 
 				return;
 			}
 		}
 
-		LogEvent_(kInfoEvent, @"undo invocation: [%@ %@] (accepted) group %ld", NSStringFromClass([mSkipTargetRef class]), NSStringFromSelector([invocation selector]), (long)[self groupingLevel]);
 		mLastTargetRef = mSkipTargetRef;
 		mLastSelector = [invocation selector];
 	}
@@ -64,9 +64,11 @@
 
 - (NSBezierPath*)renderingPathForObject:(id<DKRenderable>)object
 {
-	return [[super renderingPathForObject:object] bezierPathWithWavelength:[self wavelength]
-																 amplitude:[self amplitude]
-																	spread:[self spread]];
+	// the path is only filled, never changed, so the shared cached copy will do
+
+	return [[super renderingPathForObject:object] cachedBezierPathWithWavelength:[self wavelength]
+																	   amplitude:[self amplitude]
+																		  spread:[self spread]];
 }
 
 - (BOOL)isFill
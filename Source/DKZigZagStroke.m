@@ -76,9 +76,9 @@
 - (void)renderPath:(NSBezierPath*)path
 {
 	if ([self amplitude] > 0) {
-		NSBezierPath* rp = [path bezierPathWithWavelength:[self wavelength]
-												amplitude:[self amplitude]
-												   spread:[self spread]];
+		NSBezierPath* rp = [path cachedBezierPathWithWavelength:[self wavelength]
+													  amplitude:[self amplitude]
+														 spread:[self spread]];
 		[super renderPath:rp];
 	} else
 		[super renderPath:path];
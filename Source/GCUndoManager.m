@@ -5,6 +5,7 @@
 */
 
 #import "GCUndoManager.h"
+#import "DKTrace.h"
 
 // this proxy object is returned by -prepareWithInvocationTarget: if GCUM_USE_PROXY is 1. This provides a similar behaviour to NSUndoManager
 // on 10.6 so that a wider range of methods can be submitted as undo tasks. Unlike 10.6 however, it does not bypass um's -forwardInvocation:
@@ -158,6 +159,8 @@
 	THROW_IF_FALSE([self undoManagerState] == kGCUndoCollectingTasks, @"can't redo - already undoing or redoing");
 	THROW_IF_FALSE([self groupingLevel] == 0, @"can't redo - a group is still open");
 
+	DKTraceScope(span, kDKTraceUndo, "redo");
+
 	[self checkpoint];
 	[self popRedoAndPerformTasks];
 }
@@ -180,6 +183,8 @@
 	THROW_IF_FALSE([self undoManagerState] == kGCUndoCollectingTasks, @"can't undo - already undoing or redoing");
 	THROW_IF_FALSE([self groupingLevel] == 0, @"can't undo - a group is still open");
 
+	DKTraceScope(span, kDKTraceUndo, "undo");
+
 	[self checkpoint];
 	[self popUndoAndPerformTasks];
 }
@@ -6,6 +6,7 @@
 
 #import <Cocoa/Cocoa.h>
 #import "DKBezierLayoutManager.h"
+#import "DKGreekingLayoutManager.h"
 #import "DKCommonTypes.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -102,12 +103,20 @@ NS_ASSUME_NONNULL_BEGIN
 
 // can be used by text drawers everywhere
 
-/** @brief Supply a layout manager common to all \c DKTextShape instances
- @return the shared layout manager instance */
+/** @brief Supply a layout manager common to all \c DKTextShape instances drawn on the calling thread
+
+ Each thread has its own, so text may be laid out on several threads at once. The result must not be passed to another thread.
+ @return the thread's layout manager instance */
 NSLayoutManager* sharedDrawingLayoutManager(void);
 
-/** @brief Supply a layout manager that can be used to capture text layout into a bezier path
- @return the shared layout manager instance */
+/** @brief Supply a layout manager that can be used to capture text layout into a bezier path on the calling thread
+ @return the thread's layout manager instance */
 DKBezierLayoutManager* sharedCaptureLayoutManager(void);
 
+/** @brief Supply a greeking layout manager for laying out text on the calling thread, with a \c DKBezierTextContainer that has no path.
+
+ Its greeking is left as the last user set it, so callers should set the greeking they want.
+ @return the thread's layout manager instance */
+DKGreekingLayoutManager* sharedGreekingLayoutManager(void);
+
 NS_ASSUME_NONNULL_END
@@ -11,30 +11,30 @@
 #import "NSAttributedString+DKAdditions.h"
 #import "NSBezierPath+Geometry.h"
 
-/** @brief Supply a layout manager common to all DKTextShape instances
- @return the shared layout manager instance */
+/** @brief Supply a layout manager common to all DKTextShape instances drawn on the calling thread
+ @return the thread's layout manager instance */
 NSLayoutManager* sharedDrawingLayoutManager(void)
 {
 	// This method returns an NSLayoutManager that can be used to draw the contents of a DKTextShape.
-	// The same layout manager is used for all instances of the class
+	// The same layout manager is used for all instances of the class on one thread. A layout manager must only be used by one thread
+	// at a time, so each thread has its own, and text can be laid out on several threads at once.
 
-	static NSLayoutManager* sharedLM = nil;
+	NSMutableDictionary* threadDict = [[NSThread currentThread] threadDictionary];
+	NSLayoutManager* sharedLM = [threadDict objectForKey:@"DKSharedDrawingLayoutManager"];
 	NSTextContainer* tc = nil;
 
 	if (sharedLM == nil) {
 		tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
-		//NSTextView*	tv = [[NSTextView alloc] initWithFrame:NSZeroRect];
 
 		sharedLM = [[NSLayoutManager alloc] init];
 
-		//[tc setTextView:tv];
-		//[tv release];
-
 		[tc setWidthTracksTextView:NO];
 		[tc setHeightTracksTextView:NO];
 		[sharedLM addTextContainer:tc];
 
 		[sharedLM setUsesScreenFonts:NO];
+		[threadDict setObject:sharedLM
+					   forKey:@"DKSharedDrawingLayoutManager"];
 	} else
 		tc = [[sharedLM textContainers] lastObject];
 
@@ -42,26 +42,28 @@ NSLayoutManager* sharedDrawingLayoutManager(void)
 	return sharedLM;
 }
 
-/** @brief Supply a layout manager that can be used to capture text layout into a bezier path
- @return the shared layout manager instance */
+/** @brief Supply a layout manager that can be used to capture text layout into a bezier path on the calling thread
+ @return the thread's layout manager instance */
 DKBezierLayoutManager* sharedCaptureLayoutManager(void)
 {
-	static DKBezierLayoutManager* sharedLM = nil;
+	// as above, one per thread. The container has no text view, as views belong to the main thread; the captured glyphs don't need one.
+
+	NSMutableDictionary* threadDict = [[NSThread currentThread] threadDictionary];
+	DKBezierLayoutManager* sharedLM = [threadDict objectForKey:@"DKSharedCaptureLayoutManager"];
 	NSTextContainer* tc = nil;
 
 	if (sharedLM == nil) {
 		tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
-		NSTextView* tv = [[NSTextView alloc] initWithFrame:NSZeroRect];
 
 		sharedLM = [[DKBezierLayoutManager alloc] init];
 
-		[tc setTextView:tv];
-
 		[tc setWidthTracksTextView:NO];
 		[tc setHeightTracksTextView:NO];
 		[sharedLM addTextContainer:tc];
 
 		[sharedLM setUsesScreenFonts:NO];
+		[threadDict setObject:sharedLM
+					   forKey:@"DKSharedCaptureLayoutManager"];
 	} else
 		tc = [[sharedLM textContainers] lastObject];
 
@@ -69,6 +71,34 @@ DKBezierLayoutManager* sharedCaptureLayoutManager(void)
 	return sharedLM;
 }
 
+DKGreekingLayoutManager* sharedGreekingLayoutManager(void)
+{
+	// as above, one per thread. The container is left as a plain rectangle, as it may have been given a path by the last user.
+
+	NSMutableDictionary* threadDict = [[NSThread currentThread] threadDictionary];
+	DKGreekingLayoutManager* sharedLM = [threadDict objectForKey:@"DKSharedGreekingLayoutManager"];
+	DKBezierTextContainer* tc = nil;
+
+	if (sharedLM == nil) {
+		tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
+
+		sharedLM = [[DKGreekingLayoutManager alloc] init];
+
+		[tc setWidthTracksTextView:NO];
+		[tc setHeightTracksTextView:NO];
+		[sharedLM addTextContainer:tc];
+
+		[sharedLM setUsesScreenFonts:NO];
+		[threadDict setObject:sharedLM
+					   forKey:@"DKSharedGreekingLayoutManager"];
+	} else
+		tc = (id)[[sharedLM textContainers] lastObject];
+
+	[tc setBezierPath:nil];
+	[tc setLineFragmentPadding:0];
+	return sharedLM;
+}
+
 @implementation NSAttributedString (DKAdditions)
 
 - (void)drawInRect:(NSRect)destRect withLayoutSize:(NSSize)layoutSize atAngle:(CGFloat)radians
@@ -7,6 +7,7 @@
 #import "NSBezierPath+Editing.h"
 
 #import "DKGeometryUtilities.h"
+#import "DKRandom.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Geometry.h"
 
@@ -24,6 +25,13 @@ static CGFloat sAngleConstraint = 0.261799387799; // 15°
 static inline NSInteger arrayIndexForPartcode(const NSInteger pc);
 static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 
+// mixes the eight bytes of <v> into the hash <h>
+
+static inline uint64_t fnvMix(uint64_t h, uint64_t v)
+{
+	return DKRandomHashBytes(h, &v, sizeof(v));
+}
+
 #pragma mark -
 @implementation NSBezierPath (DKEditing)
 #pragma mark As an NSBezierPath
@@ -364,29 +372,40 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 	// Do not rely on the actual value returned, only whether it's the same as a previous value or another path. Do not archive or persist this value. Note that two paths
 	// with identical contents will return the same value, which might be a useful trait.
 
-	NSUInteger cs = 157145267; // start with arbitrary number
-	NSUInteger ec = (NSUInteger)[self elementCount];
+	// the path is hashed with 64-bit FNV-1a, taking the element types and the full bits of every coordinate in order, so that paths which
+	// differ only by a small move, or by the order of their elements, get different values. It is strong enough to key a cache of paths
+	// derived from this one.
+
+	uint64_t cs = kDKRandomHashInitial;
+	NSInteger ec = [self elementCount];
 	NSPoint p[3];
-	NSInteger i;
+	NSInteger i, j, n;
 	NSBezierPathElement element;
 
-	// munge with element count
+	cs = fnvMix(cs, (uint64_t)ec);
+	cs = fnvMix(cs, (uint64_t)[self windingRule]);
 
-	cs ^= (ec << 5);
+	for (i = 0; i < ec; ++i) {
+		element = [self elementAtIndex:i
+					  associatedPoints:p];
+		n = (element == NSCurveToBezierPathElement) ? 3 : (element == NSClosePathBezierPathElement) ? 0 : 1;
 
-	if (![self isEmpty]) {
-		// munge all the internal points together
-
-		for (i = 0; i < [self elementCount]; ++i) {
-			p[1] = p[2] = NSZeroPoint;
-			element = [self elementAtIndex:i
-						  associatedPoints:p];
-			ec = ((NSUInteger)element << 10) ^ lround(p[0].x) ^ lround(p[1].x) ^ lround(p[2].x) ^ lround(p[0].y) ^ lround(p[1].y) ^ lround(p[2].y);
-			cs ^= ec;
+		cs = fnvMix(cs, (uint64_t)element);
+
+		for (j = 0; j < n; ++j) {
+			// adding 0 makes -0 and +0 the same
+
+			double x = p[j].x + 0.0, y = p[j].y + 0.0;
+			uint64_t xb, yb;
+
+			memcpy(&xb, &x, sizeof(xb));
+			memcpy(&yb, &y, sizeof(yb));
+			cs = fnvMix(cs, xb);
+			cs = fnvMix(cs, yb);
 		}
 	}
 
-	return cs;
+	return (NSUInteger)cs;
 }
 
 #pragma mark -
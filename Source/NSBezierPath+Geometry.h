@@ -5,6 +5,7 @@
 */
 
 #import <Cocoa/Cocoa.h>
+#import "DKRandom.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -66,17 +67,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable NSBezierPath*)bezierPathByIteratingWithDelegate:(id<DKBezierElementIterationDelegate>)delegate contextInfo:(nullable void*)contextInfo;
 
-/** @brief returns a copy of the receiver modified by offsetting all of its control points by \c delta in the direction of the
- normal of the path at the location of the on-path control point.
+/** @brief returns a path parallel to the receiver, offset by \c delta.
  
- Returns a copy of the receiver modified by offsetting all of its control points by \c delta in the direction of the
- normal of the path at the location of the on-path control point. This will create a parallel-ish offset path that works
- for most non-pathological paths. Given that there is no known mathematically correct way to do this (for bezier curves), this works well enough in
- many practical situations. Positive delta moves the path below or to the right, negative is up and left.
+ Curves are offset directly to within the receiver's flatness, corners on the outside of bends are joined using the receiver's line
+ join style and miter limit, and the loops that form on the inside of bends are removed. See DKFlatPath (Offset) for details.
+ Positive delta moves the path below or to the right, negative is up and left.
  */
 - (NSBezierPath*)paralleloidPathWithOffset:(CGFloat)delta;
+/** @brief as paralleloidPathWithOffset:, but returns the receiver if \c delta is zero.
+ */
 - (NSBezierPath*)paralleloidPathWithOffset2:(CGFloat)delta;
 - (NSBezierPath*)paralleloidPathWithOffset22:(CGFloat)delta;
+/** @brief returns a path parallel to the receiver whose offset varies linearly with distance along the path from \c delta1 to \c delta2.
+ */
 - (NSBezierPath*)offsetPathWithStartingOffset:(CGFloat)delta1 endingOffset:(CGFloat)delta2;
 - (NSBezierPath*)offsetPathWithStartingOffset2:(CGFloat)delta1 endingOffset:(CGFloat)delta2;
 
@@ -91,18 +94,38 @@ NS_ASSUME_NONNULL_BEGIN
 // roughening and randomising paths
 
 - (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount;
+/** @brief As <code>-bezierPathByRandomisingPoints:</code>, drawing the offsets from \c rng rather than the calling thread's generator.
+ */
+- (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount randomState:(DKRandomState*)rng;
 - (nullable NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount;
+- (nullable NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount randomState:(DKRandomState*)rng;
 - (NSBezierPath*)bezierPathWithFragmentedLineSegments:(CGFloat)flatness;
 
 // zig-zags and waves
 
 - (NSBezierPath*)bezierPathWithZig:(CGFloat)zig zag:(CGFloat)zag;
 - (NSBezierPath*)bezierPathWithWavelength:(CGFloat)lambda amplitude:(CGFloat)amp spread:(CGFloat)spread;
+/** @brief As <code>-bezierPathWithWavelength:amplitude:spread:</code>, but remembers recent results.
+
+ The cache is keyed by the receiver's checksum and the wave's parameters, so drawing the same unchanged path with the same settings
+ again returns the earlier path rather than building it anew. The result may be shared with other callers and must not be modified.
+ Safe to call from any thread.
+ */
+- (NSBezierPath*)cachedBezierPathWithWavelength:(CGFloat)lambda amplitude:(CGFloat)amp spread:(CGFloat)spread;
 
 // getting the outline of a stroked path:
 
+/** @brief returns the outline of the receiver as it would be stroked with its current width, join, cap and dash settings.
+
+ The result should be filled using the non-zero winding rule.
+ */
 @property (readonly, copy) NSBezierPath* strokedPath;
 - (NSBezierPath*)strokedPathWithStrokeWidth:(CGFloat)width;
+/** @brief returns the outline of a stroke whose width varies linearly with distance along the path from \c width1 to \c width2.
+
+ Any dash is ignored.
+ */
+- (NSBezierPath*)strokedPathWithStartingWidth:(CGFloat)width1 endingWidth:(CGFloat)width2;
 
 // breaking a path apart:
 
@@ -5,6 +5,7 @@
 */
 
 #import "DKDrawKitMacros.h"
+#import "DKFlatPath+Offset.h"
 #import "DKGeometryUtilities.h"
 #import "DKRandom.h"
 #import "LogEvent.h"
@@ -17,40 +18,22 @@
 
 #define USE_OMNI_METHODS 0
 
+#define DEFAULT_TRIM_EPSILON 0.1
+
 #if USE_OMNI_METHODS
 #import "NSBezierPath-OAExtensions.h"
 #endif
 
 #pragma mark Static Functions
 static void ConvertPathApplierFunction(void* info, const CGPathElement* element);
-static CGFloat lengthOfBezier(const NSPoint bez[4], CGFloat acceptableError);
 static inline CGFloat distanceBetween(NSPoint a, NSPoint b);
+static NSBezierPath* wavePath(NSBezierPath* path, CGFloat lambda, CGFloat amp, CGFloat spread);
 
 /** given the vertices of the path v0..v2, this calculates \c cp1 and \c cp2 being the control points for the curve segments v0..v1 and v1..v2. i.e. this
  calculates only half of the control points, but does so for two segments. The caller needs to accumulate \c cp1 until it has \c cp2 for the same segment
  before it can add the curve segment.
  */
 static void InterpolatePoints(const NSPoint pointsIn[3], NSPoint* cp1, NSPoint* cp2, const CGFloat smooth_value);
-/** given 3 points in <code>pointsIn</code>, this returns the point that bisects the angle between the vertices, and is extended to intercept the \c offset
- parallel up to <code>miterLimit</code>. This is used to compute the correct location of a vertex for a parallel offset path.
- for zero offset, result is simply second point.
- The three points are three consecutive vertices from the original path.
- */
-static NSPoint CornerPoint(const NSPoint pointsIn[3], CGFloat offset, CGFloat miterLimit);
-/** Returns an arc segment that is centred at the middle vertex having a radius of \c offset and a start point and end point such that the offset normals to the original
- edges are joined by the arc. If the vertex is an inside bend, returns \c nil in which case the \c CornerPoint should be used.
- */
-static BOOL CornerArc(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath* newPath);
-/** Appends a bevel segment that is centred at the middle vertex having a radius of \c offset and a start point and end point such that the offset normals to the original
- edges are joined by the arc. If the vertex is an inside bend, returns \c nil in which case the \c CornerPoint should be used.
- */
-static BOOL CornerBevel(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath* newPath);
-
-@interface NSBezierPath (Geometry_Private)
-- (NSBezierPath*)paralleloidPathWithOffset3:(CGFloat)delta lineJoinStyle:(NSLineJoinStyle)js;
-
-@end
-
 #pragma mark -
 @implementation NSBezierPath (Geometry)
 #pragma mark As an NSBezierPath
@@ -334,472 +317,44 @@ static BOOL CornerBevel(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath*
 #pragma mark -
 - (NSBezierPath*)paralleloidPathWithOffset:(CGFloat)delta
 {
-	NSBezierPath* newPath = [NSBezierPath bezierPath];
-
-	if (![self isEmpty]) {
-		NSInteger i, count = [self elementCount];
-		NSPoint ap[3], np[3], p0, p1;
-		NSBezierPathElement kind, nextKind;
-		CGFloat slope, dx, dy, pdx, pdy;
-
-		pdx = pdy = 0;
-
-		for (i = 0; i < count; ++i) {
-			kind = [self elementAtIndex:i
-					   associatedPoints:ap];
-
-			if (i < count - 1) {
-				[self elementAtIndex:i + 1
-					associatedPoints:np];
-
-				// calculate the slope of the on-path point
-
-				if (kind != NSCurveToBezierPathElement) {
-					p0 = ap[0];
-					p1 = np[0];
-				} else {
-					p0 = ap[2];
-					p1 = np[0];
-				}
-			} else {
-				if (kind == NSCurveToBezierPathElement) {
-					p1 = ap[2];
-					p0 = ap[1];
-				} else {
-					p1 = ap[0];
-
-					nextKind = [self elementAtIndex:i - 1
-								   associatedPoints:np];
-
-					if (nextKind != NSCurveToBezierPathElement)
-						p0 = np[0];
-					else
-						p0 = np[2];
-				}
-			}
-
-			slope = atan2(p1.y - p0.y, p1.x - p0.x) + (M_PI_2);
-
-			// calculate the position of the modified point
-
-			dx = delta * cos(slope);
-			dy = delta * sin(slope);
-
-			switch (kind) {
-			case NSMoveToBezierPathElement:
-				ap[0].x += dx;
-				ap[0].y += dy;
-				[newPath moveToPoint:ap[0]];
-				break;
-
-			case NSLineToBezierPathElement:
-				ap[0].x += dx;
-				ap[0].y += dy;
-				[newPath lineToPoint:ap[0]];
-				break;
-
-			case NSCurveToBezierPathElement:
-				ap[0].x += pdx;
-				ap[0].y += pdy;
-				ap[1].x += dx;
-				ap[1].y += dy;
-				ap[2].x += dx;
-				ap[2].y += dy;
-				[newPath curveToPoint:ap[2]
-						controlPoint1:ap[0]
-						controlPoint2:ap[1]];
-				break;
-
-			case NSClosePathBezierPathElement:
-				[newPath closePath];
-				break;
-
-			default:
-				break;
-			}
-
-			pdx = dx;
-			pdy = dy;
-		}
-	}
-
-	return newPath;
-}
-
-static NSPoint CornerPoint(const NSPoint pointsIn[3], CGFloat offset, CGFloat miterLimit)
-{
-	if (offset == 0.0)
-		return pointsIn[1];
-
-	NSPoint rp;
-	CGFloat relAngle, r, s1, s2, angle;
-
-	s1 = Slope(pointsIn[0], pointsIn[1]);
-	s2 = Slope(pointsIn[1], pointsIn[2]);
-
-	relAngle = (s2 - s1) * 0.5;
-	r = offset / cos(relAngle);
-	angle = s1 + relAngle + NINETY_DEGREES;
-
-	CGFloat maxR = fabs(miterLimit * offset);
-
-	if (r > maxR)
-		r = maxR;
-
-	if (r < -maxR)
-		r = -maxR;
-
-	rp.x = pointsIn[1].x + r * cos(angle);
-	rp.y = pointsIn[1].y + r * sin(angle);
-
-	return rp;
-}
-
-static BOOL CornerArc(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath* newPath)
-{
-	if (offset == 0.0)
-		return NO;
-
-	CGFloat s1, s2, ra;
-
-	s1 = Slope(pointsIn[0], pointsIn[1]);
-	s2 = Slope(pointsIn[2], pointsIn[1]);
-
-	// only the arc that goes around the "outside" of the bend is required, so we need a way to detect which side of the line we are offsetting to
-	// and only append an arc for the outside case.
-
-	ra = s2 - s1;
-
-	if (ra > M_PI)
-		ra = M_PI - ra;
-
-	if (ra < -M_PI)
-		ra = -M_PI - ra;
-
-	//NSLog(@"ra = %f, offset = %f", ra, offset );
-
-	if ((ra < 0 && offset > 0) || (ra > 0 && offset < 0))
-		return NO;
-
-	s2 = Slope(pointsIn[1], pointsIn[2]);
-
-	[newPath appendBezierPathWithArcWithCenter:pointsIn[1]
-										radius:offset
-									startAngle:RADIANS_TO_DEGREES(s1 + NINETY_DEGREES)
-									  endAngle:RADIANS_TO_DEGREES(s2 + NINETY_DEGREES)
-									 clockwise:offset > 0];
-
-	return YES;
-}
-
-static BOOL CornerBevel(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath* newPath)
-{
-	if (offset == 0.0)
-		return NO;
-
-	CGFloat s1, s2, ra;
-
-	s1 = Slope(pointsIn[0], pointsIn[1]);
-	s2 = Slope(pointsIn[2], pointsIn[1]);
-
-	// only the arc that goes around the "outside" of the bend is required, so we need a way to detect which side of the line we are offsetting to
-	// and only append an arc for the outside case.
-
-	ra = s2 - s1;
-
-	if (ra > M_PI)
-		ra = M_PI - ra;
-
-	if (ra < -M_PI)
-		ra = -M_PI - ra;
-
-	//NSLog(@"ra = %f, offset = %f", ra, offset );
-
-	if ((ra < 0 && offset > 0) || (ra > 0 && offset < 0))
-		return NO;
-
-	NSPoint pa, pb;
-
-	pa.x = pointsIn[1].x + offset * cos(s1 + NINETY_DEGREES);
-	pa.y = pointsIn[1].y + offset * sin(s1 + NINETY_DEGREES);
-	pb.x = pointsIn[1].x + offset * cos(s2 - NINETY_DEGREES);
-	pb.y = pointsIn[1].y + offset * sin(s2 - NINETY_DEGREES);
-
-	[newPath lineToPoint:pa];
-	[newPath lineToPoint:pb];
-
-	return YES;
+	return [self offsetPathWithStartingOffset:delta
+								 endingOffset:delta];
 }
 
 - (NSBezierPath*)paralleloidPathWithOffset2:(CGFloat)delta
 {
-	// returns a path offset by <delta>, using the paralleloidPathWithOffset method above on a flattened version of the path. If the caller sets the
-	// default flatness prior to calling this they can control the fineness of the offset path. The offset joins are set to match the current line join style.
-
 	if (delta == 0.0)
 		return self;
 
-	NSBezierPath* temp;
-	temp = [self bezierPathByFlatteningPath];
-	temp = [temp paralleloidPathWithOffset:delta];
-
-	return temp;
+	return [self paralleloidPathWithOffset:delta];
 }
 
 - (NSBezierPath*)paralleloidPathWithOffset22:(CGFloat)delta
 {
-	// returns a path offset by <delta>, using the paralleloidPathWithOffset3 method below on a flattened version of the path. If the caller sets the
-	// default flatness prior to calling this they can control the fineness of the offset path. The offset joins are set to match the current line join style.
-
 	if (delta == 0.0)
 		return self;
 
-	NSBezierPath* temp;
-	temp = [self bezierPathByFlatteningPath];
-	temp = [temp paralleloidPathWithOffset3:delta
-							  lineJoinStyle:[self lineJoinStyle]];
-
-	return temp;
-}
-
-- (NSBezierPath*)paralleloidPathWithOffset3:(CGFloat)delta lineJoinStyle:(NSLineJoinStyle)js
-{
-	// requires flattened path, calculates correct points at the corners
-
-	NSBezierPath* newPath = [NSBezierPath bezierPath];
-	NSInteger i, m = [self elementCount], spc = 0, spStartIndex = 0;
-	NSBezierPathElement element;
-	NSPoint ap[3];
-	NSPoint v[3];
-	NSPoint fp, op, sop;
-	CGFloat slope;
-
-	v[0] = v[1] = v[2] = sop = op = fp = NSZeroPoint;
-
-	for (i = 0; i < m; ++i) {
-		element = [self elementAtIndex:i
-					  associatedPoints:ap];
-
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			// starting a new subpath - don't start the new path yet as we need the next point to know the slope
-
-			fp = v[0] = ap[0];
-			spc = 0;
-			break;
-
-		case NSLineToBezierPathElement:
-			if (spc == 0) {
-				// recently started a new subpath, so set 2nd vertex
-				v[1] = ap[0];
-				spc++;
-
-				// ok, we have enough to work out the slope and start the new path
-
-				slope = Slope(v[0], v[1]) + M_PI_2;
-				op.x = v[0].x + delta * cos(slope);
-				op.y = v[0].y + delta * sin(slope);
-				[newPath moveToPoint:op];
-				spStartIndex = [newPath elementCount] - 1;
-			} else {
-				v[2] = ap[0];
-
-				// we have three vertices, so we can calculate the required corner point
-
-				op = CornerPoint(v, delta, [self miterLimit]);
-				if (js == NSMiterLineJoinStyle)
-					[newPath lineToPoint:op];
-				else if (js == NSBevelLineJoinStyle) {
-					if (!CornerBevel(v, delta, newPath))
-						[newPath lineToPoint:op];
-				} else {
-					if (!CornerArc(v, delta, newPath))
-						[newPath lineToPoint:op];
-				}
-
-				if (spc == 1)
-					sop = op;
-
-				// shift vertex array
-
-				v[0] = v[1];
-				v[1] = v[2];
-				spc++;
-			}
-			break;
-
-		case NSCurveToBezierPathElement:
-			NSAssert(NO, @"paralleloidPathWithOffset3 requires a flattened path");
-			break;
-
-		case NSClosePathBezierPathElement:
-			// close the path by curving back to the first point
-			v[2] = fp;
-
-			op = CornerPoint(v, delta, [self miterLimit]);
-			if (js == NSMiterLineJoinStyle)
-				[newPath lineToPoint:op];
-			else if (js == NSBevelLineJoinStyle) {
-				if (!CornerBevel(v, delta, newPath))
-					[newPath lineToPoint:op];
-			} else {
-				if (!CornerArc(v, delta, newPath))
-					[newPath lineToPoint:op];
-			}
-			v[0] = v[1];
-			v[1] = v[2];
-			v[2] = sop;
-
-			op = CornerPoint(v, delta, [self miterLimit]);
-			if (js == NSMiterLineJoinStyle) {
-				[newPath lineToPoint:op];
-				[newPath setAssociatedPoints:&op
-									 atIndex:spStartIndex];
-			} else if (js == NSBevelLineJoinStyle) {
-				if (!CornerBevel(v, delta, newPath)) {
-					[newPath lineToPoint:op];
-					[newPath setAssociatedPoints:&op
-										 atIndex:spStartIndex];
-				}
-			} else {
-				if (!CornerArc(v, delta, newPath)) {
-					[newPath lineToPoint:op];
-					[newPath setAssociatedPoints:&op
-										 atIndex:spStartIndex];
-				}
-			}
-			spc = 0;
-
-			[newPath closePath];
-			break;
-
-		default:
-			break;
-		}
-	}
-
-	if (spc > 0) {
-		// open-ended path, place last offset point
-
-		slope = Slope(v[0], v[1]) + M_PI_2;
-		op.x = v[1].x + delta * cos(slope);
-		op.y = v[1].y + delta * sin(slope);
-		[newPath lineToPoint:op];
-	}
-
-	return newPath;
+	return [self paralleloidPathWithOffset:delta];
 }
 
 - (NSBezierPath*)offsetPathWithStartingOffset:(CGFloat)delta1 endingOffset:(CGFloat)delta2
 {
-	// similar to making a paralleloid path, but instead of a constant offset, each point has a different offset
-	// applied as a linear function of the difference between delta1 and delta2. So the result has a similar curvature
-	// to the original path, but also an additional ramp.
-
-	NSBezierPath* newPath = [NSBezierPath bezierPath];
-
-	if (![self isEmpty]) {
-		NSInteger i, count = [self elementCount];
-		NSPoint ap[3], np[3], p0, p1;
-		NSBezierPathElement kind, nextKind;
-		CGFloat del, slope, dx, dy, pdx, pdy;
-
-		pdx = pdy = 0;
-
-		for (i = 0; i < count; ++i) {
-			del = (((delta2 - delta1) * i) / (count - 1)) + delta1;
-
-			//	LogEvent_(kInfoEvent, @"segment %d, del = %f", i, del );
-
-			kind = [self elementAtIndex:i
-					   associatedPoints:ap];
-
-			if (i < count - 1) {
-				[self elementAtIndex:i + 1
-					associatedPoints:np];
-
-				// calculate the slope of the on-path point
+	// the offset varies linearly with distance along the path. Corners are joined according to the receiver's join style and miter
+	// limit, and curves are offset to within its flatness.
 
-				if (kind != NSCurveToBezierPathElement) {
-					p0 = ap[0];
-					p1 = np[0];
-				} else {
-					p0 = ap[2];
-					p1 = np[0];
-				}
-			} else {
-				if (kind == NSCurveToBezierPathElement) {
-					p1 = ap[2];
-					p0 = ap[1];
-				} else {
-					p1 = ap[0];
-
-					nextKind = [self elementAtIndex:i - 1
-								   associatedPoints:np];
-
-					if (nextKind != NSCurveToBezierPathElement)
-						p0 = np[0];
-					else
-						p0 = np[2];
-				}
-			}
-
-			slope = atan2(p1.y - p0.y, p1.x - p0.x) + (M_PI * 0.5);
-
-			// calculate the position of the modified point
-
-			dx = del * cos(slope);
-			dy = del * sin(slope);
-
-			switch (kind) {
-			case NSMoveToBezierPathElement:
-				ap[0].x += dx;
-				ap[0].y += dy;
-				[newPath moveToPoint:ap[0]];
-				break;
-
-			case NSLineToBezierPathElement:
-				ap[0].x += dx;
-				ap[0].y += dy;
-				[newPath lineToPoint:ap[0]];
-				break;
-
-			case NSCurveToBezierPathElement: {
-				ap[0].x += pdx;
-				ap[0].y += pdy;
-				ap[1].x += dx;
-				ap[1].y += dy;
-				ap[2].x += dx;
-				ap[2].y += dy;
-				[newPath curveToPoint:ap[2]
-						controlPoint1:ap[0]
-						controlPoint2:ap[1]];
-			} break;
+	DKFlatPath* fp = [DKFlatPath flatPathWithBezierPath:self];
 
-			case NSClosePathBezierPathElement:
-				[newPath closePath];
-				break;
-
-			default:
-				break;
-			}
-
-			pdx = dx;
-			pdy = dy;
-		}
-	}
-
-	return newPath;
+	return [[fp flatPathByOffsettingFrom:delta1
+									  to:delta2
+						   lineJoinStyle:[self lineJoinStyle]
+							  miterLimit:[self miterLimit]
+							   tolerance:[self flatness]] bezierPath];
 }
 
 - (NSBezierPath*)offsetPathWithStartingOffset2:(CGFloat)delta1 endingOffset:(CGFloat)delta2
 {
-	// Works exactly as above.
-	NSBezierPath* temp = self;
-#pragma unused(delta1, delta2)
-	temp = [temp offsetPathWithStartingOffset:delta1
+	return [self offsetPathWithStartingOffset:delta1
 								 endingOffset:delta2];
-	return temp;
 }
 
 - (NSBezierPath*)bezierPathByInterpolatingPath:(CGFloat)amount
@@ -1009,6 +564,12 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 
 #pragma mark -
 - (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount
+{
+	return [self bezierPathByRandomisingPoints:maxAmount
+								   randomState:DKRandomThreadState()];
+}
+
+- (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount randomState:(DKRandomState*)rng
 {
 	NSBezierPath* newPath = [self copy];
 
@@ -1027,8 +588,8 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 			kind = [self elementAtIndex:i
 					   associatedPoints:ap];
 
-			dx = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
-			dy = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
+			dx = DKRandomSigned(rng) * maxAmount;
+			dy = DKRandomSigned(rng) * maxAmount;
 
 			//LogEvent_(kInfoEvent, @"random amount = {%f, %f}", dx, dy );
 
@@ -1046,12 +607,12 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 			case NSCurveToBezierPathElement:
 				ap[0].x += dx;
 				ap[0].y += dy;
-				dx = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
-				dy = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
+				dx = DKRandomSigned(rng) * maxAmount;
+				dy = DKRandomSigned(rng) * maxAmount;
 				ap[1].x += dx;
 				ap[1].y += dy;
-				dx = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
-				dy = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
+				dx = DKRandomSigned(rng) * maxAmount;
+				dy = DKRandomSigned(rng) * maxAmount;
 				ap[2].x += dx;
 				ap[2].y += dy;
 				[newPath curveToPoint:ap[2]
@@ -1073,6 +634,12 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 }
 
 - (NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount
+{
+	return [self bezierPathWithRoughenedStrokeOutline:amount
+										  randomState:DKRandomThreadState()];
+}
+
+- (NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount randomState:(DKRandomState*)rng
 {
 	// given the path, this returns the outline of the path stroke roughened by the given amount. Roughening works by first taking the stroke outline at the
 	// current stroke width, inserting a large number of redundant points and then randomly offsetting each one by a small amount. The result is a path that, when
@@ -1100,7 +667,8 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 
 		// randomise the positions of the points
 
-		newPath = [newPath bezierPathByRandomisingPoints:amount];
+		newPath = [newPath bezierPathByRandomisingPoints:amount
+											 randomState:rng];
 	}
 
 	return newPath; //[newPath bezierPathByUnflatteningPath];
@@ -1184,55 +752,7 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 	if (zag <= 0)
 		return self;
 
-	CGFloat len, t = 0.0, slope;
-	NSPoint zp, np;
-	NSBezierPath* newPath;
-	BOOL side = 0; // are we zigging or zagging?
-	BOOL doneFirst = NO;
-
-	len = [self length];
-	newPath = [NSBezierPath bezierPath];
-	[newPath moveToPoint:[self firstPoint]];
-	[newPath setWindingRule:[self windingRule]];
-
-	while (t < len) {
-		if ((t + zig) > len) {
-			if ([self isPathClosed])
-				zp = [self pointOnPathAtLength:0.0
-										 slope:&slope];
-			else
-				zp = [self pointOnPathAtLength:len
-										 slope:&slope];
-		} else
-			zp = [self pointOnPathAtLength:t
-									 slope:&slope];
-
-		// calculate position of corner offset from the path
-
-		if (side)
-			slope += (M_PI_2);
-		else
-			slope -= (M_PI_2);
-
-		side = !side;
-
-		np.x = zp.x + (cos(slope) * zag);
-		np.y = zp.y + (sin(slope) * zag);
-
-		if (doneFirst)
-			[newPath lineToPoint:np];
-		else {
-			[newPath moveToPoint:np];
-			doneFirst = YES;
-		}
-
-		t += zig;
-	}
-
-	if ([self isPathClosed])
-		[newPath closePath];
-
-	return newPath;
+	return wavePath(self, zig, zag, 0.0);
 }
 
 - (NSBezierPath*)bezierPathWithWavelength:(CGFloat)lambda amplitude:(CGFloat)amp spread:(CGFloat)spread
@@ -1253,86 +773,56 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 	if (spread <= 0.0)
 		return [self bezierPathWithZig:lambda
 								   zag:amp];
-	else {
-		CGFloat len, t = 0.0, slope, rad, lastSlope;
-		NSPoint zp, np, cp1, cp2;
-		NSBezierPath* newPath;
-		BOOL side = 0; // are we zigging or zagging?
-		BOOL doneFirst = NO;
-
-		len = [self length];
-		newPath = [NSBezierPath bezierPath];
-		[newPath moveToPoint:[self firstPoint]];
-		[newPath setWindingRule:[self windingRule]];
-
-		rad = amp * spread;
-
-		//NSLog(@"rad = %f", rad);
 
-		lastSlope = [self slopeStartingPath];
-
-		while (t <= len) {
-			if ((t + lambda) > len) {
-				if ([self isPathClosed]) {
-					// if we are not in the same phase as the start of the path, need to insert an extra curve segment
-
-					if (side == 1) {
-						t = (t + len) / 2.0;
-						zp = [self pointOnPathAtLength:t
-												 slope:&slope];
-						lambda = MAX(1, len - t);
-					} else
-						zp = [self pointOnPathAtLength:0.0
-												 slope:&slope];
-				} else
-					zp = [self pointOnPathAtLength:len
-											 slope:&slope];
-			} else
-				zp = [self pointOnPathAtLength:t
-										 slope:&slope];
-
-			// calculate position of peak offset from the path
-
-			CGFloat slp = slope;
-
-			if (side)
-				slp += (M_PI / 2.0);
-			else
-				slp -= (M_PI / 2.0);
-
-			side = !side;
-
-			np.x = zp.x + (cos(slp) * amp);
-			np.y = zp.y + (sin(slp) * amp);
-
-			// calculate the control points
-
-			cp1 = [newPath currentPoint];
-			cp1.x += cos(lastSlope) * rad;
-			cp1.y += sin(lastSlope) * rad;
+	return wavePath(self, lambda, amp, spread);
+}
 
-			cp2 = np;
-			cp2.x += cos(slope - M_PI) * rad;
-			cp2.y += sin(slope - M_PI) * rad;
+- (NSBezierPath*)cachedBezierPathWithWavelength:(CGFloat)lambda amplitude:(CGFloat)amp spread:(CGFloat)spread
+{
+	// a stroke or fill redraws the same path with the same wave over and over, so the result is worth keeping. Each entry costs its element
+	// count, so a few huge paths can't push out everything else.
 
-			if (doneFirst)
-				[newPath curveToPoint:np
-						controlPoint1:cp1
-						controlPoint2:cp2];
-			else {
-				[newPath moveToPoint:np];
-				doneFirst = YES;
-			}
+	static NSCache* sWaveCache = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sWaveCache = [[NSCache alloc] init];
+		[sWaveCache setCountLimit:256];
+		[sWaveCache setTotalCostLimit:1 << 20];
+	});
 
-			lastSlope = slope;
-			t += lambda;
-		}
+	if (amp <= 0)
+		return self;
 
-		if ([self isPathClosed]) {
-			[newPath closePath];
-		}
-		return newPath;
+	struct {
+		NSUInteger checksum;
+		NSInteger elementCount;
+		CGFloat lambda, amp, spread;
+	} keyBytes;
+
+	// zero the padding, if any, so equal keys are equal bytes
+
+	memset(&keyBytes, 0, sizeof(keyBytes));
+	keyBytes.checksum = [self checksum];
+	keyBytes.elementCount = [self elementCount];
+	keyBytes.lambda = lambda;
+	keyBytes.amp = amp;
+	keyBytes.spread = MAX(0.0, spread);
+
+	NSData* key = [NSData dataWithBytes:&keyBytes
+								 length:sizeof(keyBytes)];
+	NSBezierPath* wave = [sWaveCache objectForKey:key];
+
+	if (wave == nil) {
+		wave = [[self bezierPathWithWavelength:lambda
+									 amplitude:amp
+										spread:spread] copy];
+		[sWaveCache setObject:wave
+					   forKey:key
+						 cost:(NSUInteger)[wave elementCount]];
+		[wave autorelease];
 	}
+
+	return wave;
 }
 
 #pragma mark -
@@ -1340,7 +830,18 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 - (NSBezierPath*)strokedPath
 {
 	// returns a path representing the stroked edge of the receiver, taking into account its current width and other
-	// stroke settings. This works by converting to a quartz path and using the similar system function there.
+	// stroke settings. Undashed paths are outlined by the offset engine directly; dashed paths are converted to a quartz path
+	// and use the similar system function there, which applies the dash.
+
+	NSInteger dashCount = 0;
+
+	[self getLineDash:NULL
+				count:&dashCount
+				phase:NULL];
+
+	if (dashCount == 0)
+		return [self strokedPathWithStartingWidth:[self lineWidth]
+									  endingWidth:[self lineWidth]];
 
 	// this creates an offscreen graphics context to support the CG function used, but the context itself does not
 	// need to actually draw anything, therefore a simple 1x1 bitmap is used and reused for this context.
@@ -1393,6 +894,18 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 	return newPath;
 }
 
+- (NSBezierPath*)strokedPathWithStartingWidth:(CGFloat)width1 endingWidth:(CGFloat)width2
+{
+	DKFlatPath* fp = [DKFlatPath flatPathWithBezierPath:self];
+
+	return [[fp strokeOutlineWithStartWidth:width1
+								   endWidth:width2
+							  lineJoinStyle:[self lineJoinStyle]
+							   lineCapStyle:[self lineCapStyle]
+								 miterLimit:[self miterLimit]
+								  tolerance:[self flatness]] bezierPath];
+}
+
 #pragma mark -
 #pragma mark - breaking a path apart
 
@@ -1724,7 +1237,7 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 			NSPoint left[4], right[4];
 			subdivideBezierAtT(ap, left, right, t);
 
-			CGFloat bd = lengthOfBezier(left, 0.1);
+			CGFloat bd = DKLengthOfBezier(left, 0.1);
 			distance += bd;
 		} else if (et == NSLineToBezierPathElement) {
 			NSPoint ip = Interpolate(ap[0], ap[1], t);
@@ -1808,31 +1321,6 @@ static void ConvertPathApplierFunction(void* info, const CGPathElement* element)
 
 #pragma mark -
 
-inline static void subdivideBezier(const NSPoint bez[4], NSPoint bez1[4], NSPoint bez2[4])
-{
-	NSPoint q;
-
-	bez1[0].x = bez[0].x;
-	bez1[0].y = bez[0].y;
-	bez2[3].x = bez[3].x;
-	bez2[3].y = bez[3].y;
-
-	q.x = (bez[1].x + bez[2].x) / 2.0;
-	q.y = (bez[1].y + bez[2].y) / 2.0;
-	bez1[1].x = (bez[0].x + bez[1].x) / 2.0;
-	bez1[1].y = (bez[0].y + bez[1].y) / 2.0;
-	bez2[2].x = (bez[2].x + bez[3].x) / 2.0;
-	bez2[2].y = (bez[2].y + bez[3].y) / 2.0;
-
-	bez1[2].x = (bez1[1].x + q.x) / 2.0;
-	bez1[2].y = (bez1[1].y + q.y) / 2.0;
-	bez2[1].x = (q.x + bez2[2].x) / 2.0;
-	bez2[1].y = (q.y + bez2[2].y) / 2.0;
-
-	bez1[3].x = bez2[0].x = (bez1[2].x + bez2[1].x) / 2.0;
-	bez1[3].y = bez2[0].y = (bez1[2].y + bez2[1].y) / 2.0;
-}
-
 inline void subdivideBezierAtT(const NSPoint bez[4], NSPoint bez1[4], NSPoint bez2[4], CGFloat t)
 {
 	NSPoint q;
@@ -1865,66 +1353,111 @@ static inline CGFloat distanceBetween(NSPoint a, NSPoint b)
 	return hypot(a.x - b.x, a.y - b.y);
 }
 
-// Length of a curve
-static CGFloat lengthOfBezier(const NSPoint bez[4],
-	CGFloat acceptableError)
+#pragma mark -
+
+static NSBezierPath* wavePath(NSBezierPath* path, CGFloat lambda, CGFloat amp, CGFloat spread)
 {
-	CGFloat polyLen = 0.0;
-	CGFloat chordLen = distanceBetween(bez[0], bez[3]);
-	CGFloat retLen, errLen;
-	NSUInteger n;
+	// builds both kinds of path. The distances of the peaks are worked out first, exactly as stepping along the path one peak at a time
+	// would find them, then all of them are located in a single pass over the path. A spread of 0 joins the peaks with lines, otherwise
+	// with curves whose control points lie along the path's direction at each peak.
 
-	for (n = 0; n < 3; ++n)
-		polyLen += distanceBetween(bez[n], bez[n + 1]);
+	DKFlatPath* fp = [DKFlatPath flatPathWithBezierPath:path];
+	CGFloat len = [fp lengthWithMaximumError:DEFAULT_TRIM_EPSILON];
+	BOOL closed = [path isPathClosed];
+	CGFloat maxCount = floor(len / lambda) + 4;
 
-	errLen = polyLen - chordLen;
+	if (maxCount > NSIntegerMax / sizeof(NSPoint))
+		return path;
 
-	if (errLen > acceptableError) {
-		NSPoint left[4], right[4];
-		subdivideBezier(bez, left, right);
-		retLen = (lengthOfBezier(left, acceptableError)
-			+ lengthOfBezier(right, acceptableError));
+	NSUInteger capacity = (NSUInteger)maxCount;
+	CGFloat* distances = malloc(capacity * sizeof(CGFloat));
+	CGFloat* slopes = malloc(capacity * sizeof(CGFloat));
+	NSPoint* points = malloc(capacity * sizeof(NSPoint));
+	NSUInteger count = 0, i;
+	CGFloat t = 0.0, step = lambda;
+	BOOL side = NO;
+
+	if (spread <= 0.0) {
+		while (t < len && count < capacity) {
+			distances[count++] = ((t + step) > len) ? (closed ? 0.0 : len) : t;
+			t += step;
+		}
 	} else {
-		retLen = 0.5 * (polyLen + chordLen);
+		while (t <= len && count < capacity) {
+			if ((t + step) > len) {
+				if (closed) {
+					// if we are not in the same phase as the start of the path, need to insert an extra curve segment
+
+					if (side) {
+						t = (t + len) / 2.0;
+						distances[count++] = t;
+						step = MAX(1, len - t);
+					} else
+						distances[count++] = 0.0;
+				} else
+					distances[count++] = len;
+			} else
+				distances[count++] = t;
+
+			side = !side;
+			t += step;
+		}
 	}
 
-	return retLen;
-}
+	[fp getPoints:points
+			   slopes:slopes
+		  atDistances:distances
+				count:count
+		 maximumError:DEFAULT_TRIM_EPSILON];
 
-// Split a curve at a specific length
-static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
-	NSPoint bez1[4],
-	NSPoint bez2[4],
-	CGFloat length,
-	CGFloat acceptableError)
-{
-	CGFloat top = 1.0, bottom = 0.0;
-	CGFloat t, prevT;
+	DKFlatPath* newPath = [[DKFlatPath alloc] initWithElementCapacity:count + 2];
+	CGFloat rad = amp * spread;
+	NSPoint np, prev = NSZeroPoint;
 
-	prevT = t = 0.5;
-	for (;;) {
-		CGFloat len1;
+	[newPath setWindingRule:[path windingRule]];
 
-		subdivideBezierAtT(bez, bez1, bez2, t);
+	for (i = 0; i < count; ++i) {
+		// calculate position of peak offset from the path, alternating sides
 
-		len1 = lengthOfBezier(bez1, 0.5 * acceptableError);
+		CGFloat slp = (i & 1) ? slopes[i] + M_PI_2 : slopes[i] - M_PI_2;
 
-		if (fabs(length - len1) < acceptableError)
-			return len1;
+		np.x = points[i].x + (cos(slp) * amp);
+		np.y = points[i].y + (sin(slp) * amp);
 
-		if (length > len1) {
-			bottom = t;
-			t = 0.5 * (t + top);
-		} else if (length < len1) {
-			top = t;
-			t = 0.5 * (bottom + t);
-		}
+		if (i == 0)
+			[newPath moveToPoint:np];
+		else if (spread <= 0.0)
+			[newPath lineToPoint:np];
+		else {
+			NSPoint cp1, cp2;
 
-		if (t == prevT)
-			return len1;
+			cp1.x = prev.x + cos(slopes[i - 1]) * rad;
+			cp1.y = prev.y + sin(slopes[i - 1]) * rad;
+			cp2.x = np.x + cos(slopes[i] - M_PI) * rad;
+			cp2.y = np.y + sin(slopes[i] - M_PI) * rad;
 
-		prevT = t;
+			[newPath curveToPoint:np
+					controlPoint1:cp1
+					controlPoint2:cp2];
+		}
+
+		prev = np;
 	}
+
+	if (count == 0)
+		[newPath moveToPoint:[path firstPoint]];
+
+	if (closed)
+		[newPath closePath];
+
+	free(distances);
+	free(slopes);
+	free(points);
+
+	NSBezierPath* result = [newPath bezierPath];
+	[newPath release];
+
+	return result;
 }
 
 #pragma mark -
@@ -1985,7 +1518,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 			ap[0] = pp[0];
 
 		if (element == NSCurveToBezierPathElement)
-			return lengthOfBezier(ap, 0.1);
+			return DKLengthOfBezier(ap, 0.1);
 		else if (element == NSLineToBezierPathElement)
 			return distanceBetween(ap[1], ap[0]);
 		else if (element == NSClosePathBezierPathElement) {
@@ -1999,25 +1532,25 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 - (CGFloat)lengthOfPathFromElement:(NSInteger)startElement toElement:(NSInteger)endElement
 {
+	DKFlatPath* fp = [DKFlatPath flatPathWithBezierPath:self];
 	NSInteger i;
 	CGFloat d = 0.0;
 
 	if (startElement < 0)
 		startElement = 0;
 
-	if (endElement >= [self elementCount])
-		endElement = [self elementCount] - 1;
+	if (endElement >= (NSInteger)[fp elementCount])
+		endElement = [fp elementCount] - 1;
 
 	for (i = startElement; i <= endElement; ++i)
-		d += [self lengthOfElement:i];
+		d += [fp lengthOfElement:i
+					maximumError:0.1];
 
 	return d;
 }
 
 #pragma mark -
 
-#define DEFAULT_TRIM_EPSILON 0.1
-
 // Convenience method
 
 - (NSBezierPath*)bezierPathByTrimmingToLength:(CGFloat)trimLength
@@ -2030,86 +1563,13 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
    of this NSBezierPath. */
 - (NSBezierPath*)bezierPathByTrimmingToLength:(CGFloat)trimLength withMaximumError:(CGFloat)maxError
 {
-	if (trimLength >= [self length])
-		return self;
-
-	NSBezierPath* newPath = [NSBezierPath bezierPath];
-	NSInteger elements = [self elementCount];
-	NSInteger n;
-	CGFloat length = 0.0;
-	NSPoint pointForClose = NSMakePoint(0.0, 0.0);
-	NSPoint lastPoint = NSMakePoint(0.0, 0.0);
-
-	for (n = 0; n < elements; ++n) {
-		NSPoint points[3];
-		NSBezierPathElement element = [self elementAtIndex:n
-										  associatedPoints:points];
-		CGFloat elementLength;
-		CGFloat remainingLength = trimLength - length;
-
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			[newPath moveToPoint:points[0]];
-			pointForClose = lastPoint = points[0];
-			continue;
-
-		case NSLineToBezierPathElement:
-			elementLength = distanceBetween(lastPoint, points[0]);
-
-			if (length + elementLength <= trimLength)
-				[newPath lineToPoint:points[0]];
-			else {
-				CGFloat f = remainingLength / elementLength;
-				[newPath lineToPoint:NSMakePoint(lastPoint.x + f * (points[0].x - lastPoint.x), lastPoint.y + f * (points[0].y - lastPoint.y))];
-				return newPath;
-			}
-
-			length += elementLength;
-			lastPoint = points[0];
-			break;
+	DKFlatPath* fp = [DKFlatPath flatPathWithBezierPath:self];
 
-		case NSCurveToBezierPathElement: {
-			NSPoint bezier[4] = { lastPoint, points[0], points[1], points[2] };
-			elementLength = lengthOfBezier(bezier, maxError);
-
-			if (length + elementLength <= trimLength)
-				[newPath curveToPoint:points[2]
-						controlPoint1:points[0]
-						controlPoint2:points[1]];
-			else {
-				NSPoint bez1[4], bez2[4];
-				subdivideBezierAtLength(bezier, bez1, bez2, remainingLength, maxError);
-				[newPath curveToPoint:bez1[3]
-						controlPoint1:bez1[1]
-						controlPoint2:bez1[2]];
-				return newPath;
-			}
-
-			length += elementLength;
-			lastPoint = points[2];
-			break;
-		}
-
-		case NSClosePathBezierPathElement:
-			elementLength = distanceBetween(lastPoint, pointForClose);
-
-			if (length + elementLength <= trimLength) {
-				[newPath closePath];
-			} else {
-				CGFloat f = remainingLength / elementLength;
-				[newPath lineToPoint:NSMakePoint(lastPoint.x + f * (pointForClose.x - lastPoint.x), lastPoint.y + f * (pointForClose.y - lastPoint.y))];
-				return newPath;
-			}
-
-			length += elementLength;
-			lastPoint = pointForClose;
-			break;
+	if (trimLength >= [fp lengthWithMaximumError:DEFAULT_TRIM_EPSILON])
+		return self;
 
-		default:
-			break;
-		}
-	}
-	return newPath;
+	return [[fp flatPathByTrimmingToLength:trimLength
+							  maximumError:maxError] bezierPath];
 }
 
 // Convenience method
@@ -2124,85 +1584,8 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 	if (trimLength <= 0)
 		return self;
 
-	NSBezierPath* newPath = [NSBezierPath bezierPath];
-	NSInteger elements = [self elementCount];
-	NSInteger n;
-	CGFloat length = 0.0;
-	NSPoint pointForClose = NSMakePoint(0.0, 0.0);
-	NSPoint lastPoint = NSMakePoint(0.0, 0.0);
-
-	for (n = 0; n < elements; ++n) {
-		NSPoint points[3];
-		NSBezierPathElement element = [self elementAtIndex:n
-										  associatedPoints:points];
-		CGFloat elementLength;
-		CGFloat remainingLength = trimLength - length;
-
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			if (length > trimLength)
-				[newPath moveToPoint:points[0]];
-			pointForClose = lastPoint = points[0];
-			continue;
-
-		case NSLineToBezierPathElement:
-			elementLength = distanceBetween(lastPoint, points[0]);
-
-			if (length > trimLength)
-				[newPath lineToPoint:points[0]];
-			else if (length + elementLength > trimLength) {
-				CGFloat f = remainingLength / elementLength;
-				[newPath moveToPoint:NSMakePoint(lastPoint.x + f * (points[0].x - lastPoint.x), lastPoint.y + f * (points[0].y - lastPoint.y))];
-				[newPath lineToPoint:points[0]];
-			}
-
-			length += elementLength;
-			lastPoint = points[0];
-			break;
-
-		case NSCurveToBezierPathElement: {
-			NSPoint bezier[4] = { lastPoint, points[0], points[1], points[2] };
-			elementLength = lengthOfBezier(bezier, maxError);
-
-			if (length > trimLength)
-				[newPath curveToPoint:points[2]
-						controlPoint1:points[0]
-						controlPoint2:points[1]];
-			else if (length + elementLength > trimLength) {
-				NSPoint bez1[4], bez2[4];
-				subdivideBezierAtLength(bezier, bez1, bez2, remainingLength, maxError);
-				[newPath moveToPoint:bez2[0]];
-				[newPath curveToPoint:bez2[3]
-						controlPoint1:bez2[1]
-						controlPoint2:bez2[2]];
-			}
-
-			length += elementLength;
-			lastPoint = points[2];
-			break;
-		}
-
-		case NSClosePathBezierPathElement:
-			elementLength = distanceBetween(lastPoint, pointForClose);
-
-			if (length > trimLength) {
-				[newPath lineToPoint:pointForClose];
-				[newPath closePath];
-			} else if (length + elementLength > trimLength) {
-				CGFloat f = remainingLength / elementLength;
-				[newPath moveToPoint:NSMakePoint(lastPoint.x + f * (points[0].x - lastPoint.x), lastPoint.y + f * (points[0].y - lastPoint.y))];
-				[newPath lineToPoint:points[0]];
-			}
-
-			length += elementLength;
-			lastPoint = pointForClose;
-			break;
-
-		default:
-			break;
-		}
-	}
-	return newPath;
+	return [[[DKFlatPath flatPathWithBezierPath:self] flatPathByTrimmingFromLength:trimLength
+																	  maximumError:maxError] bezierPath];
 }
 
 - (NSBezierPath*)bezierPathByTrimmingFromBothEnds:(CGFloat)trimLength
@@ -2248,10 +1631,19 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 - (NSBezierPath*)bezierPathByTrimmingFromLength:(CGFloat)startLength toLength:(CGFloat)newLength withMaximumError:(CGFloat)maxError
 {
-	NSBezierPath* temp = [self bezierPathByTrimmingFromLength:startLength
-											 withMaximumError:maxError];
-	return [temp bezierPathByTrimmingToLength:newLength
-							 withMaximumError:maxError];
+	// trims both ends without going back to an NSBezierPath in between
+
+	DKFlatPath* temp = [DKFlatPath flatPathWithBezierPath:self];
+
+	if (startLength > 0)
+		temp = [temp flatPathByTrimmingFromLength:startLength
+									 maximumError:maxError];
+
+	if (newLength >= [temp lengthWithMaximumError:DEFAULT_TRIM_EPSILON])
+		return (startLength > 0) ? [temp bezierPath] : self;
+
+	return [[temp flatPathByTrimmingToLength:newLength
+								maximumError:maxError] bezierPath];
 }
 
 #pragma mark -
@@ -2349,45 +1741,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 - (CGFloat)lengthWithMaximumError:(CGFloat)maxError
 {
-	NSInteger elements = [self elementCount];
-	NSInteger n;
-	CGFloat length = 0.0;
-	NSPoint pointForClose = NSMakePoint(0.0, 0.0);
-	NSPoint lastPoint = NSMakePoint(0.0, 0.0);
-
-	for (n = 0; n < elements; ++n) {
-		NSPoint points[3];
-		NSBezierPathElement element = [self elementAtIndex:n
-										  associatedPoints:points];
-
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			pointForClose = lastPoint = points[0];
-			break;
-
-		case NSLineToBezierPathElement:
-			length += distanceBetween(lastPoint, points[0]);
-			lastPoint = points[0];
-			break;
-
-		case NSCurveToBezierPathElement: {
-			NSPoint bezier[4] = { lastPoint, points[0], points[1], points[2] };
-			length += lengthOfBezier(bezier, maxError);
-			lastPoint = points[2];
-			break;
-		}
-
-		case NSClosePathBezierPathElement:
-			length += distanceBetween(lastPoint, pointForClose);
-			lastPoint = pointForClose;
-			break;
-
-		default:
-			break;
-		}
-	}
-
-	return length;
+	return [[DKFlatPath flatPathWithBezierPath:self] lengthWithMaximumError:maxError];
 }
 
 @end
@@ -18,8 +18,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** @brief Returns a layout manager used for text on path layout.
 
- This shared layout manager is used by text on path drawing unless a specific manager is passed.
- @return a shared layout manager instance */
+ This shared layout manager is used by text on path drawing unless a specific manager is passed. Each thread has its own.
+ @return the calling thread's layout manager instance */
 @property (class, readonly, retain) NSLayoutManager* textOnPathLayoutManager;
 
 /** @brief The attributes used to draw strings on paths.
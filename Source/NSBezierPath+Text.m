@@ -37,9 +37,11 @@ static NSString* kDKTextOnPathTextFittedCacheKey = @"DKTextOnPathTextFitted";
  @return a shared layout manager instance */
 + (NSLayoutManager*)textOnPathLayoutManager
 {
-	// returns a layout manager instance which is used for all text on path layout tasks. Reusing this shared instance saves a little time and memory
+	// returns a layout manager instance which is used for all text on path layout tasks on the calling thread. Reusing this shared instance
+	// saves a little time and memory; keeping one per thread lets text be laid out on several threads at once.
 
-	static NSLayoutManager* topLayoutMgr = nil;
+	NSMutableDictionary* threadDict = [[NSThread currentThread] threadDictionary];
+	NSLayoutManager* topLayoutMgr = [threadDict objectForKey:@"DKTextOnPathLayoutManager"];
 
 	if (topLayoutMgr == nil) {
 		topLayoutMgr = [[NSLayoutManager alloc] init];
@@ -47,6 +49,8 @@ static NSString* kDKTextOnPathTextFittedCacheKey = @"DKTextOnPathTextFitted";
 		[topLayoutMgr addTextContainer:tc];
 
 		[topLayoutMgr setUsesScreenFonts:NO];
+		[threadDict setObject:topLayoutMgr
+					   forKey:@"DKTextOnPathLayoutManager"];
 	}
 
 	return topLayoutMgr;
@@ -9,7 +9,7 @@
 
 #import <Cocoa/Cocoa.h>
 
-@class NSCountedSet, NSDictionary, NSMutableDictionary;
+@class NSCountedSet, NSDictionary, NSMutableDictionary, DKFlatPath;
 
 //#define	DEBUGGING_CURVE_INTERSECTIONS  0
 
@@ -77,6 +77,8 @@ void splitBezierCurveTo(const NSPoint* c, CGFloat t, NSPoint* l, NSPoint* r);
 - (NSCountedSet*)countedSetOfEncodedStrokeSegments;
 
 - (BOOL)intersectsRect:(NSRect)rect;
+// As -intersectsRect:, walking <flatPath>, which must be a flat copy of the receiver, so that testing many rects against one path flattens it only once. If nil, a flat copy is made.
+- (BOOL)intersectsRect:(NSRect)rect flatPath:(DKFlatPath*)flatPath;
 - (BOOL)intersectionWithLine:(NSPoint*)result lineStart:(NSPoint)lineStart lineEnd:(NSPoint)lineEnd;
 
 // Returns the first intersection with the given line (that is, the intersection closest to the start of the receiver's bezier path).
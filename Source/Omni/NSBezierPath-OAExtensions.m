@@ -7,6 +7,7 @@
 
 #import "NSBezierPath-OAExtensions.h"
 #import "NSBezierPath-OAInternal.h"
+#import "DKFlatPath.h"
 
 #import <AppKit/AppKit.h>
 //#import <OmniBase/OmniBase.h>
@@ -200,32 +201,41 @@ static struct pointInfo getLinePoint(const NSPoint* a, CGFloat position)
 
 //
 
-- (BOOL)intersectsRect:(NSRect)rect
+// YES if the rects overlap or touch; unlike NSIntersectsRect() a rect with no width or height can still overlap another.
+
+static inline BOOL rectsOverlap(NSRect a, NSRect b)
 {
-	NSInteger count = [self elementCount];
+	return NSMinX(a) <= NSMaxX(b) && NSMinX(b) <= NSMaxX(a) && NSMinY(a) <= NSMaxY(b) && NSMinY(b) <= NSMaxY(a);
+}
+
+static BOOL flatPathIntersectsRect(DKFlatPath* fp, NSRect rect, CGFloat tolerance)
+{
+	NSInteger count = [fp elementCount];
 	NSInteger i;
-	NSPoint points[3];
+	const NSBezierPathElement* elements = [fp elementTypes];
+	const NSUInteger* pointIndexes = [fp pointIndexes];
+	const NSPoint* points;
 	NSPoint startPoint;
 	NSPoint currentPoint;
 	NSPoint line[2];
 	NSPoint curve[4];
-	NSInteger element;
 	BOOL needANewStartPoint;
 
 	if (count == 0)
 		return NO;
 
-	element = [self elementAtIndex:0 associatedPoints:points];
-	if (element != NSMoveToBezierPathElement) {
+	if (elements[0] != NSMoveToBezierPathElement) {
 		return NO; // must start with a moveTo
 	}
 
-	startPoint = currentPoint = points[0];
+	startPoint = currentPoint = [fp points][0];
 	needANewStartPoint = NO;
 
+	// returns at the first segment found to intersect
+
 	for (i = 1; i < count; i++) {
-		element = [self elementAtIndex:i associatedPoints:points];
-		switch (element) {
+		points = [fp points] + pointIndexes[i];
+		switch (elements[i]) {
 		case NSMoveToBezierPathElement:
 			currentPoint = points[0];
 			if (needANewStartPoint) {
@@ -250,7 +260,7 @@ static struct pointInfo getLinePoint(const NSPoint* a, CGFloat position)
 			break;
 		case NSCurveToBezierPathElement: {
 			_parameterizeCurve(curve, currentPoint, points[2], points[0], points[1]);
-			if (_curvedLineIntersectsRect(curve, rect, [self lineWidth] + 1)) {
+			if (_curvedLineIntersectsRect(curve, rect, tolerance)) {
 				return YES;
 			}
 			currentPoint = points[2];
@@ -265,6 +275,36 @@ static struct pointInfo getLinePoint(const NSPoint* a, CGFloat position)
 	return NO;
 }
 
+- (BOOL)intersectsRect:(NSRect)rect
+{
+	return [self intersectsRect:rect
+					   flatPath:nil];
+}
+
+- (BOOL)intersectsRect:(NSRect)rect flatPath:(DKFlatPath*)flatPath
+{
+	// the control point bounds are kept by the path, so a rect well away from the path is rejected without looking at its elements.
+	// No segment can reach further from them than the tolerance used for curves.
+
+	CGFloat tolerance = [self lineWidth] + 1;
+	NSRect cpb = [self controlPointBounds];
+
+	if ([self isEmpty] || !rectsOverlap(rect, NSInsetRect(cpb, -tolerance, -tolerance)))
+		return NO;
+
+	// a path entirely inside the rect intersects it at its first segment, provided it has one
+
+	if ([self elementAtIndex:[self elementCount] - 1] != NSMoveToBezierPathElement && NSMinX(cpb) >= NSMinX(rect) && NSMaxX(cpb) < NSMaxX(rect) && NSMinY(cpb) >= NSMinY(rect) && NSMaxY(cpb) < NSMaxY(rect))
+		return YES;
+
+	// walks a flat copy of the path rather than fetching each element in turn
+
+	if (flatPath == nil)
+		flatPath = [DKFlatPath flatPathWithBezierPath:self];
+
+	return flatPathIntersectsRect(flatPath, rect, tolerance);
+}
+
 static void copyIntersection(OABezierPathIntersection* buf, const struct intersectionInfo* info, NSInteger leftSegment, NSInteger rightSegment)
 {
 	buf->left.segment = leftSegment;
@@ -3295,36 +3335,41 @@ static BOOL _curvedLineIntersectsRect(const NSPoint* c, NSRect rect, CGFloat tol
 
 - (NSInteger)_segmentHitByPoint:(NSPoint)point position:(CGFloat*)position padding:(CGFloat)padding
 {
-	NSInteger count = [self elementCount];
+	// a point further from the control point bounds than any segment's tolerance can't hit, so is rejected before the path is
+	// flattened. Curves are tested against their bounds outset by 1, lines to within the padding plus half the line width.
+
+	CGFloat reach = MAX(padding + [self lineWidth] / 2, 1) + 1;
+
+	if ([self isEmpty] || !NSPointInRect(point, NSInsetRect([self controlPointBounds], -reach, -reach)))
+		return 0;
+
+	// walks a flat copy of the path rather than fetching each element in turn
+
+	DKFlatPath* fp = [DKFlatPath flatPathWithBezierPath:self];
+	NSInteger count = [fp elementCount];
 	NSInteger i;
-	NSPoint points[3];
+	const NSBezierPathElement* elements = [fp elementTypes];
+	const NSUInteger* pointIndexes = [fp pointIndexes];
+	const NSPoint* points;
 	NSPoint startPoint;
 	NSPoint currentPoint;
-	NSInteger element;
 	BOOL needANewStartPoint;
 
 	if (count == 0)
 		return 0;
 
-	element = [self elementAtIndex:0 associatedPoints:points];
-	if (element != NSMoveToBezierPathElement) {
+	if (elements[0] != NSMoveToBezierPathElement) {
 		return 0; // must start with a moveTo
 	}
 
-	startPoint = currentPoint = points[0];
+	startPoint = currentPoint = [fp points][0];
 	needANewStartPoint = NO;
 
+	// returns the first segment hit
+
 	for (i = 1; i < count; ++i) {
-		element = [self elementAtIndex:i associatedPoints:points];
-		/*
-        if (NSEqualPoints(points[0], point)) {
-            if (i==0) {
-                i = 1;
-            }
-            return i;
-        }
-        */
-		switch (element) {
+		points = [fp points] + pointIndexes[i];
+		switch (elements[i]) {
 		case NSMoveToBezierPathElement:
 			currentPoint = points[0];
 			if (needANewStartPoint) {
@@ -3353,7 +3398,6 @@ static BOOL _curvedLineIntersectsRect(const NSPoint* c, NSRect rect, CGFloat tol
 
 			if (NSPointInRect(point, NSInsetRect(cbr, -1, -1))) {
 				if ([self _curvedLineHit:point startPoint:currentPoint endPoint:points[2] controlPoint1:points[0] controlPoint2:points[1] position:position padding:padding]) {
-					//NSLog(@"curve segemnt hit: %d, position: %f", i, *position );
 					return i;
 				}
 			}
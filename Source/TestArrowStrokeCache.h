@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKArrowStroke.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for cached arrow and dimension line geometry.
+
+ Checks that an unchanged object reuses its arrow, that the cached arrow is the same as one built afresh, that changing the path,
+ the stroke or the dimension text rebuilds it, and times redrawing 10,000 dimension lines with and without their cached arrows.
+*/
+@interface TestArrowStrokeCache : XCTestCase
+
+- (void)testArrowIsReused;
+- (void)testCachedArrowMatchesBuiltArrow;
+- (void)testArrowRebuiltOnChange;
+- (void)testPerformanceOfCachedDimensionLines;
+- (void)testPerformanceOfUncachedDimensionLines;
+
+@end
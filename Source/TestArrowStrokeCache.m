@@ -0,0 +1,188 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestArrowStrokeCache.h"
+#import <DKDrawKit/DKDrawablePath.h>
+#import <DKDrawKit/NSBezierPath+Editing.h>
+
+#define BITMAP_SIZE 512
+#define LINE_COUNT 10000
+
+@interface TestArrowStrokeCache ()
+
+- (DKArrowStroke*)dimensionStroke;
+- (DKDrawablePath*)lineFrom:(NSPoint)a to:(NSPoint)b;
+- (NSArray<DKDrawablePath*>*)manyLines;
+- (void)renderLines:(NSArray<DKDrawablePath*>*)lines withStroke:(DKArrowStroke*)stroke invalidating:(BOOL)invalidate;
+
+@end
+
+@implementation TestArrowStrokeCache
+
+- (DKArrowStroke*)dimensionStroke
+{
+	DKArrowStroke* stroke = [[DKArrowStroke standardDimensioningLine] copy];
+
+	[stroke setArrowHeadAtStart:kDKArrowHeadDimensionLineAndBar];
+	[stroke setArrowHeadAtEnd:kDKArrowHeadDimensionLineAndBar];
+
+	return stroke;
+}
+
+- (DKDrawablePath*)lineFrom:(NSPoint)a to:(NSPoint)b
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:a];
+	[path lineToPoint:b];
+
+	return [DKDrawablePath drawablePathWithBezierPath:path];
+}
+
+- (NSArray<DKDrawablePath*>*)manyLines
+{
+	NSMutableArray<DKDrawablePath*>* lines = [NSMutableArray arrayWithCapacity:LINE_COUNT];
+
+	for (NSUInteger i = 0; i < LINE_COUNT; ++i) {
+		CGFloat y = 10 + (i % 100) * 5;
+		CGFloat x = 10 + (i / 100) * 5;
+
+		[lines addObject:[self lineFrom:NSMakePoint(x, y)
+									 to:NSMakePoint(x + 60 + (i % 7) * 10, y + (i % 5) * 8)]];
+	}
+
+	return lines;
+}
+
+- (void)renderLines:(NSArray<DKDrawablePath*>*)lines withStroke:(DKArrowStroke*)stroke invalidating:(BOOL)invalidate
+{
+	NSBitmapImageRep* bitmap = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	   pixelsWide:BITMAP_SIZE
+																	   pixelsHigh:BITMAP_SIZE
+																	bitsPerSample:8
+																  samplesPerPixel:4
+																		 hasAlpha:YES
+																		 isPlanar:NO
+																   colorSpaceName:NSCalibratedRGBColorSpace
+																	  bytesPerRow:0
+																	 bitsPerPixel:0];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+
+	for (DKDrawablePath* line in lines) {
+		if (invalidate)
+			[line invalidateRenderingCache];
+
+		[stroke render:line];
+	}
+
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (void)testArrowIsReused
+{
+	DKArrowStroke* stroke = [self dimensionStroke];
+	DKDrawablePath* line = [self lineFrom:NSMakePoint(10, 10)
+									   to:NSMakePoint(200, 80)];
+	NSBezierPath* first = [stroke arrowPathForObject:line];
+
+	XCTAssertNotNil(first, @"a dimension line should have an arrow");
+	XCTAssertTrue([stroke arrowPathForObject:line] == first, @"an unchanged object should reuse its arrow");
+
+	// two strokes drawing the same object keep separate arrows
+
+	DKArrowStroke* other = [self dimensionStroke];
+
+	[other setArrowHeadLength:20];
+
+	NSBezierPath* second = [other arrowPathForObject:line];
+
+	XCTAssertTrue(second != first, @"a different stroke should build its own arrow");
+	XCTAssertTrue([stroke arrowPathForObject:line] == first, @"another stroke's arrow should not replace this one's");
+
+	// entries are keyed by stroke, not by settings, so even an identical copy keeps its own
+
+	DKArrowStroke* copy = [stroke copy];
+
+	XCTAssertNotNil([stroke renderingCacheEntryForObject:line], @"the stroke should have an entry for the line");
+	XCTAssertNil([copy renderingCacheEntryForObject:line], @"a copy of the stroke should not share its entry");
+	XCTAssertTrue([copy arrowPathForObject:line] != first, @"a copy of the stroke should build its own arrow");
+}
+
+- (void)testCachedArrowMatchesBuiltArrow
+{
+	DKArrowStroke* stroke = [self dimensionStroke];
+	DKDrawablePath* line = [self lineFrom:NSMakePoint(30, 200)
+									   to:NSMakePoint(300, 120)];
+
+	[stroke setDimensioningLineOptions:kDKDimensionPlaceInLine];
+
+	NSBezierPath* built = [stroke arrowPathFromOriginalPath:[line renderingPath]
+												 fromObject:line];
+	NSBezierPath* cached = [stroke arrowPathForObject:line];
+
+	XCTAssertEqual([built checksum], [cached checksum], @"the cached arrow differs from one built afresh");
+}
+
+- (void)testArrowRebuiltOnChange
+{
+	DKArrowStroke* stroke = [self dimensionStroke];
+	DKDrawablePath* line = [self lineFrom:NSMakePoint(10, 10)
+									   to:NSMakePoint(200, 80)];
+	NSBezierPath* arrow = [stroke arrowPathForObject:line];
+	NSBezierPath* next;
+
+	[stroke setArrowHeadWidth:[stroke arrowHeadWidth] + 2];
+	next = [stroke arrowPathForObject:line];
+	XCTAssertTrue(next != arrow, @"changing the head width should rebuild the arrow");
+	arrow = next;
+
+	[stroke setDimensionTextKind:kDKDimensionRadius];
+	next = [stroke arrowPathForObject:line];
+	XCTAssertTrue(next != arrow, @"changing the dimension text should rebuild the arrow");
+	arrow = next;
+
+	NSBezierPath* path = [[line path] copy];
+
+	[path lineToPoint:NSMakePoint(250, 80)];
+	[line setPath:path];
+	next = [stroke arrowPathForObject:line];
+	XCTAssertTrue(next != arrow, @"changing the path should rebuild the arrow");
+	XCTAssertEqual([next checksum], [[stroke arrowPathFromOriginalPath:[line renderingPath]
+															fromObject:line] checksum],
+		@"the rebuilt arrow should follow the new path");
+}
+
+- (void)testPerformanceOfCachedDimensionLines
+{
+	DKArrowStroke* stroke = [self dimensionStroke];
+	NSArray<DKDrawablePath*>* lines = [self manyLines];
+
+	[self renderLines:lines
+			withStroke:stroke
+		  invalidating:NO];
+
+	[self measureBlock:^{
+		[self renderLines:lines
+				withStroke:stroke
+			  invalidating:NO];
+	}];
+}
+
+- (void)testPerformanceOfUncachedDimensionLines
+{
+	DKArrowStroke* stroke = [self dimensionStroke];
+	NSArray<DKDrawablePath*>* lines = [self manyLines];
+
+	[self measureBlock:^{
+		[self renderLines:lines
+				withStroke:stroke
+			  invalidating:YES];
+	}];
+}
+
+@end
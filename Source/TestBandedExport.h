@@ -0,0 +1,22 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKDrawing+Export.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for banded bitmap export.
+
+ Exports a tall drawing, which is rendered in several bands, and checks that each object is drawn only for the bands it lies in, and
+ that retained bands are rendered again only when the drawing invalidates them, without a controller attached between exports.
+ Times exporting a tall drawing with many objects as PNG.
+*/
+@interface TestBandedExport : XCTestCase
+
+- (void)testBandsDrawOnlyObjectsTheyContain;
+- (void)testRetainedBandsFollowChanges;
+- (void)testPerformanceOfBandedExport;
+
+@end
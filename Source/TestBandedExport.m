@@ -0,0 +1,141 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestBandedExport.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing+Export.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+
+#define DRAWING_WIDTH 500
+#define DRAWING_HEIGHT 8000
+#define OBJECT_COUNT 2000
+
+/** @brief A shape that counts how often it is drawn.
+ */
+@interface TestCountingShape : DKDrawableShape {
+@public
+	NSUInteger mDrawCount;
+}
+
+@end
+
+@implementation TestCountingShape
+
+- (void)drawContentWithSelectedState:(BOOL)selected
+{
+	++mDrawCount;
+	[super drawContentWithSelectedState:selected];
+}
+
+@end
+
+#pragma mark -
+
+@interface TestBandedExport ()
+
+- (DKDrawing*)tallDrawingWithLayer:(DKObjectDrawingLayer* __autoreleasing*)layer;
+
+@end
+
+@implementation TestBandedExport
+
+- (DKDrawing*)tallDrawingWithLayer:(DKObjectDrawingLayer* __autoreleasing*)layer
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(DRAWING_WIDTH, DRAWING_HEIGHT)];
+	DKObjectDrawingLayer* odl = [[DKObjectDrawingLayer alloc] init];
+
+	[drawing setMarginsLeft:0
+						top:0
+					  right:0
+					 bottom:0];
+	[drawing addLayer:odl];
+	*layer = odl;
+
+	return drawing;
+}
+
+- (void)testBandsDrawOnlyObjectsTheyContain
+{
+	DKObjectDrawingLayer* layer;
+	DKDrawing* drawing = [self tallDrawingWithLayer:&layer];
+	TestCountingShape* top = [TestCountingShape drawableShapeWithRect:NSMakeRect(10, 10, 50, 50)];
+	TestCountingShape* bottom = [TestCountingShape drawableShapeWithRect:NSMakeRect(10, DRAWING_HEIGHT - 60, 50, 50)];
+
+	[layer addObject:top];
+	[layer addObject:bottom];
+
+	// at 72dpi the image is 2000 bytes a row, so the 4MB bands are about 2000 rows and the drawing takes four of them
+
+	NSData* png = [drawing PNGDataWithResolution:72
+										   gamma:0
+									  interlaced:NO];
+
+	XCTAssertNotNil(png, @"the drawing should export");
+	XCTAssertEqual(top->mDrawCount, (NSUInteger)1, @"an object in the first band should be drawn once, not once for every band");
+	XCTAssertEqual(bottom->mDrawCount, (NSUInteger)1, @"an object in the last band should be drawn once, not once for every band");
+}
+
+- (void)testRetainedBandsFollowChanges
+{
+	DKObjectDrawingLayer* layer;
+	DKDrawing* drawing = [self tallDrawingWithLayer:&layer];
+	TestCountingShape* top = [TestCountingShape drawableShapeWithRect:NSMakeRect(10, 10, 50, 50)];
+	TestCountingShape* bottom = [TestCountingShape drawableShapeWithRect:NSMakeRect(10, DRAWING_HEIGHT - 60, 50, 50)];
+
+	[layer addObject:top];
+	[layer addObject:bottom];
+	[drawing setRetainsExportBands:YES];
+
+	XCTAssertEqual([[drawing controllers] count], (NSUInteger)0, @"retaining bands should not attach a controller to the drawing");
+
+	[drawing PNGDataWithResolution:72
+							 gamma:0
+						interlaced:NO];
+
+	XCTAssertEqual([[drawing controllers] count], (NSUInteger)0, @"an export should not leave a controller attached");
+
+	[drawing PNGDataWithResolution:72
+							 gamma:0
+						interlaced:NO];
+
+	XCTAssertEqual(top->mDrawCount, (NSUInteger)1, @"unchanged bands should not be rendered again");
+
+	[top setLocation:NSMakePoint(100, 100)];
+	[drawing PNGDataWithResolution:72
+							 gamma:0
+						interlaced:NO];
+
+	XCTAssertEqual(top->mDrawCount, (NSUInteger)2, @"a band the drawing invalidated should be rendered again");
+	XCTAssertEqual(bottom->mDrawCount, (NSUInteger)1, @"a band the change didn't touch should be kept");
+
+	[drawing setRetainsExportBands:NO];
+}
+
+- (void)testPerformanceOfBandedExport
+{
+	DKObjectDrawingLayer* layer;
+	DKDrawing* drawing = [self tallDrawingWithLayer:&layer];
+	NSMutableArray* shapes = [NSMutableArray arrayWithCapacity:OBJECT_COUNT];
+
+	for (NSUInteger i = 0; i < OBJECT_COUNT; ++i) {
+		CGFloat y = (CGFloat)i / OBJECT_COUNT * (DRAWING_HEIGHT - 40);
+
+		[shapes addObject:[DKDrawableShape drawableShapeWithRect:NSMakeRect((i * 37) % (DRAWING_WIDTH - 40), y, 30, 30)]];
+	}
+
+	[layer addObjectsFromArray:shapes];
+
+	[self measureBlock:^{
+		@autoreleasepool {
+			[drawing PNGDataWithResolution:144
+									 gamma:0
+								interlaced:NO];
+		}
+	}];
+}
+
+@end
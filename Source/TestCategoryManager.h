@@ -0,0 +1,26 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKCategoryManager.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for the indexes kept by DKCategoryManager.
+
+ Checks that objects can be found by key and their keys found from them after the indexes are rebuilt by copying or unarchiving,
+ including objects that are in the master list but in no category, and that objects are indexed by identity, so one that is mutated
+ keeps its keys and one merely equal to it doesn't share them. Times finding the keys of every object in a large manager, and
+ copying it.
+*/
+@interface TestCategoryManager : XCTestCase
+
+- (void)testIndexesAfterCopy;
+- (void)testUncategorisedObjectIsIndexed;
+- (void)testIndexesAfterArchiving;
+- (void)testMutatedObjectIsIndexed;
+- (void)testPerformanceOfKeysForObject;
+- (void)testPerformanceOfCopying;
+
+@end
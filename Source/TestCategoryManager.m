@@ -0,0 +1,150 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestCategoryManager.h"
+
+#define OBJECT_COUNT 5000
+
+@interface TestCategoryManager ()
+
+- (DKCategoryManager*)managerWithObjectCount:(NSUInteger)count objects:(NSArray* __autoreleasing*)objects;
+
+@end
+
+@implementation TestCategoryManager
+
+- (DKCategoryManager*)managerWithObjectCount:(NSUInteger)count objects:(NSArray* __autoreleasing*)objects
+{
+	DKCategoryManager* cm = [DKCategoryManager categoryManager];
+	NSMutableArray* added = [NSMutableArray arrayWithCapacity:count];
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		NSString* obj = [NSString stringWithFormat:@"object %lu", (unsigned long)i];
+
+		[cm addObject:obj
+				   forKey:[NSString stringWithFormat:@"Key %lu", (unsigned long)i]
+			toCategory:[NSString stringWithFormat:@"Category %lu", (unsigned long)(i % 10)]
+			createCategory:YES];
+		[added addObject:obj];
+	}
+
+	if (objects)
+		*objects = added;
+
+	return cm;
+}
+
+- (void)testIndexesAfterCopy
+{
+	DKCategoryManager* cm = [DKCategoryManager categoryManager];
+	NSString* obj = @"red";
+
+	[cm addObject:obj
+			   forKey:@"Red"
+		toCategory:@"Colours"
+		createCategory:YES];
+
+	DKCategoryManager* copy = [cm copy];
+
+	XCTAssertEqualObjects([copy objectForKey:@"Red"], obj, @"the object should be found by its key in the copy");
+	XCTAssertEqualObjects([copy keysForObject:obj], @[ @"Red" ], @"the copy should keep the key as it was given");
+}
+
+- (void)testUncategorisedObjectIsIndexed
+{
+	DKCategoryManager* cm = [DKCategoryManager categoryManager];
+	NSString* obj = @"blue";
+
+	[cm addObject:obj
+			   forKey:@"Blue"
+		toCategory:@"Colours"
+		createCategory:YES];
+	[cm removeKeyFromAllCategories:@"Blue"];
+
+	XCTAssertEqualObjects([cm objectForKey:@"Blue"], obj, @"removing the key from every category should leave the object in the master list");
+
+	DKCategoryManager* copy = [cm copy];
+
+	XCTAssertEqualObjects([copy objectForKey:@"Blue"], obj, @"the object should be found by its key in the copy");
+	XCTAssertEqual([[copy keysForObject:obj] count], (NSUInteger)1, @"an object in no category should still have its key");
+	XCTAssertEqualObjects([[[copy keysForObject:obj] firstObject] lowercaseString], @"blue", @"the key should match the one given, ignoring case");
+}
+
+- (void)testIndexesAfterArchiving
+{
+	DKCategoryManager* cm = [DKCategoryManager categoryManager];
+
+	[cm addObject:@"green"
+			   forKey:@"Green"
+		toCategory:@"Colours"
+		createCategory:YES];
+	[cm addObject:@"grey"
+			   forKey:@"Grey"
+		toCategory:@"Colours"
+		createCategory:YES];
+	[cm removeKeyFromAllCategories:@"Grey"];
+
+	DKCategoryManager* unarchived = [[DKCategoryManager alloc] initWithData:[cm dataWithFormat:NSPropertyListBinaryFormat_v1_0]];
+
+	XCTAssertEqualObjects([unarchived keysForObject:[unarchived objectForKey:@"Green"]], @[ @"Green" ], @"a categorised object should keep its key as given");
+	XCTAssertEqual([[unarchived keysForObject:[unarchived objectForKey:@"Grey"]] count], (NSUInteger)1, @"an uncategorised object should be indexed after unarchiving");
+	XCTAssertEqualObjects([unarchived objectForKey:@"Grey"], @"grey", @"an uncategorised object should be found by its key after unarchiving");
+	XCTAssertEqualObjects([unarchived keysForObject:@"green"], @[ @"Green" ], @"an equal object that isn't the one stored should still find its key");
+}
+
+- (void)testMutatedObjectIsIndexed
+{
+	DKCategoryManager* cm = [DKCategoryManager categoryManager];
+	NSMutableString* obj = [NSMutableString stringWithString:@"orange"];
+	NSMutableString* twin = [NSMutableString stringWithString:@"orange"];
+
+	[cm addObject:obj
+			   forKey:@"Orange"
+		toCategory:@"Colours"
+		createCategory:YES];
+	[cm addObject:twin
+			   forKey:@"Amber"
+		toCategory:@"Colours"
+		createCategory:YES];
+
+	XCTAssertEqualObjects([cm keysForObject:obj], @[ @"Orange" ], @"an object should only find its own keys, not those of an equal object");
+
+	// changing the object changes its hash, which mustn't lose it from the index
+
+	[obj appendString:@" peel"];
+
+	XCTAssertEqualObjects([cm keysForObject:obj], @[ @"Orange" ], @"a mutated object should still find its key");
+	XCTAssertEqualObjects([cm keysForObject:twin], @[ @"Amber" ], @"the equal object should keep its own key");
+
+	[cm removeObjectForKey:@"Orange"];
+
+	XCTAssertEqual([[cm keysForObject:obj] count], (NSUInteger)0, @"a mutated object should be removed from the index with its key");
+	XCTAssertEqualObjects([cm keysForObject:twin], @[ @"Amber" ], @"removing one object shouldn't disturb an equal one");
+}
+
+- (void)testPerformanceOfKeysForObject
+{
+	NSArray* objects = nil;
+	DKCategoryManager* cm = [self managerWithObjectCount:OBJECT_COUNT
+												 objects:&objects];
+
+	[self measureBlock:^{
+		for (id obj in objects)
+			[cm keysForObject:obj];
+	}];
+}
+
+- (void)testPerformanceOfCopying
+{
+	DKCategoryManager* cm = [self managerWithObjectCount:OBJECT_COUNT
+												 objects:NULL];
+
+	[self measureBlock:^{
+		(void)[cm copy];
+	}];
+}
+
+@end
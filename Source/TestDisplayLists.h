@@ -0,0 +1,26 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKDrawableObject.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for per-object display lists.
+
+ Checks that a list is kept once recorded, even by an object that had no rendering cache, that it is only used at the scale it was
+ recorded at, that it replays what the object draws, that no view is current while it is recorded, that a visual change discards it
+ and that selecting or deselecting the object doesn't. Times drawing 1,000 shapes directly and from their display lists.
+*/
+@interface TestDisplayLists : XCTestCase
+
+- (void)testListIsKeptPerScale;
+- (void)testReplayMatchesDirectDrawing;
+- (void)testRecordingHasNoCurrentView;
+- (void)testVisualChangeDiscardsList;
+- (void)testSelectionKeepsList;
+- (void)testPerformanceOfDirectDrawing;
+- (void)testPerformanceOfDisplayListDrawing;
+
+@end
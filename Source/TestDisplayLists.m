@@ -0,0 +1,247 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestDisplayLists.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKDrawingView.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <DKDrawKit/DKStyle.h>
+
+#define BITMAP_SIZE 512
+#define SCALE 2.0
+#define SHAPE_COUNT 1000
+
+/** @brief A shape that notes which view was current when it was last drawn.
+ */
+@interface TestViewNotingShape : DKDrawableShape {
+@public
+	BOOL mDrawn;
+	DKDrawingView* mViewWhenDrawn;
+}
+
+@end
+
+@implementation TestViewNotingShape
+
+- (void)drawContentWithSelectedState:(BOOL)selected
+{
+	mDrawn = YES;
+	mViewWhenDrawn = [DKDrawingView currentlyDrawingView];
+	[super drawContentWithSelectedState:selected];
+}
+
+@end
+
+#pragma mark -
+
+@interface TestDisplayLists ()
+
+- (DKDrawableShape*)shapeWithRect:(NSRect)rect;
+- (NSBitmapImageRep*)bitmap;
+- (void)drawIntoBitmap:(NSBitmapImageRep*)bitmap scale:(CGFloat)scale usingBlock:(void (^)(void))block;
+- (NSArray<DKDrawableShape*>*)shapesWithDisplayLists:(BOOL)record;
+
+@end
+
+@implementation TestDisplayLists
+
+- (DKDrawableShape*)shapeWithRect:(NSRect)rect
+{
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:rect];
+
+	[shape setStyle:[DKStyle styleWithFillColour:[NSColor redColor]
+									strokeColour:[NSColor blackColor]
+									 strokeWidth:2]];
+	return shape;
+}
+
+- (NSBitmapImageRep*)bitmap
+{
+	return [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+												   pixelsWide:BITMAP_SIZE
+												   pixelsHigh:BITMAP_SIZE
+												bitsPerSample:8
+											  samplesPerPixel:4
+													 hasAlpha:YES
+													 isPlanar:NO
+											   colorSpaceName:NSCalibratedRGBColorSpace
+												  bytesPerRow:0
+												 bitsPerPixel:0];
+}
+
+- (void)drawIntoBitmap:(NSBitmapImageRep*)bitmap scale:(CGFloat)scale usingBlock:(void (^)(void))block
+{
+	NSGraphicsContext* context = [NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap];
+	CGContextRef cg = [context graphicsPort];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithGraphicsPort:cg
+																					flipped:YES]];
+
+	// flipped, as in a drawing view
+
+	CGContextTranslateCTM(cg, 0, BITMAP_SIZE);
+	CGContextScaleCTM(cg, scale, -scale);
+	block();
+
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (NSArray<DKDrawableShape*>*)shapesWithDisplayLists:(BOOL)record
+{
+	NSMutableArray* shapes = [NSMutableArray arrayWithCapacity:SHAPE_COUNT];
+
+	for (NSUInteger i = 0; i < SHAPE_COUNT; ++i) {
+		DKDrawableShape* shape = [self shapeWithRect:NSMakeRect((i * 37) % 200, (i * 53) % 200, 40, 40)];
+
+		if (record)
+			[shape setDisplayList:[shape recordDisplayListAtScale:1.0]
+							scale:1.0];
+
+		[shapes addObject:shape];
+	}
+
+	return shapes;
+}
+
+- (void)testListIsKeptPerScale
+{
+	DKDrawableShape* shape = [self shapeWithRect:NSMakeRect(20, 20, 100, 60)];
+	NSData* list = [shape recordDisplayListAtScale:SCALE];
+
+	XCTAssertNotNil(list, @"the shape should be recorded");
+
+	[shape setDisplayList:list
+					scale:SCALE];
+
+	XCTAssertTrue([shape hasDisplayListAtScale:SCALE], @"a new shape should keep its list, though it had no rendering cache");
+	XCTAssertFalse([shape hasDisplayListAtScale:1.0], @"the list should not be used at another scale");
+}
+
+- (void)testReplayMatchesDirectDrawing
+{
+	DKDrawableShape* shape = [self shapeWithRect:NSMakeRect(20, 20, 100, 60)];
+	NSBitmapImageRep* direct = [self bitmap];
+	NSBitmapImageRep* replayed = [self bitmap];
+
+	[shape setDisplayList:[shape recordDisplayListAtScale:SCALE]
+					scale:SCALE];
+
+	[self drawIntoBitmap:direct
+				   scale:SCALE
+			  usingBlock:^{
+				  [shape drawContentWithSelectedState:NO];
+			  }];
+
+	__block BOOL usedList = NO;
+
+	[self drawIntoBitmap:replayed
+				   scale:SCALE
+			  usingBlock:^{
+				  usedList = [shape drawContentFromDisplayListAtScale:SCALE];
+			  }];
+
+	XCTAssertTrue(usedList, @"the list should be replayed at the scale it was recorded at");
+
+	// the fill's centre, the stroke on the left edge, and a point outside the shape
+
+	NSPoint samples[3] = { NSMakePoint(70 * SCALE, 50 * SCALE), NSMakePoint(20 * SCALE, 50 * SCALE), NSMakePoint(150 * SCALE, 150 * SCALE) };
+
+	for (NSUInteger i = 0; i < 3; ++i) {
+		NSUInteger a[4], b[4];
+
+		[direct getPixel:a
+					 atX:samples[i].x
+					   y:samples[i].y];
+		[replayed getPixel:b
+					   atX:samples[i].x
+						 y:samples[i].y];
+
+		for (NSUInteger c = 0; c < 4; ++c)
+			XCTAssertEqualWithAccuracy((CGFloat)a[c], (CGFloat)b[c], 8.0, @"replayed pixel %lu differs from direct drawing", (unsigned long)i);
+	}
+}
+
+- (void)testRecordingHasNoCurrentView
+{
+	TestViewNotingShape* shape = [TestViewNotingShape drawableShapeWithRect:NSMakeRect(20, 20, 100, 60)];
+	DKDrawingView* view = [[DKDrawingView alloc] initWithFrame:NSMakeRect(0, 0, 200, 200)];
+
+	[view set];
+	[shape recordDisplayListAtScale:1.0];
+
+	XCTAssertTrue(shape->mDrawn, @"the shape should be drawn to record it");
+	XCTAssertNil(shape->mViewWhenDrawn, @"no view should be current while recording, so nothing is culled to it");
+	XCTAssertEqual([DKDrawingView currentlyDrawingView], view, @"the view should be current again afterwards");
+
+	[DKDrawingView pop];
+}
+
+- (void)testVisualChangeDiscardsList
+{
+	DKDrawableShape* shape = [self shapeWithRect:NSMakeRect(20, 20, 100, 60)];
+
+	[shape setDisplayList:[shape recordDisplayListAtScale:1.0]
+					scale:1.0];
+	[shape notifyVisualChange];
+
+	XCTAssertFalse([shape hasDisplayListAtScale:1.0], @"a visual change should discard the list");
+}
+
+- (void)testSelectionKeepsList
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(500, 500)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	DKDrawableShape* shape = [self shapeWithRect:NSMakeRect(20, 20, 100, 60)];
+
+	[drawing addLayer:layer];
+	[layer addObject:shape];
+	[shape setDisplayList:[shape recordDisplayListAtScale:1.0]
+					scale:1.0];
+
+	[layer addObjectToSelection:shape];
+	XCTAssertTrue([shape hasDisplayListAtScale:1.0], @"selecting an object should not discard its list");
+
+	[layer deselectAll];
+	XCTAssertTrue([shape hasDisplayListAtScale:1.0], @"deselecting an object should not discard its list");
+
+	[layer exchangeSelectionWithObjectsFromArray:@[ shape ]];
+	[layer removeObjectFromSelection:shape];
+	XCTAssertTrue([shape hasDisplayListAtScale:1.0], @"changing the selection should not discard the list");
+}
+
+- (void)testPerformanceOfDirectDrawing
+{
+	NSArray* shapes = [self shapesWithDisplayLists:NO];
+	NSBitmapImageRep* bitmap = [self bitmap];
+
+	[self measureBlock:^{
+		[self drawIntoBitmap:bitmap
+					   scale:1.0
+				  usingBlock:^{
+					  for (DKDrawableShape* shape in shapes)
+						  [shape drawContentWithSelectedState:NO];
+				  }];
+	}];
+}
+
+- (void)testPerformanceOfDisplayListDrawing
+{
+	NSArray* shapes = [self shapesWithDisplayLists:YES];
+	NSBitmapImageRep* bitmap = [self bitmap];
+
+	[self measureBlock:^{
+		[self drawIntoBitmap:bitmap
+					   scale:1.0
+				  usingBlock:^{
+					  for (DKDrawableShape* shape in shapes)
+						  [shape drawContentFromDisplayListAtScale:1.0];
+				  }];
+	}];
+}
+
+@end
@@ -0,0 +1,26 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKDrawingPreview.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for the previews saved with drawings.
+
+ Checks that binary and XML drawing data carry a preview whose counts and image sizes match the drawing, that the drawing still loads
+ from the same data, and that data saved without a preview, or with previews turned off, gives none. Times reading the preview of a
+ drawing of 50,000 shapes against loading the whole drawing, which is what Quick Look did before.
+*/
+@interface TestDrawingPreview : XCTestCase
+
+- (void)testBinaryDataHasPreview;
+- (void)testXMLDataHasPreview;
+- (void)testImageFittingSize;
+- (void)testNoPreviewWhenTurnedOff;
+- (void)testNoPreviewInOlderData;
+- (void)testPerformanceOfReadingPreview;
+- (void)testPerformanceOfLoadingDrawing;
+
+@end
@@ -0,0 +1,170 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestDrawingPreview.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing+Export.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+
+#define SMALL_SHAPE_COUNT 1000
+#define LARGE_SHAPE_COUNT 50000
+
+@interface TestDrawingPreview ()
+
+- (DKDrawing*)drawingWithShapeCount:(NSUInteger)count;
+- (void)checkPreview:(DKDrawingPreview*)preview ofDrawing:(DKDrawing*)drawing;
+
+@end
+
+@implementation TestDrawingPreview
+
+- (DKDrawing*)drawingWithShapeCount:(NSUInteger)count
+{
+	// twice as wide as it is high, so the levels have a known shape
+
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(2000, 1000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	NSMutableArray* shapes = [NSMutableArray arrayWithCapacity:count];
+
+	[drawing addLayer:layer];
+
+	for (NSUInteger i = 0; i < count; ++i)
+		[shapes addObject:[DKDrawableShape drawableShapeWithRect:NSMakeRect((i * 7) % 1990, (i * 13) % 990, 8, 6)]];
+
+	[layer addObjectsFromArray:shapes];
+
+	return drawing;
+}
+
+- (void)checkPreview:(DKDrawingPreview*)preview ofDrawing:(DKDrawing*)drawing
+{
+	XCTAssertNotNil(preview, @"drawing data should have a preview");
+	XCTAssertTrue(NSEqualSizes([preview drawingSize], [drawing drawingSize]), @"preview should record the drawing size");
+	XCTAssertEqual([preview layerCount], [[drawing flattenedLayers] count], @"preview should count the drawing's layers");
+	XCTAssertEqual([preview objectCount], (NSUInteger)SMALL_SHAPE_COUNT, @"preview should count the drawing's objects");
+
+	XCTAssertGreaterThan([preview levelCount], (NSUInteger)1, @"preview should have several levels");
+	XCTAssertEqual([preview pixelSizeOfLevel:0].width, (CGFloat)[DKDrawingPreview largestPreviewSize], @"largest level should be the largest preview size");
+	XCTAssertEqual([preview pixelSizeOfLevel:0].height, (CGFloat)[DKDrawingPreview largestPreviewSize] / 2, @"largest level should keep the drawing's proportions");
+
+	for (NSUInteger level = 1; level < [preview levelCount]; ++level) {
+		NSSize above = [preview pixelSizeOfLevel:level - 1];
+		NSSize size = [preview pixelSizeOfLevel:level];
+
+		XCTAssertEqual(size.width, floor(above.width / 2), @"level %lu should be half the width of the one above", (unsigned long)level);
+		XCTAssertEqual(size.height, floor(above.height / 2), @"level %lu should be half the height of the one above", (unsigned long)level);
+	}
+
+	NSSize smallest = [preview pixelSizeOfLevel:[preview levelCount] - 1];
+	XCTAssertGreaterThanOrEqual(MAX(smallest.width, smallest.height), 64.0, @"smallest level should be no smaller than 64 pixels");
+
+	for (NSUInteger level = 0; level < [preview levelCount]; ++level) {
+		CGImageRef image = [preview newImageAtLevel:level];
+		NSSize size = [preview pixelSizeOfLevel:level];
+
+		XCTAssertTrue(image != NULL, @"level %lu should decode", (unsigned long)level);
+		XCTAssertEqual((CGFloat)CGImageGetWidth(image), size.width, @"level %lu image should be the recorded width", (unsigned long)level);
+		XCTAssertEqual((CGFloat)CGImageGetHeight(image), size.height, @"level %lu image should be the recorded height", (unsigned long)level);
+		CGImageRelease(image);
+	}
+}
+
+- (void)testBinaryDataHasPreview
+{
+	DKDrawing* drawing = [self drawingWithShapeCount:SMALL_SHAPE_COUNT];
+	NSData* data = [drawing drawingData];
+
+	[self checkPreview:[DKDrawingPreview previewWithData:data] ofDrawing:drawing];
+
+	DKDrawing* loaded = [DKDrawing drawingWithData:data];
+	DKObjectDrawingLayer* layer = [[loaded flattenedLayersOfClass:[DKObjectDrawingLayer class]] firstObject];
+
+	XCTAssertNotNil(loaded, @"drawing should still load from data with a preview");
+	XCTAssertEqual([layer countOfObjects], (NSUInteger)SMALL_SHAPE_COUNT, @"loaded drawing should have all its objects");
+}
+
+- (void)testXMLDataHasPreview
+{
+	DKDrawing* drawing = [self drawingWithShapeCount:SMALL_SHAPE_COUNT];
+	NSData* data = [drawing drawingAsXMLDataAtRoot];
+
+	[self checkPreview:[DKDrawingPreview previewWithData:data] ofDrawing:drawing];
+	XCTAssertNotNil([DKDrawing drawingWithData:data], @"drawing should still load from XML data with a preview");
+}
+
+- (void)testImageFittingSize
+{
+	DKDrawingPreview* preview = [DKDrawingPreview previewOfDrawing:[self drawingWithShapeCount:SMALL_SHAPE_COUNT]];
+	CGImageRef image;
+
+	// levels are 512 x 256, 256 x 128, 128 x 64 and 64 x 32
+
+	image = [preview newImageFittingSize:NSMakeSize(100, 100)];
+	XCTAssertEqual(CGImageGetWidth(image), (size_t)128, @"a 100 pixel request should get the 128 pixel level");
+	CGImageRelease(image);
+
+	image = [preview newImageFittingSize:NSMakeSize(200, 200)];
+	XCTAssertEqual(CGImageGetWidth(image), (size_t)256, @"a 200 pixel request should get the 256 pixel level");
+	CGImageRelease(image);
+
+	image = [preview newImageFittingSize:NSMakeSize(2000, 2000)];
+	XCTAssertEqual(CGImageGetWidth(image), (size_t)512, @"a request larger than every level should get the largest");
+	CGImageRelease(image);
+
+	image = [preview newImageFittingSize:NSMakeSize(16, 16)];
+	XCTAssertEqual(CGImageGetWidth(image), (size_t)64, @"a request smaller than every level should get the smallest");
+	CGImageRelease(image);
+}
+
+- (void)testNoPreviewWhenTurnedOff
+{
+	DKDrawing* drawing = [self drawingWithShapeCount:SMALL_SHAPE_COUNT];
+
+	[DKDrawing setSavesPreview:NO];
+	NSData* data = [drawing drawingData];
+	[DKDrawing setSavesPreview:YES];
+
+	XCTAssertNil([DKDrawingPreview previewWithData:data], @"no preview should be saved when previews are turned off");
+	XCTAssertNotNil([DKDrawing drawingWithData:data], @"drawing should load without a preview");
+}
+
+- (void)testNoPreviewInOlderData
+{
+	DKDrawing* drawing = [self drawingWithShapeCount:SMALL_SHAPE_COUNT];
+
+	XCTAssertNil([DKDrawingPreview previewWithData:[NSKeyedArchiver archivedDataWithRootObject:drawing]], @"data saved without a preview should have none");
+	XCTAssertNil([DKDrawingPreview previewWithData:[@"not a drawing" dataUsingEncoding:NSUTF8StringEncoding]], @"data that isn't an archive should have no preview");
+}
+
+- (void)testPerformanceOfReadingPreview
+{
+	NSData* data = [[self drawingWithShapeCount:LARGE_SHAPE_COUNT] drawingData];
+
+	[self measureBlock:^{
+		DKDrawingPreview* preview = [DKDrawingPreview previewWithData:data];
+		CGImageRef image = [preview newImageFittingSize:NSMakeSize(128, 128)];
+
+		XCTAssertTrue(image != NULL, @"preview image should decode");
+		CGImageRelease(image);
+	}];
+}
+
+- (void)testPerformanceOfLoadingDrawing
+{
+	NSData* data = [[self drawingWithShapeCount:LARGE_SHAPE_COUNT] drawingData];
+
+	[self measureBlock:^{
+		DKDrawing* drawing = [DKDrawing drawingWithData:data];
+		CGImageRef image = [drawing CGImageWithResolution:72
+												 hasAlpha:YES
+											relativeScale:128.0 / 2000.0];
+
+		XCTAssertTrue(image != NULL, @"drawing should render");
+	}];
+}
+
+@end
@@ -0,0 +1,24 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKFillPattern.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for culled pattern fills.
+
+ Checks that filling only part of a shape draws exactly the pixels a full fill draws there, that a huge randomised fill only places
+ the motifs being drawn, that suppressing clipped motifs keeps them inside the path, and times dense patterns on an intricate path
+ for full and partial redraws.
+*/
+@interface TestFillPatternCulling : XCTestCase
+
+- (void)testPartialFillMatchesFullFill;
+- (void)testHugeWobblyFillOnlyPlacesVisibleMotifs;
+- (void)testSuppressedMotifsStayInsidePath;
+- (void)testPerformanceOfFullFill;
+- (void)testPerformanceOfPartialFill;
+
+@end
@@ -0,0 +1,213 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestFillPatternCulling.h"
+#import <DKDrawKit/DKRandom.h>
+
+#define BITMAP_SIZE 512
+
+@interface TestFillPatternCulling ()
+
+- (NSBitmapImageRep*)bitmap;
+- (DKFillPattern*)densePattern;
+- (NSBezierPath*)intricatePath;
+- (void)fillPath:(NSBezierPath*)path withPattern:(DKFillPattern*)pattern inBitmap:(NSBitmapImageRep*)bitmap clippedToRect:(NSRect)clip;
+
+@end
+
+@implementation TestFillPatternCulling
+
+- (NSBitmapImageRep*)bitmap
+{
+	return [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+												   pixelsWide:BITMAP_SIZE
+												   pixelsHigh:BITMAP_SIZE
+												bitsPerSample:8
+											  samplesPerPixel:4
+													 hasAlpha:YES
+													 isPlanar:NO
+											   colorSpaceName:NSCalibratedRGBColorSpace
+												  bytesPerRow:0
+												 bitsPerPixel:0];
+}
+
+- (DKFillPattern*)densePattern
+{
+	NSImage* image = [[NSImage alloc] initWithSize:NSMakeSize(4, 4)];
+
+	[image lockFocus];
+	[[NSColor blueColor] set];
+	NSRectFill(NSMakeRect(0, 0, 4, 4));
+	[image unlockFocus];
+
+	DKFillPattern* pattern = [DKFillPattern fillPatternWithImage:image];
+
+	[pattern setInterval:2];
+	[pattern setAngle:0.3];
+
+	return pattern;
+}
+
+- (NSBezierPath*)intricatePath
+{
+	// a star with many points, so that most rows cross the outline many times
+
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	NSPoint centre = NSMakePoint(BITMAP_SIZE / 2, BITMAP_SIZE / 2);
+	DKRandomState rng;
+
+	DKRandomSeed(&rng, 11);
+
+	for (NSUInteger i = 0; i < 400; ++i) {
+		CGFloat theta = i * M_PI * 2.0 / 400;
+		CGFloat radius = (i & 1) ? 120 + DKRandomUnit(&rng) * 40 : 240;
+		NSPoint p = NSMakePoint(centre.x + radius * cos(theta), centre.y + radius * sin(theta));
+
+		if (i == 0)
+			[path moveToPoint:p];
+		else
+			[path lineToPoint:p];
+	}
+
+	[path closePath];
+
+	return path;
+}
+
+- (void)fillPath:(NSBezierPath*)path withPattern:(DKFillPattern*)pattern inBitmap:(NSBitmapImageRep*)bitmap clippedToRect:(NSRect)clip
+{
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+	NSRectClip(clip);
+	[path addClip];
+	[pattern drawPatternInPath:path];
+	[[NSGraphicsContext currentContext] flushGraphics];
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (void)testPartialFillMatchesFullFill
+{
+	DKFillPattern* pattern = [self densePattern];
+	NSBezierPath* path = [self intricatePath];
+	NSBitmapImageRep* full = [self bitmap];
+	NSBitmapImageRep* partial = [self bitmap];
+	NSRect update = NSMakeRect(300, 140, 90, 70);
+
+	[pattern setWobblyness:0.3];
+	[pattern setMotifAngleRandomness:0.2];
+
+	[self fillPath:path
+			withPattern:pattern
+			   inBitmap:full
+		  clippedToRect:NSMakeRect(0, 0, BITMAP_SIZE, BITMAP_SIZE)];
+	[self fillPath:path
+			withPattern:pattern
+			   inBitmap:partial
+		  clippedToRect:update];
+
+	XCTAssertLessThan([pattern motifPlacementCount], (NSUInteger)2000, @"a partial fill should only place the motifs near the update");
+
+	// bitmap rows run from the top down
+
+	NSInteger bytesPerRow = [full bytesPerRow];
+	NSInteger top = BITMAP_SIZE - (NSInteger)NSMaxY(update);
+
+	for (NSInteger row = top; row < top + (NSInteger)NSHeight(update); ++row) {
+		const unsigned char* a = [full bitmapData] + row * bytesPerRow + (NSInteger)NSMinX(update) * 4;
+		const unsigned char* b = [partial bitmapData] + row * bytesPerRow + (NSInteger)NSMinX(update) * 4;
+
+		XCTAssertEqual(memcmp(a, b, (size_t)NSWidth(update) * 4), 0, @"row %ld of the update differs from the full fill", (long)row);
+	}
+}
+
+- (void)testHugeWobblyFillOnlyPlacesVisibleMotifs
+{
+	// the pattern covers billions of cells, but only those being drawn should cost anything, random factors included
+
+	DKFillPattern* pattern = [self densePattern];
+	NSBezierPath* path = [NSBezierPath bezierPathWithRect:NSMakeRect(-1.0e6, -1.0e6, 2.0e6, 2.0e6)];
+	NSRect update = NSMakeRect(100, 100, 40, 40);
+
+	[pattern setWobblyness:0.5];
+	[pattern setScaleRandomness:0.5];
+	[pattern setMotifAngleRandomness:0.5];
+
+	[self fillPath:path
+			withPattern:pattern
+			   inBitmap:[self bitmap]
+		  clippedToRect:update];
+
+	NSUInteger count = [pattern motifPlacementCount];
+	NSRect first = [pattern motifPlacements][0].bounds;
+
+	XCTAssertGreaterThan(count, (NSUInteger)0, @"the update should be filled");
+	XCTAssertLessThan(count, (NSUInteger)2000, @"only the motifs near the update should be placed");
+
+	[self fillPath:path
+			withPattern:pattern
+			   inBitmap:[self bitmap]
+		  clippedToRect:update];
+
+	XCTAssertTrue(NSEqualRects([pattern motifPlacements][0].bounds, first), @"a motif's random factors should be the same each time it is drawn");
+}
+
+- (void)testSuppressedMotifsStayInsidePath
+{
+	DKFillPattern* pattern = [self densePattern];
+	NSBezierPath* path = [self intricatePath];
+
+	[pattern setDrawingOfClippedElementsSupressed:YES];
+
+	[self fillPath:path
+			withPattern:pattern
+			   inBitmap:[self bitmap]
+		  clippedToRect:NSMakeRect(0, 0, BITMAP_SIZE, BITMAP_SIZE)];
+
+	NSUInteger count = [pattern motifPlacementCount];
+	const DKMotifPlacement* placements = [pattern motifPlacements];
+
+	XCTAssertGreaterThan(count, (NSUInteger)1000, @"the interior of the star should be filled");
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		NSPoint centre = NSMakePoint(NSMidX(placements[i].bounds), NSMidY(placements[i].bounds));
+
+		XCTAssertTrue([path containsPoint:centre], @"motif %lu lies outside the path", (unsigned long)i);
+	}
+}
+
+- (void)testPerformanceOfFullFill
+{
+	DKFillPattern* pattern = [self densePattern];
+	NSBezierPath* path = [self intricatePath];
+	NSBitmapImageRep* bitmap = [self bitmap];
+
+	[pattern setDrawingOfClippedElementsSupressed:YES];
+
+	[self measureBlock:^{
+		[self fillPath:path
+				withPattern:pattern
+				   inBitmap:bitmap
+			  clippedToRect:NSMakeRect(0, 0, BITMAP_SIZE, BITMAP_SIZE)];
+	}];
+}
+
+- (void)testPerformanceOfPartialFill
+{
+	DKFillPattern* pattern = [self densePattern];
+	NSBezierPath* path = [self intricatePath];
+	NSBitmapImageRep* bitmap = [self bitmap];
+
+	[pattern setDrawingOfClippedElementsSupressed:YES];
+
+	[self measureBlock:^{
+		[self fillPath:path
+				withPattern:pattern
+				   inBitmap:bitmap
+			  clippedToRect:NSMakeRect(200, 200, 40, 40)];
+	}];
+}
+
+@end
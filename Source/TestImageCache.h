@@ -0,0 +1,25 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKImageCache.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for DKImageCache.
+
+ Checks that a level is built in the background and then returned, that a level that can't be decoded is remembered as failed rather
+ than tried again on every request, that a level still being built when its key is removed isn't cached, and that an image shape's
+ private levels go when the shape does. Times drawing a large image zoomed out at full size and from its cached level.
+*/
+@interface TestImageCache : XCTestCase
+
+- (void)testLevelIsBuiltAndCached;
+- (void)testFailedLevelIsNotRetriedImmediately;
+- (void)testBuildFinishingAfterRemovalIsDropped;
+- (void)testPrivateLevelsRemovedWithShape;
+- (void)testPerformanceOfDrawingFullSizeImage;
+- (void)testPerformanceOfDrawingCachedLevel;
+
+@end
@@ -0,0 +1,241 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestImageCache.h"
+#import <DKDrawKit/DKImageShape.h>
+
+#define IMAGE_SIZE 2048
+#define BITMAP_SIZE 256
+#define LEVEL 3
+#define DRAW_COUNT 100
+
+@interface DKImageShape (TestImageCache)
+
+- (NSString*)imageCacheKey;
+
+@end
+
+@interface TestImageCache ()
+
+- (NSImage*)largeImage;
+- (CGContextRef)newBitmapContext;
+- (void)waitForLevel:(NSInteger)level ofKey:(NSString*)key inCache:(DKImageCache*)cache imageData:(NSData*)data image:(NSImage*)image;
+
+@end
+
+@implementation TestImageCache
+
+- (NSImage*)largeImage
+{
+	NSImage* image = [[NSImage alloc] initWithSize:NSMakeSize(IMAGE_SIZE, IMAGE_SIZE)];
+
+	[image lockFocus];
+	[[NSColor whiteColor] set];
+	NSRectFill(NSMakeRect(0, 0, IMAGE_SIZE, IMAGE_SIZE));
+	[[NSColor blueColor] set];
+
+	for (NSUInteger i = 0; i < IMAGE_SIZE; i += 8)
+		NSRectFill(NSMakeRect(i, 0, 2, IMAGE_SIZE));
+
+	[image unlockFocus];
+
+	return image;
+}
+
+- (CGContextRef)newBitmapContext
+{
+	CGColorSpaceRef cs = CGColorSpaceCreateDeviceRGB();
+	CGContextRef ctx = CGBitmapContextCreate(NULL, BITMAP_SIZE, BITMAP_SIZE, 8, 0, cs, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst);
+
+	CGColorSpaceRelease(cs);
+	CGContextSetInterpolationQuality(ctx, kCGInterpolationHigh);
+
+	return ctx;
+}
+
+- (void)waitForLevel:(NSInteger)level ofKey:(NSString*)key inCache:(DKImageCache*)cache imageData:(NSData*)data image:(NSImage*)image
+{
+	XCTestExpectation* built = [self expectationWithDescription:@"level built"];
+
+	[cache imageForKey:key
+				 level:level
+			 imageData:data
+				 image:image
+			completion:^{
+				[built fulfill];
+			}];
+
+	[self waitForExpectationsWithTimeout:10
+								 handler:nil];
+}
+
+- (void)testLevelIsBuiltAndCached
+{
+	DKImageCache* cache = [[DKImageCache alloc] init];
+	NSImage* image = [self largeImage];
+
+	[self waitForLevel:LEVEL
+				 ofKey:@"built"
+			   inCache:cache
+			 imageData:nil
+				 image:image];
+
+	[cache resetStatistics];
+
+	CGImageRef mip = [cache imageForKey:@"built"
+								  level:LEVEL
+							  imageData:nil
+								  image:image
+							 completion:nil];
+
+	XCTAssertTrue(mip != NULL, @"the level should be cached once built");
+	XCTAssertEqual(CGImageGetWidth(mip), (size_t)(IMAGE_SIZE >> LEVEL), @"each level should halve the size");
+	XCTAssertEqual([cache hits], (NSUInteger)1, @"the request should be a hit");
+	XCTAssertFalse([cache failedToBuildImageForKey:@"built"
+											 level:LEVEL],
+		@"the level was built");
+}
+
+- (void)testFailedLevelIsNotRetriedImmediately
+{
+	DKImageCache* cache = [[DKImageCache alloc] init];
+	NSData* garbage = [@"this is not an image" dataUsingEncoding:NSUTF8StringEncoding];
+
+	[self waitForLevel:1
+				 ofKey:@"broken"
+			   inCache:cache
+			 imageData:garbage
+				 image:nil];
+
+	XCTAssertTrue([cache failedToBuildImageForKey:@"broken"
+											level:1],
+		@"the level couldn't be decoded");
+
+	// asking again straight away must not start another decode, so the completion is never called
+
+	__block BOOL called = NO;
+
+	XCTAssertTrue([cache imageForKey:@"broken"
+							   level:1
+						   imageData:garbage
+							   image:nil
+						  completion:^{
+							  called = YES;
+						  }] == NULL,
+		@"there is nothing to return");
+
+	[[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.25]];
+	XCTAssertFalse(called, @"a failed level should not be tried again before its retry time");
+
+	[cache removeImagesForKey:@"broken"];
+	XCTAssertFalse([cache failedToBuildImageForKey:@"broken"
+											 level:1],
+		@"removing the key should forget the failure");
+}
+
+- (void)testBuildFinishingAfterRemovalIsDropped
+{
+	DKImageCache* cache = [[DKImageCache alloc] init];
+	XCTestExpectation* built = [self expectationWithDescription:@"level built"];
+
+	[cache imageForKey:@"removed"
+				 level:LEVEL
+			 imageData:nil
+				 image:[self largeImage]
+			completion:^{
+				[built fulfill];
+			}];
+
+	[cache removeImagesForKey:@"removed"];
+	[self waitForExpectationsWithTimeout:10
+								 handler:nil];
+
+	XCTAssertEqual([cache bytesUsed], (NSUInteger)0, @"a level built for a removed key should not be cached");
+	XCTAssertTrue([cache imageForKey:@"removed"
+							   level:LEVEL
+						   imageData:nil
+							   image:nil
+						  completion:nil] == NULL,
+		@"a level built for a removed key should not come back");
+}
+
+- (void)testPrivateLevelsRemovedWithShape
+{
+	DKImageCache* cache = [DKImageCache sharedImageCache];
+	NSImage* image = [self largeImage];
+	NSString* key;
+
+	@autoreleasepool {
+		DKImageShape* shape = [[DKImageShape alloc] initWithImage:image];
+
+		key = [shape imageCacheKey];
+
+		[self waitForLevel:LEVEL
+					 ofKey:key
+				   inCache:cache
+				 imageData:nil
+					 image:image];
+
+		XCTAssertTrue([cache imageForKey:key
+								   level:LEVEL
+							   imageData:nil
+								   image:nil
+							  completion:nil] != NULL,
+			@"the level should be cached while the shape exists");
+		shape = nil;
+	}
+
+	XCTAssertTrue([cache imageForKey:key
+							   level:LEVEL
+						   imageData:nil
+							   image:nil
+						  completion:nil] == NULL,
+		@"the shape's private levels should be removed when it is deallocated");
+}
+
+- (void)testPerformanceOfDrawingFullSizeImage
+{
+	CGImageRef source = [[self largeImage] CGImageForProposedRect:NULL
+														  context:nil
+															hints:nil];
+	CGContextRef ctx = [self newBitmapContext];
+
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < DRAW_COUNT; ++i)
+			CGContextDrawImage(ctx, CGRectMake(0, 0, BITMAP_SIZE, BITMAP_SIZE), source);
+	}];
+
+	CGContextRelease(ctx);
+}
+
+- (void)testPerformanceOfDrawingCachedLevel
+{
+	DKImageCache* cache = [[DKImageCache alloc] init];
+	NSImage* image = [self largeImage];
+	CGContextRef ctx = [self newBitmapContext];
+
+	[self waitForLevel:LEVEL
+				 ofKey:@"bench"
+			   inCache:cache
+			 imageData:nil
+				 image:image];
+
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < DRAW_COUNT; ++i) {
+			CGImageRef mip = [cache imageForKey:@"bench"
+										  level:LEVEL
+									  imageData:nil
+										  image:image
+									 completion:nil];
+
+			CGContextDrawImage(ctx, CGRectMake(0, 0, BITMAP_SIZE, BITMAP_SIZE), mip);
+		}
+	}];
+
+	CGContextRelease(ctx);
+}
+
+@end
@@ -0,0 +1,22 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKKnob.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for batched knob drawing.
+
+ Draws knobs into an offscreen bitmap one at a time and as batches, and checks that the pixels are identical. Also times drawing
+ the handles for 100,000 points both ways, with no window or view involved.
+*/
+@interface TestKnobBatch : XCTestCase
+
+- (void)testBatchMatchesSingleKnobs;
+- (void)testMixedTypesMatchSingleKnobs;
+- (void)testPerformanceOfSingleKnobs;
+- (void)testPerformanceOfBatchedKnobs;
+
+@end
@@ -0,0 +1,170 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestKnobBatch.h"
+#import <DKDrawKit/DKRandom.h>
+
+#define BITMAP_SIZE 512
+#define KNOB_COUNT 100000
+
+@interface TestKnobBatch ()
+
+- (NSBitmapImageRep*)bitmap;
+- (void)drawIntoBitmap:(NSBitmapImageRep*)bitmap usingBlock:(void (^)(void))block;
+- (NSPoint*)randomPoints:(NSUInteger)count;
+
+@end
+
+@implementation TestKnobBatch
+
+- (NSBitmapImageRep*)bitmap
+{
+	return [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+												   pixelsWide:BITMAP_SIZE
+												   pixelsHigh:BITMAP_SIZE
+												bitsPerSample:8
+											  samplesPerPixel:4
+													 hasAlpha:YES
+													 isPlanar:NO
+											   colorSpaceName:NSCalibratedRGBColorSpace
+												  bytesPerRow:0
+												 bitsPerPixel:0];
+}
+
+- (void)drawIntoBitmap:(NSBitmapImageRep*)bitmap usingBlock:(void (^)(void))block
+{
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+	block();
+	[[NSGraphicsContext currentContext] flushGraphics];
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (NSPoint*)randomPoints:(NSUInteger)count
+{
+	NSPoint* points = malloc(count * sizeof(NSPoint));
+	DKRandomState rng;
+
+	DKRandomSeed(&rng, 37);
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		points[i].x = DKRandomUnit(&rng) * BITMAP_SIZE;
+		points[i].y = DKRandomUnit(&rng) * BITMAP_SIZE;
+	}
+
+	return points;
+}
+
+- (void)testBatchMatchesSingleKnobs
+{
+	DKKnob* knobs = [DKKnob standardKnobs];
+	NSPoint* points = [self randomPoints:500];
+	NSBitmapImageRep* single = [self bitmap];
+	NSBitmapImageRep* batched = [self bitmap];
+	const DKKnobType types[] = { kDKBoundingRectKnobType, kDKOnPathKnobType, kDKControlPointKnobType, kDKRotationKnobType };
+
+	for (NSUInteger t = 0; t < sizeof(types) / sizeof(types[0]); ++t) {
+		for (NSUInteger a = 0; a < 2; ++a) {
+			CGFloat angle = a * 0.5;
+
+			[self drawIntoBitmap:single
+					  usingBlock:^{
+						  for (NSUInteger i = 0; i < 500; ++i)
+							  [knobs drawKnobAtPoint:points[i]
+											  ofType:types[t]
+											   angle:angle
+											userInfo:nil];
+					  }];
+
+			[self drawIntoBitmap:batched
+					  usingBlock:^{
+						  [knobs drawKnobsAtPoints:points
+											 count:500
+											ofType:types[t]
+											 angle:angle];
+					  }];
+
+			XCTAssertEqual(memcmp([single bitmapData], [batched bitmapData], [single bytesPerPlane]), 0, @"batched knobs of type %ld at angle %g should match single knobs", (long)types[t], angle);
+		}
+	}
+
+	free(points);
+}
+
+- (void)testMixedTypesMatchSingleKnobs
+{
+	DKKnob* knobs = [DKKnob standardKnobs];
+	NSPoint* points = [self randomPoints:300];
+	DKKnobType* types = malloc(300 * sizeof(DKKnobType));
+	NSBitmapImageRep* single = [self bitmap];
+	NSBitmapImageRep* batched = [self bitmap];
+
+	// keep each type's points together, in the order the types are listed, so that drawing them one by one and in groups
+	// stacks them the same way
+
+	for (NSUInteger i = 0; i < 300; ++i)
+		types[i] = (i < 100) ? kDKOnPathKnobType : (i < 200) ? kDKControlPointKnobType : kDKBoundingRectKnobType;
+
+	[self drawIntoBitmap:single
+			  usingBlock:^{
+				  for (NSUInteger i = 0; i < 300; ++i)
+					  [knobs drawKnobAtPoint:points[i]
+									  ofType:types[i]
+									userInfo:nil];
+			  }];
+
+	[self drawIntoBitmap:batched
+			  usingBlock:^{
+				  [knobs drawKnobsAtPoints:points
+								   ofTypes:types
+									 count:300];
+			  }];
+
+	XCTAssertEqual(memcmp([single bitmapData], [batched bitmapData], [single bytesPerPlane]), 0, @"mixed batch should match single knobs");
+
+	free(types);
+	free(points);
+}
+
+- (void)testPerformanceOfSingleKnobs
+{
+	DKKnob* knobs = [DKKnob standardKnobs];
+	NSPoint* points = [self randomPoints:KNOB_COUNT];
+	NSBitmapImageRep* bitmap = [self bitmap];
+
+	[self measureBlock:^{
+		[self drawIntoBitmap:bitmap
+				  usingBlock:^{
+					  for (NSUInteger i = 0; i < KNOB_COUNT; ++i)
+						  [knobs drawKnobAtPoint:points[i]
+										  ofType:kDKOnPathKnobType
+										userInfo:nil];
+				  }];
+	}];
+
+	free(points);
+}
+
+- (void)testPerformanceOfBatchedKnobs
+{
+	DKKnob* knobs = [DKKnob standardKnobs];
+	NSPoint* points = [self randomPoints:KNOB_COUNT];
+	NSBitmapImageRep* bitmap = [self bitmap];
+
+	[self measureBlock:^{
+		[self drawIntoBitmap:bitmap
+				  usingBlock:^{
+					  [knobs drawKnobsAtPoints:points
+										 count:KNOB_COUNT
+										ofType:kDKOnPathKnobType
+										 angle:0.0];
+				  }];
+	}];
+
+	free(points);
+}
+
+@end
@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for incremental marquee selection.
+
+ Drags a marquee across a dense grid of shapes, growing, shrinking and crossing over its anchor, and checks after every step that
+ the selection is exactly the set of objects the marquee touches, including after extending stops part way through. Also times a
+ long drag.
+*/
+@interface TestMarqueeSelection : XCTestCase
+
+- (void)testSelectionFollowsMarquee;
+- (void)testExtendedSelectionOnlyGrows;
+- (void)testReleasingExtendDeselects;
+- (void)testPerformanceOfMarqueeDrag;
+
+@end
@@ -0,0 +1,155 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestMarqueeSelection.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKGeometryUtilities.h>
+
+#define GRID_SIZE 100
+#define GRID_SPACING 10.0
+#define DRAG_STEPS 200
+
+@interface TestMarqueeSelection ()
+
+- (DKObjectDrawingLayer*)denseLayer;
+- (NSPoint)dragPointAtStep:(NSUInteger)step;
+- (NSSet*)objectsInLayer:(DKObjectDrawingLayer*)layer touchingRect:(NSRect)rect;
+
+@end
+
+@implementation TestMarqueeSelection
+
+- (DKObjectDrawingLayer*)denseLayer
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(GRID_SIZE * GRID_SPACING, GRID_SIZE * GRID_SPACING)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	NSMutableArray* shapes = [NSMutableArray arrayWithCapacity:GRID_SIZE * GRID_SIZE];
+
+	[drawing addLayer:layer];
+
+	for (NSUInteger y = 0; y < GRID_SIZE; ++y) {
+		for (NSUInteger x = 0; x < GRID_SIZE; ++x)
+			[shapes addObject:[DKDrawableShape drawableShapeWithRect:NSMakeRect(x * GRID_SPACING, y * GRID_SPACING, GRID_SPACING * 0.6, GRID_SPACING * 0.6)]];
+	}
+
+	[layer addObjectsFromArray:shapes];
+
+	return layer;
+}
+
+- (NSPoint)dragPointAtStep:(NSUInteger)step
+{
+	// a loop around the anchor at the centre, so the marquee grows, shrinks and flips from one side of the anchor to the other
+
+	CGFloat t = (CGFloat)step / DRAG_STEPS * 4.0 * M_PI;
+	CGFloat r = GRID_SIZE * GRID_SPACING * 0.45 * (0.2 + 0.8 * fabs(sin(t * 0.75)));
+
+	return NSMakePoint(GRID_SIZE * GRID_SPACING * 0.5 + r * cos(t), GRID_SIZE * GRID_SPACING * 0.5 + r * sin(t));
+}
+
+- (NSSet*)objectsInLayer:(DKObjectDrawingLayer*)layer touchingRect:(NSRect)rect
+{
+	NSMutableSet* hits = [NSMutableSet set];
+
+	for (DKDrawableObject* od in [layer objects]) {
+		if ([od intersectsRect:rect])
+			[hits addObject:od];
+	}
+
+	return hits;
+}
+
+- (void)testSelectionFollowsMarquee
+{
+	DKObjectDrawingLayer* layer = [self denseLayer];
+	NSPoint anchor = NSMakePoint(GRID_SIZE * GRID_SPACING * 0.5, GRID_SIZE * GRID_SPACING * 0.5);
+	NSRect marquee = NSZeroRect;
+
+	// something selected beforehand is dropped on the first step
+
+	[layer addObjectToSelection:[[layer objects] firstObject]];
+
+	for (NSUInteger step = 0; step <= DRAG_STEPS; ++step) {
+		NSRect newMarquee = NSRectFromTwoPoints(anchor, [self dragPointAtStep:step]);
+
+		[layer changeSelectionForMarqueeRect:newMarquee
+									fromRect:marquee
+								   extending:NO];
+		marquee = newMarquee;
+
+		XCTAssertEqualObjects([layer selection], [self objectsInLayer:layer touchingRect:marquee], @"selection doesn't match marquee at step %lu", (unsigned long)step);
+	}
+}
+
+- (void)testExtendedSelectionOnlyGrows
+{
+	DKObjectDrawingLayer* layer = [self denseLayer];
+	NSPoint anchor = NSMakePoint(GRID_SIZE * GRID_SPACING * 0.5, GRID_SIZE * GRID_SPACING * 0.5);
+	NSRect marquee = NSZeroRect;
+	NSMutableSet* swept = [NSMutableSet setWithObject:[[layer objects] firstObject]];
+
+	[layer addObjectToSelection:[[layer objects] firstObject]];
+
+	for (NSUInteger step = 0; step <= DRAG_STEPS; step += 10) {
+		NSRect newMarquee = NSRectFromTwoPoints(anchor, [self dragPointAtStep:step]);
+
+		[layer changeSelectionForMarqueeRect:newMarquee
+									fromRect:marquee
+								   extending:YES];
+		marquee = newMarquee;
+		[swept unionSet:[self objectsInLayer:layer touchingRect:marquee]];
+
+		XCTAssertEqualObjects([layer selection], swept, @"extended selection doesn't match everything swept at step %lu", (unsigned long)step);
+	}
+}
+
+- (void)testReleasingExtendDeselects
+{
+	DKObjectDrawingLayer* layer = [self denseLayer];
+	NSPoint anchor = NSMakePoint(GRID_SIZE * GRID_SPACING * 0.5, GRID_SIZE * GRID_SPACING * 0.5);
+	NSRect marquee = NSZeroRect;
+
+	[layer addObjectToSelection:[[layer objects] firstObject]];
+
+	// extend for the first half of the drag, then let go of the modifier part way through
+
+	for (NSUInteger step = 0; step <= DRAG_STEPS; step += 10) {
+		NSRect newMarquee = NSRectFromTwoPoints(anchor, [self dragPointAtStep:step]);
+		BOOL extend = step < DRAG_STEPS / 2;
+
+		[layer changeSelectionForMarqueeRect:newMarquee
+									fromRect:marquee
+								   extending:extend];
+		marquee = newMarquee;
+
+		if (!extend)
+			XCTAssertEqualObjects([layer selection], [self objectsInLayer:layer touchingRect:marquee], @"selection doesn't match marquee once no longer extending, at step %lu", (unsigned long)step);
+	}
+}
+
+- (void)testPerformanceOfMarqueeDrag
+{
+	DKObjectDrawingLayer* layer = [self denseLayer];
+	NSPoint anchor = NSMakePoint(GRID_SIZE * GRID_SPACING * 0.5, GRID_SIZE * GRID_SPACING * 0.5);
+
+	[self measureBlock:^{
+		NSRect marquee = NSZeroRect;
+
+		for (NSUInteger step = 0; step <= DRAG_STEPS; ++step) {
+			NSRect newMarquee = NSRectFromTwoPoints(anchor, [self dragPointAtStep:step]);
+
+			[layer changeSelectionForMarqueeRect:newMarquee
+										fromRect:marquee
+									   extending:NO];
+			marquee = newMarquee;
+		}
+
+		[layer deselectAll];
+	}];
+}
+
+@end
@@ -0,0 +1,26 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKDrawableObject+Metadata.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for metadata inherited from containers.
+
+ Sets, overrides and removes metadata at each level from the drawing down to an object in a group, and moves objects
+ between containers, checking after every step that what an object inherits agrees with a walk up its containers.
+ Also checks that a change only discards what objects below it have remembered, that looking up many absent keys doesn't
+ grow an object's cache without limit, and the layer's query for objects whose metadata passes a test.
+*/
+@interface TestMetadataInheritance : XCTestCase
+
+- (void)testInheritanceFollowsChanges;
+- (void)testInheritanceFollowsMoves;
+- (void)testKeysAreCaseInsensitive;
+- (void)testChangesOnlyAffectObjectsBelow;
+- (void)testAbsentKeysAreBounded;
+- (void)testObjectsWithMetadataPassingTest;
+
+@end
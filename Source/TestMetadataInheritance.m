@@ -0,0 +1,315 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestMetadataInheritance.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKLayer+Metadata.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <DKDrawKit/DKShapeGroup.h>
+
+#define TEST_KEY @"Finish"
+
+@interface TestMetadataInheritance ()
+
+- (void)checkObject:(DKDrawableObject*)object expecting:(NSString*)expected;
+
+@end
+
+static NSString* walkedStringForKey(DKDrawableObject* object, NSString* key)
+{
+	// look the key up the slow way, one container at a time, without going through any cache
+
+	NSString* lcKey = [key lowercaseString];
+	id level = object;
+
+	while (level != nil) {
+		DKMetadataItem* item = [[level metadata] objectForKey:lcKey];
+
+		if (item)
+			return [item stringValue];
+
+		if ([level isKindOfClass:[DKDrawableObject class]])
+			level = [level container];
+		else
+			level = [level layerGroup];
+	}
+
+	return nil;
+}
+
+@implementation TestMetadataInheritance
+
+- (void)checkObject:(DKDrawableObject*)object expecting:(NSString*)expected
+{
+	XCTAssertEqualObjects(walkedStringForKey(object, TEST_KEY), expected, @"the test itself should find the expected value");
+	XCTAssertEqualObjects([object stringForKey:TEST_KEY], expected, @"the object should inherit the nearest value");
+	XCTAssertEqualObjects([object metadataObjectForKey:TEST_KEY], expected, @"the object value should match the item");
+	XCTAssertEqual([object hasMetadataForKey:TEST_KEY], (BOOL)(expected != nil), @"the object should only have the key if some container does");
+}
+
+- (void)testInheritanceFollowsChanges
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(1000, 1000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	DKDrawableShape* loose = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+	DKDrawableShape* grouped = [DKDrawableShape drawableShapeWithRect:NSMakeRect(20, 0, 10, 10)];
+	DKDrawableShape* other = [DKDrawableShape drawableShapeWithRect:NSMakeRect(40, 0, 10, 10)];
+	DKShapeGroup* group = [DKShapeGroup groupWithObjects:@[ grouped, other ]];
+
+	[drawing addLayer:layer];
+	[layer addObject:loose];
+	[layer addObject:group];
+
+	[self checkObject:loose
+			expecting:nil];
+	[self checkObject:grouped
+			expecting:nil];
+
+	// each lookup is made before and after each change, so that a stale cached answer would be caught
+
+	[drawing setString:@"matt"
+				forKey:TEST_KEY];
+	[self checkObject:loose
+			expecting:@"matt"];
+	[self checkObject:grouped
+			expecting:@"matt"];
+
+	[layer setString:@"gloss"
+			  forKey:TEST_KEY];
+	[self checkObject:loose
+			expecting:@"gloss"];
+	[self checkObject:grouped
+			expecting:@"gloss"];
+
+	[group setString:@"satin"
+			  forKey:TEST_KEY];
+	[self checkObject:loose
+			expecting:@"gloss"];
+	[self checkObject:grouped
+			expecting:@"satin"];
+
+	[grouped setString:@"raw"
+				forKey:TEST_KEY];
+	[self checkObject:grouped
+			expecting:@"raw"];
+	[self checkObject:other
+			expecting:@"satin"];
+
+	[layer setMetadataItemValue:@"eggshell"
+						 forKey:TEST_KEY];
+	[self checkObject:loose
+			expecting:@"eggshell"];
+
+	[group removeMetadataForKey:TEST_KEY];
+	[self checkObject:other
+			expecting:@"eggshell"];
+	[self checkObject:grouped
+			expecting:@"raw"];
+
+	[layer removeMetadataForKey:TEST_KEY];
+	[self checkObject:loose
+			expecting:@"matt"];
+	[self checkObject:other
+			expecting:@"matt"];
+
+	// changing the dictionary directly is only seen once the change is announced
+
+	[[drawing metadata] setObject:[DKMetadataItem metadataItemWithString:@"lacquer"]
+						   forKey:[TEST_KEY lowercaseString]];
+	[drawing metadataDidChangeKey:TEST_KEY];
+	[self checkObject:loose
+			expecting:@"lacquer"];
+
+	[drawing setMetadata:@{}];
+	[self checkObject:loose
+			expecting:nil];
+	[self checkObject:grouped
+			expecting:@"raw"];
+}
+
+- (void)testInheritanceFollowsMoves
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(1000, 1000)];
+	DKObjectDrawingLayer* first = [[DKObjectDrawingLayer alloc] init];
+	DKObjectDrawingLayer* second = [[DKObjectDrawingLayer alloc] init];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+
+	[drawing addLayer:first];
+	[drawing addLayer:second];
+	[first setString:@"first"
+			  forKey:TEST_KEY];
+	[second setString:@"second"
+			   forKey:TEST_KEY];
+
+	[first addObject:shape];
+	[self checkObject:shape
+			expecting:@"first"];
+
+	[first removeObject:shape];
+	[second addObject:shape];
+	[self checkObject:shape
+			expecting:@"second"];
+
+	DKDrawableShape* partner = [DKDrawableShape drawableShapeWithRect:NSMakeRect(20, 0, 10, 10)];
+	[second removeObject:shape];
+
+	DKShapeGroup* group = [DKShapeGroup groupWithObjects:@[ shape, partner ]];
+	[group setString:@"grouped"
+			  forKey:TEST_KEY];
+	[first addObject:group];
+	[self checkObject:shape
+			expecting:@"grouped"];
+
+	[group removeMetadataForKey:TEST_KEY];
+	[self checkObject:shape
+			expecting:@"first"];
+
+	// moving a whole layer to another group changes what everything in it inherits
+
+	DKLayerGroup* folder = [[DKLayerGroup alloc] init];
+	[first removeMetadataForKey:TEST_KEY];
+	[folder setString:@"folder"
+			   forKey:TEST_KEY];
+	[drawing addLayer:folder];
+	[self checkObject:shape
+			expecting:nil];
+
+	[drawing removeLayer:first];
+	[folder addLayer:first];
+	[self checkObject:shape
+			expecting:@"folder"];
+}
+
+- (void)testKeysAreCaseInsensitive
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(1000, 1000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+
+	[drawing addLayer:layer];
+	[layer addObject:shape];
+	[layer setFloatValue:2.5
+				  forKey:@"Thickness"];
+
+	XCTAssertEqual([shape floatValueForKey:@"thickness"], 2.5, @"keys should match whatever their case");
+	XCTAssertEqual([shape floatValueForKey:@"THICKNESS"], 2.5, @"keys should match whatever their case");
+
+	[shape setFloatValue:4.0
+				  forKey:@"thickNESS"];
+	XCTAssertEqual([shape floatValueForKey:@"Thickness"], 4.0, @"a local value should hide the inherited one whatever the case of its key");
+	XCTAssertEqualObjects([shape metadataKeys], @[ @"thickness" ], @"keys should be stored lowercased");
+}
+
+- (void)testChangesOnlyAffectObjectsBelow
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(1000, 1000)];
+	DKObjectDrawingLayer* layerA = [[DKObjectDrawingLayer alloc] init];
+	DKObjectDrawingLayer* layerB = [[DKObjectDrawingLayer alloc] init];
+	DKDrawableShape* a = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+	DKDrawableShape* b = [DKDrawableShape drawableShapeWithRect:NSMakeRect(20, 0, 10, 10)];
+
+	[drawing addLayer:layerA];
+	[drawing addLayer:layerB];
+	[layerA addObject:a];
+	[layerB addObject:b];
+	[drawing setString:@"matt"
+				forKey:TEST_KEY];
+
+	[self checkObject:a
+			expecting:@"matt"];
+	[self checkObject:b
+			expecting:@"matt"];
+
+	// the cache is private, so it's looked at through KVC
+
+	[layerA setString:@"gloss"
+			   forKey:TEST_KEY];
+
+	XCTAssertNil([a valueForKey:@"mInheritedMetadata"], @"a change to a layer should discard what its objects remembered");
+	XCTAssertNotNil([b valueForKey:@"mInheritedMetadata"], @"a change to one layer should not discard what another layer's objects remembered");
+
+	[self checkObject:a
+			expecting:@"gloss"];
+	[self checkObject:b
+			expecting:@"matt"];
+
+	[drawing setString:@"satin"
+				forKey:TEST_KEY];
+
+	XCTAssertNil([b valueForKey:@"mInheritedMetadata"], @"a change to the drawing should discard what every object remembered");
+
+	[self checkObject:b
+			expecting:@"satin"];
+}
+
+- (void)testAbsentKeysAreBounded
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(1000, 1000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+
+	[drawing addLayer:layer];
+	[layer addObject:shape];
+	[drawing setString:@"matt"
+				forKey:TEST_KEY];
+
+	for (NSUInteger i = 0; i < 1000; ++i)
+		XCTAssertNil([shape metadataItemForKey:[NSString stringWithFormat:@"absent %lu", (unsigned long)i]], @"no container has this key");
+
+	XCTAssertLessThanOrEqual([[shape valueForKey:@"mInheritedMetadata"] count], (NSUInteger)100, @"absent keys should not be remembered without limit");
+
+	[self checkObject:shape
+			expecting:@"matt"];
+}
+
+- (void)testObjectsWithMetadataPassingTest
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(1000, 1000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	NSMutableArray* doors = [NSMutableArray array];
+
+	[drawing addLayer:layer];
+	[layer setString:@"wall"
+			  forKey:@"kind"];
+
+	for (NSUInteger i = 0; i < 50; ++i) {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(i * 20, 0, 10, 10)];
+
+		[layer addObject:shape];
+
+		if (i % 5 == 0) {
+			[shape setString:@"door"
+					  forKey:@"kind"];
+			[doors addObject:shape];
+		}
+	}
+
+	__block NSUInteger tests = 0;
+	NSArray* found = [layer objectsWithMetadataKey:@"Kind"
+									   passingTest:^BOOL(DKMetadataItem* item) {
+										   ++tests;
+										   return [[item stringValue] isEqualToString:@"door"];
+									   }];
+
+	XCTAssertEqualObjects(found, doors, @"the objects with their own matching item should be found, in stacking order");
+	XCTAssertEqual(tests, [doors count] + 1, @"the item shared by the other objects should only be tested once");
+
+	found = [layer objectsWithMetadataKey:@"kind"
+							  passingTest:^BOOL(DKMetadataItem* item) {
+								  return [[item stringValue] isEqualToString:@"wall"];
+							  }];
+	XCTAssertEqual([found count], (NSUInteger)40, @"objects inheriting a matching item should be found");
+
+	found = [layer objectsWithMetadataKey:@"colour"
+							  passingTest:^BOOL(DKMetadataItem* item) {
+#pragma unused(item)
+								  return YES;
+							  }];
+	XCTAssertEqual([found count], (NSUInteger)0, @"objects without the key should not be found");
+}
+
+@end
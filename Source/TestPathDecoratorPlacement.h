@@ -0,0 +1,22 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKPathDecorator.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for computing and drawing path decorator motif placements in bulk.
+
+ Checks that the single-pass placements land where the path's own point-at-length lookup puts them, that random factors stay put
+ between renderings, and times placing and drawing 100,000 motifs into an offscreen bitmap.
+*/
+@interface TestPathDecoratorPlacement : XCTestCase
+
+- (void)testPlacementsFollowPath;
+- (void)testLeadInShrinksMotifs;
+- (void)testWobbleIsStable;
+- (void)testPerformanceOfPlacement;
+
+@end
@@ -0,0 +1,152 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestPathDecoratorPlacement.h"
+#import <DKDrawKit/NSBezierPath+Geometry.h>
+
+#define BITMAP_SIZE 512
+#define PLACEMENT_COUNT 100000
+
+@interface TestPathDecoratorPlacement ()
+
+- (NSImage*)motifImage;
+- (NSBezierPath*)curvedPath;
+
+@end
+
+@implementation TestPathDecoratorPlacement
+
+- (NSImage*)motifImage
+{
+	NSImage* image = [[NSImage alloc] initWithSize:NSMakeSize(8, 6)];
+
+	[image lockFocus];
+	[[NSColor redColor] set];
+	NSRectFill(NSMakeRect(0, 0, 8, 6));
+	[image unlockFocus];
+
+	return image;
+}
+
+- (NSBezierPath*)curvedPath
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:NSMakePoint(10, 10)];
+	[path curveToPoint:NSMakePoint(400, 300)
+		 controlPoint1:NSMakePoint(100, 400)
+		 controlPoint2:NSMakePoint(300, -100)];
+	[path lineToPoint:NSMakePoint(20, 450)];
+
+	return path;
+}
+
+- (void)testPlacementsFollowPath
+{
+	DKPathDecorator* decorator = [DKPathDecorator pathDecoratorWithImage:[self motifImage]];
+	NSBezierPath* path = [self curvedPath];
+
+	[decorator setInterval:25];
+
+	NSUInteger count = [decorator placeMotifsAlongPath:path];
+	const DKMotifPlacement* placements = [decorator motifPlacements];
+	CGFloat length = [path length];
+
+	XCTAssertEqual(count, (NSUInteger)floor(length / 25) + 1, @"expected one placement per interval along the path");
+	XCTAssertEqual([decorator motifPlacementCount], count, @"placement count should be kept");
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		CGFloat slope;
+		NSPoint expected = [path pointOnPathAtLength:i * 25
+											   slope:&slope];
+		NSPoint centre = NSMakePoint(NSMidX(placements[i].bounds), NSMidY(placements[i].bounds));
+
+		XCTAssertEqualWithAccuracy(centre.x, expected.x, 0.5, @"placement %lu is off the path", (unsigned long)i);
+		XCTAssertEqualWithAccuracy(centre.y, expected.y, 0.5, @"placement %lu is off the path", (unsigned long)i);
+		XCTAssertEqualWithAccuracy(atan2(placements[i].transform.b, placements[i].transform.a), slope, 0.02, @"placement %lu is not normal to the path", (unsigned long)i);
+	}
+}
+
+- (void)testLeadInShrinksMotifs
+{
+	DKPathDecorator* decorator = [DKPathDecorator pathDecoratorWithImage:[self motifImage]];
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:NSZeroPoint];
+	[path lineToPoint:NSMakePoint(1000, 0)];
+
+	[decorator setInterval:10];
+	[decorator setLeadInLength:100];
+
+	NSUInteger count = [decorator placeMotifsAlongPath:path];
+	const DKMotifPlacement* placements = [decorator motifPlacements];
+
+	// the motif at the very start has zero size and is left out
+
+	XCTAssertEqual(count, (NSUInteger)100, @"the zero-sized first motif should be skipped");
+	XCTAssertLessThan(NSWidth(placements[0].bounds), NSWidth(placements[5].bounds), @"motifs should grow along the lead-in");
+	XCTAssertEqualWithAccuracy(NSWidth(placements[50].bounds), 8.0, 0.001, @"motifs past the lead-in should be full size");
+}
+
+- (void)testWobbleIsStable
+{
+	DKPathDecorator* decorator = [DKPathDecorator pathDecoratorWithImage:[self motifImage]];
+	NSBezierPath* path = [self curvedPath];
+
+	[decorator setInterval:10];
+	[decorator setWobblyness:0.5];
+	[decorator setScaleRandomness:0.5];
+
+	NSUInteger count = [decorator placeMotifsAlongPath:path];
+	DKMotifPlacement* first = malloc(count * sizeof(DKMotifPlacement));
+
+	memcpy(first, [decorator motifPlacements], count * sizeof(DKMotifPlacement));
+
+	XCTAssertEqual([decorator placeMotifsAlongPath:path], count, @"placing twice should give the same count");
+	XCTAssertEqual(memcmp(first, [decorator motifPlacements], count * sizeof(DKMotifPlacement)), 0, @"random factors should not change between renderings");
+
+	free(first);
+}
+
+- (void)testPerformanceOfPlacement
+{
+	DKPathDecorator* decorator = [DKPathDecorator pathDecoratorWithImage:[self motifImage]];
+	NSBitmapImageRep* bitmap = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	   pixelsWide:BITMAP_SIZE
+																	   pixelsHigh:BITMAP_SIZE
+																	bitsPerSample:8
+																  samplesPerPixel:4
+																		 hasAlpha:YES
+																		 isPlanar:NO
+																   colorSpaceName:NSCalibratedRGBColorSpace
+																	  bytesPerRow:0
+																	 bitsPerPixel:0];
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	// a zigzag that wanders well outside the bitmap, so that both placement and culling are exercised
+
+	[path moveToPoint:NSZeroPoint];
+
+	for (NSUInteger i = 1; i <= 1000; ++i)
+		[path lineToPoint:NSMakePoint(i * 20.0, (i & 1) ? 100.0 : 0.0)];
+
+	[decorator setInterval:[path length] / (PLACEMENT_COUNT - 1)];
+	[decorator setWobblyness:0.2];
+
+	[self measureBlock:^{
+		[NSGraphicsContext saveGraphicsState];
+		[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+		NSUInteger count = [decorator placeMotifsAlongPath:path];
+
+		[decorator drawMotifPlacements:[decorator motifPlacements]
+								 count:count];
+		[NSGraphicsContext restoreGraphicsState];
+	}];
+
+	XCTAssertGreaterThanOrEqual([decorator motifPlacementCount], (NSUInteger)(PLACEMENT_COUNT - 1), @"expected about %d placements", PLACEMENT_COUNT);
+}
+
+@end
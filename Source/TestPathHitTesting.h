@@ -0,0 +1,24 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/NSBezierPath-OAExtensions.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for hit testing paths against rects and points.
+
+ Checks that rects away from a path, inside its outline or enclosing it give the right answer, that passing a flat copy of the path
+ agrees with flattening it afresh, and that the first segment near a point is found. Times testing a grid of rects against a long path,
+ flattening it for each rect and once for all of them.
+*/
+@interface TestPathHitTesting : XCTestCase
+
+- (void)testRectIntersection;
+- (void)testFlatPathAgrees;
+- (void)testSegmentHit;
+- (void)testPerformanceOfRectIntersection;
+- (void)testPerformanceOfRectIntersectionWithFlatPath;
+
+@end
@@ -0,0 +1,141 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestPathHitTesting.h"
+#import <DKDrawKit/DKFlatPath.h>
+
+#define ZIGZAG_SEGMENTS 1000
+#define GRID_SIZE 60
+
+@interface TestPathHitTesting ()
+
+- (NSBezierPath*)zigzagPath;
+- (NSUInteger)countRectsIntersectingPath:(NSBezierPath*)path flatPath:(DKFlatPath*)flatPath;
+
+@end
+
+@implementation TestPathHitTesting
+
+- (NSBezierPath*)zigzagPath
+{
+	// alternate lines and curves across 0..1000 x 0..100
+
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:NSZeroPoint];
+
+	for (NSUInteger i = 1; i <= ZIGZAG_SEGMENTS; ++i) {
+		NSPoint p = NSMakePoint(i, (i % 2) ? 100 : 0);
+
+		if (i % 3)
+			[path lineToPoint:p];
+		else
+			[path curveToPoint:p
+				 controlPoint1:NSMakePoint(i - 0.5, 50)
+				 controlPoint2:NSMakePoint(i - 0.25, 75)];
+	}
+
+	return path;
+}
+
+- (NSUInteger)countRectsIntersectingPath:(NSBezierPath*)path flatPath:(DKFlatPath*)flatPath
+{
+	NSRect bounds = NSInsetRect([path bounds], -100, -100);
+	NSSize cell = NSMakeSize(NSWidth(bounds) / GRID_SIZE, NSHeight(bounds) / GRID_SIZE);
+	NSUInteger hits = 0;
+
+	for (NSUInteger row = 0; row < GRID_SIZE; ++row) {
+		for (NSUInteger col = 0; col < GRID_SIZE; ++col) {
+			NSRect r = NSMakeRect(NSMinX(bounds) + col * cell.width, NSMinY(bounds) + row * cell.height, cell.width * 0.5, cell.height * 0.5);
+
+			if ([path intersectsRect:r
+							flatPath:flatPath])
+				++hits;
+		}
+	}
+
+	return hits;
+}
+
+- (void)testRectIntersection
+{
+	NSBezierPath* square = [NSBezierPath bezierPathWithRect:NSMakeRect(0, 0, 100, 100)];
+	NSBezierPath* circle = [NSBezierPath bezierPathWithOvalInRect:NSMakeRect(0, 0, 100, 100)];
+
+	XCTAssertFalse([square intersectsRect:NSMakeRect(500, 500, 10, 10)], @"a rect away from the path should not intersect it");
+	XCTAssertFalse([square intersectsRect:NSMakeRect(40, 40, 20, 20)], @"a rect inside the outline should not intersect it");
+	XCTAssertTrue([square intersectsRect:NSMakeRect(90, 40, 20, 20)], @"a rect across an edge should intersect the path");
+	XCTAssertTrue([square intersectsRect:NSMakeRect(-10, -10, 200, 200)], @"a rect enclosing the path should intersect it");
+	XCTAssertTrue([square intersectsRect:NSMakeRect(50, -10, 0, 20)], @"a rect with no width should still intersect an edge it crosses");
+
+	XCTAssertFalse([circle intersectsRect:NSMakeRect(0, 0, 5, 5)], @"a rect in the corner of a circle's bounds should not intersect it");
+	XCTAssertTrue([circle intersectsRect:NSMakeRect(-5, 45, 10, 10)], @"a rect across the curve should intersect it");
+
+	NSBezierPath* moveOnly = [NSBezierPath bezierPath];
+
+	[moveOnly moveToPoint:NSMakePoint(50, 50)];
+	XCTAssertFalse([moveOnly intersectsRect:NSMakeRect(0, 0, 100, 100)], @"a path with no segments should not intersect anything");
+}
+
+- (void)testFlatPathAgrees
+{
+	NSBezierPath* path = [self zigzagPath];
+	DKFlatPath* flatPath = [DKFlatPath flatPathWithBezierPath:path];
+	NSUInteger plain = [self countRectsIntersectingPath:path
+											   flatPath:nil];
+
+	XCTAssertGreaterThan(plain, (NSUInteger)0, @"some rects should intersect the path");
+	XCTAssertLessThan(plain, (NSUInteger)(GRID_SIZE * GRID_SIZE), @"some rects should miss the path");
+	XCTAssertEqual([self countRectsIntersectingPath:path
+										   flatPath:flatPath],
+		plain, @"a flat copy of the path should give the same results");
+}
+
+- (void)testSegmentHit
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:NSZeroPoint];
+	[path lineToPoint:NSMakePoint(100, 0)];
+	[path lineToPoint:NSMakePoint(100, 100)];
+	[path lineToPoint:NSMakePoint(0, 100)];
+
+	XCTAssertEqual([path segmentHitByPoint:NSMakePoint(100, 50)
+								   padding:2],
+		(NSInteger)2, @"the second segment should be hit");
+	XCTAssertEqual([path segmentHitByPoint:NSMakePoint(100, 0)
+								   padding:2],
+		(NSInteger)1, @"the first of two segments meeting at the point should be found");
+	XCTAssertEqual([path segmentHitByPoint:NSMakePoint(50, 50)
+								   padding:2],
+		(NSInteger)0, @"a point away from every segment should not hit");
+	XCTAssertEqual([path segmentHitByPoint:NSMakePoint(1000, 1000)
+								   padding:2],
+		(NSInteger)0, @"a point outside the bounds should not hit");
+}
+
+- (void)testPerformanceOfRectIntersection
+{
+	NSBezierPath* path = [self zigzagPath];
+
+	[self measureBlock:^{
+		[self countRectsIntersectingPath:path
+								flatPath:nil];
+	}];
+}
+
+- (void)testPerformanceOfRectIntersectionWithFlatPath
+{
+	NSBezierPath* path = [self zigzagPath];
+	DKFlatPath* flatPath = [DKFlatPath flatPathWithBezierPath:path];
+
+	[self measureBlock:^{
+		[self countRectsIntersectingPath:path
+								flatPath:flatPath];
+	}];
+}
+
+@end
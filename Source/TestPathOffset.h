@@ -0,0 +1,26 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKFlatPath+Offset.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for the path offset engine.
+
+ Checks the offsets and stroke outlines of simple shapes whose exact results are known: that curves stay within tolerance of the true
+ offset, that outer corners are joined and inner corners trimmed, even where a path folds back and the loop spans many segments, and
+ that caps and tapers give the expected extents. Times outlining a long path with a loop at every other bend.
+*/
+@interface TestPathOffset : XCTestCase
+
+- (void)testOffsetSquare;
+- (void)testOffsetCircle;
+- (void)testInnerCornerLoopRemoved;
+- (void)testStrokeOutlineCaps;
+- (void)testTaperedStroke;
+- (void)testFoldedBackLoopRemoved;
+- (void)testPerformanceOfOffsettingLongPath;
+
+@end
@@ -0,0 +1,205 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestPathOffset.h"
+#import <DKDrawKit/NSBezierPath+Geometry.h>
+
+#define OFFSET_TEST_TOLERANCE 0.05
+#define FOLD_SEGMENTS 40
+#define WAVE_SEGMENTS 2000
+
+static BOOL rectsNearlyEqual(NSRect a, NSRect b, CGFloat tol)
+{
+	return fabs(NSMinX(a) - NSMinX(b)) < tol && fabs(NSMinY(a) - NSMinY(b)) < tol && fabs(NSWidth(a) - NSWidth(b)) < tol && fabs(NSHeight(a) - NSHeight(b)) < tol;
+}
+
+@implementation TestPathOffset
+
+- (void)testOffsetSquare
+{
+	// bezierPathWithRect: runs anticlockwise, so positive offsets are inwards
+
+	DKFlatPath* square = [DKFlatPath flatPathWithBezierPath:[NSBezierPath bezierPathWithRect:NSMakeRect(0, 0, 100, 100)]];
+	DKFlatPath* inset = [square flatPathByOffsettingFrom:10
+													  to:10
+										   lineJoinStyle:NSMiterLineJoinStyle
+											  miterLimit:10
+											   tolerance:OFFSET_TEST_TOLERANCE];
+	DKFlatPath* outset = [square flatPathByOffsettingFrom:-10
+													   to:-10
+											lineJoinStyle:NSMiterLineJoinStyle
+											   miterLimit:10
+												tolerance:OFFSET_TEST_TOLERANCE];
+
+	XCTAssertTrue(rectsNearlyEqual([[inset bezierPath] bounds], NSMakeRect(10, 10, 80, 80), 1e-6), @"inset square has wrong bounds (%@)", NSStringFromRect([[inset bezierPath] bounds]));
+	XCTAssertTrue(rectsNearlyEqual([[outset bezierPath] bounds], NSMakeRect(-10, -10, 120, 120), 1e-6), @"mitered outset square has wrong bounds (%@)", NSStringFromRect([[outset bezierPath] bounds]));
+
+	// a bevelled outset cuts the corners off
+
+	outset = [square flatPathByOffsettingFrom:-10
+										   to:-10
+								lineJoinStyle:NSBevelLineJoinStyle
+								   miterLimit:10
+									tolerance:OFFSET_TEST_TOLERANCE];
+
+	XCTAssertFalse([[outset bezierPath] containsPoint:NSMakePoint(-9, -9)], @"bevelled corner should not contain the miter point");
+	XCTAssertTrue([[outset bezierPath] containsPoint:NSMakePoint(-1, -1)], @"bevelled corner should contain the original corner");
+}
+
+- (void)testOffsetCircle
+{
+	DKFlatPath* circle = [DKFlatPath flatPathWithBezierPath:[NSBezierPath bezierPathWithOvalInRect:NSMakeRect(-50, -50, 100, 100)]];
+	CGFloat offsets[2] = { 10, -10 };
+	CGFloat radii[2];
+	NSUInteger k;
+
+	for (k = 0; k < 2; ++k) {
+		DKFlatPath* offset = [circle flatPathByOffsettingFrom:offsets[k]
+														   to:offsets[k]
+												lineJoinStyle:NSMiterLineJoinStyle
+												   miterLimit:10
+													tolerance:OFFSET_TEST_TOLERANCE];
+
+		// every on-path point must lie on the offset circle, within tolerance
+
+		NSRect bounds = [[offset bezierPath] bounds];
+		CGFloat r = NSWidth(bounds) * 0.5;
+		NSUInteger i;
+
+		for (i = 0; i < [offset elementCount]; ++i) {
+			NSPoint p = [offset endPointOfElement:i];
+			XCTAssertEqualWithAccuracy(hypot(p.x, p.y), r, OFFSET_TEST_TOLERANCE, @"point %lu of offset circle is off the circle", (unsigned long)i);
+		}
+
+		radii[k] = r;
+	}
+
+	XCTAssertEqualWithAccuracy(MIN(radii[0], radii[1]), 40, OFFSET_TEST_TOLERANCE, @"inner offset circle has wrong radius");
+	XCTAssertEqualWithAccuracy(MAX(radii[0], radii[1]), 60, OFFSET_TEST_TOLERANCE, @"outer offset circle has wrong radius");
+}
+
+- (void)testInnerCornerLoopRemoved
+{
+	// an L shape turning left; its left offset is on the inside of the bend and the two offset lines must meet at a single corner
+
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	[path moveToPoint:NSMakePoint(0, 0)];
+	[path lineToPoint:NSMakePoint(100, 0)];
+	[path lineToPoint:NSMakePoint(100, 100)];
+
+	DKFlatPath* offset = [[DKFlatPath flatPathWithBezierPath:path] flatPathByOffsettingFrom:10
+																						  to:10
+																			   lineJoinStyle:NSRoundLineJoinStyle
+																				  miterLimit:10
+																				   tolerance:OFFSET_TEST_TOLERANCE];
+
+	XCTAssertEqual([offset elementCount], (NSUInteger)3, @"inner corner was not trimmed");
+	XCTAssertTrue(NSEqualPoints([offset endPointOfElement:1], NSMakePoint(90, 10)), @"inner corner is in the wrong place (%@)", NSStringFromPoint([offset endPointOfElement:1]));
+	XCTAssertTrue(NSEqualPoints([offset endPointOfElement:2], NSMakePoint(90, 100)), @"offset does not end in the right place");
+}
+
+- (void)testStrokeOutlineCaps
+{
+	DKFlatPath* line = [[DKFlatPath alloc] init];
+	[line moveToPoint:NSMakePoint(0, 0)];
+	[line lineToPoint:NSMakePoint(100, 0)];
+
+	NSRect butt = [[[line strokeOutlineWithStartWidth:10
+											 endWidth:10
+										lineJoinStyle:NSMiterLineJoinStyle
+										 lineCapStyle:NSButtLineCapStyle
+										   miterLimit:10
+											tolerance:OFFSET_TEST_TOLERANCE] bezierPath] bounds];
+	NSRect square = [[[line strokeOutlineWithStartWidth:10
+											   endWidth:10
+										  lineJoinStyle:NSMiterLineJoinStyle
+										   lineCapStyle:NSSquareLineCapStyle
+											 miterLimit:10
+											  tolerance:OFFSET_TEST_TOLERANCE] bezierPath] bounds];
+	NSRect round = [[[line strokeOutlineWithStartWidth:10
+											  endWidth:10
+										 lineJoinStyle:NSMiterLineJoinStyle
+										  lineCapStyle:NSRoundLineCapStyle
+											miterLimit:10
+											 tolerance:OFFSET_TEST_TOLERANCE] bezierPath] bounds];
+
+	XCTAssertTrue(rectsNearlyEqual(butt, NSMakeRect(0, -5, 100, 10), 1e-6), @"butt capped outline has wrong bounds (%@)", NSStringFromRect(butt));
+	XCTAssertTrue(rectsNearlyEqual(square, NSMakeRect(-5, -5, 110, 10), 1e-6), @"square capped outline has wrong bounds (%@)", NSStringFromRect(square));
+	XCTAssertTrue(rectsNearlyEqual(round, NSMakeRect(-5, -5, 110, 10), 0.01), @"round capped outline has wrong bounds (%@)", NSStringFromRect(round));
+}
+
+- (void)testTaperedStroke
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	[path moveToPoint:NSMakePoint(0, 0)];
+	[path lineToPoint:NSMakePoint(100, 0)];
+	[path setLineCapStyle:NSButtLineCapStyle];
+
+	NSBezierPath* outline = [path strokedPathWithStartingWidth:2
+												   endingWidth:20];
+
+	XCTAssertTrue(rectsNearlyEqual([outline bounds], NSMakeRect(0, -10, 100, 20), 1e-6), @"tapered outline has wrong bounds (%@)", NSStringFromRect([outline bounds]));
+	XCTAssertTrue([outline containsPoint:NSMakePoint(50, 5)], @"tapered outline should be 11 wide half way along");
+	XCTAssertFalse([outline containsPoint:NSMakePoint(10, 5)], @"tapered outline should be under 4 wide near the start");
+}
+
+- (void)testFoldedBackLoopRemoved
+{
+	// a long, narrow V made of many short lines. Its left offset is on the inside of the V, where the two sides' offsets cross about
+	// 100 units back from the point - 20 segments either side of the bend - and everything beyond the crossing is a loop to remove.
+
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	NSUInteger i;
+
+	[path moveToPoint:NSZeroPoint];
+
+	for (i = 1; i <= FOLD_SEGMENTS; ++i)
+		[path lineToPoint:NSMakePoint(200.0 * i / FOLD_SEGMENTS, 0)];
+
+	for (i = 1; i <= FOLD_SEGMENTS; ++i)
+		[path lineToPoint:NSMakePoint(200.0 - 200.0 * i / FOLD_SEGMENTS, 40.0 * i / FOLD_SEGMENTS)];
+
+	DKFlatPath* offset = [[DKFlatPath flatPathWithBezierPath:path] flatPathByOffsettingFrom:10
+																						  to:10
+																			   lineJoinStyle:NSMiterLineJoinStyle
+																				  miterLimit:10
+																				   tolerance:OFFSET_TEST_TOLERANCE];
+
+	// the sides are 10 from the crossing, which is on the bisector of the V's angle
+
+	CGFloat halfAngle = 0.5 * atan2(40, 200);
+	CGFloat crossingX = 200.0 - (10.0 / sin(halfAngle)) * cos(halfAngle);
+	NSRect bounds = [[offset bezierPath] bounds];
+
+	XCTAssertEqualWithAccuracy(NSMaxX(bounds), crossingX, 0.5, @"the loop beyond the crossing was not removed (%@)", NSStringFromRect(bounds));
+
+	for (i = 1; i < [offset elementCount]; ++i)
+		XCTAssertNotEqual([offset elementTypes][i], NSMoveToBezierPathElement, @"offset should be a single subpath");
+}
+
+- (void)testPerformanceOfOffsettingLongPath
+{
+	// a wave whose bends on one side are tighter than the offset, so it has a loop to remove at every other peak
+
+	DKFlatPath* wave = [[DKFlatPath alloc] init];
+	NSUInteger i;
+
+	[wave moveToPoint:NSZeroPoint];
+
+	for (i = 1; i <= WAVE_SEGMENTS; ++i)
+		[wave lineToPoint:NSMakePoint(i * 2.0, 20.0 * sin(i * 0.3))];
+
+	[self measureBlock:^{
+		[wave strokeOutlineWithStartWidth:16
+								 endWidth:16
+							lineJoinStyle:NSRoundLineJoinStyle
+							 lineCapStyle:NSButtLineCapStyle
+							   miterLimit:10
+								tolerance:OFFSET_TEST_TOLERANCE];
+	}];
+}
+
+@end
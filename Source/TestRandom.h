@@ -0,0 +1,28 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKRandom.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for DKRandom.
+
+ Pins the sequences produced for fixed seeds, so that anything drawn from a seeded generator renders identically from one
+ release to the next, and checks that batches and per-thread generators agree with single values, that the shared hash is FNV-1a,
+ and that a rough stroke's seed is undoable. Times filling a million values in batches and one at a time.
+*/
+@interface TestRandom : XCTestCase
+
+- (void)testSequencesArePinned;
+- (void)testUnitValuesArePinned;
+- (void)testBatchesMatchSingleValues;
+- (void)testThreadGenerators;
+- (void)testSignedBatchWithNoAmount;
+- (void)testHashIsFNV1a;
+- (void)testRoughStrokeSeedIsUndoable;
+- (void)testPerformanceOfUnitBatches;
+- (void)testPerformanceOfSingleValues;
+
+@end
@@ -0,0 +1,193 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestRandom.h"
+#import <DKDrawKit/DKRoughStroke.h>
+#import <DKDrawKit/DKStyle.h>
+#import <DKDrawKit/DKUndoManager.h>
+
+#define NUMBER_OF_VALUES 200
+#define BENCHMARK_VALUES 1000000
+
+@implementation TestRandom
+
+- (void)testSequencesArePinned
+{
+	// if these change, every seeded dither, roughened stroke and annealed route changes with them
+
+	static const uint64_t expected0[] = { 0x99EC5F36CB75F2B4ULL, 0xBF6E1F784956452AULL, 0x1A5F849D4933E6E0ULL, 0x6AA594F1262D2D2CULL };
+	static const uint64_t expected42[] = { 0x15780B2E0C2EC716ULL, 0x6104D9866D113A7EULL, 0xAE17533239E499A1ULL, 0xECB8AD4703B360A1ULL };
+	DKRandomState rng;
+	NSUInteger i;
+
+	DKRandomSeed(&rng, 0);
+	for (i = 0; i < 4; ++i)
+		XCTAssertEqual(DKRandomNext(&rng), expected0[i], @"sequence for seed 0 changed at %lu", (unsigned long)i);
+
+	DKRandomSeed(&rng, 42);
+	for (i = 0; i < 4; ++i)
+		XCTAssertEqual(DKRandomNext(&rng), expected42[i], @"sequence for seed 42 changed at %lu", (unsigned long)i);
+}
+
+- (void)testUnitValuesArePinned
+{
+	static const CGFloat expected[] = { 0.083862971059882163, 0.37898025066266861, 0.68004341102813937, 0.92469294532538759 };
+	DKRandomState rng;
+
+	DKRandomSeed(&rng, 42);
+	for (NSUInteger i = 0; i < 4; ++i)
+		XCTAssertEqual(DKRandomUnit(&rng), expected[i], @"unit value for seed 42 changed at %lu", (unsigned long)i);
+
+	DKRandomSeed(&rng, 42);
+	for (NSUInteger i = 0; i < 4; ++i)
+		XCTAssertEqualWithAccuracy(DKRandomSigned(&rng), expected[i] - 0.5, 1e-15, @"signed value for seed 42 changed at %lu", (unsigned long)i);
+}
+
+- (void)testBatchesMatchSingleValues
+{
+	DKRandomState single, batch;
+	CGFloat values[NUMBER_OF_VALUES];
+	NSUInteger i;
+
+	// the count crosses a chunk boundary inside the batch functions on purpose
+
+	DKRandomSeed(&single, 7);
+	DKRandomSeed(&batch, 7);
+	DKRandomFillUnit(&batch, values, NUMBER_OF_VALUES);
+
+	for (i = 0; i < NUMBER_OF_VALUES; ++i)
+		XCTAssertEqual(values[i], DKRandomUnit(&single), @"batch differs from single values at %lu", (unsigned long)i);
+
+	XCTAssertEqual(DKRandomNext(&batch), DKRandomNext(&single), @"batch left the generator in a different state");
+
+	DKRandomSeed(&single, 7);
+	DKRandomSeed(&batch, 7);
+	DKRandomFillSigned(&batch, values, NUMBER_OF_VALUES, 4.0);
+
+	for (i = 0; i < NUMBER_OF_VALUES; ++i) {
+		XCTAssertEqualWithAccuracy(values[i], DKRandomSigned(&single) * 4.0, 1e-12, @"signed batch differs from single values at %lu", (unsigned long)i);
+		XCTAssert(values[i] >= -2.0 && values[i] < 2.0, @"signed batch value %f out of range", values[i]);
+	}
+}
+
+- (void)testThreadGenerators
+{
+	DKRandomState rng;
+	__block CGFloat otherThreadValue = 0;
+	dispatch_semaphore_t done = dispatch_semaphore_create(0);
+
+	DKRandomSeed(&rng, 99);
+	[DKRandom seedThreadGenerator:99];
+
+	// reseeding and drawing on another thread must not disturb this thread's sequence. dispatch_sync can run its block on the
+	// calling thread, so dispatch asynchronously and wait.
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		[DKRandom seedThreadGenerator:99];
+		otherThreadValue = [DKRandom randomNumber];
+		[DKRandom randomNumber];
+		dispatch_semaphore_signal(done);
+	});
+	dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+
+	CGFloat first = DKRandomUnit(&rng);
+
+	XCTAssertEqual(otherThreadValue, first, @"other thread's generator doesn't match a generator with the same seed");
+	XCTAssertEqual([DKRandom randomNumber], first, @"thread generator doesn't match a generator with the same seed");
+	XCTAssertEqual([DKRandom randomNumber], DKRandomUnit(&rng), @"thread generator was disturbed by another thread");
+}
+
+- (void)testSignedBatchWithNoAmount
+{
+	DKRandomState rng;
+	CGFloat values[NUMBER_OF_VALUES];
+
+	DKRandomSeed(&rng, 7);
+	DKRandomFillSigned(&rng, values, NUMBER_OF_VALUES, 0.0);
+
+	for (NSUInteger i = 0; i < NUMBER_OF_VALUES; ++i)
+		XCTAssertEqual(values[i], (CGFloat)0.0, @"an amount of 0 should give no variation, not unit values");
+}
+
+- (void)testHashIsFNV1a
+{
+	// published FNV-1a test vectors
+
+	XCTAssertEqual(DKRandomHashBytes(kDKRandomHashInitial, "", 0), 0xCBF29CE484222325ULL, @"hashing nothing should leave the initial value");
+	XCTAssertEqual(DKRandomHashBytes(kDKRandomHashInitial, "a", 1), 0xAF63DC4C8601EC8CULL, @"hash of \"a\" is wrong");
+	XCTAssertEqual(DKRandomHashBytes(kDKRandomHashInitial, "foobar", 6), 0x85944171F73967E8ULL, @"hash of \"foobar\" is wrong");
+	XCTAssertEqual(DKRandomHashBytes(DKRandomHashBytes(kDKRandomHashInitial, "foo", 3), "bar", 3), 0x85944171F73967E8ULL, @"hashing in pieces should match hashing at once");
+}
+
+- (void)testRoughStrokeSeedIsUndoable
+{
+	DKUndoManager* um = [[DKUndoManager alloc] init];
+	DKStyle* style = [[DKStyle alloc] init];
+	DKRoughStroke* stroke = [[DKRoughStroke alloc] init];
+	uint64_t original = [stroke seed];
+	__block BOOL observed = NO;
+
+	[um setGroupsByEvent:NO];
+	[style setUndoManager:um];
+	[style addRenderer:stroke];
+
+	id observer = [[NSNotificationCenter defaultCenter] addObserverForName:kDKStyleDidChangeNotification
+																	object:style
+																	 queue:nil
+																usingBlock:^(NSNotification* note) {
+#pragma unused(note)
+																	observed = YES;
+																}];
+
+	[um beginUndoGrouping];
+	[stroke setSeed:original + 1];
+	[um endUndoGrouping];
+
+	[[NSNotificationCenter defaultCenter] removeObserver:observer];
+
+	XCTAssertTrue(observed, @"the style should see the seed change");
+	XCTAssertTrue([um canUndo], @"changing the seed should be undoable");
+
+	[um undo];
+	XCTAssertEqual([stroke seed], original, @"undo should restore the seed");
+
+	[um redo];
+	XCTAssertEqual([stroke seed], original + 1, @"redo should set the seed again");
+}
+
+- (void)testPerformanceOfUnitBatches
+{
+	DKRandomState rng;
+	CGFloat* values = malloc(BENCHMARK_VALUES * sizeof(CGFloat));
+
+	DKRandomSeed(&rng, 1);
+
+	[self measureBlock:^{
+		DKRandomState local = rng;
+		DKRandomFillUnit(&local, values, BENCHMARK_VALUES);
+	}];
+
+	free(values);
+}
+
+- (void)testPerformanceOfSingleValues
+{
+	DKRandomState rng;
+	CGFloat* values = malloc(BENCHMARK_VALUES * sizeof(CGFloat));
+
+	DKRandomSeed(&rng, 1);
+
+	[self measureBlock:^{
+		DKRandomState local = rng;
+
+		for (NSUInteger i = 0; i < BENCHMARK_VALUES; ++i)
+			values[i] = DKRandomUnit(&local);
+	}];
+
+	free(values);
+}
+
+@end
@@ -0,0 +1,33 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKRasterEffectPipeline.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for the CPU raster effects and DKCIFilterRastGroup's use of them.
+
+ Checks the blur, colour matrix, blend and drop shadow against known results, that the buffer pool reuses what it is given back and
+ frees the oldest first, that Core Image filter names map to pipelines, that a filter group captures an object once and reuses the
+ result until the object, the filter or the scale changes, and that hit-testing leaves that result alone. Times the common effect
+ chains on a 512 pixel square image, and redrawing 1,000 shadowed shapes.
+*/
+@interface TestRasterEffects : XCTestCase
+
+- (void)testGaussianBlurKeepsCoverage;
+- (void)testColourMatrix;
+- (void)testBlendModes;
+- (void)testDropShadow;
+- (void)testPipelineFromFilter;
+- (void)testPoolReusesBuffers;
+- (void)testPoolTrimsOldestFirst;
+- (void)testFilterGroupCachesPerObject;
+- (void)testHitTestingLeavesCache;
+- (void)testPerformanceOfBlur;
+- (void)testPerformanceOfDropShadow;
+- (void)testPerformanceOfGlow;
+- (void)testPerformanceOfRedrawingShadowedShapes;
+
+@end
@@ -0,0 +1,423 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestRasterEffects.h"
+#import <DKDrawKit/DKCIFilterRastGroup.h>
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKFill.h>
+
+#define BITMAP_SIZE 512
+#define SHAPE_COUNT 1000
+
+/** @brief A fill that counts how often it is drawn, to tell whether a filter group captured its contents again.
+ */
+@interface TestCountingFill : DKFill {
+@public
+	NSUInteger mRenderCount;
+}
+
+@end
+
+@implementation TestCountingFill
+
+- (void)render:(id<DKRenderable>)object
+{
+	++mRenderCount;
+	[super render:object];
+}
+
+@end
+
+#pragma mark -
+
+@interface TestRasterEffects ()
+
+- (void)getSquareBuffer:(DKRasterBuffer*)buffer;
+- (uint8_t*)pixelOfBuffer:(DKRasterBuffer*)buffer x:(size_t)x y:(size_t)y;
+- (NSUInteger)totalAlphaOfBuffer:(DKRasterBuffer*)buffer;
+- (void)renderShapes:(NSArray<DKDrawableShape*>*)shapes withGroup:(DKCIFilterRastGroup*)group scale:(CGFloat)scale;
+- (void)measurePipeline:(DKRasterEffectPipeline*)pipeline;
+
+@end
+
+@implementation TestRasterEffects
+
+- (void)getSquareBuffer:(DKRasterBuffer*)buffer
+{
+	// an opaque red square in the middle half of a BITMAP_SIZE buffer
+
+	XCTAssertTrue([[DKRasterBufferPool sharedPool] getBuffer:buffer
+													   width:BITMAP_SIZE
+													  height:BITMAP_SIZE],
+		@"pool should supply a buffer");
+
+	for (size_t y = BITMAP_SIZE / 4; y < BITMAP_SIZE * 3 / 4; ++y) {
+		for (size_t x = BITMAP_SIZE / 4; x < BITMAP_SIZE * 3 / 4; ++x) {
+			uint8_t* p = [self pixelOfBuffer:buffer
+										   x:x
+										   y:y];
+
+			p[0] = 255;
+			p[3] = 255;
+		}
+	}
+}
+
+- (uint8_t*)pixelOfBuffer:(DKRasterBuffer*)buffer x:(size_t)x y:(size_t)y
+{
+	return buffer->data + y * buffer->rowBytes + x * 4;
+}
+
+- (NSUInteger)totalAlphaOfBuffer:(DKRasterBuffer*)buffer
+{
+	NSUInteger total = 0;
+
+	for (size_t y = 0; y < buffer->height; ++y)
+		for (size_t x = 0; x < buffer->width; ++x)
+			total += [self pixelOfBuffer:buffer
+									   x:x
+									   y:y][3];
+
+	return total;
+}
+
+- (void)renderShapes:(NSArray<DKDrawableShape*>*)shapes withGroup:(DKCIFilterRastGroup*)group scale:(CGFloat)scale
+{
+	NSBitmapImageRep* bitmap = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	   pixelsWide:BITMAP_SIZE
+																	   pixelsHigh:BITMAP_SIZE
+																	bitsPerSample:8
+																  samplesPerPixel:4
+																		 hasAlpha:YES
+																		 isPlanar:NO
+																   colorSpaceName:NSCalibratedRGBColorSpace
+																	  bytesPerRow:0
+																	 bitsPerPixel:0];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+	CGContextScaleCTM([[NSGraphicsContext currentContext] graphicsPort], scale, scale);
+
+	for (DKDrawableShape* shape in shapes)
+		[group render:shape];
+
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (void)measurePipeline:(DKRasterEffectPipeline*)pipeline
+{
+	DKRasterBuffer buffer;
+
+	[self getSquareBuffer:&buffer];
+
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < 10; ++i)
+			XCTAssertTrue([pipeline applyToBuffer:&buffer
+											scale:1.0],
+				@"pipeline should apply");
+	}];
+
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&buffer];
+}
+
+#pragma mark -
+
+- (void)testGaussianBlurKeepsCoverage
+{
+	DKRasterBuffer buffer, scratch;
+
+	[self getSquareBuffer:&buffer];
+	[[DKRasterBufferPool sharedPool] getBuffer:&scratch
+										 width:BITMAP_SIZE
+										height:BITMAP_SIZE];
+
+	NSUInteger before = [self totalAlphaOfBuffer:&buffer];
+
+	DKRasterGaussianBlur(&buffer, &scratch, 8.0);
+
+	NSUInteger after = [self totalAlphaOfBuffer:&buffer];
+
+	XCTAssertEqualWithAccuracy((double)after, (double)before, before * 0.005, @"blurring should neither add nor lose coverage");
+	XCTAssertEqual([self pixelOfBuffer:&buffer x:BITMAP_SIZE / 2 y:BITMAP_SIZE / 2][3], (uint8_t)255, @"the middle of the square should stay opaque");
+	XCTAssertEqual([self pixelOfBuffer:&buffer x:BITMAP_SIZE / 2 y:BITMAP_SIZE / 2][0], (uint8_t)255, @"the middle of the square should stay red");
+	XCTAssertGreaterThan([self pixelOfBuffer:&buffer x:BITMAP_SIZE / 4 - 4 y:BITMAP_SIZE / 2][3], 0, @"the edge should spread outwards");
+	XCTAssertLessThan([self pixelOfBuffer:&buffer x:BITMAP_SIZE / 4 y:BITMAP_SIZE / 2][3], 255, @"the edge should soften");
+	XCTAssertEqual([self pixelOfBuffer:&buffer x:4 y:4][3], (uint8_t)0, @"far from the square should stay clear");
+
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&buffer];
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&scratch];
+}
+
+- (void)testColourMatrix
+{
+	DKRasterBuffer buffer;
+	const CGFloat identity[20] = { 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0 };
+	const CGFloat invert[20] = { -1, 0, 0, 0, 1, 0, -1, 0, 0, 1, 0, 0, -1, 0, 1, 0, 0, 0, 1, 0 };
+
+	[[DKRasterBufferPool sharedPool] getBuffer:&buffer
+										 width:2
+										height:1];
+
+	// opaque red, and half transparent orange, premultiplied
+
+	uint8_t pixels[8] = { 255, 0, 0, 255, 100, 50, 0, 128 };
+	memcpy(buffer.data, pixels, sizeof(pixels));
+
+	DKRasterColourMatrix(&buffer, identity);
+	XCTAssertEqual(memcmp(buffer.data, pixels, sizeof(pixels)), 0, @"the identity matrix should change nothing");
+
+	DKRasterColourMatrix(&buffer, invert);
+
+	uint8_t inverted[8] = { 0, 255, 255, 255, 28, 78, 128, 128 };
+	for (NSUInteger i = 0; i < 8; ++i)
+		XCTAssertEqualWithAccuracy(buffer.data[i], inverted[i], 1, @"component %lu should be inverted before premultiplying", (unsigned long)i);
+
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&buffer];
+}
+
+- (void)testBlendModes
+{
+	DKRasterBuffer src, dst;
+	const uint8_t grey[4] = { 128, 128, 128, 255 };
+	const uint8_t magenta[4] = { 255, 0, 255, 255 };
+
+	[[DKRasterBufferPool sharedPool] getBuffer:&src
+										 width:1
+										height:1];
+	[[DKRasterBufferPool sharedPool] getBuffer:&dst
+										 width:1
+										height:1];
+
+	memcpy(src.data, magenta, 4);
+
+	memcpy(dst.data, grey, 4);
+	DKRasterBlend(&src, &dst, kDKRasterBlendMultiply, 1.0);
+	XCTAssertTrue(dst.data[0] == 128 && dst.data[1] == 0 && dst.data[2] == 128 && dst.data[3] == 255, @"multiply should darken grey by magenta");
+
+	memcpy(dst.data, grey, 4);
+	DKRasterBlend(&src, &dst, kDKRasterBlendScreen, 1.0);
+	XCTAssertTrue(dst.data[0] == 255 && dst.data[1] == 128 && dst.data[2] == 255, @"screen should lighten grey by magenta");
+
+	memcpy(dst.data, grey, 4);
+	DKRasterBlend(&src, &dst, kDKRasterBlendNormal, 0.5);
+	XCTAssertEqualWithAccuracy(dst.data[0], 192, 1, @"half opaque normal blend should mix evenly");
+	XCTAssertEqualWithAccuracy(dst.data[1], 64, 1, @"half opaque normal blend should mix evenly");
+
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&src];
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&dst];
+}
+
+- (void)testDropShadow
+{
+	DKRasterBuffer buffer, shadow, scratch;
+	const CGFloat colour[4] = { 0, 0, 0, 0.5 };
+
+	[self getSquareBuffer:&buffer];
+	[[DKRasterBufferPool sharedPool] getBuffer:&shadow
+										 width:BITMAP_SIZE
+										height:BITMAP_SIZE];
+	[[DKRasterBufferPool sharedPool] getBuffer:&scratch
+										 width:BITMAP_SIZE
+										height:BITMAP_SIZE];
+
+	DKRasterDropShadow(&buffer, &shadow, &scratch, 10, 20, 0.0, colour);
+
+	uint8_t* inShadow = [self pixelOfBuffer:&buffer
+										  x:BITMAP_SIZE * 3 / 4 + 5
+										  y:BITMAP_SIZE * 3 / 4 + 10];
+	uint8_t* inSquare = [self pixelOfBuffer:&buffer
+										  x:BITMAP_SIZE / 2
+										  y:BITMAP_SIZE / 2];
+
+	XCTAssertEqualWithAccuracy(inShadow[3], 128, 1, @"the shadow should show below and right of the square");
+	XCTAssertEqual(inShadow[0], (uint8_t)0, @"the shadow should be black");
+	XCTAssertTrue(inSquare[0] == 255 && inSquare[3] == 255, @"the square should be drawn over its shadow");
+	XCTAssertEqual([self pixelOfBuffer:&buffer x:BITMAP_SIZE / 4 - 2 y:BITMAP_SIZE / 4 - 2][3], (uint8_t)0, @"there should be no shadow above and left of the square");
+
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&buffer];
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&shadow];
+	[[DKRasterBufferPool sharedPool] recycleBuffer:&scratch];
+}
+
+- (void)testPipelineFromFilter
+{
+	DKRasterEffectPipeline* blur = [DKRasterEffectPipeline pipelineWithFilter:@"CIGaussianBlur"
+																	 arguments:@{ @"inputRadius": @5 }];
+
+	XCTAssertEqual([blur count], (NSUInteger)1, @"a gaussian blur should be one step");
+	XCTAssertEqual([blur stepAtIndex:0]->kind, kDKRasterEffectGaussianBlur, @"a gaussian blur should map to the blur step");
+	XCTAssertEqual([blur stepAtIndex:0]->radius, 5.0, @"the blur radius should come from the arguments");
+	XCTAssertEqual([blur extraSpaceNeeded].width, 15.0, @"a blur should need three deviations of room");
+
+	DKRasterEffectPipeline* shadow = [DKRasterEffectPipeline pipelineWithFilter:kDKRasterDropShadowFilter
+																	   arguments:@{ @"inputOffset": [NSValue valueWithSize:NSMakeSize(4, -6)] }];
+
+	XCTAssertEqual([shadow stepAtIndex:0]->kind, kDKRasterEffectDropShadow, @"a drop shadow should map to the shadow step");
+	XCTAssertEqual([shadow extraSpaceNeeded].height, 18.0, @"a shadow should need its offset and blur in room");
+
+	XCTAssertNotNil([DKRasterEffectPipeline pipelineWithFilter:@"CIColorMatrix" arguments:nil], @"colour matrices should be done on the CPU");
+	XCTAssertNil([DKRasterEffectPipeline pipelineWithFilter:@"CIVortexDistortion" arguments:nil], @"other filters should be left to Core Image");
+}
+
+- (void)testPoolReusesBuffers
+{
+	DKRasterBufferPool* pool = [[DKRasterBufferPool alloc] init];
+	DKRasterBuffer a, b;
+
+	XCTAssertTrue([pool getBuffer:&a width:100 height:100], @"pool should supply a buffer");
+	memset(a.data, 0xFF, a.rowBytes * a.height);
+	[pool recycleBuffer:&a];
+	XCTAssertTrue(a.data == NULL, @"recycling should clear the caller's buffer");
+
+	XCTAssertTrue([pool getBuffer:&b width:90 height:100], @"pool should supply a buffer");
+	XCTAssertEqual([pool allocationCount], (NSUInteger)1, @"a slightly smaller buffer should reuse the one given back");
+	XCTAssertEqual(b.data[0], (uint8_t)0, @"reused buffers should be cleared");
+	[pool recycleBuffer:&b];
+
+	XCTAssertTrue([pool getBuffer:&b width:10 height:10], @"pool should supply a buffer");
+	XCTAssertEqual([pool allocationCount], (NSUInteger)2, @"a much smaller buffer should not waste a large one");
+	[pool recycleBuffer:&b];
+
+	[pool setMaximumRetainedBytes:0];
+	XCTAssertTrue([pool getBuffer:&b width:100 height:100], @"pool should supply a buffer");
+	XCTAssertEqual([pool allocationCount], (NSUInteger)3, @"lowering the limit should free what is kept");
+	[pool recycleBuffer:&b];
+}
+
+- (void)testPoolTrimsOldestFirst
+{
+	DKRasterBufferPool* pool = [[DKRasterBufferPool alloc] init];
+	DKRasterBuffer a, b, c, d;
+
+	XCTAssertTrue([pool getBuffer:&a width:100 height:100], @"pool should supply a buffer");
+	XCTAssertTrue([pool getBuffer:&b width:50 height:50], @"pool should supply a buffer");
+	XCTAssertTrue([pool getBuffer:&c width:20 height:20], @"pool should supply a buffer");
+	XCTAssertTrue([pool getBuffer:&d width:60 height:60], @"pool should supply a buffer");
+	[pool recycleBuffer:&a];
+	[pool recycleBuffer:&b];
+	[pool recycleBuffer:&c];
+	[pool recycleBuffer:&d];
+
+	// taking one from the middle mustn't let the newest move ahead of an older one
+
+	XCTAssertTrue([pool getBuffer:&b width:50 height:50], @"pool should supply a buffer");
+	XCTAssertEqual([pool allocationCount], (NSUInteger)4, @"the buffer given back should be reused");
+
+	[pool setMaximumRetainedBytes:60 * 60 * 4];
+	XCTAssertTrue([pool getBuffer:&d width:60 height:60], @"pool should supply a buffer");
+	XCTAssertEqual([pool allocationCount], (NSUInteger)4, @"trimming should have freed the older buffers and kept the newest");
+
+	[pool recycleBuffer:&b];
+	[pool recycleBuffer:&d];
+}
+
+- (void)testFilterGroupCachesPerObject
+{
+	DKCIFilterRastGroup* group = [DKCIFilterRastGroup effectGroupWithFilter:@"CIGaussianBlur"];
+	TestCountingFill* fill = [[TestCountingFill alloc] init];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(100, 100, 200, 100)];
+	DKDrawableShape* other = [DKDrawableShape drawableShapeWithRect:NSMakeRect(100, 300, 200, 100)];
+
+	[fill setColour:[NSColor redColor]];
+	[group addRenderer:fill];
+	[group setClipping:kDKClippingNone];
+	[group setArguments:@{ @"inputRadius": @4 }];
+
+	[self renderShapes:@[shape, other] withGroup:group scale:1.0];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)2, @"each object should be captured the first time it is drawn");
+
+	[self renderShapes:@[shape, other] withGroup:group scale:1.0];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)2, @"unchanged objects should not be captured again");
+
+	[shape notifyVisualChange];
+	[self renderShapes:@[shape, other] withGroup:group scale:1.0];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)3, @"only the changed object should be captured again");
+
+	[self renderShapes:@[shape] withGroup:group scale:2.0];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)4, @"drawing at another scale should capture again");
+
+	[group setArguments:@{ @"inputRadius": @8 }];
+	[self renderShapes:@[shape, other] withGroup:group scale:2.0];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)6, @"changing the filter should capture every object again");
+}
+
+- (void)testHitTestingLeavesCache
+{
+	DKCIFilterRastGroup* group = [DKCIFilterRastGroup effectGroupWithFilter:@"CIGaussianBlur"];
+	TestCountingFill* fill = [[TestCountingFill alloc] init];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(100, 100, 200, 100)];
+
+	[fill setColour:[NSColor redColor]];
+	[group addRenderer:fill];
+	[group setArguments:@{ @"inputRadius": @4 }];
+
+	[self renderShapes:@[shape] withGroup:group scale:1.0];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)1, @"the object should be captured the first time it is drawn");
+
+	// hit-testing draws into a context far smaller than the object
+
+	[shape setBeingHitTested:YES];
+	[self renderShapes:@[shape] withGroup:group scale:0.01];
+	[shape setBeingHitTested:NO];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)2, @"hit-testing should draw the contents directly");
+
+	[self renderShapes:@[shape] withGroup:group scale:1.0];
+	XCTAssertEqual(fill->mRenderCount, (NSUInteger)2, @"hit-testing should not replace the image cached for the screen");
+}
+
+- (void)testPerformanceOfBlur
+{
+	DKRasterEffectPipeline* pipeline = [[DKRasterEffectPipeline alloc] init];
+
+	[pipeline addGaussianBlurWithRadius:8.0];
+	[self measurePipeline:pipeline];
+}
+
+- (void)testPerformanceOfDropShadow
+{
+	DKRasterEffectPipeline* pipeline = [[DKRasterEffectPipeline alloc] init];
+
+	[pipeline addDropShadowWithOffset:NSMakeSize(4, 4)
+							   radius:6.0
+							   colour:[NSColor colorWithCalibratedWhite:0.0 alpha:0.5]];
+	[self measurePipeline:pipeline];
+}
+
+- (void)testPerformanceOfGlow
+{
+	// blur, tint and put the sharp original back over the top
+
+	DKRasterEffectPipeline* pipeline = [[DKRasterEffectPipeline alloc] init];
+	const CGFloat yellow[20] = { 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0 };
+
+	[pipeline addGaussianBlurWithRadius:6.0];
+	[pipeline addColourMatrix:yellow];
+	[pipeline addBlendSourceWithMode:kDKRasterBlendNormal
+							 opacity:1.0];
+	[self measurePipeline:pipeline];
+}
+
+- (void)testPerformanceOfRedrawingShadowedShapes
+{
+	DKCIFilterRastGroup* group = [DKCIFilterRastGroup effectGroupWithFilter:kDKRasterDropShadowFilter];
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray arrayWithCapacity:SHAPE_COUNT];
+
+	[group addRenderer:[DKFill fillWithColour:[NSColor blueColor]]];
+	[group setClipping:kDKClippingNone];
+
+	for (NSUInteger i = 0; i < SHAPE_COUNT; ++i)
+		[shapes addObject:[DKDrawableShape drawableShapeWithRect:NSMakeRect((i % 40) * 12, (i / 40) * 12, 10, 10)]];
+
+	// the first draw makes every object's image; what is measured is redrawing them, as when a view scrolls
+
+	[self renderShapes:shapes withGroup:group scale:1.0];
+
+	[self measureBlock:^{
+		[self renderShapes:shapes withGroup:group scale:1.0];
+	}];
+}
+
+@end
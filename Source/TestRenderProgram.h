@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKStyle.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for styles rendering through their compiled render programs.
+
+ Checks that the object being rendered is the style's render client only while it renders, that a renderer throwing an exception
+ doesn't escape the style or leave the render client set, and that the program is rebuilt when a renderer is added. Times rendering
+ 1,000 shapes with a style of several renderers.
+*/
+@interface TestRenderProgram : XCTestCase
+
+- (void)testRenderClientIsSetWhileRendering;
+- (void)testExceptionInRendererIsContained;
+- (void)testProgramIsRebuiltWhenStyleChanges;
+- (void)testPerformanceOfStyleRendering;
+
+@end
@@ -0,0 +1,158 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestRenderProgram.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKRenderProgram.h>
+#import <DKDrawKit/DKStroke.h>
+
+#define BITMAP_SIZE 512
+#define SHAPE_COUNT 1000
+
+/** @brief A renderer that notes the style's render client when it renders, and can be made to throw.
+ */
+@interface TestNotingRenderer : DKRasterizer {
+@public
+	__weak DKStyle* mStyle;
+	id mClientWhenRendered;
+	BOOL mThrows;
+}
+
+@end
+
+@implementation TestNotingRenderer
+
+- (void)render:(id<DKRenderable>)object
+{
+#pragma unused(object)
+	mClientWhenRendered = [mStyle currentRenderClient];
+
+	if (mThrows)
+		[NSException raise:NSInternalInconsistencyException
+					format:@"renderer failed"];
+}
+
+@end
+
+#pragma mark -
+
+@interface TestRenderProgram ()
+
+- (void)renderInBitmapUsingBlock:(void (^)(void))block;
+- (TestNotingRenderer*)notingRendererInStyle:(DKStyle*)style;
+
+@end
+
+@implementation TestRenderProgram
+
+- (void)renderInBitmapUsingBlock:(void (^)(void))block
+{
+	NSBitmapImageRep* bitmap = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	   pixelsWide:BITMAP_SIZE
+																	   pixelsHigh:BITMAP_SIZE
+																	bitsPerSample:8
+																  samplesPerPixel:4
+																		 hasAlpha:YES
+																		 isPlanar:NO
+																   colorSpaceName:NSCalibratedRGBColorSpace
+																	  bytesPerRow:0
+																	 bitsPerPixel:0];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+	block();
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (TestNotingRenderer*)notingRendererInStyle:(DKStyle*)style
+{
+	TestNotingRenderer* renderer = [[TestNotingRenderer alloc] init];
+
+	renderer->mStyle = style;
+	[style addRenderer:renderer];
+
+	return renderer;
+}
+
+- (void)testRenderClientIsSetWhileRendering
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor redColor]
+									 strokeColour:nil];
+	TestNotingRenderer* renderer = [self notingRendererInStyle:style];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(10, 10, 100, 100)];
+
+	[self renderInBitmapUsingBlock:^{
+		[style render:shape];
+	}];
+
+	XCTAssertEqual(renderer->mClientWhenRendered, shape, @"the shape should be the render client while it renders");
+	XCTAssertNil([style currentRenderClient], @"there should be no render client afterwards");
+}
+
+- (void)testExceptionInRendererIsContained
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor redColor]
+									 strokeColour:nil];
+	TestNotingRenderer* renderer = [self notingRendererInStyle:style];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(10, 10, 100, 100)];
+
+	renderer->mThrows = YES;
+
+	[self renderInBitmapUsingBlock:^{
+		XCTAssertNoThrow([style render:shape], @"an exception in a renderer should not escape the style");
+	}];
+
+	XCTAssertEqual(renderer->mClientWhenRendered, shape, @"the renderer should have been reached");
+	XCTAssertNil([style currentRenderClient], @"the render client should be cleared even though the renderer threw");
+
+	// the style still works afterwards
+
+	renderer->mThrows = NO;
+	renderer->mClientWhenRendered = nil;
+
+	[self renderInBitmapUsingBlock:^{
+		[style render:shape];
+	}];
+
+	XCTAssertEqual(renderer->mClientWhenRendered, shape, @"the style should render normally after an exception");
+}
+
+- (void)testProgramIsRebuiltWhenStyleChanges
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor redColor]
+									 strokeColour:nil];
+	NSUInteger steps = [[style renderProgram] count];
+
+	XCTAssertGreaterThan(steps, (NSUInteger)0, @"the fill should be in the program");
+
+	[style addRenderer:[DKStroke defaultStroke]];
+
+	XCTAssertGreaterThan([[style renderProgram] count], steps, @"adding a stroke should rebuild the program");
+}
+
+- (void)testPerformanceOfStyleRendering
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor redColor]
+									 strokeColour:[NSColor blackColor]
+									  strokeWidth:2];
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray arrayWithCapacity:SHAPE_COUNT];
+
+	[style addRenderer:[DKStroke strokeWithWidth:6
+										  colour:[NSColor colorWithCalibratedWhite:0
+																			 alpha:0.2]]];
+
+	for (NSUInteger i = 0; i < SHAPE_COUNT; ++i)
+		[shapes addObject:[DKDrawableShape drawableShapeWithRect:NSMakeRect((i * 37) % 400, (i * 53) % 400, 60, 40)]];
+
+	[self measureBlock:^{
+		[self renderInBitmapUsingBlock:^{
+			for (DKDrawableShape* shape in shapes)
+				[style render:shape];
+		}];
+	}];
+}
+
+@end
@@ -0,0 +1,25 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKGeometryTable.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for shapes sharing their geometry through DKGeometryTable.
+
+ Checks that shapes with the same geometry share one path, that setting a path doesn't let later changes to it reach the shape,
+ that archives store shared geometry once and unarchived shapes share it again, and that unused geometry is dropped. Times making
+ and archiving 1,000,000 mostly identical shapes, checking how many distinct paths they keep and how large their archive is.
+*/
+@interface TestSharedGeometry : XCTestCase
+
+- (void)testIdenticalShapesSharePath;
+- (void)testSetPathCopiesOnWrite;
+- (void)testArchiveStoresGeometryOnce;
+- (void)testUnusedGeometryIsDropped;
+- (void)testPerformanceOfManyShapes;
+- (void)testPerformanceOfArchivingManyShapes;
+
+@end
@@ -0,0 +1,168 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestSharedGeometry.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKShapeFactory.h>
+#import <DKDrawKit/NSBezierPath+Editing.h>
+
+#define SHAPE_COUNT 1000000
+#define DISTINCT_COUNT 1000
+
+@interface TestSharedGeometry ()
+
+- (DKDrawableShape*)shapeAtIndex:(NSUInteger)i;
+- (NSArray<DKDrawableShape*>*)shapesWithCount:(NSUInteger)count;
+- (NSArray<DKDrawableShape*>*)distinctShapesWithCount:(NSUInteger)count;
+
+@end
+
+@implementation TestSharedGeometry
+
+- (DKDrawableShape*)shapeAtIndex:(NSUInteger)i
+{
+	// mostly rects, ovals and hexagons, with one shape in a thousand given a round rect of its own
+
+	NSRect r = NSMakeRect((i % 1000) * 10, (i / 1000) * 10, 8, 6);
+	DKDrawableShape* shape;
+
+	if (i % 1000 == 999) {
+		shape = [DKDrawableShape drawableShapeWithRect:r];
+		[shape setPath:[DKShapeFactory roundRectWithCornerRadius:0.01 + (i / 1000) * 0.0001]];
+	} else if (i % 3 == 0)
+		shape = [DKDrawableShape drawableShapeWithRect:r];
+	else if (i % 3 == 1)
+		shape = [DKDrawableShape drawableShapeWithOvalInRect:r];
+	else {
+		shape = [DKDrawableShape drawableShapeWithRect:r];
+		[shape setPath:[DKShapeFactory hexagon]];
+	}
+
+	return shape;
+}
+
+- (NSArray<DKDrawableShape*>*)shapesWithCount:(NSUInteger)count
+{
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray arrayWithCapacity:count];
+
+	for (NSUInteger i = 0; i < count; ++i)
+		[shapes addObject:[self shapeAtIndex:i]];
+
+	return shapes;
+}
+
+- (NSArray<DKDrawableShape*>*)distinctShapesWithCount:(NSUInteger)count
+{
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray arrayWithCapacity:count];
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(i * 10, 0, 8, 6)];
+
+		[shape setPath:[DKShapeFactory roundRectWithCornerRadius:0.2 + i * 0.0001]];
+		[shapes addObject:shape];
+	}
+
+	return shapes;
+}
+
+- (void)testIdenticalShapesSharePath
+{
+	DKDrawableShape* a = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+	DKDrawableShape* b = [DKDrawableShape drawableShapeWithRect:NSMakeRect(50, 20, 100, 30)];
+	DKDrawableShape* c = [DKDrawableShape drawableShapeWithOvalInRect:NSMakeRect(0, 0, 10, 10)];
+	DKDrawableShape* d = [DKDrawableShape drawableShapeWithOvalInRect:NSMakeRect(5, 5, 40, 10)];
+
+	XCTAssertTrue([a path] == [b path], @"rect shapes should share one path");
+	XCTAssertTrue([c path] == [d path], @"oval shapes should share one path");
+	XCTAssertTrue([a path] != [c path], @"rects and ovals should not share a path");
+	XCTAssertTrue([[a copy] path] == [a path], @"a copied shape should share its original's path");
+
+	[a setPath:[DKShapeFactory oval]];
+	XCTAssertTrue([a path] == [c path], @"setting an oval path should share the ovals' path");
+}
+
+- (void)testSetPathCopiesOnWrite
+{
+	DKDrawableShape* a = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+	DKDrawableShape* b = [DKDrawableShape drawableShapeWithRect:NSMakeRect(20, 0, 10, 10)];
+	NSBezierPath* path = [DKShapeFactory roundRectWithCornerRadius:0.1234];
+	NSUInteger checksum = [path checksum];
+
+	[a setPath:path];
+	XCTAssertTrue([a path] != path, @"the shape should not keep the caller's own path");
+	XCTAssertTrue([b path] != [a path], @"changing one shape's path should not change another's");
+
+	// changing the path set afterwards must not reach the shape
+
+	NSAffineTransform* tfm = [NSAffineTransform transform];
+	[tfm scaleBy:0.5];
+	[path transformUsingAffineTransform:tfm];
+
+	XCTAssertEqual([[a path] checksum], checksum, @"changing the caller's path should not change the shape");
+	XCTAssertTrue(NSEqualRects([[b path] bounds], [DKDrawableShape unitRectAtOrigin]), @"the other shape should keep its rect");
+}
+
+- (void)testArchiveStoresGeometryOnce
+{
+	NSArray<DKDrawableShape*>* shared = [self shapesWithCount:DISTINCT_COUNT];
+	NSArray<DKDrawableShape*>* distinct = [self distinctShapesWithCount:DISTINCT_COUNT];
+	NSData* sharedData = [NSKeyedArchiver archivedDataWithRootObject:shared];
+	NSData* distinctData = [NSKeyedArchiver archivedDataWithRootObject:distinct];
+
+	XCTAssertTrue([sharedData length] < [distinctData length], @"shapes sharing geometry should make a smaller archive (%lu, %lu)", (unsigned long)[sharedData length], (unsigned long)[distinctData length]);
+
+	NSArray<DKDrawableShape*>* decoded = [NSKeyedUnarchiver unarchiveObjectWithData:sharedData];
+
+	XCTAssertEqual([decoded count], [shared count], @"all the shapes should be unarchived");
+	XCTAssertTrue([decoded[0] path] == [decoded[3] path], @"unarchived rects should share one path");
+	XCTAssertTrue([decoded[1] path] == [decoded[4] path], @"unarchived ovals should share one path");
+	XCTAssertTrue([decoded[0] path] == [shared[0] path], @"unarchived shapes should share the table's path");
+}
+
+- (void)testUnusedGeometryIsDropped
+{
+	DKGeometryTable* table = [DKGeometryTable sharedGeometryTable];
+	NSBezierPath* path = [DKShapeFactory roundRectWithCornerRadius:0.4321];
+
+	@autoreleasepool {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(0, 0, 10, 10)];
+
+		[shape setPath:path];
+		XCTAssertNotNil([table existingPathForPath:path], @"a path in use should be in the table");
+	}
+
+	XCTAssertNil([table existingPathForPath:path], @"a path nothing uses should be dropped from the table");
+}
+
+- (void)testPerformanceOfManyShapes
+{
+	[self measureBlock:^{
+		@autoreleasepool {
+			NSArray<DKDrawableShape*>* shapes = [self shapesWithCount:SHAPE_COUNT];
+
+			// three common shapes and one of each thousand
+
+			XCTAssertTrue([[DKGeometryTable sharedGeometryTable] count] < 3 + SHAPE_COUNT / 1000 + 100, @"shapes with the same geometry should share their paths");
+			XCTAssertEqual([shapes count], (NSUInteger)SHAPE_COUNT);
+		}
+	}];
+}
+
+- (void)testPerformanceOfArchivingManyShapes
+{
+	NSArray<DKDrawableShape*>* shapes = [self shapesWithCount:SHAPE_COUNT];
+	NSUInteger distinctBytesPerShape = [[NSKeyedArchiver archivedDataWithRootObject:[self distinctShapesWithCount:DISTINCT_COUNT]] length] / DISTINCT_COUNT;
+
+	[self measureBlock:^{
+		@autoreleasepool {
+			NSData* data = [NSKeyedArchiver archivedDataWithRootObject:shapes];
+
+			XCTAssertTrue([data length] < SHAPE_COUNT * distinctBytesPerShape, @"the archive should be smaller than one with a path per shape");
+		}
+	}];
+}
+
+@end
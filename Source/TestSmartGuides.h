@@ -0,0 +1,26 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKAxisIndex.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for guide and smart guide snapping.
+
+ Checks the axis index against a linear search, checks that guide layers still find the nearest guide after guides are added
+ and moved, and that a layer's smart guides follow its objects as they are added, moved and removed, are off unless asked for
+ and don't keep removed objects alive. Also times snapping a
+ dragged rect on a layer with many objects.
+*/
+@interface TestSmartGuides : XCTestCase
+
+- (void)testAxisIndexMatchesLinearSearch;
+- (void)testGuideLayerFindsNearestGuide;
+- (void)testSmartGuidesFollowObjects;
+- (void)testSmartGuideSnappingIsOptIn;
+- (void)testRemovedObjectsAreReleased;
+- (void)testPerformanceOfSmartGuideSnapping;
+
+@end
@@ -0,0 +1,259 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestSmartGuides.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKGuideLayer.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <DKDrawKit/DKRandom.h>
+
+#define NUMBER_OF_POSITIONS 1000
+#define NUMBER_OF_QUERIES 5000
+#define NUMBER_OF_OBJECTS 30000
+
+@interface TestSmartGuides ()
+
+- (DKObjectDrawingLayer*)layerWithObjects:(NSUInteger)count;
+
+@end
+
+@implementation TestSmartGuides
+
+- (DKObjectDrawingLayer*)layerWithObjects:(NSUInteger)count
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(5000, 5000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	NSMutableArray* shapes = [NSMutableArray arrayWithCapacity:count];
+	DKRandomState rng;
+
+	DKRandomSeed(&rng, 36);
+	[drawing addLayer:layer];
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		NSRect r = NSMakeRect(floor(DKRandomUnit(&rng) * 4900), floor(DKRandomUnit(&rng) * 4900), 10 + floor(DKRandomUnit(&rng) * 90), 10 + floor(DKRandomUnit(&rng) * 90));
+		[shapes addObject:[DKDrawableShape drawableShapeWithRect:r]];
+	}
+
+	[layer addObjectsFromArray:shapes];
+
+	return layer;
+}
+
+- (void)testAxisIndexMatchesLinearSearch
+{
+	DKAxisIndex* index = [[DKAxisIndex alloc] init];
+	NSMutableArray* owners = [NSMutableArray array];
+	CGFloat positions[NUMBER_OF_POSITIONS];
+	DKAxisIndexEntry batch[NUMBER_OF_POSITIONS / 2];
+	DKRandomState rng;
+	NSUInteger i;
+
+	DKRandomSeed(&rng, 1);
+
+	// half added in one batch, half one at a time, then some removed again
+
+	for (i = 0; i < NUMBER_OF_POSITIONS; ++i) {
+		[owners addObject:[NSObject new]];
+		positions[i] = floor(DKRandomUnit(&rng) * 10000) / 10.0;
+	}
+
+	for (i = 0; i < NUMBER_OF_POSITIONS / 2; ++i) {
+		batch[i].position = positions[i];
+		batch[i].owner = owners[i];
+	}
+
+	[index addEntries:batch
+				count:NUMBER_OF_POSITIONS / 2];
+
+	for (i = NUMBER_OF_POSITIONS / 2; i < NUMBER_OF_POSITIONS; ++i)
+		[index addPosition:positions[i]
+					 owner:owners[i]];
+
+	for (i = 0; i < NUMBER_OF_POSITIONS / 5; ++i)
+		[index removePosition:positions[i]
+						owner:owners[i]];
+
+	XCTAssertEqual([index count], (NSUInteger)(NUMBER_OF_POSITIONS - NUMBER_OF_POSITIONS / 5), @"wrong number of entries");
+
+	for (i = 1; i < [index count]; ++i)
+		XCTAssertLessThanOrEqual([index entries][i - 1].position, [index entries][i].position, @"index is not sorted at %lu", (unsigned long)i);
+
+	for (NSUInteger q = 0; q < NUMBER_OF_QUERIES; ++q) {
+		CGFloat pos = DKRandomUnit(&rng) * 1000.0;
+		NSUInteger skip = DKRandomIndex(&rng, NUMBER_OF_POSITIONS);
+		NSHashTable* exclude = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+		CGFloat found = 0, bestDistance = 3.0;
+		id expected = nil;
+
+		[exclude addObject:owners[skip]];
+
+		for (i = NUMBER_OF_POSITIONS / 5; i < NUMBER_OF_POSITIONS; ++i) {
+			if (i != skip && fabs(positions[i] - pos) < bestDistance) {
+				bestDistance = fabs(positions[i] - pos);
+				expected = owners[i];
+			}
+		}
+
+		id owner = [index nearestOwnerToPosition:pos
+									   tolerance:3.0
+									   excluding:exclude
+										position:&found];
+
+		XCTAssertEqual(owner == nil, expected == nil, @"index and linear search disagree about a match near %f", pos);
+
+		if (owner)
+			XCTAssertEqualWithAccuracy(fabs(found - pos), bestDistance, 1e-9, @"index found a further entry than linear search near %f", pos);
+	}
+}
+
+- (void)testGuideLayerFindsNearestGuide
+{
+	DKGuideLayer* layer = [[DKGuideLayer alloc] init];
+
+	[layer setSnapTolerance:5.0];
+
+	for (NSUInteger i = 0; i < 10; ++i) {
+		DKGuide* guide = [[DKGuide alloc] init];
+
+		[guide setIsVerticalGuide:YES];
+		[guide setGuidePosition:(10 - i) * 100.0];
+		[layer addGuide:guide];
+	}
+
+	XCTAssertEqual([[layer nearestVerticalGuideToPosition:302.0] guidePosition], 300.0, @"didn't find the nearest guide");
+	XCTAssertNil([layer nearestVerticalGuideToPosition:350.0], @"found a guide outside the snap tolerance");
+	XCTAssertNil([layer nearestHorizontalGuideToPosition:300.0], @"found a horizontal guide where there are none");
+
+	XCTAssertEqual([layer snapRectToGuide:NSMakeRect(197, 0, 96, 10)].origin.x, 200.0, @"rect didn't snap its left edge");
+	XCTAssertEqual([layer snapRectToGuide:NSMakeRect(150, 0, 148, 10)].origin.x, 152.0, @"rect didn't snap its right edge");
+
+	[layer removeGuide:[layer nearestVerticalGuideToPosition:300.0]];
+
+	XCTAssertNil([layer nearestVerticalGuideToPosition:302.0], @"found a removed guide");
+}
+
+- (void)testSmartGuidesFollowObjects
+{
+	DKObjectDrawingLayer* layer = [self layerWithObjects:0];
+	DKDrawableShape* a = [DKDrawableShape drawableShapeWithRect:NSMakeRect(100, 100, 50, 50)];
+	DKDrawableShape* b = [DKDrawableShape drawableShapeWithRect:NSMakeRect(400, 400, 80, 20)];
+	NSSize off;
+
+	[layer addObject:a];
+	[layer addObject:b];
+
+	// a rect whose left edge is 2 units right of a's right edge, and whose centre is 1 unit below b's bottom edge
+
+	off = [layer smartGuideOffsetForRect:NSMakeRect(152, 389, 30, 20)
+						excludingObjects:nil
+							   tolerance:4.0];
+	XCTAssertEqual(off.width, -2.0, @"didn't snap to the edge of an object");
+	XCTAssertEqual(off.height, 1.0, @"didn't snap to the centre of an object");
+
+	// objects being dragged are ignored
+
+	off = [layer smartGuideOffsetForRect:NSMakeRect(152, 389, 30, 20)
+						excludingObjects:@[a, b]
+							   tolerance:4.0];
+	XCTAssertTrue(NSEqualSizes(off, NSZeroSize), @"snapped to an excluded object");
+
+	// moving and removing objects must be reflected in the next query
+
+	[a setLocation:NSMakePoint(1000, 1000)];
+	[layer removeObject:b];
+
+	off = [layer smartGuideOffsetForRect:NSMakeRect(152, 389, 30, 20)
+						excludingObjects:nil
+							   tolerance:4.0];
+	XCTAssertTrue(NSEqualSizes(off, NSZeroSize), @"snapped to an object that has moved or been removed");
+
+	off = [layer smartGuideOffsetForRect:NSMakeRect(994, 600, 10, 10)
+						excludingObjects:nil
+							   tolerance:4.0];
+	XCTAssertEqual(off.width, 1.0, @"didn't snap to the moved object's centre");
+}
+
+- (void)testSmartGuideSnappingIsOptIn
+{
+	DKObjectDrawingLayer* layer = [self layerWithObjects:0];
+	DKDrawableShape* a = [DKDrawableShape drawableShapeWithRect:NSMakeRect(100, 100, 50, 50)];
+	DKDrawableShape* b = [DKDrawableShape drawableShapeWithRect:NSMakeRect(300, 300, 50, 50)];
+
+	[layer addObject:a];
+	[layer addObject:b];
+	[[layer drawing] setSnapsToGrid:NO];
+	[[layer drawing] setSnapsToGuides:NO];
+
+	XCTAssertTrue([layer allowsSnapToObjects], @"snapping to objects should be on by default");
+	XCTAssertFalse([layer snapsToSmartGuides], @"smart guides should be off by default");
+
+	// b's location is its centre; this puts its left edge 2 units right of a's right edge
+
+	NSPoint mp = NSMakePoint(177, 400);
+
+	XCTAssertEqual([b snappedMousePoint:mp forSnappingPointsWithControlFlag:NO].x, mp.x, @"snapped to a smart guide that wasn't asked for");
+
+	[layer setSnapsToSmartGuides:YES];
+
+	XCTAssertEqual([b snappedMousePoint:mp forSnappingPointsWithControlFlag:NO].x, mp.x - 2.0, @"didn't snap to the smart guide");
+}
+
+- (void)testRemovedObjectsAreReleased
+{
+	DKObjectDrawingLayer* layer = [self layerWithObjects:20];
+	NSHashTable* removed = [NSHashTable weakObjectsHashTable];
+
+	// one object removed alone, and a batch too large to remove one by one
+
+	@autoreleasepool {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(100, 100, 50, 50)];
+		NSIndexSet* batch = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 12)];
+
+		[layer addObject:shape];
+		[layer smartGuideOffsetForRect:NSMakeRect(0, 0, 10, 10)
+					  excludingObjects:nil
+							 tolerance:4.0];
+
+		[removed addObject:shape];
+
+		for (DKDrawableObject* od in [layer objectsAtIndexes:batch])
+			[removed addObject:od];
+
+		[shape setLocation:NSMakePoint(500, 500)];
+		[layer removeObject:shape];
+		[layer removeObjectsAtIndexes:batch];
+		[[layer undoManager] removeAllActions];
+	}
+
+	XCTAssertEqual([[removed allObjects] count], (NSUInteger)0, @"the smart guides kept removed objects alive");
+}
+
+- (void)testPerformanceOfSmartGuideSnapping
+{
+	DKObjectDrawingLayer* layer = [self layerWithObjects:NUMBER_OF_OBJECTS];
+	DKDrawableObject* dragged = [[layer objects] firstObject];
+
+	// a simulated drag: the object moves, then the next position is snapped, as DKDrawableObject does during a drag
+
+	[self measureBlock:^{
+		for (NSUInteger step = 0; step < 500; ++step) {
+			NSPoint p = NSMakePoint(100 + step * 8.3, 100 + step * 5.7);
+			NSRect r = [dragged logicalBounds];
+
+			r.origin.x += p.x - [dragged location].x;
+			r.origin.y += p.y - [dragged location].y;
+
+			NSSize off = [layer smartGuideOffsetForRect:r
+									   excludingObjects:@[dragged]
+											  tolerance:6.0];
+
+			[dragged setLocation:NSMakePoint(p.x + off.width, p.y + off.height)];
+		}
+	}];
+}
+
+@end
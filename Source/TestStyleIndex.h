@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for the style index kept by object owner layers.
+
+ Adds, removes and restyles objects in a layer, directly and through undo and redo, and after each step checks that the
+ answers given by the index agree with a scan of the layer's objects. Times finding the objects with each of 50 styles, and all the
+ styles in use, in a layer of 10,000 objects.
+*/
+@interface TestStyleIndex : XCTestCase
+
+- (void)testIndexFollowsEdits;
+- (void)testIndexFollowsUndoAndRedo;
+- (void)testPerformanceOfObjectsWithStyle;
+- (void)testPerformanceOfAllStyles;
+
+@end
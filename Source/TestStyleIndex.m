@@ -0,0 +1,241 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestStyleIndex.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKShapeGroup.h>
+#import <DKDrawKit/DKStyle.h>
+#import <DKDrawKit/DKUndoManager.h>
+
+#define NUMBER_OF_OBJECTS 60
+#define BENCHMARK_OBJECTS 10000
+#define BENCHMARK_STYLES 50
+
+@interface TestStyleIndex ()
+
+- (DKObjectDrawingLayer*)layerWithUndoManager:(NSUndoManager*)um;
+- (void)checkIndexOfLayer:(DKObjectDrawingLayer*)layer againstStyles:(NSArray*)styles;
+- (DKObjectDrawingLayer*)layerForBenchmarkWithStyles:(NSArray* __autoreleasing*)styles;
+
+@end
+
+static DKStyle* sharedStyleWithColour(NSColor* colour)
+{
+	DKStyle* style = [DKStyle styleWithFillColour:colour
+									 strokeColour:nil];
+	[style setStyleSharable:YES];
+
+	return style;
+}
+
+@implementation TestStyleIndex
+
+- (DKObjectDrawingLayer*)layerWithUndoManager:(NSUndoManager*)um
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(1000, 1000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+
+	[drawing setUndoManager:um];
+	[drawing addLayer:layer];
+
+	return layer;
+}
+
+- (void)checkIndexOfLayer:(DKObjectDrawingLayer*)layer againstStyles:(NSArray*)styles
+{
+	NSMutableSet* scannedStyles = [NSMutableSet set];
+
+	for (DKDrawableObject* od in [layer objects]) {
+		if ([od allStyles])
+			[scannedStyles unionSet:[od allStyles]];
+	}
+
+	for (DKStyle* style in styles) {
+		NSMutableSet* scanned = [NSMutableSet set];
+
+		for (DKDrawableObject* od in [layer objects]) {
+			if ([[[od style] uniqueKey] isEqualToString:[style uniqueKey]])
+				[scanned addObject:od];
+		}
+
+		NSSet* indexed = [NSSet setWithArray:[layer objectsWithStyle:style]];
+
+		XCTAssertEqual([[layer objectsWithStyle:style] count], [indexed count], @"an object was indexed twice under style %@", [style name]);
+		XCTAssertEqualObjects(indexed, scanned, @"indexed objects for style %@ don't match the layer", [style name]);
+	}
+
+	XCTAssertEqualObjects([layer allStyles] ?: [NSSet set], scannedStyles, @"indexed styles don't match the layer");
+}
+
+- (void)testIndexFollowsEdits
+{
+	DKObjectDrawingLayer* layer = [self layerWithUndoManager:nil];
+	NSArray* styles = @[sharedStyleWithColour([NSColor redColor]), sharedStyleWithColour([NSColor greenColor]), sharedStyleWithColour([NSColor blueColor])];
+	NSUInteger i;
+
+	// query before adding anything, so the index exists and must be maintained from here on
+
+	XCTAssertEqual([[layer objectsWithStyle:styles[0]] count], (NSUInteger)0, @"empty layer should have no matches");
+
+	for (i = 0; i < NUMBER_OF_OBJECTS; ++i) {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(i * 10, i * 10, 50, 50)];
+		[shape setStyle:styles[i % 3]];
+		[layer addObject:shape];
+	}
+
+	XCTAssertEqual([[layer objectsWithStyle:styles[0]] count], (NSUInteger)(NUMBER_OF_OBJECTS / 3), @"wrong number of matches");
+	[self checkIndexOfLayer:layer
+			  againstStyles:styles];
+
+	// restyle, remove and replace objects
+
+	[layer replaceStyle:styles[0]
+				 withStyle:styles[1]
+		selectingObjects:NO];
+	[self checkIndexOfLayer:layer
+			  againstStyles:styles];
+	XCTAssertEqual([[layer objectsWithStyle:styles[0]] count], (NSUInteger)0, @"replaced style should have no matches");
+
+	NSArray* objects = [layer objects];
+
+	[layer removeObjectsInArray:[objects subarrayWithRange:NSMakeRange(0, 10)]];
+	[[objects objectAtIndex:20] setStyle:styles[0]];
+	[layer removeObject:[objects objectAtIndex:30]];
+	[self checkIndexOfLayer:layer
+			  againstStyles:styles];
+
+	// grouped objects are found through -allStyles but not -objectsWithStyle:
+
+	NSArray* toGroup = [[layer objects] subarrayWithRange:NSMakeRange(0, 5)];
+
+	[layer removeObjectsInArray:toGroup];
+	[layer addObject:[DKShapeGroup groupWithObjects:toGroup]];
+	[self checkIndexOfLayer:layer
+			  againstStyles:styles];
+
+	// replacing the whole list discards the index, which must rebuild correctly
+
+	[layer setObjects:[[layer objects] subarrayWithRange:NSMakeRange(0, 12)]];
+	[self checkIndexOfLayer:layer
+			  againstStyles:styles];
+}
+
+- (void)testIndexFollowsUndoAndRedo
+{
+	DKUndoManager* um = [[DKUndoManager alloc] init];
+	[um setGroupsByEvent:NO];
+
+	DKObjectDrawingLayer* layer = [self layerWithUndoManager:um];
+	NSArray* styles = @[sharedStyleWithColour([NSColor redColor]), sharedStyleWithColour([NSColor greenColor]), sharedStyleWithColour([NSColor blueColor])];
+	NSUInteger i;
+
+	[layer objectsWithStyle:styles[0]];
+
+	// step 1: add the objects
+
+	[um beginUndoGrouping];
+
+	for (i = 0; i < NUMBER_OF_OBJECTS; ++i) {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(i * 10, i * 10, 50, 50)];
+		[shape setStyle:styles[i % 3]];
+		[layer addObject:shape];
+	}
+
+	[um endUndoGrouping];
+
+	// step 2: swap a style throughout
+
+	[um beginUndoGrouping];
+	[layer replaceStyle:styles[0]
+				 withStyle:styles[2]
+		selectingObjects:NO];
+	[um endUndoGrouping];
+
+	// step 3: remove some objects and restyle others
+
+	[um beginUndoGrouping];
+	NSArray* objects = [layer objects];
+	[layer removeObjectsInArray:[objects subarrayWithRange:NSMakeRange(5, 15)]];
+	[[objects objectAtIndex:40] setStyle:styles[0]];
+	[[objects objectAtIndex:41] setStyle:nil];
+	[um endUndoGrouping];
+
+	NSUInteger countAfterEdits = [[layer objectsWithStyle:styles[2]] count];
+	[self checkIndexOfLayer:layer
+			  againstStyles:styles];
+
+	// undo all three steps, checking after each
+
+	for (i = 0; i < 3; ++i) {
+		XCTAssertTrue([um canUndo], @"expected something to undo");
+		[um undo];
+		[self checkIndexOfLayer:layer
+				  againstStyles:styles];
+	}
+
+	XCTAssertEqual([layer countOfObjects], (NSUInteger)0, @"undoing everything should leave the layer empty");
+
+	// redo them again
+
+	for (i = 0; i < 3; ++i) {
+		XCTAssertTrue([um canRedo], @"expected something to redo");
+		[um redo];
+		[self checkIndexOfLayer:layer
+				  againstStyles:styles];
+	}
+
+	XCTAssertEqual([[layer objectsWithStyle:styles[2]] count], countAfterEdits, @"redo should restore the edited state");
+}
+
+- (DKObjectDrawingLayer*)layerForBenchmarkWithStyles:(NSArray* __autoreleasing*)styles
+{
+	DKObjectDrawingLayer* layer = [self layerWithUndoManager:nil];
+	NSMutableArray* made = [NSMutableArray arrayWithCapacity:BENCHMARK_STYLES];
+	NSUInteger i;
+
+	for (i = 0; i < BENCHMARK_STYLES; ++i)
+		[made addObject:sharedStyleWithColour([NSColor colorWithCalibratedHue:(CGFloat)i / BENCHMARK_STYLES
+																	saturation:1
+																	brightness:1
+																		 alpha:1])];
+
+	for (i = 0; i < BENCHMARK_OBJECTS; ++i) {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(i % 100 * 10, i / 100 * 10, 8, 8)];
+		[shape setStyle:made[i % BENCHMARK_STYLES]];
+		[layer addObject:shape];
+	}
+
+	*styles = made;
+
+	return layer;
+}
+
+- (void)testPerformanceOfObjectsWithStyle
+{
+	NSArray* styles = nil;
+	DKObjectDrawingLayer* layer = [self layerForBenchmarkWithStyles:&styles];
+
+	[layer objectsWithStyle:styles[0]];
+
+	[self measureBlock:^{
+		for (DKStyle* style in styles)
+			[layer objectsWithStyle:style];
+	}];
+}
+
+- (void)testPerformanceOfAllStyles
+{
+	NSArray* styles = nil;
+	DKObjectDrawingLayer* layer = [self layerForBenchmarkWithStyles:&styles];
+
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < 100; ++i)
+			[layer allStyles];
+	}];
+}
+
+@end
@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKStyleRegistry.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for the name index kept by DKStyleRegistry.
+
+ Checks that names in use are found when registering styles and making unique names, and that the index follows a registered style
+ being renamed or unregistered, and styles being imported while skipping duplicate names. Times importing 50,000 styles.
+*/
+@interface TestStyleRegistry : XCTestCase
+
+- (void)testNameLookup;
+- (void)testRenamedStyle;
+- (void)testUnregisteredStyle;
+- (void)testImportIgnoringDuplicateNames;
+- (void)testPerformanceOfImport;
+
+@end
@@ -0,0 +1,142 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestStyleRegistry.h"
+#import <DKDrawKit/DKStyle.h>
+
+#define IMPORT_COUNT 50000
+
+@interface TestStyleRegistry ()
+
+- (DKStyle*)styleNamed:(NSString*)name;
+
+@end
+
+@implementation TestStyleRegistry
+
+- (void)setUp
+{
+	[super setUp];
+	[DKStyleRegistry resetRegistry];
+}
+
+- (void)tearDown
+{
+	[DKStyleRegistry resetRegistry];
+	[super tearDown];
+}
+
+- (DKStyle*)styleNamed:(NSString*)name
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor redColor]
+									 strokeColour:nil];
+	[style setName:name];
+
+	return style;
+}
+
+- (void)testNameLookup
+{
+	DKStyleRegistry* reg = [DKStyleRegistry sharedStyleRegistry];
+
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Test Style"], @"Test Style", @"an unused name should be returned unchanged");
+
+	DKStyle* first = [self styleNamed:@"Test Style"];
+	DKStyle* second = [self styleNamed:@"Test Style"];
+
+	[DKStyleRegistry registerStyle:first];
+	[DKStyleRegistry registerStyle:second];
+
+	XCTAssertEqualObjects([first name], @"Test Style", @"the first style should keep its name");
+	XCTAssertEqualObjects([second name], @"Test Style 1", @"a style registered under a name in use should be renamed");
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Test Style"], @"Test Style 2", @"both names in use should be skipped");
+	XCTAssertEqualObjects([reg styleNameForKey:[second uniqueKey]], @"Test Style 1", @"the registry should know the style by its new name");
+}
+
+- (void)testRenamedStyle
+{
+	DKStyleRegistry* reg = [DKStyleRegistry sharedStyleRegistry];
+	DKStyle* style = [self styleNamed:@"Old Name"];
+
+	[DKStyleRegistry registerStyle:style];
+
+	// look a name up first, so the index exists and must follow the rename
+
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Old Name"], @"Old Name 1", @"the registered name should be in use");
+
+	[style setLocked:NO];
+	[style setName:@"New Name"];
+	[style setLocked:YES];
+
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Old Name"], @"Old Name", @"the name given up by the rename should be free");
+	XCTAssertEqualObjects([reg uniqueNameForName:@"New Name"], @"New Name 1", @"the name taken by the rename should be in use");
+
+	DKStyle* other = [self styleNamed:@"New Name"];
+	[DKStyleRegistry registerStyle:other];
+
+	XCTAssertEqualObjects([other name], @"New Name 1", @"a style registered after the rename should avoid the new name");
+}
+
+- (void)testUnregisteredStyle
+{
+	DKStyleRegistry* reg = [DKStyleRegistry sharedStyleRegistry];
+	DKStyle* style = [self styleNamed:@"Removed"];
+	DKStyle* duplicate = [self styleNamed:@"Removed"];
+
+	[DKStyleRegistry registerStyle:style];
+	[DKStyleRegistry registerStyle:duplicate];
+
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Removed"], @"Removed 2", @"both names should be in use");
+
+	[DKStyleRegistry unregisterStyle:duplicate];
+
+	XCTAssertNil([DKStyleRegistry styleForKey:[duplicate uniqueKey]], @"the style should have been unregistered");
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Removed 1"], @"Removed 1", @"the name of the unregistered style should be free");
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Removed"], @"Removed 1", @"the name of the style still registered should be in use");
+
+	[DKStyleRegistry unregisterStyle:style];
+
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Removed"], @"Removed", @"no name should be in use once both styles are gone");
+}
+
+- (void)testImportIgnoringDuplicateNames
+{
+	DKStyleRegistry* reg = [DKStyleRegistry sharedStyleRegistry];
+	DKStyle* existing = [self styleNamed:@"Imported"];
+
+	[DKStyleRegistry registerStyle:existing];
+
+	NSArray* styles = @[[self styleNamed:@"Imported"], [self styleNamed:@"Fresh"], [self styleNamed:@"Fresh"]];
+
+	[DKStyleRegistry registerStylesFromArray:styles
+								inCategories:@[@"Test Styles"]
+					  ignoringDuplicateNames:YES];
+
+	XCTAssertNil([DKStyleRegistry styleForKey:[styles[0] uniqueKey]], @"a style whose name was registered before the import should be skipped");
+	XCTAssertNotNil([DKStyleRegistry styleForKey:[styles[1] uniqueKey]], @"a style with a new name should be imported");
+	XCTAssertNotNil([DKStyleRegistry styleForKey:[styles[2] uniqueKey]], @"only names registered before the import count as duplicates");
+	XCTAssertEqualObjects([styles[2] name], @"Fresh 1", @"a name repeated within the import should still be made unique");
+	XCTAssertEqualObjects([reg uniqueNameForName:@"Fresh"], @"Fresh 2", @"the imported names should be in the index");
+}
+
+- (void)testPerformanceOfImport
+{
+	NSMutableArray* styles = [NSMutableArray arrayWithCapacity:IMPORT_COUNT];
+
+	for (NSUInteger i = 0; i < IMPORT_COUNT; ++i)
+		[styles addObject:[self styleNamed:[NSString stringWithFormat:@"Imported Style %lu", (unsigned long)i]]];
+
+	[self measureBlock:^{
+		[DKStyleRegistry registerStylesFromArray:styles
+									inCategories:@[@"Imported Styles"]];
+
+		// the names are all distinct, so the same styles can be imported again after the registry is emptied
+
+		[[DKStyleRegistry sharedStyleRegistry] removeAllStyles];
+	}];
+}
+
+@end
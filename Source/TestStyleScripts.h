@@ -0,0 +1,26 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKStyleReader.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for reading style scripts.
+
+ Checks that symbols in a script are replaced by their values while literal sub-expressions such as lists of numbers are
+ passed on unevaluated, that objects which keep the expression they were made from each see their own items, and that
+ evaluating a script again makes new objects. Times parsing and evaluating a script of a few megabytes, and evaluating it
+ again once it has been parsed.
+*/
+@interface TestStyleScripts : XCTestCase
+
+- (void)testSymbolsAreEvaluated;
+- (void)testLiteralSubexpressionsAreNotEvaluated;
+- (void)testKeptExpressionsAreNotReused;
+- (void)testRepeatedScriptMakesNewObjects;
+- (void)testPerformanceOfReadingLargeScript;
+- (void)testPerformanceOfEvaluatingParsedScript;
+
+@end
@@ -0,0 +1,150 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestStyleScripts.h"
+#import <DKDrawKit/DKExpression.h>
+
+#define SCRIPT_ITEM_COUNT 50000
+
+// an object that keeps the expression it was made from, so the test can look at what the evaluator passed it
+
+@interface TestScriptedObject : NSObject
+
++ (id)instantiateFromExpression:(DKExpression*)expr;
+
+@property (strong) DKExpression* expression;
+
+@end
+
+@implementation TestScriptedObject
+
++ (id)instantiateFromExpression:(DKExpression*)expr
+{
+	TestScriptedObject* obj = [[self alloc] init];
+
+	obj.expression = expr;
+
+	return obj;
+}
+
+@end
+
+#pragma mark -
+
+@interface TestStyleScripts ()
+
+- (DKStyleReader*)reader;
+- (NSString*)largeScript;
+
+@end
+
+@implementation TestStyleScripts
+
+- (DKStyleReader*)reader
+{
+	DKStyleReader* reader = [[DKStyleReader alloc] init];
+
+	[reader registerClass:[TestScriptedObject class]
+			withShortName:@"thing"];
+
+	return reader;
+}
+
+- (NSString*)largeScript
+{
+	NSMutableString* script = [NSMutableString stringWithString:@"(thing "];
+
+	for (NSUInteger i = 0; i < SCRIPT_ITEM_COUNT; ++i)
+		[script appendFormat:@"(thing width:%lu.5 dash:(4 2 1) colour:red) ", (unsigned long)i];
+
+	[script appendString:@")"];
+
+	return script;
+}
+
+- (void)testSymbolsAreEvaluated
+{
+	DKStyleReader* reader = [self reader];
+	NSColor* colour = [reader evaluateScript:@"(colour r:1 g:0.5 b:0 a:1)"];
+
+	XCTAssertTrue([colour isKindOfClass:[NSColor class]], @"the colour short name should make a colour");
+	XCTAssertEqualWithAccuracy([colour greenComponent], 0.5, 0.001, @"the colour should have the green given");
+
+	TestScriptedObject* obj = [reader evaluateScript:@"(thing fill:red)"];
+
+	XCTAssertTrue([obj isKindOfClass:[TestScriptedObject class]], @"a registered short name should make an instance of its class");
+	XCTAssertEqualObjects([obj.expression valueForKey:@"fill"], [NSColor redColor], @"a symbol should be replaced by its value");
+}
+
+- (void)testLiteralSubexpressionsAreNotEvaluated
+{
+	TestScriptedObject* obj = [[self reader] evaluateScript:@"(thing list:(1 2 3) colour:(r:1 g:0 b:0) (4 5))"];
+	DKExpression* list = [obj.expression valueForKey:@"list"];
+	DKExpression* colour = [obj.expression valueForKey:@"colour"];
+	DKExpression* anonymous = [obj.expression valueAtIndex:3];
+
+	XCTAssertTrue([list isKindOfClass:[DKExpression class]], @"a list of numbers should be passed on as an expression");
+	XCTAssertEqual([list argCount], (NSInteger)3, @"the list should keep all its items");
+	XCTAssertEqualObjects([list valueAtIndex:2], @3, @"the list should keep its items in order");
+
+	XCTAssertTrue([colour isKindOfClass:[DKExpression class]], @"keyed values should be passed on as an expression");
+	XCTAssertEqualObjects([colour valueForKey:@"g"], @0, @"the keyed values should be kept");
+
+	XCTAssertTrue([anonymous isKindOfClass:[DKExpression class]], @"an unkeyed literal should be passed on as an expression");
+	XCTAssertEqualObjects([anonymous valueAtIndex:0], @4, @"the unkeyed literal should keep its items");
+}
+
+- (void)testKeptExpressionsAreNotReused
+{
+	// each inner object keeps the expression it was made from, so the evaluator must not reuse it for the next
+
+	TestScriptedObject* outer = [[self reader] evaluateScript:@"(thing (thing fill:red) (thing fill:blue))"];
+	TestScriptedObject* first = [outer.expression valueAtIndex:1];
+	TestScriptedObject* second = [outer.expression valueAtIndex:2];
+
+	XCTAssertNotEqual(first.expression, second.expression, @"objects should not share an expression");
+	XCTAssertEqualObjects([first.expression valueForKey:@"fill"], [NSColor redColor], @"the first object's expression was changed");
+	XCTAssertEqualObjects([second.expression valueForKey:@"fill"], [NSColor blueColor], @"the second object's expression was changed");
+}
+
+- (void)testRepeatedScriptMakesNewObjects
+{
+	DKStyleReader* reader = [self reader];
+	NSString* script = @"(thing width:2 fill:green)";
+	TestScriptedObject* a = [reader evaluateScript:script];
+	TestScriptedObject* b = [reader evaluateScript:script];
+
+	XCTAssertNotEqual(a, b, @"each evaluation should make a new object");
+	XCTAssertEqualObjects([b.expression valueForKey:@"width"], @2, @"the script should read the same the second time");
+	XCTAssertEqualObjects([b.expression valueForKey:@"fill"], [NSColor greenColor], @"symbols should be evaluated the second time");
+}
+
+- (void)testPerformanceOfReadingLargeScript
+{
+	NSString* script = [self largeScript];
+
+	// a new reader each time, so that the script is parsed every time
+
+	[self measureBlock:^{
+		TestScriptedObject* obj = [[self reader] evaluateScript:script];
+		XCTAssertEqual([obj.expression argCount], (NSInteger)(SCRIPT_ITEM_COUNT + 1), @"every item should be read");
+	}];
+}
+
+- (void)testPerformanceOfEvaluatingParsedScript
+{
+	NSString* script = [self largeScript];
+	DKStyleReader* reader = [self reader];
+
+	[reader evaluateScript:script];
+
+	[self measureBlock:^{
+		TestScriptedObject* obj = [reader evaluateScript:script];
+		XCTAssertEqual([obj.expression argCount], (NSInteger)(SCRIPT_ITEM_COUNT + 1), @"every item should be read");
+	}];
+}
+
+@end
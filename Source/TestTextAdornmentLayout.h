@@ -0,0 +1,25 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKTextAdornment.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for per-object text layout in DKTextAdornment.
+
+ Checks that an object keeps its laid out text between draws, that whether the text fitted is reported for each object and for the
+ last object drawn, that objects sharing an adornment keep separate layouts, that a change of metadata or of the adornment lays the
+ text out again, that text can be laid out on several threads at once, and times redrawing 2,000 labelled shapes.
+*/
+@interface TestTextAdornmentLayout : XCTestCase
+
+- (void)testLayoutIsReused;
+- (void)testFittingIsReportedPerObject;
+- (void)testObjectsKeepSeparateLayouts;
+- (void)testLayoutRebuiltOnChange;
+- (void)testConcurrentLayout;
+- (void)testPerformanceOfLabelledShapes;
+
+@end
@@ -0,0 +1,233 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestTextAdornmentLayout.h"
+#import <DKDrawKit/DKDrawableObject+Metadata.h>
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/NSBezierPath+Editing.h>
+
+#define BITMAP_SIZE 512
+#define SHAPE_COUNT 2000
+
+@interface TestTextAdornmentLayout ()
+
+- (DKTextAdornment*)nameLabel;
+- (DKDrawableShape*)shapeNamed:(NSString*)name inRect:(NSRect)rect;
+- (id)layoutOfShape:(DKDrawableShape*)shape forAdornment:(DKTextAdornment*)adornment;
+- (void)renderShapes:(NSArray<DKDrawableShape*>*)shapes withAdornment:(DKTextAdornment*)adornment;
+
+@end
+
+@implementation TestTextAdornmentLayout
+
+- (DKTextAdornment*)nameLabel
+{
+	DKTextAdornment* adornment = [DKTextAdornment textAdornmentWithText:@"Shape %%name"];
+
+	[adornment setVerticalAlignment:kDKTextShapeVerticalAlignmentCentre];
+	[adornment setWrapsLines:YES];
+
+	return adornment;
+}
+
+- (DKDrawableShape*)shapeNamed:(NSString*)name inRect:(NSRect)rect
+{
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:rect];
+
+	[shape setString:name
+			  forKey:@"name"];
+
+	return shape;
+}
+
+- (id)layoutOfShape:(DKDrawableShape*)shape forAdornment:(DKTextAdornment*)adornment
+{
+	return [adornment renderingCacheEntryForObject:shape];
+}
+
+- (void)renderShapes:(NSArray<DKDrawableShape*>*)shapes withAdornment:(DKTextAdornment*)adornment
+{
+	NSBitmapImageRep* bitmap = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	   pixelsWide:BITMAP_SIZE
+																	   pixelsHigh:BITMAP_SIZE
+																	bitsPerSample:8
+																  samplesPerPixel:4
+																		 hasAlpha:YES
+																		 isPlanar:NO
+																   colorSpaceName:NSCalibratedRGBColorSpace
+																	  bytesPerRow:0
+																	 bitsPerPixel:0];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+
+	for (DKDrawableShape* shape in shapes)
+		[adornment render:shape];
+
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (void)testLayoutIsReused
+{
+	DKTextAdornment* adornment = [self nameLabel];
+	DKDrawableShape* shape = [self shapeNamed:@"one"
+									   inRect:NSMakeRect(20, 20, 200, 100)];
+
+	[self renderShapes:@[shape]
+		 withAdornment:adornment];
+
+	id layout = [self layoutOfShape:shape
+					   forAdornment:adornment];
+
+	XCTAssertNotNil(layout, @"drawing should leave the layout in the object's cache");
+
+	[self renderShapes:@[shape]
+		 withAdornment:adornment];
+	XCTAssertTrue([self layoutOfShape:shape
+						 forAdornment:adornment] == layout,
+		@"an unchanged object should reuse its layout");
+	XCTAssertTrue([adornment allTextWasFittedForObject:shape], @"the label should fit in the shape");
+
+	// the text system is shared; the object keeps only what it produced
+
+	XCTAssertNotEqual([[layout valueForKey:@"mGlyphRuns"] count], (NSUInteger)0, @"the object should keep its glyphs and their positions");
+	XCTAssertFalse([[layout valueForKey:@"mText"] isKindOfClass:[NSTextStorage class]], @"the object should not keep a text storage");
+}
+
+- (void)testFittingIsReportedPerObject
+{
+	DKTextAdornment* adornment = [self nameLabel];
+	DKDrawableShape* roomy = [self shapeNamed:@"one"
+									   inRect:NSMakeRect(20, 20, 300, 100)];
+	DKDrawableShape* cramped = [self shapeNamed:@"with a name far too long to fit in such a small shape"
+										 inRect:NSMakeRect(20, 200, 30, 12)];
+
+	[self renderShapes:@[cramped, roomy]
+		 withAdornment:adornment];
+
+	XCTAssertTrue([adornment allTextWasFittedForObject:roomy], @"the label should fit in the roomy shape");
+	XCTAssertFalse([adornment allTextWasFittedForObject:cramped], @"drawing another object should not hide that this one's text didn't fit");
+	XCTAssertTrue([adornment allTextWasFitted], @"the adornment should report the fitting of the object it drew last");
+
+	[self renderShapes:@[roomy, cramped]
+		 withAdornment:adornment];
+
+	XCTAssertFalse([adornment allTextWasFitted], @"the adornment should report the fitting of the object it drew last");
+}
+
+- (void)testObjectsKeepSeparateLayouts
+{
+	DKTextAdornment* adornment = [self nameLabel];
+	DKDrawableShape* first = [self shapeNamed:@"one"
+									   inRect:NSMakeRect(20, 20, 200, 100)];
+	DKDrawableShape* second = [self shapeNamed:@"two"
+										inRect:NSMakeRect(20, 200, 200, 100)];
+
+	[self renderShapes:@[first, second]
+		 withAdornment:adornment];
+
+	id firstLayout = [self layoutOfShape:first
+							forAdornment:adornment];
+	id secondLayout = [self layoutOfShape:second
+							 forAdornment:adornment];
+
+	XCTAssertTrue(firstLayout != secondLayout, @"each object should have its own layout");
+
+	// drawing the other object, with different metadata, must not throw away the first one's layout
+
+	[self renderShapes:@[first, second, first]
+		 withAdornment:adornment];
+	XCTAssertTrue([self layoutOfShape:first
+						 forAdornment:adornment] == firstLayout,
+		@"drawing another object should not replace this one's layout");
+	XCTAssertTrue([self layoutOfShape:second
+						 forAdornment:adornment] == secondLayout,
+		@"drawing another object should not replace this one's layout");
+}
+
+- (void)testLayoutRebuiltOnChange
+{
+	DKTextAdornment* adornment = [self nameLabel];
+	DKDrawableShape* shape = [self shapeNamed:@"one"
+									   inRect:NSMakeRect(20, 20, 200, 100)];
+	NSUInteger before = [[adornment textAsPathForObject:shape] checksum];
+
+	[self renderShapes:@[shape]
+		 withAdornment:adornment];
+
+	id layout = [self layoutOfShape:shape
+					   forAdornment:adornment];
+
+	[shape setString:@"something else"
+			  forKey:@"name"];
+	[self renderShapes:@[shape]
+		 withAdornment:adornment];
+	XCTAssertTrue([self layoutOfShape:shape
+						 forAdornment:adornment] != layout,
+		@"changing the object's metadata should lay the text out again");
+	XCTAssertNotEqual([[adornment textAsPathForObject:shape] checksum], before, @"the text path should follow the new metadata");
+	layout = [self layoutOfShape:shape
+					forAdornment:adornment];
+
+	[adornment setLabel:@"Renamed %%name"];
+	[self renderShapes:@[shape]
+		 withAdornment:adornment];
+	XCTAssertTrue([self layoutOfShape:shape
+						 forAdornment:adornment] != layout,
+		@"changing the label should lay the text out again");
+}
+
+- (void)testConcurrentLayout
+{
+	DKTextAdornment* adornment = [self nameLabel];
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray array];
+	const NSUInteger count = 64;
+	NSUInteger i;
+
+	for (i = 0; i < count; ++i)
+		[shapes addObject:[self shapeNamed:[NSString stringWithFormat:@"number %lu", (unsigned long)i]
+									inRect:NSMakeRect(10, 10, 100 + i, 80)]];
+
+	NSUInteger* serial = calloc(count, sizeof(NSUInteger));
+	NSUInteger* concurrent = calloc(count, sizeof(NSUInteger));
+
+	for (i = 0; i < count; ++i)
+		serial[i] = [[adornment textAsPathForObject:shapes[i]] checksum];
+
+	dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t n) {
+		concurrent[n] = [[adornment textAsPathForObject:shapes[n]] checksum];
+	});
+
+	for (i = 0; i < count; ++i)
+		XCTAssertEqual(serial[i], concurrent[i], @"text laid out on another thread differs for shape %lu", (unsigned long)i);
+
+	free(serial);
+	free(concurrent);
+}
+
+- (void)testPerformanceOfLabelledShapes
+{
+	DKTextAdornment* adornment = [self nameLabel];
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray arrayWithCapacity:SHAPE_COUNT];
+
+	for (NSUInteger i = 0; i < SHAPE_COUNT; ++i) {
+		CGFloat x = 10 + (i % 40) * 12;
+		CGFloat y = 10 + (i / 40) * 9;
+
+		[shapes addObject:[self shapeNamed:[NSString stringWithFormat:@"%lu", (unsigned long)i]
+									inRect:NSMakeRect(x, y, 80, 30)]];
+	}
+
+	[self renderShapes:shapes
+		 withAdornment:adornment];
+
+	[self measureBlock:^{
+		[self renderShapes:shapes
+			 withAdornment:adornment];
+	}];
+}
+
+@end
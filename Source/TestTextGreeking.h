@@ -0,0 +1,24 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKGreekingLayoutManager.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for greeking and automatic greeking.
+
+ Checks that greeking blocks follow the text when it changes, that text too small to read on screen is greeked automatically and
+ text large enough is not, going by the size most of the text is set in, and times drawing 2,000 labelled shapes at several zoom levels.
+*/
+@interface TestTextGreeking : XCTestCase
+
+- (void)testGreekingBlocksFollowText;
+- (void)testAutomaticGreekingFromScale;
+- (void)testAutomaticGreekingFollowsMostOfTheText;
+- (void)testPerformanceAtFullSize;
+- (void)testPerformanceAtQuarterSize;
+- (void)testPerformanceAtTenthSize;
+
+@end
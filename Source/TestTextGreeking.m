@@ -0,0 +1,243 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestTextGreeking.h"
+#import <DKDrawKit/DKDrawableObject+Metadata.h>
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKTextAdornment.h>
+
+#define BITMAP_SIZE 512
+#define SHAPE_COUNT 2000
+
+@interface DKTextAdornment (Greeking)
+
+- (DKGreeking)greekingForText:(NSAttributedString*)text transform:(NSAffineTransform*)tfm;
+
+@end
+
+@interface TestTextGreeking ()
+
+- (NSBitmapImageRep*)newBitmap;
+- (NSArray<DKDrawableShape*>*)labelledShapes;
+- (NSBitmapImageRep*)renderShapes:(NSArray<DKDrawableShape*>*)shapes withAdornment:(DKTextAdornment*)adornment scale:(CGFloat)scale;
+- (NSUInteger)countPixelsInBitmap:(NSBitmapImageRep*)bitmap lighterThan:(CGFloat)level;
+- (void)measureShapesAtScale:(CGFloat)scale;
+
+@end
+
+@implementation TestTextGreeking
+
+- (NSBitmapImageRep*)newBitmap
+{
+	return [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+												   pixelsWide:BITMAP_SIZE
+												   pixelsHigh:BITMAP_SIZE
+												bitsPerSample:8
+											  samplesPerPixel:4
+													 hasAlpha:YES
+													 isPlanar:NO
+											   colorSpaceName:NSCalibratedRGBColorSpace
+												  bytesPerRow:0
+												 bitsPerPixel:0];
+}
+
+- (NSArray<DKDrawableShape*>*)labelledShapes
+{
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray arrayWithCapacity:SHAPE_COUNT];
+
+	for (NSUInteger i = 0; i < SHAPE_COUNT; ++i) {
+		CGFloat x = 10 + (i % 40) * 120;
+		CGFloat y = 10 + (i / 40) * 90;
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(x, y, 110, 80)];
+
+		[shape setString:[NSString stringWithFormat:@"item %lu of a text-heavy drawing", (unsigned long)i]
+				  forKey:@"name"];
+		[shapes addObject:shape];
+	}
+
+	return shapes;
+}
+
+- (NSBitmapImageRep*)renderShapes:(NSArray<DKDrawableShape*>*)shapes withAdornment:(DKTextAdornment*)adornment scale:(CGFloat)scale
+{
+	NSBitmapImageRep* bitmap = [self newBitmap];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+
+	NSAffineTransform* zoom = [NSAffineTransform transform];
+	[zoom scaleBy:scale];
+	[zoom concat];
+
+	for (DKDrawableShape* shape in shapes)
+		[adornment render:shape];
+
+	[NSGraphicsContext restoreGraphicsState];
+
+	return bitmap;
+}
+
+- (NSUInteger)countPixelsInBitmap:(NSBitmapImageRep*)bitmap lighterThan:(CGFloat)level
+{
+	// counts the drawn pixels whose colour, ignoring coverage, is lighter than <level>. Text is black; greeking is light grey
+
+	NSUInteger count = 0;
+
+	for (NSInteger y = 0; y < BITMAP_SIZE; ++y)
+		for (NSInteger x = 0; x < BITMAP_SIZE; ++x) {
+			NSColor* colour = [bitmap colorAtX:x
+											 y:y];
+
+			if ([colour alphaComponent] > 0.0 && [colour redComponent] > level)
+				++count;
+		}
+
+	return count;
+}
+
+- (void)measureShapesAtScale:(CGFloat)scale
+{
+	DKTextAdornment* adornment = [DKTextAdornment textAdornmentWithText:@"%%name"];
+	NSArray<DKDrawableShape*>* shapes = [self labelledShapes];
+
+	[adornment setWrapsLines:YES];
+
+	[self renderShapes:shapes
+		 withAdornment:adornment
+				 scale:scale];
+
+	[self measureBlock:^{
+		[self renderShapes:shapes
+			 withAdornment:adornment
+					 scale:scale];
+	}];
+}
+
+- (void)testGreekingBlocksFollowText
+{
+	DKGreekingLayoutManager* lm = [[DKGreekingLayoutManager alloc] init];
+	NSTextContainer* tc = [[NSTextContainer alloc] initWithContainerSize:NSMakeSize(400, 400)];
+	NSTextStorage* text = [[NSTextStorage alloc] initWithString:@"Greeked text"
+													 attributes:@{ NSFontAttributeName: [NSFont fontWithName:@"Helvetica"
+																										size:24] }];
+	NSUInteger before, after;
+
+	[lm addTextContainer:tc];
+	[text addLayoutManager:lm];
+	[lm setGreeking:kDKGreekingByGlyphRectangle];
+
+	NSBitmapImageRep* bitmap = [self newBitmap];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+	[lm drawGlyphsForGlyphRange:[lm glyphRangeForTextContainer:tc]
+						atPoint:NSMakePoint(10, 10)];
+	[NSGraphicsContext restoreGraphicsState];
+
+	before = [self countPixelsInBitmap:bitmap
+						   lighterThan:0.5];
+	XCTAssertTrue(before > 0, @"greeking should draw blocks");
+
+	// the blocks are kept between draws, so a longer string must replace them
+
+	[text appendAttributedString:[[NSAttributedString alloc] initWithString:@" and a good deal more of it"
+																  attributes:[text attributesAtIndex:0
+																					  effectiveRange:NULL]]];
+
+	bitmap = [self newBitmap];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+	[lm drawGlyphsForGlyphRange:[lm glyphRangeForTextContainer:tc]
+						atPoint:NSMakePoint(10, 10)];
+	[NSGraphicsContext restoreGraphicsState];
+
+	after = [self countPixelsInBitmap:bitmap
+						  lighterThan:0.5];
+	XCTAssertTrue(after > before, @"greeking blocks should be worked out again when the text changes");
+}
+
+- (void)testAutomaticGreekingFromScale
+{
+	DKTextAdornment* adornment = [DKTextAdornment textAdornmentWithText:@"%%name"];
+	NSArray<DKDrawableShape*>* shapes = [[self labelledShapes] subarrayWithRange:NSMakeRange(0, 40)];
+	CGFloat threshold = [DKTextAdornment automaticGreekingTextSize];
+	NSBitmapImageRep* bitmap;
+
+	[adornment setWrapsLines:YES];
+
+	bitmap = [self renderShapes:shapes
+				  withAdornment:adornment
+						  scale:1.0];
+	XCTAssertEqual([self countPixelsInBitmap:bitmap
+								 lighterThan:0.5],
+		(NSUInteger)0, @"readable text should not be greeked");
+
+	bitmap = [self renderShapes:shapes
+				  withAdornment:adornment
+						  scale:0.1];
+	XCTAssertTrue([self countPixelsInBitmap:bitmap
+								lighterThan:0.5] > 0,
+		@"text too small to read should be greeked");
+
+	[DKTextAdornment setAutomaticGreekingTextSize:0];
+
+	bitmap = [self renderShapes:shapes
+				  withAdornment:adornment
+						  scale:0.1];
+	XCTAssertEqual([self countPixelsInBitmap:bitmap
+								 lighterThan:0.5],
+		(NSUInteger)0, @"text should not be greeked when automatic greeking is off");
+
+	[DKTextAdornment setAutomaticGreekingTextSize:threshold];
+}
+
+- (void)testAutomaticGreekingFollowsMostOfTheText
+{
+	DKTextAdornment* adornment = [DKTextAdornment textAdornmentWithText:@""];
+	CGFloat threshold = [DKTextAdornment automaticGreekingTextSize];
+	NSFont* small = [NSFont systemFontOfSize:threshold * 0.75];
+	NSFont* large = [NSFont systemFontOfSize:threshold * 4];
+	NSMutableAttributedString* smallPrint = [[NSMutableAttributedString alloc] initWithString:@"W"
+																				   attributes:@{ NSFontAttributeName : large }];
+	NSMutableAttributedString* heading = [[NSMutableAttributedString alloc] initWithString:@"a heading over a paragraph"
+																				attributes:@{ NSFontAttributeName : large }];
+	NSBitmapImageRep* bitmap = [self newBitmap];
+
+	[smallPrint appendAttributedString:[[NSAttributedString alloc] initWithString:@"ith a large initial, this is small print"
+																	   attributes:@{ NSFontAttributeName : small }]];
+	[heading appendAttributedString:[[NSAttributedString alloc] initWithString:@" and a footnote"
+																	attributes:@{ NSFontAttributeName : small }]];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+
+	XCTAssertEqual([adornment greekingForText:smallPrint
+									transform:nil],
+		kDKGreekingByGlyphRectangle, @"small print should be greeked despite a large first character");
+	XCTAssertEqual([adornment greekingForText:heading
+									transform:nil],
+		kDKGreekingNone, @"mostly large text should not be greeked for a small footnote");
+
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+- (void)testPerformanceAtFullSize
+{
+	[self measureShapesAtScale:1.0];
+}
+
+- (void)testPerformanceAtQuarterSize
+{
+	[self measureShapesAtScale:0.25];
+}
+
+- (void)testPerformanceAtTenthSize
+{
+	[self measureShapesAtScale:0.1];
+}
+
+@end
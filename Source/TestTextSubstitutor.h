@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKTextSubstitutor.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for compiled text substitution templates.
+
+ Checks that substituted strings keep the text and attributes they had when each key was replaced in place, that cached
+ results follow changes to the metadata and the template, and times labelling a large number of objects.
+*/
+@interface TestTextSubstitutor : XCTestCase
+
+- (void)testSubstitution;
+- (void)testAttributesOfSubstitutedValues;
+- (void)testResultsFollowChanges;
+- (void)testBulkSubstitution;
+- (void)testPerformanceOfBulkSubstitution;
+
+@end
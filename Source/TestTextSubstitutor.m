@@ -0,0 +1,152 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestTextSubstitutor.h"
+
+#define NUMBER_OF_OBJECTS 20000
+
+/** @brief The smallest object that can supply metadata to a substitutor.
+ */
+@interface TestLabelledObject : NSObject
+
+@property (copy) NSDictionary* metadata;
+- (id)metadataObjectForKey:(NSString*)key;
+
+@end
+
+@implementation TestLabelledObject
+
+- (id)metadataObjectForKey:(NSString*)key
+{
+	return [[self metadata] objectForKey:key];
+}
+
+@end
+
+#pragma mark -
+
+static TestLabelledObject* labelledObject(NSDictionary* metadata)
+{
+	TestLabelledObject* object = [[TestLabelledObject alloc] init];
+	[object setMetadata:metadata];
+
+	return object;
+}
+
+@implementation TestTextSubstitutor
+
+- (void)testSubstitution
+{
+	DKTextSubstitutor* subs = [[DKTextSubstitutor alloc] initWithString:@"Room %%name.U, %%area sq m (%%ref.#05)"];
+	TestLabelledObject* room = labelledObject(@{ @"name" : @"kitchen",
+		@"area" : @12.5,
+		@"ref" : @"42" });
+
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:room] string], @"Room KITCHEN, 12.5 sq m (00042)", @"keys should be replaced by their values");
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:labelledObject(@{})] string], @"Room ,  sq m ()", @"missing values should be replaced by nothing");
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:@"not labelled"] string], @"Room ,  sq m ()", @"an object without metadata should give empty values");
+
+	DKTextSubstitutor* plain = [[DKTextSubstitutor alloc] initWithString:@"no keys here"];
+
+	XCTAssertEqualObjects([plain substitutedStringWithObject:room], [plain masterString], @"a string without keys should be returned as is");
+}
+
+- (void)testAttributesOfSubstitutedValues
+{
+	NSFont* bold = [NSFont boldSystemFontOfSize:12];
+	NSFont* plain = [NSFont systemFontOfSize:12];
+	NSMutableAttributedString* master = [[NSMutableAttributedString alloc] initWithString:@"Name: %%name end"
+																			   attributes:@{ NSFontAttributeName : plain }];
+
+	[master addAttribute:NSFontAttributeName
+				   value:bold
+				   range:NSMakeRange(6, 6)];
+
+	DKTextSubstitutor* subs = [[DKTextSubstitutor alloc] initWithAttributedString:master];
+	NSAttributedString* result = [subs substitutedStringWithObject:labelledObject(@{ @"name" : @"Alexandra" })];
+
+	XCTAssertEqualObjects([result string], @"Name: Alexandra end", @"the value should replace the key");
+	XCTAssertEqualObjects([result attribute:NSFontAttributeName
+									atIndex:0
+							 effectiveRange:NULL],
+		plain, @"literal text should keep its attributes");
+
+	NSRange effective;
+
+	XCTAssertEqualObjects([result attribute:NSFontAttributeName
+									atIndex:6
+							 effectiveRange:&effective],
+		bold, @"the value should take on the attributes of the key");
+	XCTAssertTrue(NSEqualRanges(effective, NSMakeRange(6, 9)), @"the value's attributes should cover exactly the value");
+	XCTAssertEqualObjects([result attribute:NSFontAttributeName
+									atIndex:15
+							 effectiveRange:NULL],
+		plain, @"text after the key should keep its attributes");
+}
+
+- (void)testResultsFollowChanges
+{
+	DKTextSubstitutor* subs = [[DKTextSubstitutor alloc] initWithString:@"%%name.U"];
+	TestLabelledObject* object = labelledObject(@{ @"name" : @"first" });
+
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:object] string], @"FIRST");
+
+	[object setMetadata:@{ @"name" : @"second" }];
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:object] string], @"SECOND", @"a cached result should not outlive the metadata it was made from");
+
+	[subs setString:@"<%%name.L>"
+		withAttributes:nil];
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:object] string], @"<second>", @"a new master string should be recompiled");
+
+	NSString* oldDelimiter = [DKTextSubstitutor delimiterString];
+
+	[DKTextSubstitutor setDelimiterString:@"$$"];
+	[subs setString:@"<$$name>"
+		withAttributes:nil];
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:object] string], @"<second>", @"the template should use the current delimiter");
+	[DKTextSubstitutor setDelimiterString:oldDelimiter];
+	XCTAssertEqualObjects([[subs substitutedStringWithObject:object] string], @"<$$name>", @"changing the delimiter should recompile existing templates");
+}
+
+- (void)testBulkSubstitution
+{
+	DKTextSubstitutor* subs = [[DKTextSubstitutor alloc] initWithString:@"%%id: %%kind"];
+	NSMutableArray* objects = [NSMutableArray array];
+
+	for (NSUInteger i = 0; i < 50; ++i)
+		[objects addObject:labelledObject(@{ @"id" : @(i % 10),
+			@"kind" : (i & 1) ? @"odd" : @"even" })];
+
+	NSArray* results = [subs substitutedStringsWithObjects:objects];
+
+	XCTAssertEqual([results count], [objects count], @"there should be one result per object");
+
+	for (NSUInteger i = 0; i < [objects count]; ++i) {
+		XCTAssertEqualObjects([results objectAtIndex:i], [subs substitutedStringWithObject:[objects objectAtIndex:i]], @"bulk and single substitution should agree");
+		XCTAssertEqualObjects([[results objectAtIndex:i] string], ([NSString stringWithFormat:@"%lu: %@", (unsigned long)(i % 10), (i & 1) ? @"odd" : @"even"]));
+	}
+}
+
+- (void)testPerformanceOfBulkSubstitution
+{
+	DKTextSubstitutor* subs = [[DKTextSubstitutor alloc] initWithString:@"Plot %%plot.#04 - %%owner.C (%%area m2), zone %%zone.U"];
+	NSMutableArray* objects = [NSMutableArray arrayWithCapacity:NUMBER_OF_OBJECTS];
+
+	for (NSUInteger i = 0; i < NUMBER_OF_OBJECTS; ++i)
+		[objects addObject:labelledObject(@{ @"plot" : @(i),
+			@"owner" : @"a. n. other",
+			@"area" : @(100 + i % 37),
+			@"zone" : (i % 3) ? @"residential" : @"commercial" })];
+
+	// the first pass fills the cache, later ones are the repeated redraws of objects whose metadata hasn't changed
+
+	[self measureBlock:^{
+		for (NSUInteger pass = 0; pass < 5; ++pass)
+			[subs substitutedStringsWithObjects:objects];
+	}];
+}
+
+@end
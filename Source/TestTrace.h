@@ -0,0 +1,28 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKTrace.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for DKTrace.
+
+ Checks that nothing is recorded for categories that are off, that spans are recorded with their durations and arguments, that a
+ full buffer keeps the newest events, that a finished thread's events outlive it and a reset discards a running thread's events,
+ that the hit-testing and storage trace points fire, and that the written trace is in the documented format. Times a million trace
+ points with tracing off and on.
+*/
+@interface TestTrace : XCTestCase
+
+- (void)testNothingRecordedWhenDisabled;
+- (void)testSpansAndInstants;
+- (void)testFullBufferKeepsNewestEvents;
+- (void)testResetWhileOtherThreadsRecord;
+- (void)testHitTestingIsTraced;
+- (void)testTraceDataFormat;
+- (void)testPerformanceOfDisabledTracePoints;
+- (void)testPerformanceOfEnabledTracePoints;
+
+@end
@@ -0,0 +1,306 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestTrace.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#include <pthread.h>
+
+#define SMALL_CAPACITY 8
+#define EVENTS_ON_THREAD 20
+#define TRACE_POINT_COUNT 1000000
+
+static void* recordEventsOnThread(void* unused)
+{
+#pragma unused(unused)
+	for (NSUInteger i = 0; i < EVENTS_ON_THREAD; ++i)
+		DKTraceInstant(kDKTraceStorage, "thread event", i);
+
+	return NULL;
+}
+
+static dispatch_semaphore_t sRecorded;
+static dispatch_semaphore_t sProceed;
+
+static void* recordEventsAroundReset(void* unused)
+{
+#pragma unused(unused)
+	// records some events, waits while the test resets the trace, then records some more, waiting again before it finishes
+
+	for (NSUInteger i = 0; i < 3; ++i)
+		DKTraceInstant(kDKTraceStorage, "before reset", i);
+
+	dispatch_semaphore_signal(sRecorded);
+	dispatch_semaphore_wait(sProceed, DISPATCH_TIME_FOREVER);
+
+	for (NSUInteger i = 0; i < 2; ++i)
+		DKTraceInstant(kDKTraceStorage, "after reset", i);
+
+	dispatch_semaphore_signal(sRecorded);
+	dispatch_semaphore_wait(sProceed, DISPATCH_TIME_FOREVER);
+
+	return NULL;
+}
+
+@interface TestTrace ()
+
+- (NSArray<NSDictionary*>*)eventsInTraceData:(NSData*)data;
+- (NSArray<NSDictionary*>*)eventsNamed:(NSString*)name;
+
+@end
+
+@implementation TestTrace
+
+- (void)setUp
+{
+	[super setUp];
+	DKTraceSetEnabledCategories(0);
+	DKTraceReset();
+}
+
+- (void)tearDown
+{
+	DKTraceSetEnabledCategories(0);
+	DKTraceSetBufferCapacity(16384);
+	DKTraceReset();
+	[super tearDown];
+}
+
+- (NSArray<NSDictionary*>*)eventsInTraceData:(NSData*)data
+{
+	// reads the whole trace as the header documents it, failing if it doesn't add up to exactly the length of the data
+
+	const uint8_t* bytes = [data bytes];
+	NSUInteger offset = 16;
+	uint32_t header[3];
+	NSMutableArray* names = [NSMutableArray array];
+	NSMutableArray* events = [NSMutableArray array];
+
+	XCTAssertGreaterThanOrEqual([data length], (NSUInteger)16, @"trace should have a header");
+	XCTAssertEqual(memcmp(bytes, "DKTR", 4), 0, @"trace should start with its magic number");
+	memcpy(header, bytes + 4, sizeof(header));
+	XCTAssertEqual(header[0], (uint32_t)1, @"trace should be format version 1");
+
+	for (uint32_t i = 0; i < header[1]; ++i) {
+		uint32_t length;
+
+		memcpy(&length, bytes + offset, sizeof(length));
+		[names addObject:[[NSString alloc] initWithBytes:bytes + offset + 4
+												  length:length
+												encoding:NSUTF8StringEncoding]];
+		offset += 4 + length;
+	}
+
+	for (uint32_t t = 0; t < header[2]; ++t) {
+		uint64_t threadID;
+		uint32_t count;
+
+		memcpy(&threadID, bytes + offset, sizeof(threadID));
+		memcpy(&count, bytes + offset + 8, sizeof(count));
+		offset += 8 + 4 + 64;
+
+		for (uint32_t e = 0; e < count; ++e) {
+			uint64_t values[3];
+			uint32_t nameIndex;
+
+			memcpy(values, bytes + offset, sizeof(values));
+			memcpy(&nameIndex, bytes + offset + 24, sizeof(nameIndex));
+			XCTAssertLessThan(nameIndex, header[1], @"event should name one of the trace's names");
+
+			[events addObject:@{ @"name" : names[nameIndex],
+				@"thread" : @(threadID),
+				@"start" : @(values[0]),
+				@"duration" : @(values[1]),
+				@"argument" : @(values[2]),
+				@"phase" : @(bytes[offset + 28]),
+				@"category" : @(bytes[offset + 29]) }];
+
+			offset += 32;
+		}
+	}
+
+	XCTAssertEqual(offset, [data length], @"trace should end after its last event");
+
+	return events;
+}
+
+- (NSArray<NSDictionary*>*)eventsNamed:(NSString*)name
+{
+	return [[self eventsInTraceData:DKTraceData()] filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name == %@", name]];
+}
+
+- (void)testNothingRecordedWhenDisabled
+{
+	DKTraceSetEnabledCategories(kDKTraceRendering);
+
+	{
+		DKTraceScope(span, kDKTraceStorage, "disabled span");
+		span.argument = 1;
+	}
+	DKTraceInstant(kDKTraceUndo, "disabled instant", 2);
+
+	XCTAssertFalse(DKTraceIsEnabled(kDKTraceStorage), @"storage should not be traced");
+	XCTAssertTrue(DKTraceIsEnabled(kDKTraceRendering), @"rendering should be traced");
+	XCTAssertEqual([[self eventsNamed:@"disabled span"] count], (NSUInteger)0, @"a span in a disabled category should not be recorded");
+	XCTAssertEqual([[self eventsNamed:@"disabled instant"] count], (NSUInteger)0, @"an instant in a disabled category should not be recorded");
+}
+
+- (void)testSpansAndInstants
+{
+	DKTraceSetEnabledCategories(kDKTraceAllCategories);
+
+	{
+		DKTraceScope(span, kDKTraceArchiving, "sleeping span");
+		usleep(2000);
+		span.argument = 42;
+	}
+	DKTraceInstant(kDKTraceUndo, "an instant", 7);
+
+	NSArray* spans = [self eventsNamed:@"sleeping span"];
+	NSArray* instants = [self eventsNamed:@"an instant"];
+
+	XCTAssertEqual([spans count], (NSUInteger)1, @"the span should be recorded once");
+	XCTAssertEqual([spans[0][@"phase"] charValue], 'X', @"a span should be a complete event");
+	XCTAssertGreaterThanOrEqual([spans[0][@"duration"] unsignedLongLongValue], 2000000ULL, @"the span should last at least as long as the sleep");
+	XCTAssertEqual([spans[0][@"argument"] unsignedLongLongValue], 42ULL, @"the argument set in the span should be recorded");
+	XCTAssertEqual([spans[0][@"category"] unsignedCharValue], (uint8_t)3, @"archiving is category bit 3");
+
+	XCTAssertEqual([instants count], (NSUInteger)1, @"the instant should be recorded once");
+	XCTAssertEqual([instants[0][@"phase"] charValue], 'i', @"an instant should be an instant event");
+	XCTAssertEqual([instants[0][@"duration"] unsignedLongLongValue], 0ULL, @"an instant should have no duration");
+	XCTAssertGreaterThanOrEqual([instants[0][@"start"] unsignedLongLongValue], [spans[0][@"start"] unsignedLongLongValue] + [spans[0][@"duration"] unsignedLongLongValue], @"the instant came after the span ended");
+}
+
+- (void)testFullBufferKeepsNewestEvents
+{
+	pthread_t thread;
+
+	// the capacity applies to buffers made from now on, so the events are recorded on a new thread
+
+	DKTraceSetEnabledCategories(kDKTraceStorage);
+	DKTraceSetBufferCapacity(SMALL_CAPACITY);
+
+	XCTAssertEqual(pthread_create(&thread, NULL, recordEventsOnThread, NULL), 0, @"should be able to start a thread");
+	pthread_join(thread, NULL);
+
+	NSArray* events = [self eventsNamed:@"thread event"];
+
+	XCTAssertEqual([events count], (NSUInteger)SMALL_CAPACITY, @"a full buffer should hold its capacity");
+
+	for (NSUInteger i = 0; i < [events count]; ++i)
+		XCTAssertEqual([events[i][@"argument"] unsignedIntegerValue], EVENTS_ON_THREAD - SMALL_CAPACITY + i, @"the buffer should hold the newest events, oldest first");
+
+	// the finished thread's buffer was freed as it exited, keeping just these events until a reset
+
+	DKTraceReset();
+	XCTAssertEqual([[self eventsNamed:@"thread event"] count], (NSUInteger)0, @"reset should discard the events");
+}
+
+- (void)testResetWhileOtherThreadsRecord
+{
+	pthread_t thread;
+
+	DKTraceSetEnabledCategories(kDKTraceStorage);
+	sRecorded = dispatch_semaphore_create(0);
+	sProceed = dispatch_semaphore_create(0);
+
+	XCTAssertEqual(pthread_create(&thread, NULL, recordEventsAroundReset, NULL), 0, @"should be able to start a thread");
+	dispatch_semaphore_wait(sRecorded, DISPATCH_TIME_FOREVER);
+
+	XCTAssertEqual([[self eventsNamed:@"before reset"] count], (NSUInteger)3, @"a running thread's events should be read");
+
+	// the other thread's buffer is left for it to empty, and its old events ignored meanwhile
+
+	DKTraceReset();
+	XCTAssertEqual([[self eventsNamed:@"before reset"] count], (NSUInteger)0, @"reset should discard a running thread's events");
+
+	dispatch_semaphore_signal(sProceed);
+	dispatch_semaphore_wait(sRecorded, DISPATCH_TIME_FOREVER);
+
+	XCTAssertEqual([[self eventsNamed:@"before reset"] count], (NSUInteger)0, @"events from before the reset should not come back");
+	XCTAssertEqual([[self eventsNamed:@"after reset"] count], (NSUInteger)2, @"events after the reset should be read");
+
+	dispatch_semaphore_signal(sProceed);
+	pthread_join(thread, NULL);
+
+	XCTAssertEqual([[self eventsNamed:@"after reset"] count], (NSUInteger)2, @"a finished thread's events should be kept");
+}
+
+- (void)testHitTestingIsTraced
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(500, 500)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(100, 100, 100, 100)];
+
+	[drawing addLayer:layer];
+	[layer addObject:shape];
+
+	DKTraceSetEnabledCategories(kDKTraceHitTesting | kDKTraceStorage);
+
+	XCTAssertEqual([layer hitTest:NSMakePoint(150, 150)], shape, @"the shape should be hit");
+
+	NSArray* events = [self eventsInTraceData:DKTraceData()];
+	NSArray* hits = [events filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name == 'hit test layer'"]];
+	NSArray* queries = [events filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name CONTAINS 'storage objects'"]];
+
+	XCTAssertEqual([hits count], (NSUInteger)1, @"the hit test should be recorded");
+	XCTAssertEqual([hits[0][@"argument"] unsignedLongLongValue], 1ULL, @"one object should have been tried");
+	XCTAssertGreaterThanOrEqual([queries count], (NSUInteger)1, @"the storage query should be recorded");
+	XCTAssertGreaterThanOrEqual([[queries lastObject][@"argument"] unsignedLongLongValue], 1ULL, @"the query should have found the shape");
+}
+
+- (void)testTraceDataFormat
+{
+	NSURL* url = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"TestTrace.dktrace"]];
+	NSError* error = nil;
+
+	DKTraceSetEnabledCategories(kDKTraceLayers);
+	DKTraceInstant(kDKTraceLayers, "first", 1);
+	DKTraceInstant(kDKTraceLayers, "second", 2);
+	DKTraceInstant(kDKTraceLayers, "first", 3);
+
+	XCTAssertTrue(DKTraceWriteToURL(url, &error), @"the trace should be written (%@)", error);
+
+	NSData* data = [NSData dataWithContentsOfURL:url];
+	uint32_t header[3];
+
+	[data getBytes:header
+			 range:NSMakeRange(4, sizeof(header))];
+
+	XCTAssertEqual(header[1], (uint32_t)2, @"a name used twice should be written once");
+	XCTAssertEqual(header[2], (uint32_t)1, @"only this thread has recorded events");
+	XCTAssertEqual([[self eventsInTraceData:data] count], (NSUInteger)3, @"every event should be written");
+
+	[[NSFileManager defaultManager] removeItemAtURL:url
+											  error:nil];
+}
+
+- (void)testPerformanceOfDisabledTracePoints
+{
+	DKTraceSetEnabledCategories(0);
+
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < TRACE_POINT_COUNT; ++i) {
+			DKTraceScope(span, kDKTraceStorage, "benchmark");
+			span.argument = i;
+		}
+	}];
+}
+
+- (void)testPerformanceOfEnabledTracePoints
+{
+	DKTraceSetEnabledCategories(kDKTraceStorage);
+
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < TRACE_POINT_COUNT; ++i) {
+			DKTraceScope(span, kDKTraceStorage, "benchmark");
+			span.argument = i;
+		}
+	}];
+}
+
+@end
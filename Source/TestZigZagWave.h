@@ -0,0 +1,25 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/NSBezierPath+Geometry.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for zig-zag and wave paths.
+
+ Checks that the peaks of zig-zags and waves lie where stepping along the path point by point puts them, that the cache returns
+ the same path until the source path or a parameter changes, and times building waves along a long path with and without the cache.
+*/
+@interface TestZigZagWave : XCTestCase
+
+- (void)testZigZagPeaksFollowPath;
+- (void)testWavePeaksFollowPath;
+- (void)testCachedWaveMatchesUncached;
+- (void)testCacheMissesOnChange;
+- (void)testChecksumSeesSmallMoves;
+- (void)testPerformanceOfWave;
+- (void)testPerformanceOfCachedWave;
+
+@end
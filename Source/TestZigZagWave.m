@@ -0,0 +1,197 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestZigZagWave.h"
+#import <DKDrawKit/NSBezierPath+Editing.h>
+
+#define WAVE_TEST_TOLERANCE 0.2
+
+@interface TestZigZagWave ()
+
+- (NSBezierPath*)curvyPath;
+- (NSBezierPath*)longPath;
+- (void)checkPeaksOfPath:(NSBezierPath*)wave alongPath:(NSBezierPath*)path wavelength:(CGFloat)lambda amplitude:(CGFloat)amp;
+
+@end
+
+@implementation TestZigZagWave
+
+- (NSBezierPath*)curvyPath
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:NSMakePoint(0, 0)];
+	[path curveToPoint:NSMakePoint(200, 0)
+		 controlPoint1:NSMakePoint(50, 120)
+		 controlPoint2:NSMakePoint(150, -120)];
+	[path lineToPoint:NSMakePoint(200, 150)];
+
+	return path;
+}
+
+- (NSBezierPath*)longPath
+{
+	// a meandering open path of 10,000 elements
+
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:NSZeroPoint];
+
+	for (NSUInteger i = 1; i < 10000; ++i) {
+		NSPoint p = NSMakePoint(i * 3.0, 40.0 * sin(i * 0.05));
+
+		if (i & 1)
+			[path lineToPoint:p];
+		else
+			[path curveToPoint:p
+				 controlPoint1:NSMakePoint(p.x - 2, p.y + 4)
+				 controlPoint2:NSMakePoint(p.x - 1, p.y - 4)];
+	}
+
+	return path;
+}
+
+- (void)checkPeaksOfPath:(NSBezierPath*)wave alongPath:(NSBezierPath*)path wavelength:(CGFloat)lambda amplitude:(CGFloat)amp
+{
+	// each peak should be <amp> from the point <lambda> further along the path than the last, on alternate sides. The last is at the end.
+
+	CGFloat len = [path length];
+	NSInteger i, ec = [wave elementCount];
+	NSPoint ap[3];
+
+	XCTAssertEqual(ec, (NSInteger)ceil(len / lambda), @"wave has the wrong number of peaks");
+
+	for (i = 0; i < ec; ++i) {
+		CGFloat t = (i == ec - 1) ? len : i * lambda;
+		CGFloat slope;
+		NSPoint zp = [path pointOnPathAtLength:t
+										 slope:&slope];
+		NSBezierPathElement element = [wave elementAtIndex:i
+										  associatedPoints:ap];
+		NSPoint peak = (element == NSCurveToBezierPathElement) ? ap[2] : ap[0];
+
+		slope += (i & 1) ? M_PI_2 : -M_PI_2;
+
+		XCTAssertEqualWithAccuracy(peak.x, zp.x + cos(slope) * amp, WAVE_TEST_TOLERANCE, @"peak %ld is in the wrong place", (long)i);
+		XCTAssertEqualWithAccuracy(peak.y, zp.y + sin(slope) * amp, WAVE_TEST_TOLERANCE, @"peak %ld is in the wrong place", (long)i);
+	}
+}
+
+- (void)testZigZagPeaksFollowPath
+{
+	NSBezierPath* path = [self curvyPath];
+	NSBezierPath* zig = [path bezierPathWithZig:7
+											zag:5];
+	NSInteger mtc, ctc;
+
+	[zig getPathMoveToCount:&mtc
+				lineToCount:NULL
+			   curveToCount:&ctc
+			 closePathCount:NULL];
+
+	XCTAssertEqual(mtc, 1, @"zig-zag should be one subpath");
+	XCTAssertEqual(ctc, 0, @"zig-zag should have no curves");
+
+	[self checkPeaksOfPath:zig
+				 alongPath:path
+				wavelength:7
+				 amplitude:5];
+}
+
+- (void)testWavePeaksFollowPath
+{
+	NSBezierPath* path = [self curvyPath];
+	NSBezierPath* wave = [path bezierPathWithWavelength:9
+											  amplitude:4
+												 spread:0.5];
+
+	[self checkPeaksOfPath:wave
+				 alongPath:path
+				wavelength:9
+				 amplitude:4];
+}
+
+- (void)testCachedWaveMatchesUncached
+{
+	NSBezierPath* path = [self curvyPath];
+	NSBezierPath* wave = [path bezierPathWithWavelength:6
+											  amplitude:3
+												 spread:0.4];
+	NSBezierPath* cached = [path cachedBezierPathWithWavelength:6
+													  amplitude:3
+														 spread:0.4];
+
+	XCTAssertEqual([wave checksum], [cached checksum], @"cached wave differs from the uncached one");
+	XCTAssertTrue(cached == [[path copy] cachedBezierPathWithWavelength:6
+															  amplitude:3
+																 spread:0.4],
+		@"an identical path should hit the cache");
+}
+
+- (void)testCacheMissesOnChange
+{
+	NSBezierPath* path = [self curvyPath];
+	NSBezierPath* cached = [path cachedBezierPathWithWavelength:6
+													  amplitude:3
+														 spread:0.4];
+
+	XCTAssertTrue(cached != [path cachedBezierPathWithWavelength:6
+													   amplitude:3.5
+														  spread:0.4],
+		@"a new amplitude should miss the cache");
+
+	[path lineToPoint:NSMakePoint(0, 150)];
+
+	NSBezierPath* changed = [path cachedBezierPathWithWavelength:6
+													   amplitude:3
+														  spread:0.4];
+
+	XCTAssertTrue(cached != changed, @"a changed path should miss the cache");
+	XCTAssertGreaterThan([changed elementCount], [cached elementCount], @"the wave should follow the longer path");
+}
+
+- (void)testChecksumSeesSmallMoves
+{
+	NSBezierPath* a = [self curvyPath];
+	NSBezierPath* b = [self curvyPath];
+
+	XCTAssertEqual([a checksum], [b checksum], @"identical paths should have the same checksum");
+
+	NSPoint p = NSMakePoint(200.001, 150);
+
+	[b setAssociatedPoints:&p
+				   atIndex:2];
+
+	XCTAssertNotEqual([a checksum], [b checksum], @"moving a point slightly should change the checksum");
+}
+
+- (void)testPerformanceOfWave
+{
+	NSBezierPath* path = [self longPath];
+
+	[self measureBlock:^{
+		[path bezierPathWithWavelength:5
+							 amplitude:3
+								spread:0.5];
+	}];
+}
+
+- (void)testPerformanceOfCachedWave
+{
+	NSBezierPath* path = [self longPath];
+
+	[path cachedBezierPathWithWavelength:5
+							   amplitude:3
+								  spread:0.5];
+
+	[self measureBlock:^{
+		[path cachedBezierPathWithWavelength:5
+								   amplitude:3
+									  spread:0.5];
+	}];
+}
+
+@end
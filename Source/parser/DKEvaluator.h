@@ -11,6 +11,7 @@
 
 @interface DKEvaluator : NSObject {
 	NSMutableDictionary* mSymbolTable;
+	NSMapTable* mResolvedSymbols; // interned DKSymbols -> their values, cleared whenever the symbol table changes
 }
 
 - (void)addValue:(id)value forSymbol:(NSString*)symbol;
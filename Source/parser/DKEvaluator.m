@@ -16,33 +16,40 @@
 {
 	[mSymbolTable setValue:value
 					forKey:symbol];
+	[mResolvedSymbols removeAllObjects];
 }
 
 #pragma mark -
 - (id)evaluateSymbol:(NSString*)symbol
 {
-	id sym = [mSymbolTable valueForKeyPath:symbol];
-	return (sym ? sym : symbol);
-}
+	// parsed symbols are interned and never freed, so their lookups can be remembered by address. Anything else, such as a
+	// literal string passed in by a subclass, is looked up each time.
 
-- (id)evaluateObject:(id)anObject
-{
-	if ([anObject isLiteralValue])
-		return anObject;
+	BOOL interned = [symbol isKindOfClass:[DKSymbol class]];
+	id sym;
 
-	if ([anObject isKindOfClass:[DKSymbol class]])
-		return [self evaluateSymbol:anObject];
+	if (interned) {
+		sym = [mResolvedSymbols objectForKey:symbol];
 
-	if ([anObject isKindOfClass:[DKExpression class]])
-		return [self evaluateExpression:anObject];
-
-	if ([anObject isKindOfClass:[DKExpressionPair class]]) {
-		id val = [self evaluateObject:[(DKExpressionPair*)anObject value]];
-		return [[[DKExpressionPair alloc] initWithKey:[(DKExpressionPair*)anObject key]
-												value:val] autorelease];
+		if (sym)
+			return sym;
 	}
 
-	return anObject;
+	sym = [mSymbolTable valueForKeyPath:symbol];
+
+	if (sym == nil)
+		sym = symbol;
+
+	if (interned)
+		[mResolvedSymbols setObject:sym
+							 forKey:symbol];
+
+	return sym;
+}
+
+- (id)evaluateObject:(id)anObject
+{
+	return [anObject evaluateWithEvaluator:self];
 }
 
 - (id)evaluateExpression:(DKExpression*)expr
@@ -50,18 +57,36 @@
 	if ([expr isLiteralValue])
 		return [self evaluateSimpleExpression:expr];
 
+	// the evaluated items are only gathered once an item turns out to have a different value; until then the items are shared
+	// with the original, so an expression whose symbols all evaluate to themselves costs no copying at all
+
+	DKExpression* sexpr = nil;
+	NSInteger i, count = [expr argCount];
 	id value;
 
-	NSEnumerator* curs = [expr objectEnumerator];
-	DKExpression* sexpr = [[DKExpression alloc] init];
-	[sexpr setType:[expr type]];
-	id item;
+	for (i = 0; i < count; ++i) {
+		id item = [expr objectAtIndex:i];
+		id evaluated = [item evaluateWithEvaluator:self];
 
-	while ((item = [curs nextObject]))
-		[sexpr addObject:[self evaluateObject:item]];
+		if (sexpr == nil && evaluated != item) {
+			NSInteger j;
 
-	value = [[self evaluateSimpleExpression:sexpr] retain];
-	[sexpr release];
+			sexpr = [[DKExpression alloc] init];
+			[sexpr setType:[expr type]];
+
+			for (j = 0; j < i; ++j)
+				[sexpr addObject:[expr objectAtIndex:j]];
+		}
+
+		[sexpr addObject:evaluated];
+	}
+
+	if (sexpr == nil)
+		value = [[self evaluateSimpleExpression:expr] retain];
+	else {
+		value = [[self evaluateSimpleExpression:sexpr] retain];
+		[sexpr release];
+	}
 
 	return [value autorelease];
 }
@@ -75,6 +100,7 @@
 #pragma mark As an NSObject
 - (void)dealloc
 {
+	[mResolvedSymbols release];
 	[mSymbolTable release];
 
 	[super dealloc];
@@ -85,8 +111,11 @@
 	self = [super init];
 	if (self != nil) {
 		mSymbolTable = [[NSMutableDictionary alloc] init];
+		mResolvedSymbols = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsObjectPointerPersonality
+													 valueOptions:NSPointerFunctionsStrongMemory
+														 capacity:64];
 
-		if (mSymbolTable == nil) {
+		if (mSymbolTable == nil || mResolvedSymbols == nil) {
 			[self autorelease];
 			self = nil;
 		}
@@ -7,9 +7,22 @@
 
 #import <Foundation/Foundation.h>
 
+@class DKEvaluator;
+
+// the type string of an expression, decoded once when the type is set
+
+typedef enum {
+	kDKExpressionOther = 0,
+	kDKExpressionExpr,
+	kDKExpressionSequence,
+	kDKExpressionMethodCall
+} DKExpressionKind;
+
 @interface DKExpression : NSObject {
 	NSString* mType;
 	NSMutableArray* mValues;
+	DKExpressionKind mKind;
+	BOOL mIsLiteral; // YES while every value added so far is literal
 }
 
 - (void)setType:(NSString*)aType;
@@ -32,6 +45,7 @@
 
 - (void)addObject:(id)aValue;
 - (void)addObject:(id)aValue forKey:(NSString*)key;
+- (void)removeAllObjects;
 
 - (void)applyKeyedValuesTo:(id)anObject;
 
@@ -59,4 +73,9 @@
 
 - (BOOL)isLiteralValue;
 
+// returns the value of the receiver as a node of a script. Plain objects are their own value; symbols, expressions and pairs
+// override this, so the evaluator dispatches on the node with a single message rather than testing its class.
+
+- (id)evaluateWithEvaluator:(DKEvaluator*)evaluator;
+
 @end
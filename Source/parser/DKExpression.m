@@ -7,6 +7,8 @@
 
 #import "DKExpression.h"
 
+#import "DKEvaluator.h"
+
 @implementation DKExpression
 #pragma mark As a DKExpression
 - (void)setType:(NSString*)aType
@@ -14,6 +16,15 @@
 	[aType retain];
 	[mType release];
 	mType = aType;
+
+	if ([@"expr" isEqualToString:mType] || [@"emptyExpr" isEqualToString:mType])
+		mKind = kDKExpressionExpr;
+	else if ([@"seq" isEqualToString:mType] || [@"emptySeq" isEqualToString:mType])
+		mKind = kDKExpressionSequence;
+	else if ([@"mcall" isEqualToString:mType])
+		mKind = kDKExpressionMethodCall;
+	else
+		mKind = kDKExpressionOther;
 }
 
 - (NSString*)type
@@ -23,35 +34,20 @@
 
 - (BOOL)isSequence
 {
-	if ([@"seq" isEqualToString:mType])
-		return YES;
-
-	if ([@"emptySeq" isEqualToString:mType])
-		return YES;
-
-	return NO;
+	return mKind == kDKExpressionSequence;
 }
 
 - (BOOL)isMethodCall
 {
-	if ([@"mcall" isEqualToString:mType])
-		return YES;
-
-	return NO;
+	return mKind == kDKExpressionMethodCall;
 }
 
 #pragma mark -
 - (BOOL)isLiteralValue
 {
-	NSEnumerator* curs = [mValues objectEnumerator];
-	id item;
+	// kept up to date as values are added, rather than found by walking the whole subtree each time it's asked
 
-	while ((item = [curs nextObject])) {
-		if (![item isLiteralValue])
-			return NO;
-	}
-
-	return YES;
+	return mIsLiteral;
 }
 
 - (NSInteger)argCount
@@ -101,12 +97,24 @@
 {
 	[mValues replaceObjectAtIndex:ndx
 					   withObject:obj];
+
+	mIsLiteral = YES;
+
+	for (id item in mValues) {
+		if (![item isLiteralValue]) {
+			mIsLiteral = NO;
+			break;
+		}
+	}
 }
 
 #pragma mark -
 - (void)addObject:(id)aValue
 {
 	[mValues addObject:aValue];
+
+	if (mIsLiteral)
+		mIsLiteral = [aValue isLiteralValue];
 }
 
 - (void)addObject:(id)aValue forKey:(NSString*)key
@@ -114,10 +122,27 @@
 	DKExpressionPair* pair = [[DKExpressionPair alloc] initWithKey:key
 															 value:aValue];
 
-	[mValues addObject:pair];
+	[self addObject:pair];
 	[pair release];
 }
 
+- (void)removeAllObjects
+{
+	[mValues removeAllObjects];
+	mIsLiteral = YES;
+}
+
+- (id)evaluateWithEvaluator:(DKEvaluator*)evaluator
+{
+	// as an item of another expression, a literal expression such as (1 2 3) or (r:1 g:0 b:0) is a value in its own right, left
+	// for the object built from the enclosing expression to interpret
+
+	if (mIsLiteral)
+		return self;
+
+	return [evaluator evaluateExpression:self];
+}
+
 #pragma mark -
 - (void)applyKeyedValuesTo:(id)anObject
 {
@@ -180,15 +205,13 @@
 	NSMutableString* desc;
 	NSString* start, *end;
 
-	if ([@"seq" isEqualToString:mType] ||
-		[@"emptySeq" isEqualToString:mType]) {
+	if (mKind == kDKExpressionSequence) {
 		start = @"{";
 		end = @"}\n";
-	} else if ([@"expr" isEqualToString:mType] ||
-			   [@"emptyExpr" isEqualToString:mType]) {
+	} else if (mKind == kDKExpressionExpr) {
 		start = @"(";
 		end = @")\n";
-	} else if ([@"mcall" isEqualToString:mType]) {
+	} else if (mKind == kDKExpressionMethodCall) {
 		start = @"[";
 		end = @"]\n";
 	} else {
@@ -213,6 +236,7 @@
 	if (self != nil) {
 		[self setType:@"expr"];
 		mValues = [[NSMutableArray alloc] init];
+		mIsLiteral = YES;
 
 		if (mType == nil
 			|| mValues == nil) {
@@ -259,6 +283,19 @@
 	return [value isLiteralValue];
 }
 
+- (id)evaluateWithEvaluator:(DKEvaluator*)evaluator
+{
+	// a pair is only copied if evaluating its value actually changes it
+
+	id val = [evaluator evaluateObject:value];
+
+	if (val == value)
+		return self;
+
+	return [[[DKExpressionPair alloc] initWithKey:key
+											value:val] autorelease];
+}
+
 #pragma mark -
 #pragma mark As an NSObject
 - (void)dealloc
@@ -283,4 +320,10 @@
 	return YES;
 }
 
+- (id)evaluateWithEvaluator:(DKEvaluator*)evaluator
+{
+#pragma unused(evaluator)
+	return self;
+}
+
 @end
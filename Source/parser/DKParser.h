@@ -16,6 +16,7 @@
 @interface DKParser : NSObject {
 	Scanner scanr;
 	NSMutableDictionary* mFactories;
+	NSMutableSet* mKeywords; // one copy of each keyword, shared by every pair that uses it
 	NSMutableArray* mParseStack;
 	id mDelegate;
 
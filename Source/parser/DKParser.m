@@ -34,8 +34,8 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 		fClass = NSClassFromString(fClass);
 
 	if (fClass)
-		[mFactories setValue:fClass
-					  forKey:key];
+		[mFactories setObject:fClass
+					   forKey:key];
 }
 
 #pragma mark -
@@ -54,9 +54,18 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 
 - parseString:(NSString*)inString;
 {
-	NSData* input = [inString dataUsingEncoding:NSASCIIStringEncoding
-						   allowLossyConversion:YES];
-	return [self parseData:input];
+	// the scanner runs until it finds the terminating nul, which the encoded data doesn't include
+
+	NSMutableData* input = [[inString dataUsingEncoding:NSASCIIStringEncoding
+								   allowLossyConversion:YES] mutableCopy];
+	const char* term = "\0";
+	[input appendBytes:term
+				length:1];
+
+	id result = [self parseData:input];
+	[input release];
+
+	return result;
 }
 
 - parseContentsOfFile:(NSString*)filename;
@@ -120,18 +129,30 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 #pragma mark -
 - currentToken
 {
-	id token;
+	id token = nil;
 	switch (scanr.token) {
 	case TK_String:
 		// trim off the quotes
 		token = [NSString stringWithCString:&scanr.data[1]
 									 length:scanr.len - 2];
 		break;
-	case TK_Keyword:
-		// trim off the trailing ':'
-		token = [NSString stringWithCString:scanr.data
-									 length:scanr.len - 1];
-		break;
+	case TK_Keyword: {
+		// trim off the trailing ':'. Scripts use the same few keywords over and over, so the parsed tree shares one string
+		// for each rather than keeping a copy per pair
+
+		NSString* keyword = [[NSString alloc] initWithBytes:scanr.data
+													 length:scanr.len - 1
+												   encoding:NSASCIIStringEncoding];
+
+		token = [mKeywords member:keyword];
+
+		if (token == nil) {
+			[mKeywords addObject:keyword];
+			token = keyword;
+		}
+
+		[keyword release];
+	} break;
 	case TK_Identifier:
 		token = [DKSymbol symbolForCString:scanr.data
 									length:scanr.len];
@@ -142,14 +163,39 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 		break;
 	case TK_Real:
 	case TK_Integer: {
-		NSString* stringValue, *error;
-		stringValue = [NSString stringWithCString:scanr.data
-										   length:scanr.len];
-
-		if (![numberFormatter getObjectValue:&token
-								   forString:stringValue
-							errorDescription:&error])
-			[self parseError:@"BAD NUMBER Format in %@", stringValue];
+		// plain numbers are converted directly; the number formatter is only consulted for anything the C library
+		// doesn't accept whole, such as grouping separators
+
+		char buf[64];
+		char* end = NULL;
+
+		if (scanr.len > 0 && scanr.len < (NSInteger)sizeof(buf)) {
+			memcpy(buf, scanr.data, scanr.len);
+			buf[scanr.len] = 0;
+
+			if (scanr.token == TK_Integer) {
+				long long iv = strtoll(buf, &end, 10);
+
+				if (*end == 0)
+					token = [NSNumber numberWithLongLong:iv];
+			} else {
+				double dv = strtod(buf, &end);
+
+				if (*end == 0)
+					token = [NSNumber numberWithDouble:dv];
+			}
+		}
+
+		if (token == nil) {
+			NSString* stringValue, *error;
+			stringValue = [NSString stringWithCString:scanr.data
+											   length:scanr.len];
+
+			if (![numberFormatter getObjectValue:&token
+									   forString:stringValue
+								errorDescription:&error])
+				[self parseError:@"BAD NUMBER Format in %@", stringValue];
+		}
 	} break;
 	default:
 		token = [NSString stringWithCString:scanr.data
@@ -180,7 +226,7 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 
 - instantiate:(NSString*)type;
 {
-	Class factory = [mFactories valueForKey:type];
+	Class factory = [mFactories objectForKey:type];
 
 	// Some default types
 	if (factory == Nil) {
@@ -220,6 +266,7 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 
 	[mDelegate release];
 	[mParseStack release];
+	[mKeywords release];
 	[mFactories release];
 
 	[super dealloc];
@@ -237,6 +284,7 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 		// All scanr members set to zero.
 		mFactories = [[NSMutableDictionary alloc] init];
 		mParseStack = [[NSMutableArray alloc] init];
+		mKeywords = [[NSMutableSet alloc] init];
 		NSAssert(mDelegate == nil, @"Expected init to zero");
 
 		numberFormatter = [[NSNumberFormatter alloc] init];
@@ -246,6 +294,7 @@ NSInteger dk_lex(id* val, YYLTYPE* yloc, void* reader)
 
 		if (mFactories == nil
 			|| mParseStack == nil
+			|| mKeywords == nil
 			|| numberFormatter == nil) {
 			[self autorelease];
 			self = nil;
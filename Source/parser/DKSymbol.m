@@ -7,6 +7,8 @@
 
 #import "DKSymbol.h"
 
+#import "DKEvaluator.h"
+
 #pragma mark Static Vars
 static NSMutableDictionary* sSymbolMap;
 static NSInteger sSymCounter = 0;
@@ -24,13 +26,15 @@ static NSInteger sSymCounter = 0;
 
 + (DKSymbol*)symbolForString:(NSString*)str
 {
-	DKSymbol* sym = [[DKSymbol symbolMap] valueForKey:str];
+	// -objectForKey: rather than -valueForKey:, which would treat a leading '@' as a KVC operator and costs more
+
+	DKSymbol* sym = [[DKSymbol symbolMap] objectForKey:str];
 
 	if (sym == nil) {
-		sym = [[DKSymbol alloc] initWithString:str
+		sym = [[DKSymbol alloc] initWithString:[[str copy] autorelease]
 										 index:(++sSymCounter)];
-		[[DKSymbol symbolMap] setValue:sym
-								forKey:[sym string]];
+		[[DKSymbol symbolMap] setObject:sym
+								 forKey:[sym string]];
 		[sym release];
 	}
 
@@ -101,6 +105,11 @@ static NSInteger sSymCounter = 0;
 	return NO;
 }
 
+- (id)evaluateWithEvaluator:(DKEvaluator*)evaluator
+{
+	return [evaluator evaluateSymbol:self];
+}
+
 - (BOOL)isSmoothAtom
 {
 	return NO;
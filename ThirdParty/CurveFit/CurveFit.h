@@ -15,6 +15,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class DKFlatPath;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -35,6 +37,11 @@ extern NSBezierPath* DKCurveFitPath(NSBezierPath* inPath, CGFloat epsilon);
  */
 extern NSBezierPath* DKSmartCurveFitPath(NSBezierPath* inPath, CGFloat epsilon, CGFloat cornerAngleThreshold);
 
+/** As DKSmartCurveFitPath, but working on and returning the flat representation. Each run of line segments is passed to the fitter
+ directly from the path's point array without being copied.
+ */
+extern DKFlatPath* DKSmartCurveFitFlatPath(DKFlatPath* inPath, CGFloat epsilon, CGFloat cornerAngleThreshold);
+
 #ifdef __cplusplus
 }
 #endif
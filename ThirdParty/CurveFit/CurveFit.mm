@@ -11,203 +11,162 @@
 
 #import "CurveFit.h"
 #import "bezier-utils.h"
+#import "../../Source/DKFlatPath.h"
 #import "../../Source/NSBezierPath+Geometry.h"
 #import "../../Source/DKGeometryUtilities.h"
 
 
 
-NSBezierPath* DKCurveFitPath(NSBezierPath* inPath, CGFloat epsilon)
+// NSPoint and Geom::Point are both a pair of doubles, so runs of points in a DKFlatPath can be passed to the fitter where they lie.
+
+static_assert(sizeof(Geom::Point) == sizeof(NSPoint) && sizeof(Geom::Coord) == sizeof(CGFloat), "NSPoint must be layout compatible with Geom::Point");
+
+#define kDKCurveFitMaxSegments 256
+
+static void appendCurveFitOfPoints(DKFlatPath* result, const NSPoint* points, NSInteger count, CGFloat epsilon)
 {
-	// given an input path in vector form (flattened), this converts it to the C++ data structure list of points and processes it via the
-	// curve fit method in the bezier-utils lib. It then converts the result back to NSBezierPath form. Note - the caller is responsible for passing
-	// a flattened path.
-	
-	Geom::Point*	pd;
-	NSInteger		ec, i;
-	NSPoint			p[3];
-	NSBezierPath*	result = [NSBezierPath bezierPath];
-	
-	ec = [inPath elementCount];
-	
-	if ( ec < 3 )
-	{
-		[result appendBezierPath:inPath];
-		return result;
-	}
-	
-	pd = (Geom::Point*) malloc( sizeof( Geom::Point ) * ec );
-	
-	for( i = 0; i < ec; ++i )
-	{
-		[inPath elementAtIndex:i associatedPoints:p];
-		pd[i] = Geom::Point((Geom::Coord)p[0].x, (Geom::Coord)p[0].y);
-	}
-	
-	// converted, now try the curve fit. Note that we don't know how much space we need to store the result, and the code doesn't give
-	// us a way to find out, so we just create a big buffer and hope for the best.
-	
-	NSInteger		segments, maxSegments;
-	Geom::Point*	segBuffer;
-	
-	maxSegments = 256;
-	segBuffer = (Geom::Point*) malloc( sizeof( Geom::Point ) * maxSegments * 4 );
-	
-	// do the fitting:
-	
-	segments = bezier_fit_cubic_r( segBuffer, pd, (int)ec, epsilon, (int)maxSegments );
-	
-	if ( segments > 0 )
-	{
-		//NSLog(@"curve fit generated %d segments", segments );
-		
-		// we got a result, so convert it back to an NSBezierPath. The result is returned as quads of points (presumably this means that
-		// there is a lot of duplication).
-		
-		NSPoint temp[3];
-		NSInteger segElement;
-		
-		temp[0].x = segBuffer[0][Geom::X];
-		temp[0].y = segBuffer[0][Geom::Y];
-		[result moveToPoint:temp[0]];
-		
-		for( i = 0; i < segments; ++i )
-		{
-			segElement = ( i * 4 ) + 1;
-			
-			temp[0].x = segBuffer[segElement][Geom::X];
-			temp[0].y = segBuffer[segElement++][Geom::Y];
-			temp[1].x = segBuffer[segElement][Geom::X];
-			temp[1].y = segBuffer[segElement++][Geom::Y];
-			temp[2].x = segBuffer[segElement][Geom::X];
-			temp[2].y = segBuffer[segElement][Geom::Y];
-		
-			[result curveToPoint:temp[2] controlPoint1:temp[0] controlPoint2:temp[1]];
+	// fits curves to <count> points and appends them to result, whose current point must already be points[0]. Note that we don't know
+	// how much space we need to store the result, and the code doesn't give us a way to find out, so we just use a big buffer and hope
+	// for the best.
+
+	NSInteger i, segments = 0;
+
+	if (count >= 3) {
+		Geom::Point segBuffer[kDKCurveFitMaxSegments * 4];
+
+		segments = bezier_fit_cubic_r(segBuffer, reinterpret_cast<const Geom::Point*>(points), (int)count, epsilon, kDKCurveFitMaxSegments);
+
+		// the result is returned as quads of points, the first of each being the same as the last of the one before
+
+		for (i = 0; i < segments; ++i) {
+			const Geom::Point* seg = segBuffer + (i * 4);
+
+			[result curveToPoint:NSMakePoint(seg[3][Geom::X], seg[3][Geom::Y])
+				   controlPoint1:NSMakePoint(seg[1][Geom::X], seg[1][Geom::Y])
+				   controlPoint2:NSMakePoint(seg[2][Geom::X], seg[2][Geom::Y])];
 		}
 	}
-	
-	// clean up
-	
-	free( pd );
-	free( segBuffer );
-	
-	return result;
+
+	// too few points to fit, or the fit failed - keep the original segments
+
+	if (segments <= 0) {
+		for (i = 1; i < count; ++i)
+			[result lineToPoint:points[i]];
+	}
 }
 
+NSBezierPath* DKCurveFitPath(NSBezierPath* inPath, CGFloat epsilon)
+{
+	// given an input path in vector form (flattened), this processes its points via the curve fit method in the bezier-utils lib.
+	// Note - the caller is responsible for passing a flattened path.
+
+	if ([inPath elementCount] < 3)
+		return [inPath copy];
+
+	DKFlatPath* fp = [DKFlatPath flatPathWithBezierPath:inPath];
+	DKFlatPath* result = [[DKFlatPath alloc] init];
+
+	[result moveToPoint:[fp points][0]];
+	appendCurveFitOfPoints(result, [fp points], [fp pointCount], epsilon);
+
+	return [result bezierPath];
+}
 
 NSBezierPath* DKSmartCurveFitPath(NSBezierPath* inPath, CGFloat epsilon, CGFloat cornerAngleThreshold)
+{
+	return [DKSmartCurveFitFlatPath([DKFlatPath flatPathWithBezierPath:inPath], epsilon, cornerAngleThreshold) bezierPath];
+}
+
+DKFlatPath* DKSmartCurveFitFlatPath(DKFlatPath* inPath, CGFloat epsilon, CGFloat cornerAngleThreshold)
 {
 	// this curve fits a flattened path, but is much smarter about which parts of the path to curve fit and which to leave alone. It
 	// also properly deals with separate subpaths within the original path (holes).
-	
+
 	// a line segment that is longer than a given threshhold is not curve-fitted, and sharp corners also define boundaries for curve
 	// segments. Existing curved segments are copied to the result without any changes.
-	
-	NSInteger				i, ec = [inPath elementCount];
-	NSBezierPathElement		elem;
-	NSPoint					ap[3], np[3];
-	NSPoint					lastPoint = NSZeroPoint;
-	NSPoint					firstPoint = NSZeroPoint;
-	NSBezierPath*			result;
-	NSBezierPath*			temp;
-	CGFloat					angle;
-	
-	result = [NSBezierPath bezierPath];
+
+	// because every element's start point immediately precedes its own points in the flat path, a run of line segments (including the
+	// closing segment of a subpath) is a contiguous range of points, from <runStart> to the end point of the last line in the run.
+
+	NSUInteger i, ec = [inPath elementCount];
+	const NSBezierPathElement* types = [inPath elementTypes];
+	const NSUInteger* pi = [inPath pointIndexes];
+	const NSPoint* pts = [inPath points];
+	NSUInteger runStart = 0;
+	NSPoint firstPoint = NSZeroPoint;
+	CGFloat angle;
+
+	DKFlatPath* result = [[DKFlatPath alloc] initWithElementCapacity:ec];
 	[result setWindingRule:[inPath windingRule]];
-	
-	if ( ec > 0 )
-	{
-		temp = [NSBezierPath bezierPath];	// holds the accumulated elements for each subsection
-		
-		for( i = 0; i < ec; ++i )
-		{
-			elem = [inPath elementAtIndex:i associatedPoints:ap];
-			
-			switch( elem )
-			{
-				case NSMoveToBezierPathElement:
-					// if temp has accumulated anything, curve fit it and append to result
-					
-					if ([temp elementCount] > 1 )
-					{
-						[result appendBezierPathRemovingInitialMoveToPoint:DKCurveFitPath( temp, epsilon )];
-						[temp removeAllPoints];
-					}
-					[temp moveToPoint:ap[0]];
-					[result moveToPoint:ap[0]];
-					lastPoint = firstPoint = ap[0];
-					break;
-				
-				case NSLineToBezierPathElement:
-
-					if ([temp isEmpty])
-						[temp moveToPoint:ap[0]];
-					else
-						[temp lineToPoint:ap[0]];
-						
-					// find out if there is a sharp turn here, or the contributing lengths are long
-
-					if( i < ( ec - 1 ))
-					{
-						elem = [inPath elementAtIndex:i+1 associatedPoints:np];
-						
-						if ( elem == NSClosePathBezierPathElement )
-							np[0] = firstPoint;
-						
-						angle = AngleBetween( lastPoint, ap[0], np[0] );
-					}
-					else
-						angle = AngleBetween( lastPoint, ap[0], firstPoint );
-
-					lastPoint = ap[0];
-
-					// compare sharp-turniness against the threshold
-					
-					if( ABS( angle ) > cornerAngleThreshold )
-					{
-						// accumulated subcurve is complete and can be processed
-						
-						if ([temp elementCount] > 1 )
-						{
-							[result appendBezierPathRemovingInitialMoveToPoint:DKCurveFitPath( temp, epsilon )];
-						
-							// will now start a new temp path
-						
-							[temp removeAllPoints];
-							[temp moveToPoint:ap[0]];
-						}
-					}	
-					break;
-				
-				case NSCurveToBezierPathElement:
-					if ([temp elementCount] > 1 )
-					{
-						[result appendBezierPathRemovingInitialMoveToPoint:DKCurveFitPath( temp, epsilon )];
-						[temp removeAllPoints];
-					}
-					[result curveToPoint:ap[2] controlPoint1:ap[0] controlPoint2:ap[1]];
-					lastPoint = ap[2];
-					break;
-				
-				case NSClosePathBezierPathElement:
-					if ([temp elementCount] > 1 )
-					{
-						[temp lineToPoint:firstPoint];
-						[result appendBezierPathRemovingInitialMoveToPoint:DKCurveFitPath( temp, epsilon )];
-						[temp removeAllPoints];
-					}
-					[result closePath];
-					lastPoint = firstPoint;
-					break;
-				default:
-					assert("Encountered invalid switch case.");
-					break;
-			}
+
+#define FLUSH_RUN_TO(k)                                                                          \
+	if ((k) > runStart) {                                                                        \
+		appendCurveFitOfPoints(result, pts + runStart, (NSInteger)((k)-runStart + 1), epsilon); \
+		runStart = (k);                                                                          \
+	}
+
+	for (i = 0; i < ec; ++i) {
+		const NSPoint* p = pts + pi[i];
+
+		switch (types[i]) {
+		case NSMoveToBezierPathElement:
+			// if a run has accumulated, curve fit it and append to result
+
+			if (i > 0)
+				FLUSH_RUN_TO(pi[i] - 1);
+
+			[result moveToPoint:p[0]];
+			runStart = pi[i];
+			firstPoint = p[0];
+			break;
+
+		case NSLineToBezierPathElement:
+			// find out if there is a sharp turn here
+
+			if (i < (ec - 1))
+				angle = AngleBetween(p[-1], p[0], pts[pi[i + 1]]);
+			else
+				angle = AngleBetween(p[-1], p[0], firstPoint);
+
+			// compare sharp-turniness against the threshold - if exceeded the run is complete and a new one starts here
+
+			if (ABS(angle) > cornerAngleThreshold)
+				FLUSH_RUN_TO(pi[i]);
+			break;
+
+		case NSCurveToBezierPathElement:
+			FLUSH_RUN_TO(pi[i] - 1);
+			[result curveToPoint:p[2]
+				   controlPoint1:p[0]
+				   controlPoint2:p[1]];
+			runStart = pi[i] + 2;
+			break;
+
+		case NSClosePathBezierPathElement:
+			// the close element's point is the start of the subpath, so the closing segment is fitted along with the rest of the run
+
+			if (pi[i] - 1 > runStart)
+				FLUSH_RUN_TO(pi[i]);
+
+			[result closePath];
+			runStart = pi[i];
+			break;
+
+		default:
+			break;
 		}
 	}
+
+	// an open subpath may end with a run that has not been flushed yet
+
+	if (ec > 0)
+		FLUSH_RUN_TO([inPath pointCount] - 1);
+
+#undef FLUSH_RUN_TO
+
 	return result;
 }
 
-
 #endif /* defined(qUseCurveFit) */
 
 
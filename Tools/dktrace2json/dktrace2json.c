@@ -0,0 +1,254 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+// dktrace2json - convert a trace written by DKTraceWriteToURL() to the Trace Event JSON format, to be viewed in Perfetto
+// (ui.perfetto.dev) or chrome://tracing.
+//
+//	usage: dktrace2json trace.dktrace [output.json]
+//
+// Writes to standard output if no output file is given. This is plain C99 with no dependence on DrawKit or Apple frameworks, so
+// traces can be looked at on any machine. Build with:
+//
+//	cc -std=c99 -O2 dktrace2json.c -o dktrace2json
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREAD_NAME_LENGTH 64
+#define EVENT_SIZE 32
+
+static const char* const sCategoryNames[] = { "storage", "rendering", "hit-testing", "archiving", "undo", "layers" };
+
+typedef struct {
+	const unsigned char* bytes;
+	size_t length;
+	size_t offset;
+} Reader;
+
+static int readBytes(Reader* reader, void* dest, size_t count)
+{
+	if (reader->length - reader->offset < count)
+		return 0;
+
+	memcpy(dest, reader->bytes + reader->offset, count);
+	reader->offset += count;
+	return 1;
+}
+
+// the file is little-endian whatever machine reads it
+
+static int readU32(Reader* reader, uint32_t* value)
+{
+	unsigned char b[4];
+
+	if (!readBytes(reader, b, sizeof(b)))
+		return 0;
+
+	*value = (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+	return 1;
+}
+
+static int readU64(Reader* reader, uint64_t* value)
+{
+	uint32_t lo, hi;
+
+	if (!readU32(reader, &lo) || !readU32(reader, &hi))
+		return 0;
+
+	*value = (uint64_t)hi << 32 | lo;
+	return 1;
+}
+
+static void writeString(FILE* out, const char* s, size_t length)
+{
+	fputc('"', out);
+
+	for (size_t i = 0; i < length && s[i]; ++i) {
+		unsigned char c = (unsigned char)s[i];
+
+		if (c == '"' || c == '\\')
+			fprintf(out, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(out, "\\u%04x", c);
+		else
+			fputc(c, out);
+	}
+
+	fputc('"', out);
+}
+
+static void writeMicroseconds(FILE* out, uint64_t ns)
+{
+	fprintf(out, "%" PRIu64 ".%03u", ns / 1000, (unsigned)(ns % 1000));
+}
+
+static int convert(Reader* reader, FILE* out)
+{
+	char magic[4];
+	uint32_t version, nameCount, threadCount;
+
+	if (!readBytes(reader, magic, sizeof(magic)) || memcmp(magic, "DKTR", 4) != 0) {
+		fprintf(stderr, "dktrace2json: not a DrawKit trace\n");
+		return 0;
+	}
+
+	if (!readU32(reader, &version) || !readU32(reader, &nameCount) || !readU32(reader, &threadCount))
+		goto truncated;
+
+	if (version != 1) {
+		fprintf(stderr, "dktrace2json: unknown trace format version %" PRIu32 "\n", version);
+		return 0;
+	}
+
+	// names stay in the file's buffer; each is its offset and length
+
+	size_t* nameOffsets = calloc(nameCount ? nameCount : 1, sizeof(size_t));
+	uint32_t* nameLengths = calloc(nameCount ? nameCount : 1, sizeof(uint32_t));
+
+	if (nameOffsets == NULL || nameLengths == NULL) {
+		free(nameOffsets);
+		free(nameLengths);
+		fprintf(stderr, "dktrace2json: out of memory\n");
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < nameCount; ++i) {
+		if (!readU32(reader, &nameLengths[i]) || reader->length - reader->offset < nameLengths[i])
+			goto truncatedNames;
+
+		nameOffsets[i] = reader->offset;
+		reader->offset += nameLengths[i];
+	}
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	int first = 1;
+
+	for (uint32_t t = 0; t < threadCount; ++t) {
+		uint64_t threadID;
+		uint32_t eventCount;
+		char threadName[THREAD_NAME_LENGTH];
+
+		if (!readU64(reader, &threadID) || !readU32(reader, &eventCount) || !readBytes(reader, threadName, sizeof(threadName)))
+			goto truncatedEvents;
+
+		fprintf(out, "%s\n{\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu64 ",\"name\":\"thread_name\",\"args\":{\"name\":", first ? "" : ",", threadID);
+
+		if (threadName[0])
+			writeString(out, threadName, sizeof(threadName));
+		else
+			fprintf(out, "\"thread %" PRIu64 "\"", threadID);
+
+		fprintf(out, "}}");
+		first = 0;
+
+		for (uint32_t e = 0; e < eventCount; ++e) {
+			uint64_t start, duration, argument;
+			uint32_t nameIndex;
+			unsigned char tail[4];
+
+			if (!readU64(reader, &start) || !readU64(reader, &duration) || !readU64(reader, &argument) || !readU32(reader, &nameIndex) || !readBytes(reader, tail, sizeof(tail)))
+				goto truncatedEvents;
+
+			fprintf(out, ",\n{\"name\":");
+
+			if (nameIndex < nameCount)
+				writeString(out, (const char*)reader->bytes + nameOffsets[nameIndex], nameLengths[nameIndex]);
+			else
+				fprintf(out, "\"?\"");
+
+			if (tail[1] < sizeof(sCategoryNames) / sizeof(sCategoryNames[0]))
+				fprintf(out, ",\"cat\":\"%s\"", sCategoryNames[tail[1]]);
+			else
+				fprintf(out, ",\"cat\":\"category%u\"", (unsigned)tail[1]);
+
+			fprintf(out, ",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":", threadID);
+			writeMicroseconds(out, start);
+
+			if (tail[0] == 'X') {
+				fprintf(out, ",\"ph\":\"X\",\"dur\":");
+				writeMicroseconds(out, duration);
+			} else
+				fprintf(out, ",\"ph\":\"i\",\"s\":\"t\"");
+
+			fprintf(out, ",\"args\":{\"value\":%" PRIu64 "}}", argument);
+		}
+	}
+
+	fprintf(out, "\n]}\n");
+	free(nameOffsets);
+	free(nameLengths);
+	return 1;
+
+truncatedEvents:
+	fprintf(out, "\n]}\n");
+truncatedNames:
+	free(nameOffsets);
+	free(nameLengths);
+truncated:
+	fprintf(stderr, "dktrace2json: the trace is truncated\n");
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "usage: dktrace2json trace.dktrace [output.json]\n");
+		return 2;
+	}
+
+	FILE* in = fopen(argv[1], "rb");
+
+	if (in == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	size_t capacity = 1 << 16, length = 0, n;
+	unsigned char* bytes = malloc(capacity);
+
+	while (bytes && (n = fread(bytes + length, 1, capacity - length, in)) > 0) {
+		length += n;
+
+		if (length == capacity) {
+			unsigned char* larger = realloc(bytes, capacity * 2);
+
+			if (larger == NULL) {
+				free(bytes);
+				bytes = NULL;
+			} else {
+				bytes = larger;
+				capacity *= 2;
+			}
+		}
+	}
+
+	fclose(in);
+
+	if (bytes == NULL) {
+		fprintf(stderr, "dktrace2json: out of memory\n");
+		return 1;
+	}
+
+	FILE* out = (argc == 3) ? fopen(argv[2], "w") : stdout;
+
+	if (out == NULL) {
+		perror(argv[2]);
+		free(bytes);
+		return 1;
+	}
+
+	Reader reader = { bytes, length, 0 };
+	int ok = convert(&reader, out);
+
+	if (out != stdout)
+		fclose(out);
+
+	free(bytes);
+	return ok ? 0 : 1;
+}